@@ -0,0 +1,236 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <arpa/inet.h>
+
+#include <amf/stub.hpp>
+#include <lib/app/base_app.hpp>
+#include <lib/crypt/milenage.hpp>
+#include <lib/sctp/sctp.hpp>
+#include <ue/subscribers/db.hpp>
+#include <utils/constants.hpp>
+#include <utils/options.hpp>
+#include <utils/yaml_utils.hpp>
+#include <yaml-cpp/yaml.h>
+
+static nr::amf::AmfStub *g_amfStub = nullptr;
+
+static struct Options
+{
+    std::string configFile{};
+    std::string subscriberFile{};
+    std::string dumpFile{};
+} g_options{};
+
+static int g_reportPeriod = 5000;
+
+static void DumpCounters()
+{
+    if (g_options.dumpFile.empty() || g_amfStub == nullptr)
+        return;
+
+    std::ofstream file(g_options.dumpFile);
+    file << g_amfStub->toJson().dumpJson() << std::endl;
+}
+
+static nas::ETypeOfIntegrityProtectionAlgorithm ReadIntegrity(const YAML::Node &node, const std::string &name)
+{
+    std::string value = yaml::GetString(node, name);
+    if (value == "IA1")
+        return nas::ETypeOfIntegrityProtectionAlgorithm::IA1_128;
+    if (value == "IA2")
+        return nas::ETypeOfIntegrityProtectionAlgorithm::IA2_128;
+    if (value == "IA3")
+        return nas::ETypeOfIntegrityProtectionAlgorithm::IA3_128;
+    throw std::runtime_error("Invalid integrity algorithm: " + value);
+}
+
+static nas::ETypeOfCipheringAlgorithm ReadCiphering(const YAML::Node &node, const std::string &name)
+{
+    std::string value = yaml::GetString(node, name);
+    if (value == "EA0")
+        return nas::ETypeOfCipheringAlgorithm::EA0;
+    if (value == "EA1")
+        return nas::ETypeOfCipheringAlgorithm::EA1_128;
+    if (value == "EA2")
+        return nas::ETypeOfCipheringAlgorithm::EA2_128;
+    if (value == "EA3")
+        return nas::ETypeOfCipheringAlgorithm::EA3_128;
+    throw std::runtime_error("Invalid ciphering algorithm: " + value);
+}
+
+static nr::amf::AmfStubConfig ReadConfigYaml()
+{
+    nr::amf::AmfStubConfig result{};
+    auto config = YAML::LoadFile(g_options.configFile);
+
+    result.ngapIp = yaml::GetIp4(config, "ngapIp");
+    result.ngapPort = 38412;
+    if (yaml::HasField(config, "ngapPort"))
+        result.ngapPort = static_cast<uint16_t>(yaml::GetInt32(config, "ngapPort", 1, 65535));
+
+    result.amfName = yaml::HasField(config, "amfName") ? yaml::GetString(config, "amfName", 1, 150) : "UERANSIM-amf";
+
+    result.plmn.mcc = yaml::GetInt32(config, "mcc", 1, 999);
+    yaml::GetString(config, "mcc", 3, 3);
+    result.plmn.mnc = yaml::GetInt32(config, "mnc", 0, 999);
+    result.plmn.isLongMnc = yaml::GetString(config, "mnc", 2, 3).size() == 3;
+
+    result.amfRegionId = yaml::GetInt32(config, "amfRegionId", 0, 0xFF);
+    result.amfSetId = yaml::GetInt32(config, "amfSetId", 0, 0x3FF);
+    result.amfPointer = yaml::GetInt32(config, "amfPointer", 0, 0x3F);
+
+    for (auto &tac : yaml::GetSequence(config, "tacs"))
+        result.tacs.push_back(tac.as<int>());
+    if (result.tacs.empty())
+        throw std::runtime_error("At least one TAC must be configured");
+
+    for (auto &nssai : yaml::GetSequence(config, "slices"))
+    {
+        SingleSlice s{};
+        s.sst = yaml::GetInt32(nssai, "sst", 0, 0xFF);
+        if (yaml::HasField(nssai, "sd"))
+            s.sd = octet3{yaml::GetInt32(nssai, "sd", 0, 0xFFFFFF)};
+        result.nssai.slices.push_back(s);
+    }
+
+    if (yaml::HasField(config, "workers"))
+        result.workers = yaml::GetInt32(config, "workers", 1, 256);
+
+    if (yaml::HasField(config, "key"))
+    {
+        nr::amf::SubscriberCredentials credentials{};
+        credentials.key = OctetString::FromHex(yaml::GetString(config, "key", 32, 32));
+        credentials.opC = OctetString::FromHex(yaml::GetString(config, "op", 32, 32));
+        credentials.amf = OctetString::FromHex(yaml::GetString(config, "amf", 4, 4));
+
+        std::string opType = yaml::GetString(config, "opType");
+        if (opType == "OP")
+            credentials.opC = crypto::milenage::CalculateOpC(credentials.opC, credentials.key);
+        else if (opType != "OPC")
+            throw std::runtime_error("Invalid OP type: " + opType);
+
+        result.defaultCredentials = std::move(credentials);
+    }
+
+    result.integrity = ReadIntegrity(config, "integrity");
+    result.ciphering = ReadCiphering(config, "ciphering");
+
+    std::string subnet = yaml::GetString(config, "ueSubnet");
+    auto slash = subnet.find('/');
+    if (slash == std::string::npos)
+        throw std::runtime_error("Invalid UE subnet: " + subnet);
+    in_addr address{};
+    if (inet_pton(AF_INET, subnet.substr(0, slash).c_str(), &address) != 1)
+        throw std::runtime_error("Invalid UE subnet: " + subnet);
+    result.uePrefixLength = std::stoi(subnet.substr(slash + 1));
+    if (result.uePrefixLength < 8 || result.uePrefixLength > 30)
+        throw std::runtime_error("Invalid UE subnet prefix length: " + subnet);
+    result.ueSubnet = ntohl(address.s_addr) & (0xFFFFFFFFu << (32 - result.uePrefixLength));
+
+    result.upfAddress = yaml::GetIp4(config, "upfAddress");
+    result.dnn = yaml::GetString(config, "dnn", 1, 100);
+    if (yaml::HasField(config, "fiveQi"))
+        result.fiveQi = yaml::GetInt32(config, "fiveQi", 1, 255);
+
+    auto ambr = config["ambr"];
+    result.sessionAmbrUplink = yaml::GetInt32(ambr, "uplink", 1, 0xFFFF);
+    result.sessionAmbrDownlink = yaml::GetInt32(ambr, "downlink", 1, 0xFFFF);
+
+    if (yaml::HasField(config, "reportPeriod"))
+        g_reportPeriod = yaml::GetInt32(config, "reportPeriod", 100, std::nullopt);
+
+    return result;
+}
+
+static void ReadOptions(int argc, char **argv)
+{
+    opt::OptionsDescription desc{cons::Project,
+                                 cons::Tag,
+                                 "NGAP and NAS stand-in for the control plane of a 5G core",
+                                 cons::Owner,
+                                 "nr-amf-stub",
+                                 {"-c <config-file> [option...]"},
+                                 {},
+                                 true,
+                                 false};
+
+    opt::OptionItem itemConfigFile = {'c', "config", "Use specified configuration file for the AMF stub",
+                                      "config-file"};
+    opt::OptionItem itemSubscribers = {'s', "subscribers",
+                                       "Take the keys and slices of each UE from the specified bulk subscriber file",
+                                       "file"};
+    opt::OptionItem itemDump = {'d', "dump", "Dump the counters and latencies of each procedure to the specified file at exit",
+                                "file"};
+
+    desc.items.push_back(itemConfigFile);
+    desc.items.push_back(itemSubscribers);
+    desc.items.push_back(itemDump);
+
+    opt::OptionsResult opt{argc, argv, desc, false, nullptr};
+
+    g_options.configFile = opt.getOption(itemConfigFile);
+    if (opt.hasFlag(itemSubscribers))
+        g_options.subscriberFile = opt.getOption(itemSubscribers);
+    if (opt.hasFlag(itemDump))
+        g_options.dumpFile = opt.getOption(itemDump);
+}
+
+int main(int argc, char **argv)
+{
+    app::Initialize();
+
+    nr::amf::AmfStubConfig config{};
+    std::unique_ptr<nr::ue::SubscriberDb> subscribers{};
+    try
+    {
+        ReadOptions(argc, argv);
+        config = ReadConfigYaml();
+        if (!g_options.subscriberFile.empty())
+            subscribers = nr::ue::SubscriberDb::Load(g_options.subscriberFile);
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (subscribers == nullptr && !config.defaultCredentials.has_value())
+    {
+        std::cerr << "ERROR: Either a subscriber file or the default credentials must be given" << std::endl;
+        return 1;
+    }
+
+    std::cout << cons::Name << std::endl;
+
+    auto *logBase = new LogBase("logs/amf-stub.log");
+    try
+    {
+        g_amfStub = new nr::amf::AmfStub(std::move(config), std::move(subscribers), logBase);
+    }
+    catch (const sctp::SctpError &e)
+    {
+        std::cerr << "ERROR: NGAP server could not be created: " << e.what() << std::endl;
+        return 1;
+    }
+    app::RunAtExit(DumpCounters);
+    g_amfStub->start();
+
+    auto logger = logBase->makeUniqueLogger("amf");
+    while (true)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(g_reportPeriod));
+        logger->info(FMT_STRING("{}"), g_amfStub->summary(g_reportPeriod));
+    }
+}
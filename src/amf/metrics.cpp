@@ -0,0 +1,175 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "metrics.hpp"
+
+#include <chrono>
+#include <sstream>
+
+static constexpr const int64_t LATENCY_HIGHEST_VALUE = 60LL * 1000 * 1000; // 1 minute in microseconds
+static constexpr const int LATENCY_SIGNIFICANT_DIGITS = 3;
+
+static double PerSecond(int64_t count, int64_t periodMs)
+{
+    return periodMs > 0 ? static_cast<double>(count) * 1000.0 / static_cast<double>(periodMs) : 0.0;
+}
+
+namespace nr::amf
+{
+
+int64_t MetricsTime()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+AmfMetrics::AmfMetrics() : m_mutex{}, m_procedures{}, m_ueCount{}, m_sessionCount{}, m_ngSetupCount{}
+{
+    for (auto &procedure : m_procedures)
+    {
+        procedure.latency = std::make_unique<HdrHistogram>(LATENCY_HIGHEST_VALUE, LATENCY_SIGNIFICANT_DIGITS);
+        procedure.periodLatency = std::make_unique<HdrHistogram>(LATENCY_HIGHEST_VALUE, LATENCY_SIGNIFICANT_DIGITS);
+    }
+}
+
+void AmfMetrics::started(EProcedure procedure)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_procedures[static_cast<int>(procedure)].started++;
+}
+
+void AmfMetrics::completed(EProcedure procedure, int64_t startTime)
+{
+    int64_t latency = MetricsTime() - startTime;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &metrics = m_procedures[static_cast<int>(procedure)];
+    metrics.completed++;
+    metrics.periodCompleted++;
+    metrics.latency->record(latency);
+    metrics.periodLatency->record(latency);
+}
+
+void AmfMetrics::failed(EProcedure procedure)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_procedures[static_cast<int>(procedure)].failed++;
+}
+
+void AmfMetrics::addUes(int64_t delta)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ueCount += delta;
+}
+
+void AmfMetrics::addSessions(int64_t delta)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sessionCount += delta;
+}
+
+void AmfMetrics::ngSetupCompleted()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ngSetupCount++;
+}
+
+int64_t AmfMetrics::completedCount(EProcedure procedure) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_procedures[static_cast<int>(procedure)].completed;
+}
+
+int64_t AmfMetrics::failedCount(EProcedure procedure) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_procedures[static_cast<int>(procedure)].failed;
+}
+
+int64_t AmfMetrics::ngSetupCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_ngSetupCount;
+}
+
+Json AmfMetrics::toJson() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Json procedures = Json::Obj({});
+    for (int i = 0; i < PROCEDURE_COUNT; i++)
+    {
+        auto &metrics = m_procedures[i];
+        Json json = Json::Obj({
+            {"started", metrics.started},
+            {"completed", metrics.completed},
+            {"failed", metrics.failed},
+        });
+        if (metrics.latency->totalCount() > 0)
+        {
+            json.put("latency-p50-us", metrics.latency->valueAtPercentile(50.0));
+            json.put("latency-p90-us", metrics.latency->valueAtPercentile(90.0));
+            json.put("latency-p99-us", metrics.latency->valueAtPercentile(99.0));
+            json.put("latency-max-us", metrics.latency->maxValue());
+        }
+        procedures.put(ToJson(static_cast<EProcedure>(i)).str(), json);
+    }
+
+    return Json::Obj({
+        {"ues", m_ueCount},
+        {"sessions", m_sessionCount},
+        {"ng-setups", m_ngSetupCount},
+        {"procedures", procedures},
+    });
+}
+
+std::string AmfMetrics::summary(int64_t periodMs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::stringstream ss{};
+    ss.precision(1);
+    ss << std::fixed;
+    ss << m_ueCount << " UEs, " << m_sessionCount << " sessions";
+
+    for (int i = 0; i < PROCEDURE_COUNT; i++)
+    {
+        auto &metrics = m_procedures[i];
+        if (metrics.periodCompleted == 0)
+            continue;
+
+        ss << ", " << ToJson(static_cast<EProcedure>(i)).str() << " " << PerSecond(metrics.periodCompleted, periodMs)
+           << "/s p50 " << metrics.periodLatency->valueAtPercentile(50.0) << " us p99 "
+           << metrics.periodLatency->valueAtPercentile(99.0) << " us";
+
+        metrics.periodCompleted = 0;
+        metrics.periodLatency->reset();
+    }
+    return ss.str();
+}
+
+Json ToJson(const EProcedure &procedure)
+{
+    switch (procedure)
+    {
+    case EProcedure::REGISTRATION:
+        return "registration";
+    case EProcedure::PDU_SESSION_ESTABLISHMENT:
+        return "pdu-session-establishment";
+    case EProcedure::PDU_SESSION_RELEASE:
+        return "pdu-session-release";
+    case EProcedure::DEREGISTRATION:
+        return "deregistration";
+    case EProcedure::PATH_SWITCH:
+        return "path-switch";
+    default:
+        return "?";
+    }
+}
+
+} // namespace nr::amf
@@ -0,0 +1,85 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <utils/hdr_histogram.hpp>
+#include <utils/json.hpp>
+
+namespace nr::amf
+{
+
+enum class EProcedure
+{
+    REGISTRATION,              // Registration request to registration complete
+    PDU_SESSION_ESTABLISHMENT, // Establishment request to resource setup response
+    PDU_SESSION_RELEASE,       // Release request to release complete
+    DEREGISTRATION,            // Deregistration request to UE context release complete
+    PATH_SWITCH,               // Path switch request to its acknowledge
+};
+
+static constexpr const int PROCEDURE_COUNT = 5;
+
+/* Microseconds on the steady clock, for the latencies of the procedures */
+int64_t MetricsTime();
+
+/* Per procedure counters and latency percentiles of the AMF stub, thread safe */
+class AmfMetrics
+{
+  private:
+    struct ProcedureMetrics
+    {
+        int64_t started{};
+        int64_t completed{};
+        int64_t failed{};
+        int64_t periodCompleted{}; // Since the last summary
+        std::unique_ptr<HdrHistogram> latency{};
+        std::unique_ptr<HdrHistogram> periodLatency{};
+    };
+
+  private:
+    mutable std::mutex m_mutex;
+    std::array<ProcedureMetrics, PROCEDURE_COUNT> m_procedures;
+    int64_t m_ueCount;
+    int64_t m_sessionCount;
+    int64_t m_ngSetupCount;
+
+  public:
+    AmfMetrics();
+
+  public:
+    void started(EProcedure procedure);
+    /* The start time is MetricsTime() at the start of the procedure */
+    void completed(EProcedure procedure, int64_t startTime);
+    void failed(EProcedure procedure);
+
+    /* Gauges of the UE contexts and the established PDU sessions */
+    void addUes(int64_t delta);
+    void addSessions(int64_t delta);
+    /* Counts the gNBs set up, e.g. to wait for the gNB of the same process */
+    void ngSetupCompleted();
+
+    /* Totals since the start, e.g. to wait for a procedure of all the UEs of the same process */
+    [[nodiscard]] int64_t completedCount(EProcedure procedure) const;
+    [[nodiscard]] int64_t failedCount(EProcedure procedure) const;
+    [[nodiscard]] int64_t ngSetupCount() const;
+
+    [[nodiscard]] Json toJson() const;
+    /* Rates and latencies over the period since the previous summary, for a periodic log line */
+    std::string summary(int64_t periodMs);
+};
+
+Json ToJson(const EProcedure &procedure);
+
+} // namespace nr::amf
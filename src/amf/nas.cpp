@@ -0,0 +1,734 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "metrics.hpp"
+#include "security.hpp"
+#include "stub.hpp"
+#include "task.hpp"
+
+#include <arpa/inet.h>
+#include <cstdio>
+
+#include <lib/nas/utils.hpp>
+
+static constexpr const int MAX_AUTH_ATTEMPTS = 3;
+static constexpr const int RAND_LENGTH = 16;
+static constexpr const int ABBA_LENGTH = 2;
+
+/* The default QoS rule of QFI 1 with a match-all packet filter */
+static constexpr const char *DEFAULT_QOS_RULES = "01000631310101FF01";
+
+static bool IsAllowedInClear(nas::EMessageType messageType)
+{
+    switch (messageType)
+    {
+    case nas::EMessageType::REGISTRATION_REQUEST:
+    case nas::EMessageType::IDENTITY_RESPONSE:
+    case nas::EMessageType::AUTHENTICATION_RESPONSE:
+    case nas::EMessageType::AUTHENTICATION_FAILURE:
+    case nas::EMessageType::SECURITY_MODE_REJECT:
+    case nas::EMessageType::DEREGISTRATION_REQUEST_UE_ORIGINATING:
+    case nas::EMessageType::SERVICE_REQUEST:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool SupportsIntegrity(const nas::IEUeSecurityCapability &cap, nas::ETypeOfIntegrityProtectionAlgorithm alg)
+{
+    switch (alg)
+    {
+    case nas::ETypeOfIntegrityProtectionAlgorithm::IA1_128:
+        return cap.b_128_5G_IA1 != 0;
+    case nas::ETypeOfIntegrityProtectionAlgorithm::IA2_128:
+        return cap.b_128_5G_IA2 != 0;
+    case nas::ETypeOfIntegrityProtectionAlgorithm::IA3_128:
+        return cap.b_128_5G_IA3 != 0;
+    default:
+        return false;
+    }
+}
+
+static bool SupportsCiphering(const nas::IEUeSecurityCapability &cap, nas::ETypeOfCipheringAlgorithm alg)
+{
+    switch (alg)
+    {
+    case nas::ETypeOfCipheringAlgorithm::EA0:
+        return cap.b_5G_EA0 != 0;
+    case nas::ETypeOfCipheringAlgorithm::EA1_128:
+        return cap.b_128_5G_EA1 != 0;
+    case nas::ETypeOfCipheringAlgorithm::EA2_128:
+        return cap.b_128_5G_EA2 != 0;
+    case nas::ETypeOfCipheringAlgorithm::EA3_128:
+        return cap.b_128_5G_EA3 != 0;
+    default:
+        return false;
+    }
+}
+
+static std::string SupiFromSuci(const ImsiMobileIdentity &imsi)
+{
+    char buffer[8] = {0};
+    if (imsi.plmn.isLongMnc)
+        std::snprintf(buffer, sizeof(buffer), "%03d%03d", imsi.plmn.mcc, imsi.plmn.mnc);
+    else
+        std::snprintf(buffer, sizeof(buffer), "%03d%02d", imsi.plmn.mcc, imsi.plmn.mnc);
+    return buffer + imsi.schemeOutput;
+}
+
+static bool IsSliceSubscribed(const NetworkSlice &nssai, const SingleSlice &slice)
+{
+    for (auto &item : nssai.slices)
+    {
+        if (item.sst == slice.sst && item.sd.has_value() == slice.sd.has_value() &&
+            (!item.sd.has_value() || static_cast<int>(*item.sd) == static_cast<int>(*slice.sd)))
+            return true;
+    }
+    return false;
+}
+
+namespace nr::amf
+{
+
+void AmfTask::receiveNas(UeContext &ue, const OctetString &nasPdu)
+{
+    // A UE may start registering again before its connection is released, that belongs to the next context
+    if (ue.isReleasing)
+        return;
+
+    auto msg = nas::DecodeNasMessage(OctetView{nasPdu});
+    if (msg == nullptr || msg->epd != nas::EExtendedProtocolDiscriminator::MOBILITY_MANAGEMENT_MESSAGES)
+    {
+        m_logger->err(FMT_STRING("Bad NAS message received from UE[{}]"), ue.amfUeNgapId);
+        return;
+    }
+
+    auto &mmMessage = (nas::MmMessage &)(*msg);
+    if (mmMessage.sht == nas::ESecurityHeaderType::NOT_PROTECTED)
+    {
+        auto &plain = (nas::PlainMmMessage &)(mmMessage);
+        if (ue.security.isActive && !IsAllowedInClear(plain.messageType))
+        {
+            m_logger->err(FMT_STRING("Unprotected NAS message [{}] of UE[{}] is discarded"),
+                          static_cast<int>(plain.messageType), ue.amfUeNgapId);
+            return;
+        }
+        receiveMmMessage(ue, plain);
+        return;
+    }
+
+    auto &secured = (nas::SecuredMmMessage &)(mmMessage);
+
+    std::unique_ptr<nas::NasMessage> inner;
+    if (ue.security.kNasInt.length() == 0)
+    {
+        // An initial message protected with a context of a previous registration, which the stub does not keep. Its
+        // MAC cannot be checked, but the message is not ciphered and starts a new authentication anyway.
+        if (secured.sht != nas::ESecurityHeaderType::INTEGRITY_PROTECTED)
+        {
+            m_logger->err(FMT_STRING("Ciphered NAS message of UE[{}] without a security context is discarded"),
+                          ue.amfUeNgapId);
+            return;
+        }
+        inner = nas::DecodeNasMessage(OctetView{secured.plainNasMessage});
+    }
+    else
+    {
+        inner = security::Unprotect(ue.security, secured);
+        if (inner == nullptr)
+        {
+            m_logger->err(FMT_STRING("NAS message of UE[{}] failed the integrity check"), ue.amfUeNgapId);
+            return;
+        }
+    }
+
+    if (inner == nullptr || inner->epd != nas::EExtendedProtocolDiscriminator::MOBILITY_MANAGEMENT_MESSAGES ||
+        ((nas::MmMessage &)(*inner)).sht != nas::ESecurityHeaderType::NOT_PROTECTED)
+    {
+        m_logger->err(FMT_STRING("Bad protected NAS message received from UE[{}]"), ue.amfUeNgapId);
+        return;
+    }
+
+    receiveMmMessage(ue, (nas::PlainMmMessage &)(*inner));
+}
+
+void AmfTask::receiveMmMessage(UeContext &ue, const nas::PlainMmMessage &msg)
+{
+    switch (msg.messageType)
+    {
+    case nas::EMessageType::REGISTRATION_REQUEST:
+        receiveRegistrationRequest(ue, (const nas::RegistrationRequest &)(msg));
+        break;
+    case nas::EMessageType::IDENTITY_RESPONSE:
+        receiveIdentityResponse(ue, (const nas::IdentityResponse &)(msg));
+        break;
+    case nas::EMessageType::AUTHENTICATION_RESPONSE:
+        receiveAuthenticationResponse(ue, (const nas::AuthenticationResponse &)(msg));
+        break;
+    case nas::EMessageType::AUTHENTICATION_FAILURE:
+        receiveAuthenticationFailure(ue, (const nas::AuthenticationFailure &)(msg));
+        break;
+    case nas::EMessageType::SECURITY_MODE_COMPLETE:
+        receiveSecurityModeComplete(ue, (const nas::SecurityModeComplete &)(msg));
+        break;
+    case nas::EMessageType::SECURITY_MODE_REJECT:
+        receiveSecurityModeReject(ue, (const nas::SecurityModeReject &)(msg));
+        break;
+    case nas::EMessageType::REGISTRATION_COMPLETE:
+        receiveRegistrationComplete(ue, (const nas::RegistrationComplete &)(msg));
+        break;
+    case nas::EMessageType::DEREGISTRATION_REQUEST_UE_ORIGINATING:
+        receiveDeregistrationRequest(ue, (const nas::DeRegistrationRequestUeOriginating &)(msg));
+        break;
+    case nas::EMessageType::SERVICE_REQUEST:
+        receiveServiceRequest(ue, (const nas::ServiceRequest &)(msg));
+        break;
+    case nas::EMessageType::UL_NAS_TRANSPORT:
+        receiveUlNasTransport(ue, (const nas::UlNasTransport &)(msg));
+        break;
+    default:
+        m_logger->debug(FMT_STRING("Unhandled NAS message [{}] received from UE[{}]"),
+                        static_cast<int>(msg.messageType), ue.amfUeNgapId);
+        break;
+    }
+}
+
+void AmfTask::receiveRegistrationRequest(UeContext &ue, const nas::RegistrationRequest &msg)
+{
+    if (ue.registrationStart == 0)
+    {
+        m_stub->metrics().started(EProcedure::REGISTRATION);
+        ue.registrationStart = MetricsTime();
+    }
+
+    if (!msg.ueSecurityCapability.has_value())
+    {
+        m_logger->err(FMT_STRING("Registration request of UE[{}] without the UE security capability"), ue.amfUeNgapId);
+        rejectRegistration(ue, nas::EMmCause::UE_SECURITY_CAP_MISMATCH);
+        return;
+    }
+    ue.ueSecurityCapability = nas::utils::DeepCopyIe(*msg.ueSecurityCapability);
+
+    // The new security context needs an ngKSI which is not in use by the UE
+    int ksi = 0;
+    while (ksi == msg.nasKeySetIdentifier.ksi || (msg.nonCurrentNgKsi.has_value() && ksi == msg.nonCurrentNgKsi->ksi))
+        ksi++;
+    ue.pendingNgKsi = ksi;
+    ue.authAttempts = 0;
+
+    if (identifyUe(ue, msg.mobileIdentity))
+    {
+        startAuthentication(ue);
+        return;
+    }
+
+    if (msg.mobileIdentity.type == nas::EIdentityType::GUTI)
+    {
+        // 5G-GUTI of another AMF or of a previous run of the stub
+        nas::IdentityRequest request;
+        request.identityType = nas::IE5gsIdentityType{nas::EIdentityType::SUCI};
+        ue.state = EUeState::IDENTIFICATION;
+        sendNas(ue, request);
+        return;
+    }
+
+    rejectRegistration(ue, nas::EMmCause::UE_IDENTITY_CANNOT_BE_DERIVED_FROM_NETWORK);
+}
+
+void AmfTask::receiveIdentityResponse(UeContext &ue, const nas::IdentityResponse &msg)
+{
+    if (ue.state != EUeState::IDENTIFICATION)
+        return;
+
+    if (!identifyUe(ue, msg.mobileIdentity))
+    {
+        rejectRegistration(ue, nas::EMmCause::UE_IDENTITY_CANNOT_BE_DERIVED_FROM_NETWORK);
+        return;
+    }
+
+    startAuthentication(ue);
+}
+
+void AmfTask::receiveAuthenticationResponse(UeContext &ue, const nas::AuthenticationResponse &msg)
+{
+    if (ue.state != EUeState::AUTHENTICATION)
+        return;
+
+    if (!msg.authenticationResponseParameter.has_value() ||
+        ue.xresStar != msg.authenticationResponseParameter->rawData)
+    {
+        m_logger->err(FMT_STRING("Authentication of UE[{}] failed, RES* mismatch"), ue.amfUeNgapId);
+        m_stub->metrics().failed(EProcedure::REGISTRATION);
+        ue.registrationStart = 0;
+        sendNas(ue, nas::AuthenticationReject{});
+        sendContextReleaseCommand(ue);
+        return;
+    }
+
+    // A new native security context, which the security mode control takes into use
+    NasSecurity security{};
+    security.ngKsi = ue.pendingNgKsi;
+    security.kAmf = security::DeriveKamf(ue.kAusf, security::ServingNetworkName(m_stub->config().plmn), ue.supi,
+                                         OctetString::FromSpare(ABBA_LENGTH));
+    ue.security = std::move(security);
+
+    ue.rand = {};
+    ue.xresStar = {};
+    ue.kAusf = {};
+
+    startSecurityModeControl(ue);
+}
+
+void AmfTask::receiveAuthenticationFailure(UeContext &ue, const nas::AuthenticationFailure &msg)
+{
+    if (ue.state != EUeState::AUTHENTICATION)
+        return;
+
+    if (++ue.authAttempts >= MAX_AUTH_ATTEMPTS)
+    {
+        m_logger->err(FMT_STRING("Authentication of UE[{}] failed after {} attempts"), ue.amfUeNgapId, ue.authAttempts);
+        rejectRegistration(ue, nas::EMmCause::ILLEGAL_UE);
+        return;
+    }
+
+    switch (msg.mmCause.value)
+    {
+    case nas::EMmCause::SYNCH_FAILURE: {
+        uint64_t sqnMs{};
+        if (!msg.authenticationFailureParameter.has_value() ||
+            !security::ResolveAuts(ue.credentials, ue.rand, msg.authenticationFailureParameter->rawData, sqnMs))
+        {
+            m_logger->err(FMT_STRING("Synchronisation failure of UE[{}] with an invalid AUTS"), ue.amfUeNgapId);
+            rejectRegistration(ue, nas::EMmCause::ILLEGAL_UE);
+            return;
+        }
+        m_stub->resynchronize(ue.supi, sqnMs);
+        break;
+    }
+    case nas::EMmCause::NGKSI_ALREADY_IN_USE:
+        ue.pendingNgKsi = (ue.pendingNgKsi + 1) % nas::IENasKeySetIdentifier::NOT_AVAILABLE_OR_RESERVED;
+        break;
+    default:
+        m_logger->err(FMT_STRING("Authentication of UE[{}] failed [{}]"), ue.amfUeNgapId,
+                      nas::utils::EnumToString(msg.mmCause.value));
+        rejectRegistration(ue, nas::EMmCause::ILLEGAL_UE);
+        return;
+    }
+
+    startAuthentication(ue);
+}
+
+void AmfTask::receiveSecurityModeComplete(UeContext &ue, const nas::SecurityModeComplete &msg)
+{
+    if (ue.state != EUeState::SECURITY_MODE)
+        return;
+
+    ue.security.isActive = true;
+
+    auto &config = m_stub->config();
+    ue.tmsi = m_stub->allocateTmsi(ue.supi);
+
+    nas::RegistrationAccept accept;
+    accept.registrationResult = nas::IE5gsRegistrationResult{nas::ESmsOverNasTransportAllowed::NOT_ALLOWED,
+                                                             nas::E5gsRegistrationResult::THREEGPP_ACCESS};
+
+    accept.mobileIdentity = nas::IE5gsMobileIdentity{};
+    accept.mobileIdentity->type = nas::EIdentityType::GUTI;
+    accept.mobileIdentity->gutiOrTmsi = GutiMobileIdentity{
+        config.plmn, static_cast<uint8_t>(config.amfRegionId), config.amfSetId, config.amfPointer, ue.tmsi};
+
+    accept.taiList = nas::IE5gsTrackingAreaIdentityList{};
+    for (int tac : config.tacs)
+        nas::utils::AddToTaiList(*accept.taiList, nas::VTrackingAreaIdentity{nas::utils::PlmnFrom(config.plmn), octet3{tac}});
+
+    accept.allowedNSSAI = nas::utils::NssaiFrom(ue.subscribedNssai);
+
+    ue.state = EUeState::REGISTERING;
+    sendInitialContextSetupRequest(ue, encodeNas(ue, accept));
+}
+
+void AmfTask::receiveSecurityModeReject(UeContext &ue, const nas::SecurityModeReject &msg)
+{
+    if (ue.state != EUeState::SECURITY_MODE)
+        return;
+
+    m_logger->err(FMT_STRING("Security mode control of UE[{}] is rejected [{}]"), ue.amfUeNgapId,
+                  nas::utils::EnumToString(msg.mmCause.value));
+
+    m_stub->metrics().failed(EProcedure::REGISTRATION);
+    ue.registrationStart = 0;
+    ue.security = {};
+    sendContextReleaseCommand(ue);
+}
+
+void AmfTask::receiveRegistrationComplete(UeContext &ue, const nas::RegistrationComplete &msg)
+{
+    if (ue.state != EUeState::REGISTERING)
+        return;
+
+    ue.state = EUeState::REGISTERED;
+    m_stub->metrics().completed(EProcedure::REGISTRATION, ue.registrationStart);
+    ue.registrationStart = 0;
+
+    m_logger->debug(FMT_STRING("UE[{}] with SUPI[imsi-{}] is registered"), ue.amfUeNgapId, ue.supi);
+}
+
+void AmfTask::receiveDeregistrationRequest(UeContext &ue, const nas::DeRegistrationRequestUeOriginating &msg)
+{
+    m_stub->metrics().started(EProcedure::DEREGISTRATION);
+    ue.deregistrationStart = MetricsTime();
+    ue.state = EUeState::DEREGISTERING;
+
+    if (msg.deRegistrationType.switchOff == nas::ESwitchOff::NORMAL_DE_REGISTRATION)
+        sendNas(ue, nas::DeRegistrationAcceptUeOriginating{});
+
+    // Completed with the UE context release
+    sendContextReleaseCommand(ue);
+}
+
+void AmfTask::receiveServiceRequest(UeContext &ue, const nas::ServiceRequest &msg)
+{
+    // The stub keeps no contexts of idle UEs, the UE registers again after the reject
+    nas::ServiceReject reject;
+    reject.mmCause = nas::IE5gMmCause{nas::EMmCause::UE_IDENTITY_CANNOT_BE_DERIVED_FROM_NETWORK};
+    sendNas(ue, reject);
+    sendContextReleaseCommand(ue);
+}
+
+void AmfTask::receiveUlNasTransport(UeContext &ue, const nas::UlNasTransport &msg)
+{
+    if (ue.state != EUeState::REGISTERING && ue.state != EUeState::REGISTERED)
+        return;
+
+    if (msg.payloadContainerType.payloadContainerType != nas::EPayloadContainerType::N1_SM_INFORMATION)
+    {
+        m_logger->debug(FMT_STRING("Unhandled UL NAS transport payload container type [{}]"),
+                        static_cast<int>(msg.payloadContainerType.payloadContainerType));
+        return;
+    }
+
+    auto sm = nas::DecodeNasMessage(OctetView{msg.payloadContainer.data});
+    if (sm == nullptr || sm->epd != nas::EExtendedProtocolDiscriminator::SESSION_MANAGEMENT_MESSAGES)
+    {
+        m_logger->err(FMT_STRING("Bad payload container in UL NAS transport of UE[{}]"), ue.amfUeNgapId);
+        return;
+    }
+
+    auto &smMessage = (nas::SmMessage &)(*sm);
+    switch (smMessage.messageType)
+    {
+    case nas::EMessageType::PDU_SESSION_ESTABLISHMENT_REQUEST:
+        receiveEstablishmentRequest(ue, (const nas::PduSessionEstablishmentRequest &)(smMessage), msg);
+        break;
+    case nas::EMessageType::PDU_SESSION_RELEASE_REQUEST:
+        receiveReleaseRequest(ue, (const nas::PduSessionReleaseRequest &)(smMessage));
+        break;
+    case nas::EMessageType::PDU_SESSION_RELEASE_COMPLETE:
+        receiveReleaseComplete(ue, (const nas::PduSessionReleaseComplete &)(smMessage));
+        break;
+    default:
+        m_logger->debug(FMT_STRING("Unhandled SM message [{}] received from UE[{}]"),
+                        static_cast<int>(smMessage.messageType), ue.amfUeNgapId);
+        break;
+    }
+}
+
+void AmfTask::receiveEstablishmentRequest(UeContext &ue, const nas::PduSessionEstablishmentRequest &msg,
+                                          const nas::UlNasTransport &transport)
+{
+    m_stub->metrics().started(EProcedure::PDU_SESSION_ESTABLISHMENT);
+    int64_t startTime = MetricsTime();
+
+    auto &config = m_stub->config();
+    int psi = msg.pduSessionId;
+
+    auto reject = [this, &ue, &msg, psi](nas::ESmCause cause) {
+        m_logger->err(FMT_STRING("PDU session establishment of UE[{}] PSI[{}] is rejected [{}]"), ue.amfUeNgapId, psi,
+                      nas::utils::EnumToString(cause));
+        m_stub->metrics().failed(EProcedure::PDU_SESSION_ESTABLISHMENT);
+
+        nas::PduSessionEstablishmentReject response;
+        response.pti = msg.pti;
+        response.pduSessionId = psi;
+        response.smCause = nas::IE5gSmCause{cause};
+        sendDownlinkNasTransport(ue, encodeSm(ue, psi, response));
+    };
+
+    if (psi < 1 || psi > 15)
+    {
+        reject(nas::ESmCause::INVALID_PDU_SESSION_IDENTITY);
+        return;
+    }
+
+    // The UE does not know the session any more, e.g. after a local release
+    if (ue.sessions.count(psi))
+        releaseSession(ue, psi);
+
+    if (msg.pduSessionType.has_value() && msg.pduSessionType->pduSessionType != nas::EPduSessionType::IPV4 &&
+        msg.pduSessionType->pduSessionType != nas::EPduSessionType::IPV4V6)
+    {
+        reject(nas::ESmCause::UNKNOWN_PDU_SESSION_TYPE);
+        return;
+    }
+
+    if (transport.dnn.has_value() && !nas::utils::DeepEqualsIe(*transport.dnn, nas::utils::DnnFromApn(config.dnn)))
+    {
+        reject(nas::ESmCause::MISSING_OR_UNKNOWN_DNN);
+        return;
+    }
+
+    SingleSlice slice{};
+    if (transport.sNssai.has_value())
+        slice = nas::utils::SNssaiTo(*transport.sNssai);
+    else if (!ue.subscribedNssai.slices.empty())
+        slice = ue.subscribedNssai.slices[0];
+    else
+        slice.sst = 1;
+
+    if (transport.sNssai.has_value() && !IsSliceSubscribed(ue.subscribedNssai, slice))
+    {
+        reject(nas::ESmCause::REQUEST_REJECTED_UNSPECIFIED);
+        return;
+    }
+
+    uint32_t address = m_stub->allocateUeAddress();
+    if (address == 0)
+    {
+        reject(nas::ESmCause::INSUFFICIENT_RESOURCES);
+        return;
+    }
+
+    auto &session = ue.sessions[psi];
+    session.psi = psi;
+    session.slice = slice;
+    session.dnn = config.dnn;
+    session.ueAddress = address;
+    session.uplinkTeid = m_stub->allocateTeid();
+    session.requestTime = startTime;
+
+    nas::PduSessionEstablishmentAccept accept;
+    accept.pti = msg.pti;
+    accept.pduSessionId = psi;
+    accept.selectedPduSessionType = nas::IEPduSessionType{nas::EPduSessionType::IPV4};
+    accept.selectedSscMode = nas::IESscMode{nas::ESscMode::SSC_MODE_1};
+    accept.authorizedQoSRules = nas::IEQoSRules{OctetString::FromHex(DEFAULT_QOS_RULES)};
+    accept.sessionAmbr = nas::IESessionAmbr{nas::EUnitForSessionAmbr::MULT_1Mbps, octet2{config.sessionAmbrDownlink},
+                                            nas::EUnitForSessionAmbr::MULT_1Mbps, octet2{config.sessionAmbrUplink}};
+    accept.pduAddress = nas::IEPduAddress{nas::EPduSessionType::IPV4, OctetString::FromOctet4(ntohl(address))};
+    accept.sNssai = nas::utils::SNssaiFrom(slice);
+    accept.dnn = nas::utils::DnnFromApn(config.dnn);
+
+    // Delivered by the gNB once the resources are set up, completed with the resource setup response
+    sendSessionResourceSetupRequest(ue, session, encodeSm(ue, psi, accept));
+}
+
+void AmfTask::receiveReleaseRequest(UeContext &ue, const nas::PduSessionReleaseRequest &msg)
+{
+    m_stub->metrics().started(EProcedure::PDU_SESSION_RELEASE);
+
+    int psi = msg.pduSessionId;
+    auto it = ue.sessions.find(psi);
+    if (it == ue.sessions.end())
+    {
+        m_stub->metrics().failed(EProcedure::PDU_SESSION_RELEASE);
+
+        nas::PduSessionReleaseReject response;
+        response.pti = msg.pti;
+        response.pduSessionId = psi;
+        response.smCause = nas::IE5gSmCause{nas::ESmCause::PDU_SESSION_DOES_NOT_EXIST};
+        sendDownlinkNasTransport(ue, encodeSm(ue, psi, response));
+        return;
+    }
+
+    it->second.requestTime = MetricsTime();
+
+    nas::PduSessionReleaseCommand command;
+    command.pti = msg.pti;
+    command.pduSessionId = psi;
+    command.smCause = nas::IE5gSmCause{nas::ESmCause::REGULAR_DEACTIVATION};
+
+    // Completed with the release complete of the UE
+    sendSessionResourceReleaseCommand(ue, psi, encodeSm(ue, psi, command));
+}
+
+void AmfTask::receiveReleaseComplete(UeContext &ue, const nas::PduSessionReleaseComplete &msg)
+{
+    auto it = ue.sessions.find(msg.pduSessionId);
+    if (it == ue.sessions.end())
+        return;
+
+    m_stub->metrics().completed(EProcedure::PDU_SESSION_RELEASE, it->second.requestTime);
+    releaseSession(ue, msg.pduSessionId);
+}
+
+bool AmfTask::identifyUe(UeContext &ue, const nas::IE5gsMobileIdentity &identity)
+{
+    std::string supi{};
+
+    if (identity.type == nas::EIdentityType::SUCI)
+    {
+        // Only the null scheme, the stub has no home network private keys
+        if (identity.supiFormat != nas::ESupiFormat::IMSI || identity.imsi.protectionSchemaId != 0)
+        {
+            m_logger->err(FMT_STRING("SUCI of UE[{}] is not an IMSI with the null scheme"), ue.amfUeNgapId);
+            return false;
+        }
+        supi = SupiFromSuci(identity.imsi);
+    }
+    else if (identity.type == nas::EIdentityType::GUTI)
+    {
+        auto found = m_stub->findSupiByTmsi(identity.gutiOrTmsi.tmsi);
+        if (!found.has_value())
+            return false;
+        supi = *found;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (!m_stub->findSubscriber(supi, ue.credentials, ue.subscribedNssai))
+    {
+        m_logger->err(FMT_STRING("SUPI[imsi-{}] is not a known subscriber"), supi);
+        return false;
+    }
+
+    ue.supi = supi;
+    return true;
+}
+
+void AmfTask::startAuthentication(UeContext &ue)
+{
+    OctetString rand;
+    for (int i = 0; i < RAND_LENGTH; i++)
+        rand.appendOctet(static_cast<uint8_t>(m_random() & 0xFF));
+
+    auto vector = security::GenerateAuthVector(ue.credentials, security::ServingNetworkName(m_stub->config().plmn),
+                                               m_stub->nextSqn(ue.supi), std::move(rand));
+    ue.rand = std::move(vector.rand);
+    ue.xresStar = std::move(vector.xresStar);
+    ue.kAusf = std::move(vector.kAusf);
+
+    nas::AuthenticationRequest request;
+    request.ngKSI = nas::IENasKeySetIdentifier{nas::ETypeOfSecurityContext::NATIVE_SECURITY_CONTEXT, ue.pendingNgKsi};
+    request.abba = nas::IEAbba{OctetString::FromSpare(ABBA_LENGTH)};
+    request.authParamRAND = nas::IEAuthenticationParameterRand{ue.rand.copy()};
+    request.authParamAUTN = nas::IEAuthenticationParameterAutn{std::move(vector.autn)};
+
+    ue.state = EUeState::AUTHENTICATION;
+    sendNas(ue, request);
+}
+
+void AmfTask::startSecurityModeControl(UeContext &ue)
+{
+    auto &config = m_stub->config();
+    auto &cap = *ue.ueSecurityCapability;
+
+    // The configured algorithms are preferred, IA0 is never selected
+    std::optional<nas::ETypeOfIntegrityProtectionAlgorithm> integrity{};
+    for (auto alg : {config.integrity, nas::ETypeOfIntegrityProtectionAlgorithm::IA2_128,
+                     nas::ETypeOfIntegrityProtectionAlgorithm::IA1_128,
+                     nas::ETypeOfIntegrityProtectionAlgorithm::IA3_128})
+    {
+        if (SupportsIntegrity(cap, alg))
+        {
+            integrity = alg;
+            break;
+        }
+    }
+
+    std::optional<nas::ETypeOfCipheringAlgorithm> ciphering{};
+    for (auto alg : {config.ciphering, nas::ETypeOfCipheringAlgorithm::EA2_128, nas::ETypeOfCipheringAlgorithm::EA1_128,
+                     nas::ETypeOfCipheringAlgorithm::EA3_128, nas::ETypeOfCipheringAlgorithm::EA0})
+    {
+        if (SupportsCiphering(cap, alg))
+        {
+            ciphering = alg;
+            break;
+        }
+    }
+
+    if (!integrity.has_value() || !ciphering.has_value())
+    {
+        m_logger->err(FMT_STRING("UE[{}] supports none of the NAS security algorithms"), ue.amfUeNgapId);
+        rejectRegistration(ue, nas::EMmCause::UE_SECURITY_CAP_MISMATCH);
+        return;
+    }
+
+    ue.security.integrity = *integrity;
+    ue.security.ciphering = *ciphering;
+    security::DeriveNasKeys(ue.security);
+
+    nas::SecurityModeCommand command;
+    command.selectedNasSecurityAlgorithms = nas::IENasSecurityAlgorithms{*integrity, *ciphering};
+    command.ngKsi = nas::IENasKeySetIdentifier{nas::ETypeOfSecurityContext::NATIVE_SECURITY_CONTEXT, ue.security.ngKsi};
+    command.replayedUeSecurityCapabilities = nas::utils::DeepCopyIe(cap);
+    command.abba = nas::IEAbba{OctetString::FromSpare(ABBA_LENGTH)};
+
+    ue.state = EUeState::SECURITY_MODE;
+    sendDownlinkNasTransport(
+        ue, security::Protect(ue.security, command,
+                              nas::ESecurityHeaderType::INTEGRITY_PROTECTED_WITH_NEW_SECURITY_CONTEXT));
+}
+
+void AmfTask::releaseSession(UeContext &ue, int psi)
+{
+    auto it = ue.sessions.find(psi);
+    if (it == ue.sessions.end())
+        return;
+
+    if (it->second.isActive)
+        m_stub->metrics().addSessions(-1);
+    m_stub->releaseUeAddress(it->second.ueAddress);
+    ue.sessions.erase(it);
+}
+
+void AmfTask::rejectRegistration(UeContext &ue, nas::EMmCause cause)
+{
+    m_logger->err(FMT_STRING("Registration of UE[{}] is rejected [{}]"), ue.amfUeNgapId,
+                  nas::utils::EnumToString(cause));
+
+    if (ue.registrationStart != 0)
+        m_stub->metrics().failed(EProcedure::REGISTRATION);
+    ue.registrationStart = 0;
+
+    nas::RegistrationReject reject;
+    reject.mmCause = nas::IE5gMmCause{cause};
+    sendNas(ue, reject);
+    sendContextReleaseCommand(ue);
+}
+
+OctetString AmfTask::encodeNas(UeContext &ue, const nas::PlainMmMessage &msg)
+{
+    if (ue.security.isActive)
+        return security::Protect(ue.security, msg, nas::ESecurityHeaderType::INTEGRITY_PROTECTED_AND_CIPHERED);
+
+    OctetString stream;
+    nas::EncodeNasMessage(msg, stream);
+    return stream;
+}
+
+OctetString AmfTask::encodeSm(UeContext &ue, int psi, const nas::SmMessage &msg)
+{
+    OctetString payload;
+    nas::EncodeNasMessage(msg, payload);
+
+    nas::DlNasTransport transport;
+    transport.payloadContainerType = nas::IEPayloadContainerType{nas::EPayloadContainerType::N1_SM_INFORMATION};
+    transport.payloadContainer = nas::IEPayloadContainer{std::move(payload)};
+    transport.pduSessionId = nas::IEPduSessionIdentity2{static_cast<uint8_t>(psi)};
+    return encodeNas(ue, transport);
+}
+
+void AmfTask::sendNas(UeContext &ue, const nas::PlainMmMessage &msg)
+{
+    sendDownlinkNasTransport(ue, encodeNas(ue, msg));
+}
+
+} // namespace nr::amf
@@ -0,0 +1,778 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "metrics.hpp"
+#include "security.hpp"
+#include "stub.hpp"
+#include "task.hpp"
+
+#include <vector>
+
+#include <gnb/ngap/encode.hpp>
+#include <gnb/ngap/utils.hpp>
+#include <lib/asn/ngap.hpp>
+#include <lib/asn/utils.hpp>
+#include <utils/common.hpp>
+
+#include <asn/ngap/ASN_NGAP_AMF-UE-NGAP-ID.h>
+#include <asn/ngap/ASN_NGAP_AllowedNSSAI-Item.h>
+#include <asn/ngap/ASN_NGAP_BroadcastPLMNItem.h>
+#include <asn/ngap/ASN_NGAP_GTPTunnel.h>
+#include <asn/ngap/ASN_NGAP_InitialContextSetupRequest.h>
+#include <asn/ngap/ASN_NGAP_InitialUEMessage.h>
+#include <asn/ngap/ASN_NGAP_InitiatingMessage.h>
+#include <asn/ngap/ASN_NGAP_DownlinkNASTransport.h>
+#include <asn/ngap/ASN_NGAP_NGAP-PDU.h>
+#include <asn/ngap/ASN_NGAP_NGSetupFailure.h>
+#include <asn/ngap/ASN_NGAP_NGSetupRequest.h>
+#include <asn/ngap/ASN_NGAP_NGSetupResponse.h>
+#include <asn/ngap/ASN_NGAP_NonDynamic5QIDescriptor.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceFailedToSetupItemSURes.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceReleaseCommand.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceReleaseCommandTransfer.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceReleasedItemPSAck.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceReleasedItemPSFail.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceSetupItemSUReq.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceSetupItemSURes.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceSetupRequest.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceSetupRequestTransfer.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceSetupResponse.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceSetupResponseTransfer.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceSwitchedItem.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceToBeSwitchedDLItem.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceToReleaseItemRelCmd.h>
+#include <asn/ngap/ASN_NGAP_PLMNSupportItem.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequest.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequestAcknowledge.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequestAcknowledgeTransfer.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequestFailure.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequestTransfer.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequestUnsuccessfulTransfer.h>
+#include <asn/ngap/ASN_NGAP_ProtocolIE-Field.h>
+#include <asn/ngap/ASN_NGAP_QosFlowSetupRequestItem.h>
+#include <asn/ngap/ASN_NGAP_RAN-UE-NGAP-ID.h>
+#include <asn/ngap/ASN_NGAP_ServedGUAMIItem.h>
+#include <asn/ngap/ASN_NGAP_SliceSupportItem.h>
+#include <asn/ngap/ASN_NGAP_SuccessfulOutcome.h>
+#include <asn/ngap/ASN_NGAP_SupportedTAItem.h>
+#include <asn/ngap/ASN_NGAP_UE-NGAP-ID-pair.h>
+#include <asn/ngap/ASN_NGAP_UE-NGAP-IDs.h>
+#include <asn/ngap/ASN_NGAP_UEContextReleaseCommand.h>
+#include <asn/ngap/ASN_NGAP_UEContextReleaseComplete.h>
+#include <asn/ngap/ASN_NGAP_UEContextReleaseRequest.h>
+#include <asn/ngap/ASN_NGAP_UESecurityCapabilities.h>
+#include <asn/ngap/ASN_NGAP_UnsuccessfulOutcome.h>
+#include <asn/ngap/ASN_NGAP_UplinkNASTransport.h>
+#include <asn/ngap/ASN_NGAP_UserLocationInformation.h>
+#include <asn/ngap/ASN_NGAP_UserLocationInformationNR.h>
+
+static constexpr const int QOS_FLOW_IDENTIFIER = 1;
+static constexpr const int ARP_PRIORITY_LEVEL = 8;
+static constexpr const uint64_t MEGABIT = 1000000;
+
+using namespace nr::gnb;
+
+template <typename T>
+static int64_t FindAmfUeNgapId(T *msg)
+{
+    auto *ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_AMF_UE_NGAP_ID);
+    return ie ? asn::GetSigned64(ie->AMF_UE_NGAP_ID) : -1;
+}
+
+static void SetGuami(const nr::amf::AmfStubConfig &config, ASN_NGAP_GUAMI_t &guami)
+{
+    ngap_utils::ToPlmnAsn_Ref(config.plmn, guami.pLMNIdentity);
+    asn::SetBitStringInt<8>(config.amfRegionId, guami.aMFRegionID);
+    asn::SetBitStringInt<10>(config.amfSetId, guami.aMFSetID);
+    asn::SetBitStringInt<6>(config.amfPointer, guami.aMFPointer);
+}
+
+static void SetSNssai(const SingleSlice &slice, ASN_NGAP_S_NSSAI_t &target)
+{
+    asn::SetOctetString1(target.sST, slice.sst);
+    if (slice.sd.has_value())
+    {
+        target.sD = asn::New<ASN_NGAP_SD_t>();
+        asn::SetOctetString3(*target.sD, *slice.sd);
+    }
+}
+
+static void SetAllowedNssai(const NetworkSlice &nssai, ASN_NGAP_AllowedNSSAI_t &target)
+{
+    for (auto &slice : nssai.slices)
+    {
+        auto *item = asn::New<ASN_NGAP_AllowedNSSAI_Item>();
+        SetSNssai(slice, item->s_NSSAI);
+        asn::SequenceAdd(target, item);
+    }
+}
+
+static void SetGtpTunnel(const std::string &address, uint32_t teid, ASN_NGAP_UPTransportLayerInformation_t &target)
+{
+    target.present = ASN_NGAP_UPTransportLayerInformation_PR_gTPTunnel;
+    target.choice.gTPTunnel = asn::New<ASN_NGAP_GTPTunnel>();
+    asn::SetBitString(target.choice.gTPTunnel->transportLayerAddress, utils::IpToOctetString(address));
+    asn::SetOctetString4(target.choice.gTPTunnel->gTP_TEID, octet4{teid});
+}
+
+static bool GetGtpTunnel(const ASN_NGAP_UPTransportLayerInformation_t &source, std::string &outAddress,
+                         uint32_t &outTeid)
+{
+    if (source.present != ASN_NGAP_UPTransportLayerInformation_PR_gTPTunnel || source.choice.gTPTunnel == nullptr)
+        return false;
+
+    outAddress = utils::OctetStringToIp(asn::GetOctetString(source.choice.gTPTunnel->transportLayerAddress));
+    outTeid = static_cast<uint32_t>(asn::GetOctet4(source.choice.gTPTunnel->gTP_TEID));
+    return true;
+}
+
+static OctetString EncodeUnsuccessfulTransfer(NgapCause cause)
+{
+    auto *transfer = asn::New<ASN_NGAP_PathSwitchRequestUnsuccessfulTransfer>();
+    ngap_utils::ToCauseAsn_Ref(cause, transfer->cause);
+    OctetString encoded = ngap_encode::EncodeS(asn_DEF_ASN_NGAP_PathSwitchRequestUnsuccessfulTransfer, transfer);
+    asn::Free(asn_DEF_ASN_NGAP_PathSwitchRequestUnsuccessfulTransfer, transfer);
+    return encoded;
+}
+
+namespace nr::amf
+{
+
+void AmfTask::handleNgapMessage(const std::shared_ptr<GnbAssociation> &association, uint16_t stream,
+                                ASN_NGAP_NGAP_PDU &pdu)
+{
+    if (pdu.present == ASN_NGAP_NGAP_PDU_PR_initiatingMessage)
+    {
+        auto &value = pdu.choice.initiatingMessage->value;
+        switch (value.present)
+        {
+        case ASN_NGAP_InitiatingMessage__value_PR_NGSetupRequest:
+            receiveNgSetupRequest(association, &value.choice.NGSetupRequest);
+            break;
+        case ASN_NGAP_InitiatingMessage__value_PR_InitialUEMessage:
+            receiveInitialUeMessage(association, stream, &value.choice.InitialUEMessage);
+            break;
+        case ASN_NGAP_InitiatingMessage__value_PR_UplinkNASTransport:
+            receiveUplinkNasTransport(&value.choice.UplinkNASTransport);
+            break;
+        case ASN_NGAP_InitiatingMessage__value_PR_UEContextReleaseRequest:
+            receiveContextReleaseRequest(&value.choice.UEContextReleaseRequest);
+            break;
+        case ASN_NGAP_InitiatingMessage__value_PR_PathSwitchRequest:
+            receivePathSwitchRequest(association, stream, &value.choice.PathSwitchRequest);
+            break;
+        case ASN_NGAP_InitiatingMessage__value_PR_ErrorIndication:
+            m_logger->warn(FMT_STRING("Error indication received from association[{}]"), association->id);
+            break;
+        default:
+            m_logger->debug(FMT_STRING("Unhandled NGAP initiating-message received ({})"), value.present);
+            break;
+        }
+    }
+    else if (pdu.present == ASN_NGAP_NGAP_PDU_PR_successfulOutcome)
+    {
+        auto &value = pdu.choice.successfulOutcome->value;
+        switch (value.present)
+        {
+        case ASN_NGAP_SuccessfulOutcome__value_PR_PDUSessionResourceSetupResponse:
+            receiveSessionResourceSetupResponse(&value.choice.PDUSessionResourceSetupResponse);
+            break;
+        case ASN_NGAP_SuccessfulOutcome__value_PR_UEContextReleaseComplete:
+            receiveContextReleaseComplete(&value.choice.UEContextReleaseComplete);
+            break;
+        case ASN_NGAP_SuccessfulOutcome__value_PR_InitialContextSetupResponse:
+        case ASN_NGAP_SuccessfulOutcome__value_PR_PDUSessionResourceReleaseResponse:
+            break;
+        default:
+            m_logger->debug(FMT_STRING("Unhandled NGAP successful-outcome received ({})"), value.present);
+            break;
+        }
+    }
+    else if (pdu.present == ASN_NGAP_NGAP_PDU_PR_unsuccessfulOutcome)
+    {
+        m_logger->warn(FMT_STRING("NGAP unsuccessful-outcome received ({})"),
+                       pdu.choice.unsuccessfulOutcome->value.present);
+    }
+}
+
+void AmfTask::receiveNgSetupRequest(const std::shared_ptr<GnbAssociation> &association,
+                                    ASN_NGAP_NGSetupRequest *msg)
+{
+    auto *ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_RANNodeName);
+    if (ie)
+        association->name = asn::GetPrintableString(ie->RANNodeName);
+
+    auto &config = m_stub->config();
+
+    bool isPlmnSupported = false;
+    ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_SupportedTAList);
+    if (ie)
+    {
+        asn::ForeachItem(ie->SupportedTAList, [&config, &isPlmnSupported](ASN_NGAP_SupportedTAItem &ta) {
+            asn::ForeachItem(ta.broadcastPLMNList, [&config, &isPlmnSupported](ASN_NGAP_BroadcastPLMNItem &item) {
+                Plmn plmn{};
+                ngap_utils::PlmnFromAsn_Ref(item.pLMNIdentity, plmn);
+                if (plmn.mcc == config.plmn.mcc && plmn.mnc == config.plmn.mnc)
+                    isPlmnSupported = true;
+            });
+        });
+    }
+
+    if (!isPlmnSupported)
+    {
+        m_logger->err(FMT_STRING("NG Setup of association[{}] is rejected, no supported TA in the PLMN"),
+                      association->id);
+
+        auto *ieCause = asn::New<ASN_NGAP_NGSetupFailureIEs>();
+        ieCause->id = ASN_NGAP_ProtocolIE_ID_id_Cause;
+        ieCause->criticality = ASN_NGAP_Criticality_ignore;
+        ieCause->value.present = ASN_NGAP_NGSetupFailureIEs__value_PR_Cause;
+        ngap_utils::ToCauseAsn_Ref(NgapCause::Misc_unknown_PLMN, ieCause->value.choice.Cause);
+
+        m_stub->sendNgap(*association, 0, asn::ngap::NewMessagePdu<ASN_NGAP_NGSetupFailure>({ieCause}));
+        return;
+    }
+
+    auto *ieAmfName = asn::New<ASN_NGAP_NGSetupResponseIEs>();
+    ieAmfName->id = ASN_NGAP_ProtocolIE_ID_id_AMFName;
+    ieAmfName->criticality = ASN_NGAP_Criticality_reject;
+    ieAmfName->value.present = ASN_NGAP_NGSetupResponseIEs__value_PR_AMFName;
+    asn::SetPrintableString(ieAmfName->value.choice.AMFName, config.amfName);
+
+    auto *servedGuami = asn::New<ASN_NGAP_ServedGUAMIItem>();
+    SetGuami(config, servedGuami->gUAMI);
+
+    auto *ieServedGuamiList = asn::New<ASN_NGAP_NGSetupResponseIEs>();
+    ieServedGuamiList->id = ASN_NGAP_ProtocolIE_ID_id_ServedGUAMIList;
+    ieServedGuamiList->criticality = ASN_NGAP_Criticality_reject;
+    ieServedGuamiList->value.present = ASN_NGAP_NGSetupResponseIEs__value_PR_ServedGUAMIList;
+    asn::SequenceAdd(ieServedGuamiList->value.choice.ServedGUAMIList, servedGuami);
+
+    auto *ieCapacity = asn::New<ASN_NGAP_NGSetupResponseIEs>();
+    ieCapacity->id = ASN_NGAP_ProtocolIE_ID_id_RelativeAMFCapacity;
+    ieCapacity->criticality = ASN_NGAP_Criticality_ignore;
+    ieCapacity->value.present = ASN_NGAP_NGSetupResponseIEs__value_PR_RelativeAMFCapacity;
+    ieCapacity->value.choice.RelativeAMFCapacity = config.relativeCapacity;
+
+    auto *plmnSupport = asn::New<ASN_NGAP_PLMNSupportItem>();
+    ngap_utils::ToPlmnAsn_Ref(config.plmn, plmnSupport->pLMNIdentity);
+    for (auto &slice : config.nssai.slices)
+    {
+        auto *item = asn::New<ASN_NGAP_SliceSupportItem>();
+        SetSNssai(slice, item->s_NSSAI);
+        asn::SequenceAdd(plmnSupport->sliceSupportList, item);
+    }
+
+    auto *iePlmnSupportList = asn::New<ASN_NGAP_NGSetupResponseIEs>();
+    iePlmnSupportList->id = ASN_NGAP_ProtocolIE_ID_id_PLMNSupportList;
+    iePlmnSupportList->criticality = ASN_NGAP_Criticality_reject;
+    iePlmnSupportList->value.present = ASN_NGAP_NGSetupResponseIEs__value_PR_PLMNSupportList;
+    asn::SequenceAdd(iePlmnSupportList->value.choice.PLMNSupportList, plmnSupport);
+
+    auto *pdu = asn::ngap::NewMessagePdu<ASN_NGAP_NGSetupResponse>(
+        {ieAmfName, ieServedGuamiList, ieCapacity, iePlmnSupportList});
+    m_stub->sendNgap(*association, 0, pdu);
+    m_stub->metrics().ngSetupCompleted();
+
+    m_logger->info(FMT_STRING("NG Setup of association[{}] '{}' is successful"), association->id, association->name);
+}
+
+void AmfTask::receiveInitialUeMessage(const std::shared_ptr<GnbAssociation> &association, uint16_t stream,
+                                      ASN_NGAP_InitialUEMessage *msg)
+{
+    auto *ieRanId = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_RAN_UE_NGAP_ID);
+    auto *ieNasPdu = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_NAS_PDU);
+    if (ieRanId == nullptr || ieNasPdu == nullptr)
+    {
+        m_logger->err("Initial UE message without a RAN UE NGAP ID or a NAS PDU is ignored");
+        return;
+    }
+
+    auto *ue = createUe(association, stream, ieRanId->RAN_UE_NGAP_ID);
+
+    auto *ieLocation = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_UserLocationInformation);
+    if (ieLocation &&
+        ieLocation->UserLocationInformation.present == ASN_NGAP_UserLocationInformation_PR_userLocationInformationNR)
+    {
+        auto &nr = *ieLocation->UserLocationInformation.choice.userLocationInformationNR;
+        ngap_utils::PlmnFromAsn_Ref(nr.tAI.pLMNIdentity, ue->tai.plmn);
+        ue->tai.tac = static_cast<int>(asn::GetOctet3(nr.tAI.tAC));
+    }
+
+    receiveNas(*ue, asn::GetOctetString(ieNasPdu->NAS_PDU));
+}
+
+void AmfTask::receiveUplinkNasTransport(ASN_NGAP_UplinkNASTransport *msg)
+{
+    auto *ue = findUe(FindAmfUeNgapId(msg));
+    if (ue == nullptr)
+    {
+        m_logger->err("Uplink NAS transport for an unknown UE is ignored");
+        return;
+    }
+
+    auto *ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_NAS_PDU);
+    if (ie)
+        receiveNas(*ue, asn::GetOctetString(ie->NAS_PDU));
+}
+
+void AmfTask::receiveSessionResourceSetupResponse(ASN_NGAP_PDUSessionResourceSetupResponse *msg)
+{
+    auto *ue = findUe(FindAmfUeNgapId(msg));
+    if (ue == nullptr)
+        return;
+
+    auto *ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceSetupListSURes);
+    if (ie)
+    {
+        asn::ForeachItem(ie->PDUSessionResourceSetupListSURes, [this, ue](ASN_NGAP_PDUSessionResourceSetupItemSURes &item) {
+            auto it = ue->sessions.find(static_cast<int>(item.pDUSessionID));
+            if (it == ue->sessions.end())
+                return;
+            auto &session = it->second;
+
+            auto *transfer = ngap_encode::Decode<ASN_NGAP_PDUSessionResourceSetupResponseTransfer>(
+                asn_DEF_ASN_NGAP_PDUSessionResourceSetupResponseTransfer, item.pDUSessionResourceSetupResponseTransfer);
+            bool hasTunnel = transfer != nullptr &&
+                             GetGtpTunnel(transfer->dLQosFlowPerTNLInformation.uPTransportLayerInformation,
+                                          session.gnbAddress, session.downlinkTeid);
+            asn::Free(asn_DEF_ASN_NGAP_PDUSessionResourceSetupResponseTransfer, transfer);
+
+            if (!hasTunnel)
+            {
+                m_logger->err(FMT_STRING("PDU session resource setup response without a downlink tunnel, PSI[{}]"),
+                              session.psi);
+                return;
+            }
+
+            if (!session.isActive)
+            {
+                session.isActive = true;
+                m_stub->metrics().addSessions(1);
+                m_stub->metrics().completed(EProcedure::PDU_SESSION_ESTABLISHMENT, session.requestTime);
+            }
+            m_stub->notifyTunnel(session.uplinkTeid, session.downlinkTeid, session.gnbAddress);
+        });
+    }
+
+    ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceFailedToSetupListSURes);
+    if (ie)
+    {
+        asn::ForeachItem(ie->PDUSessionResourceFailedToSetupListSURes,
+                         [this, ue](ASN_NGAP_PDUSessionResourceFailedToSetupItemSURes &item) {
+                             int psi = static_cast<int>(item.pDUSessionID);
+                             m_logger->err(FMT_STRING("PDU session resource setup failed, PSI[{}]"), psi);
+                             m_stub->metrics().failed(EProcedure::PDU_SESSION_ESTABLISHMENT);
+
+                             auto it = ue->sessions.find(psi);
+                             if (it != ue->sessions.end())
+                             {
+                                 m_stub->releaseUeAddress(it->second.ueAddress);
+                                 ue->sessions.erase(it);
+                             }
+                         });
+    }
+}
+
+void AmfTask::receiveContextReleaseRequest(ASN_NGAP_UEContextReleaseRequest *msg)
+{
+    auto *ue = findUe(FindAmfUeNgapId(msg));
+    if (ue == nullptr)
+        return;
+
+    sendContextReleaseCommand(*ue);
+}
+
+void AmfTask::receiveContextReleaseComplete(ASN_NGAP_UEContextReleaseComplete *msg)
+{
+    auto *ue = findUe(FindAmfUeNgapId(msg));
+    if (ue == nullptr)
+        return;
+
+    if (ue->state == EUeState::DEREGISTERING && ue->deregistrationStart != 0)
+        m_stub->metrics().completed(EProcedure::DEREGISTRATION, ue->deregistrationStart);
+
+    deleteUe(ue->amfUeNgapId);
+}
+
+void AmfTask::receivePathSwitchRequest(const std::shared_ptr<GnbAssociation> &association, uint16_t stream,
+                                       ASN_NGAP_PathSwitchRequest *msg)
+{
+    int64_t startTime = MetricsTime();
+
+    auto *ieSourceId = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_SourceAMF_UE_NGAP_ID);
+    auto *ieRanId = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_RAN_UE_NGAP_ID);
+    if (ieSourceId == nullptr || ieRanId == nullptr)
+    {
+        m_logger->err("Path switch request without the UE NGAP IDs is ignored");
+        return;
+    }
+
+    auto *ue = findUe(asn::GetSigned64(ieSourceId->AMF_UE_NGAP_ID));
+    if (ue == nullptr)
+    {
+        m_logger->err("Path switch request for an unknown UE is ignored");
+        return;
+    }
+
+    m_stub->metrics().started(EProcedure::PATH_SWITCH);
+
+    // The UE is served by the target gNB from now on
+    ue->association = association;
+    ue->stream = stream;
+    ue->ranUeNgapId = ieRanId->RAN_UE_NGAP_ID;
+
+    auto *ieLocation = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_UserLocationInformation);
+    if (ieLocation &&
+        ieLocation->UserLocationInformation.present == ASN_NGAP_UserLocationInformation_PR_userLocationInformationNR)
+    {
+        auto &nr = *ieLocation->UserLocationInformation.choice.userLocationInformationNR;
+        ngap_utils::PlmnFromAsn_Ref(nr.tAI.pLMNIdentity, ue->tai.plmn);
+        ue->tai.tac = static_cast<int>(asn::GetOctet3(nr.tAI.tAC));
+    }
+
+    std::vector<ASN_NGAP_PDUSessionResourceSwitchedItem *> switchedList;
+    std::vector<int> releasedList;
+
+    auto *ieSessions = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceToBeSwitchedDLList);
+    if (ieSessions)
+    {
+        asn::ForeachItem(ieSessions->PDUSessionResourceToBeSwitchedDLList,
+                         [this, ue, &switchedList, &releasedList](ASN_NGAP_PDUSessionResourceToBeSwitchedDLItem &item) {
+                             int psi = static_cast<int>(item.pDUSessionID);
+                             auto it = ue->sessions.find(psi);
+
+                             auto *transfer = ngap_encode::Decode<ASN_NGAP_PathSwitchRequestTransfer>(
+                                 asn_DEF_ASN_NGAP_PathSwitchRequestTransfer, item.pathSwitchRequestTransfer);
+
+                             std::string address{};
+                             uint32_t teid{};
+                             bool hasTunnel = transfer != nullptr &&
+                                              GetGtpTunnel(transfer->dL_NGU_UP_TNLInformation, address, teid);
+                             asn::Free(asn_DEF_ASN_NGAP_PathSwitchRequestTransfer, transfer);
+
+                             if (it == ue->sessions.end() || !hasTunnel)
+                             {
+                                 releasedList.push_back(psi);
+                                 return;
+                             }
+
+                             auto &session = it->second;
+                             session.gnbAddress = address;
+                             session.downlinkTeid = teid;
+                             m_stub->notifyTunnel(session.uplinkTeid, session.downlinkTeid, session.gnbAddress);
+
+                             auto *ackTransfer = asn::New<ASN_NGAP_PathSwitchRequestAcknowledgeTransfer>();
+                             ackTransfer->uL_NGU_UP_TNLInformation = asn::New<ASN_NGAP_UPTransportLayerInformation>();
+                             SetGtpTunnel(m_stub->config().upfAddress, session.uplinkTeid,
+                                          *ackTransfer->uL_NGU_UP_TNLInformation);
+
+                             auto *switched = asn::New<ASN_NGAP_PDUSessionResourceSwitchedItem>();
+                             switched->pDUSessionID = psi;
+                             asn::SetOctetString(
+                                 switched->pathSwitchRequestAcknowledgeTransfer,
+                                 ngap_encode::EncodeS(asn_DEF_ASN_NGAP_PathSwitchRequestAcknowledgeTransfer, ackTransfer));
+                             asn::Free(asn_DEF_ASN_NGAP_PathSwitchRequestAcknowledgeTransfer, ackTransfer);
+
+                             switchedList.push_back(switched);
+                         });
+    }
+
+    if (switchedList.empty())
+    {
+        m_logger->err(FMT_STRING("Path switch of UE[{}] failed, none of the PDU sessions is known"), ue->amfUeNgapId);
+        m_stub->metrics().failed(EProcedure::PATH_SWITCH);
+
+        auto *ieReleased = asn::New<ASN_NGAP_PathSwitchRequestFailureIEs>();
+        ieReleased->id = ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceReleasedListPSFail;
+        ieReleased->criticality = ASN_NGAP_Criticality_ignore;
+        ieReleased->value.present = ASN_NGAP_PathSwitchRequestFailureIEs__value_PR_PDUSessionResourceReleasedListPSFail;
+        for (int psi : releasedList)
+        {
+            auto *item = asn::New<ASN_NGAP_PDUSessionResourceReleasedItemPSFail>();
+            item->pDUSessionID = psi;
+            asn::SetOctetString(item->pathSwitchRequestUnsuccessfulTransfer,
+                                EncodeUnsuccessfulTransfer(NgapCause::RadioNetwork_unknown_PDU_session_ID));
+            asn::SequenceAdd(ieReleased->value.choice.PDUSessionResourceReleasedListPSFail, item);
+        }
+
+        sendNgapUeAssociated(*ue, asn::ngap::NewMessagePdu<ASN_NGAP_PathSwitchRequestFailure>({ieReleased}));
+        return;
+    }
+
+    // Vertical key derivation, chained from the KgNB of the initial context setup
+    ue->nextHop = security::DeriveNextHop(ue->security.kAmf, ue->nextHop);
+    ue->nextHopChainingCount = (ue->nextHopChainingCount + 1) & 0x7;
+
+    auto *ieSecurityContext = asn::New<ASN_NGAP_PathSwitchRequestAcknowledgeIEs>();
+    ieSecurityContext->id = ASN_NGAP_ProtocolIE_ID_id_SecurityContext;
+    ieSecurityContext->criticality = ASN_NGAP_Criticality_reject;
+    ieSecurityContext->value.present = ASN_NGAP_PathSwitchRequestAcknowledgeIEs__value_PR_SecurityContext;
+    ieSecurityContext->value.choice.SecurityContext.nextHopChainingCount = ue->nextHopChainingCount;
+    asn::SetBitString(ieSecurityContext->value.choice.SecurityContext.nextHopNH, ue->nextHop);
+
+    auto *ieSwitched = asn::New<ASN_NGAP_PathSwitchRequestAcknowledgeIEs>();
+    ieSwitched->id = ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceSwitchedList;
+    ieSwitched->criticality = ASN_NGAP_Criticality_ignore;
+    ieSwitched->value.present = ASN_NGAP_PathSwitchRequestAcknowledgeIEs__value_PR_PDUSessionResourceSwitchedList;
+    for (auto *item : switchedList)
+        asn::SequenceAdd(ieSwitched->value.choice.PDUSessionResourceSwitchedList, item);
+
+    auto *ieAllowedNssai = asn::New<ASN_NGAP_PathSwitchRequestAcknowledgeIEs>();
+    ieAllowedNssai->id = ASN_NGAP_ProtocolIE_ID_id_AllowedNSSAI;
+    ieAllowedNssai->criticality = ASN_NGAP_Criticality_reject;
+    ieAllowedNssai->value.present = ASN_NGAP_PathSwitchRequestAcknowledgeIEs__value_PR_AllowedNSSAI;
+    SetAllowedNssai(ue->subscribedNssai, ieAllowedNssai->value.choice.AllowedNSSAI);
+
+    std::vector<ASN_NGAP_PathSwitchRequestAcknowledgeIEs *> ies{ieSecurityContext, ieSwitched, ieAllowedNssai};
+
+    if (!releasedList.empty())
+    {
+        auto *ieReleased = asn::New<ASN_NGAP_PathSwitchRequestAcknowledgeIEs>();
+        ieReleased->id = ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceReleasedListPSAck;
+        ieReleased->criticality = ASN_NGAP_Criticality_ignore;
+        ieReleased->value.present =
+            ASN_NGAP_PathSwitchRequestAcknowledgeIEs__value_PR_PDUSessionResourceReleasedListPSAck;
+        for (int psi : releasedList)
+        {
+            auto *item = asn::New<ASN_NGAP_PDUSessionResourceReleasedItemPSAck>();
+            item->pDUSessionID = psi;
+            asn::SetOctetString(item->pathSwitchRequestUnsuccessfulTransfer,
+                                EncodeUnsuccessfulTransfer(NgapCause::RadioNetwork_unknown_PDU_session_ID));
+            asn::SequenceAdd(ieReleased->value.choice.PDUSessionResourceReleasedListPSAck, item);
+        }
+        ies.push_back(ieReleased);
+    }
+
+    sendNgapUeAssociated(*ue, asn::ngap::NewMessagePdu<ASN_NGAP_PathSwitchRequestAcknowledge>(ies));
+
+    m_stub->metrics().completed(EProcedure::PATH_SWITCH, startTime);
+    m_logger->debug(FMT_STRING("Path switch of UE[{}] to association[{}] is successful"), ue->amfUeNgapId,
+                    association->id);
+}
+
+void AmfTask::sendNgapUeAssociated(UeContext &ue, ASN_NGAP_NGAP_PDU *pdu)
+{
+    if (ue.association == nullptr)
+    {
+        asn::Free(asn_DEF_ASN_NGAP_NGAP_PDU, pdu);
+        return;
+    }
+
+    auto criticality =
+        pdu->present == ASN_NGAP_NGAP_PDU_PR_initiatingMessage ? ASN_NGAP_Criticality_reject : ASN_NGAP_Criticality_ignore;
+
+    asn::ngap::AddProtocolIeIfUsable(*pdu, asn_DEF_ASN_NGAP_AMF_UE_NGAP_ID, ASN_NGAP_ProtocolIE_ID_id_AMF_UE_NGAP_ID,
+                                     criticality, [&ue](void *mem) {
+                                         auto &id = *reinterpret_cast<ASN_NGAP_AMF_UE_NGAP_ID_t *>(mem);
+                                         asn::SetSigned64(ue.amfUeNgapId, id);
+                                     });
+
+    asn::ngap::AddProtocolIeIfUsable(
+        *pdu, asn_DEF_ASN_NGAP_RAN_UE_NGAP_ID, ASN_NGAP_ProtocolIE_ID_id_RAN_UE_NGAP_ID, criticality,
+        [&ue](void *mem) { *reinterpret_cast<ASN_NGAP_RAN_UE_NGAP_ID_t *>(mem) = ue.ranUeNgapId; });
+
+    m_stub->sendNgap(*ue.association, ue.stream, pdu);
+}
+
+void AmfTask::sendDownlinkNasTransport(UeContext &ue, const OctetString &nasPdu)
+{
+    auto *ie = asn::New<ASN_NGAP_DownlinkNASTransport_IEs>();
+    ie->id = ASN_NGAP_ProtocolIE_ID_id_NAS_PDU;
+    ie->criticality = ASN_NGAP_Criticality_reject;
+    ie->value.present = ASN_NGAP_DownlinkNASTransport_IEs__value_PR_NAS_PDU;
+    asn::SetOctetString(ie->value.choice.NAS_PDU, nasPdu);
+
+    sendNgapUeAssociated(ue, asn::ngap::NewMessagePdu<ASN_NGAP_DownlinkNASTransport>({ie}));
+}
+
+void AmfTask::sendInitialContextSetupRequest(UeContext &ue, const OctetString &nasPdu)
+{
+    auto &config = m_stub->config();
+
+    auto *ieAmbr = asn::New<ASN_NGAP_InitialContextSetupRequestIEs>();
+    ieAmbr->id = ASN_NGAP_ProtocolIE_ID_id_UEAggregateMaximumBitRate;
+    ieAmbr->criticality = ASN_NGAP_Criticality_reject;
+    ieAmbr->value.present = ASN_NGAP_InitialContextSetupRequestIEs__value_PR_UEAggregateMaximumBitRate;
+    asn::SetUnsigned64(config.sessionAmbrDownlink * MEGABIT,
+                       ieAmbr->value.choice.UEAggregateMaximumBitRate.uEAggregateMaximumBitRateDL);
+    asn::SetUnsigned64(config.sessionAmbrUplink * MEGABIT,
+                       ieAmbr->value.choice.UEAggregateMaximumBitRate.uEAggregateMaximumBitRateUL);
+
+    auto *ieGuami = asn::New<ASN_NGAP_InitialContextSetupRequestIEs>();
+    ieGuami->id = ASN_NGAP_ProtocolIE_ID_id_GUAMI;
+    ieGuami->criticality = ASN_NGAP_Criticality_reject;
+    ieGuami->value.present = ASN_NGAP_InitialContextSetupRequestIEs__value_PR_GUAMI;
+    SetGuami(config, ieGuami->value.choice.GUAMI);
+
+    auto *ieAllowedNssai = asn::New<ASN_NGAP_InitialContextSetupRequestIEs>();
+    ieAllowedNssai->id = ASN_NGAP_ProtocolIE_ID_id_AllowedNSSAI;
+    ieAllowedNssai->criticality = ASN_NGAP_Criticality_reject;
+    ieAllowedNssai->value.present = ASN_NGAP_InitialContextSetupRequestIEs__value_PR_AllowedNSSAI;
+    SetAllowedNssai(ue.subscribedNssai, ieAllowedNssai->value.choice.AllowedNSSAI);
+
+    // The 5G algorithms of the NAS capability, which is what the UE supports for the AS as well
+    int encryption = 0, integrity = 0;
+    if (ue.ueSecurityCapability.has_value())
+    {
+        auto &cap = *ue.ueSecurityCapability;
+        encryption = (cap.b_128_5G_EA1 ? 1 << 15 : 0) | (cap.b_128_5G_EA2 ? 1 << 14 : 0) |
+                     (cap.b_128_5G_EA3 ? 1 << 13 : 0);
+        integrity = (cap.b_128_5G_IA1 ? 1 << 15 : 0) | (cap.b_128_5G_IA2 ? 1 << 14 : 0) |
+                    (cap.b_128_5G_IA3 ? 1 << 13 : 0);
+    }
+
+    auto *ieCapabilities = asn::New<ASN_NGAP_InitialContextSetupRequestIEs>();
+    ieCapabilities->id = ASN_NGAP_ProtocolIE_ID_id_UESecurityCapabilities;
+    ieCapabilities->criticality = ASN_NGAP_Criticality_reject;
+    ieCapabilities->value.present = ASN_NGAP_InitialContextSetupRequestIEs__value_PR_UESecurityCapabilities;
+    auto &capabilities = ieCapabilities->value.choice.UESecurityCapabilities;
+    asn::SetBitStringInt<16>(encryption, capabilities.nRencryptionAlgorithms);
+    asn::SetBitStringInt<16>(integrity, capabilities.nRintegrityProtectionAlgorithms);
+    asn::SetBitStringInt<16>(0, capabilities.eUTRAencryptionAlgorithms);
+    asn::SetBitStringInt<16>(0, capabilities.eUTRAintegrityProtectionAlgorithms);
+
+    auto *ieSecurityKey = asn::New<ASN_NGAP_InitialContextSetupRequestIEs>();
+    ieSecurityKey->id = ASN_NGAP_ProtocolIE_ID_id_SecurityKey;
+    ieSecurityKey->criticality = ASN_NGAP_Criticality_reject;
+    ieSecurityKey->value.present = ASN_NGAP_InitialContextSetupRequestIEs__value_PR_SecurityKey;
+    ue.nextHop = security::DeriveKgnb(ue.security.kAmf, ue.security.uplinkCount);
+    ue.nextHopChainingCount = 0;
+    asn::SetBitString(ieSecurityKey->value.choice.SecurityKey, ue.nextHop);
+
+    auto *ieNasPdu = asn::New<ASN_NGAP_InitialContextSetupRequestIEs>();
+    ieNasPdu->id = ASN_NGAP_ProtocolIE_ID_id_NAS_PDU;
+    ieNasPdu->criticality = ASN_NGAP_Criticality_ignore;
+    ieNasPdu->value.present = ASN_NGAP_InitialContextSetupRequestIEs__value_PR_NAS_PDU;
+    asn::SetOctetString(ieNasPdu->value.choice.NAS_PDU, nasPdu);
+
+    auto *pdu = asn::ngap::NewMessagePdu<ASN_NGAP_InitialContextSetupRequest>(
+        {ieAmbr, ieGuami, ieAllowedNssai, ieCapabilities, ieSecurityKey, ieNasPdu});
+    sendNgapUeAssociated(ue, pdu);
+}
+
+void AmfTask::sendSessionResourceSetupRequest(UeContext &ue, const PduSession &session, const OctetString &nasPdu)
+{
+    auto &config = m_stub->config();
+
+    auto *transfer = asn::New<ASN_NGAP_PDUSessionResourceSetupRequestTransfer>();
+
+    auto *ieAmbr = asn::New<ASN_NGAP_PDUSessionResourceSetupRequestTransferIEs>();
+    ieAmbr->id = ASN_NGAP_ProtocolIE_ID_id_PDUSessionAggregateMaximumBitRate;
+    ieAmbr->criticality = ASN_NGAP_Criticality_reject;
+    ieAmbr->value.present = ASN_NGAP_PDUSessionResourceSetupRequestTransferIEs__value_PR_PDUSessionAggregateMaximumBitRate;
+    asn::SetUnsigned64(config.sessionAmbrDownlink * MEGABIT,
+                       ieAmbr->value.choice.PDUSessionAggregateMaximumBitRate.pDUSessionAggregateMaximumBitRateDL);
+    asn::SetUnsigned64(config.sessionAmbrUplink * MEGABIT,
+                       ieAmbr->value.choice.PDUSessionAggregateMaximumBitRate.pDUSessionAggregateMaximumBitRateUL);
+    asn::ngap::AddProtocolIe(*transfer, ieAmbr);
+
+    auto *ieTunnel = asn::New<ASN_NGAP_PDUSessionResourceSetupRequestTransferIEs>();
+    ieTunnel->id = ASN_NGAP_ProtocolIE_ID_id_UL_NGU_UP_TNLInformation;
+    ieTunnel->criticality = ASN_NGAP_Criticality_reject;
+    ieTunnel->value.present = ASN_NGAP_PDUSessionResourceSetupRequestTransferIEs__value_PR_UPTransportLayerInformation;
+    SetGtpTunnel(config.upfAddress, session.uplinkTeid, ieTunnel->value.choice.UPTransportLayerInformation);
+    asn::ngap::AddProtocolIe(*transfer, ieTunnel);
+
+    auto *ieSessionType = asn::New<ASN_NGAP_PDUSessionResourceSetupRequestTransferIEs>();
+    ieSessionType->id = ASN_NGAP_ProtocolIE_ID_id_PDUSessionType;
+    ieSessionType->criticality = ASN_NGAP_Criticality_reject;
+    ieSessionType->value.present = ASN_NGAP_PDUSessionResourceSetupRequestTransferIEs__value_PR_PDUSessionType;
+    ieSessionType->value.choice.PDUSessionType = ASN_NGAP_PDUSessionType_ipv4;
+    asn::ngap::AddProtocolIe(*transfer, ieSessionType);
+
+    auto *qosFlow = asn::New<ASN_NGAP_QosFlowSetupRequestItem>();
+    qosFlow->qosFlowIdentifier = QOS_FLOW_IDENTIFIER;
+    auto &qosParameters = qosFlow->qosFlowLevelQosParameters;
+    qosParameters.qosCharacteristics.present = ASN_NGAP_QosCharacteristics_PR_nonDynamic5QI;
+    qosParameters.qosCharacteristics.choice.nonDynamic5QI = asn::New<ASN_NGAP_NonDynamic5QIDescriptor>();
+    qosParameters.qosCharacteristics.choice.nonDynamic5QI->fiveQI = config.fiveQi;
+    qosParameters.allocationAndRetentionPriority.priorityLevelARP = ARP_PRIORITY_LEVEL;
+    qosParameters.allocationAndRetentionPriority.pre_emptionCapability =
+        ASN_NGAP_Pre_emptionCapability_shall_not_trigger_pre_emption;
+    qosParameters.allocationAndRetentionPriority.pre_emptionVulnerability =
+        ASN_NGAP_Pre_emptionVulnerability_not_pre_emptable;
+
+    auto *ieQosFlows = asn::New<ASN_NGAP_PDUSessionResourceSetupRequestTransferIEs>();
+    ieQosFlows->id = ASN_NGAP_ProtocolIE_ID_id_QosFlowSetupRequestList;
+    ieQosFlows->criticality = ASN_NGAP_Criticality_reject;
+    ieQosFlows->value.present = ASN_NGAP_PDUSessionResourceSetupRequestTransferIEs__value_PR_QosFlowSetupRequestList;
+    asn::SequenceAdd(ieQosFlows->value.choice.QosFlowSetupRequestList, qosFlow);
+    asn::ngap::AddProtocolIe(*transfer, ieQosFlows);
+
+    OctetString encodedTransfer = ngap_encode::EncodeS(asn_DEF_ASN_NGAP_PDUSessionResourceSetupRequestTransfer, transfer);
+    asn::Free(asn_DEF_ASN_NGAP_PDUSessionResourceSetupRequestTransfer, transfer);
+
+    auto *item = asn::New<ASN_NGAP_PDUSessionResourceSetupItemSUReq>();
+    item->pDUSessionID = session.psi;
+    item->pDUSessionNAS_PDU = asn::New<ASN_NGAP_NAS_PDU_t>();
+    asn::SetOctetString(*item->pDUSessionNAS_PDU, nasPdu);
+    SetSNssai(session.slice, item->s_NSSAI);
+    asn::SetOctetString(item->pDUSessionResourceSetupRequestTransfer, encodedTransfer);
+
+    auto *ieList = asn::New<ASN_NGAP_PDUSessionResourceSetupRequestIEs>();
+    ieList->id = ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceSetupListSUReq;
+    ieList->criticality = ASN_NGAP_Criticality_reject;
+    ieList->value.present = ASN_NGAP_PDUSessionResourceSetupRequestIEs__value_PR_PDUSessionResourceSetupListSUReq;
+    asn::SequenceAdd(ieList->value.choice.PDUSessionResourceSetupListSUReq, item);
+
+    sendNgapUeAssociated(ue, asn::ngap::NewMessagePdu<ASN_NGAP_PDUSessionResourceSetupRequest>({ieList}));
+}
+
+void AmfTask::sendSessionResourceReleaseCommand(UeContext &ue, int psi, const OctetString &nasPdu)
+{
+    auto *transfer = asn::New<ASN_NGAP_PDUSessionResourceReleaseCommandTransfer>();
+    ngap_utils::ToCauseAsn_Ref(NgapCause::Nas_normal_release, transfer->cause);
+    OctetString encodedTransfer =
+        ngap_encode::EncodeS(asn_DEF_ASN_NGAP_PDUSessionResourceReleaseCommandTransfer, transfer);
+    asn::Free(asn_DEF_ASN_NGAP_PDUSessionResourceReleaseCommandTransfer, transfer);
+
+    auto *item = asn::New<ASN_NGAP_PDUSessionResourceToReleaseItemRelCmd>();
+    item->pDUSessionID = psi;
+    asn::SetOctetString(item->pDUSessionResourceReleaseCommandTransfer, encodedTransfer);
+
+    auto *ieNasPdu = asn::New<ASN_NGAP_PDUSessionResourceReleaseCommandIEs>();
+    ieNasPdu->id = ASN_NGAP_ProtocolIE_ID_id_NAS_PDU;
+    ieNasPdu->criticality = ASN_NGAP_Criticality_ignore;
+    ieNasPdu->value.present = ASN_NGAP_PDUSessionResourceReleaseCommandIEs__value_PR_NAS_PDU;
+    asn::SetOctetString(ieNasPdu->value.choice.NAS_PDU, nasPdu);
+
+    auto *ieList = asn::New<ASN_NGAP_PDUSessionResourceReleaseCommandIEs>();
+    ieList->id = ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceToReleaseListRelCmd;
+    ieList->criticality = ASN_NGAP_Criticality_reject;
+    ieList->value.present = ASN_NGAP_PDUSessionResourceReleaseCommandIEs__value_PR_PDUSessionResourceToReleaseListRelCmd;
+    asn::SequenceAdd(ieList->value.choice.PDUSessionResourceToReleaseListRelCmd, item);
+
+    sendNgapUeAssociated(ue, asn::ngap::NewMessagePdu<ASN_NGAP_PDUSessionResourceReleaseCommand>({ieNasPdu, ieList}));
+}
+
+void AmfTask::sendContextReleaseCommand(UeContext &ue)
+{
+    ue.isReleasing = true;
+
+    auto *ieIds = asn::New<ASN_NGAP_UEContextReleaseCommand_IEs>();
+    ieIds->id = ASN_NGAP_ProtocolIE_ID_id_UE_NGAP_IDs;
+    ieIds->criticality = ASN_NGAP_Criticality_reject;
+    ieIds->value.present = ASN_NGAP_UEContextReleaseCommand_IEs__value_PR_UE_NGAP_IDs;
+    ieIds->value.choice.UE_NGAP_IDs.present = ASN_NGAP_UE_NGAP_IDs_PR_uE_NGAP_ID_pair;
+    ieIds->value.choice.UE_NGAP_IDs.choice.uE_NGAP_ID_pair = asn::New<ASN_NGAP_UE_NGAP_ID_pair>();
+    asn::SetSigned64(ue.amfUeNgapId, ieIds->value.choice.UE_NGAP_IDs.choice.uE_NGAP_ID_pair->aMF_UE_NGAP_ID);
+    ieIds->value.choice.UE_NGAP_IDs.choice.uE_NGAP_ID_pair->rAN_UE_NGAP_ID = ue.ranUeNgapId;
+
+    auto *ieCause = asn::New<ASN_NGAP_UEContextReleaseCommand_IEs>();
+    ieCause->id = ASN_NGAP_ProtocolIE_ID_id_Cause;
+    ieCause->criticality = ASN_NGAP_Criticality_ignore;
+    ieCause->value.present = ASN_NGAP_UEContextReleaseCommand_IEs__value_PR_Cause;
+    ngap_utils::ToCauseAsn_Ref(ue.state == EUeState::DEREGISTERING ? NgapCause::Nas_deregister
+                                                                   : NgapCause::Nas_normal_release,
+                               ieCause->value.choice.Cause);
+
+    sendNgapUeAssociated(ue, asn::ngap::NewMessagePdu<ASN_NGAP_UEContextReleaseCommand>({ieIds, ieCause}));
+}
+
+} // namespace nr::amf
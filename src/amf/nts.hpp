@@ -0,0 +1,45 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <memory>
+
+#include <lib/asn/utils.hpp>
+#include <utils/nts.hpp>
+
+#include <asn/ngap/ASN_NGAP_NGAP-PDU.h>
+
+namespace nr::amf
+{
+
+struct NmAmfNgap : NtsMessage
+{
+    enum PR
+    {
+        RECEIVE_MESSAGE,
+        ASSOCIATION_SHUTDOWN,
+    } present;
+
+    // RECEIVE_MESSAGE
+    // ASSOCIATION_SHUTDOWN
+    std::shared_ptr<GnbAssociation> association{};
+
+    // RECEIVE_MESSAGE
+    uint16_t stream{};
+    asn::Unique<ASN_NGAP_NGAP_PDU> pdu{};
+
+    explicit NmAmfNgap(PR present) : NtsMessage(NtsMessageType::AMF_NGAP), present(present)
+    {
+    }
+};
+
+} // namespace nr::amf
@@ -0,0 +1,226 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "security.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+
+#include <lib/crypt/crypt.hpp>
+#include <lib/crypt/milenage.hpp>
+
+static const int N_NAS_enc_alg = 0x01;
+static const int N_NAS_int_alg = 0x02;
+
+static const int BEARER_3GPP_ACCESS = 1;
+static const int DIRECTION_UPLINK = 0;
+static const int DIRECTION_DOWNLINK = 1;
+
+static OctetString SqnToOctetString(uint64_t sqn)
+{
+    OctetString res;
+    for (int i = 5; i >= 0; i--)
+        res.appendOctet(static_cast<uint8_t>((sqn >> (i * 8)) & 0xFF));
+    return res;
+}
+
+static uint32_t ComputeMac(nr::amf::NasSecurity &security, uint32_t count, int direction, const OctetString &message)
+{
+    if (security.integrity == nas::ETypeOfIntegrityProtectionAlgorithm::IA0)
+        return 0;
+
+    auto data = OctetString::Concat(OctetString::FromOctet(static_cast<uint8_t>(count & 0xFF)), message);
+
+    switch (security.integrity)
+    {
+    case nas::ETypeOfIntegrityProtectionAlgorithm::IA1_128:
+        return crypto::ComputeMacEia1(count, BEARER_3GPP_ACCESS, direction, data, security.kNasInt);
+    case nas::ETypeOfIntegrityProtectionAlgorithm::IA2_128:
+        return crypto::ComputeMacEia2(count, BEARER_3GPP_ACCESS, direction, data,
+                                      security.intSchedule.get(security.kNasInt));
+    case nas::ETypeOfIntegrityProtectionAlgorithm::IA3_128:
+        return crypto::ComputeMacEia3(count, BEARER_3GPP_ACCESS, direction, data, security.kNasInt);
+    default:
+        throw std::runtime_error("Bad integrity algorithm");
+    }
+}
+
+/* Ciphering and deciphering are the same keystream XOR */
+static void Cipher(nr::amf::NasSecurity &security, uint32_t count, int direction, OctetString &message)
+{
+    switch (security.ciphering)
+    {
+    case nas::ETypeOfCipheringAlgorithm::EA0:
+        break;
+    case nas::ETypeOfCipheringAlgorithm::EA1_128:
+        crypto::EncryptEea1(count, BEARER_3GPP_ACCESS, direction, message, security.kNasEnc);
+        break;
+    case nas::ETypeOfCipheringAlgorithm::EA2_128:
+        crypto::EncryptEea2(count, BEARER_3GPP_ACCESS, direction, message, security.encSchedule.get(security.kNasEnc));
+        break;
+    case nas::ETypeOfCipheringAlgorithm::EA3_128:
+        crypto::EncryptEea3(count, BEARER_3GPP_ACCESS, direction, message, security.kNasEnc);
+        break;
+    default:
+        throw std::runtime_error("Bad ciphering algorithm");
+    }
+}
+
+static bool IsCiphered(nas::ESecurityHeaderType sht)
+{
+    return sht == nas::ESecurityHeaderType::INTEGRITY_PROTECTED_AND_CIPHERED ||
+           sht == nas::ESecurityHeaderType::INTEGRITY_PROTECTED_AND_CIPHERED_WITH_NEW_SECURITY_CONTEXT;
+}
+
+namespace nr::amf::security
+{
+
+std::string ServingNetworkName(const Plmn &plmn)
+{
+    char buffer[40] = {0};
+    std::snprintf(buffer, sizeof(buffer), "5G:mnc%03d.mcc%03d.3gppnetwork.org", plmn.mnc, plmn.mcc);
+    return std::string{buffer};
+}
+
+AuthVector GenerateAuthVector(const SubscriberCredentials &credentials, const std::string &snn, uint64_t sqn,
+                              OctetString &&rand)
+{
+    OctetString sqnOctets = SqnToOctetString(sqn);
+    auto milenage = crypto::milenage::Calculate(credentials.opC, credentials.key, rand, sqnOctets, credentials.amf);
+    auto sqnXorAk = OctetString::Xor(sqnOctets, milenage.ak);
+
+    AuthVector av{};
+    av.autn = sqnXorAk.copy();
+    av.autn.append(credentials.amf);
+    av.autn.append(milenage.mac_a);
+
+    OctetString ckIk = OctetString::Concat(milenage.ck, milenage.ik);
+
+    OctetString resParams[3];
+    resParams[0] = crypto::EncodeKdfString(snn);
+    resParams[1] = rand.copy();
+    resParams[2] = milenage.res.copy();
+    auto resOutput = crypto::CalculateKdfKey(ckIk, 0x6B, resParams, 3);
+    av.xresStar = resOutput.subCopy(resOutput.length() - 16);
+
+    OctetString ausfParams[2];
+    ausfParams[0] = crypto::EncodeKdfString(snn);
+    ausfParams[1] = std::move(sqnXorAk);
+    av.kAusf = crypto::CalculateKdfKey(ckIk, 0x6A, ausfParams, 2);
+
+    av.rand = std::move(rand);
+    return av;
+}
+
+bool ResolveAuts(const SubscriberCredentials &credentials, const OctetString &rand, const OctetString &auts,
+                 uint64_t &outSqnMs)
+{
+    if (auts.length() != 14)
+        return false;
+
+    // AK* does not depend on the SQN, and MAC-S is computed with the dummy AMF of all zeros
+    auto dummyAmf = OctetString::FromSpare(2);
+    auto first = crypto::milenage::Calculate(credentials.opC, credentials.key, rand, OctetString::FromSpare(6), dummyAmf);
+    auto sqnMs = OctetString::Xor(auts.subCopy(0, 6), first.ak_r);
+
+    auto second = crypto::milenage::Calculate(credentials.opC, credentials.key, rand, sqnMs, dummyAmf);
+    if (second.mac_s != auts.subCopy(6, 8))
+        return false;
+
+    outSqnMs = 0;
+    for (int i = 0; i < 6; i++)
+        outSqnMs = (outSqnMs << 8) | sqnMs.get(i);
+    return true;
+}
+
+OctetString DeriveKamf(const OctetString &kAusf, const std::string &snn, const std::string &supi,
+                       const OctetString &abba)
+{
+    OctetString s1[1];
+    s1[0] = crypto::EncodeKdfString(snn);
+
+    OctetString s2[2];
+    s2[0] = crypto::EncodeKdfString(supi);
+    s2[1] = abba.copy();
+
+    auto kSeaf = crypto::CalculateKdfKey(kAusf, 0x6C, s1, 1);
+    return crypto::CalculateKdfKey(kSeaf, 0x6D, s2, 2);
+}
+
+void DeriveNasKeys(NasSecurity &security)
+{
+    OctetString s1[2];
+    s1[0] = OctetString::FromOctet(N_NAS_enc_alg);
+    s1[1] = OctetString::FromOctet((int)security.ciphering);
+
+    OctetString s2[2];
+    s2[0] = OctetString::FromOctet(N_NAS_int_alg);
+    s2[1] = OctetString::FromOctet((int)security.integrity);
+
+    security.kNasEnc = crypto::CalculateKdfKey(security.kAmf, 0x69, s1, 2).subCopy(16, 16);
+    security.kNasInt = crypto::CalculateKdfKey(security.kAmf, 0x69, s2, 2).subCopy(16, 16);
+}
+
+OctetString DeriveKgnb(const OctetString &kAmf, uint32_t uplinkCount)
+{
+    OctetString s[2];
+    s[0] = OctetString::FromOctet4(uplinkCount);
+    s[1] = OctetString::FromOctet(0x01); // 3GPP access
+    return crypto::CalculateKdfKey(kAmf, 0x6E, s, 2);
+}
+
+OctetString DeriveNextHop(const OctetString &kAmf, const OctetString &syncInput)
+{
+    OctetString s[1];
+    s[0] = syncInput.copy();
+    return crypto::CalculateKdfKey(kAmf, 0x6F, s, 1);
+}
+
+OctetString Protect(NasSecurity &security, const nas::PlainMmMessage &msg, nas::ESecurityHeaderType sht)
+{
+    uint32_t count = security.downlinkCount;
+
+    OctetString payload;
+    nas::EncodeNasMessage(msg, payload);
+    if (IsCiphered(sht))
+        Cipher(security, count, DIRECTION_DOWNLINK, payload);
+
+    nas::SecuredMmMessage secured{};
+    secured.epd = nas::EExtendedProtocolDiscriminator::MOBILITY_MANAGEMENT_MESSAGES;
+    secured.sht = sht;
+    secured.messageAuthenticationCode = octet4{ComputeMac(security, count, DIRECTION_DOWNLINK, payload)};
+    secured.sequenceNumber = static_cast<uint8_t>(count & 0xFF);
+    secured.plainNasMessage = std::move(payload);
+
+    security.downlinkCount = (count + 1) & 0xFFFFFF;
+
+    OctetString stream;
+    nas::EncodeNasMessage(secured, stream);
+    return stream;
+}
+
+std::unique_ptr<nas::NasMessage> Unprotect(NasSecurity &security, const nas::SecuredMmMessage &msg)
+{
+    // The overflow is incremented if the sequence number wraps around, like the UE does for the downlink
+    uint32_t overflow = security.uplinkCount >> 8;
+    if ((security.uplinkCount & 0xFF) > msg.sequenceNumber)
+        overflow = (overflow + 1) & 0xFFFF;
+    uint32_t count = (overflow << 8) | msg.sequenceNumber;
+
+    if (ComputeMac(security, count, DIRECTION_UPLINK, msg.plainNasMessage) != (uint32_t)msg.messageAuthenticationCode)
+        return nullptr;
+
+    security.uplinkCount = count;
+
+    OctetString payload = msg.plainNasMessage.copy();
+    if (IsCiphered(msg.sht))
+        Cipher(security, count, DIRECTION_UPLINK, payload);
+    return nas::DecodeNasMessage(OctetView{payload});
+}
+
+} // namespace nr::amf::security
@@ -0,0 +1,54 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "types.hpp"
+
+#include <memory>
+#include <string>
+
+#include <lib/nas/nas.hpp>
+#include <utils/common_types.hpp>
+#include <utils/octet_string.hpp>
+
+namespace nr::amf::security
+{
+
+/* 5G AKA authentication vector of the home network, generated by the stub instead of the AUSF and the UDM */
+struct AuthVector
+{
+    OctetString rand{};
+    OctetString autn{};
+    OctetString xresStar{};
+    OctetString kAusf{};
+};
+
+std::string ServingNetworkName(const Plmn &plmn);
+
+AuthVector GenerateAuthVector(const SubscriberCredentials &credentials, const std::string &snn, uint64_t sqn,
+                              OctetString &&rand);
+
+/* Recovers SQN_MS from the AUTS of a synchronisation failure, returns false if MAC-S does not match */
+bool ResolveAuts(const SubscriberCredentials &credentials, const OctetString &rand, const OctetString &auts,
+                 uint64_t &outSqnMs);
+
+OctetString DeriveKamf(const OctetString &kAusf, const std::string &snn, const std::string &supi,
+                       const OctetString &abba);
+void DeriveNasKeys(NasSecurity &security);
+OctetString DeriveKgnb(const OctetString &kAmf, uint32_t uplinkCount);
+OctetString DeriveNextHop(const OctetString &kAmf, const OctetString &syncInput);
+
+/* Integrity protects and ciphers (unless the header type says otherwise) a message with the downlink count, which is
+ * then incremented */
+OctetString Protect(NasSecurity &security, const nas::PlainMmMessage &msg, nas::ESecurityHeaderType sht);
+
+/* Checks the MAC and deciphers a message with the estimated uplink count, nullptr on MAC failure */
+std::unique_ptr<nas::NasMessage> Unprotect(NasSecurity &security, const nas::SecuredMmMessage &msg);
+
+} // namespace nr::amf::security
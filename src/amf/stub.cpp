@@ -0,0 +1,418 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "stub.hpp"
+#include "nts.hpp"
+#include "task.hpp"
+
+#include <algorithm>
+
+#include <arpa/inet.h>
+
+#include <gnb/ngap/encode.hpp>
+#include <lib/asn/ngap.hpp>
+#include <lib/asn/utils.hpp>
+
+#include <asn/ngap/ASN_NGAP_AMF-UE-NGAP-ID.h>
+#include <asn/ngap/ASN_NGAP_ProtocolIE-Field.h>
+#include <asn/ngap/ASN_NGAP_RAN-UE-NGAP-ID.h>
+
+static constexpr const size_t DEFAULT_AMF_FIELD_SIZE = 2;
+
+namespace nr::amf
+{
+
+/* Receives the NGAP PDUs of an association on its receiver thread, the PDU is null if it could not be decoded */
+class NgapHandler : public sctp::ISctpHandler
+{
+  private:
+    const std::function<void(ASN_NGAP_NGAP_PDU *, uint16_t)> m_dispatch;
+
+  public:
+    bool isNotified{}; // Whether the last receive had any callback, a receive without one means the peer is gone
+    bool isShutdown{};
+
+  public:
+    explicit NgapHandler(std::function<void(ASN_NGAP_NGAP_PDU *, uint16_t)> dispatch) : m_dispatch(std::move(dispatch))
+    {
+    }
+
+  private:
+    void onAssociationSetup(int associationId, int inStreams, int outStreams) override
+    {
+        isNotified = true;
+    }
+
+    void onAssociationShutdown() override
+    {
+        isNotified = true;
+        isShutdown = true;
+    }
+
+    void onMessage(const uint8_t *buffer, size_t length, uint16_t stream) override
+    {
+        isNotified = true;
+
+        m_dispatch(gnb::ngap_encode::Decode<ASN_NGAP_NGAP_PDU>(asn_DEF_ASN_NGAP_NGAP_PDU, buffer, length), stream);
+    }
+
+    void onUnhandledNotification() override
+    {
+        isNotified = true;
+    }
+};
+
+AmfStub::AmfStub(AmfStubConfig config, std::unique_ptr<ue::SubscriberDb> subscribers, LogBase *logBase)
+    : m_logger{logBase->makeUniqueLogger("amf")}, m_config{std::move(config)}, m_logBase{logBase}, m_server{},
+      m_subscribers{std::move(subscribers)}, m_metrics{}, m_tasks{}, m_acceptor{}, m_tunnelCallback{}, m_mutex{},
+      m_receivers{}, m_associationCounter{}, m_sequenceNumbers{}, m_tmsis{}, m_tmsiBySupi{}, m_tmsiCounter{},
+      m_freeAddresses{}, m_addressCounter{1}, m_teidCounter{1}
+{
+    m_server = std::make_unique<sctp::SctpServer>(m_config.ngapIp, m_config.ngapPort, sctp::PayloadProtocolId::NGAP);
+
+    int workers = std::max(m_config.workers, 1);
+    for (int i = 0; i < workers; i++)
+    {
+        auto task = std::make_unique<AmfTask>(this, logBase, i, workers);
+        task->setTraceName("amf/worker" + std::to_string(i));
+        m_tasks.push_back(std::move(task));
+    }
+}
+
+AmfStub::~AmfStub()
+{
+    m_acceptor.reset();
+    m_receivers.clear();
+
+    for (auto &task : m_tasks)
+        task->quit();
+}
+
+void AmfStub::start()
+{
+    for (auto &task : m_tasks)
+        task->start();
+
+    m_acceptor = std::make_unique<ScopedThread>(&AmfStub::AcceptorThread, this);
+
+    m_logger->info(FMT_STRING("NGAP is up on {}:{} with {} workers"), m_config.ngapIp, m_config.ngapPort,
+                   static_cast<int>(m_tasks.size()));
+}
+
+void AmfStub::setTunnelCallback(TunnelCallback callback)
+{
+    m_tunnelCallback = std::move(callback);
+}
+
+Json AmfStub::toJson() const
+{
+    return m_metrics.toJson();
+}
+
+std::string AmfStub::summary(int64_t periodMs)
+{
+    return m_metrics.summary(periodMs);
+}
+
+const AmfStubConfig &AmfStub::config() const
+{
+    return m_config;
+}
+
+AmfMetrics &AmfStub::metrics()
+{
+    return m_metrics;
+}
+
+bool AmfStub::findSubscriber(const std::string &supi, SubscriberCredentials &outCredentials,
+                             NetworkSlice &outNssai) const
+{
+    const ue::SubscriberRecord *record = m_subscribers ? m_subscribers->find(supi) : nullptr;
+    if (record == nullptr)
+    {
+        if (!m_config.defaultCredentials.has_value())
+            return false;
+
+        outCredentials.key = m_config.defaultCredentials->key.copy();
+        outCredentials.opC = m_config.defaultCredentials->opC.copy();
+        outCredentials.amf = m_config.defaultCredentials->amf.copy();
+        outNssai = m_config.nssai;
+        return true;
+    }
+
+    outCredentials.key = OctetString::FromArray(record->key, sizeof(record->key));
+    outCredentials.opC = OctetString::FromArray(record->opc, sizeof(record->opc));
+
+    if (record->flags & ue::SubscriberRecord::FLAG_HAS_AMF)
+        outCredentials.amf = OctetString::FromArray(record->amf, sizeof(record->amf));
+    else if (m_config.defaultCredentials.has_value())
+        outCredentials.amf = m_config.defaultCredentials->amf.copy();
+    else
+        outCredentials.amf = OctetString::FromSpare(DEFAULT_AMF_FIELD_SIZE);
+
+    if (record->flags & ue::SubscriberRecord::FLAG_HAS_NSSAI)
+    {
+        outNssai.slices.clear();
+        for (int i = 0; i < record->sliceCount; i++)
+        {
+            SingleSlice slice{};
+            slice.sst = record->sst[i];
+            if (record->sdMask & (1 << i))
+                slice.sd = octet3{record->sd[i][0], record->sd[i][1], record->sd[i][2]};
+            outNssai.slices.push_back(slice);
+        }
+    }
+    else
+    {
+        outNssai = m_config.nssai;
+    }
+    return true;
+}
+
+uint64_t AmfStub::nextSqn(const std::string &supi)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // SEQ starts from one, and IND is always zero
+    auto &seq = m_sequenceNumbers[supi];
+    if (seq == 0)
+        seq = 1;
+    return (seq++) << 5;
+}
+
+void AmfStub::resynchronize(const std::string &supi, uint64_t sqnMs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sequenceNumbers[supi] = (sqnMs >> 5) + 1;
+}
+
+octet4 AmfStub::allocateTmsi(const std::string &supi)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // The previous 5G-TMSI of the SUPI, if any, is not looked up anymore
+    uint32_t tmsi = ++m_tmsiCounter;
+    auto &latest = m_tmsiBySupi[supi];
+    if (latest != 0)
+        m_tmsis.erase(latest);
+    latest = tmsi;
+    m_tmsis[tmsi] = supi;
+    return octet4{tmsi};
+}
+
+std::optional<std::string> AmfStub::findSupiByTmsi(const octet4 &tmsi)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_tmsis.find(static_cast<uint32_t>(tmsi));
+    if (it == m_tmsis.end())
+        return std::nullopt;
+    return it->second;
+}
+
+uint32_t AmfStub::allocateUeAddress()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint32_t address;
+    if (!m_freeAddresses.empty())
+    {
+        address = m_freeAddresses.back();
+        m_freeAddresses.pop_back();
+    }
+    else
+    {
+        // The network and the broadcast addresses of the subnet are not allocated
+        uint64_t size = 1ull << (32 - m_config.uePrefixLength);
+        if (m_addressCounter + 1ull >= size)
+            return 0;
+        address = m_config.ueSubnet + m_addressCounter++;
+    }
+    return htonl(address);
+}
+
+void AmfStub::releaseUeAddress(uint32_t address)
+{
+    if (address == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_freeAddresses.push_back(ntohl(address));
+}
+
+uint32_t AmfStub::allocateTeid()
+{
+    return m_teidCounter++;
+}
+
+void AmfStub::notifyTunnel(uint32_t uplinkTeid, uint32_t downlinkTeid, const std::string &gnbAddress)
+{
+    if (m_tunnelCallback)
+        m_tunnelCallback(uplinkTeid, downlinkTeid, gnbAddress);
+}
+
+void AmfStub::sendNgap(GnbAssociation &association, uint16_t stream, ASN_NGAP_NGAP_PDU *pdu)
+{
+    char errorBuffer[1024];
+    size_t len = sizeof(errorBuffer);
+
+    if (asn_check_constraints(&asn_DEF_ASN_NGAP_NGAP_PDU, pdu, errorBuffer, &len) != 0)
+    {
+        m_logger->err(FMT_STRING("NGAP PDU ASN constraint validation failed: {}"), std::string(errorBuffer, len));
+        asn::Free(asn_DEF_ASN_NGAP_NGAP_PDU, pdu);
+        return;
+    }
+
+    ssize_t encoded;
+    uint8_t *buffer;
+    if (!gnb::ngap_encode::Encode(asn_DEF_ASN_NGAP_NGAP_PDU, pdu, encoded, buffer))
+    {
+        m_logger->err("NGAP APER encoding failed");
+        asn::Free(asn_DEF_ASN_NGAP_NGAP_PDU, pdu);
+        return;
+    }
+    asn::Free(asn_DEF_ASN_NGAP_NGAP_PDU, pdu);
+
+    {
+        // The descriptor may be reused by another association once it is closed
+        std::lock_guard<std::mutex> lock(association.sendMutex);
+        if (association.isUp)
+        {
+            try
+            {
+                m_server->send(association.sd, stream, buffer, static_cast<size_t>(encoded));
+            }
+            catch (const sctp::SctpError &e)
+            {
+                m_logger->err(FMT_STRING("NGAP message could not be sent to association[{}]: {}"), association.id,
+                              e.what());
+            }
+        }
+    }
+
+    delete[] buffer;
+}
+
+void AmfStub::AcceptorThread(void *args)
+{
+    reinterpret_cast<AmfStub *>(args)->acceptorLoop();
+}
+
+void AmfStub::ReceiverThread(void *args)
+{
+    auto *receiver = reinterpret_cast<Receiver *>(args);
+    receiver->stub->receiverLoop(*receiver);
+}
+
+void AmfStub::acceptorLoop()
+{
+    while (true)
+    {
+        int sd;
+        try
+        {
+            sd = m_server->accept();
+        }
+        catch (const sctp::SctpError &e)
+        {
+            m_logger->err(FMT_STRING("SCTP association could not be accepted: {}"), e.what());
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // The receivers of the closed associations are joined here, since a thread cannot join itself
+        m_receivers.erase(std::remove_if(m_receivers.begin(), m_receivers.end(),
+                                         [](auto &receiver) { return receiver->isFinished.load(); }),
+                          m_receivers.end());
+
+        auto receiver = std::make_unique<Receiver>();
+        receiver->stub = this;
+        receiver->association = std::make_shared<GnbAssociation>(++m_associationCounter, sd);
+        receiver->thread = std::make_unique<ScopedThread>(&AmfStub::ReceiverThread, receiver.get());
+
+        m_logger->info(FMT_STRING("SCTP association[{}] is accepted"), receiver->association->id);
+        m_receivers.push_back(std::move(receiver));
+    }
+}
+
+void AmfStub::receiverLoop(Receiver &receiver)
+{
+    auto &association = receiver.association;
+
+    NgapHandler handler{[this, &association](ASN_NGAP_NGAP_PDU *pdu, uint16_t stream) {
+        if (pdu == nullptr)
+            m_logger->err(FMT_STRING("NGAP PDU could not be decoded on association[{}]"), association->id);
+        else
+            dispatch(association, stream, pdu);
+    }};
+
+    while (!handler.isShutdown)
+    {
+        handler.isNotified = false;
+        try
+        {
+            m_server->receive(association->sd, &handler);
+        }
+        catch (const sctp::SctpError &e)
+        {
+            m_logger->err(FMT_STRING("SCTP receive failed on association[{}]: {}"), association->id, e.what());
+            break;
+        }
+        if (!handler.isNotified)
+            break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(association->sendMutex);
+        association->isUp = false;
+        m_server->close(association->sd);
+    }
+
+    // Every worker may have UEs on the association
+    for (auto &task : m_tasks)
+    {
+        auto *msg = new NmAmfNgap(NmAmfNgap::ASSOCIATION_SHUTDOWN);
+        msg->association = association;
+        task->push(msg);
+    }
+
+    m_logger->warn(FMT_STRING("SCTP association[{}] is closed"), association->id);
+    receiver.isFinished = true;
+}
+
+void AmfStub::dispatch(const std::shared_ptr<GnbAssociation> &association, uint16_t stream, ASN_NGAP_NGAP_PDU *pdu)
+{
+    int64_t key = -1;
+
+    // The AMF UE NGAP ID determines the worker of a UE, the RAN UE NGAP ID is only known for the initial messages
+    auto *ptr =
+        asn::ngap::FindProtocolIeInPdu(*pdu, asn_DEF_ASN_NGAP_AMF_UE_NGAP_ID, ASN_NGAP_ProtocolIE_ID_id_AMF_UE_NGAP_ID);
+    if (ptr == nullptr)
+        ptr = asn::ngap::FindProtocolIeInPdu(*pdu, asn_DEF_ASN_NGAP_AMF_UE_NGAP_ID,
+                                             ASN_NGAP_ProtocolIE_ID_id_SourceAMF_UE_NGAP_ID);
+    if (ptr != nullptr)
+        key = asn::GetSigned64(*reinterpret_cast<ASN_NGAP_AMF_UE_NGAP_ID_t *>(ptr));
+    else
+    {
+        ptr = asn::ngap::FindProtocolIeInPdu(*pdu, asn_DEF_ASN_NGAP_RAN_UE_NGAP_ID,
+                                             ASN_NGAP_ProtocolIE_ID_id_RAN_UE_NGAP_ID);
+        if (ptr != nullptr)
+            key = static_cast<int64_t>(*reinterpret_cast<ASN_NGAP_RAN_UE_NGAP_ID_t *>(ptr));
+    }
+
+    auto *msg = new NmAmfNgap(NmAmfNgap::RECEIVE_MESSAGE);
+    msg->association = association;
+    msg->stream = stream;
+    msg->pdu = asn::WrapUnique(pdu, asn_DEF_ASN_NGAP_NGAP_PDU);
+
+    size_t shard = key < 0 ? 0 : static_cast<size_t>(key) % m_tasks.size();
+    m_tasks[shard]->push(msg);
+}
+
+} // namespace nr::amf
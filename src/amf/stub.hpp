@@ -0,0 +1,122 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "metrics.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/sctp/sctp.hpp>
+#include <ue/subscribers/db.hpp>
+#include <utils/json.hpp>
+#include <utils/logger.hpp>
+#include <utils/scoped_thread.hpp>
+
+#include <asn/ngap/ASN_NGAP_NGAP-PDU.h>
+
+namespace nr::amf
+{
+
+class AmfTask;
+
+/* Called with the uplink TEID, the downlink TEID and the gNB address of each PDU session resource set up or switched,
+ * e.g. to program a UPF stub of the same process */
+using TunnelCallback = std::function<void(uint32_t uplinkTeid, uint32_t downlinkTeid, const std::string &gnbAddress)>;
+
+/* A stand-in for the control plane of a 5G core to benchmark the gNB and the UEs without one. Terminates NGAP over SCTP
+ * and runs a scripted NAS flow per UE: registration with 5G AKA and the NAS security mode control, PDU session
+ * establishment and release, deregistration and path switch. The authentication vectors are generated by the stub
+ * from the subscriber credentials instead of an AUSF and a UDM.
+ *
+ * Each association has a receiver thread which decodes the NGAP PDUs and hands them to the worker tasks. The UEs are
+ * sharded over the workers by their AMF UE NGAP ID, so that the context of a UE is only touched by one worker. */
+class AmfStub
+{
+  private:
+    struct Receiver
+    {
+        AmfStub *stub{};
+        std::shared_ptr<GnbAssociation> association{};
+        std::atomic<bool> isFinished{};
+        std::unique_ptr<ScopedThread> thread{};
+    };
+
+  private:
+    std::unique_ptr<Logger> m_logger;
+    AmfStubConfig m_config;
+    LogBase *m_logBase;
+    std::unique_ptr<sctp::SctpServer> m_server;
+    std::unique_ptr<ue::SubscriberDb> m_subscribers;
+    AmfMetrics m_metrics;
+    std::vector<std::unique_ptr<AmfTask>> m_tasks;
+    std::unique_ptr<ScopedThread> m_acceptor;
+    TunnelCallback m_tunnelCallback;
+
+    /* Guards the state shared by the workers below */
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Receiver>> m_receivers;
+    int m_associationCounter;
+    std::unordered_map<std::string, uint64_t> m_sequenceNumbers; // Next SQN per SUPI
+    std::unordered_map<uint32_t, std::string> m_tmsis;           // SUPI per assigned 5G-TMSI
+    std::unordered_map<std::string, uint32_t> m_tmsiBySupi;      // Latest 5G-TMSI per SUPI
+    uint32_t m_tmsiCounter;
+    std::vector<uint32_t> m_freeAddresses; // Released UE addresses in host byte order
+    uint32_t m_addressCounter;
+    std::atomic<uint32_t> m_teidCounter;
+
+  public:
+    AmfStub(AmfStubConfig config, std::unique_ptr<ue::SubscriberDb> subscribers, LogBase *logBase);
+    ~AmfStub();
+
+  public:
+    void start();
+    void setTunnelCallback(TunnelCallback callback);
+
+    /* Per procedure counters and latencies */
+    [[nodiscard]] Json toJson() const;
+    /* Rates and latencies over the period since the previous summary, for a periodic log line */
+    std::string summary(int64_t periodMs);
+
+  public:
+    /* For the worker tasks, thread safe */
+    [[nodiscard]] const AmfStubConfig &config() const;
+    AmfMetrics &metrics();
+    bool findSubscriber(const std::string &supi, SubscriberCredentials &outCredentials, NetworkSlice &outNssai) const;
+    /* SQN for a new authentication vector of the SUPI, increments the sequence number */
+    uint64_t nextSqn(const std::string &supi);
+    /* Continues the sequence of the SUPI after the SQN_MS of a synchronisation failure */
+    void resynchronize(const std::string &supi, uint64_t sqnMs);
+    octet4 allocateTmsi(const std::string &supi);
+    std::optional<std::string> findSupiByTmsi(const octet4 &tmsi);
+    /* In network byte order, zero if the pool is exhausted */
+    uint32_t allocateUeAddress();
+    void releaseUeAddress(uint32_t address);
+    uint32_t allocateTeid();
+    void notifyTunnel(uint32_t uplinkTeid, uint32_t downlinkTeid, const std::string &gnbAddress);
+    /* Encodes and sends the PDU, and frees it */
+    void sendNgap(GnbAssociation &association, uint16_t stream, ASN_NGAP_NGAP_PDU *pdu);
+
+  private:
+    static void AcceptorThread(void *args);
+    static void ReceiverThread(void *args);
+    void acceptorLoop();
+    void receiverLoop(Receiver &receiver);
+    void dispatch(const std::shared_ptr<GnbAssociation> &association, uint16_t stream, ASN_NGAP_NGAP_PDU *pdu);
+};
+
+} // namespace nr::amf
@@ -0,0 +1,125 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "task.hpp"
+#include "nts.hpp"
+#include "stub.hpp"
+
+#include <vector>
+
+namespace nr::amf
+{
+
+AmfTask::AmfTask(AmfStub *stub, LogBase *logBase, int shard, int shardCount)
+    : m_stub{stub}, m_logger{logBase->makeUniqueLogger("amf-worker" + std::to_string(shard))}, m_shard{shard},
+      m_shardCount{shardCount}, m_nextAmfUeNgapId{shard + shardCount}, m_random{std::random_device{}()}, m_ues{}
+{
+}
+
+void AmfTask::onStart()
+{
+}
+
+void AmfTask::onLoop()
+{
+    NtsMessage *msg = take();
+    if (!msg)
+        return;
+
+    switch (msg->msgType)
+    {
+    case NtsMessageType::AMF_NGAP: {
+        auto *w = dynamic_cast<NmAmfNgap *>(msg);
+        switch (w->present)
+        {
+        case NmAmfNgap::RECEIVE_MESSAGE:
+            handleNgapMessage(w->association, w->stream, *w->pdu);
+            break;
+        case NmAmfNgap::ASSOCIATION_SHUTDOWN:
+            handleAssociationShutdown(w->association);
+            break;
+        }
+        break;
+    }
+    default: {
+        m_logger->unhandledNts(msg);
+        break;
+    }
+    }
+
+    delete msg;
+}
+
+void AmfTask::onQuit()
+{
+    m_ues.clear();
+}
+
+UeContext *AmfTask::createUe(const std::shared_ptr<GnbAssociation> &association, uint16_t stream,
+                             int64_t ranUeNgapId)
+{
+    // IDs of the shard are congruent to the shard modulo the shard count
+    int64_t id = m_nextAmfUeNgapId;
+    m_nextAmfUeNgapId += m_shardCount;
+
+    auto ue = std::make_unique<UeContext>(id);
+    ue->ranUeNgapId = ranUeNgapId;
+    ue->association = association;
+    ue->stream = stream;
+
+    auto *ptr = ue.get();
+    m_ues[id] = std::move(ue);
+    m_stub->metrics().addUes(1);
+    return ptr;
+}
+
+UeContext *AmfTask::findUe(int64_t amfUeNgapId)
+{
+    auto it = m_ues.find(amfUeNgapId);
+    if (it == m_ues.end())
+        return nullptr;
+    return it->second.get();
+}
+
+void AmfTask::deleteUe(int64_t amfUeNgapId)
+{
+    auto it = m_ues.find(amfUeNgapId);
+    if (it == m_ues.end())
+        return;
+
+    int activeSessions = 0;
+    for (auto &session : it->second->sessions)
+    {
+        if (session.second.isActive)
+            activeSessions++;
+        m_stub->releaseUeAddress(session.second.ueAddress);
+    }
+
+    m_stub->metrics().addSessions(-activeSessions);
+    m_stub->metrics().addUes(-1);
+    m_ues.erase(it);
+}
+
+void AmfTask::handleAssociationShutdown(const std::shared_ptr<GnbAssociation> &association)
+{
+    std::vector<int64_t> ids;
+    for (auto &ue : m_ues)
+    {
+        if (ue.second->association == association)
+            ids.push_back(ue.first);
+    }
+
+    for (int64_t id : ids)
+        deleteUe(id);
+
+    if (!ids.empty())
+        m_logger->info(FMT_STRING("{} UE contexts of association[{}] are removed"), static_cast<int>(ids.size()),
+                       association->id);
+}
+
+} // namespace nr::amf
@@ -0,0 +1,117 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+#include <lib/nas/nas.hpp>
+#include <utils/logger.hpp>
+#include <utils/nts.hpp>
+
+extern "C"
+{
+    struct ASN_NGAP_NGAP_PDU;
+    struct ASN_NGAP_NGSetupRequest;
+    struct ASN_NGAP_InitialUEMessage;
+    struct ASN_NGAP_UplinkNASTransport;
+    struct ASN_NGAP_PDUSessionResourceSetupResponse;
+    struct ASN_NGAP_UEContextReleaseRequest;
+    struct ASN_NGAP_UEContextReleaseComplete;
+    struct ASN_NGAP_PathSwitchRequest;
+}
+
+namespace nr::amf
+{
+
+class AmfStub;
+
+/* A worker of the AMF stub, which owns the contexts of the UEs of its shard. AMF UE NGAP IDs are allocated so that the
+ * shard of a UE is its ID modulo the number of the workers. */
+class AmfTask : public NtsTask
+{
+  private:
+    AmfStub *m_stub;
+    std::unique_ptr<Logger> m_logger;
+    const int m_shard;
+    const int m_shardCount;
+    int64_t m_nextAmfUeNgapId;
+    std::mt19937_64 m_random;
+    std::unordered_map<int64_t, std::unique_ptr<UeContext>> m_ues;
+
+  public:
+    AmfTask(AmfStub *stub, LogBase *logBase, int shard, int shardCount);
+    ~AmfTask() override = default;
+
+  protected:
+    void onStart() override;
+    void onLoop() override;
+    void onQuit() override;
+
+  private: /* Context management */
+    UeContext *createUe(const std::shared_ptr<GnbAssociation> &association, uint16_t stream, int64_t ranUeNgapId);
+    UeContext *findUe(int64_t amfUeNgapId);
+    void deleteUe(int64_t amfUeNgapId);
+    void handleAssociationShutdown(const std::shared_ptr<GnbAssociation> &association);
+
+  private: /* NGAP */
+    void handleNgapMessage(const std::shared_ptr<GnbAssociation> &association, uint16_t stream,
+                           ASN_NGAP_NGAP_PDU &pdu);
+    void receiveNgSetupRequest(const std::shared_ptr<GnbAssociation> &association, ASN_NGAP_NGSetupRequest *msg);
+    void receiveInitialUeMessage(const std::shared_ptr<GnbAssociation> &association, uint16_t stream,
+                                 ASN_NGAP_InitialUEMessage *msg);
+    void receiveUplinkNasTransport(ASN_NGAP_UplinkNASTransport *msg);
+    void receiveSessionResourceSetupResponse(ASN_NGAP_PDUSessionResourceSetupResponse *msg);
+    void receiveContextReleaseRequest(ASN_NGAP_UEContextReleaseRequest *msg);
+    void receiveContextReleaseComplete(ASN_NGAP_UEContextReleaseComplete *msg);
+    void receivePathSwitchRequest(const std::shared_ptr<GnbAssociation> &association, uint16_t stream,
+                                  ASN_NGAP_PathSwitchRequest *msg);
+
+    void sendNgapUeAssociated(UeContext &ue, ASN_NGAP_NGAP_PDU *pdu);
+    void sendDownlinkNasTransport(UeContext &ue, const OctetString &nasPdu);
+    void sendInitialContextSetupRequest(UeContext &ue, const OctetString &nasPdu);
+    void sendSessionResourceSetupRequest(UeContext &ue, const PduSession &session, const OctetString &nasPdu);
+    void sendSessionResourceReleaseCommand(UeContext &ue, int psi, const OctetString &nasPdu);
+    void sendContextReleaseCommand(UeContext &ue);
+
+  private: /* NAS */
+    void receiveNas(UeContext &ue, const OctetString &nasPdu);
+    void receiveMmMessage(UeContext &ue, const nas::PlainMmMessage &msg);
+    void receiveRegistrationRequest(UeContext &ue, const nas::RegistrationRequest &msg);
+    void receiveIdentityResponse(UeContext &ue, const nas::IdentityResponse &msg);
+    void receiveAuthenticationResponse(UeContext &ue, const nas::AuthenticationResponse &msg);
+    void receiveAuthenticationFailure(UeContext &ue, const nas::AuthenticationFailure &msg);
+    void receiveSecurityModeComplete(UeContext &ue, const nas::SecurityModeComplete &msg);
+    void receiveSecurityModeReject(UeContext &ue, const nas::SecurityModeReject &msg);
+    void receiveRegistrationComplete(UeContext &ue, const nas::RegistrationComplete &msg);
+    void receiveDeregistrationRequest(UeContext &ue, const nas::DeRegistrationRequestUeOriginating &msg);
+    void receiveServiceRequest(UeContext &ue, const nas::ServiceRequest &msg);
+    void receiveUlNasTransport(UeContext &ue, const nas::UlNasTransport &msg);
+    void receiveEstablishmentRequest(UeContext &ue, const nas::PduSessionEstablishmentRequest &msg,
+                                     const nas::UlNasTransport &transport);
+    void receiveReleaseRequest(UeContext &ue, const nas::PduSessionReleaseRequest &msg);
+    void receiveReleaseComplete(UeContext &ue, const nas::PduSessionReleaseComplete &msg);
+
+    bool identifyUe(UeContext &ue, const nas::IE5gsMobileIdentity &identity);
+    void startAuthentication(UeContext &ue);
+    void startSecurityModeControl(UeContext &ue);
+    void releaseSession(UeContext &ue, int psi);
+    void rejectRegistration(UeContext &ue, nas::EMmCause cause);
+
+    /* Protected with the security context of the UE if it is active */
+    OctetString encodeNas(UeContext &ue, const nas::PlainMmMessage &msg);
+    OctetString encodeSm(UeContext &ue, int psi, const nas::SmMessage &msg);
+    void sendNas(UeContext &ue, const nas::PlainMmMessage &msg);
+};
+
+} // namespace nr::amf
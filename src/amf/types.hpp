@@ -0,0 +1,160 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <lib/crypt/aes.hpp>
+#include <lib/nas/nas.hpp>
+#include <utils/common_types.hpp>
+#include <utils/octet_string.hpp>
+
+namespace nr::amf
+{
+
+/* Credentials of a subscriber, the OPc already derived from the OP if the OP is configured */
+struct SubscriberCredentials
+{
+    OctetString key{};
+    OctetString opC{};
+    OctetString amf{};
+};
+
+struct AmfStubConfig
+{
+    std::string ngapIp{};
+    uint16_t ngapPort{};
+    std::string amfName{};
+    Plmn plmn{};
+    int amfRegionId{}; // 8-bit
+    int amfSetId{};    // 10-bit
+    int amfPointer{};  // 6-bit
+    std::vector<int> tacs{};
+    NetworkSlice nssai{};
+    int relativeCapacity = 255;
+    int workers = 1;
+
+    /* For the SUPIs which are not in the subscriber file, if any */
+    std::optional<SubscriberCredentials> defaultCredentials{};
+    nas::ETypeOfIntegrityProtectionAlgorithm integrity{};
+    nas::ETypeOfCipheringAlgorithm ciphering{};
+
+    uint32_t ueSubnet{}; // In host byte order
+    int uePrefixLength{};
+    std::string upfAddress{};
+    std::string dnn{};
+    int fiveQi = 9;
+    int sessionAmbrUplink{}; // Mbps
+    int sessionAmbrDownlink{};
+};
+
+/* An SCTP association of a gNB */
+struct GnbAssociation
+{
+    const int id;
+    const int sd;
+    std::atomic<bool> isUp{true};
+    std::mutex sendMutex{};
+
+    std::string name{}; // RAN node name of the NG Setup
+
+    GnbAssociation(int id, int sd) : id(id), sd(sd)
+    {
+    }
+};
+
+/* Counts are the 24-bit NAS COUNT, i.e. the overflow and the sequence number */
+struct NasSecurity
+{
+    bool isActive{};
+    int ngKsi{};
+    OctetString kAmf{};
+    OctetString kNasInt{};
+    OctetString kNasEnc{};
+    nas::ETypeOfIntegrityProtectionAlgorithm integrity{};
+    nas::ETypeOfCipheringAlgorithm ciphering{};
+    uint32_t uplinkCount{};
+    uint32_t downlinkCount{};
+
+    /* Expanded AES schedules of the NAS keys for NIA2 and NEA2, allocated on the first protected message */
+    crypto::AesKeyCache intSchedule{};
+    crypto::AesKeyCache encSchedule{};
+};
+
+struct PduSession
+{
+    int psi{};
+    SingleSlice slice{};
+    std::string dnn{};
+    uint32_t ueAddress{}; // In network byte order
+    uint32_t uplinkTeid{};
+
+    /* Known after the resource setup response of the gNB */
+    uint32_t downlinkTeid{};
+    std::string gnbAddress{};
+    bool isActive{};
+
+    int64_t requestTime{}; // Of the procedure in progress, if any
+};
+
+enum class EUeState
+{
+    IDENTIFICATION,
+    AUTHENTICATION,
+    SECURITY_MODE,
+    REGISTERING, // Registration accept is sent
+    REGISTERED,
+    DEREGISTERING,
+};
+
+struct UeContext
+{
+    const int64_t amfUeNgapId;
+    int64_t ranUeNgapId{};
+    std::shared_ptr<GnbAssociation> association{};
+    uint16_t stream{};
+    EUeState state{};
+    bool isReleasing{}; // UE context release command is sent
+    Tai tai{};
+
+    std::string supi{}; // IMSI digits
+    SubscriberCredentials credentials{};
+    NetworkSlice subscribedNssai{};
+    std::optional<nas::IEUeSecurityCapability> ueSecurityCapability{};
+    octet4 tmsi{};
+
+    /* Authentication in progress */
+    OctetString rand{};
+    OctetString xresStar{};
+    OctetString kAusf{};
+    int pendingNgKsi{};
+    int authAttempts{};
+
+    NasSecurity security{};
+    int nextHopChainingCount{};
+    OctetString nextHop{};
+
+    std::map<int, PduSession> sessions{};
+
+    int64_t registrationStart{};
+    int64_t deregistrationStart{};
+
+    explicit UeContext(int64_t amfUeNgapId) : amfUeNgapId(amfUeNgapId)
+    {
+    }
+};
+
+} // namespace nr::amf
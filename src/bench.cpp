@@ -0,0 +1,190 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <bench/cases.hpp>
+#include <lib/app/base_app.hpp>
+#include <lib/crypt/aes.hpp>
+#include <utils/common.hpp>
+#include <utils/constants.hpp>
+#include <utils/json.hpp>
+#include <utils/options.hpp>
+
+static constexpr const int DEFAULT_MIN_TIME = 200; // Milliseconds of the measured run of each case
+
+static struct Options
+{
+    std::vector<std::string> filters{};
+    std::string outputFile{};
+    int minTime{};
+    bool list{};
+} g_options{};
+
+static void ReadOptions(int argc, char **argv)
+{
+    opt::OptionsDescription desc{cons::Project,
+                                 cons::Tag,
+                                 "Microbenchmarks of the codecs, the security algorithms and the core data structures",
+                                 cons::Owner,
+                                 "nr-bench",
+                                 {"[option...]"},
+                                 {"nr-bench -f nas/,crypt/eea2", "nr-bench -t 1000 -o results.json"},
+                                 false,
+                                 false};
+
+    opt::OptionItem itemFilter = {'f', "filter",
+                                  "Run only the cases whose name contains one of the specified comma separated parts",
+                                  "filter"};
+    opt::OptionItem itemMinTime = {'t', "min-time",
+                                   "Measure each case for at least the specified milliseconds instead of " +
+                                       std::to_string(DEFAULT_MIN_TIME),
+                                   "ms"};
+    opt::OptionItem itemOutput = {'o', "output", "Also write the results in JSON to the specified file", "file"};
+    opt::OptionItem itemList = {'l', "list", "List the names of the cases without running them", std::nullopt};
+
+    desc.items.push_back(itemFilter);
+    desc.items.push_back(itemMinTime);
+    desc.items.push_back(itemOutput);
+    desc.items.push_back(itemList);
+
+    opt::OptionsResult opt{argc, argv, desc, false, nullptr};
+
+    if (opt.hasFlag(itemFilter))
+    {
+        std::stringstream stream{opt.getOption(itemFilter)};
+        std::string filter;
+        while (std::getline(stream, filter, ','))
+            g_options.filters.push_back(filter);
+    }
+
+    g_options.minTime = DEFAULT_MIN_TIME;
+    if (opt.hasFlag(itemMinTime))
+    {
+        g_options.minTime = utils::ParseInt(opt.getOption(itemMinTime));
+        if (g_options.minTime <= 0)
+            throw std::runtime_error("Invalid minimum time");
+    }
+
+    if (opt.hasFlag(itemOutput))
+        g_options.outputFile = opt.getOption(itemOutput);
+
+    g_options.list = opt.hasFlag(itemList);
+}
+
+static bool IsSelected(const std::string &name)
+{
+    if (g_options.filters.empty())
+        return true;
+    for (auto &filter : g_options.filters)
+        if (!filter.empty() && name.find(filter) != std::string::npos)
+            return true;
+    return false;
+}
+
+static void PrintHeader()
+{
+    std::printf("%-48s %12s %12s %10s %12s %10s\n", "case", "iterations", "ns/op", "allocs/op", "bytes/op", "MB/s");
+}
+
+static void PrintResult(const bench::Result &result)
+{
+    std::string allocations = "-";
+    std::string bytes = "-";
+    if (bench::IsAllocationCounted())
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.2f", result.allocationsPerOp);
+        allocations = buffer;
+        std::snprintf(buffer, sizeof(buffer), "%.1f", result.bytesPerOp);
+        bytes = buffer;
+    }
+
+    std::string throughput = "-";
+    if (result.megabytesPerSec > 0.0)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.1f", result.megabytesPerSec);
+        throughput = buffer;
+    }
+
+    std::printf("%-48s %12lld %12.1f %10s %12s %10s\n", result.name.c_str(),
+                static_cast<long long>(result.iterations), result.nsPerOp, allocations.c_str(), bytes.c_str(),
+                throughput.c_str());
+    std::fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    app::Initialize();
+
+    try
+    {
+        ReadOptions(argc, argv);
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    bench::Registry registry{};
+    bench::RegisterNasCases(registry);
+    bench::RegisterAsnCases(registry);
+    bench::RegisterGtpCases(registry);
+    bench::RegisterRlsCases(registry);
+    bench::RegisterCryptCases(registry);
+    bench::RegisterCoreCases(registry);
+    bench::RegisterRadioCases(registry);
+
+    if (g_options.list)
+    {
+        for (auto &benchCase : registry.cases())
+            if (IsSelected(benchCase.name))
+                std::cout << benchCase.name << std::endl;
+        return 0;
+    }
+
+    std::cerr << cons::Name << std::endl;
+    if (!bench::IsAllocationCounted())
+        std::cerr << "WARNING: Allocations are not counted, they can only be counted with glibc" << std::endl;
+
+    PrintHeader();
+
+    std::vector<Json> results{};
+    for (auto &benchCase : registry.cases())
+    {
+        if (!IsSelected(benchCase.name))
+            continue;
+
+        auto result = bench::Run(benchCase, g_options.minTime);
+        PrintResult(result);
+        results.push_back(ToJson(result));
+    }
+
+    if (!g_options.outputFile.empty())
+    {
+        std::ofstream file(g_options.outputFile);
+        file << Json::Obj({
+                    {"min-time-ms", g_options.minTime},
+                    {"allocations-counted", bench::IsAllocationCounted()},
+                    {"aes-backend", std::string{crypto::AesBackend()}},
+                    {"results", Json::Arr(std::move(results))},
+                })
+                    .dumpJson()
+             << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "alloc.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+
+#include <malloc.h>
+
+/* Zero-initialized, so that they are usable from the first allocation of a thread without any allocation themselves */
+static thread_local uint64_t t_blocks;
+static thread_local uint64_t t_bytes;
+
+#ifdef __GLIBC__
+
+static inline void Count(size_t size)
+{
+    t_blocks++;
+    t_bytes += size;
+}
+
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+
+    void *malloc(size_t size)
+    {
+        Count(size);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        Count(count * size);
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        Count(size);
+        return __libc_realloc(ptr, size);
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        Count(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        Count(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void **ptr, size_t alignment, size_t size)
+    {
+        if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        Count(size);
+        void *mem = __libc_memalign(alignment, size);
+        if (mem == nullptr)
+            return ENOMEM;
+        *ptr = mem;
+        return 0;
+    }
+}
+
+#endif
+
+namespace bench
+{
+
+bool IsAllocationCounted()
+{
+#ifdef __GLIBC__
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationCount ThreadAllocations()
+{
+    return AllocationCount{t_blocks, t_bytes};
+}
+
+} // namespace bench
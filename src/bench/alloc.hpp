@@ -0,0 +1,29 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace bench
+{
+
+struct AllocationCount
+{
+    uint64_t blocks{};
+    uint64_t bytes{};
+};
+
+/* True if the heap allocations are counted. They are counted by interposing malloc and its variants, which covers
+ * operator new as well as the C allocations of the ASN.1 codecs, but needs glibc. */
+bool IsAllocationCounted();
+
+/* Heap allocations of the calling thread since it started. A realloc counts as an allocation of the new size. */
+AllocationCount ThreadAllocations();
+
+} // namespace bench
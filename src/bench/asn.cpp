@@ -0,0 +1,264 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "cases.hpp"
+
+#include <string>
+
+#include <gnb/ngap/encode.hpp>
+#include <lib/asn/ngap.hpp>
+#include <lib/asn/rrc.hpp>
+#include <lib/asn/utils.hpp>
+#include <lib/rrc/encode.hpp>
+#include <utils/common.hpp>
+
+#include <asn/ngap/ASN_NGAP_AMF-UE-NGAP-ID.h>
+#include <asn/ngap/ASN_NGAP_DownlinkNASTransport.h>
+#include <asn/ngap/ASN_NGAP_InitialUEMessage.h>
+#include <asn/ngap/ASN_NGAP_InitiatingMessage.h>
+#include <asn/ngap/ASN_NGAP_NGAP-PDU.h>
+#include <asn/ngap/ASN_NGAP_ProtocolIE-Field.h>
+#include <asn/ngap/ASN_NGAP_RAN-UE-NGAP-ID.h>
+#include <asn/ngap/ASN_NGAP_UplinkNASTransport.h>
+#include <asn/rrc/ASN_RRC_DLInformationTransfer-IEs.h>
+#include <asn/rrc/ASN_RRC_DLInformationTransfer.h>
+#include <asn/rrc/ASN_RRC_MIB.h>
+#include <asn/rrc/ASN_RRC_PLMN-IdentityInfo.h>
+#include <asn/rrc/ASN_RRC_PLMN-IdentityInfoList.h>
+#include <asn/rrc/ASN_RRC_RRCSetupRequest-IEs.h>
+#include <asn/rrc/ASN_RRC_RRCSetupRequest.h>
+#include <asn/rrc/ASN_RRC_SIB1.h>
+#include <asn/rrc/ASN_RRC_UAC-BarringInfoSet.h>
+#include <asn/rrc/ASN_RRC_UAC-BarringPerCat.h>
+#include <asn/rrc/ASN_RRC_UAC-BarringPerCatList.h>
+
+namespace bench
+{
+
+/* Size of a typical NAS PDU carried by the RRC and NGAP messages, e.g. a protected registration request */
+static constexpr const int NAS_PDU_SIZE = 80;
+
+static ASN_RRC_BCCH_BCH_Message *MakeMib()
+{
+    auto *pdu = asn::New<ASN_RRC_BCCH_BCH_Message>();
+    pdu->message.present = ASN_RRC_BCCH_BCH_MessageType_PR_mib;
+    pdu->message.choice.mib = asn::New<ASN_RRC_MIB>();
+
+    auto &mib = *pdu->message.choice.mib;
+    asn::SetBitStringInt<6>(0, mib.systemFrameNumber);
+    mib.subCarrierSpacingCommon = ASN_RRC_MIB__subCarrierSpacingCommon_scs15or60;
+    mib.dmrs_TypeA_Position = ASN_RRC_MIB__dmrs_TypeA_Position_pos2;
+    mib.cellBarred = ASN_RRC_MIB__cellBarred_notBarred;
+    mib.intraFreqReselection = ASN_RRC_MIB__intraFreqReselection_allowed;
+    asn::SetBitStringInt<1>(0, mib.spare);
+    return pdu;
+}
+
+/* Same content as the SIB1 broadcast by the gNB */
+static ASN_RRC_BCCH_DL_SCH_Message *MakeSib1()
+{
+    auto *pdu = asn::New<ASN_RRC_BCCH_DL_SCH_Message>();
+    pdu->message.present = ASN_RRC_BCCH_DL_SCH_MessageType_PR_c1;
+    pdu->message.choice.c1 = asn::NewFor(pdu->message.choice.c1);
+    pdu->message.choice.c1->present = ASN_RRC_BCCH_DL_SCH_MessageType__c1_PR_systemInformationBlockType1;
+    pdu->message.choice.c1->choice.systemInformationBlockType1 = asn::New<ASN_RRC_SIB1>();
+
+    auto &sib1 = *pdu->message.choice.c1->choice.systemInformationBlockType1;
+
+    auto *plmnInfo = asn::New<ASN_RRC_PLMN_IdentityInfo>();
+    plmnInfo->cellReservedForOperatorUse = ASN_RRC_PLMN_IdentityInfo__cellReservedForOperatorUse_notReserved;
+    asn::MakeNew(plmnInfo->trackingAreaCode);
+    asn::SetBitStringInt<24>(1, *plmnInfo->trackingAreaCode);
+    asn::SetBitStringLong<36>(0x10, plmnInfo->cellIdentity);
+    asn::SequenceAdd(plmnInfo->plmn_IdentityList, asn::rrc::NewPlmnId(Plmn{286, 1, false}));
+    asn::SequenceAdd(sib1.cellAccessRelatedInfo.plmn_IdentityList, plmnInfo);
+
+    asn::MakeNew(sib1.uac_BarringInfo);
+
+    auto *info = asn::New<ASN_RRC_UAC_BarringInfoSet>();
+    info->uac_BarringFactor = ASN_RRC_UAC_BarringInfoSet__uac_BarringFactor_p50;
+    info->uac_BarringTime = ASN_RRC_UAC_BarringInfoSet__uac_BarringTime_s4;
+    asn::SetBitStringInt<7>(0, info->uac_BarringForAccessIdentity);
+    asn::SequenceAdd(sib1.uac_BarringInfo->uac_BarringInfoSetList, info);
+
+    asn::MakeNew(sib1.uac_BarringInfo->uac_BarringForCommon);
+    for (long i = 0; i < 63; i++)
+    {
+        auto *item = asn::New<ASN_RRC_UAC_BarringPerCat>();
+        item->accessCategory = i + 1;
+        item->uac_barringInfoSetIndex = 1;
+        asn::SequenceAdd(*sib1.uac_BarringInfo->uac_BarringForCommon, item);
+    }
+
+    return pdu;
+}
+
+static ASN_RRC_UL_CCCH_Message *MakeSetupRequest()
+{
+    auto *pdu = asn::New<ASN_RRC_UL_CCCH_Message>();
+    pdu->message.present = ASN_RRC_UL_CCCH_MessageType_PR_c1;
+    pdu->message.choice.c1 = asn::NewFor(pdu->message.choice.c1);
+    pdu->message.choice.c1->present = ASN_RRC_UL_CCCH_MessageType__c1_PR_rrcSetupRequest;
+
+    auto &r = pdu->message.choice.c1->choice.rrcSetupRequest = asn::New<ASN_RRC_RRCSetupRequest>();
+    r->rrcSetupRequest.ue_Identity.present = ASN_RRC_InitialUE_Identity_PR_randomValue;
+    asn::SetBitStringLong<39>(0x123456789, r->rrcSetupRequest.ue_Identity.choice.randomValue);
+    r->rrcSetupRequest.establishmentCause = ASN_RRC_EstablishmentCause_mo_Signalling;
+    asn::SetSpareBits<1>(r->rrcSetupRequest.spare);
+    return pdu;
+}
+
+static ASN_RRC_DL_DCCH_Message *MakeDlInformationTransfer()
+{
+    auto *pdu = asn::New<ASN_RRC_DL_DCCH_Message>();
+    pdu->message.present = ASN_RRC_DL_DCCH_MessageType_PR_c1;
+    pdu->message.choice.c1 =
+        asn::New<ASN_RRC_DL_DCCH_MessageType_t::ASN_RRC_DL_DCCH_MessageType_u::ASN_RRC_DL_DCCH_MessageType__c1>();
+    pdu->message.choice.c1->present = ASN_RRC_DL_DCCH_MessageType__c1_PR_dlInformationTransfer;
+    pdu->message.choice.c1->choice.dlInformationTransfer = asn::New<ASN_RRC_DLInformationTransfer>();
+
+    auto &c1 = pdu->message.choice.c1->choice.dlInformationTransfer->criticalExtensions;
+    c1.present = ASN_RRC_DLInformationTransfer__criticalExtensions_PR_dlInformationTransfer;
+    c1.choice.dlInformationTransfer = asn::New<ASN_RRC_DLInformationTransfer_IEs>();
+    c1.choice.dlInformationTransfer->dedicatedNAS_Message = asn::New<ASN_RRC_DedicatedNAS_Message_t>();
+    asn::SetOctetString(*c1.choice.dlInformationTransfer->dedicatedNAS_Message, OctetString::FromSpare(NAS_PDU_SIZE));
+    return pdu;
+}
+
+/* Adds the UE NGAP IDs the way the gNB and the AMF do before sending a UE associated message */
+static ASN_NGAP_NGAP_PDU *AddUeNgapIds(ASN_NGAP_NGAP_PDU *pdu)
+{
+    asn::ngap::AddProtocolIeIfUsable(*pdu, asn_DEF_ASN_NGAP_AMF_UE_NGAP_ID, ASN_NGAP_ProtocolIE_ID_id_AMF_UE_NGAP_ID,
+                                     ASN_NGAP_Criticality_reject, [](void *mem) {
+                                         auto &id = *reinterpret_cast<ASN_NGAP_AMF_UE_NGAP_ID_t *>(mem);
+                                         asn::SetSigned64(0x12345678, id);
+                                     });
+    asn::ngap::AddProtocolIeIfUsable(*pdu, asn_DEF_ASN_NGAP_RAN_UE_NGAP_ID, ASN_NGAP_ProtocolIE_ID_id_RAN_UE_NGAP_ID,
+                                     ASN_NGAP_Criticality_reject,
+                                     [](void *mem) { *reinterpret_cast<ASN_NGAP_RAN_UE_NGAP_ID_t *>(mem) = 1234; });
+    return pdu;
+}
+
+static ASN_NGAP_NGAP_PDU *MakeInitialUeMessage()
+{
+    auto *ieEstablishmentCause = asn::New<ASN_NGAP_InitialUEMessage_IEs>();
+    ieEstablishmentCause->id = ASN_NGAP_ProtocolIE_ID_id_RRCEstablishmentCause;
+    ieEstablishmentCause->criticality = ASN_NGAP_Criticality_ignore;
+    ieEstablishmentCause->value.present = ASN_NGAP_InitialUEMessage_IEs__value_PR_RRCEstablishmentCause;
+    ieEstablishmentCause->value.choice.RRCEstablishmentCause = ASN_NGAP_RRCEstablishmentCause_mo_Signalling;
+
+    auto *ieCtxRequest = asn::New<ASN_NGAP_InitialUEMessage_IEs>();
+    ieCtxRequest->id = ASN_NGAP_ProtocolIE_ID_id_UEContextRequest;
+    ieCtxRequest->criticality = ASN_NGAP_Criticality_ignore;
+    ieCtxRequest->value.present = ASN_NGAP_InitialUEMessage_IEs__value_PR_UEContextRequest;
+    ieCtxRequest->value.choice.UEContextRequest = ASN_NGAP_UEContextRequest_requested;
+
+    auto *ieNasPdu = asn::New<ASN_NGAP_InitialUEMessage_IEs>();
+    ieNasPdu->id = ASN_NGAP_ProtocolIE_ID_id_NAS_PDU;
+    ieNasPdu->criticality = ASN_NGAP_Criticality_reject;
+    ieNasPdu->value.present = ASN_NGAP_InitialUEMessage_IEs__value_PR_NAS_PDU;
+    asn::SetOctetString(ieNasPdu->value.choice.NAS_PDU, OctetString::FromSpare(NAS_PDU_SIZE));
+
+    return AddUeNgapIds(
+        asn::ngap::NewMessagePdu<ASN_NGAP_InitialUEMessage>({ieEstablishmentCause, ieCtxRequest, ieNasPdu}));
+}
+
+static ASN_NGAP_NGAP_PDU *MakeUplinkNasTransport()
+{
+    auto *ieNasPdu = asn::New<ASN_NGAP_UplinkNASTransport_IEs>();
+    ieNasPdu->id = ASN_NGAP_ProtocolIE_ID_id_NAS_PDU;
+    ieNasPdu->criticality = ASN_NGAP_Criticality_reject;
+    ieNasPdu->value.present = ASN_NGAP_UplinkNASTransport_IEs__value_PR_NAS_PDU;
+    asn::SetOctetString(ieNasPdu->value.choice.NAS_PDU, OctetString::FromSpare(NAS_PDU_SIZE));
+
+    return AddUeNgapIds(asn::ngap::NewMessagePdu<ASN_NGAP_UplinkNASTransport>({ieNasPdu}));
+}
+
+static ASN_NGAP_NGAP_PDU *MakeDownlinkNasTransport()
+{
+    auto *ieNasPdu = asn::New<ASN_NGAP_DownlinkNASTransport_IEs>();
+    ieNasPdu->id = ASN_NGAP_ProtocolIE_ID_id_NAS_PDU;
+    ieNasPdu->criticality = ASN_NGAP_Criticality_reject;
+    ieNasPdu->value.present = ASN_NGAP_DownlinkNASTransport_IEs__value_PR_NAS_PDU;
+    asn::SetOctetString(ieNasPdu->value.choice.NAS_PDU, OctetString::FromSpare(NAS_PDU_SIZE));
+
+    return AddUeNgapIds(asn::ngap::NewMessagePdu<ASN_NGAP_DownlinkNASTransport>({ieNasPdu}));
+}
+
+/* RRC messages are UPER encoded */
+template <typename T>
+static void AddRrcCases(Registry &registry, const std::string &name, asn_TYPE_descriptor_t *desc, T *(*make)())
+{
+    registry.add("rrc/encode/" + name, [desc, make](State &state) {
+        auto *pdu = make();
+        while (state.keepRunning())
+        {
+            auto encoded = rrc::encode::EncodeS(*desc, pdu);
+            DoNotOptimize(encoded);
+        }
+        asn::Free(*desc, pdu);
+    });
+
+    registry.add("rrc/decode/" + name, [desc, make](State &state) {
+        auto *pdu = make();
+        auto encoded = rrc::encode::EncodeS(*desc, pdu);
+        asn::Free(*desc, pdu);
+
+        state.setProcessedBytes(encoded.length());
+        while (state.keepRunning())
+        {
+            auto *decoded = rrc::encode::Decode<T>(*desc, encoded);
+            DoNotOptimize(decoded);
+            asn::Free(*desc, decoded);
+        }
+    });
+}
+
+/* NGAP messages are APER encoded */
+static void AddNgapCases(Registry &registry, const std::string &name, ASN_NGAP_NGAP_PDU *(*make)())
+{
+    registry.add("ngap/encode/" + name, [make](State &state) {
+        auto *pdu = make();
+        while (state.keepRunning())
+        {
+            auto encoded = nr::gnb::ngap_encode::EncodeS(asn_DEF_ASN_NGAP_NGAP_PDU, pdu);
+            DoNotOptimize(encoded);
+        }
+        asn::Free(asn_DEF_ASN_NGAP_NGAP_PDU, pdu);
+    });
+
+    registry.add("ngap/decode/" + name, [make](State &state) {
+        auto *pdu = make();
+        auto encoded = nr::gnb::ngap_encode::EncodeS(asn_DEF_ASN_NGAP_NGAP_PDU, pdu);
+        asn::Free(asn_DEF_ASN_NGAP_NGAP_PDU, pdu);
+
+        state.setProcessedBytes(encoded.length());
+        while (state.keepRunning())
+        {
+            auto *decoded =
+                nr::gnb::ngap_encode::Decode<ASN_NGAP_NGAP_PDU>(asn_DEF_ASN_NGAP_NGAP_PDU, encoded.data(),
+                                                                static_cast<size_t>(encoded.length()));
+            DoNotOptimize(decoded);
+            asn::Free(asn_DEF_ASN_NGAP_NGAP_PDU, decoded);
+        }
+    });
+}
+
+void RegisterAsnCases(Registry &registry)
+{
+    AddRrcCases(registry, "mib", &asn_DEF_ASN_RRC_BCCH_BCH_Message, MakeMib);
+    AddRrcCases(registry, "sib1", &asn_DEF_ASN_RRC_BCCH_DL_SCH_Message, MakeSib1);
+    AddRrcCases(registry, "rrc-setup-request", &asn_DEF_ASN_RRC_UL_CCCH_Message, MakeSetupRequest);
+    AddRrcCases(registry, "dl-information-transfer", &asn_DEF_ASN_RRC_DL_DCCH_Message, MakeDlInformationTransfer);
+
+    AddNgapCases(registry, "initial-ue-message", MakeInitialUeMessage);
+    AddNgapCases(registry, "uplink-nas-transport", MakeUplinkNasTransport);
+    AddNgapCases(registry, "downlink-nas-transport", MakeDownlinkNasTransport);
+}
+
+} // namespace bench
@@ -0,0 +1,24 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "harness.hpp"
+
+namespace bench
+{
+
+void RegisterNasCases(Registry &registry);
+void RegisterAsnCases(Registry &registry);
+void RegisterGtpCases(Registry &registry);
+void RegisterRlsCases(Registry &registry);
+void RegisterCryptCases(Registry &registry);
+void RegisterCoreCases(Registry &registry);
+void RegisterRadioCases(Registry &registry);
+
+} // namespace bench
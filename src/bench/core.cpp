@@ -0,0 +1,173 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "cases.hpp"
+
+#include <memory>
+
+#include <utils/common.hpp>
+#include <utils/nts.hpp>
+#include <utils/octet_string.hpp>
+#include <utils/octet_view.hpp>
+
+namespace bench
+{
+
+static constexpr const int PACKET_SIZE = 1500;
+static constexpr const int PENDING_TIMERS = 64;
+
+/* A task which is never started, its queue is used directly by the thread of the benchmark */
+class QueueTask : public NtsTask
+{
+  public:
+    NtsMessage *pollMessage()
+    {
+        return poll();
+    }
+
+  protected:
+    void onStart() override
+    {
+    }
+
+    void onLoop() override
+    {
+    }
+
+    void onQuit() override
+    {
+    }
+};
+
+void RegisterCoreCases(Registry &registry)
+{
+    // Building a header of mixed size fields, like the encoders do
+    registry.add("octet-string/append", [](State &state) {
+        while (state.keepRunning())
+        {
+            OctetString stream;
+            for (int i = 0; i < 4; i++)
+            {
+                stream.appendOctet(i);
+                stream.appendOctet2(i);
+                stream.appendOctet4(i);
+                stream.appendOctet8(static_cast<uint64_t>(i));
+            }
+            DoNotOptimize(stream);
+        }
+    });
+
+    registry.add("octet-string/copy-1500", [](State &state) {
+        auto packet = OctetString::FromSpare(PACKET_SIZE);
+        state.setProcessedBytes(PACKET_SIZE);
+        while (state.keepRunning())
+        {
+            auto copy = packet.copy();
+            DoNotOptimize(copy);
+        }
+    });
+
+    registry.add("octet-string/sub-copy-1500", [](State &state) {
+        auto packet = OctetString::FromSpare(PACKET_SIZE);
+        state.setProcessedBytes(PACKET_SIZE - 20);
+        while (state.keepRunning())
+        {
+            auto copy = packet.subCopy(20);
+            DoNotOptimize(copy);
+        }
+    });
+
+    registry.add("octet-string/to-hex-64", [](State &state) {
+        auto stream = OctetString::FromSpare(64);
+        state.setProcessedBytes(64);
+        while (state.keepRunning())
+        {
+            auto hex = stream.toHexString();
+            DoNotOptimize(hex);
+        }
+    });
+
+    // Parsing the same header, like the decoders do
+    registry.add("octet-view/read", [](State &state) {
+        OctetString stream;
+        for (int i = 0; i < 4; i++)
+        {
+            stream.appendOctet(i);
+            stream.appendOctet2(i);
+            stream.appendOctet4(i);
+            stream.appendOctet8(static_cast<uint64_t>(i));
+        }
+
+        while (state.keepRunning())
+        {
+            OctetView view{stream};
+            uint64_t sum = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                sum += view.readI();
+                sum += view.read2I();
+                sum += view.read4UI();
+                sum += view.read8UL();
+            }
+            DoNotOptimize(sum);
+        }
+    });
+
+    registry.add("octet-view/read-octet-string-1500", [](State &state) {
+        auto packet = OctetString::FromSpare(PACKET_SIZE);
+        state.setProcessedBytes(PACKET_SIZE);
+        while (state.keepRunning())
+        {
+            OctetView view{packet};
+            auto pdu = view.readOctetString(PACKET_SIZE);
+            DoNotOptimize(pdu);
+        }
+    });
+
+    // A message through the queue of a task, including its allocation and deletion
+    registry.add("nts/push-poll", [](State &state) {
+        auto task = std::make_unique<QueueTask>();
+        while (state.keepRunning())
+        {
+            task->push(new NmTimerExpired(1));
+            auto *msg = task->pollMessage();
+            DoNotOptimize(msg);
+            delete msg;
+        }
+    });
+
+    // The check of a task for a message or an expired timer when there is none
+    registry.add("nts/poll-empty", [](State &state) {
+        auto task = std::make_unique<QueueTask>();
+        task->setTimer(1, 1'000'000);
+        while (state.keepRunning())
+        {
+            auto *msg = task->pollMessage();
+            DoNotOptimize(msg);
+        }
+    });
+
+    // A timer which expires at once, set while other timers of the task are pending
+    registry.add("timer/set-expire", [](State &state) {
+        TimerBase timers{};
+        int64_t future = utils::CurrentTimeMillis() + 1'000'000;
+        for (int i = 0; i < PENDING_TIMERS; i++)
+            timers.setTimerAbsolute(i, future + i);
+
+        int64_t past = utils::CurrentTimeMillis() - 1;
+        while (state.keepRunning())
+        {
+            timers.setTimerAbsolute(PENDING_TIMERS, past);
+            auto *timer = timers.getAndRemoveExpiredTimer();
+            DoNotOptimize(timer);
+            delete timer;
+        }
+    });
+}
+
+} // namespace bench
@@ -0,0 +1,142 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "cases.hpp"
+
+#include <string>
+
+#include <lib/crypt/crypt.hpp>
+#include <lib/crypt/milenage.hpp>
+
+namespace bench
+{
+
+/* A NAS message and a full size user plane packet */
+static const int MESSAGE_SIZES[] = {64, 1500};
+
+using CipherFunction = void (*)(uint32_t, int, int, OctetString &, const OctetString &);
+using MacFunction = uint32_t (*)(uint32_t, int, int, const OctetString &, const OctetString &);
+
+static const struct
+{
+    const char *name;
+    CipherFunction function;
+} CIPHERS[] = {
+    {"eea1", crypto::EncryptEea1},
+    {"eea2", crypto::EncryptEea2},
+    {"eea3", crypto::EncryptEea3},
+};
+
+static const struct
+{
+    const char *name;
+    MacFunction function;
+} MACS[] = {
+    {"eia1", crypto::ComputeMacEia1},
+    {"eia2", crypto::ComputeMacEia2},
+    {"eia3", crypto::ComputeMacEia3},
+};
+
+static OctetString Key()
+{
+    return OctetString::FromHex("2BD6459F82C5B300952C49104881FF48");
+}
+
+void RegisterCryptCases(Registry &registry)
+{
+    for (auto &cipher : CIPHERS)
+    {
+        for (int size : MESSAGE_SIZES)
+        {
+            auto function = cipher.function;
+            registry.add(std::string{"crypt/"} + cipher.name + "/" + std::to_string(size), [function, size](State &state) {
+                auto key = Key();
+                auto message = OctetString::FromSpare(size);
+                uint32_t count = 0;
+
+                state.setProcessedBytes(size);
+                while (state.keepRunning())
+                {
+                    function(count++, 1, 0, message, key);
+                    DoNotOptimize(message);
+                }
+            });
+        }
+    }
+
+    for (auto &mac : MACS)
+    {
+        for (int size : MESSAGE_SIZES)
+        {
+            auto function = mac.function;
+            registry.add(std::string{"crypt/"} + mac.name + "/" + std::to_string(size), [function, size](State &state) {
+                auto key = Key();
+                auto message = OctetString::FromSpare(size);
+                uint32_t count = 0;
+
+                state.setProcessedBytes(size);
+                while (state.keepRunning())
+                {
+                    uint32_t result = function(count++, 1, 0, message, key);
+                    DoNotOptimize(result);
+                }
+            });
+        }
+    }
+
+    registry.add("crypt/milenage/calculate", [](State &state) {
+        auto key = Key();
+        auto opc = crypto::milenage::CalculateOpC(OctetString::FromHex("E8ED289DEBA952E4283B54E88E6183CA"), key);
+        auto rand = OctetString::FromHex("23553CBE9637A89D218AE64DAE47BF35");
+        auto sqn = OctetString::FromHex("FF9BB4D0B607");
+        auto amf = OctetString::FromHex("8000");
+
+        while (state.keepRunning())
+        {
+            auto result = crypto::milenage::Calculate(opc, key, rand, sqn, amf);
+            DoNotOptimize(result);
+        }
+    });
+
+    registry.add("crypt/milenage/opc", [](State &state) {
+        auto key = Key();
+        auto op = OctetString::FromHex("E8ED289DEBA952E4283B54E88E6183CA");
+
+        while (state.keepRunning())
+        {
+            auto opc = crypto::milenage::CalculateOpC(op, key);
+            DoNotOptimize(opc);
+        }
+    });
+
+    // Derivation of a 256-bit key with two parameters, as for K_AMF and the NAS keys
+    registry.add("crypt/kdf/key", [](State &state) {
+        auto key = OctetString::FromSpare(32);
+        OctetString params[2] = {OctetString::FromHex("01"), OctetString::FromHex("02")};
+
+        while (state.keepRunning())
+        {
+            auto derived = crypto::CalculateKdfKey(key, 0x69, params, 2);
+            DoNotOptimize(derived);
+        }
+    });
+
+    registry.add("crypt/hmac-sha256/64", [](State &state) {
+        auto key = OctetString::FromSpare(32);
+        auto input = OctetString::FromSpare(64);
+
+        state.setProcessedBytes(input.length());
+        while (state.keepRunning())
+        {
+            auto mac = crypto::HmacSha256(key, input);
+            DoNotOptimize(mac);
+        }
+    });
+}
+
+} // namespace bench
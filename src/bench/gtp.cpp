@@ -0,0 +1,74 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "cases.hpp"
+
+#include <memory>
+#include <string>
+
+#include <gnb/gtp/proto.hpp>
+
+namespace bench
+{
+
+static const int PAYLOAD_SIZES[] = {64, 1400};
+
+/* A G-PDU with a PDU session container, as the gNB sends in the uplink and the UPF in the downlink */
+static gtp::GtpMessage MakeGpdu(int payloadSize, bool isUplink)
+{
+    gtp::GtpMessage gtp{};
+    gtp.payload = OctetString::FromSpare(payloadSize);
+    gtp.msgType = gtp::GtpMessage::MT_G_PDU;
+    gtp.teid = 0x12345678;
+
+    auto cont = std::make_unique<gtp::PduSessionContainerExtHeader>();
+    if (isUplink)
+    {
+        auto ul = std::make_unique<gtp::UlPduSessionInformation>();
+        ul->qfi = 1;
+        cont->pduSessionInformation = std::move(ul);
+    }
+    else
+    {
+        auto dl = std::make_unique<gtp::DlPduSessionInformation>();
+        dl->qfi = 1;
+        cont->pduSessionInformation = std::move(dl);
+    }
+    gtp.extHeaders.push_back(std::move(cont));
+    return gtp;
+}
+
+void RegisterGtpCases(Registry &registry)
+{
+    for (int size : PAYLOAD_SIZES)
+    {
+        registry.add("gtp/encode/g-pdu-ul-" + std::to_string(size), [size](State &state) {
+            auto gtp = MakeGpdu(size, true);
+            state.setProcessedBytes(size);
+            while (state.keepRunning())
+            {
+                OctetString stream;
+                gtp::EncodeGtpMessage(gtp, stream);
+                DoNotOptimize(stream);
+            }
+        });
+
+        registry.add("gtp/decode/g-pdu-dl-" + std::to_string(size), [size](State &state) {
+            OctetString stream;
+            gtp::EncodeGtpMessage(MakeGpdu(size, false), stream);
+            state.setProcessedBytes(size);
+            while (state.keepRunning())
+            {
+                std::unique_ptr<gtp::GtpMessage> gtp{gtp::DecodeGtpMessage(OctetView{stream})};
+                DoNotOptimize(gtp);
+            }
+        });
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,132 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "harness.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+static constexpr const int64_t MAX_ITERATIONS = 1'000'000'000;
+
+static int64_t CurrentTimeNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+namespace bench
+{
+
+State::State(int64_t iterations) : m_iterations(iterations), m_remaining(iterations)
+{
+}
+
+void State::start()
+{
+    m_startAllocations = ThreadAllocations();
+    m_startTime = CurrentTimeNs();
+}
+
+void State::stop()
+{
+    m_elapsed = CurrentTimeNs() - m_startTime;
+
+    auto allocations = ThreadAllocations();
+    m_allocations.blocks = allocations.blocks - m_startAllocations.blocks;
+    m_allocations.bytes = allocations.bytes - m_startAllocations.bytes;
+}
+
+void State::setProcessedBytes(int64_t bytesPerOp)
+{
+    m_processedBytes = bytesPerOp;
+}
+
+int64_t State::iterations() const
+{
+    return m_iterations;
+}
+
+int64_t State::elapsedNs() const
+{
+    return m_elapsed;
+}
+
+AllocationCount State::allocations() const
+{
+    return m_allocations;
+}
+
+int64_t State::processedBytes() const
+{
+    return m_processedBytes;
+}
+
+void Registry::add(std::string name, CaseFunction function)
+{
+    m_cases.push_back(Case{std::move(name), std::move(function)});
+}
+
+const std::vector<Case> &Registry::cases() const
+{
+    return m_cases;
+}
+
+Result Run(const Case &benchCase, int64_t minTimeMs)
+{
+    int64_t minTime = minTimeMs * 1'000'000;
+
+    // Warms up the caches and the lazily initialized state of the code under test
+    {
+        State state{1};
+        benchCase.function(state);
+    }
+
+    int64_t iterations = 1;
+    while (true)
+    {
+        State state{iterations};
+        benchCase.function(state);
+
+        if (state.elapsedNs() >= minTime || iterations >= MAX_ITERATIONS)
+        {
+            auto n = static_cast<double>(iterations);
+            auto elapsed = static_cast<double>(std::max<int64_t>(state.elapsedNs(), 1));
+
+            Result result{};
+            result.name = benchCase.name;
+            result.iterations = iterations;
+            result.nsPerOp = elapsed / n;
+            result.allocationsPerOp = static_cast<double>(state.allocations().blocks) / n;
+            result.bytesPerOp = static_cast<double>(state.allocations().bytes) / n;
+            result.megabytesPerSec = static_cast<double>(state.processedBytes()) * n * 1e3 / elapsed;
+            return result;
+        }
+
+        // Aims at 1.4 times the minimum time from the rate so far, growing by at most 10 times per run like
+        // google-benchmark does
+        double multiplier = state.elapsedNs() * 10 <= minTime
+                                ? 10.0
+                                : static_cast<double>(minTime) * 1.4 / static_cast<double>(state.elapsedNs());
+        iterations = std::min(MAX_ITERATIONS,
+                              std::max(iterations + 1, static_cast<int64_t>(static_cast<double>(iterations) * multiplier)));
+    }
+}
+
+Json ToJson(const Result &result)
+{
+    return Json::Obj({
+        {"name", result.name},
+        {"iterations", result.iterations},
+        {"ns-per-op", result.nsPerOp},
+        {"allocs-per-op", result.allocationsPerOp},
+        {"bytes-per-op", result.bytesPerOp},
+        {"mb-per-sec", result.megabytesPerSec},
+    });
+}
+
+} // namespace bench
@@ -0,0 +1,113 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "alloc.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <utils/json.hpp>
+
+namespace bench
+{
+
+/* Passed to the body of a case, which performs the measured operation once for each keepRunning() call that returns
+ * true:
+ *
+ *     // Setup, not measured
+ *     while (state.keepRunning())
+ *         // Operation
+ *
+ * The time and the allocations are measured from the first call to the last one. */
+class State
+{
+  private:
+    const int64_t m_iterations;
+    int64_t m_remaining;
+    int64_t m_startTime{};
+    int64_t m_elapsed{};
+    AllocationCount m_startAllocations{};
+    AllocationCount m_allocations{};
+    int64_t m_processedBytes{};
+
+  public:
+    explicit State(int64_t iterations);
+
+  public:
+    inline bool keepRunning()
+    {
+        if (m_remaining == m_iterations)
+            start();
+        if (m_remaining == 0)
+        {
+            stop();
+            return false;
+        }
+        m_remaining--;
+        return true;
+    }
+
+    /* Octets processed by each operation, reported as throughput */
+    void setProcessedBytes(int64_t bytesPerOp);
+
+    [[nodiscard]] int64_t iterations() const;
+    [[nodiscard]] int64_t elapsedNs() const;
+    [[nodiscard]] AllocationCount allocations() const;
+    [[nodiscard]] int64_t processedBytes() const;
+
+  private:
+    void start();
+    void stop();
+};
+
+using CaseFunction = std::function<void(State &)>;
+
+struct Case
+{
+    std::string name{}; // As 'component/operation/variant'
+    CaseFunction function{};
+};
+
+class Registry
+{
+  private:
+    std::vector<Case> m_cases{};
+
+  public:
+    void add(std::string name, CaseFunction function);
+
+    [[nodiscard]] const std::vector<Case> &cases() const;
+};
+
+struct Result
+{
+    std::string name{};
+    int64_t iterations{};
+    double nsPerOp{};
+    double allocationsPerOp{};
+    double bytesPerOp{};     // Allocated on the heap
+    double megabytesPerSec{}; // Processed, 0 if the case does not tell
+};
+
+/* Runs the case with increasing iteration counts until a run takes at least the given time, and reports that run */
+Result Run(const Case &benchCase, int64_t minTimeMs);
+
+/* Keeps the compiler from optimizing away the computation of the value */
+template <typename T>
+inline void DoNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+Json ToJson(const Result &result);
+
+} // namespace bench
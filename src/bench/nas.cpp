@@ -0,0 +1,240 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "cases.hpp"
+
+#include <memory>
+#include <string>
+
+#include <lib/nas/nas.hpp>
+#include <lib/nas/utils.hpp>
+#include <ue/nas/enc.hpp>
+
+namespace bench
+{
+
+static const Plmn PLMN = {286, 1, false};
+
+static nas::IEUeSecurityCapability MakeSecurityCapability()
+{
+    auto supported = ~0;
+
+    nas::IEUeSecurityCapability cap{};
+    cap.b_5G_EA0 = supported;
+    cap.b_5G_IA0 = supported;
+    cap.b_128_5G_EA1 = supported;
+    cap.b_128_5G_IA1 = supported;
+    cap.b_128_5G_EA2 = supported;
+    cap.b_128_5G_IA2 = supported;
+    cap.b_128_5G_EA3 = supported;
+    cap.b_128_5G_IA3 = supported;
+    return cap;
+}
+
+static NetworkSlice MakeSlices()
+{
+    NetworkSlice nssai{};
+    nssai.addIfNotExists(SingleSlice{1, std::nullopt});
+    nssai.addIfNotExists(SingleSlice{1, octet3{0x010203}});
+    return nssai;
+}
+
+static std::unique_ptr<nas::NasMessage> MakeRegistrationRequest()
+{
+    auto msg = std::make_unique<nas::RegistrationRequest>();
+    msg->registrationType =
+        nas::IE5gsRegistrationType{nas::EFollowOnRequest::FOR_PENDING, nas::ERegistrationType::INITIAL_REGISTRATION};
+    msg->mobileIdentity.type = nas::EIdentityType::SUCI;
+    msg->mobileIdentity.supiFormat = nas::ESupiFormat::IMSI;
+    msg->mobileIdentity.imsi.plmn.mcc = PLMN.mcc;
+    msg->mobileIdentity.imsi.plmn.mnc = PLMN.mnc;
+    msg->mobileIdentity.imsi.plmn.isLongMnc = PLMN.isLongMnc;
+    msg->mobileIdentity.imsi.routingIndicator = "0000";
+    msg->mobileIdentity.imsi.schemeOutput = "0000000001";
+    msg->mmCapability = nas::IE5gMmCapability{};
+    msg->mmCapability->s1Mode = nas::EEpcNasSupported::NOT_SUPPORTED;
+    msg->mmCapability->hoAttach = nas::EHandoverAttachSupported::NOT_SUPPORTED;
+    msg->mmCapability->lpp = nas::ELtePositioningProtocolCapability::NOT_SUPPORTED;
+    msg->requestedNSSAI = nas::utils::NssaiFrom(MakeSlices());
+    msg->ueSecurityCapability = MakeSecurityCapability();
+    msg->updateType =
+        nas::IE5gsUpdateType(nas::ESmsRequested::NOT_SUPPORTED, nas::ENgRanRadioCapabilityUpdate::NOT_NEEDED);
+    return msg;
+}
+
+static std::unique_ptr<nas::NasMessage> MakeAuthenticationRequest()
+{
+    auto msg = std::make_unique<nas::AuthenticationRequest>();
+    msg->ngKSI = nas::IENasKeySetIdentifier{nas::ETypeOfSecurityContext::NATIVE_SECURITY_CONTEXT, 1};
+    msg->abba = nas::IEAbba{OctetString::FromSpare(2)};
+    msg->authParamRAND = nas::IEAuthenticationParameterRand{OctetString::FromHex("0123456789ABCDEF0123456789ABCDEF")};
+    msg->authParamAUTN = nas::IEAuthenticationParameterAutn{OctetString::FromHex("FEDCBA9876543210FEDCBA9876543210")};
+    return msg;
+}
+
+static std::unique_ptr<nas::NasMessage> MakeSecurityModeCommand()
+{
+    auto msg = std::make_unique<nas::SecurityModeCommand>();
+    msg->selectedNasSecurityAlgorithms = nas::IENasSecurityAlgorithms{
+        nas::ETypeOfIntegrityProtectionAlgorithm::IA2_128, nas::ETypeOfCipheringAlgorithm::EA2_128};
+    msg->ngKsi = nas::IENasKeySetIdentifier{nas::ETypeOfSecurityContext::NATIVE_SECURITY_CONTEXT, 1};
+    msg->replayedUeSecurityCapabilities = MakeSecurityCapability();
+    msg->abba = nas::IEAbba{OctetString::FromSpare(2)};
+    return msg;
+}
+
+static std::unique_ptr<nas::NasMessage> MakeRegistrationAccept()
+{
+    auto msg = std::make_unique<nas::RegistrationAccept>();
+    msg->registrationResult = nas::IE5gsRegistrationResult{nas::ESmsOverNasTransportAllowed::NOT_ALLOWED,
+                                                           nas::E5gsRegistrationResult::THREEGPP_ACCESS};
+    msg->mobileIdentity = nas::IE5gsMobileIdentity{};
+    msg->mobileIdentity->type = nas::EIdentityType::GUTI;
+    msg->mobileIdentity->gutiOrTmsi = GutiMobileIdentity{PLMN, 1, 1, 1, octet4{0x12345678u}};
+    msg->taiList = nas::IE5gsTrackingAreaIdentityList{};
+    nas::utils::AddToTaiList(*msg->taiList, nas::VTrackingAreaIdentity{nas::utils::PlmnFrom(PLMN), octet3{1}});
+    msg->allowedNSSAI = nas::utils::NssaiFrom(MakeSlices());
+    return msg;
+}
+
+static std::unique_ptr<nas::SmMessage> MakeSessionEstablishmentRequestSm()
+{
+    auto msg = std::make_unique<nas::PduSessionEstablishmentRequest>();
+    msg->pti = 1;
+    msg->pduSessionId = 1;
+    msg->integrityProtectionMaximumDataRate.maxRateDownlink =
+        nas::EMaximumDataRatePerUeForUserPlaneIntegrityProtectionForDownlink::FULL_DATA_RATE;
+    msg->integrityProtectionMaximumDataRate.maxRateUplink =
+        nas::EMaximumDataRatePerUeForUserPlaneIntegrityProtectionForUplink::FULL_DATA_RATE;
+    msg->pduSessionType = nas::IEPduSessionType{};
+    msg->pduSessionType->pduSessionType = nas::EPduSessionType::IPV4;
+    msg->sscMode = nas::IESscMode{};
+    msg->sscMode->sscMode = nas::ESscMode::SSC_MODE_1;
+    msg->smCapability = nas::IE5gSmCapability{};
+    msg->smCapability->rqos = nas::EReflectiveQoS::NOT_SUPPORTED;
+    msg->smCapability->mh6pdu = nas::EMultiHomedIPv6PduSession::NOT_SUPPORTED;
+    return msg;
+}
+
+static std::unique_ptr<nas::NasMessage> MakeSessionEstablishmentRequest()
+{
+    return MakeSessionEstablishmentRequestSm();
+}
+
+static std::unique_ptr<nas::SmMessage> MakeSessionEstablishmentAcceptSm()
+{
+    auto msg = std::make_unique<nas::PduSessionEstablishmentAccept>();
+    msg->pti = 1;
+    msg->pduSessionId = 1;
+    msg->selectedPduSessionType = nas::IEPduSessionType{nas::EPduSessionType::IPV4};
+    msg->selectedSscMode = nas::IESscMode{nas::ESscMode::SSC_MODE_1};
+    msg->authorizedQoSRules = nas::IEQoSRules{OctetString::FromHex("01000631310101FF01")};
+    msg->sessionAmbr = nas::IESessionAmbr{nas::EUnitForSessionAmbr::MULT_1Mbps, octet2{1000},
+                                          nas::EUnitForSessionAmbr::MULT_1Mbps, octet2{1000}};
+    msg->pduAddress = nas::IEPduAddress{nas::EPduSessionType::IPV4, OctetString::FromOctet4(0x0A2D0001u)};
+    msg->sNssai = nas::utils::SNssaiFrom(SingleSlice{1, std::nullopt});
+    msg->dnn = nas::utils::DnnFromApn("internet");
+    return msg;
+}
+
+static std::unique_ptr<nas::NasMessage> MakeSessionEstablishmentAccept()
+{
+    return MakeSessionEstablishmentAcceptSm();
+}
+
+static std::unique_ptr<nas::NasMessage> MakeUlNasTransport()
+{
+    OctetString payload;
+    nas::EncodeNasMessage(*MakeSessionEstablishmentRequestSm(), payload);
+
+    auto msg = std::make_unique<nas::UlNasTransport>();
+    msg->payloadContainerType = nas::IEPayloadContainerType{nas::EPayloadContainerType::N1_SM_INFORMATION};
+    msg->payloadContainer = nas::IEPayloadContainer{std::move(payload)};
+    msg->pduSessionId = nas::IEPduSessionIdentity2{1};
+    msg->requestType = nas::IERequestType{nas::ERequestType::INITIAL_REQUEST};
+    msg->sNssai = nas::utils::SNssaiFrom(SingleSlice{1, std::nullopt});
+    msg->dnn = nas::utils::DnnFromApn("internet");
+    return msg;
+}
+
+static std::unique_ptr<nas::NasMessage> MakeDlNasTransport()
+{
+    OctetString payload;
+    nas::EncodeNasMessage(*MakeSessionEstablishmentAcceptSm(), payload);
+
+    auto msg = std::make_unique<nas::DlNasTransport>();
+    msg->payloadContainerType = nas::IEPayloadContainerType{nas::EPayloadContainerType::N1_SM_INFORMATION};
+    msg->payloadContainer = nas::IEPayloadContainer{std::move(payload)};
+    msg->pduSessionId = nas::IEPduSessionIdentity2{1};
+    return msg;
+}
+
+static const struct
+{
+    const char *name;
+    std::unique_ptr<nas::NasMessage> (*make)();
+} MESSAGES[] = {
+    {"registration-request", MakeRegistrationRequest},
+    {"authentication-request", MakeAuthenticationRequest},
+    {"security-mode-command", MakeSecurityModeCommand},
+    {"registration-accept", MakeRegistrationAccept},
+    {"pdu-session-establishment-request", MakeSessionEstablishmentRequest},
+    {"pdu-session-establishment-accept", MakeSessionEstablishmentAccept},
+    {"ul-nas-transport", MakeUlNasTransport},
+    {"dl-nas-transport", MakeDlNasTransport},
+};
+
+void RegisterNasCases(Registry &registry)
+{
+    for (auto &message : MESSAGES)
+    {
+        auto make = message.make;
+
+        registry.add(std::string{"nas/encode/"} + message.name, [make](State &state) {
+            auto msg = make();
+            while (state.keepRunning())
+            {
+                OctetString stream;
+                nas::EncodeNasMessage(*msg, stream);
+                DoNotOptimize(stream);
+            }
+        });
+
+        registry.add(std::string{"nas/decode/"} + message.name, [make](State &state) {
+            OctetString stream;
+            nas::EncodeNasMessage(*make(), stream);
+            state.setProcessedBytes(stream.length());
+            while (state.keepRunning())
+            {
+                auto msg = nas::DecodeNasMessage(OctetView{stream});
+                DoNotOptimize(msg);
+            }
+        });
+    }
+
+    // The uplink protection of the UE, i.e. encoding, ciphering and integrity protection
+    registry.add("nas/protect/ul-nas-transport", [](State &state) {
+        nr::ue::NasSecurityContext ctx{};
+        ctx.tsc = nas::ETypeOfSecurityContext::NATIVE_SECURITY_CONTEXT;
+        ctx.integrity = nas::ETypeOfIntegrityProtectionAlgorithm::IA2_128;
+        ctx.ciphering = nas::ETypeOfCipheringAlgorithm::EA2_128;
+        ctx.keys.kNasInt = OctetString::FromSpare(16);
+        ctx.keys.kNasEnc = OctetString::FromSpare(16);
+
+        auto msg = MakeUlNasTransport();
+        while (state.keepRunning())
+        {
+            auto secured = nr::ue::nas_enc::Encrypt(ctx, static_cast<const nas::PlainMmMessage &>(*msg), false);
+            OctetString stream;
+            nas::EncodeNasMessage(*secured, stream);
+            DoNotOptimize(stream);
+        }
+    });
+}
+
+} // namespace bench
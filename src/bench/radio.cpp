@@ -0,0 +1,122 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "cases.hpp"
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <lib/radio/environment.hpp>
+#include <lib/radio/mobility.hpp>
+
+namespace bench
+{
+
+static constexpr const int GRID_CELLS = 10; // per side, 100 cells in total
+static constexpr const float CELL_SPACING = 500.0f;
+static constexpr const float MIN_DBM = -120.0f;
+static constexpr const int UE_COUNT = 10000;
+static constexpr const int STEP_MS = 100;
+static constexpr const int RX_POWER_CELLS = 100;
+
+static void SetupCells(radio::RadioEnvironment &env, float shadowingStdDev)
+{
+    for (int y = 0; y < GRID_CELLS; y++)
+    {
+        for (int x = 0; x < GRID_CELLS; x++)
+        {
+            radio::PathLossConfig config{};
+            config.shadowingStdDev = shadowingStdDev;
+            config.seed = static_cast<uint64_t>(y * GRID_CELLS + x);
+            env.addCell(Vector3{static_cast<int>(x * CELL_SPACING), static_cast<int>(y * CELL_SPACING), 25}, config);
+        }
+    }
+}
+
+static std::vector<std::unique_ptr<radio::MobilityModel>> MakeWalkers()
+{
+    std::vector<std::unique_ptr<radio::MobilityModel>> walkers;
+    walkers.reserve(UE_COUNT);
+
+    int side = static_cast<int>((GRID_CELLS - 1) * CELL_SPACING);
+    for (int i = 0; i < UE_COUNT; i++)
+    {
+        radio::MobilityConfig config{};
+        config.model = radio::EMobilityModel::RANDOM_WAYPOINT;
+        config.position = Vector3{(i * 7919) % side, (i * 104729) % side, 1};
+        config.areaMin = Vector3{0, 0, 1};
+        config.areaMax = Vector3{side, side, 1};
+        config.seed = static_cast<uint64_t>(i);
+        walkers.push_back(radio::CreateMobilityModel(config));
+    }
+    return walkers;
+}
+
+/* One simulated step of a whole population: every UE moves along its random waypoint path and the measurements of all
+ * UEs against all cells in range are recomputed. Without moving, only the recomputation is measured. */
+static void RunEnvironment(State &state, float shadowingStdDev, bool moving)
+{
+    radio::RadioEnvironment env{MIN_DBM};
+    SetupCells(env, shadowingStdDev);
+    env.setUeCount(UE_COUNT);
+
+    auto walkers = MakeWalkers();
+    int64_t time = 0;
+    for (int i = 0; i < UE_COUNT; i++)
+        env.setUePosition(i, walkers[i]->positionAt(time));
+
+    while (state.keepRunning())
+    {
+        if (moving)
+        {
+            time += STEP_MS;
+            for (int i = 0; i < UE_COUNT; i++)
+                env.setUePosition(i, walkers[i]->positionAt(time));
+        }
+        env.update();
+        DoNotOptimize(env.measurements().data());
+    }
+}
+
+void RegisterRadioCases(Registry &registry)
+{
+    registry.add("radio/environment/10000x100", [](State &state) { RunEnvironment(state, 0.0f, true); });
+    registry.add("radio/environment/10000x100-shadowing", [](State &state) { RunEnvironment(state, 4.0f, true); });
+    registry.add("radio/environment/10000x100-static", [](State &state) { RunEnvironment(state, 0.0f, false); });
+
+    // The SIMD kernel alone, one UE against a bucket of cells
+    registry.add("radio/rx-powers/100", [](State &state) {
+        std::mt19937 rng{1};
+        std::uniform_real_distribution<float> coord{0.0f, 5000.0f};
+
+        std::vector<float> x(RX_POWER_CELLS), y(RX_POWER_CELLS), z(RX_POWER_CELLS, 25.0f);
+        radio::PathLossModel model{radio::PathLossConfig{}};
+        std::vector<float> base(RX_POWER_CELLS, model.referencePower());
+        std::vector<float> slope(RX_POWER_CELLS, 5.0f * model.config().exponent / std::log(10.0f));
+        std::vector<float> out(RX_POWER_CELLS);
+        for (int i = 0; i < RX_POWER_CELLS; i++)
+        {
+            x[i] = coord(rng);
+            y[i] = coord(rng);
+        }
+
+        float ueX = 2500.0f;
+        while (state.keepRunning())
+        {
+            radio::ComputeRxPowers(ueX, 2500.0f, 1.0f, x.data(), y.data(), z.data(), base.data(), slope.data(),
+                                   RX_POWER_CELLS, out.data());
+            DoNotOptimize(out.data());
+            ueX += 0.5f;
+        }
+    });
+}
+
+} // namespace bench
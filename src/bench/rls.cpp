@@ -0,0 +1,305 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "cases.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <lib/rls/rls_pdu.hpp>
+#include <lib/rls/rls_transport.hpp>
+#include <utils/common.hpp>
+
+namespace bench
+{
+
+static constexpr const uint64_t STI = 0x0123456789ABCDEFull;
+static constexpr const int PDU_SIZE = 1400;
+static constexpr const int ACKED_PDUS = 8;
+
+static constexpr const char *LOOPBACK = "127.0.0.1";
+static constexpr const int BASE_PORT = 30000;
+static constexpr const int PORT_RANGE = 20000;
+static constexpr const int STREAM_BURST = 32;
+static constexpr const int REPLY_TIMEOUT = 1000; // ms
+static constexpr const int SERVER_POLL = 10;     // ms
+
+/* First octet of a transport benchmark datagram, followed by a 4 octet sequence number */
+enum class EProbeKind : uint8_t
+{
+    PING = 1, // echoed back as it is
+    DATA,     // only consumed
+    LAST,     // last datagram of a burst, answered with an ACK
+    ACK,
+};
+
+static constexpr const int PROBE_HEADER_SIZE = 5;
+
+static void WriteProbeHeader(uint8_t *buffer, EProbeKind kind, uint32_t sequence)
+{
+    buffer[0] = static_cast<uint8_t>(kind);
+    buffer[1] = static_cast<uint8_t>(sequence >> 24);
+    buffer[2] = static_cast<uint8_t>(sequence >> 16);
+    buffer[3] = static_cast<uint8_t>(sequence >> 8);
+    buffer[4] = static_cast<uint8_t>(sequence);
+}
+
+static bool IsProbe(const uint8_t *buffer, int size, EProbeKind kind, uint32_t sequence)
+{
+    uint8_t expected[PROBE_HEADER_SIZE];
+    WriteProbeHeader(expected, kind, sequence);
+    return size >= PROBE_HEADER_SIZE && std::equal(expected, expected + PROBE_HEADER_SIZE, buffer);
+}
+
+/* The gNB side of the transport benchmarks, served by its own thread like the RLS task of the gNB */
+class ProbeServer
+{
+  private:
+    std::unique_ptr<rls::RlsTransport> m_transport;
+    std::atomic<bool> m_stop;
+    std::thread m_thread;
+
+  public:
+    ProbeServer(rls::ETransportType type, uint16_t port)
+        : m_transport{rls::CreateServerTransport(type, LOOPBACK, port)}, m_stop{}, m_thread{[this]() { run(); }}
+    {
+    }
+
+    ~ProbeServer()
+    {
+        m_stop = true;
+        m_thread.join();
+    }
+
+  private:
+    void run()
+    {
+        std::vector<uint8_t> buffer(PDU_SIZE * 2);
+        InetAddress peer{};
+
+        while (!m_stop)
+        {
+            int size = m_transport->receive(buffer.data(), buffer.size(), SERVER_POLL, peer);
+            if (size < PROBE_HEADER_SIZE)
+                continue;
+
+            auto kind = static_cast<EProbeKind>(buffer[0]);
+            if (kind == EProbeKind::PING)
+                m_transport->send(peer, buffer.data(), static_cast<size_t>(size));
+            else if (kind == EProbeKind::LAST)
+            {
+                buffer[0] = static_cast<uint8_t>(EProbeKind::ACK);
+                m_transport->send(peer, buffer.data(), PROBE_HEADER_SIZE);
+            }
+        }
+    }
+};
+
+/* A UE side transport connected to a fresh server. Every run gets its own port, so that a run never sees datagrams
+ * of the previous one and benchmarks of concurrent processes do not collide */
+class ProbeClient
+{
+  private:
+    ProbeServer m_server;
+    std::unique_ptr<rls::RlsTransport> m_transport;
+    InetAddress m_serverAddress;
+    std::vector<uint8_t> m_rxBuffer;
+    uint32_t m_sequence;
+
+  public:
+    ProbeClient(rls::ETransportType type, uint16_t port)
+        : m_server{type, port}, m_transport{rls::CreateClientTransport(type)}, m_serverAddress{LOOPBACK, port},
+          m_rxBuffer(PDU_SIZE * 2), m_sequence{}
+    {
+        // The shared memory channel is established by the first datagram, keep it out of the measurement
+        std::vector<uint8_t> ping(PROBE_HEADER_SIZE);
+        pingPong(ping);
+    }
+
+    void pingPong(std::vector<uint8_t> &ping)
+    {
+        uint32_t sequence = ++m_sequence;
+        WriteProbeHeader(ping.data(), EProbeKind::PING, sequence);
+        exchange(ping.data(), ping.size(), EProbeKind::PING, sequence);
+    }
+
+    void stream(std::vector<uint8_t> &pdu)
+    {
+        uint32_t sequence = ++m_sequence;
+        WriteProbeHeader(pdu.data(), EProbeKind::DATA, sequence);
+        for (int i = 0; i < STREAM_BURST - 1; i++)
+            m_transport->send(m_serverAddress, pdu.data(), pdu.size());
+
+        WriteProbeHeader(pdu.data(), EProbeKind::LAST, sequence);
+        exchange(pdu.data(), pdu.size(), EProbeKind::ACK, sequence);
+    }
+
+  private:
+    // Sends the datagram until the expected reply arrives, stale replies of earlier attempts are skipped
+    void exchange(const uint8_t *data, size_t size, EProbeKind reply, uint32_t sequence)
+    {
+        for (int attempt = 0; attempt < 10; attempt++)
+        {
+            m_transport->send(m_serverAddress, data, size);
+
+            auto deadline = utils::CurrentTimeMillis() + REPLY_TIMEOUT;
+            while (utils::CurrentTimeMillis() < deadline)
+            {
+                InetAddress peer{};
+                int n = m_transport->receive(m_rxBuffer.data(), m_rxBuffer.size(), REPLY_TIMEOUT, peer);
+                if (IsProbe(m_rxBuffer.data(), n, reply, sequence))
+                    return;
+            }
+        }
+        throw std::runtime_error("no reply from the transport benchmark server");
+    }
+};
+
+static uint16_t NextProbePort()
+{
+    static int counter = 0;
+    return static_cast<uint16_t>(BASE_PORT + (static_cast<int>(::getpid()) * 97 + counter++) % PORT_RANGE);
+}
+
+static std::unique_ptr<rls::RlsMessage> MakeHeartBeat()
+{
+    auto msg = std::make_unique<rls::RlsHeartBeat>(STI);
+    msg->simPos = Vector3{1, 2, 3};
+    msg->features = rls::SUPPORTED_FEATURES;
+    return msg;
+}
+
+static std::unique_ptr<rls::RlsMessage> MakePduTransmission()
+{
+    auto msg = std::make_unique<rls::RlsPduTransmission>(STI);
+    msg->pduType = rls::EPduType::DATA;
+    msg->pduId = 1234;
+    msg->payload = 1;
+    msg->pdu = OctetString::FromSpare(PDU_SIZE);
+    return msg;
+}
+
+static std::unique_ptr<rls::RlsMessage> MakePduTransmissionAck()
+{
+    auto msg = std::make_unique<rls::RlsPduTransmissionAck>(STI);
+    for (uint32_t i = 0; i < ACKED_PDUS; i++)
+        msg->pduIds.push_back(1000 + i * 2);
+    msg->cumulativeId = 999;
+    return msg;
+}
+
+static const struct
+{
+    const char *name;
+    std::unique_ptr<rls::RlsMessage> (*make)();
+} MESSAGES[] = {
+    {"heartbeat", MakeHeartBeat},
+    {"pdu-transmission-1400", MakePduTransmission},
+    {"pdu-transmission-ack", MakePduTransmissionAck},
+};
+
+void RegisterRlsCases(Registry &registry)
+{
+    for (auto &message : MESSAGES)
+    {
+        auto make = message.make;
+
+        registry.add(std::string{"rls/encode/"} + message.name, [make](State &state) {
+            auto msg = make();
+            while (state.keepRunning())
+            {
+                OctetString stream;
+                rls::EncodeRlsMessage(*msg, stream);
+                DoNotOptimize(stream);
+            }
+        });
+
+        registry.add(std::string{"rls/decode/"} + message.name, [make](State &state) {
+            OctetString stream;
+            rls::EncodeRlsMessage(*make(), stream);
+            state.setProcessedBytes(stream.length());
+            while (state.keepRunning())
+            {
+                auto msg = rls::DecodeRlsMessage(OctetView{stream});
+                DoNotOptimize(msg);
+            }
+        });
+    }
+
+    // The copy-free paths of the user plane
+    registry.add("rls/encode-header/pdu-transmission", [](State &state) {
+        std::vector<uint8_t> buffer(rls::PDU_TRANSMISSION_HEADER_SIZE + PDU_SIZE);
+        while (state.keepRunning())
+        {
+            rls::EncodePduTransmissionHeader(STI, rls::EPduType::DATA, 1234, 1, PDU_SIZE, buffer.data());
+            DoNotOptimize(buffer);
+        }
+    });
+
+    // The views only decode the bodies of the heartbeat and the PDU transmission among these messages
+    for (auto &message : MESSAGES)
+    {
+        auto make = message.make;
+        if (make == MakePduTransmissionAck)
+            continue;
+
+        registry.add(std::string{"rls/decode-view/"} + message.name, [make](State &state) {
+            OctetString stream;
+            rls::EncodeRlsMessage(*make(), stream);
+            state.setProcessedBytes(stream.length());
+            while (state.keepRunning())
+            {
+                rls::RlsMessageView view{};
+                bool isValid = rls::DecodeRlsMessageView(stream.data(), static_cast<size_t>(stream.length()), view);
+                DoNotOptimize(isValid);
+                DoNotOptimize(view);
+            }
+        });
+    }
+
+    // Transport cases run against a server thread on the loopback address. Ping-pong is the round trip latency of
+    // one PDU, stream is the throughput of bursts of PDUs with one acknowledgement per burst.
+    const struct
+    {
+        const char *name;
+        rls::ETransportType type;
+    } transports[] = {
+        {"udp", rls::ETransportType::UDP},
+        {"shm", rls::ETransportType::SHM},
+    };
+
+    for (auto &transport : transports)
+    {
+        auto type = transport.type;
+
+        registry.add(std::string{"rls/transport/"} + transport.name + "/ping-pong", [type](State &state) {
+            ProbeClient client{type, NextProbePort()};
+            std::vector<uint8_t> ping(PDU_SIZE);
+            state.setProcessedBytes(2 * PDU_SIZE);
+            while (state.keepRunning())
+                client.pingPong(ping);
+        });
+
+        registry.add(std::string{"rls/transport/"} + transport.name + "/stream", [type](State &state) {
+            ProbeClient client{type, NextProbePort()};
+            std::vector<uint8_t> pdu(PDU_SIZE);
+            state.setProcessedBytes(STREAM_BURST * PDU_SIZE);
+            while (state.keepRunning())
+                client.stream(pdu);
+        });
+    }
+}
+
+} // namespace bench
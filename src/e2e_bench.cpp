@@ -0,0 +1,572 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <sys/resource.h>
+
+#include <amf/stub.hpp>
+#include <gnb/gnb.hpp>
+#include <lib/app/base_app.hpp>
+#include <lib/app/cli_base.hpp>
+#include <lib/app/cli_cmd.hpp>
+#include <lib/app/ue_ctl.hpp>
+#include <lib/crypt/milenage.hpp>
+#include <lib/sctp/sctp.hpp>
+#include <lib/traffic/traffic.hpp>
+#include <ue/metrics.hpp>
+#include <ue/rls/endpoint.hpp>
+#include <ue/ue.hpp>
+#include <upf/stub.hpp>
+#include <utils/common.hpp>
+#include <utils/constants.hpp>
+#include <utils/json.hpp>
+#include <utils/libc_error.hpp>
+#include <utils/options.hpp>
+#include <utils/yaml_utils.hpp>
+#include <yaml-cpp/yaml.h>
+
+static constexpr const int WAIT_POLL_PERIOD = 1; // Milliseconds between the checks of the AMF stub counters
+
+enum class EScenario
+{
+    REGISTRATION, // The UEs register
+    SESSION,      // And establish a PDU session each
+    DATA,         // And send synthetic traffic over it, reflected by the UPF stub
+    HANDOVER,     // And all of them switch the path at once, for a number of rounds
+};
+
+static struct Options
+{
+    std::string configFile{};
+    std::string outputFile{};
+    EScenario scenario{};
+    int count{};
+} g_options{};
+
+/* What the benchmark configuration gives, besides the configurations of the nodes built from it */
+static struct BenchConfig
+{
+    int ueCount{};
+    int threads{};
+    int dataDuration{};
+    int handoverRounds{};
+    int timeout{};
+    std::string rlsTransport{};
+    std::optional<traffic::TrafficProfile> traffic{};
+} g_bench{};
+
+static nr::amf::AmfStubConfig g_amfConfig{};
+static nr::upf::UpfStubConfig g_upfConfig{};
+static nr::gnb::GnbConfig *g_gnbConfig = nullptr;
+static std::shared_ptr<nr::ue::UeProfile> g_ueProfile{};
+
+/* Takes the responses of the commands given to the gNB, the counters of the AMF stub tell their outcome */
+class CommandResponseTask : public NtsTask
+{
+  protected:
+    void onStart() override
+    {
+    }
+
+    void onLoop() override
+    {
+        auto *msg = take();
+        delete msg;
+    }
+
+    void onQuit() override
+    {
+    }
+};
+
+/* The UEs are never switched off during a benchmark */
+static class UeController : public app::IUeController
+{
+  public:
+    void performSwitchOff(nr::ue::UserEquipment *) override
+    {
+    }
+} g_ueController;
+
+static bool ParseScenario(const std::string &value, EScenario &outScenario)
+{
+    if (value == "registration")
+        outScenario = EScenario::REGISTRATION;
+    else if (value == "session")
+        outScenario = EScenario::SESSION;
+    else if (value == "data")
+        outScenario = EScenario::DATA;
+    else if (value == "handover")
+        outScenario = EScenario::HANDOVER;
+    else
+        return false;
+    return true;
+}
+
+static std::string ScenarioName(EScenario scenario)
+{
+    switch (scenario)
+    {
+    case EScenario::REGISTRATION:
+        return "registration";
+    case EScenario::SESSION:
+        return "session";
+    case EScenario::DATA:
+        return "data";
+    case EScenario::HANDOVER:
+        return "handover";
+    default:
+        return "?";
+    }
+}
+
+static traffic::TrafficProfile ReadTrafficProfile(const YAML::Node &node)
+{
+    traffic::TrafficProfile profile{};
+
+    std::string model = yaml::GetString(node, "model");
+    if (!traffic::ParseTrafficModel(model, profile.model))
+        throw std::runtime_error("Invalid traffic model: " + model);
+
+    std::string destination = yaml::GetIp4(node, "destination");
+    profile.destination = inet_addr(destination.c_str());
+
+    if (yaml::HasField(node, "rate"))
+        profile.rate = yaml::GetDouble(node, "rate", 0.001, 1000000);
+    if (yaml::HasField(node, "size"))
+        profile.packetSize = yaml::GetInt32(node, "size", static_cast<int>(traffic::PROBE_HEADER_SIZE), 65000);
+    if (yaml::HasField(node, "burstSize"))
+        profile.burstSize = yaml::GetInt32(node, "burstSize", 1, 10000);
+    if (yaml::HasField(node, "port"))
+        profile.port = static_cast<uint16_t>(yaml::GetInt32(node, "port", 1, 65535));
+    return profile;
+}
+
+static void ReadConfigYaml()
+{
+    auto config = YAML::LoadFile(g_options.configFile);
+
+    Plmn plmn{};
+    plmn.mcc = yaml::GetInt32(config, "mcc", 1, 999);
+    yaml::GetString(config, "mcc", 3, 3);
+    plmn.mnc = yaml::GetInt32(config, "mnc", 0, 999);
+    plmn.isLongMnc = yaml::GetString(config, "mnc", 2, 3).size() == 3;
+
+    std::string amfIp = yaml::GetIp4(config, "amfIp");
+    std::string upfIp = yaml::GetIp4(config, "upfIp");
+    std::string gnbIp = yaml::GetIp4(config, "gnbIp");
+    if (upfIp == gnbIp)
+        throw std::runtime_error("The UPF and the gNB addresses must differ");
+
+    int tac = yaml::GetInt32(config, "tac", 0, 0xFFFFFF);
+    std::string dnn = yaml::GetString(config, "dnn", 1, 100);
+
+    rls::ETransportType rlsTransport{};
+    g_bench.rlsTransport = yaml::GetString(config, "rlsTransport");
+    if (!rls::ParseTransportType(g_bench.rlsTransport, rlsTransport))
+        throw std::runtime_error("Invalid RLS transport: " + g_bench.rlsTransport);
+
+    OctetString key = OctetString::FromHex(yaml::GetString(config, "key", 32, 32));
+    OctetString op = OctetString::FromHex(yaml::GetString(config, "op", 32, 32));
+    OctetString amf = OctetString::FromHex(yaml::GetString(config, "amf", 4, 4));
+    std::string opType = yaml::GetString(config, "opType");
+    if (opType != "OP" && opType != "OPC")
+        throw std::runtime_error("Invalid OP type: " + opType);
+
+    g_bench.ueCount = g_options.count > 0 ? g_options.count : yaml::GetInt32(config, "ueCount", 1, std::nullopt);
+    g_bench.threads = yaml::GetInt32(config, "threads", 1, 1024);
+    g_bench.dataDuration = yaml::GetInt32(config, "dataDuration", 1, std::nullopt);
+    g_bench.handoverRounds = yaml::GetInt32(config, "handoverRounds", 1, std::nullopt);
+    g_bench.timeout = yaml::GetInt32(config, "timeout", 1, std::nullopt);
+    if (g_options.scenario >= EScenario::DATA)
+        g_bench.traffic = ReadTrafficProfile(config["traffic"]);
+
+    /* AMF stub */
+    g_amfConfig.ngapIp = amfIp;
+    g_amfConfig.ngapPort = 38412;
+    g_amfConfig.amfName = "UERANSIM-amf";
+    g_amfConfig.plmn = plmn;
+    g_amfConfig.amfRegionId = 1;
+    g_amfConfig.amfSetId = 1;
+    g_amfConfig.amfPointer = 1;
+    g_amfConfig.tacs.push_back(tac);
+    g_amfConfig.nssai.slices.push_back(SingleSlice{1, std::nullopt});
+    g_amfConfig.workers = yaml::GetInt32(config, "amfWorkers", 1, 256);
+
+    nr::amf::SubscriberCredentials credentials{};
+    credentials.key = key.copy();
+    credentials.opC = opType == "OP" ? crypto::milenage::CalculateOpC(op, key) : op.copy();
+    credentials.amf = amf.copy();
+    g_amfConfig.defaultCredentials = std::move(credentials);
+    g_amfConfig.integrity = nas::ETypeOfIntegrityProtectionAlgorithm::IA2_128;
+    g_amfConfig.ciphering = nas::ETypeOfCipheringAlgorithm::EA2_128;
+
+    std::string subnet = yaml::GetString(config, "ueSubnet");
+    auto slash = subnet.find('/');
+    in_addr address{};
+    if (slash == std::string::npos || inet_pton(AF_INET, subnet.substr(0, slash).c_str(), &address) != 1)
+        throw std::runtime_error("Invalid UE subnet: " + subnet);
+    g_amfConfig.uePrefixLength = std::stoi(subnet.substr(slash + 1));
+    if (g_amfConfig.uePrefixLength < 8 || g_amfConfig.uePrefixLength > 30)
+        throw std::runtime_error("Invalid UE subnet prefix length: " + subnet);
+    g_amfConfig.ueSubnet = ntohl(address.s_addr) & (0xFFFFFFFFu << (32 - g_amfConfig.uePrefixLength));
+    g_amfConfig.upfAddress = upfIp;
+    g_amfConfig.dnn = dnn;
+    g_amfConfig.sessionAmbrUplink = 0xFFFF;
+    g_amfConfig.sessionAmbrDownlink = 0xFFFF;
+
+    /* UPF stub, the tunnels are programmed by the AMF stub as the sessions are set up */
+    g_upfConfig.address = upfIp;
+    g_upfConfig.port = static_cast<uint16_t>(cons::GtpPort);
+    g_upfConfig.uplinkMode = nr::upf::EUplinkMode::REFLECT;
+
+    /* gNB */
+    g_gnbConfig = new nr::gnb::GnbConfig();
+    g_gnbConfig->plmn = plmn;
+    g_gnbConfig->nci = yaml::GetInt64(config, "nci", 0, 0xFFFFFFFFFll);
+    g_gnbConfig->gnbIdLength = yaml::GetInt32(config, "idLength", 22, 32);
+    g_gnbConfig->tac = tac;
+    g_gnbConfig->portalIp = gnbIp;
+    g_gnbConfig->ngapIp = gnbIp;
+    g_gnbConfig->gtpIp = gnbIp;
+    g_gnbConfig->rlsTransport = rlsTransport;
+    g_gnbConfig->pathLoss.seed = static_cast<uint64_t>(g_gnbConfig->nci);
+    g_gnbConfig->pagingDrx = EPagingDrx::V128;
+    g_gnbConfig->name = "UERANSIM-gnb-" + std::to_string(plmn.mcc) + "-" + std::to_string(plmn.mnc) + "-" +
+                        std::to_string(g_gnbConfig->getGnbId());
+    g_gnbConfig->amfConfigs.push_back(nr::gnb::GnbAmfConfig{amfIp, g_amfConfig.ngapPort});
+    g_gnbConfig->nssai.slices.push_back(SingleSlice{1, std::nullopt});
+
+    /* UEs */
+    g_ueProfile = std::make_shared<nr::ue::UeProfile>();
+    g_ueProfile->supi = Supi::Parse("imsi-" + yaml::GetString(config, "imsi"));
+    g_ueProfile->hplmn = plmn;
+    g_ueProfile->key = std::move(key);
+    g_ueProfile->opC = std::move(op);
+    g_ueProfile->opType = opType == "OP" ? nr::ue::OpType::OP : nr::ue::OpType::OPC;
+    g_ueProfile->amf = std::move(amf);
+    g_ueProfile->supportedAlgs = nr::ue::SupportedAlgs{true, true, true, true, true, true};
+    g_ueProfile->gnbSearchList.push_back(gnbIp);
+    g_ueProfile->rlsTransport = rlsTransport;
+    g_ueProfile->traffic = g_bench.traffic;
+    g_ueProfile->integrityMaxRate.uplinkFull = true;
+    g_ueProfile->integrityMaxRate.downlinkFull = true;
+    g_ueProfile->configuredNssai.slices.push_back(SingleSlice{1, std::nullopt});
+    g_ueProfile->defaultConfiguredNssai.slices.push_back(SingleSlice{1, std::nullopt});
+    g_ueProfile->prefixLogger = g_bench.ueCount > 1;
+
+    if (g_options.scenario >= EScenario::SESSION)
+    {
+        nr::ue::SessionConfig session{};
+        session.type = nas::EPduSessionType::IPV4;
+        session.apn = dnn;
+        session.sNssai = SingleSlice{1, std::nullopt};
+        g_ueProfile->defaultSessions.push_back(session);
+    }
+}
+
+static void ReadOptions(int argc, char **argv)
+{
+    opt::OptionsDescription desc{cons::Project,
+                                 cons::Tag,
+                                 "In-process loopback benchmark of the gNB, the UEs and the stand-ins of the core",
+                                 cons::Owner,
+                                 "nr-e2e-bench",
+                                 {"-c <config-file> -s <scenario> [option...]"},
+                                 {},
+                                 true,
+                                 false};
+
+    opt::OptionItem itemConfigFile = {'c', "config", "Use specified configuration file for the benchmark",
+                                      "config-file"};
+    opt::OptionItem itemScenario = {'s', "scenario",
+                                    "Run the specified scenario: registration, session, data or handover. Each one "
+                                    "also runs the ones before it.",
+                                    "scenario"};
+    opt::OptionItem itemCount = {'n', "num-of-UE", "Use specified number of UEs instead of the configured one", "num"};
+    opt::OptionItem itemOutput = {'o', "output", "Write the results in JSON to the specified file instead of stdout",
+                                  "file"};
+    opt::OptionItem itemLogLevel = {std::nullopt, "log-level",
+                                    "Log the messages of the specified level and above: debug, info, warn or error. "
+                                    "Nothing is logged by default, the console is shared with the results.",
+                                    "level"};
+
+    desc.items.push_back(itemConfigFile);
+    desc.items.push_back(itemScenario);
+    desc.items.push_back(itemCount);
+    desc.items.push_back(itemOutput);
+    desc.items.push_back(itemLogLevel);
+
+    opt::OptionsResult opt{argc, argv, desc, false, nullptr};
+
+    g_options.configFile = opt.getOption(itemConfigFile);
+
+    std::string scenario = opt.getOption(itemScenario);
+    if (!ParseScenario(scenario, g_options.scenario))
+        throw std::runtime_error("Invalid scenario: " + scenario);
+
+    if (opt.hasFlag(itemCount))
+    {
+        g_options.count = utils::ParseInt(opt.getOption(itemCount));
+        if (g_options.count <= 0)
+            throw std::runtime_error("Invalid number of UEs");
+    }
+
+    if (opt.hasFlag(itemOutput))
+        g_options.outputFile = opt.getOption(itemOutput);
+
+    Logger::SetMinSeverity(Severity::FATAL);
+    if (opt.hasFlag(itemLogLevel))
+    {
+        Severity severity{};
+        if (!ParseSeverity(opt.getOption(itemLogLevel), severity))
+            throw std::runtime_error("Invalid log level: " + opt.getOption(itemLogLevel));
+        Logger::SetMinSeverity(severity);
+    }
+}
+
+/* User and system CPU time of the whole process in microseconds, i.e. of the gNB, the UEs and the stubs together */
+static int64_t CpuTime()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return (static_cast<int64_t>(usage.ru_utime.tv_sec) + static_cast<int64_t>(usage.ru_stime.tv_sec)) * 1000000 +
+           static_cast<int64_t>(usage.ru_utime.tv_usec) + static_cast<int64_t>(usage.ru_stime.tv_usec);
+}
+
+static double PerSecond(double value, int64_t periodUs)
+{
+    return periodUs > 0 ? value * 1e6 / static_cast<double>(periodUs) : 0.0;
+}
+
+/* Polls the condition until it holds or the timeout passes */
+static bool WaitFor(const std::function<bool()> &condition)
+{
+    int64_t deadline = nr::amf::MetricsTime() + static_cast<int64_t>(g_bench.timeout) * 1000;
+    while (!condition())
+    {
+        if (nr::amf::MetricsTime() >= deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_POLL_PERIOD));
+    }
+    return true;
+}
+
+/* Waits until the procedure is completed or failed the given number of times in total */
+static bool WaitForProcedure(nr::amf::AmfStub &amf, nr::amf::EProcedure procedure, int64_t count)
+{
+    return WaitFor([&amf, procedure, count]() {
+        return amf.metrics().completedCount(procedure) + amf.metrics().failedCount(procedure) >= count;
+    });
+}
+
+/* Rate and CPU cost of a phase, which started at the given wall clock and CPU times */
+static Json PhaseResult(bool isFinished, int64_t completed, int64_t failed, int64_t startTime, int64_t startCpu)
+{
+    int64_t elapsed = nr::amf::MetricsTime() - startTime;
+    int64_t cpu = CpuTime() - startCpu;
+
+    return Json::Obj({
+        {"finished", isFinished},
+        {"duration-ms", elapsed / 1000},
+        {"completed", completed},
+        {"failed", failed},
+        {"per-second", PerSecond(static_cast<double>(completed), elapsed)},
+        {"cpu-ms-per-ue", static_cast<double>(cpu) / 1000.0 / static_cast<double>(g_bench.ueCount)},
+    });
+}
+
+/* Bit rates over the period from the byte counters of the traffic generators of the UEs and of the UPF stub */
+static Json DataResult(const traffic::TrafficStats &ue, const traffic::TrafficStats &upf, int64_t periodUs,
+                       int64_t cpu)
+{
+    return Json::Obj({
+        {"duration-ms", periodUs / 1000},
+        {"uplink-gbps", PerSecond(static_cast<double>(ue.txBytes) * 8.0, periodUs) / 1e9},
+        {"downlink-gbps", PerSecond(static_cast<double>(ue.rxBytes) * 8.0, periodUs) / 1e9},
+        {"uplink-pps", PerSecond(static_cast<double>(ue.txPackets), periodUs)},
+        {"downlink-pps", PerSecond(static_cast<double>(ue.rxPackets), periodUs)},
+        {"lost", ue.lost},
+        {"reordered", ue.reordered},
+        {"upf", ToJson(upf)},
+        {"cpu-ms-per-ue", static_cast<double>(cpu) / 1000.0 / static_cast<double>(g_bench.ueCount)},
+    });
+}
+
+static void WriteOutput(const Json &result)
+{
+    if (g_options.outputFile.empty())
+    {
+        std::cout << result.dumpJson() << std::endl;
+        return;
+    }
+
+    std::ofstream file(g_options.outputFile);
+    file << result.dumpJson() << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    app::Initialize();
+
+    try
+    {
+        ReadOptions(argc, argv);
+        ReadConfigYaml();
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cerr << cons::Name << std::endl;
+
+    // The shared threads also carry the user plane of the UEs, rather lose log messages than stall them
+    LogBase::SetOverflowPolicy(LogOverflowPolicy::DROP);
+
+    nr::amf::AmfStub *amf;
+    nr::upf::UpfStub *upf;
+    try
+    {
+        amf = new nr::amf::AmfStub(std::move(g_amfConfig), nullptr, new LogBase("logs/e2e-bench-amf.log"));
+        upf = new nr::upf::UpfStub(g_upfConfig, new LogBase("logs/e2e-bench-upf.log"));
+    }
+    catch (const sctp::SctpError &e)
+    {
+        std::cerr << "ERROR: NGAP server could not be created: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (const LibError &e)
+    {
+        std::cerr << "ERROR: GTP-U socket could not be created: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string gnbIp = g_gnbConfig->gtpIp;
+    amf->setTunnelCallback([upf, gnbIp](uint32_t uplinkTeid, uint32_t downlinkTeid, const std::string &) {
+        upf->addTunnel(uplinkTeid, downlinkTeid, InetAddress{gnbIp, cons::GtpPort});
+    });
+    amf->start();
+    upf->start();
+
+    auto *responseTask = new CommandResponseTask();
+    responseTask->start();
+
+    auto *gnb = new nr::gnb::GNodeB(g_gnbConfig, nullptr, responseTask);
+    gnb->start();
+
+    // Otherwise the first UEs would be measured against the setup of the gNB
+    if (!WaitFor([amf]() { return amf->metrics().ngSetupCount() > 0; }))
+    {
+        std::cerr << "ERROR: NG Setup of the gNB is not completed" << std::endl;
+        return 1;
+    }
+
+    auto *procMetrics = new nr::ue::ProcedureMetrics();
+    auto *trafficMetrics = g_bench.traffic ? new traffic::TrafficMetrics() : nullptr;
+
+    auto *host = new nr::ue::UeHostContext();
+    host->logBase = new LogBase("logs/e2e-bench-ue.log");
+    host->executor = new NtsExecutor(g_bench.threads);
+    host->rlsEndpoint = new nr::ue::RlsEndpointTask(host->logBase, g_ueProfile->rlsTransport, g_ueProfile->gnbSearchList);
+    host->rlsEndpoint->start();
+
+    std::vector<nr::ue::UserEquipment *> ues{};
+    for (int i = 0; i < g_bench.ueCount; i++)
+    {
+        auto *config = new nr::ue::UeConfig(g_ueProfile, i);
+        ues.push_back(new nr::ue::UserEquipment(config, &g_ueController, nullptr, responseTask, host, procMetrics,
+                                                trafficMetrics));
+    }
+
+    Json result = Json::Obj({
+        {"scenario", ScenarioName(g_options.scenario)},
+        {"ues", g_bench.ueCount},
+        {"threads", g_bench.threads},
+        {"rls-transport", g_bench.rlsTransport},
+    });
+    bool isFinished;
+
+    /* Registration, and the PDU session establishment following it. Both are timed from the start of the UEs. */
+    int64_t startTime = nr::amf::MetricsTime();
+    int64_t startCpu = CpuTime();
+    for (auto *ue : ues)
+        ue->start();
+
+    auto &metrics = amf->metrics();
+    isFinished = WaitForProcedure(*amf, nr::amf::EProcedure::REGISTRATION, g_bench.ueCount);
+    result.put("registration",
+               PhaseResult(isFinished, metrics.completedCount(nr::amf::EProcedure::REGISTRATION),
+                           metrics.failedCount(nr::amf::EProcedure::REGISTRATION), startTime, startCpu));
+
+    if (isFinished && g_options.scenario >= EScenario::SESSION)
+    {
+        isFinished = WaitForProcedure(*amf, nr::amf::EProcedure::PDU_SESSION_ESTABLISHMENT, g_bench.ueCount);
+        result.put("session", PhaseResult(isFinished,
+                                          metrics.completedCount(nr::amf::EProcedure::PDU_SESSION_ESTABLISHMENT),
+                                          metrics.failedCount(nr::amf::EProcedure::PDU_SESSION_ESTABLISHMENT),
+                                          startTime, startCpu));
+    }
+
+    /* Synthetic traffic of all the sessions, measured once they are all up */
+    if (isFinished && g_options.scenario >= EScenario::DATA)
+    {
+        auto ueStats = trafficMetrics->stats();
+        auto upfStats = upf->stats();
+        startTime = nr::amf::MetricsTime();
+        startCpu = CpuTime();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(g_bench.dataDuration));
+
+        result.put("data", DataResult(trafficMetrics->stats() - ueStats, upf->stats() - upfStats,
+                                      nr::amf::MetricsTime() - startTime, CpuTime() - startCpu));
+    }
+
+    /* Path switch of all the UEs at once per round, the traffic of the sessions goes on meanwhile */
+    if (isFinished && g_options.scenario >= EScenario::HANDOVER)
+    {
+        int64_t completed = metrics.completedCount(nr::amf::EProcedure::PATH_SWITCH);
+        int64_t failed = metrics.failedCount(nr::amf::EProcedure::PATH_SWITCH);
+        startTime = nr::amf::MetricsTime();
+        startCpu = CpuTime();
+
+        for (int round = 1; round <= g_bench.handoverRounds && isFinished; round++)
+        {
+            gnb->pushCommand(std::make_unique<app::GnbCliCommand>(app::GnbCliCommand::PATH_SWITCH), InetAddress{});
+            isFinished = WaitForProcedure(*amf, nr::amf::EProcedure::PATH_SWITCH,
+                                          completed + failed + static_cast<int64_t>(round) * g_bench.ueCount);
+        }
+
+        Json handover = PhaseResult(isFinished, metrics.completedCount(nr::amf::EProcedure::PATH_SWITCH) - completed,
+                                    metrics.failedCount(nr::amf::EProcedure::PATH_SWITCH) - failed, startTime,
+                                    startCpu);
+        handover.put("rounds", g_bench.handoverRounds);
+        result.put("handover", handover);
+    }
+
+    result.put("finished", isFinished);
+    result.put("amf", amf->toJson());
+    result.put("ue", procMetrics->toJson(false));
+    if (trafficMetrics)
+        result.put("traffic", trafficMetrics->toJson());
+    WriteOutput(result);
+
+    // The nodes are not torn down, there is no orderly shutdown of the UEs and the gNB in the same process
+    LogBase::FlushAll();
+    std::_Exit(isFinished ? 0 : 1);
+}
@@ -1,14 +0,0 @@
-// Source: https://github.com/kokke/tiny-AES-c
-
-#ifndef _AES_HPP_
-#define _AES_HPP_
-
-#ifndef __cplusplus
-#error Do not include the hpp header in a c project!
-#endif //__cplusplus
-
-extern "C" {
-#include "aes.h"
-}
-
-#endif //_AES_HPP_
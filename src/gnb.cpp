@@ -19,7 +19,9 @@
 #include <lib/app/proc_table.hpp>
 #include <utils/constants.hpp>
 #include <utils/io.hpp>
+#include <utils/nts_trace.hpp>
 #include <utils/options.hpp>
+#include <utils/packet_capture.hpp>
 #include <utils/yaml_utils.hpp>
 #include <yaml-cpp/yaml.h>
 
@@ -28,12 +30,22 @@ static nr::gnb::GnbConfig *g_refConfig = nullptr;
 static std::unordered_map<std::string, nr::gnb::GNodeB *> g_gnbMap{};
 static app::CliResponseTask *g_cliRespTask = nullptr;
 
+static constexpr const size_t NTS_TRACE_RECORDS_PER_THREAD = 8192;
+static constexpr const size_t CAPTURE_RING_SIZE = 32 * 1024 * 1024;
+
 static struct Options
 {
     std::string configFile{};
     bool disableCmd{};
+    std::string ntsTraceFile{};
+    std::string captureFile{};
 } g_options{};
 
+static Vector3 ReadVector3(const YAML::Node &node)
+{
+    return Vector3{yaml::GetInt32(node, "x"), yaml::GetInt32(node, "y"), yaml::GetInt32(node, "z")};
+}
+
 static nr::gnb::GnbConfig *ReadConfigYaml()
 {
     auto *result = new nr::gnb::GnbConfig();
@@ -56,6 +68,34 @@ static nr::gnb::GnbConfig *ReadConfigYaml()
         result->gtpAdvertiseIp = yaml::GetIp4(config, "gtpAdvertiseIp");
 
     result->ignoreStreamIds = yaml::GetBool(config, "ignoreStreamIds");
+
+    if (yaml::HasField(config, "rlsTransport"))
+    {
+        std::string transport = yaml::GetString(config, "rlsTransport");
+        if (!rls::ParseTransportType(transport, result->rlsTransport))
+            throw std::runtime_error("Invalid RLS transport: " + transport);
+    }
+
+    if (yaml::HasField(config, "location"))
+        result->phyLocation = ReadVector3(config["location"]);
+
+    result->pathLoss.seed = static_cast<uint64_t>(result->nci);
+    if (yaml::HasField(config, "radio"))
+    {
+        auto radio = config["radio"];
+        if (yaml::HasField(radio, "txPower"))
+            result->pathLoss.txPower = static_cast<float>(yaml::GetDouble(radio, "txPower", -50, 80));
+        if (yaml::HasField(radio, "frequency"))
+            result->pathLoss.frequency = static_cast<float>(yaml::GetDouble(radio, "frequency", 400, 100000));
+        if (yaml::HasField(radio, "pathLossExponent"))
+            result->pathLoss.exponent = static_cast<float>(yaml::GetDouble(radio, "pathLossExponent", 1, 8));
+        if (yaml::HasField(radio, "shadowing"))
+            result->pathLoss.shadowingStdDev = static_cast<float>(yaml::GetDouble(radio, "shadowing", 0, 20));
+        if (yaml::HasField(radio, "decorrelationDistance"))
+            result->pathLoss.decorrelationDistance =
+                static_cast<float>(yaml::GetDouble(radio, "decorrelationDistance", 1, 10000));
+    }
+
     result->pagingDrx = EPagingDrx::V128;
     result->name = "UERANSIM-gnb-" + std::to_string(result->plmn.mcc) + "-" + std::to_string(result->plmn.mnc) + "-" +
                    std::to_string(result->getGnbId()); // NOTE: Avoid using "/" dir separator character.
@@ -80,6 +120,19 @@ static nr::gnb::GnbConfig *ReadConfigYaml()
     return result;
 }
 
+static void ExportNtsTrace()
+{
+    if (!g_options.ntsTraceFile.empty())
+        NtsTrace::ExportChromeJson(g_options.ntsTraceFile);
+}
+
+static void StopCapture()
+{
+    int64_t dropped = PacketCapture::Stop();
+    if (dropped > 0)
+        std::cerr << "WARNING: " << dropped << " packets were dropped from the capture" << std::endl;
+}
+
 static void ReadOptions(int argc, char **argv)
 {
     opt::OptionsDescription desc{cons::Project,
@@ -95,18 +148,42 @@ static void ReadOptions(int argc, char **argv)
     opt::OptionItem itemConfigFile = {'c', "config", "Use specified configuration file for gNB", "config-file"};
     opt::OptionItem itemDisableCmd = {'l', "disable-cmd", "Disable command line functionality for this instance",
                                       std::nullopt};
+    opt::OptionItem itemLogLevel = {std::nullopt, "log-level",
+                                    "Log the messages of the specified level and above: debug, info, warn or error",
+                                    "level"};
+    opt::OptionItem itemNtsTrace = {std::nullopt, "nts-trace",
+                                    "Trace the messages between the tasks and write the trace in Chrome trace format "
+                                    "to the specified file at exit",
+                                    "file"};
+    opt::OptionItem itemCapture = {std::nullopt, "capture",
+                                   "Capture the NGAP, RLS and GTP-U packets into the specified pcapng file", "file"};
 
     desc.items.push_back(itemConfigFile);
     desc.items.push_back(itemDisableCmd);
+    desc.items.push_back(itemLogLevel);
+    desc.items.push_back(itemNtsTrace);
+    desc.items.push_back(itemCapture);
 
     opt::OptionsResult opt{argc, argv, desc, false, nullptr};
 
     if (opt.hasFlag(itemDisableCmd))
         g_options.disableCmd = true;
     g_options.configFile = opt.getOption(itemConfigFile);
+    if (opt.hasFlag(itemNtsTrace))
+        g_options.ntsTraceFile = opt.getOption(itemNtsTrace);
+    if (opt.hasFlag(itemCapture))
+        g_options.captureFile = opt.getOption(itemCapture);
 
     try
     {
+        if (opt.hasFlag(itemLogLevel))
+        {
+            Severity severity{};
+            if (!ParseSeverity(opt.getOption(itemLogLevel), severity))
+                throw std::runtime_error("Invalid log level: " + opt.getOption(itemLogLevel));
+            Logger::SetMinSeverity(severity);
+        }
+
         g_refConfig = ReadConfigYaml();
     }
     catch (const std::runtime_error &e)
@@ -207,6 +284,26 @@ int main(int argc, char **argv)
 
     std::cout << cons::Name << std::endl;
 
+    if (!g_options.ntsTraceFile.empty())
+    {
+        NtsTrace::Enable(NTS_TRACE_RECORDS_PER_THREAD);
+        app::RunAtExit(ExportNtsTrace);
+    }
+
+    if (!g_options.captureFile.empty())
+    {
+        try
+        {
+            PacketCapture::Start(g_options.captureFile, CAPTURE_RING_SIZE);
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+        app::RunAtExit(StopCapture);
+    }
+
     if (!g_options.disableCmd)
     {
         g_cliServer = new app::CliServer{};
@@ -157,6 +157,24 @@ void GnbCmdHandler::handleCmdImpl(NmGnbCliCommand &msg)
         }
         break;
     }
+    case app::GnbCliCommand::PATH_SWITCH: {
+        if (msg.cmd->ueId != 0 && m_base->ngapTask->m_ueCtx.count(msg.cmd->ueId) == 0)
+        {
+            sendError(msg.address, "UE not found with given ID");
+            break;
+        }
+
+        int count = 0;
+        for (auto &ue : m_base->ngapTask->m_ueCtx)
+        {
+            if (msg.cmd->ueId != 0 && ue.first != msg.cmd->ueId)
+                continue;
+            if (m_base->ngapTask->sendPathSwitchRequest(ue.first))
+                count++;
+        }
+        sendResult(msg.address, "Requesting path switch for " + std::to_string(count) + " UE(s)");
+        break;
+    }
     // Pradnya
     case app::GnbCliCommand::HANDOVERPREPARE: {
         
@@ -14,6 +14,9 @@
 #include "rrc/task.hpp"
 #include "sctp/task.hpp"
 
+#include <utils/nts_trace.hpp>
+#include <utils/packet_capture.hpp>
+
 #include <lib/app/cli_base.hpp>
 
 namespace nr::gnb
@@ -27,6 +30,10 @@ GNodeB::GNodeB(GnbConfig *config, app::INodeListener *nodeListener, NtsTask *cli
     base->nodeListener = nodeListener;
     base->cliCallbackTask = cliCallbackTask;
 
+    // The packets of a gNB are captured on an interface named after the node
+    if (PacketCapture::IsEnabled())
+        base->captureInterface = PacketCapture::AddInterface(config->name);
+
     base->appTask = new GnbAppTask(base);
     base->sctpTask = new SctpTask(base);
     base->ngapTask = new NgapTask(base);
@@ -34,6 +41,17 @@ GNodeB::GNodeB(GnbConfig *config, app::INodeListener *nodeListener, NtsTask *cli
     base->gtpTask = new GtpTask(base);
     base->rlsTask = new GnbRlsTask(base);
 
+    // The tasks of a gNB are grouped in the trace by the node name
+    if (NtsTrace::IsEnabled())
+    {
+        base->appTask->setTraceName(config->name + "/app");
+        base->sctpTask->setTraceName(config->name + "/sctp");
+        base->ngapTask->setTraceName(config->name + "/ngap");
+        base->rrcTask->setTraceName(config->name + "/rrc");
+        base->gtpTask->setTraceName(config->name + "/gtp");
+        base->rlsTask->setTraceName(config->name + "/rls");
+    }
+
     taskBase = base;
 }
 
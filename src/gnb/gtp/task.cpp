@@ -20,9 +20,16 @@ namespace nr::gnb
 
 GtpTask::GtpTask(TaskBase *base)
     : m_base{base}, m_udpServer{}, m_ueContexts{},
-      m_rateLimiter(std::make_unique<RateLimiter>()), m_pduSessions{}, m_sessionTree{}
+      m_rateLimiter(std::make_unique<RateLimiter>()), m_pduSessions{}, m_sessionTree{}, m_capture{}
 {
     m_logger = m_base->logBase->makeUniqueLogger("gtp");
+
+    if (PacketCapture::IsEnabled())
+    {
+        m_capture.interface = base->captureInterface;
+        m_capture.protocol = CaptureProtocol::GTP;
+        m_capture.local = CaptureAddress{InetAddress{base->config->gtpIp, cons::GtpPort}};
+    }
 }
 
 void GtpTask::onStart()
@@ -34,7 +41,7 @@ void GtpTask::onStart()
     }
     catch (const LibError &e)
     {
-        m_logger->err("GTP/UDP task could not be created. %s", e.what());
+        m_logger->err(FMT_STRING("GTP/UDP task could not be created. {}"), e.what());
     }
 }
 
@@ -114,7 +121,8 @@ void GtpTask::handleSessionCreate(PduSessionResource *session)
 {
     if (!m_ueContexts.count(session->ueId))
     {
-        m_logger->err("PDU session resource could not be created, UE context with ID[%d] not found", session->ueId);
+        m_logger->err(FMT_STRING("PDU session resource could not be created, UE context with ID[{}] not found"),
+                      session->ueId);
         return;
     }
 
@@ -131,7 +139,7 @@ void GtpTask::handleSessionRelease(int ueId, int psi)
 {
     if (!m_ueContexts.count(ueId))
     {
-        m_logger->err("PDU session resource could not be released, UE context with ID[%d] not found", ueId);
+        m_logger->err(FMT_STRING("PDU session resource could not be released, UE context with ID[{}] not found"), ueId);
         return;
     }
 
@@ -189,7 +197,7 @@ void GtpTask::handleUplinkData(int ueId, int psi, OctetString &&pdu)
 
     if (!m_pduSessions.count(sessionInd))
     {
-        m_logger->err("Uplink data failure, PDU session not found. UE[%d] PSI[%d]", ueId, psi);
+        m_logger->err(FMT_STRING("Uplink data failure, PDU session not found. UE[{}] PSI[{}]"), ueId, psi);
         return;
     }
 
@@ -214,26 +222,34 @@ void GtpTask::handleUplinkData(int ueId, int psi, OctetString &&pdu)
         if (!gtp::EncodeGtpMessage(gtp, gtpPdu))
             m_logger->err("Uplink data failure, GTP encoding failed");
         else
-            m_udpServer->send(InetAddress(pduSession->upTunnel.address, cons::GtpPort), gtpPdu);
+        {
+            InetAddress upf{pduSession->upTunnel.address, cons::GtpPort};
+            PacketCapture::Record(m_capture, CaptureDirection::OUTBOUND, upf, gtpPdu.data(),
+                                  static_cast<size_t>(gtpPdu.length()));
+            m_udpServer->send(upf, gtpPdu);
+        }
     }
 }
 
 void GtpTask::handleUdpReceive(const udp::NwUdpServerReceive &msg)
 {
+    PacketCapture::Record(m_capture, CaptureDirection::INBOUND, msg.fromAddress, msg.packet.data(),
+                          static_cast<size_t>(msg.packet.length()));
+
     OctetView buffer{msg.packet};
     auto *gtp = gtp::DecodeGtpMessage(buffer);
 
     auto sessionInd = m_sessionTree.findByDownTeid(gtp->teid);
     if (sessionInd == 0)
     {
-        m_logger->err("TEID %d not found on GTP-U Downlink", gtp->teid);
+        m_logger->err(FMT_STRING("TEID {} not found on GTP-U Downlink"), gtp->teid);
         delete gtp;
         return;
     }
 
     if (gtp->msgType != gtp::GtpMessage::MT_G_PDU)
     {
-        m_logger->err("Unhandled GTP-U message type: %d", gtp->msgType);
+        m_logger->err(FMT_STRING("Unhandled GTP-U message type: {}"), gtp->msgType);
         delete gtp;
         return;
     }
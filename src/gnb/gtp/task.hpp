@@ -19,6 +19,7 @@
 #include <lib/udp/server_task.hpp>
 #include <utils/logger.hpp>
 #include <utils/nts.hpp>
+#include <utils/packet_capture.hpp>
 
 namespace nr::gnb
 {
@@ -34,6 +35,7 @@ class GtpTask : public NtsTask
     std::unique_ptr<IRateLimiter> m_rateLimiter;
     std::unordered_map<uint64_t, std::unique_ptr<PduSessionResource>> m_pduSessions;
     PduSessionTree m_sessionTree;
+    CapturePoint m_capture;
 
     friend class GnbCmdHandler;
 
@@ -6,17 +6,32 @@
 // and subject to the terms and conditions defined in LICENSE file.
 //
 
+#include "encode.hpp"
 #include "task.hpp"
 #include "utils.hpp"
 
+#include <stdexcept>
+#include <vector>
+
 #include <gnb/gtp/task.hpp>
 #include <gnb/rrc/task.hpp>
+#include <utils/common.hpp>
 
 #include <asn/ngap/ASN_NGAP_AMF-UE-NGAP-ID.h>
+#include <asn/ngap/ASN_NGAP_GTPTunnel.h>
 #include <asn/ngap/ASN_NGAP_InitialContextSetupRequest.h>
 #include <asn/ngap/ASN_NGAP_InitialContextSetupResponse.h>
 #include <asn/ngap/ASN_NGAP_NGAP-PDU.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceReleasedItemPSAck.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceReleasedItemPSFail.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceSwitchedItem.h>
+#include <asn/ngap/ASN_NGAP_PDUSessionResourceToBeSwitchedDLItem.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequest.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequestAcknowledge.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequestFailure.h>
+#include <asn/ngap/ASN_NGAP_PathSwitchRequestTransfer.h>
 #include <asn/ngap/ASN_NGAP_ProtocolIE-Field.h>
+#include <asn/ngap/ASN_NGAP_QosFlowAcceptedItem.h>
 #include <asn/ngap/ASN_NGAP_SuccessfulOutcome.h>
 #include <asn/ngap/ASN_NGAP_UE-NGAP-ID-pair.h>
 #include <asn/ngap/ASN_NGAP_UE-NGAP-IDs.h>
@@ -46,6 +61,11 @@ void NgapTask::receiveInitialContextSetup(int amfId, ASN_NGAP_InitialContextSetu
         ue->ueAmbr.ulAmbr = asn::GetUnsigned64(ie->UEAggregateMaximumBitRate.uEAggregateMaximumBitRateUL) / 8ull;
     }
 
+    ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_UESecurityCapabilities);
+    if (ie)
+        ue->securityCapabilities =
+            asn::UniqueCopy(ie->UESecurityCapabilities, asn_DEF_ASN_NGAP_UESecurityCapabilities);
+
     auto *response = asn::ngap::NewMessagePdu<ASN_NGAP_InitialContextSetupResponse>({});
     sendNgapUeAssociated(ue->ctxId, response);
 
@@ -102,7 +122,7 @@ void NgapTask::receiveContextModification(int amfId, ASN_NGAP_UEContextModificat
     {
         int64_t old = ue->amfUeNgapId;
         ue->amfUeNgapId = asn::GetSigned64(ie->AMF_UE_NGAP_ID_1);
-        m_logger->debug("AMF-UE-NGAP-ID changed from %ld to %ld", old, ue->amfUeNgapId);
+        m_logger->debug(FMT_STRING("AMF-UE-NGAP-ID changed from {} to {}"), old, ue->amfUeNgapId);
     }
 
     auto *response = asn::ngap::NewMessagePdu<ASN_NGAP_UEContextModificationResponse>({});
@@ -127,4 +147,134 @@ void NgapTask::sendContextRelease(int ueId, NgapCause cause)
     sendNgapUeAssociated(ueId, pdu);
 }
 
+bool NgapTask::sendPathSwitchRequest(int ueId)
+{
+    auto *ue = findUeContext(ueId);
+    if (ue == nullptr || ue->amfUeNgapId <= 0 || ue->pduSessions.empty())
+        return false;
+
+    // The UE arrived from a source gNB over Xn, the AMF is asked to switch the downlink of its sessions to us
+    auto *ieSourceId = asn::New<ASN_NGAP_PathSwitchRequestIEs>();
+    ieSourceId->id = ASN_NGAP_ProtocolIE_ID_id_SourceAMF_UE_NGAP_ID;
+    ieSourceId->criticality = ASN_NGAP_Criticality_reject;
+    ieSourceId->value.present = ASN_NGAP_PathSwitchRequestIEs__value_PR_AMF_UE_NGAP_ID;
+    asn::SetSigned64(ue->amfUeNgapId, ieSourceId->value.choice.AMF_UE_NGAP_ID);
+
+    auto *ieSecurity = asn::New<ASN_NGAP_PathSwitchRequestIEs>();
+    ieSecurity->id = ASN_NGAP_ProtocolIE_ID_id_UESecurityCapabilities;
+    ieSecurity->criticality = ASN_NGAP_Criticality_ignore;
+    ieSecurity->value.present = ASN_NGAP_PathSwitchRequestIEs__value_PR_UESecurityCapabilities;
+    if (ue->securityCapabilities)
+    {
+        asn::DeepCopy(asn_DEF_ASN_NGAP_UESecurityCapabilities, *ue->securityCapabilities,
+                      &ieSecurity->value.choice.UESecurityCapabilities);
+    }
+    else
+    {
+        auto &capabilities = ieSecurity->value.choice.UESecurityCapabilities;
+        asn::SetBitString(capabilities.nRencryptionAlgorithms, OctetString::FromHex("0000"));
+        asn::SetBitString(capabilities.nRintegrityProtectionAlgorithms, OctetString::FromHex("0000"));
+        asn::SetBitString(capabilities.eUTRAencryptionAlgorithms, OctetString::FromHex("0000"));
+        asn::SetBitString(capabilities.eUTRAintegrityProtectionAlgorithms, OctetString::FromHex("0000"));
+    }
+
+    auto *ieSessions = asn::New<ASN_NGAP_PathSwitchRequestIEs>();
+    ieSessions->id = ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceToBeSwitchedDLList;
+    ieSessions->criticality = ASN_NGAP_Criticality_reject;
+    ieSessions->value.present = ASN_NGAP_PathSwitchRequestIEs__value_PR_PDUSessionResourceToBeSwitchedDLList;
+
+    std::string gtpIp = m_base->config->gtpAdvertiseIp.value_or(m_base->config->gtpIp);
+
+    for (auto &session : ue->pduSessions)
+    {
+        auto *tr = asn::New<ASN_NGAP_PathSwitchRequestTransfer>();
+
+        auto &upInfo = tr->dL_NGU_UP_TNLInformation;
+        upInfo.present = ASN_NGAP_UPTransportLayerInformation_PR_gTPTunnel;
+        upInfo.choice.gTPTunnel = asn::New<ASN_NGAP_GTPTunnel>();
+        asn::SetBitString(upInfo.choice.gTPTunnel->transportLayerAddress, utils::IpToOctetString(gtpIp));
+        asn::SetOctetString4(upInfo.choice.gTPTunnel->gTP_TEID, (octet4)session.second.downlinkTeid);
+
+        for (int qfi : session.second.qosFlowIds)
+        {
+            auto *accepted = asn::New<ASN_NGAP_QosFlowAcceptedItem>();
+            accepted->qosFlowIdentifier = qfi;
+            asn::SequenceAdd(tr->qosFlowAcceptedList, accepted);
+        }
+
+        OctetString encodedTr = ngap_encode::EncodeS(asn_DEF_ASN_NGAP_PathSwitchRequestTransfer, tr);
+        asn::Free(asn_DEF_ASN_NGAP_PathSwitchRequestTransfer, tr);
+
+        if (encodedTr.length() == 0)
+            throw std::runtime_error("PathSwitchRequestTransfer encoding failed");
+
+        auto *item = asn::New<ASN_NGAP_PDUSessionResourceToBeSwitchedDLItem>();
+        item->pDUSessionID = static_cast<ASN_NGAP_PDUSessionID_t>(session.first);
+        asn::SetOctetString(item->pathSwitchRequestTransfer, encodedTr);
+        asn::SequenceAdd(ieSessions->value.choice.PDUSessionResourceToBeSwitchedDLList, item);
+    }
+
+    m_logger->debug(FMT_STRING("Sending Path Switch Request for UE[{}]"), ue->ctxId);
+
+    auto *pdu = asn::ngap::NewMessagePdu<ASN_NGAP_PathSwitchRequest>({ieSourceId, ieSessions, ieSecurity});
+    sendNgapUeAssociated(ue->ctxId, pdu);
+    return true;
+}
+
+void NgapTask::receivePathSwitchAcknowledge(int amfId, ASN_NGAP_PathSwitchRequestAcknowledge *msg)
+{
+    auto *ue = findUeByNgapIdPair(amfId, ngap_utils::FindNgapIdPair(msg));
+    if (ue == nullptr)
+        return;
+
+    // The uplink tunnels are kept, the sessions stay anchored at the same UPF
+    std::vector<int> released{};
+    auto *ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceReleasedListPSAck);
+    if (ie)
+    {
+        asn::ForeachItem(ie->PDUSessionResourceReleasedListPSAck,
+                         [&released](ASN_NGAP_PDUSessionResourceReleasedItemPSAck &item) {
+                             released.push_back(static_cast<int>(item.pDUSessionID));
+                         });
+    }
+    releasePduSessionsLocally(*ue, released);
+
+    m_logger->debug(FMT_STRING("Path switch is successful for UE[{}], released PDU sessions[{}]"), ue->ctxId,
+                    static_cast<int>(released.size()));
+}
+
+void NgapTask::receivePathSwitchFailure(int amfId, ASN_NGAP_PathSwitchRequestFailure *msg)
+{
+    auto *ue = findUeByNgapIdPair(amfId, ngap_utils::FindNgapIdPair(msg));
+    if (ue == nullptr)
+        return;
+
+    std::vector<int> released{};
+    auto *ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_PDUSessionResourceReleasedListPSFail);
+    if (ie)
+    {
+        asn::ForeachItem(ie->PDUSessionResourceReleasedListPSFail,
+                         [&released](ASN_NGAP_PDUSessionResourceReleasedItemPSFail &item) {
+                             released.push_back(static_cast<int>(item.pDUSessionID));
+                         });
+    }
+    releasePduSessionsLocally(*ue, released);
+
+    m_logger->err(FMT_STRING("Path switch failed for UE[{}]"), ue->ctxId);
+}
+
+void NgapTask::releasePduSessionsLocally(NgapUeContext &ue, const std::vector<int> &psIds)
+{
+    for (int psi : psIds)
+    {
+        if (ue.pduSessions.erase(psi) == 0)
+            continue;
+
+        auto *w = new NmGnbNgapToGtp(NmGnbNgapToGtp::SESSION_RELEASE);
+        w->ueId = ue.ctxId;
+        w->psi = psi;
+        m_base->gtpTask->push(w);
+    }
+}
+
 } // namespace nr::gnb
\ No newline at end of file
@@ -47,16 +47,20 @@ inline bool Encode(const asn_TYPE_descriptor_t &desc, T *pdu, ssize_t &encoded,
 template <typename T>
 inline OctetString EncodeS(const asn_TYPE_descriptor_t &desc, T *pdu)
 {
-    uint8_t *buffer;
-    ssize_t encoded;
-    if (Encode(desc, pdu, encoded, buffer))
+    // Copied straight from the buffer of asn1c, which is allocated with malloc
+    auto res = asn_encode_to_new_buffer(nullptr, ATS_ALIGNED_CANONICAL_PER, &desc, pdu);
+    if (res.buffer == nullptr)
+        return OctetString{};
+    if (res.result.encoded < 0)
     {
-        std::vector<uint8_t> v(encoded);
-        memcpy(v.data(), buffer, encoded);
-        free(buffer);
-        return OctetString{std::move(v)};
+        free(res.buffer);
+        return OctetString{};
     }
-    return OctetString{};
+
+    auto *data = reinterpret_cast<uint8_t *>(res.buffer);
+    std::vector<uint8_t> v(data, data + res.result.encoded);
+    free(res.buffer);
+    return OctetString{std::move(v)};
 }
 
 template <typename T>
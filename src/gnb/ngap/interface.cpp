@@ -99,8 +99,8 @@ void NgapTask::handleAssociationShutdown(int amfId)
     if (amf == nullptr)
         return;
 
-    m_logger->err("Association terminated for AMF[%d]", amfId);
-    m_logger->debug("Removing AMF context[%d]", amfId);
+    m_logger->err(FMT_STRING("Association terminated for AMF[{}]"), amfId);
+    m_logger->debug(FMT_STRING("Removing AMF context[{}]"), amfId);
 
     amf->state = EAmfState::NOT_CONNECTED;
 
@@ -215,7 +215,8 @@ void NgapTask::receiveNgSetupFailure(int amfId, ASN_NGAP_NGSetupFailure *msg)
 
     auto *ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_Cause);
     if (ie)
-        m_logger->err("NG Setup procedure is failed. Cause: %s", ngap_utils::CauseToString(ie->Cause).c_str());
+        m_logger->err(FMT_STRING("NG Setup procedure is failed. Cause: {}"),
+                      ngap_utils::CauseToString(ie->Cause).c_str());
     else
         m_logger->err("NG Setup procedure is failed.");
 }
@@ -231,7 +232,7 @@ void NgapTask::receiveErrorIndication(int amfId, ASN_NGAP_ErrorIndication *msg)
 
     auto *ie = asn::ngap::GetProtocolIe(msg, ASN_NGAP_ProtocolIE_ID_id_Cause);
     if (ie)
-        m_logger->err("Error indication received. Cause: %s", ngap_utils::CauseToString(ie->Cause).c_str());
+        m_logger->err(FMT_STRING("Error indication received. Cause: {}"), ngap_utils::CauseToString(ie->Cause).c_str());
     else
         m_logger->err("Error indication received.");
 }
@@ -244,7 +245,7 @@ void NgapTask::sendErrorIndication(int amfId, NgapCause cause, int ueId)
     ieCause->value.present = ASN_NGAP_ErrorIndicationIEs__value_PR_Cause;
     ngap_utils::ToCauseAsn_Ref(cause, ieCause->value.choice.Cause);
 
-    m_logger->warn("Sending an error indication with cause: %s",
+    m_logger->warn(FMT_STRING("Sending an error indication with cause: {}"),
                    ngap_utils::CauseToString(ieCause->value.choice.Cause).c_str());
 
     auto *pdu = asn::ngap::NewMessagePdu<ASN_NGAP_ErrorIndication>({ieCause});
@@ -261,7 +262,7 @@ void NgapTask::handoverPreparation(int ueId)
 {
 
     // Print the various parameters to pass on to handleXnHandover
-    m_logger->debug("handoverPreparation ueId: %d", ueId);
+    m_logger->debug(FMT_STRING("handoverPreparation ueId: {}"), ueId);
 
     Find UE and AMF contexts 
 
@@ -271,9 +272,9 @@ void NgapTask::handoverPreparation(int ueId)
         asn::Free(asn_DEF_ASN_NGAP_NGAP_PDU, pdu);
         return;
     }
-    m_logger->debug("amfId: %d", ue->associatedAmfId);
-    m_logger->debug("ue->amfUeNgapId: %d", ue->amfUeNgapId);
-    m_logger->debug("ue->ranUeNgapId: %d", ue->ranUeNgapId);
+    m_logger->debug(FMT_STRING("amfId: {}"), ue->associatedAmfId);
+    m_logger->debug(FMT_STRING("ue->amfUeNgapId: {}"), ue->amfUeNgapId);
+    m_logger->debug(FMT_STRING("ue->ranUeNgapId: {}"), ue->ranUeNgapId);
 
     auto *amf = findAmfContext(ue->associatedAmfId);
     if (amf == nullptr)
@@ -282,9 +283,9 @@ void NgapTask::handoverPreparation(int ueId)
         return;
     }
 
-    m_logger->debug("amf->amfName: %s", amf->amfName.c_str());
-    m_logger->debug("amf->ctxId: %d", amf->ctxId);
-    m_logger->debug("ue->uplinkStream: %d", ue->uplinkStream);
+    m_logger->debug(FMT_STRING("amf->amfName: {}"), amf->amfName.c_str());
+    m_logger->debug(FMT_STRING("amf->ctxId: {}"), amf->ctxId);
+    m_logger->debug(FMT_STRING("ue->uplinkStream: {}"), ue->uplinkStream);
 
 } */
 
@@ -292,8 +293,8 @@ void NgapTask::handoverPreparation(int ueId)
 void NgapTask::handleXnHandover(int asAmfId, int64_t amfUeNgapId, int64_t ranUeNgapId, int ctxtId, int ulStr, std::string amf_name)
 {
 
-    m_logger->debug("handle Xn handover asAmfId: %d", asAmfId);
-    m_logger->debug("amf_Name: %s", amf_name.c_str());
+    m_logger->debug(FMT_STRING("handle Xn handover asAmfId: {}"), asAmfId);
+    m_logger->debug(FMT_STRING("amf_Name: {}"), amf_name.c_str());
 
     auto *pdu = asn::ngap::NewMessagePdu<ASN_NGAP_PathSwitchRequest>({});
 
@@ -490,7 +491,7 @@ void NgapTask::receiveOverloadStart(int amfId, ASN_NGAP_OverloadStart *msg)
             amf->overloadInfo.indication.action = EOverloadAction::ONLY_HIGH_PRI_AND_MT;
             break;
         default:
-            m_logger->warn("AMF overload action [%d] could not understand",
+            m_logger->warn(FMT_STRING("AMF overload action [{}] could not understand"),
                            (int)ie->OverloadResponse.choice.overloadAction);
             break;
         }
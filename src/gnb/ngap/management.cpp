@@ -19,7 +19,7 @@ NgapAmfContext *NgapTask::findAmfContext(int ctxId)
     if (m_amfCtx.count(ctxId))
         ctx = m_amfCtx[ctxId];
     if (ctx == nullptr)
-        m_logger->err("AMF context not found with id: %d", ctxId);
+        m_logger->err(FMT_STRING("AMF context not found with id: {}"), ctxId);
     return ctx;
 }
 
@@ -44,7 +44,7 @@ void NgapTask::createUeContext(int ueId)
     // Perform AMF selection
     auto *amf = selectAmf(ueId);
     if (amf == nullptr)
-        m_logger->err("AMF selection for UE[%d] failed. Could not find a suitable AMF.", ueId);
+        m_logger->err(FMT_STRING("AMF selection for UE[{}] failed. Could not find a suitable AMF."), ueId);
     else
         ctx->associatedAmfId = amf->ctxId;
 }
@@ -55,7 +55,7 @@ NgapUeContext *NgapTask::findUeContext(int ctxId)
     if (m_ueCtx.count(ctxId))
         ctx = m_ueCtx[ctxId];
     if (ctx == nullptr)
-        m_logger->err("UE context not found with id: %d", ctxId);
+        m_logger->err(FMT_STRING("UE context not found with id: {}"), ctxId);
     return ctx;
 }
 
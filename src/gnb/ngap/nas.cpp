@@ -26,11 +26,11 @@ namespace nr::gnb
 
 void NgapTask::handleInitialNasTransport(int ueId, const OctetString &nasPdu, long rrcEstablishmentCause)
 {
-    m_logger->debug("Initial NAS message received from UE[%d]", ueId);
+    m_logger->debug(FMT_STRING("Initial NAS message received from UE[{}]"), ueId);
 
     if (m_ueCtx.count(ueId))
     {
-        m_logger->err("UE context[%d] already exists", ueId);
+        m_logger->err(FMT_STRING("UE context[{}] already exists"), ueId);
         return;
     }
 
@@ -102,7 +102,7 @@ void NgapTask::handleUplinkNasTransport(int ueId, const OctetString &nasPdu)
 
 void NgapTask::sendNasNonDeliveryIndication(int ueId, const OctetString &nasPdu, NgapCause cause)
 {
-    m_logger->debug("Sending non-delivery indication for UE[%d]", ueId);
+    m_logger->debug(FMT_STRING("Sending non-delivery indication for UE[{}]"), ueId);
 
     auto *ieNasPdu = asn::New<ASN_NGAP_NASNonDeliveryIndication_IEs>();
     ieNasPdu->id = ASN_NGAP_ProtocolIE_ID_id_NAS_PDU;
@@ -140,7 +140,7 @@ void NgapTask::receiveSessionResourceSetupRequest(int amfId, ASN_NGAP_PDUSession
                     associatedQosFlowItem->qosFlowIdentifier = qosList.array[iQos]->qosFlowIdentifier;
                     asn::SequenceAdd(tr->dLQosFlowPerTNLInformation.associatedQosFlowList, associatedQosFlowItem);
                     // Pradnya
-                    m_logger->debug("QoS Flow ID : %d",associatedQosFlowItem->qosFlowIdentifier);
+                    m_logger->debug(FMT_STRING("QoS Flow ID : {}"),associatedQosFlowItem->qosFlowIdentifier);
                 }
 
                 auto &upInfo = tr->dLQosFlowPerTNLInformation.uPTransportLayerInformation;
@@ -150,9 +150,9 @@ void NgapTask::receiveSessionResourceSetupRequest(int amfId, ASN_NGAP_PDUSession
                 asn::SetOctetString4(upInfo.choice.gTPTunnel->gTP_TEID, (octet4)resource->downTunnel.teid);
 
                 // Pradnya
-                m_logger->debug("PDU session id : %d",resource->psi);
-                m_logger->debug("TEID : %d",resource->downTunnel.teid);
-                m_logger->debug("Tunnel address : %d", *(resource->downTunnel.address.data()+3));
+                m_logger->debug(FMT_STRING("PDU session id : {}"),resource->psi);
+                m_logger->debug(FMT_STRING("TEID : {}"),resource->downTunnel.teid);
+                m_logger->debug(FMT_STRING("Tunnel address : {}"), *(resource->downTunnel.address.data()+3));
 
                 OctetString encodedTr =
                     ngap_encode::EncodeS(asn_DEF_ASN_NGAP_PDUSessionResourceSetupResponseTransfer, tr);
@@ -210,14 +210,15 @@ void NgapTask::receiveSessionResourceSetupRequest(int amfId, ASN_NGAP_PDUSession
     sendNgapUeAssociated(ue->ctxId, respPdu);
 
     if (failedList.empty())
-        m_logger->info("PDU session resource(s) setup for UE[%d] count[%d]", ue->ctxId,
+        m_logger->info(FMT_STRING("PDU session resource(s) setup for UE[{}] count[{}]"), ue->ctxId,
                        static_cast<int>(successList.size()));
     else if (successList.empty())
-        m_logger->err("PDU session resource(s) setup was failed for UE[%d] count[%d]", ue->ctxId,
+        m_logger->err(FMT_STRING("PDU session resource(s) setup was failed for UE[{}] count[{}]"), ue->ctxId,
                       static_cast<int>(failedList.size()));
     else
-        m_logger->err("PDU session establishment is partially successful for UE[%d], success[%d], failed[%d]",
-                      static_cast<int>(successList.size()), static_cast<int>(failedList.size()));
+        m_logger->err(
+            FMT_STRING("PDU session establishment is partially successful for UE[{}], success[{}], failed[{}]"),
+            ue->ctxId, static_cast<int>(successList.size()), static_cast<int>(failedList.size()));
 }
 
 std::optional<NgapCause> NgapTask::setupPduSessionResource(PduSessionResource *resource)
@@ -245,6 +246,17 @@ std::optional<NgapCause> NgapTask::setupPduSessionResource(PduSessionResource *r
     resource->downTunnel.address = utils::IpToOctetString(gtpIp);
     resource->downTunnel.teid = ++m_downlinkTeidCounter;
 
+    auto *ue = findUeContext(resource->ueId);
+    if (ue)
+    {
+        auto &session = ue->pduSessions[resource->psi];
+        session.downlinkTeid = resource->downTunnel.teid;
+        session.qosFlowIds.clear();
+        asn::ForeachItem(*resource->qosFlows, [&session](ASN_NGAP_QosFlowSetupRequestItem &item) {
+            session.qosFlowIds.push_back(static_cast<int>(item.qosFlowIdentifier));
+        });
+    }
+
     auto *w = new NmGnbNgapToGtp(NmGnbNgapToGtp::SESSION_CREATE);
     w->resource = resource;
     m_base->gtpTask->push(w);
@@ -286,6 +298,8 @@ void NgapTask::receiveSessionResourceReleaseCommand(int amfId, ASN_NGAP_PDUSessi
     // Perform release
     for (auto &psi : psIds)
     {
+        ue->pduSessions.erase(psi);
+
         auto *w = new NmGnbNgapToGtp(NmGnbNgapToGtp::SESSION_RELEASE);
         w->ueId = ue->ctxId;
         w->psi = psi;
@@ -313,7 +327,8 @@ void NgapTask::receiveSessionResourceReleaseCommand(int amfId, ASN_NGAP_PDUSessi
     auto *respPdu = asn::ngap::NewMessagePdu<ASN_NGAP_PDUSessionResourceReleaseResponse>({ieResp});
     sendNgapUeAssociated(ue->ctxId, respPdu);
 
-    m_logger->info("PDU session resource(s) released for UE[%d] count[%d]", ue->ctxId, static_cast<int>(psIds.size()));
+    m_logger->info(FMT_STRING("PDU session resource(s) released for UE[{}] count[{}]"), ue->ctxId,
+                   static_cast<int>(psIds.size()));
 }
 
 } // namespace nr::gnb
\ No newline at end of file
@@ -34,6 +34,8 @@ extern "C"
     struct ASN_NGAP_OverloadStop;
     struct ASN_NGAP_PDUSessionResourceReleaseCommand;
     struct ASN_NGAP_Paging;
+    struct ASN_NGAP_PathSwitchRequestAcknowledge;
+    struct ASN_NGAP_PathSwitchRequestFailure;
 }
 
 namespace nr::gnb
@@ -118,6 +120,11 @@ class NgapTask : public NtsTask
     void receiveContextRelease(int amfId, ASN_NGAP_UEContextReleaseCommand *msg);
     void receiveContextModification(int amfId, ASN_NGAP_UEContextModificationRequest *msg);
     void sendContextRelease(int ueId, NgapCause cause);
+    /* Returns false if the UE has no AMF UE NGAP ID or no PDU session to switch */
+    bool sendPathSwitchRequest(int ueId);
+    void receivePathSwitchAcknowledge(int amfId, ASN_NGAP_PathSwitchRequestAcknowledge *msg);
+    void receivePathSwitchFailure(int amfId, ASN_NGAP_PathSwitchRequestFailure *msg);
+    void releasePduSessionsLocally(NgapUeContext &ue, const std::vector<int> &psIds);
 
     /* NAS Node Selection */
     NgapAmfContext *selectAmf(int ueId);
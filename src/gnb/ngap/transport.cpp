@@ -147,9 +147,13 @@ void NgapTask::sendNgapUeAssociated(int ueId, ASN_NGAP_NGAP_PDU *pdu)
         return;
     }
 
+    // The path switch request has the AMF UE NGAP ID of the source gNB as a distinct IE of the same type
+    bool isPathSwitch = pdu->present == ASN_NGAP_NGAP_PDU_PR_initiatingMessage &&
+                        pdu->choice.initiatingMessage->procedureCode == ASN_NGAP_ProcedureCode_id_PathSwitchRequest;
+
     /* Insert UE-related information elements */
     {
-        if (ue->amfUeNgapId > 0)
+        if (ue->amfUeNgapId > 0 && !isPathSwitch)
         {
             asn::ngap::AddProtocolIeIfUsable(
                 *pdu, asn_DEF_ASN_NGAP_AMF_UE_NGAP_ID, ASN_NGAP_ProtocolIE_ID_id_AMF_UE_NGAP_ID,
@@ -293,7 +297,7 @@ void NgapTask::handleSctpMessage(int amfId, uint16_t stream, const UniqueBuffer
             receivePaging(amf->ctxId, &value.choice.Paging);
             break;
         default:
-            m_logger->err("Unhandled NGAP initiating-message received (%d)", value.present);
+            m_logger->err(FMT_STRING("Unhandled NGAP initiating-message received ({})"), value.present);
             break;
         }
     }
@@ -305,8 +309,11 @@ void NgapTask::handleSctpMessage(int amfId, uint16_t stream, const UniqueBuffer
         case ASN_NGAP_SuccessfulOutcome__value_PR_NGSetupResponse:
             receiveNgSetupResponse(amf->ctxId, &value.choice.NGSetupResponse);
             break;
+        case ASN_NGAP_SuccessfulOutcome__value_PR_PathSwitchRequestAcknowledge:
+            receivePathSwitchAcknowledge(amf->ctxId, &value.choice.PathSwitchRequestAcknowledge);
+            break;
         default:
-            m_logger->err("Unhandled NGAP successful-outcome received (%d)", value.present);
+            m_logger->err(FMT_STRING("Unhandled NGAP successful-outcome received ({})"), value.present);
             break;
         }
     }
@@ -318,8 +325,11 @@ void NgapTask::handleSctpMessage(int amfId, uint16_t stream, const UniqueBuffer
         case ASN_NGAP_UnsuccessfulOutcome__value_PR_NGSetupFailure:
             receiveNgSetupFailure(amf->ctxId, &value.choice.NGSetupFailure);
             break;
+        case ASN_NGAP_UnsuccessfulOutcome__value_PR_PathSwitchRequestFailure:
+            receivePathSwitchFailure(amf->ctxId, &value.choice.PathSwitchRequestFailure);
+            break;
         default:
-            m_logger->err("Unhandled NGAP unsuccessful-outcome received (%d)", value.present);
+            m_logger->err(FMT_STRING("Unhandled NGAP unsuccessful-outcome received ({})"), value.present);
             break;
         }
     }
@@ -356,7 +366,7 @@ bool NgapTask::handleSctpStreamId(int amfId, int stream, const ASN_NGAP_NGAP_PDU
             ue->downlinkStream = stream;
         else if (ue->downlinkStream != stream)
         {
-            m_logger->err("received stream number is inconsistent. received %d, expected :%d", stream,
+            m_logger->err(FMT_STRING("received stream number is inconsistent. received {}, expected :{}"), stream,
                           ue->downlinkStream);
             sendErrorIndication(amfId, NgapCause::Protocol_unspecified);
             return false;
@@ -384,7 +394,7 @@ bool NgapTask::handleSctpStreamId(int amfId, int stream, const ASN_NGAP_NGAP_PDU
                 ue->downlinkStream = stream;
             else if (ue->downlinkStream != stream)
             {
-                m_logger->err("received stream number is inconsistent. received %d, expected :%d", stream,
+                m_logger->err(FMT_STRING("received stream number is inconsistent. received {}, expected :{}"), stream,
                               ue->downlinkStream);
                 sendErrorIndication(amfId, NgapCause::Protocol_unspecified);
                 return false;
@@ -8,23 +8,27 @@
 
 #include "ctl_task.hpp"
 
-#include <stdexcept>
 #include <utils/common.hpp>
 
-static constexpr const size_t MAX_PDU_COUNT = 4096;
-static constexpr const int MAX_PDU_TTL = 3000;
+static constexpr const int RETRANSMISSION_TIMEOUT = 500;
+static constexpr const int MAX_RETRANSMISSION = 4;
+static constexpr const size_t RETRANSMISSION_WHEEL_SIZE = 64;
 
-static constexpr const int TIMER_ID_ACK_CONTROL = 1;
+static constexpr const int TIMER_ID_RETRANSMISSION = 1;
 static constexpr const int TIMER_ID_ACK_SEND = 2;
+static constexpr const int TIMER_ID_BATCH_FLUSH = 3;
 
-static constexpr const int TIMER_PERIOD_ACK_CONTROL = 1500;
-static constexpr const int TIMER_PERIOD_ACK_SEND = 2250;
+static constexpr const int TIMER_PERIOD_RETRANSMISSION = 100;
+static constexpr const int TIMER_PERIOD_ACK_SEND = 20;
+static constexpr const int TIMER_PERIOD_BATCH_FLUSH = 1;
 
 namespace nr::gnb
 {
 
 RlsControlTask::RlsControlTask(TaskBase *base, uint64_t sti)
-    : m_sti{sti}, m_mainTask{}, m_udpTask{}, m_pduMap{}, m_pendingAck{}
+    : m_sti{sti}, m_mainTask{}, m_udpTask{}, m_txWindows{}, m_rxWindows{}, m_pendingAck{},
+      m_retransmissions{RETRANSMISSION_WHEEL_SIZE, TIMER_PERIOD_RETRANSMISSION}, m_batcher{}, m_ackTimerSet{},
+      m_retransmissionTimerSet{}, m_batchTimerSet{}
 {
     m_logger = base->logBase->makeUniqueLogger("rls-ctl");
 }
@@ -37,8 +41,6 @@ void RlsControlTask::initialize(NtsTask *mainTask, RlsUdpTask *udpTask)
 
 void RlsControlTask::onStart()
 {
-    setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
-    setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
 }
 
 void RlsControlTask::onLoop()
@@ -66,7 +68,7 @@ void RlsControlTask::onLoop()
             handleDownlinkDataDelivery(w->ueId, w->psi, std::move(w->data));
             break;
         case NmGnbRlsToRls::DOWNLINK_RRC:
-            handleDownlinkRrcDelivery(w->ueId, w->pduId, w->rrcChannel, std::move(w->data));
+            handleDownlinkRrcDelivery(w->ueId, w->rrcChannel, std::move(w->data));
             break;
         default:
             m_logger->unhandledNts(msg);
@@ -76,16 +78,21 @@ void RlsControlTask::onLoop()
     }
     case NtsMessageType::TIMER_EXPIRED: {
         auto *w = dynamic_cast<NmTimerExpired *>(msg);
-        if (w->timerId == TIMER_ID_ACK_CONTROL)
+        if (w->timerId == TIMER_ID_RETRANSMISSION)
         {
-            setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
-            onAckControlTimerExpired();
+            m_retransmissionTimerSet = false;
+            onRetransmissionTimerExpired();
         }
         else if (w->timerId == TIMER_ID_ACK_SEND)
         {
-            setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
+            m_ackTimerSet = false;
             onAckSendTimerExpired();
         }
+        else if (w->timerId == TIMER_ID_BATCH_FLUSH)
+        {
+            m_batchTimerSet = false;
+            onBatchTimerExpired();
+        }
         break;
     }
     default:
@@ -109,6 +116,11 @@ void RlsControlTask::handleSignalDetected(int ueId)
 
 void RlsControlTask::handleSignalLost(int ueId)
 {
+    m_txWindows.erase(ueId);
+    m_retransmissions.cancel(ueId);
+    m_rxWindows.erase(ueId);
+    m_pendingAck.erase(ueId);
+
     auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::SIGNAL_LOST);
     w->ueId = ueId;
     m_mainTask->push(w);
@@ -119,118 +131,154 @@ void RlsControlTask::handleRlsMessage(int ueId, rls::RlsMessage &msg)
     if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION_ACK)
     {
         auto &m = (rls::RlsPduTransmissionAck &)msg;
-        for (auto pduId : m.pduIds)
-            m_pduMap.erase(pduId);
+        auto it = m_txWindows.find(ueId);
+        if (it != m_txWindows.end())
+            it->second.acknowledge(m.cumulativeId, m.pduIds);
     }
     else if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION)
     {
         auto &m = (rls::RlsPduTransmission &)msg;
-        if (m.pduId != 0)
-            m_pendingAck[ueId].push_back(m.pduId);
+        handlePduTransmission(ueId, m.pduType, m.pduId, m.payload, std::move(m.pdu));
+    }
+    else if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION_BATCH)
+    {
+        auto &m = (rls::RlsPduTransmissionBatch &)msg;
+        for (auto &item : m.items)
+            handlePduTransmission(ueId, item.pduType, item.pduId, item.payload, std::move(item.pdu));
+    }
+    else
+    {
+        m_logger->err("Unhandled RLS message type");
+    }
+}
 
-        if (m.pduType == rls::EPduType::DATA)
-        {
-            auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::UPLINK_DATA);
-            w->ueId = ueId;
-            w->psi = static_cast<int>(m.payload);
-            w->data = std::move(m.pdu);
-            m_mainTask->push(w);
-        }
-        else if (m.pduType == rls::EPduType::RRC)
-        {
-            auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::UPLINK_RRC);
-            w->ueId = ueId;
-            w->rrcChannel = static_cast<rrc::RrcChannel>(m.payload);
-            w->data = std::move(m.pdu);
-            m_mainTask->push(w);
-        }
-        else
+void RlsControlTask::handlePduTransmission(int ueId, rls::EPduType pduType, uint32_t pduId, uint32_t payload,
+                                           OctetString &&pdu)
+{
+    if (pduId != 0)
+    {
+        bool isNew = m_rxWindows[ueId].receive(pduId);
+
+        // Duplicates are acknowledged again, since the previous ACK may be lost
+        m_pendingAck.insert(ueId);
+        if (!m_ackTimerSet)
         {
-            m_logger->err("Unhandled RLS PDU type");
+            m_ackTimerSet = true;
+            setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
         }
+
+        if (!isNew)
+            return;
+    }
+
+    if (pduType == rls::EPduType::DATA)
+    {
+        auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::UPLINK_DATA);
+        w->ueId = ueId;
+        w->psi = static_cast<int>(payload);
+        w->data = std::move(pdu);
+        m_mainTask->push(w);
+    }
+    else if (pduType == rls::EPduType::RRC)
+    {
+        auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::UPLINK_RRC);
+        w->ueId = ueId;
+        w->rrcChannel = static_cast<rrc::RrcChannel>(payload);
+        w->data = std::move(pdu);
+        m_mainTask->push(w);
     }
     else
     {
-        m_logger->err("Unhandled RLS message type");
+        m_logger->err("Unhandled RLS PDU type");
     }
 }
 
-void RlsControlTask::handleDownlinkRrcDelivery(int ueId, uint32_t pduId, rrc::RrcChannel channel, OctetString &&data)
+void RlsControlTask::handleDownlinkRrcDelivery(int ueId, rrc::RrcChannel channel, OctetString &&data)
 {
-    if (ueId == 0 && pduId != 0)
+    if (ueId == 0)
     {
-        // PDU ID must be not set in case of broadcast
-        throw std::runtime_error("");
+        // Broadcast messages are sent in unacknowledged mode
+        rls::RlsPduTransmission msg{m_sti};
+        msg.pduType = rls::EPduType::RRC;
+        msg.pdu = std::move(data);
+        msg.payload = static_cast<uint32_t>(channel);
+        msg.pduId = 0;
+
+        m_udpTask->send(ueId, msg);
+        return;
     }
 
-    if (pduId != 0)
+    auto &window = m_txWindows[ueId];
+    if (window.isFull())
     {
-        if (m_pduMap.count(pduId))
-        {
-            m_pduMap.clear();
-
-            auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::RADIO_LINK_FAILURE);
-            w->rlfCause = rls::ERlfCause::PDU_ID_EXISTS;
-            m_mainTask->push(w);
-            return;
-        }
+        window.reset();
+        m_retransmissions.cancel(ueId);
 
-        if (m_pduMap.size() > MAX_PDU_COUNT)
-        {
-            m_pduMap.clear();
+        auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::RADIO_LINK_FAILURE);
+        w->ueId = ueId;
+        w->rlfCause = rls::ERlfCause::PDU_ID_FULL;
+        m_mainTask->push(w);
+        return;
+    }
 
-            auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::RADIO_LINK_FAILURE);
-            w->rlfCause = rls::ERlfCause::PDU_ID_FULL;
-            m_mainTask->push(w);
-            return;
-        }
+    auto &pdu = window.push(ueId, channel, std::move(data));
+    transmitRrc(pdu);
 
-        m_pduMap[pduId].endPointId = ueId;
-        m_pduMap[pduId].id = pduId;
-        m_pduMap[pduId].pdu = data.copy();
-        m_pduMap[pduId].rrcChannel = channel;
-        m_pduMap[pduId].sentTime = utils::CurrentTimeMillis();
+    m_retransmissions.schedule(pdu.sentTime, RETRANSMISSION_TIMEOUT, {ueId, pdu.id});
+    if (!m_retransmissionTimerSet)
+    {
+        m_retransmissionTimerSet = true;
+        setTimer(TIMER_ID_RETRANSMISSION, TIMER_PERIOD_RETRANSMISSION);
     }
+}
 
+void RlsControlTask::transmitRrc(rls::PduInfo &pdu)
+{
     rls::RlsPduTransmission msg{m_sti};
     msg.pduType = rls::EPduType::RRC;
-    msg.pdu = std::move(data);
-    msg.payload = static_cast<uint32_t>(channel);
-    msg.pduId = pduId;
+    msg.pdu = std::move(pdu.pdu);
+    msg.payload = static_cast<uint32_t>(pdu.rrcChannel);
+    msg.pduId = pdu.id;
+
+    m_udpTask->send(pdu.endPointId, msg);
 
-    m_udpTask->send(ueId, msg);
+    // Keep the PDU for retransmission without copying it
+    pdu.pdu = std::move(msg.pdu);
 }
 
 void RlsControlTask::handleDownlinkDataDelivery(int ueId, int psi, OctetString &&data)
 {
-    rls::RlsPduTransmission msg{m_sti};
-    msg.pduType = rls::EPduType::DATA;
-    msg.pdu = std::move(data);
-    msg.payload = static_cast<uint32_t>(psi);
-    msg.pduId = 0;
-
-    m_udpTask->send(ueId, msg);
+    sendBatched(ueId, static_cast<uint32_t>(psi), std::move(data));
 }
 
-void RlsControlTask::onAckControlTimerExpired()
+void RlsControlTask::onRetransmissionTimerExpired()
 {
     int64_t current = utils::CurrentTimeMillis();
 
-    std::vector<uint32_t> transmissionFailureIds;
     std::vector<rls::PduInfo> transmissionFailures;
 
-    for (auto &pdu : m_pduMap)
+    for (auto &entry : m_retransmissions.advance(current))
     {
-        auto delta = current - pdu.second.sentTime;
-        if (delta > MAX_PDU_TTL)
+        auto it = m_txWindows.find(entry.endPointId);
+        if (it == m_txWindows.end())
+            continue;
+
+        auto *pdu = it->second.find(entry.id);
+        if (pdu == nullptr)
+            continue; // Already acknowledged
+
+        if (pdu->retransmissions >= MAX_RETRANSMISSION)
         {
-            transmissionFailureIds.push_back(pdu.first);
-            transmissionFailures.push_back(std::move(pdu.second));
+            auto released = it->second.release(entry.id);
+            if (released.has_value())
+                transmissionFailures.push_back(std::move(*released));
+            continue;
         }
-    }
 
-    for (auto id : transmissionFailureIds)
-        m_pduMap.erase(id);
+        pdu->retransmissions++;
+        transmitRrc(*pdu);
+        m_retransmissions.schedule(current, RETRANSMISSION_TIMEOUT, entry);
+    }
 
     if (!transmissionFailures.empty())
     {
@@ -238,23 +286,75 @@ void RlsControlTask::onAckControlTimerExpired()
         w->pduList = std::move(transmissionFailures);
         m_mainTask->push(w);
     }
+
+    if (!m_retransmissions.isEmpty())
+    {
+        m_retransmissionTimerSet = true;
+        setTimer(TIMER_ID_RETRANSMISSION, TIMER_PERIOD_RETRANSMISSION);
+    }
 }
 
 void RlsControlTask::onAckSendTimerExpired()
 {
-    auto copy = m_pendingAck;
+    for (int ueId : m_pendingAck)
+    {
+        auto &window = m_rxWindows[ueId];
+
+        rls::RlsPduTransmissionAck msg{m_sti};
+        msg.cumulativeId = window.cumulativeId();
+        msg.pduIds = window.selectiveIds();
+
+        m_udpTask->send(ueId, msg);
+    }
+
     m_pendingAck.clear();
+}
 
-    for (auto &item : copy)
+void RlsControlTask::sendBatched(int endPointId, uint32_t payload, OctetString &&data)
+{
+    if (!m_batcher.fits(endPointId, data))
     {
-        if (!item.second.empty())
-            continue;
+        flushBatch(endPointId);
 
-        rls::RlsPduTransmissionAck msg{m_sti};
-        msg.pduIds = std::move(item.second);
+        if (!m_batcher.fits(endPointId, data))
+        {
+            // Too large to be batched, send it directly
+            rls::RlsPduTransmission msg{m_sti};
+            msg.pduType = rls::EPduType::DATA;
+            msg.pdu = std::move(data);
+            msg.payload = payload;
+            msg.pduId = 0;
+
+            m_udpTask->send(endPointId, msg);
+            return;
+        }
+    }
+
+    rls::RlsPduItem item{};
+    item.pduType = rls::EPduType::DATA;
+    item.pduId = 0;
+    item.payload = payload;
+    item.pdu = std::move(data);
+    m_batcher.add(endPointId, std::move(item));
 
-        m_udpTask->send(item.first, msg);
+    if (!m_batchTimerSet)
+    {
+        m_batchTimerSet = true;
+        setTimer(TIMER_ID_BATCH_FLUSH, TIMER_PERIOD_BATCH_FLUSH);
     }
 }
 
+void RlsControlTask::flushBatch(int endPointId)
+{
+    auto msg = m_batcher.take(endPointId, m_sti);
+    if (msg != nullptr)
+        m_udpTask->send(endPointId, *msg);
+}
+
+void RlsControlTask::onBatchTimerExpired()
+{
+    for (int endPointId : m_batcher.endPoints())
+        flushBatch(endPointId);
+}
+
 } // namespace nr::gnb
@@ -10,8 +10,13 @@
 
 #include "udp_task.hpp"
 
+#include <unordered_map>
+#include <unordered_set>
+
 #include <gnb/nts.hpp>
 #include <gnb/types.hpp>
+#include <lib/rls/rls_batch.hpp>
+#include <lib/rls/rls_window.hpp>
 #include <utils/nts.hpp>
 
 namespace nr::gnb
@@ -24,8 +29,14 @@ class RlsControlTask : public NtsTask
     uint64_t m_sti;
     NtsTask *m_mainTask;
     RlsUdpTask *m_udpTask;
-    std::unordered_map<uint32_t, rls::PduInfo> m_pduMap;
-    std::unordered_map<int, std::vector<uint32_t>> m_pendingAck;
+    std::unordered_map<int, rls::TxWindow> m_txWindows;
+    std::unordered_map<int, rls::RxWindow> m_rxWindows;
+    std::unordered_set<int> m_pendingAck;
+    rls::RetransmissionWheel m_retransmissions;
+    rls::PduBatcher m_batcher;
+    bool m_ackTimerSet;
+    bool m_retransmissionTimerSet;
+    bool m_batchTimerSet;
 
   public:
     explicit RlsControlTask(TaskBase *base, uint64_t sti);
@@ -43,10 +54,15 @@ class RlsControlTask : public NtsTask
     void handleSignalDetected(int ueId);
     void handleSignalLost(int ueId);
     void handleRlsMessage(int ueId, rls::RlsMessage &msg);
-    void handleDownlinkRrcDelivery(int ueId, uint32_t pduId, rrc::RrcChannel channel, OctetString &&data);
+    void handlePduTransmission(int ueId, rls::EPduType pduType, uint32_t pduId, uint32_t payload, OctetString &&pdu);
+    void handleDownlinkRrcDelivery(int ueId, rrc::RrcChannel channel, OctetString &&data);
     void handleDownlinkDataDelivery(int ueId, int psi, OctetString &&data);
-    void onAckControlTimerExpired();
+    void onRetransmissionTimerExpired();
     void onAckSendTimerExpired();
+    void transmitRrc(rls::PduInfo &pdu);
+    void onBatchTimerExpired();
+    void sendBatched(int endPointId, uint32_t payload, OctetString &&data);
+    void flushBatch(int endPointId);
 };
 
 } // namespace nr::gnb
\ No newline at end of file
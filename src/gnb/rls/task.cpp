@@ -11,6 +11,7 @@
 #include <gnb/gtp/task.hpp>
 #include <gnb/rrc/task.hpp>
 #include <utils/common.hpp>
+#include <utils/nts_trace.hpp>
 
 namespace nr::gnb
 {
@@ -23,6 +24,12 @@ GnbRlsTask::GnbRlsTask(TaskBase *base) : m_base{base}
     m_udpTask = new RlsUdpTask(base, m_sti, base->config->phyLocation);
     m_ctlTask = new RlsControlTask(base, m_sti);
 
+    if (NtsTrace::IsEnabled())
+    {
+        m_udpTask->setTraceName(base->config->name + "/rls-udp");
+        m_ctlTask->setTraceName(base->config->name + "/rls-ctl");
+    }
+
     m_udpTask->initialize(m_ctlTask);
     m_ctlTask->initialize(this, m_udpTask);
 }
@@ -52,7 +59,7 @@ void GnbRlsTask::onLoop()
             break;
         }
         case NmGnbRlsToRls::SIGNAL_LOST: {
-            m_logger->debug("UE[%d] signal lost", w->ueId);
+            m_logger->debug(FMT_STRING("UE[{}] signal lost"), w->ueId);
             break;
         }
         case NmGnbRlsToRls::UPLINK_DATA: {
@@ -72,11 +79,11 @@ void GnbRlsTask::onLoop()
             break;
         }
         case NmGnbRlsToRls::RADIO_LINK_FAILURE: {
-            m_logger->debug("radio link failure [%d]", (int)w->rlfCause);
+            m_logger->debug(FMT_STRING("UE[{}] radio link failure [{}]"), w->ueId, (int)w->rlfCause);
             break;
         }
         case NmGnbRlsToRls::TRANSMISSION_FAILURE: {
-            m_logger->debug("transmission failure [%s]", "");
+            m_logger->debug(FMT_STRING("transmission failure [{}]"), w->pduList.size());
             break;
         }
         default: {
@@ -94,7 +101,6 @@ void GnbRlsTask::onLoop()
             auto *m = new NmGnbRlsToRls(NmGnbRlsToRls::DOWNLINK_RRC);
             m->ueId = w->ueId;
             m->rrcChannel = w->channel;
-            m->pduId = 0;
             m->data = std::move(w->pdu);
             m_ctlTask->push(m);
             break;
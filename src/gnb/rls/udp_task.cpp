@@ -8,10 +8,12 @@
 
 #include "udp_task.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <set>
+#include <vector>
 
 #include <gnb/nts.hpp>
 #include <utils/common.hpp>
@@ -26,33 +28,24 @@ static constexpr const int HEARTBEAT_THRESHOLD = 2000; // (LOOP_PERIOD + RECEIVE
 
 static constexpr const int MIN_ALLOWED_DBM = -120;
 
-static int EstimateSimulatedDbm(const Vector3 &myPos, const Vector3 &uePos)
-{
-    int deltaX = myPos.x - uePos.x;
-    int deltaY = myPos.y - uePos.y;
-    int deltaZ = myPos.z - uePos.z;
-
-    int distance = static_cast<int>(std::sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ));
-    if (distance == 0)
-        return -1; // 0 may be confusing for people
-    return -distance;
-}
-
 namespace nr::gnb
 {
 
 RlsUdpTask::RlsUdpTask(TaskBase *base, uint64_t sti, Vector3 phyLocation)
-    : m_server{}, m_ctlTask{}, m_sti{sti}, m_phyLocation{phyLocation}, m_lastLoop{}, m_stiToUe{}, m_ueMap{}, m_newIdCounter{}
+    : m_transport{}, m_ctlTask{}, m_sti{sti}, m_phyLocation{phyLocation},
+      m_pathLoss{base->config->pathLoss}, m_lastLoop{}, m_stiToUe{}, m_ueMap{}, m_newIdCounter{}
 {
     m_logger = base->logBase->makeUniqueLogger("rls-udp");
 
     try
     {
-        m_server = new udp::UdpServer(base->config->portalIp, cons::PortalPort);
+        m_transport = rls::WithCapture(
+            rls::CreateServerTransport(base->config->rlsTransport, base->config->portalIp, cons::PortalPort),
+            base->captureInterface, InetAddress{base->config->portalIp, cons::PortalPort});
     }
     catch (const LibError &e)
     {
-        m_logger->err("RLS failure [%s]", e.what());
+        m_logger->err(FMT_STRING("RLS failure [{}]"), e.what());
         quit();
         return;
     }
@@ -74,77 +67,192 @@ void RlsUdpTask::onLoop()
     uint8_t buffer[BUFFER_SIZE];
     InetAddress peerAddress;
 
-    int size = m_server->Receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
+    int size = m_transport->receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
     if (size > 0)
     {
-        auto rlsMsg = rls::DecodeRlsMessage(OctetView{buffer, static_cast<size_t>(size)});
-        if (rlsMsg == nullptr)
+        rls::RlsMessageView view{};
+        if (!rls::DecodeRlsMessageView(buffer, static_cast<size_t>(size), view))
             m_logger->err("Unable to decode RLS message");
         else
-            receiveRlsPdu(peerAddress, std::move(rlsMsg));
+            receiveRlsPdu(peerAddress, view, buffer, static_cast<size_t>(size));
     }
 }
 
 void RlsUdpTask::onQuit()
 {
-    delete m_server;
+    m_transport.reset();
 }
 
-void RlsUdpTask::receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg)
+void RlsUdpTask::receiveRlsPdu(const InetAddress &addr, const rls::RlsMessageView &view, const uint8_t *data,
+                               size_t size)
 {
-    if (msg->msgType == rls::EMessageType::HEARTBEAT)
+    if (view.msgType == rls::EMessageType::HEARTBEAT)
     {
-        int dbm = EstimateSimulatedDbm(m_phyLocation, ((const rls::RlsHeartBeat &)*msg).simPos);
+        int dbm = estimateDbm(view.simPos);
         if (dbm < MIN_ALLOWED_DBM)
         {
             // if the simulated signal strength is such low, then ignore this message
             return;
         }
 
-        if (m_stiToUe.count(msg->sti))
-        {
-            int ueId = m_stiToUe[msg->sti];
-            m_ueMap[ueId].address = addr;
-            m_ueMap[ueId].lastSeen = utils::CurrentTimeMillis();
-        }
-        else
-        {
-            int ueId = ++m_newIdCounter;
-
-            m_stiToUe[msg->sti] = ueId;
-            m_ueMap[ueId].address = addr;
-            m_ueMap[ueId].lastSeen = utils::CurrentTimeMillis();
-
-            auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::SIGNAL_DETECTED);
-            w->ueId = ueId;
-            m_ctlTask->push(w);
-        }
+        bool isNew = false;
+        int ueId = updateUe(addr, view.sti, view.features, utils::CurrentTimeMillis(), isNew);
 
         rls::RlsHeartBeatAck ack{m_sti};
         ack.dbm = dbm;
+        ack.features = rls::SUPPORTED_FEATURES;
 
-        sendRlsPdu(addr, ack);
+        sendRlsPdu(m_ueMap[ueId], ack);
+        if (isNew)
+            notifySignalDetected(ueId);
+        return;
+    }
+
+    if (view.msgType == rls::EMessageType::HEARTBEAT_BATCH)
+    {
+        receiveHeartbeatBatch(addr, view);
         return;
     }
 
-    if (!m_stiToUe.count(msg->sti))
+    if (!m_stiToUe.count(view.sti))
     {
         // if no HB received yet, and the message is not HB, then ignore the message
         return;
     }
 
+    std::unique_ptr<rls::RlsMessage> msg;
+    if (view.msgType == rls::EMessageType::PDU_TRANSMISSION)
+    {
+        auto m = std::make_unique<rls::RlsPduTransmission>(view.sti);
+        m->pduType = view.pduType;
+        m->pduId = view.pduId;
+        m->payload = view.payload;
+        m->pdu = OctetString::FromArray(view.pdu, view.pduLength);
+        msg = std::move(m);
+    }
+    else
+    {
+        msg = rls::DecodeRlsMessage(OctetView{data, size});
+        if (msg == nullptr)
+        {
+            m_logger->err("Unable to decode RLS message");
+            return;
+        }
+    }
+
     auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::RECEIVE_RLS_MESSAGE);
-    w->ueId = m_stiToUe[msg->sti];
+    w->ueId = m_stiToUe[view.sti];
     w->msg = std::move(msg);
     m_ctlTask->push(w);
 }
 
-void RlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg)
+void RlsUdpTask::receiveHeartbeatBatch(const InetAddress &addr, const rls::RlsMessageView &view)
 {
+    int64_t time = utils::CurrentTimeMillis();
+
+    // All the UEs of the batch are answered with a single message
+    rls::RlsHeartBeatAckBatch ack{m_sti};
+    ack.features = rls::SUPPORTED_FEATURES;
+    ack.items.reserve(view.itemCount);
+    std::vector<int> newUes{};
+
+    for (size_t i = 0; i < view.itemCount; i++)
+    {
+        auto item = rls::GetHeartBeatItem(view, i);
+
+        int dbm = estimateDbm(item.simPos);
+        if (dbm < MIN_ALLOWED_DBM)
+            continue;
+
+        bool isNew = false;
+        int ueId = updateUe(addr, item.sti, view.features, time, isNew);
+        if (isNew)
+            newUes.push_back(ueId);
+        ack.items.push_back({item.sti, dbm});
+    }
+
+    if (ack.items.empty())
+        return;
+
     OctetString stream;
+    rls::EncodeRlsMessage(ack, stream);
+
+    m_transport->send(addr, stream.data(), static_cast<size_t>(stream.length()));
+
+    for (int ueId : newUes)
+        notifySignalDetected(ueId);
+}
+
+int RlsUdpTask::estimateDbm(const Vector3 &simPos) const
+{
+    // 0 may be confusing for people, so the strongest reported value is -1
+    return std::min(-1, static_cast<int>(std::lround(m_pathLoss.rxPower(m_phyLocation, simPos))));
+}
+
+int RlsUdpTask::updateUe(const InetAddress &addr, uint64_t sti, uint8_t features, int64_t time, bool &outIsNew)
+{
+    auto it = m_stiToUe.find(sti);
+    outIsNew = it == m_stiToUe.end();
+    if (!outIsNew)
+    {
+        auto &ue = m_ueMap[it->second];
+        ue.address = addr;
+        ue.lastSeen = time;
+        ue.features = features;
+        return it->second;
+    }
+
+    int ueId = ++m_newIdCounter;
+    m_stiToUe[sti] = ueId;
+
+    auto &ue = m_ueMap[ueId];
+    ue.sti = sti;
+    ue.address = addr;
+    ue.lastSeen = time;
+    ue.features = features;
+    return ueId;
+}
+
+void RlsUdpTask::notifySignalDetected(int ueId)
+{
+    // After the heartbeat ACK is sent, because the system information broadcast it triggers is sent by another task.
+    // The UE drops the messages of a cell which has not acknowledged its heartbeat yet.
+    auto *w = new NmGnbRlsToRls(NmGnbRlsToRls::SIGNAL_DETECTED);
+    w->ueId = ueId;
+    m_ctlTask->push(w);
+}
+
+void RlsUdpTask::sendRlsPdu(const UeInfo &ue, const rls::RlsMessage &msg)
+{
+    // UEs sharing a socket can only tell from the envelope whom the message is for
+    size_t envelopeSize = (ue.features & rls::FEATURE_ENVELOPE) ? rls::ENVELOPE_HEADER_SIZE : 0;
+
+    if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION)
+    {
+        auto &m = (const rls::RlsPduTransmission &)msg;
+
+        // Only the header is encoded, the PDU is sent from where it is
+        uint8_t header[rls::ENVELOPE_HEADER_SIZE + rls::PDU_TRANSMISSION_HEADER_SIZE];
+        if (envelopeSize > 0)
+            rls::EncodeEnvelopeHeader(ue.sti, header);
+        rls::EncodePduTransmissionHeader(m.sti, m.pduType, m.pduId, m.payload, static_cast<size_t>(m.pdu.length()),
+                                         header + envelopeSize);
+
+        m_transport->send(ue.address, header, envelopeSize + rls::PDU_TRANSMISSION_HEADER_SIZE, m.pdu.data(),
+                          static_cast<size_t>(m.pdu.length()));
+        return;
+    }
+
+    OctetString stream;
+    if (envelopeSize > 0)
+    {
+        uint8_t envelope[rls::ENVELOPE_HEADER_SIZE];
+        rls::EncodeEnvelopeHeader(ue.sti, envelope);
+        stream.append(OctetString::FromArray(envelope, sizeof(envelope)));
+    }
     rls::EncodeRlsMessage(msg, stream);
 
-    m_server->Send(addr, stream.data(), static_cast<size_t>(stream.length()));
+    m_transport->send(ue.address, stream.data(), static_cast<size_t>(stream.length()));
 }
 
 void RlsUdpTask::heartbeatCycle(int64_t time)
@@ -195,7 +303,24 @@ void RlsUdpTask::send(int ueId, const rls::RlsMessage &msg)
         return;
     }
 
-    sendRlsPdu(m_ueMap[ueId].address, msg);
+    auto &ue = m_ueMap[ueId];
+
+    if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION_BATCH && !(ue.features & rls::FEATURE_PDU_BATCH))
+    {
+        // The UE does not support batching, send the PDUs one by one
+        for (auto &item : ((const rls::RlsPduTransmissionBatch &)msg).items)
+        {
+            rls::RlsPduTransmission m{msg.sti};
+            m.pduType = item.pduType;
+            m.pduId = item.pduId;
+            m.payload = item.payload;
+            m.pdu = item.pdu.copy();
+            sendRlsPdu(ue, m);
+        }
+        return;
+    }
+
+    sendRlsPdu(ue, msg);
 }
 
 } // namespace nr::gnb
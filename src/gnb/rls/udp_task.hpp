@@ -13,8 +13,9 @@
 #include <vector>
 
 #include <gnb/types.hpp>
+#include <lib/radio/path_loss.hpp>
 #include <lib/rls/rls_pdu.hpp>
-#include <lib/udp/server.hpp>
+#include <lib/rls/rls_transport.hpp>
 #include <utils/nts.hpp>
 
 namespace nr::gnb
@@ -28,14 +29,16 @@ class RlsUdpTask : public NtsTask
         uint64_t sti{};
         InetAddress address;
         int64_t lastSeen{};
+        uint8_t features{};
     };
 
   private:
     std::unique_ptr<Logger> m_logger;
-    udp::UdpServer *m_server;
+    std::unique_ptr<rls::RlsTransport> m_transport;
     NtsTask *m_ctlTask;
     uint64_t m_sti;
     Vector3 m_phyLocation;
+    radio::PathLossModel m_pathLoss;
     int64_t m_lastLoop;
     std::unordered_map<uint64_t, int> m_stiToUe;
     std::unordered_map<int, UeInfo> m_ueMap;
@@ -51,8 +54,13 @@ class RlsUdpTask : public NtsTask
     void onQuit() override;
 
   private:
-    void receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg);
-    void sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg);
+    void receiveRlsPdu(const InetAddress &addr, const rls::RlsMessageView &view, const uint8_t *data, size_t size);
+    void receiveHeartbeatBatch(const InetAddress &addr, const rls::RlsMessageView &view);
+    int estimateDbm(const Vector3 &simPos) const;
+    /* Returns the UE ID, and whether the UE is new, i.e. its signal is to be notified once it is acknowledged */
+    int updateUe(const InetAddress &addr, uint64_t sti, uint8_t features, int64_t time, bool &outIsNew);
+    void notifySignalDetected(int ueId);
+    void sendRlsPdu(const UeInfo &ue, const rls::RlsMessage &msg);
     void heartbeatCycle(int64_t time);
 
   public:
@@ -64,7 +64,7 @@ void GnbRrcTask::receiveRrcSetupRequest(int ueId, const ASN_RRC_RRCSetupRequest
     int64_t initialRandomId = asn::GetBitStringLong<39>(msg.rrcSetupRequest.ue_Identity.choice.randomValue);
     if (tryFindByInitialRandomId(initialRandomId) != nullptr)
     {
-        m_logger->err("Initial random ID conflict [%ld], discarding RRC Setup Request", initialRandomId);
+        m_logger->err(FMT_STRING("Initial random ID conflict [{}], discarding RRC Setup Request"), initialRandomId);
         return;
     }
 
@@ -88,7 +88,7 @@ void GnbRrcTask::receiveRrcSetupRequest(int ueId, const ASN_RRC_RRCSetupRequest
     asn::SetOctetString(rrcSetupIEs->masterCellGroup,
                         rrc::encode::EncodeS(asn_DEF_ASN_RRC_CellGroupConfig, &masterCellGroup));
 
-    m_logger->info("RRC Setup for UE[%d]", ueId);
+    m_logger->info(FMT_STRING("RRC Setup for UE[{}]"), ueId);
     sendRrcMessage(ueId, pdu);
 }
 
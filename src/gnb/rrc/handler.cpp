@@ -74,7 +74,7 @@ void GnbRrcTask::receiveUplinkInformationTransfer(int ueId, const ASN_RRC_ULInfo
 
 void GnbRrcTask::releaseConnection(int ueId)
 {
-    m_logger->info("Releasing RRC connection for UE[%d]", ueId);
+    m_logger->info(FMT_STRING("Releasing RRC connection for UE[{}]"), ueId);
 
     // Send RRC Release message
     auto *pdu = asn::New<ASN_RRC_DL_DCCH_Message>();
@@ -19,7 +19,7 @@ void GnbRrcTask::handleRlsSapMessage(NmGnbRlsToRrc &msg)
     switch (msg.present)
     {
     case NmGnbRlsToRrc::SIGNAL_DETECTED: {
-        m_logger->debug("UE[%d] new signal detected", msg.ueId);
+        m_logger->debug(FMT_STRING("UE[{}] new signal detected"), msg.ueId);
         triggerSysInfoBroadcast();
         break;
     }
@@ -33,7 +33,7 @@ RrcUeContext *GnbRrcTask::findUe(int id)
     auto *ue = tryFindUe(id);
     if (ue == nullptr)
     {
-        m_logger->err("UE context with ID[%d] not found", id);
+        m_logger->err(FMT_STRING("UE context with ID[{}] not found"), id);
         return ue;
     }
     return ue;
@@ -46,9 +46,12 @@ class SctpHandler : public sctp::ISctpHandler
   private:
     SctpTask *const sctpTask;
     int clientId;
+    CapturePoint capture;
+    InetAddress remoteAddress;
 
   public:
-    SctpHandler(SctpTask *const sctpTask, int clientId) : sctpTask(sctpTask), clientId(clientId)
+    SctpHandler(SctpTask *const sctpTask, int clientId, const CapturePoint &capture, const InetAddress &remoteAddress)
+        : sctpTask(sctpTask), clientId(clientId), capture(capture), remoteAddress(remoteAddress)
     {
     }
 
@@ -72,6 +75,8 @@ class SctpHandler : public sctp::ISctpHandler
 
     void onMessage(const uint8_t *buffer, size_t length, uint16_t stream) override
     {
+        PacketCapture::Record(capture, CaptureDirection::INBOUND, remoteAddress, buffer, length, stream);
+
         auto *data = new uint8_t[length];
         std::memcpy(data, buffer, length);
 
@@ -188,7 +193,7 @@ void SctpTask::receiveSctpConnectionSetupRequest(int clientId, const std::string
                                                  const std::string &remoteAddress, uint16_t remotePort,
                                                  sctp::PayloadProtocolId ppid, NtsTask *associatedTask)
 {
-    m_logger->info("Trying to establish SCTP connection... (%s:%d)", remoteAddress.c_str(), remotePort);
+    m_logger->info(FMT_STRING("Trying to establish SCTP connection... ({}:{})"), remoteAddress.c_str(), remotePort);
 
     auto *client = new sctp::SctpClient(ppid);
 
@@ -198,7 +203,7 @@ void SctpTask::receiveSctpConnectionSetupRequest(int clientId, const std::string
     }
     catch (const sctp::SctpError &exc)
     {
-        m_logger->err("Binding to %s:%d failed. %s", localAddress.c_str(), localPort, exc.what());
+        m_logger->err(FMT_STRING("Binding to {}:{} failed. {}"), localAddress.c_str(), localPort, exc.what());
         delete client;
         return;
     }
@@ -209,14 +214,24 @@ void SctpTask::receiveSctpConnectionSetupRequest(int clientId, const std::string
     }
     catch (const sctp::SctpError &exc)
     {
-        m_logger->err("Connecting to %s:%d failed. %s", remoteAddress.c_str(), remotePort, exc.what());
+        m_logger->err(FMT_STRING("Connecting to {}:{} failed. {}"), remoteAddress.c_str(), remotePort, exc.what());
         delete client;
         return;
     }
 
-    m_logger->info("SCTP connection established (%s:%d)", remoteAddress.c_str(), remotePort);
+    m_logger->info(FMT_STRING("SCTP connection established ({}:{})"), remoteAddress.c_str(), remotePort);
+
+    CapturePoint capture{};
+    InetAddress remote{};
+    if (PacketCapture::IsEnabled())
+    {
+        capture.interface = m_base->captureInterface;
+        capture.protocol = CaptureProtocol::NGAP;
+        capture.local = CaptureAddress{InetAddress{localAddress, localPort}};
+        remote = InetAddress{remoteAddress, remotePort};
+    }
 
-    sctp::ISctpHandler *handler = new SctpHandler(this, clientId);
+    sctp::ISctpHandler *handler = new SctpHandler(this, clientId, capture, remote);
 
     auto *entry = new ClientEntry;
     m_clients[clientId] = entry;
@@ -225,6 +240,8 @@ void SctpTask::receiveSctpConnectionSetupRequest(int clientId, const std::string
     entry->client = client;
     entry->handler = handler;
     entry->associatedTask = associatedTask;
+    entry->capture = capture;
+    entry->remoteAddress = remote;
     entry->receiverThread = new ScopedThread(
         [](void *arg) { ReceiverThread(reinterpret_cast<std::pair<sctp::SctpClient *, sctp::ISctpHandler *> *>(arg)); },
         new std::pair<sctp::SctpClient *, sctp::ISctpHandler *>(client, handler));
@@ -232,12 +249,12 @@ void SctpTask::receiveSctpConnectionSetupRequest(int clientId, const std::string
 
 void SctpTask::receiveAssociationSetup(int clientId, int associationId, int inStreams, int outStreams)
 {
-    m_logger->debug("SCTP association setup ascId[%d]", associationId);
+    m_logger->debug(FMT_STRING("SCTP association setup ascId[{}]"), associationId);
 
     ClientEntry *entry = m_clients[clientId];
     if (entry == nullptr)
     {
-        m_logger->warn("Client entry not found for id: %d", clientId);
+        m_logger->warn(FMT_STRING("Client entry not found for id: {}"), clientId);
         return;
     }
 
@@ -252,12 +269,12 @@ void SctpTask::receiveAssociationSetup(int clientId, int associationId, int inSt
 
 void SctpTask::receiveAssociationShutdown(int clientId)
 {
-    m_logger->debug("SCTP association shutdown (clientId: %d)", clientId);
+    m_logger->debug(FMT_STRING("SCTP association shutdown (clientId: {})"), clientId);
 
     ClientEntry *entry = m_clients[clientId];
     if (entry == nullptr)
     {
-        m_logger->warn("Client entry not found for id: %d", clientId);
+        m_logger->warn(FMT_STRING("Client entry not found for id: {}"), clientId);
         return;
     }
 
@@ -272,7 +289,7 @@ void SctpTask::receiveClientReceive(int clientId, uint16_t stream, UniqueBuffer
     ClientEntry *entry = m_clients[clientId];
     if (entry == nullptr)
     {
-        m_logger->warn("Client entry not found for id: %d", clientId);
+        m_logger->warn(FMT_STRING("Client entry not found for id: {}"), clientId);
         return;
     }
 
@@ -298,7 +315,7 @@ void SctpTask::receiveConnectionClose(int clientId)
     ClientEntry *entry = m_clients[clientId];
     if (entry == nullptr)
     {
-        m_logger->warn("Client entry not found for id: %d", clientId);
+        m_logger->warn(FMT_STRING("Client entry not found for id: {}"), clientId);
         return;
     }
 
@@ -310,7 +327,7 @@ void SctpTask::receiveSendMessage(int clientId, uint16_t stream, UniqueBuffer &&
     ClientEntry *entry = m_clients[clientId];
     if (entry == nullptr)
     {
-        m_logger->warn("Client entry not found for id: %d", clientId);
+        m_logger->warn(FMT_STRING("Client entry not found for id: {}"), clientId);
         return;
     }
 
@@ -323,6 +340,8 @@ void SctpTask::receiveSendMessage(int clientId, uint16_t stream, UniqueBuffer &&
         receiveClientReceive(clientId, 0, copy, data.length());
     }
 #else
+    PacketCapture::Record(entry->capture, CaptureDirection::OUTBOUND, entry->remoteAddress, buffer.data(),
+                          buffer.size(), stream);
     entry->client->send(stream, buffer.data(), 0, buffer.size());
 #endif
 }
@@ -17,6 +17,7 @@
 #include <lib/sctp/sctp.hpp>
 #include <utils/logger.hpp>
 #include <utils/nts.hpp>
+#include <utils/packet_capture.hpp>
 #include <utils/scoped_thread.hpp>
 
 namespace nr::gnb
@@ -32,6 +33,8 @@ class SctpTask : public NtsTask
         ScopedThread *receiverThread;
         sctp::ISctpHandler *handler;
         NtsTask *associatedTask;
+        CapturePoint capture;
+        InetAddress remoteAddress;
     };
 
   private:
@@ -8,8 +8,13 @@
 
 #pragma once
 
+#include <map>
+#include <vector>
+
 #include <lib/app/monitor.hpp>
 #include <lib/asn/utils.hpp>
+#include <lib/radio/path_loss.hpp>
+#include <lib/rls/rls_transport.hpp>
 #include <utils/common_types.hpp>
 #include <utils/logger.hpp>
 #include <utils/network.hpp>
@@ -17,6 +22,7 @@
 #include <utils/octet_string.hpp>
 
 #include <asn/ngap/ASN_NGAP_QosFlowSetupRequestList.h>
+#include <asn/ngap/ASN_NGAP_UESecurityCapabilities.h>
 #include <asn/rrc/ASN_RRC_InitialUE-Identity.h>
 
 namespace nr::gnb
@@ -122,6 +128,13 @@ struct AggregateMaximumBitRate
     uint64_t ulAmbr{};
 };
 
+/* What the NGAP task keeps of a PDU session resource, the GTP task owns the resource itself */
+struct NgapPduSession
+{
+    uint32_t downlinkTeid{};
+    std::vector<int> qosFlowIds{};
+};
+
 struct NgapUeContext
 {
     const int ctxId{};
@@ -132,6 +145,8 @@ struct NgapUeContext
     int uplinkStream{};
     int downlinkStream{};
     AggregateMaximumBitRate ueAmbr{};
+    asn::Unique<ASN_NGAP_UESecurityCapabilities> securityCapabilities{}; // From the initial context setup
+    std::map<int, NgapPduSession> pduSessions{};                         // By PSI, to request the path switch
 
     explicit NgapUeContext(int ctxId) : ctxId(ctxId)
     {
@@ -309,11 +324,13 @@ struct GnbConfig
     std::string gtpIp{};
     std::optional<std::string> gtpAdvertiseIp{};
     bool ignoreStreamIds{};
+    rls::ETransportType rlsTransport{};
+    radio::PathLossConfig pathLoss{};
 
     /* Assigned by program */
     std::string name{};
     EPagingDrx pagingDrx{};
-    Vector3 phyLocation{};
+    Vector3 phyLocation{}; // Read from config file if present
 
     [[nodiscard]] inline uint32_t getGnbId() const
     {
@@ -332,6 +349,7 @@ struct TaskBase
     LogBase *logBase{};
     app::INodeListener *nodeListener{};
     NtsTask *cliCallbackTask{};
+    uint32_t captureInterface{};
 
     GnbAppTask *appTask{};
     GtpTask *gtpTask{};
@@ -152,6 +152,8 @@ static OrderedMap<std::string, CmdEntry> g_gnbCmdEntries = {
     {"ue-list", {"List all UEs associated with the gNB", "", DefaultDesc, false}},
     {"ue-count", {"Print the total number of UEs connected the this gNB", "", DefaultDesc, false}},
     {"ue-release", {"Request a UE context release for the given UE", "<ue-id>", DefaultDesc, false}},
+    {"path-switch", {"Request a path switch for the given UE or for all UEs, as the target gNB of an Xn handover",
+                     "[ue-id]", DefaultDesc, false}},
     {"handover", {"Perform handover for the given UE", "<ue-id>", DefaultDesc, false}}, // Pradnya
     {"handover-prepare", {"Prepare for handover for the given UE", "<ue-id>", DefaultDesc, false}},
 };
@@ -162,6 +164,11 @@ static OrderedMap<std::string, CmdEntry> g_ueCmdEntries = {
     {"timers", {"Dump current status of the timers in the UE", "", DefaultDesc, false}},
     {"rls-state", {"Show status information about RLS", "", DefaultDesc, false}},
     {"coverage", {"Dump available cells and PLMNs in the coverage", "", DefaultDesc, false}},
+    {"latency", {"Show procedure latencies of the UE and percentiles of all UEs in the process", "", DefaultDesc,
+                 false}},
+    {"memory", {"Show C++ heap usage of the UE and of all UEs in the process by subsystem", "", DefaultDesc, false}},
+    {"traffic", {"Show synthetic traffic of the PDU sessions of the UE and totals of all UEs in the process", "",
+                 DefaultDesc, false}},
     {"ps-establish",
      {"Trigger a PDU session establishment procedure", "<session-type> [options]", DescForPsEstablish, true}},
     {"ps-list", {"List all PDU sessions", "", DefaultDesc, false}},
@@ -218,6 +225,19 @@ static std::unique_ptr<GnbCliCommand> GnbCliParseImpl(const std::string &subCmd,
             CMD_ERR("Invalid UE ID")
         return cmd;
     }
+    else if (subCmd == "path-switch")
+    {
+        auto cmd = std::make_unique<GnbCliCommand>(GnbCliCommand::PATH_SWITCH);
+        if (options.positionalCount() > 1)
+            CMD_ERR("At most one UE ID is expected")
+        if (options.positionalCount() == 1)
+        {
+            cmd->ueId = utils::ParseInt(options.getPositional(0));
+            if (cmd->ueId <= 0)
+                CMD_ERR("Invalid UE ID")
+        }
+        return cmd;
+    }
     // Pradnya
     else if (subCmd == "handover-prepare")
     {
@@ -352,6 +372,18 @@ static std::unique_ptr<UeCliCommand> UeCliParseImpl(const std::string &subCmd, c
     {
         return std::make_unique<UeCliCommand>(UeCliCommand::COVERAGE);
     }
+    else if (subCmd == "latency")
+    {
+        return std::make_unique<UeCliCommand>(UeCliCommand::LATENCY);
+    }
+    else if (subCmd == "memory")
+    {
+        return std::make_unique<UeCliCommand>(UeCliCommand::MEMORY);
+    }
+    else if (subCmd == "traffic")
+    {
+        return std::make_unique<UeCliCommand>(UeCliCommand::TRAFFIC);
+    }
 
     return nullptr;
 }
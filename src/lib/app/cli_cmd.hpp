@@ -29,6 +29,7 @@ struct GnbCliCommand
         UE_LIST,
         UE_COUNT,
         UE_RELEASE_REQ,
+        PATH_SWITCH,
         HANDOVERPREPARE,  //Pradnya
         HANDOVER,        
     } present;
@@ -36,7 +37,7 @@ struct GnbCliCommand
     // AMF_INFO
     int amfId{};
 
-    // UE_RELEASE_REQ
+    // UE_RELEASE_REQ, PATH_SWITCH (zero for all UEs)
     int ueId{};
 
     // Pradnya
@@ -69,6 +70,9 @@ struct UeCliCommand
         DE_REGISTER,
         RLS_STATE,
         COVERAGE,
+        LATENCY,
+        MEMORY,
+        TRAFFIC,
     } present;
 
     // DE_REGISTER
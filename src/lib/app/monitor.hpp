@@ -36,7 +36,8 @@ enum class StateType
     RM,
     CM,
     U5,
-    RRC
+    RRC,
+    PS
 };
 
 class INodeListener
@@ -0,0 +1,423 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "aes.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define AES_NI_AVAILABLE
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+static constexpr const int ROUNDS = 10;
+static constexpr const int BLOCK_SIZE = 16;
+static constexpr const int CTR_LANES = 8; // Independent blocks in flight, to hide the latency of the AES-NI rounds
+
+static constexpr const uint8_t SBOX[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76, 0xca, 0x82, 0xc9,
+    0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, 0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f,
+    0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15, 0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07,
+    0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75, 0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3,
+    0x29, 0xe3, 0x2f, 0x84, 0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58,
+    0xcf, 0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8, 0x51, 0xa3,
+    0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, 0xcd, 0x0c, 0x13, 0xec, 0x5f,
+    0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73, 0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+    0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb, 0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac,
+    0x62, 0x91, 0x95, 0xe4, 0x79, 0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a,
+    0xae, 0x08, 0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a, 0x70,
+    0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, 0xe1, 0xf8, 0x98, 0x11,
+    0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf, 0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42,
+    0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
+
+static constexpr const uint8_t RCON[ROUNDS] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+
+struct RoundTable
+{
+    uint32_t value[256];
+};
+
+static constexpr uint8_t XTime(uint8_t x)
+{
+    return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+/* SubBytes and MixColumns of one byte of a column, the other rows are the rotations of it */
+static constexpr RoundTable MakeRoundTable()
+{
+    RoundTable table{};
+    for (int i = 0; i < 256; i++)
+    {
+        uint8_t s = SBOX[i];
+        uint8_t s2 = XTime(s);
+        table.value[i] = static_cast<uint32_t>(s2) << 24 | static_cast<uint32_t>(s) << 16 |
+                         static_cast<uint32_t>(s) << 8 | static_cast<uint32_t>(s2 ^ s);
+    }
+    return table;
+}
+
+static constexpr const RoundTable TE = MakeRoundTable();
+
+static inline uint32_t Rotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t Read4(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 |
+           static_cast<uint32_t>(p[3]);
+}
+
+static inline void Write4(uint8_t *p, uint32_t value)
+{
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+static inline uint64_t Read8(const uint8_t *p)
+{
+    return static_cast<uint64_t>(Read4(p)) << 32 | Read4(p + 4);
+}
+
+static inline void Write8(uint8_t *p, uint64_t value)
+{
+    Write4(p, static_cast<uint32_t>(value >> 32));
+    Write4(p + 4, static_cast<uint32_t>(value));
+}
+
+static inline uint32_t SubWord(uint32_t w)
+{
+    return static_cast<uint32_t>(SBOX[w >> 24]) << 24 | static_cast<uint32_t>(SBOX[(w >> 16) & 0xff]) << 16 |
+           static_cast<uint32_t>(SBOX[(w >> 8) & 0xff]) << 8 | static_cast<uint32_t>(SBOX[w & 0xff]);
+}
+
+static inline uint32_t RoundColumn(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    return TE.value[a >> 24] ^ Rotr(TE.value[(b >> 16) & 0xff], 8) ^ Rotr(TE.value[(c >> 8) & 0xff], 16) ^
+           Rotr(TE.value[d & 0xff], 24);
+}
+
+static inline uint32_t LastRoundColumn(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    return static_cast<uint32_t>(SBOX[a >> 24]) << 24 | static_cast<uint32_t>(SBOX[(b >> 16) & 0xff]) << 16 |
+           static_cast<uint32_t>(SBOX[(c >> 8) & 0xff]) << 8 | static_cast<uint32_t>(SBOX[d & 0xff]);
+}
+
+static void EncryptBlockPortable(const uint32_t *rk, const uint8_t *in, uint8_t *out)
+{
+    uint32_t s0 = Read4(in) ^ rk[0];
+    uint32_t s1 = Read4(in + 4) ^ rk[1];
+    uint32_t s2 = Read4(in + 8) ^ rk[2];
+    uint32_t s3 = Read4(in + 12) ^ rk[3];
+
+    for (int round = 1; round < ROUNDS; round++)
+    {
+        const uint32_t *k = rk + round * 4;
+        uint32_t t0 = RoundColumn(s0, s1, s2, s3) ^ k[0];
+        uint32_t t1 = RoundColumn(s1, s2, s3, s0) ^ k[1];
+        uint32_t t2 = RoundColumn(s2, s3, s0, s1) ^ k[2];
+        uint32_t t3 = RoundColumn(s3, s0, s1, s2) ^ k[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    const uint32_t *k = rk + ROUNDS * 4;
+    Write4(out, LastRoundColumn(s0, s1, s2, s3) ^ k[0]);
+    Write4(out + 4, LastRoundColumn(s1, s2, s3, s0) ^ k[1]);
+    Write4(out + 8, LastRoundColumn(s2, s3, s0, s1) ^ k[2]);
+    Write4(out + 12, LastRoundColumn(s3, s0, s1, s2) ^ k[3]);
+}
+
+static void CtrPortable(const uint32_t *rk, const uint8_t *iv, uint8_t *buffer, size_t length)
+{
+    uint8_t block[BLOCK_SIZE];
+    uint8_t keystream[BLOCK_SIZE];
+    std::memcpy(block, iv, BLOCK_SIZE);
+    uint64_t counter = Read8(iv + 8);
+
+    for (size_t offset = 0; offset < length; offset += BLOCK_SIZE)
+    {
+        Write8(block + 8, counter++);
+        EncryptBlockPortable(rk, block, keystream);
+
+        size_t size = length - offset < BLOCK_SIZE ? length - offset : BLOCK_SIZE;
+        for (size_t i = 0; i < size; i++)
+            buffer[offset + i] ^= keystream[i];
+    }
+}
+
+static void CbcMacPortable(const uint32_t *rk, uint8_t *state, const uint8_t *data, size_t blocks)
+{
+    for (size_t i = 0; i < blocks; i++)
+    {
+        for (int j = 0; j < BLOCK_SIZE; j++)
+            state[j] ^= data[i * BLOCK_SIZE + j];
+        EncryptBlockPortable(rk, state, state);
+    }
+}
+
+#ifdef AES_NI_AVAILABLE
+
+#define AES_NI_TARGET __attribute__((target("aes,sse2")))
+
+AES_NI_TARGET static inline __m128i EncryptAesNi(const __m128i *keys, __m128i block)
+{
+    block = _mm_xor_si128(block, keys[0]);
+    for (int round = 1; round < ROUNDS; round++)
+        block = _mm_aesenc_si128(block, keys[round]);
+    return _mm_aesenclast_si128(block, keys[ROUNDS]);
+}
+
+AES_NI_TARGET static inline void LoadKeys(const uint8_t *roundKeys, __m128i *keys)
+{
+    for (int i = 0; i <= ROUNDS; i++)
+        keys[i] = _mm_load_si128(reinterpret_cast<const __m128i *>(roundKeys + i * BLOCK_SIZE));
+}
+
+AES_NI_TARGET static inline __m128i CounterBlock(uint64_t upper, uint64_t counter)
+{
+    return _mm_set_epi64x(static_cast<long long>(__builtin_bswap64(counter)), static_cast<long long>(upper));
+}
+
+AES_NI_TARGET static void EncryptBlockAesNi(const uint8_t *roundKeys, const uint8_t *in, uint8_t *out)
+{
+    __m128i keys[ROUNDS + 1];
+    LoadKeys(roundKeys, keys);
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), EncryptAesNi(keys, block));
+}
+
+AES_NI_TARGET static void CtrAesNi(const uint8_t *roundKeys, const uint8_t *iv, uint8_t *buffer, size_t length)
+{
+    __m128i keys[ROUNDS + 1];
+    LoadKeys(roundKeys, keys);
+
+    // The upper half of the counter block is constant, the lower half is a big endian counter
+    uint64_t upper;
+    std::memcpy(&upper, iv, 8);
+    uint64_t counter = Read8(iv + 8);
+
+    size_t offset = 0;
+    while (length - offset >= CTR_LANES * BLOCK_SIZE)
+    {
+        __m128i blocks[CTR_LANES];
+        for (int i = 0; i < CTR_LANES; i++)
+            blocks[i] = _mm_xor_si128(CounterBlock(upper, counter + i), keys[0]);
+        for (int round = 1; round < ROUNDS; round++)
+            for (int i = 0; i < CTR_LANES; i++)
+                blocks[i] = _mm_aesenc_si128(blocks[i], keys[round]);
+        for (int i = 0; i < CTR_LANES; i++)
+        {
+            auto *p = reinterpret_cast<__m128i *>(buffer + offset + i * BLOCK_SIZE);
+            __m128i keystream = _mm_aesenclast_si128(blocks[i], keys[ROUNDS]);
+            _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), keystream));
+        }
+        counter += CTR_LANES;
+        offset += CTR_LANES * BLOCK_SIZE;
+    }
+
+    while (length - offset >= BLOCK_SIZE)
+    {
+        auto *p = reinterpret_cast<__m128i *>(buffer + offset);
+        __m128i keystream = EncryptAesNi(keys, CounterBlock(upper, counter++));
+        _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), keystream));
+        offset += BLOCK_SIZE;
+    }
+
+    if (offset < length)
+    {
+        uint8_t keystream[BLOCK_SIZE];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(keystream), EncryptAesNi(keys, CounterBlock(upper, counter)));
+        for (size_t i = 0; offset + i < length; i++)
+            buffer[offset + i] ^= keystream[i];
+    }
+}
+
+AES_NI_TARGET static void CbcMacAesNi(const uint8_t *roundKeys, uint8_t *state, const uint8_t *data, size_t blocks)
+{
+    __m128i keys[ROUNDS + 1];
+    LoadKeys(roundKeys, keys);
+
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state));
+    for (size_t i = 0; i < blocks; i++)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * BLOCK_SIZE));
+        x = EncryptAesNi(keys, _mm_xor_si128(x, block));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(state), x);
+}
+
+static bool DetectAesNi()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes");
+}
+
+#else
+
+static bool DetectAesNi()
+{
+    return false;
+}
+
+#endif
+
+static bool g_portableForced = false;
+
+static bool HasAesNi()
+{
+    static const bool detected = DetectAesNi();
+    return detected && !g_portableForced;
+}
+
+static void EncryptBlock(const uint8_t *roundKeys, const uint32_t *roundWords, const uint8_t *in, uint8_t *out)
+{
+#ifdef AES_NI_AVAILABLE
+    if (HasAesNi())
+    {
+        EncryptBlockAesNi(roundKeys, in, out);
+        return;
+    }
+#endif
+    EncryptBlockPortable(roundWords, in, out);
+}
+
+static void CbcMac(const uint8_t *roundKeys, const uint32_t *roundWords, uint8_t *state, const uint8_t *data,
+                   size_t blocks)
+{
+#ifdef AES_NI_AVAILABLE
+    if (HasAesNi())
+    {
+        CbcMacAesNi(roundKeys, state, data, blocks);
+        return;
+    }
+#endif
+    CbcMacPortable(roundWords, state, data, blocks);
+}
+
+/* Doubling in GF(2^128) for the CMAC subkeys */
+static void Double(const uint8_t *in, uint8_t *out)
+{
+    uint8_t carry = 0;
+    for (int i = BLOCK_SIZE - 1; i >= 0; i--)
+    {
+        uint8_t next = in[i] >> 7;
+        out[i] = static_cast<uint8_t>((in[i] << 1) | carry);
+        carry = next;
+    }
+    if (carry)
+        out[BLOCK_SIZE - 1] ^= 0x87;
+}
+
+namespace crypto
+{
+
+AesKey::AesKey() : m_roundKeys{}, m_roundWords{}, m_k1{}, m_k2{}
+{
+}
+
+AesKey::AesKey(const uint8_t *key) : AesKey()
+{
+    for (int i = 0; i < 4; i++)
+        m_roundWords[i] = Read4(key + i * 4);
+    for (int i = 4; i < 4 * (ROUNDS + 1); i++)
+    {
+        uint32_t temp = m_roundWords[i - 1];
+        if (i % 4 == 0)
+            temp = SubWord(Rotr(temp, 24)) ^ static_cast<uint32_t>(RCON[i / 4 - 1]) << 24;
+        m_roundWords[i] = m_roundWords[i - 4] ^ temp;
+    }
+    for (int i = 0; i < 4 * (ROUNDS + 1); i++)
+        Write4(m_roundKeys + i * 4, m_roundWords[i]);
+
+    uint8_t zero[BLOCK_SIZE] = {0};
+    uint8_t l[BLOCK_SIZE];
+    encryptBlock(zero, l);
+    Double(l, m_k1);
+    Double(m_k1, m_k2);
+}
+
+void AesKey::encryptBlock(const uint8_t *in, uint8_t *out) const
+{
+    EncryptBlock(m_roundKeys, m_roundWords, in, out);
+}
+
+void AesKey::ctr(const uint8_t *iv, uint8_t *buffer, size_t length) const
+{
+#ifdef AES_NI_AVAILABLE
+    if (HasAesNi())
+    {
+        CtrAesNi(m_roundKeys, iv, buffer, length);
+        return;
+    }
+#endif
+    CtrPortable(m_roundWords, iv, buffer, length);
+}
+
+void AesKey::cmac(const uint8_t *message, size_t length, uint8_t *mac) const
+{
+    // All blocks but the last one are chained as they are, the last one is masked with a subkey (RFC 4493)
+    size_t blocks = length == 0 ? 1 : (length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    bool complete = length != 0 && length % BLOCK_SIZE == 0;
+
+    uint8_t state[BLOCK_SIZE] = {0};
+    CbcMac(m_roundKeys, m_roundWords, state, message, blocks - 1);
+
+    uint8_t last[BLOCK_SIZE] = {0};
+    size_t lastOffset = (blocks - 1) * BLOCK_SIZE;
+    size_t lastSize = length - lastOffset;
+    if (lastSize > 0)
+        std::memcpy(last, message + lastOffset, lastSize);
+    if (!complete)
+        last[lastSize] = 0x80;
+
+    const uint8_t *subkey = complete ? m_k1 : m_k2;
+    for (int i = 0; i < BLOCK_SIZE; i++)
+        last[i] ^= subkey[i];
+
+    CbcMac(m_roundKeys, m_roundWords, state, last, 1);
+    std::memcpy(mac, state, BLOCK_SIZE);
+}
+
+AesKeyCache::AesKeyCache() : m_key{}, m_schedule{}
+{
+}
+
+const AesKey &AesKeyCache::get(const OctetString &key)
+{
+    assert(key.length() == 16);
+
+    if (m_schedule != nullptr && std::memcmp(m_key, key.data(), sizeof(m_key)) == 0)
+        return *m_schedule;
+
+    std::memcpy(m_key, key.data(), sizeof(m_key));
+    if (m_schedule == nullptr)
+        m_schedule = std::make_unique<AesKey>(key.data());
+    else
+        *m_schedule = AesKey{key.data()};
+    return *m_schedule;
+}
+
+const char *AesBackend()
+{
+    return HasAesNi() ? "aes-ni" : "portable";
+}
+
+void ForcePortableAes()
+{
+    g_portableForced = true;
+}
+
+} // namespace crypto
@@ -0,0 +1,67 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <utils/octet_string.hpp>
+
+namespace crypto
+{
+
+/* An AES-128 key with its expanded key schedule and CMAC subkeys, so that they are computed once per key instead of
+ * once per message. The rounds run on AES-NI if the CPU has it, on a portable table based implementation otherwise. */
+class AesKey
+{
+  private:
+    alignas(16) uint8_t m_roundKeys[176];
+    uint32_t m_roundWords[44];
+    uint8_t m_k1[16];
+    uint8_t m_k2[16];
+
+  public:
+    AesKey();
+    explicit AesKey(const uint8_t *key);
+
+  public:
+    void encryptBlock(const uint8_t *in, uint8_t *out) const;
+
+    /* XORs the keystream of the counter mode into the buffer, the counter being the least significant 64 bits of the
+     * initial counter block as in EEA2 */
+    void ctr(const uint8_t *iv, uint8_t *buffer, size_t length) const;
+
+    void cmac(const uint8_t *message, size_t length, uint8_t *mac) const;
+};
+
+/* Keeps the schedule of the last key it was given, to be kept next to a key which rarely changes like the NAS keys of
+ * a security context. The key is compared on each use, so the owner does not need to invalidate it. The schedule is
+ * allocated on the first use, hence a context which never protects a message costs only the key and a pointer. */
+class AesKeyCache
+{
+  private:
+    uint8_t m_key[16];
+    std::unique_ptr<AesKey> m_schedule;
+
+  public:
+    AesKeyCache();
+
+  public:
+    const AesKey &get(const OctetString &key);
+};
+
+/* Name of the AES implementation in use, "aes-ni" or "portable" */
+const char *AesBackend();
+
+/* Makes all keys use the portable implementation from now on, so that it can be tested on a CPU with AES-NI. Not to
+ * be called while keys are in use on other threads. */
+void ForcePortableAes();
+
+} // namespace crypto
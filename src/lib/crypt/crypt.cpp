@@ -140,17 +140,39 @@ uint32_t ComputeMacEia1(uint32_t count, int bearer, int direction, const OctetSt
     return ComputeMacUia2(key.data(), count, fresh, direction, message.data(), message.length());
 }
 
+/* Schedule of the last key used by the callers which do not keep one */
+static const AesKey &ScheduleOf(const OctetString &key)
+{
+    static thread_local AesKeyCache cache{};
+    return cache.get(key);
+}
+
 void EncryptEea2(uint32_t count, int bearer, int direction, OctetString &message, const OctetString &key)
 {
-    eea2::Encrypt(count, bearer, direction, message, key);
+    eea2::Encrypt(count, bearer, direction, message, ScheduleOf(key));
 }
 
 void DecryptEea2(uint32_t count, int bearer, int direction, OctetString &message, const OctetString &key)
 {
-    eea2::Decrypt(count, bearer, direction, message, key);
+    eea2::Decrypt(count, bearer, direction, message, ScheduleOf(key));
 }
 
 uint32_t ComputeMacEia2(uint32_t count, int bearer, int direction, const OctetString &message, const OctetString &key)
+{
+    return eia2::Compute(count, bearer, direction, message, ScheduleOf(key));
+}
+
+void EncryptEea2(uint32_t count, int bearer, int direction, OctetString &message, const AesKey &key)
+{
+    eea2::Encrypt(count, bearer, direction, message, key);
+}
+
+void DecryptEea2(uint32_t count, int bearer, int direction, OctetString &message, const AesKey &key)
+{
+    eea2::Decrypt(count, bearer, direction, message, key);
+}
+
+uint32_t ComputeMacEia2(uint32_t count, int bearer, int direction, const OctetString &message, const AesKey &key)
 {
     return eia2::Compute(count, bearer, direction, message, key);
 }
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "aes.hpp"
+
 #include <utils/octet_string.hpp>
 
 namespace crypto
@@ -39,6 +41,11 @@ void EncryptEea2(uint32_t count, int bearer, int direction, OctetString &message
 void DecryptEea2(uint32_t count, int bearer, int direction, OctetString &message, const OctetString &key);
 uint32_t ComputeMacEia2(uint32_t count, int bearer, int direction, const OctetString &message, const OctetString &key);
 
+/* EEA2 and EIA2 with a key schedule kept by the caller, e.g. in a NAS security context */
+void EncryptEea2(uint32_t count, int bearer, int direction, OctetString &message, const AesKey &key);
+void DecryptEea2(uint32_t count, int bearer, int direction, OctetString &message, const AesKey &key);
+uint32_t ComputeMacEia2(uint32_t count, int bearer, int direction, const OctetString &message, const AesKey &key);
+
 /* EEA3 and EIA3 */
 void EncryptEea3(uint32_t count, int bearer, int direction, OctetString &message, const OctetString &key);
 void DecryptEea3(uint32_t count, int bearer, int direction, OctetString &message, const OctetString &key);
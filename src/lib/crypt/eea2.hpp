@@ -8,12 +8,14 @@
 
 #pragma once
 
+#include "aes.hpp"
+
 #include <utils/octet_string.hpp>
 
 namespace crypto::eea2
 {
 
-void Encrypt(uint32_t count, int bearer, int direction, OctetString &message, const OctetString &key);
-void Decrypt(uint32_t count, int bearer, int direction, OctetString &message, const OctetString &key);
+void Encrypt(uint32_t count, int bearer, int direction, OctetString &message, const AesKey &key);
+void Decrypt(uint32_t count, int bearer, int direction, OctetString &message, const AesKey &key);
 
 } // namespace crypt::eea2
\ No newline at end of file
@@ -7,31 +7,35 @@
 //
 
 #include "eia2.hpp"
-#include "mac.hpp"
+
+#include <cstring>
+#include <vector>
 
 #include <utils/bits.hpp>
 
-static OctetString GenerateMacInput(uint32_t count, int bearer, int direction, const OctetString &message)
+/* The header and the message, allocated once as the message may be as large as a user plane packet */
+static std::vector<uint8_t> GenerateMacInput(uint32_t count, int bearer, int direction, const OctetString &message)
 {
-    OctetString m{};
-    m.appendOctet4(count);
-    m.appendOctet(bits::Ranged8({{5, bearer}, {1, direction}, {2, 0}}));
-    m.appendOctet3(0);
-    m.append(message);
+    std::vector<uint8_t> m(8 + message.length());
+    m[0] = static_cast<uint8_t>(count >> 24);
+    m[1] = static_cast<uint8_t>(count >> 16);
+    m[2] = static_cast<uint8_t>(count >> 8);
+    m[3] = static_cast<uint8_t>(count);
+    m[4] = bits::Ranged8({{5, bearer}, {1, direction}, {2, 0}});
+    if (message.length() > 0)
+        std::memcpy(m.data() + 8, message.data(), message.length());
     return m;
 }
 
 namespace crypto::eia2
 {
 
-uint32_t Compute(uint32_t count, int bearer, int direction, const OctetString &message, const OctetString &key)
+uint32_t Compute(uint32_t count, int bearer, int direction, const OctetString &message, const AesKey &key)
 {
-    assert(key.length() == 16);
-
     auto macInput = GenerateMacInput(count, bearer, direction, message);
 
     uint8_t buf[16] = {0};
-    AesCmac(buf, key.data(), macInput.data(), macInput.length());
+    key.cmac(macInput.data(), macInput.size(), buf);
 
     return (uint32_t)octet4{buf[0], buf[1], buf[2], buf[3]};
 }
@@ -8,11 +8,13 @@
 
 #pragma once
 
+#include "aes.hpp"
+
 #include <utils/octet_string.hpp>
 
 namespace crypto::eia2
 {
 
-uint32_t Compute(uint32_t count, int bearer, int direction, const OctetString &message, const OctetString &key);
+uint32_t Compute(uint32_t count, int bearer, int direction, const OctetString &message, const AesKey &key);
 
 } // namespace crypt::eia2
\ No newline at end of file
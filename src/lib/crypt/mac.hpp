@@ -16,6 +16,4 @@ namespace crypto
 
 void HmacSha256(uint8_t out[32], const uint8_t *data, size_t dataLen, const uint8_t *key, size_t keyLen);
 
-void AesCmac(uint8_t *cmac, const uint8_t *key, const uint8_t *msg, uint32_t len);
-
 }
\ No newline at end of file
@@ -0,0 +1,288 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "environment.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static constexpr const float LN2 = 0.693147180559945f;
+static constexpr const float LN10 = 2.302585092994046f;
+
+// Same margin is used when deciding whether shadowing can still lift a cell above the threshold
+static constexpr const float SHADOWING_MARGIN = 3.0f;
+
+// Natural logarithm for x >= 1: exponent from the float bits, and ln(m) = 2 atanh((m - 1) / (m + 1)) for the mantissa.
+// The error is below 2e-5, far less than the precision the dBm values are reported with.
+static inline float FastLog(float x)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    auto exponent = static_cast<int>(bits >> 23) - 127;
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+
+    float t = (m - 1.0f) / (m + 1.0f);
+    float t2 = t * t;
+    float p = ((1.0f / 7.0f * t2 + 1.0f / 5.0f) * t2 + 1.0f / 3.0f) * t2 + 1.0f;
+    return static_cast<float>(exponent) * LN2 + 2.0f * t * p;
+}
+
+#if defined(__SSE2__)
+static inline __m128 FastLog4(__m128 x)
+{
+    __m128i bits = _mm_castps_si128(x);
+    __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+    __m128 m = _mm_castsi128_ps(
+        _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.0f / 7.0f), t2), _mm_set1_ps(1.0f / 5.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1.0f / 3.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), one);
+
+    __m128 lnm = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(2.0f), t), p);
+    return _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(exponent), _mm_set1_ps(LN2)), lnm);
+}
+#endif
+
+namespace radio
+{
+
+void ComputeRxPowers(float ueX, float ueY, float ueZ, const float *cellX, const float *cellY, const float *cellZ,
+                     const float *cellBase, const float *cellSlope, size_t count, float *outDbm)
+{
+    // rxPower = base - 10 n log10(d) = base - (5 n / ln 10) ln(d^2), with d at least 1 meter
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    __m128 ux = _mm_set1_ps(ueX);
+    __m128 uy = _mm_set1_ps(ueY);
+    __m128 uz = _mm_set1_ps(ueZ);
+    __m128 one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(cellX + i), ux);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(cellY + i), uy);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(cellZ + i), uz);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        d2 = _mm_max_ps(d2, one);
+
+        __m128 loss = _mm_mul_ps(_mm_loadu_ps(cellSlope + i), FastLog4(d2));
+        _mm_storeu_ps(outDbm + i, _mm_sub_ps(_mm_loadu_ps(cellBase + i), loss));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        float dx = cellX[i] - ueX;
+        float dy = cellY[i] - ueY;
+        float dz = cellZ[i] - ueZ;
+        float d2 = std::max(1.0f, dx * dx + dy * dy + dz * dz);
+        outDbm[i] = cellBase[i] - cellSlope[i] * FastLog(d2);
+    }
+}
+
+RadioEnvironment::RadioEnvironment(float minDbm)
+    : m_range{1.0f}, m_minDbm{minDbm}, m_cellModels{}, m_cellPositions{}, m_cellsDirty{}, m_cellX{}, m_cellY{},
+      m_cellZ{}, m_cellBase{}, m_cellSlope{}, m_cellShadowing{}, m_cellIndex{}, m_buckets{}, m_uePositions{},
+      m_measurements{}, m_ueOffsets{}, m_scratch{}
+{
+}
+
+int RadioEnvironment::addCell(const Vector3 &position, const PathLossConfig &config)
+{
+    m_cellModels.emplace_back(config);
+    m_cellPositions.push_back(position);
+    m_cellsDirty = true;
+    return static_cast<int>(m_cellModels.size()) - 1;
+}
+
+void RadioEnvironment::moveCell(int cell, const Vector3 &position)
+{
+    m_cellPositions[cell] = position;
+    m_cellsDirty = true;
+}
+
+size_t RadioEnvironment::cellCount() const
+{
+    return m_cellModels.size();
+}
+
+float RadioEnvironment::range()
+{
+    if (m_cellsDirty)
+        rebuildGrid();
+    return m_range;
+}
+
+void RadioEnvironment::setUeCount(size_t count)
+{
+    m_uePositions.resize(count);
+}
+
+void RadioEnvironment::setUePosition(int ue, const Vector3 &position)
+{
+    m_uePositions[ue] = position;
+}
+
+size_t RadioEnvironment::ueCount() const
+{
+    return m_uePositions.size();
+}
+
+int64_t RadioEnvironment::bucketKey(int bx, int by) const
+{
+    return (static_cast<int64_t>(bx) << 32) | static_cast<uint32_t>(by);
+}
+
+void RadioEnvironment::rebuildGrid()
+{
+    m_cellsDirty = false;
+
+    // The bucket size is the distance at which the strongest cell falls below the threshold
+    m_range = 1.0f;
+    for (auto &model : m_cellModels)
+    {
+        auto &c = model.config();
+        float budget = model.referencePower() + SHADOWING_MARGIN * c.shadowingStdDev - m_minDbm;
+        if (budget > 0 && c.exponent > 0)
+            m_range = std::max(m_range, std::pow(10.0f, budget / (10.0f * c.exponent)));
+    }
+
+    auto bucketOf = [this](const Vector3 &p) {
+        return bucketKey(static_cast<int>(std::floor(p.x / m_range)), static_cast<int>(std::floor(p.y / m_range)));
+    };
+
+    std::vector<int> order(m_cellModels.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return bucketOf(m_cellPositions[a]) < bucketOf(m_cellPositions[b]); });
+
+    m_cellX.clear();
+    m_cellY.clear();
+    m_cellZ.clear();
+    m_cellBase.clear();
+    m_cellSlope.clear();
+    m_cellShadowing.clear();
+    m_cellIndex.clear();
+    m_buckets.clear();
+
+    for (int cell : order)
+    {
+        auto &pos = m_cellPositions[cell];
+        auto &model = m_cellModels[cell];
+
+        auto &bucket = m_buckets[bucketOf(pos)];
+        if (bucket.begin == bucket.end)
+            bucket.begin = m_cellIndex.size();
+        bucket.end = m_cellIndex.size() + 1;
+
+        m_cellX.push_back(static_cast<float>(pos.x));
+        m_cellY.push_back(static_cast<float>(pos.y));
+        m_cellZ.push_back(static_cast<float>(pos.z));
+        m_cellBase.push_back(model.referencePower());
+        m_cellSlope.push_back(5.0f * model.config().exponent / LN10);
+        m_cellShadowing.push_back(model.config().shadowingStdDev);
+        m_cellIndex.push_back(cell);
+    }
+
+    m_scratch.resize(m_cellIndex.size());
+}
+
+void RadioEnvironment::update()
+{
+    if (m_cellsDirty)
+        rebuildGrid();
+
+    m_measurements.clear();
+    m_ueOffsets.resize(m_uePositions.size() + 1);
+
+    for (size_t ue = 0; ue < m_uePositions.size(); ue++)
+    {
+        m_ueOffsets[ue] = m_measurements.size();
+
+        auto &pos = m_uePositions[ue];
+
+        // Cells usually share the decorrelation distance, so the grid point is reused across them
+        ShadowingPoint shadowingPoint{};
+        float shadowingDistance = -1.0f;
+
+        int bx = static_cast<int>(std::floor(pos.x / m_range));
+        int by = static_cast<int>(std::floor(pos.y / m_range));
+
+        for (int i = -1; i <= 1; i++)
+        {
+            for (int j = -1; j <= 1; j++)
+            {
+                auto it = m_buckets.find(bucketKey(bx + i, by + j));
+                if (it == m_buckets.end())
+                    continue;
+
+                size_t begin = it->second.begin;
+                size_t count = it->second.end - begin;
+
+                ComputeRxPowers(static_cast<float>(pos.x), static_cast<float>(pos.y), static_cast<float>(pos.z),
+                                m_cellX.data() + begin, m_cellY.data() + begin, m_cellZ.data() + begin,
+                                m_cellBase.data() + begin, m_cellSlope.data() + begin, count, m_scratch.data());
+
+                for (size_t k = 0; k < count; k++)
+                {
+                    float dbm = m_scratch[k];
+                    float sigma = m_cellShadowing[begin + k];
+                    if (dbm + SHADOWING_MARGIN * sigma < m_minDbm)
+                        continue;
+
+                    int cell = m_cellIndex[begin + k];
+                    if (sigma > 0)
+                    {
+                        auto &model = m_cellModels[cell];
+                        if (model.config().decorrelationDistance != shadowingDistance)
+                        {
+                            shadowingDistance = model.config().decorrelationDistance;
+                            shadowingPoint = MakeShadowingPoint(pos, shadowingDistance);
+                        }
+                        dbm += model.shadowing(shadowingPoint);
+                    }
+                    if (dbm >= m_minDbm)
+                        m_measurements.push_back({static_cast<int>(ue), cell, dbm});
+                }
+            }
+        }
+    }
+
+    m_ueOffsets[m_uePositions.size()] = m_measurements.size();
+}
+
+const std::vector<RadioEnvironment::Measurement> &RadioEnvironment::measurements() const
+{
+    return m_measurements;
+}
+
+const RadioEnvironment::Measurement *RadioEnvironment::ueMeasurements(int ue, size_t &outCount) const
+{
+    if (ue < 0 || static_cast<size_t>(ue) + 1 >= m_ueOffsets.size())
+    {
+        outCount = 0;
+        return nullptr;
+    }
+    outCount = m_ueOffsets[ue + 1] - m_ueOffsets[ue];
+    return m_measurements.data() + m_ueOffsets[ue];
+}
+
+} // namespace radio
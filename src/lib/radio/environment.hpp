@@ -0,0 +1,95 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "path_loss.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/common_types.hpp>
+
+namespace radio
+{
+
+/* Computes the received power of many UEs from many cells in one pass. Cells are bucketed into a uniform grid whose
+ * bucket size is the largest distance at which any cell can still be above the minimum dBm, so only the 3x3 buckets
+ * around a UE are looked at. Cells of a bucket are kept in contiguous arrays and the path loss against them is
+ * computed with SIMD. */
+class RadioEnvironment
+{
+  public:
+    struct Measurement
+    {
+        int ue{};
+        int cell{};
+        float dbm{};
+    };
+
+  private:
+    struct Bucket
+    {
+        size_t begin{};
+        size_t end{};
+    };
+
+  private:
+    float m_range;
+    float m_minDbm;
+
+    std::vector<PathLossModel> m_cellModels;
+    std::vector<Vector3> m_cellPositions;
+    bool m_cellsDirty;
+
+    /* Cells sorted by bucket, structure of arrays */
+    std::vector<float> m_cellX;
+    std::vector<float> m_cellY;
+    std::vector<float> m_cellZ;
+    std::vector<float> m_cellBase;
+    std::vector<float> m_cellSlope;
+    std::vector<float> m_cellShadowing;
+    std::vector<int> m_cellIndex;
+    std::unordered_map<int64_t, Bucket> m_buckets;
+
+    std::vector<Vector3> m_uePositions;
+    std::vector<Measurement> m_measurements;
+    std::vector<size_t> m_ueOffsets;
+    std::vector<float> m_scratch;
+
+  public:
+    explicit RadioEnvironment(float minDbm);
+
+  public:
+    int addCell(const Vector3 &position, const PathLossConfig &config);
+    void moveCell(int cell, const Vector3 &position);
+    [[nodiscard]] size_t cellCount() const;
+    [[nodiscard]] float range();
+
+    void setUeCount(size_t count);
+    void setUePosition(int ue, const Vector3 &position);
+    [[nodiscard]] size_t ueCount() const;
+
+    // Recomputes all measurements from the current positions
+    void update();
+
+    // Measurements above the minimum dBm, ordered by UE
+    [[nodiscard]] const std::vector<Measurement> &measurements() const;
+    [[nodiscard]] const Measurement *ueMeasurements(int ue, size_t &outCount) const;
+
+  private:
+    void rebuildGrid();
+    [[nodiscard]] int64_t bucketKey(int bx, int by) const;
+};
+
+// Received power of one UE from count cells given as arrays. Exposed for benchmarking
+void ComputeRxPowers(float ueX, float ueY, float ueZ, const float *cellX, const float *cellY, const float *cellZ,
+                     const float *cellBase, const float *cellSlope, size_t count, float *outDbm);
+
+} // namespace radio
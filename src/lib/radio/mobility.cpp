@@ -0,0 +1,230 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "mobility.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+static Vector3 Interpolate(const Vector3 &from, const Vector3 &to, double ratio)
+{
+    return Vector3{static_cast<int>(std::lround(from.x + (to.x - from.x) * ratio)),
+                   static_cast<int>(std::lround(from.y + (to.y - from.y) * ratio)),
+                   static_cast<int>(std::lround(from.z + (to.z - from.z) * ratio))};
+}
+
+static double Distance(const Vector3 &a, const Vector3 &b)
+{
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    double dz = a.z - b.z;
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+namespace radio
+{
+
+class StaticMobility : public MobilityModel
+{
+  private:
+    Vector3 m_position;
+
+  public:
+    explicit StaticMobility(const Vector3 &position) : m_position{position}
+    {
+    }
+
+    Vector3 positionAt(int64_t time) override
+    {
+        return m_position;
+    }
+};
+
+/* Follows timed points, used both for routes and for replayed traces */
+class PolylineMobility : public MobilityModel
+{
+  private:
+    std::vector<TracePoint> m_points;
+    bool m_loop;
+
+  public:
+    PolylineMobility(std::vector<TracePoint> &&points, bool loop) : m_points{std::move(points)}, m_loop{loop}
+    {
+    }
+
+    Vector3 positionAt(int64_t time) override
+    {
+        if (m_points.empty())
+            return Vector3{};
+
+        int64_t duration = m_points.back().time;
+        if (duration <= 0 || time <= 0)
+            return m_points.front().position;
+
+        if (m_loop)
+            time %= duration;
+        else if (time >= duration)
+            return m_points.back().position;
+
+        auto it = std::upper_bound(m_points.begin(), m_points.end(), time,
+                                   [](int64_t t, const TracePoint &p) { return t < p.time; });
+        auto &to = *it;
+        auto &from = *(it - 1);
+
+        double ratio = static_cast<double>(time - from.time) / static_cast<double>(to.time - from.time);
+        return Interpolate(from.position, to.position, ratio);
+    }
+};
+
+class RandomWaypointMobility : public MobilityModel
+{
+  private:
+    MobilityConfig m_config;
+    std::mt19937_64 m_random;
+    Vector3 m_from;
+    Vector3 m_to;
+    int64_t m_departTime;
+    int64_t m_arriveTime;
+
+  public:
+    explicit RandomWaypointMobility(const MobilityConfig &config)
+        : m_config{config}, m_random{config.seed}, m_from{config.position}, m_to{config.position}, m_departTime{},
+          m_arriveTime{}
+    {
+        nextWaypoint(0);
+    }
+
+    Vector3 positionAt(int64_t time) override
+    {
+        while (time >= m_arriveTime + m_config.pauseTime)
+        {
+            m_from = m_to;
+            nextWaypoint(m_arriveTime + m_config.pauseTime);
+        }
+
+        if (time <= m_departTime)
+            return m_from;
+        if (time >= m_arriveTime)
+            return m_to;
+
+        double ratio = static_cast<double>(time - m_departTime) / static_cast<double>(m_arriveTime - m_departTime);
+        return Interpolate(m_from, m_to, ratio);
+    }
+
+  private:
+    int uniformInt(int a, int b)
+    {
+        return std::uniform_int_distribution<int>{std::min(a, b), std::max(a, b)}(m_random);
+    }
+
+    void nextWaypoint(int64_t departTime)
+    {
+        m_to = Vector3{uniformInt(m_config.areaMin.x, m_config.areaMax.x),
+                       uniformInt(m_config.areaMin.y, m_config.areaMax.y),
+                       uniformInt(m_config.areaMin.z, m_config.areaMax.z)};
+
+        float minSpeed = std::max(0.1f, std::min(m_config.minSpeed, m_config.maxSpeed));
+        float maxSpeed = std::max(minSpeed, m_config.maxSpeed);
+        double speed = std::uniform_real_distribution<double>{minSpeed, maxSpeed}(m_random);
+
+        m_departTime = departTime;
+        // At least one millisecond, so that the loop in positionAt always makes progress
+        m_arriveTime = departTime + std::max<int64_t>(1, std::llround(Distance(m_from, m_to) / speed * 1000.0));
+    }
+};
+
+std::unique_ptr<MobilityModel> CreateMobilityModel(const MobilityConfig &config)
+{
+    switch (config.model)
+    {
+    case EMobilityModel::RANDOM_WAYPOINT:
+        return std::make_unique<RandomWaypointMobility>(config);
+    case EMobilityModel::ROUTE: {
+        std::vector<TracePoint> points{};
+        double time = 0;
+        for (size_t i = 0; i < config.waypoints.size(); i++)
+        {
+            if (i > 0)
+                time += Distance(config.waypoints[i - 1], config.waypoints[i]) / config.speed * 1000.0;
+            points.push_back({std::llround(time), config.waypoints[i]});
+        }
+        if (config.loop && config.waypoints.size() > 1)
+        {
+            time += Distance(config.waypoints.back(), config.waypoints.front()) / config.speed * 1000.0;
+            points.push_back({std::llround(time), config.waypoints.front()});
+        }
+        return std::make_unique<PolylineMobility>(std::move(points), config.loop);
+    }
+    case EMobilityModel::TRACE: {
+        auto points = config.trace;
+        return std::make_unique<PolylineMobility>(std::move(points), config.loop);
+    }
+    default:
+        return std::make_unique<StaticMobility>(config.position);
+    }
+}
+
+std::vector<TracePoint> LoadMobilityTrace(const std::string &file)
+{
+    std::ifstream stream{file};
+    if (!stream)
+        throw std::runtime_error("Mobility trace file could not be opened: " + file);
+
+    std::vector<TracePoint> res{};
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(stream, line))
+    {
+        lineNumber++;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream ss{line};
+
+        TracePoint p{};
+        if (!(ss >> p.time >> p.position.x >> p.position.y >> p.position.z))
+            throw std::runtime_error("Invalid mobility trace line " + std::to_string(lineNumber) + " in " + file);
+        if (!res.empty() && p.time <= res.back().time)
+            throw std::runtime_error("Mobility trace times must be increasing, see line " +
+                                     std::to_string(lineNumber) + " in " + file);
+        res.push_back(p);
+    }
+
+    if (res.empty())
+        throw std::runtime_error("Mobility trace is empty: " + file);
+
+    // Times are relative to the first point
+    int64_t start = res.front().time;
+    for (auto &p : res)
+        p.time -= start;
+
+    return res;
+}
+
+bool ParseMobilityModel(const std::string &value, EMobilityModel &outModel)
+{
+    if (value == "static")
+        outModel = EMobilityModel::STATIC;
+    else if (value == "randomWaypoint")
+        outModel = EMobilityModel::RANDOM_WAYPOINT;
+    else if (value == "route")
+        outModel = EMobilityModel::ROUTE;
+    else if (value == "trace")
+        outModel = EMobilityModel::TRACE;
+    else
+        return false;
+    return true;
+}
+
+} // namespace radio
@@ -0,0 +1,74 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <utils/common_types.hpp>
+
+namespace radio
+{
+
+enum class EMobilityModel
+{
+    STATIC,
+    RANDOM_WAYPOINT,
+    ROUTE,
+    TRACE,
+};
+
+struct TracePoint
+{
+    int64_t time{}; // milliseconds since the start of the movement
+    Vector3 position{};
+};
+
+struct MobilityConfig
+{
+    EMobilityModel model{};
+    Vector3 position{}; // Fixed position, or the starting point of the random waypoint model
+
+    /* Random waypoint */
+    Vector3 areaMin{};
+    Vector3 areaMax{};
+    float minSpeed = 1.0f;  // m/s
+    float maxSpeed = 10.0f; // m/s
+    int pauseTime{};        // ms
+    uint64_t seed{};
+
+    /* Route */
+    std::vector<Vector3> waypoints{};
+    float speed = 10.0f; // m/s
+
+    /* Trace */
+    std::vector<TracePoint> trace{};
+
+    bool loop{}; // Route and trace start over at the end
+};
+
+class MobilityModel
+{
+  public:
+    virtual ~MobilityModel() = default;
+
+    // Time is in milliseconds since the start of the movement, and never goes backwards
+    virtual Vector3 positionAt(int64_t time) = 0;
+};
+
+std::unique_ptr<MobilityModel> CreateMobilityModel(const MobilityConfig &config);
+
+// Reads "time,x,y,z" lines, time in milliseconds. Throws std::runtime_error on malformed input
+std::vector<TracePoint> LoadMobilityTrace(const std::string &file);
+
+bool ParseMobilityModel(const std::string &value, EMobilityModel &outModel);
+
+} // namespace radio
@@ -0,0 +1,114 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "path_loss.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static uint64_t SplitMix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Approximately standard normal value which only depends on the seed and the grid point. The sum of four uniform
+// values (Irwin-Hall) is close enough for shadowing, and avoids transcendental functions in the hot path.
+static float GridGaussian(uint64_t seedHash, uint64_t gridHash)
+{
+    // Both inputs are already well mixed, a single multiply is enough to combine them
+    uint64_t h = (seedHash ^ gridHash) * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 29;
+    // Summing as integer first keeps the float conversion to a single cheap signed one
+    auto sum = static_cast<int32_t>((h & 0xFFFF) + ((h >> 16) & 0xFFFF) + ((h >> 32) & 0xFFFF) + (h >> 48));
+    // Each term has mean 0.5 and variance 1/12 after scaling to [0, 1)
+    return (static_cast<float>(sum) / 65536.0f - 2.0f) * 1.7320508f;
+}
+
+static uint64_t GridHash(int64_t i, int64_t j)
+{
+    return SplitMix64(static_cast<uint64_t>(i) ^ SplitMix64(static_cast<uint64_t>(j)));
+}
+
+namespace radio
+{
+
+PathLossModel::PathLossModel() : PathLossModel(PathLossConfig{})
+{
+}
+
+PathLossModel::PathLossModel(const PathLossConfig &config) : m_config{config}, m_seedHash{SplitMix64(config.seed)}
+{
+    // Free space path loss at 1 meter, frequency in MHz
+    m_referenceLoss = 20.0f * std::log10(m_config.frequency) - 27.55f;
+}
+
+float PathLossModel::rxPower(const Vector3 &cellPos, const Vector3 &uePos) const
+{
+    auto dx = static_cast<float>(cellPos.x - uePos.x);
+    auto dy = static_cast<float>(cellPos.y - uePos.y);
+    auto dz = static_cast<float>(cellPos.z - uePos.z);
+
+    float distance = std::max(1.0f, std::sqrt(dx * dx + dy * dy + dz * dz));
+    return referencePower() - 10.0f * m_config.exponent * std::log10(distance) + shadowing(uePos);
+}
+
+float PathLossModel::shadowing(const Vector3 &uePos) const
+{
+    if (m_config.shadowingStdDev <= 0.0f)
+        return 0.0f;
+    return shadowing(MakeShadowingPoint(uePos, m_config.decorrelationDistance));
+}
+
+float PathLossModel::shadowing(const ShadowingPoint &point) const
+{
+    if (m_config.shadowingStdDev <= 0.0f)
+        return 0.0f;
+
+    float v00 = GridGaussian(m_seedHash, point.corners[0]);
+    float v10 = GridGaussian(m_seedHash, point.corners[1]);
+    float v01 = GridGaussian(m_seedHash, point.corners[2]);
+    float v11 = GridGaussian(m_seedHash, point.corners[3]);
+
+    // Interpolating between grid points gives a spatially correlated field
+    float fx = point.fx;
+    float fy = point.fy;
+    float v = (v00 * (1 - fx) + v10 * fx) * (1 - fy) + (v01 * (1 - fx) + v11 * fx) * fy;
+    return v * m_config.shadowingStdDev;
+}
+
+float PathLossModel::referencePower() const
+{
+    return m_config.txPower - m_referenceLoss;
+}
+
+const PathLossConfig &PathLossModel::config() const
+{
+    return m_config;
+}
+
+ShadowingPoint MakeShadowingPoint(const Vector3 &uePos, float decorrelationDistance)
+{
+    double gx = uePos.x / static_cast<double>(decorrelationDistance);
+    double gy = uePos.y / static_cast<double>(decorrelationDistance);
+    auto i = static_cast<int64_t>(std::floor(gx));
+    auto j = static_cast<int64_t>(std::floor(gy));
+
+    ShadowingPoint point{};
+    point.corners[0] = GridHash(i, j);
+    point.corners[1] = GridHash(i + 1, j);
+    point.corners[2] = GridHash(i, j + 1);
+    point.corners[3] = GridHash(i + 1, j + 1);
+    point.fx = static_cast<float>(gx - static_cast<double>(i));
+    point.fy = static_cast<float>(gy - static_cast<double>(j));
+    return point;
+}
+
+} // namespace radio
@@ -0,0 +1,62 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstdint>
+
+#include <utils/common_types.hpp>
+
+namespace radio
+{
+
+struct PathLossConfig
+{
+    float txPower = 43.0f;               // dBm
+    float frequency = 3500.0f;           // MHz
+    float exponent = 3.5f;               // 2 is free space
+    float shadowingStdDev = 0.0f;        // dB, zero disables shadowing
+    float decorrelationDistance = 50.0f; // meters
+    uint64_t seed{};
+};
+
+/* Position of a UE on the shadowing grid. It does not depend on the cell, so it is computed once per UE when many
+ * cells are evaluated */
+struct ShadowingPoint
+{
+    uint64_t corners[4];
+    float fx;
+    float fy;
+};
+
+ShadowingPoint MakeShadowingPoint(const Vector3 &uePos, float decorrelationDistance);
+
+/* Log-distance path loss anchored at the free space loss at 1 meter, with optional log-normal shadowing. Shadowing is
+ * a deterministic function of the UE position, so a UE standing still sees a stable signal. */
+class PathLossModel
+{
+  private:
+    PathLossConfig m_config;
+    float m_referenceLoss;
+    uint64_t m_seedHash;
+
+  public:
+    PathLossModel();
+    explicit PathLossModel(const PathLossConfig &config);
+
+  public:
+    [[nodiscard]] float rxPower(const Vector3 &cellPos, const Vector3 &uePos) const;
+    [[nodiscard]] float shadowing(const Vector3 &uePos) const;
+    [[nodiscard]] float shadowing(const ShadowingPoint &point) const;
+
+    // Received power at 1 meter without shadowing
+    [[nodiscard]] float referencePower() const;
+    [[nodiscard]] const PathLossConfig &config() const;
+};
+
+} // namespace radio
@@ -0,0 +1,82 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "rls_batch.hpp"
+
+// Path MTU of an Ethernet link minus IPv4 and UDP headers
+static constexpr const size_t MAX_DATAGRAM_SIZE = 1500 - 20 - 8;
+
+// RLS header (compatibility octet, version, message type, STI) and the item count of a batch message
+static constexpr const size_t BATCH_HEADER_SIZE = 1 + 3 + 1 + 8 + 2;
+
+// PDU type, PDU ID, payload and PDU length fields of a batch item
+static constexpr const size_t BATCH_ITEM_HEADER_SIZE = 1 + 4 + 4 + 2;
+
+namespace rls
+{
+
+bool PduBatcher::isEmpty() const
+{
+    return m_items.empty();
+}
+
+bool PduBatcher::fits(int endPointId, const OctetString &pdu) const
+{
+    size_t current = BATCH_HEADER_SIZE;
+    if (m_sizes.count(endPointId))
+        current = m_sizes.at(endPointId);
+
+    return current + BATCH_ITEM_HEADER_SIZE + static_cast<size_t>(pdu.length()) <= MAX_DATAGRAM_SIZE;
+}
+
+std::vector<int> PduBatcher::endPoints() const
+{
+    std::vector<int> res;
+    res.reserve(m_items.size());
+    for (auto &item : m_items)
+        res.push_back(item.first);
+    return res;
+}
+
+void PduBatcher::add(int endPointId, RlsPduItem &&item)
+{
+    if (!m_sizes.count(endPointId))
+        m_sizes[endPointId] = BATCH_HEADER_SIZE;
+
+    m_sizes[endPointId] += BATCH_ITEM_HEADER_SIZE + static_cast<size_t>(item.pdu.length());
+    m_items[endPointId].push_back(std::move(item));
+}
+
+std::unique_ptr<RlsMessage> PduBatcher::take(int endPointId, uint64_t sti)
+{
+    if (!m_items.count(endPointId))
+        return nullptr;
+
+    auto items = std::move(m_items[endPointId]);
+    m_items.erase(endPointId);
+    m_sizes.erase(endPointId);
+
+    if (items.empty())
+        return nullptr;
+
+    if (items.size() == 1)
+    {
+        auto res = std::make_unique<RlsPduTransmission>(sti);
+        res->pduType = items[0].pduType;
+        res->pduId = items[0].pduId;
+        res->payload = items[0].payload;
+        res->pdu = std::move(items[0].pdu);
+        return res;
+    }
+
+    auto res = std::make_unique<RlsPduTransmissionBatch>(sti);
+    res->items = std::move(items);
+    return res;
+}
+
+} // namespace rls
@@ -0,0 +1,41 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "rls_pdu.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rls
+{
+
+/* Collects small PDUs per end point so that they can be sent in a single PDU_TRANSMISSION_BATCH message */
+class PduBatcher
+{
+  private:
+    std::unordered_map<int, std::vector<RlsPduItem>> m_items;
+    std::unordered_map<int, size_t> m_sizes;
+
+  public:
+    PduBatcher() = default;
+
+  public:
+    [[nodiscard]] bool isEmpty() const;
+    [[nodiscard]] bool fits(int endPointId, const OctetString &pdu) const;
+    [[nodiscard]] std::vector<int> endPoints() const;
+
+    void add(int endPointId, RlsPduItem &&item);
+
+    // Returns nullptr if there is nothing to send. A batch with a single item is returned as a plain PDU_TRANSMISSION
+    std::unique_ptr<RlsMessage> take(int endPointId, uint64_t sti);
+};
+
+} // namespace rls
@@ -10,6 +10,23 @@
 
 #include <utils/constants.hpp>
 
+static constexpr const size_t COMMON_HEADER_SIZE = 13;
+static constexpr const uint8_t ENVELOPE_MARKER = 0x04;
+
+static inline void Write4(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = static_cast<uint8_t>(value >> 24);
+    buffer[1] = static_cast<uint8_t>(value >> 16);
+    buffer[2] = static_cast<uint8_t>(value >> 8);
+    buffer[3] = static_cast<uint8_t>(value);
+}
+
+static inline uint32_t Read4(const uint8_t *buffer)
+{
+    return (static_cast<uint32_t>(buffer[0]) << 24) | (static_cast<uint32_t>(buffer[1]) << 16) |
+           (static_cast<uint32_t>(buffer[2]) << 8) | static_cast<uint32_t>(buffer[3]);
+}
+
 namespace rls
 {
 
@@ -28,11 +45,13 @@ void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream)
         stream.appendOctet4(m.simPos.x);
         stream.appendOctet4(m.simPos.y);
         stream.appendOctet4(m.simPos.z);
+        stream.appendOctet(m.features);
     }
     else if (msg.msgType == EMessageType::HEARTBEAT_ACK)
     {
         auto &m = (const RlsHeartBeatAck &)msg;
         stream.appendOctet4(m.dbm);
+        stream.appendOctet(m.features);
     }
     else if (msg.msgType == EMessageType::PDU_TRANSMISSION)
     {
@@ -49,6 +68,44 @@ void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream)
         stream.appendOctet4(static_cast<uint32_t>(m.pduIds.size()));
         for (auto pduId : m.pduIds)
             stream.appendOctet4(pduId);
+        stream.appendOctet4(m.cumulativeId);
+    }
+    else if (msg.msgType == EMessageType::PDU_TRANSMISSION_BATCH)
+    {
+        auto &m = (const RlsPduTransmissionBatch &)msg;
+        stream.appendOctet2(static_cast<int>(m.items.size()));
+        for (auto &item : m.items)
+        {
+            stream.appendOctet(static_cast<uint8_t>(item.pduType));
+            stream.appendOctet4(item.pduId);
+            stream.appendOctet4(item.payload);
+            stream.appendOctet2(item.pdu.length());
+            stream.append(item.pdu);
+        }
+    }
+    else if (msg.msgType == EMessageType::HEARTBEAT_BATCH)
+    {
+        auto &m = (const RlsHeartBeatBatch &)msg;
+        stream.appendOctet(m.features);
+        stream.appendOctet2(static_cast<int>(m.items.size()));
+        for (auto &item : m.items)
+        {
+            stream.appendOctet8(item.sti);
+            stream.appendOctet4(item.simPos.x);
+            stream.appendOctet4(item.simPos.y);
+            stream.appendOctet4(item.simPos.z);
+        }
+    }
+    else if (msg.msgType == EMessageType::HEARTBEAT_ACK_BATCH)
+    {
+        auto &m = (const RlsHeartBeatAckBatch &)msg;
+        stream.appendOctet(m.features);
+        stream.appendOctet2(static_cast<int>(m.items.size()));
+        for (auto &item : m.items)
+        {
+            stream.appendOctet8(item.sti);
+            stream.appendOctet4(item.dbm);
+        }
     }
 }
 
@@ -74,12 +131,16 @@ std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream)
         res->simPos.x = stream.read4I();
         res->simPos.y = stream.read4I();
         res->simPos.z = stream.read4I();
+        if (stream.hasNext()) // (Features octet is absent in older versions)
+            res->features = stream.read();
         return res;
     }
     else if (msgType == EMessageType::HEARTBEAT_ACK)
     {
         auto res = std::make_unique<RlsHeartBeatAck>(sti);
         res->dbm = stream.read4I();
+        if (stream.hasNext()) // (Features octet is absent in older versions)
+            res->features = stream.read();
         return res;
     }
     else if (msgType == EMessageType::PDU_TRANSMISSION)
@@ -98,10 +159,170 @@ std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream)
         res->pduIds.reserve(count);
         for (uint32_t i = 0; i < count; i++)
             res->pduIds.push_back(stream.read4UI());
+        if (stream.hasNext()) // (Cumulative ID is absent in older versions)
+            res->cumulativeId = stream.read4UI();
+        return res;
+    }
+    else if (msgType == EMessageType::PDU_TRANSMISSION_BATCH)
+    {
+        auto res = std::make_unique<RlsPduTransmissionBatch>(sti);
+        auto count = stream.read2I();
+        res->items.resize(count);
+        for (auto &item : res->items)
+        {
+            item.pduType = static_cast<EPduType>((uint8_t)stream.read());
+            item.pduId = stream.read4UI();
+            item.payload = stream.read4UI();
+            item.pdu = stream.readOctetString(stream.read2I());
+        }
+        return res;
+    }
+    else if (msgType == EMessageType::HEARTBEAT_BATCH)
+    {
+        auto res = std::make_unique<RlsHeartBeatBatch>(sti);
+        res->features = stream.read();
+        auto count = stream.read2I();
+        res->items.resize(count);
+        for (auto &item : res->items)
+        {
+            item.sti = stream.read8UL();
+            item.simPos.x = stream.read4I();
+            item.simPos.y = stream.read4I();
+            item.simPos.z = stream.read4I();
+        }
+        return res;
+    }
+    else if (msgType == EMessageType::HEARTBEAT_ACK_BATCH)
+    {
+        auto res = std::make_unique<RlsHeartBeatAckBatch>(sti);
+        res->features = stream.read();
+        auto count = stream.read2I();
+        res->items.resize(count);
+        for (auto &item : res->items)
+        {
+            item.sti = stream.read8UL();
+            item.dbm = stream.read4I();
+        }
         return res;
     }
 
     return nullptr;
 }
 
+void EncodePduTransmissionHeader(uint64_t sti, EPduType pduType, uint32_t pduId, uint32_t payload, size_t pduLength,
+                                 uint8_t *buffer)
+{
+    buffer[0] = 0x03; // (Just for old RLS compatibility)
+    buffer[1] = cons::Major;
+    buffer[2] = cons::Minor;
+    buffer[3] = cons::Patch;
+    buffer[4] = static_cast<uint8_t>(EMessageType::PDU_TRANSMISSION);
+    Write4(buffer + 5, static_cast<uint32_t>(sti >> 32));
+    Write4(buffer + 9, static_cast<uint32_t>(sti));
+    buffer[13] = static_cast<uint8_t>(pduType);
+    Write4(buffer + 14, pduId);
+    Write4(buffer + 18, payload);
+    Write4(buffer + 22, static_cast<uint32_t>(pduLength));
+}
+
+void EncodeEnvelopeHeader(uint64_t destination, uint8_t *buffer)
+{
+    // Differs from the first octet of the messages, so that enveloped and bare messages can be told apart
+    buffer[0] = ENVELOPE_MARKER;
+    Write4(buffer + 1, static_cast<uint32_t>(destination >> 32));
+    Write4(buffer + 5, static_cast<uint32_t>(destination));
+}
+
+bool DecodeEnvelope(const uint8_t *&data, size_t &size, uint64_t &destination)
+{
+    if (size < ENVELOPE_HEADER_SIZE || data[0] != ENVELOPE_MARKER)
+        return false;
+
+    destination = (static_cast<uint64_t>(Read4(data + 1)) << 32) | Read4(data + 5);
+    data += ENVELOPE_HEADER_SIZE;
+    size -= ENVELOPE_HEADER_SIZE;
+    return true;
+}
+
+bool DecodeRlsMessageView(const uint8_t *data, size_t size, RlsMessageView &view)
+{
+    if (size < COMMON_HEADER_SIZE)
+        return false;
+
+    // (First octet is just for old RLS compatibility)
+    if (data[0] != 0x03 || data[1] != cons::Major || data[2] != cons::Minor || data[3] != cons::Patch)
+        return false;
+
+    view.msgType = static_cast<EMessageType>(data[4]);
+    view.sti = (static_cast<uint64_t>(Read4(data + 5)) << 32) | Read4(data + 9);
+
+    const uint8_t *body = data + COMMON_HEADER_SIZE;
+    size_t bodySize = size - COMMON_HEADER_SIZE;
+
+    if (view.msgType == EMessageType::HEARTBEAT)
+    {
+        if (bodySize < 12)
+            return false;
+        view.simPos.x = static_cast<int>(Read4(body));
+        view.simPos.y = static_cast<int>(Read4(body + 4));
+        view.simPos.z = static_cast<int>(Read4(body + 8));
+        view.features = bodySize > 12 ? body[12] : 0;
+    }
+    else if (view.msgType == EMessageType::HEARTBEAT_ACK)
+    {
+        if (bodySize < 4)
+            return false;
+        view.dbm = static_cast<int>(Read4(body));
+        view.features = bodySize > 4 ? body[4] : 0;
+    }
+    else if (view.msgType == EMessageType::PDU_TRANSMISSION)
+    {
+        if (size < PDU_TRANSMISSION_HEADER_SIZE)
+            return false;
+        view.pduType = static_cast<EPduType>(data[13]);
+        view.pduId = Read4(data + 14);
+        view.payload = Read4(data + 18);
+        view.pduLength = Read4(data + 22);
+        view.pdu = data + PDU_TRANSMISSION_HEADER_SIZE;
+        if (view.pduLength > size - PDU_TRANSMISSION_HEADER_SIZE)
+            return false;
+    }
+    else if (view.msgType == EMessageType::HEARTBEAT_BATCH || view.msgType == EMessageType::HEARTBEAT_ACK_BATCH)
+    {
+        if (bodySize < 3)
+            return false;
+        size_t itemSize =
+            view.msgType == EMessageType::HEARTBEAT_BATCH ? HEARTBEAT_ITEM_SIZE : HEARTBEAT_ACK_ITEM_SIZE;
+        view.features = body[0];
+        view.itemCount = (static_cast<size_t>(body[1]) << 8) | body[2];
+        view.items = body + 3;
+        if (view.itemCount * itemSize > bodySize - 3)
+            return false;
+    }
+
+    return true;
+}
+
+RlsHeartBeatItem GetHeartBeatItem(const RlsMessageView &view, size_t index)
+{
+    const uint8_t *item = view.items + index * HEARTBEAT_ITEM_SIZE;
+
+    RlsHeartBeatItem res{};
+    res.sti = (static_cast<uint64_t>(Read4(item)) << 32) | Read4(item + 4);
+    res.simPos.x = static_cast<int>(Read4(item + 8));
+    res.simPos.y = static_cast<int>(Read4(item + 12));
+    res.simPos.z = static_cast<int>(Read4(item + 16));
+    return res;
+}
+
+RlsHeartBeatAckItem GetHeartBeatAckItem(const RlsMessageView &view, size_t index)
+{
+    const uint8_t *item = view.items + index * HEARTBEAT_ACK_ITEM_SIZE;
+
+    RlsHeartBeatAckItem res{};
+    res.sti = (static_cast<uint64_t>(Read4(item)) << 32) | Read4(item + 4);
+    res.dbm = static_cast<int>(Read4(item + 8));
+    return res;
+}
+
 } // namespace rls
@@ -10,6 +10,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <utils/common_types.hpp>
 #include <utils/octet_string.hpp>
@@ -30,6 +31,9 @@ enum class EMessageType : uint8_t
     HEARTBEAT_ACK = 5,
     PDU_TRANSMISSION = 6,
     PDU_TRANSMISSION_ACK = 7,
+    PDU_TRANSMISSION_BATCH = 8,
+    HEARTBEAT_BATCH = 9,
+    HEARTBEAT_ACK_BATCH = 10,
 };
 
 enum class EPduType : uint8_t
@@ -39,6 +43,15 @@ enum class EPduType : uint8_t
     DATA
 };
 
+// Optional capabilities advertised in heartbeat and heartbeat ACK messages
+static constexpr const uint8_t FEATURE_PDU_BATCH = 0x01;
+// Downlink messages are wrapped into an envelope naming the destination UE, for UEs sharing a socket
+static constexpr const uint8_t FEATURE_ENVELOPE = 0x02;
+// Heartbeats of the UEs sharing a socket are sent together in HEARTBEAT_BATCH messages
+static constexpr const uint8_t FEATURE_HEARTBEAT_BATCH = 0x04;
+
+static constexpr const uint8_t SUPPORTED_FEATURES = FEATURE_PDU_BATCH | FEATURE_ENVELOPE | FEATURE_HEARTBEAT_BATCH;
+
 struct RlsMessage
 {
     const EMessageType msgType;
@@ -52,6 +65,7 @@ struct RlsMessage
 struct RlsHeartBeat : RlsMessage
 {
     Vector3 simPos;
+    uint8_t features{};
 
     explicit RlsHeartBeat(uint64_t sti) : RlsMessage(EMessageType::HEARTBEAT, sti)
     {
@@ -61,6 +75,7 @@ struct RlsHeartBeat : RlsMessage
 struct RlsHeartBeatAck : RlsMessage
 {
     int dbm{};
+    uint8_t features{};
 
     explicit RlsHeartBeatAck(uint64_t sti) : RlsMessage(EMessageType::HEARTBEAT_ACK, sti)
     {
@@ -81,14 +96,129 @@ struct RlsPduTransmission : RlsMessage
 
 struct RlsPduTransmissionAck : RlsMessage
 {
+    // Selectively acknowledged PDU IDs
     std::vector<uint32_t> pduIds;
+    // All the PDU IDs up to (including) this value are acknowledged, 0 if not present
+    uint32_t cumulativeId{};
 
     explicit RlsPduTransmissionAck(uint64_t sti) : RlsMessage(EMessageType::PDU_TRANSMISSION_ACK, sti)
     {
     }
 };
 
+struct RlsPduItem
+{
+    EPduType pduType{};
+    uint32_t pduId{};
+    uint32_t payload{};
+    OctetString pdu{};
+};
+
+struct RlsPduTransmissionBatch : RlsMessage
+{
+    std::vector<RlsPduItem> items;
+
+    explicit RlsPduTransmissionBatch(uint64_t sti) : RlsMessage(EMessageType::PDU_TRANSMISSION_BATCH, sti)
+    {
+    }
+};
+
+struct RlsHeartBeatItem
+{
+    uint64_t sti{};
+    Vector3 simPos{};
+};
+
+// Heartbeats of many UEs, the STI of the message itself is not used
+struct RlsHeartBeatBatch : RlsMessage
+{
+    uint8_t features{};
+    std::vector<RlsHeartBeatItem> items;
+
+    explicit RlsHeartBeatBatch(uint64_t sti) : RlsMessage(EMessageType::HEARTBEAT_BATCH, sti)
+    {
+    }
+};
+
+struct RlsHeartBeatAckItem
+{
+    uint64_t sti{};
+    int dbm{};
+};
+
+// Heartbeat ACKs of the gNB for many UEs, in response to a HEARTBEAT_BATCH
+struct RlsHeartBeatAckBatch : RlsMessage
+{
+    uint8_t features{};
+    std::vector<RlsHeartBeatAckItem> items;
+
+    explicit RlsHeartBeatAckBatch(uint64_t sti) : RlsMessage(EMessageType::HEARTBEAT_ACK_BATCH, sti)
+    {
+    }
+};
+
+// Sizes of the items in HEARTBEAT_BATCH and HEARTBEAT_ACK_BATCH messages
+static constexpr const size_t HEARTBEAT_ITEM_SIZE = 20;
+static constexpr const size_t HEARTBEAT_ACK_ITEM_SIZE = 12;
+
+// Size of the fields preceding the PDU in a PDU_TRANSMISSION message
+static constexpr const size_t PDU_TRANSMISSION_HEADER_SIZE = 26;
+
+// Size of the envelope preceding an enveloped message
+static constexpr const size_t ENVELOPE_HEADER_SIZE = 9;
+
+/* Decoded form of an RLS message that lives on the stack and refers to the PDU in the receive buffer */
+struct RlsMessageView
+{
+    EMessageType msgType{};
+    uint64_t sti{};
+
+    // HEARTBEAT
+    Vector3 simPos{};
+
+    // HEARTBEAT
+    // HEARTBEAT_ACK
+    // HEARTBEAT_BATCH
+    // HEARTBEAT_ACK_BATCH
+    uint8_t features{};
+
+    // HEARTBEAT_ACK
+    int dbm{};
+
+    // HEARTBEAT_BATCH
+    // HEARTBEAT_ACK_BATCH
+    const uint8_t *items{};
+    size_t itemCount{};
+
+    // PDU_TRANSMISSION
+    EPduType pduType{};
+    uint32_t pduId{};
+    uint32_t payload{};
+    const uint8_t *pdu{};
+    size_t pduLength{};
+};
+
 void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream);
 std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream);
 
+// Writes the PDU_TRANSMISSION fields preceding the PDU into the given buffer (e.g. the headroom of the PDU).
+// The buffer must have at least PDU_TRANSMISSION_HEADER_SIZE octets.
+void EncodePduTransmissionHeader(uint64_t sti, EPduType pduType, uint32_t pduId, uint32_t payload, size_t pduLength,
+                                 uint8_t *buffer);
+
+// Writes the envelope header naming the destination STI. The buffer must have at least ENVELOPE_HEADER_SIZE octets.
+void EncodeEnvelopeHeader(uint64_t destination, uint8_t *buffer);
+
+// If the message is enveloped, strips the envelope by advancing the data and returns true with the destination STI
+bool DecodeEnvelope(const uint8_t *&data, size_t &size, uint64_t &destination);
+
+// Decodes the common header and the HEARTBEAT, HEARTBEAT_ACK, PDU_TRANSMISSION, HEARTBEAT_BATCH and HEARTBEAT_ACK_BATCH
+// bodies without any allocation or copy. Bodies of the other message types are not decoded. Returns false if the
+// message is invalid.
+bool DecodeRlsMessageView(const uint8_t *data, size_t size, RlsMessageView &view);
+
+// Items of a decoded HEARTBEAT_BATCH or HEARTBEAT_ACK_BATCH view, the index must be less than the item count
+RlsHeartBeatItem GetHeartBeatItem(const RlsMessageView &view, size_t index);
+RlsHeartBeatAckItem GetHeartBeatAckItem(const RlsMessageView &view, size_t index);
+
 } // namespace rls
\ No newline at end of file
@@ -0,0 +1,579 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "rls_shm.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <utils/common.hpp>
+#include <utils/libc_error.hpp>
+
+static constexpr const size_t RING_CAPACITY = 1 << 20;
+static constexpr const size_t MAX_RECORD_SIZE = 65535;
+static constexpr const uint32_t WRAP_MARKER = 0xFFFFFFFF;
+static constexpr const uint8_t SHM_VERSION = 1;
+static constexpr const int CONNECT_RETRY_PERIOD = 1000;
+static constexpr const int HANDOVER_TIMEOUT = 1000;
+
+static size_t AlignRecord(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+static std::string AddressKey(const InetAddress &address)
+{
+    return std::string{reinterpret_cast<const char *>(address.getSockAddr()), address.getSockLen()};
+}
+
+static socklen_t MakeAbstractAddress(const std::string &name, sockaddr_un &outAddress)
+{
+    outAddress = {};
+    outAddress.sun_family = AF_UNIX;
+    // Leading zero selects the abstract namespace, nothing is left behind in the file system
+    std::memcpy(outAddress.sun_path + 1, name.data(), std::min(name.size(), sizeof(outAddress.sun_path) - 1));
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 +
+                                  std::min(name.size(), sizeof(outAddress.sun_path) - 1));
+}
+
+// The control socket of a gNB is named after its link address, that is what the UEs have in their gnbSearchList
+static bool MakeControlAddress(const InetAddress &address, sockaddr_un &outAddress, socklen_t &outLength)
+{
+    char ip[INET6_ADDRSTRLEN] = {0};
+    auto *sa = address.getSockAddr();
+
+    if (sa->sa_family == AF_INET)
+    {
+        if (inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in *>(sa)->sin_addr, ip, sizeof(ip)) == nullptr)
+            return false;
+    }
+    else if (sa->sa_family == AF_INET6)
+    {
+        if (inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6 *>(sa)->sin6_addr, ip, sizeof(ip)) == nullptr)
+            return false;
+    }
+    else
+        return false;
+
+    outLength = MakeAbstractAddress("UERANSIM/rls/" + std::string{ip} + ":" + std::to_string(address.getPort()),
+                                    outAddress);
+    return true;
+}
+
+// UEs attached over shared memory have no IP address, they are given a unique unix address instead
+static InetAddress MakePeerAddress(int channelId)
+{
+    sockaddr_un addr{};
+    socklen_t len = MakeAbstractAddress("UERANSIM/rls/peer/" + std::to_string(channelId), addr);
+
+    sockaddr_storage storage{};
+    std::memcpy(&storage, &addr, sizeof(addr));
+    return InetAddress{storage, len};
+}
+
+static void CloseFd(int fd)
+{
+    if (fd >= 0)
+        ::close(fd);
+}
+
+static void RingDoorbell(int fd)
+{
+    uint64_t value = 1;
+    // Can only fail if the counter overflows, the peer is woken up anyway in that case
+    (void)::write(fd, &value, sizeof(value));
+}
+
+static void ClearDoorbell(int fd)
+{
+    uint64_t value;
+    (void)::read(fd, &value, sizeof(value));
+}
+
+static bool SendFds(int socketFd, const int *fds, int count)
+{
+    uint8_t version = SHM_VERSION;
+    iovec iov{&version, sizeof(version)};
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 3)] = {0};
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+    auto *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+
+    return ::sendmsg(socketFd, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(version));
+}
+
+static bool ReceiveFds(int socketFd, int *fds, int count)
+{
+    uint8_t version = 0;
+    iovec iov{&version, sizeof(version)};
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 3)] = {0};
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+    if (::recvmsg(socketFd, &msg, MSG_CMSG_CLOEXEC) != static_cast<ssize_t>(sizeof(version)))
+        return false;
+
+    auto *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        return false;
+
+    size_t received = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    std::memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * std::min(received, static_cast<size_t>(count)));
+
+    if (received != static_cast<size_t>(count) || version != SHM_VERSION)
+    {
+        for (size_t i = 0; i < std::min(received, static_cast<size_t>(count)); i++)
+            CloseFd(fds[i]);
+        return false;
+    }
+    return true;
+}
+
+namespace rls
+{
+
+ShmRing::ShmRing() : m_header{}, m_data{}, m_capacity{}
+{
+}
+
+ShmRing::ShmRing(void *memory, size_t capacity)
+    : m_header{reinterpret_cast<Header *>(memory)},
+      m_data{reinterpret_cast<uint8_t *>(memory) + sizeof(Header)}, m_capacity{capacity}
+{
+}
+
+bool ShmRing::isEmpty() const
+{
+    return m_header->tail.load() == m_header->head.load();
+}
+
+bool ShmRing::isWaiting() const
+{
+    return m_header->waiting.load() != 0;
+}
+
+void ShmRing::setWaiting(bool waiting)
+{
+    m_header->waiting.store(waiting ? 1 : 0);
+}
+
+bool ShmRing::push(const uint8_t *header, size_t headerSize, const uint8_t *payload, size_t payloadSize)
+{
+    size_t length = headerSize + payloadSize;
+    if (length == 0 || length > MAX_RECORD_SIZE)
+        return false;
+
+    size_t need = AlignRecord(4 + length);
+
+    uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+
+    size_t pos = head % m_capacity;
+    size_t contiguous = m_capacity - pos;
+    size_t skip = contiguous < need ? contiguous : 0;
+
+    if (m_capacity - (head - tail) < skip + need)
+        return false;
+
+    if (skip != 0)
+    {
+        // Records are never split, the rest of the ring is skipped instead
+        std::memcpy(m_data + pos, &WRAP_MARKER, 4);
+        head += skip;
+        pos = 0;
+    }
+
+    auto length32 = static_cast<uint32_t>(length);
+    std::memcpy(m_data + pos, &length32, 4);
+    std::memcpy(m_data + pos + 4, header, headerSize);
+    if (payloadSize != 0)
+        std::memcpy(m_data + pos + 4 + headerSize, payload, payloadSize);
+
+    m_header->head.store(head + need);
+    return true;
+}
+
+int ShmRing::pop(uint8_t *buffer, size_t bufferSize)
+{
+    while (true)
+    {
+        uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+        uint64_t head = m_header->head.load(std::memory_order_acquire);
+        if (tail == head)
+            return 0;
+
+        size_t pos = tail % m_capacity;
+
+        uint32_t length;
+        std::memcpy(&length, m_data + pos, 4);
+
+        if (length == WRAP_MARKER)
+        {
+            m_header->tail.store(tail + (m_capacity - pos), std::memory_order_release);
+            continue;
+        }
+
+        size_t need = AlignRecord(4 + static_cast<size_t>(length));
+        if (length == 0 || need > m_capacity - pos || need > head - tail)
+        {
+            // The peer has written garbage, nothing in the ring can be trusted anymore
+            m_header->tail.store(head, std::memory_order_release);
+            return 0;
+        }
+
+        bool fits = length <= bufferSize;
+        if (fits)
+            std::memcpy(buffer, m_data + pos + 4, length);
+
+        m_header->tail.store(tail + need, std::memory_order_release);
+
+        if (fits)
+            return static_cast<int>(length);
+    }
+}
+
+size_t ShmRing::RequiredSize(size_t capacity)
+{
+    return sizeof(Header) + capacity;
+}
+
+ShmTransport::ShmTransport()
+    : m_udp{Socket::CreateUdp4()}, m_listenFd{-1}, m_channelIdCounter{}, m_nextChannel{}, m_channels{},
+      m_channelByPeer{}, m_lastConnectAttempt{}
+{
+}
+
+ShmTransport::ShmTransport(const std::string &address, uint16_t port)
+    : m_udp{Socket::CreateAndBindUdp({address, port})}, m_listenFd{-1}, m_channelIdCounter{}, m_nextChannel{},
+      m_channels{}, m_channelByPeer{}, m_lastConnectAttempt{}
+{
+    sockaddr_un addr{};
+    socklen_t len{};
+    if (!MakeControlAddress(InetAddress{address, port}, addr, len))
+    {
+        m_udp.close();
+        throw LibError("Shared memory transport is not supported for address " + address);
+    }
+
+    m_listenFd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0)
+    {
+        m_udp.close();
+        throw LibError("Shared memory control socket could not be created:", errno);
+    }
+
+    if (::bind(m_listenFd, reinterpret_cast<sockaddr *>(&addr), len) < 0 || ::listen(m_listenFd, SOMAXCONN) < 0)
+    {
+        int err = errno;
+        CloseFd(m_listenFd);
+        m_udp.close();
+        throw LibError("Shared memory control socket could not be bound:", err);
+    }
+}
+
+ShmTransport::~ShmTransport()
+{
+    while (!m_channels.empty())
+        closeChannel(m_channels.back().get());
+
+    CloseFd(m_listenFd);
+    m_udp.close();
+}
+
+int ShmTransport::receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    int size = popAny(buffer, bufferSize, outPeerAddress);
+    if (size > 0)
+        return size;
+
+    // Announce the sleep first and then check again, otherwise a record pushed in between would not ring the doorbell
+    bool pending = false;
+    for (auto &channel : m_channels)
+        channel->rx.setWaiting(true);
+    for (auto &channel : m_channels)
+        pending |= !channel->rx.isEmpty();
+
+    std::vector<pollfd> fds{};
+    fds.reserve(2 + m_channels.size() * 2);
+    fds.push_back({m_udp.getFd(), POLLIN, 0});
+    fds.push_back({m_listenFd, POLLIN, 0}); // Negative fd is ignored by poll
+    for (auto &channel : m_channels)
+    {
+        fds.push_back({channel->rxEvent, POLLIN, 0});
+        fds.push_back({channel->controlFd, POLLIN, 0});
+    }
+
+    // Channels are only closed by this function, and connected ones are appended. So the polled channels are still
+    // the first ones after the lock is taken again.
+    size_t polledCount = m_channels.size();
+
+    lock.unlock();
+    int rc = pending ? 0 : ::poll(fds.data(), fds.size(), timeoutMs);
+    int pollError = errno;
+    lock.lock();
+
+    for (auto &channel : m_channels)
+        channel->rx.setWaiting(false);
+
+    if (rc < 0)
+    {
+        if (pollError == EINTR)
+            return 0;
+        throw LibError("poll failed: ", pollError);
+    }
+
+    // The peer never writes to the control socket, any event there means it has gone
+    std::vector<Channel *> closed{};
+    for (size_t i = 0; i < polledCount; i++)
+    {
+        if (fds[2 + i * 2].revents & POLLIN)
+            ClearDoorbell(m_channels[i]->rxEvent);
+        if (fds[2 + i * 2 + 1].revents != 0)
+            closed.push_back(m_channels[i].get());
+    }
+    for (auto *channel : closed)
+        closeChannel(channel);
+
+    if (fds[1].revents & POLLIN)
+        acceptChannel();
+
+    size = popAny(buffer, bufferSize, outPeerAddress);
+    if (size > 0)
+        return size;
+
+    if (fds[0].revents & POLLIN)
+        return m_udp.receive(buffer, bufferSize, 0, outPeerAddress);
+    return 0;
+}
+
+void ShmTransport::send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    send(address, buffer, bufferSize, nullptr, 0);
+}
+
+void ShmTransport::send(const InetAddress &address, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+                        size_t payloadSize)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto *channel = findChannel(address);
+    if (channel == nullptr)
+    {
+        if (address.getSockAddr()->sa_family != AF_UNIX)
+        {
+            if (payloadSize == 0)
+                m_udp.send(address, header, headerSize);
+            else
+                m_udp.send(address, header, headerSize, payload, payloadSize);
+        }
+        return;
+    }
+
+    if (channel->tx.push(header, headerSize, payload, payloadSize) && channel->tx.isWaiting())
+        RingDoorbell(channel->txEvent);
+}
+
+int ShmTransport::popAny(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress)
+{
+    size_t count = m_channels.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t index = (m_nextChannel + i) % count;
+        int size = m_channels[index]->rx.pop(buffer, bufferSize);
+        if (size > 0)
+        {
+            // Start from the next channel next time so that a busy peer cannot starve the others
+            m_nextChannel = (index + 1) % count;
+            outPeerAddress = m_channels[index]->peer;
+            return size;
+        }
+    }
+    return 0;
+}
+
+ShmTransport::Channel *ShmTransport::findChannel(const InetAddress &address)
+{
+    auto it = m_channelByPeer.find(AddressKey(address));
+    if (it != m_channelByPeer.end())
+        return it->second;
+
+    // Only the UE side initiates channels
+    if (m_listenFd >= 0 || address.getSockAddr()->sa_family == AF_UNIX)
+        return nullptr;
+    return connectChannel(address);
+}
+
+ShmTransport::Channel *ShmTransport::connectChannel(const InetAddress &address)
+{
+    auto key = AddressKey(address);
+    auto now = utils::CurrentTimeMillis();
+
+    auto it = m_lastConnectAttempt.find(key);
+    if (it != m_lastConnectAttempt.end() && now - it->second < CONNECT_RETRY_PERIOD)
+        return nullptr;
+    m_lastConnectAttempt[key] = now;
+
+    sockaddr_un addr{};
+    socklen_t len{};
+    if (!MakeControlAddress(address, addr, len))
+        return nullptr;
+
+    int controlFd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (controlFd < 0)
+        return nullptr;
+
+    // Fails if there is no gNB with shared memory transport on this host at that address, UDP is used in that case
+    if (::connect(controlFd, reinterpret_cast<sockaddr *>(&addr), len) < 0)
+    {
+        CloseFd(controlFd);
+        return nullptr;
+    }
+
+    size_t memorySize = 2 * ShmRing::RequiredSize(RING_CAPACITY);
+
+    int fds[3];
+    fds[0] = ::memfd_create("rls-shm", MFD_CLOEXEC);
+    fds[1] = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    fds[2] = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    void *memory = MAP_FAILED;
+    if (fds[0] >= 0 && fds[1] >= 0 && fds[2] >= 0 && ::ftruncate(fds[0], static_cast<off_t>(memorySize)) == 0)
+        memory = ::mmap(nullptr, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+
+    if (memory == MAP_FAILED || !SendFds(controlFd, fds, 3))
+    {
+        if (memory != MAP_FAILED)
+            ::munmap(memory, memorySize);
+        for (int fd : fds)
+            CloseFd(fd);
+        CloseFd(controlFd);
+        return nullptr;
+    }
+
+    // The mapping keeps the memory alive
+    CloseFd(fds[0]);
+
+    auto channel = std::make_unique<Channel>();
+    channel->controlFd = controlFd;
+    channel->txEvent = fds[1];
+    channel->rxEvent = fds[2];
+    channel->memory = memory;
+    channel->memorySize = memorySize;
+    channel->tx = ShmRing{memory, RING_CAPACITY};
+    channel->rx = ShmRing{reinterpret_cast<uint8_t *>(memory) + ShmRing::RequiredSize(RING_CAPACITY), RING_CAPACITY};
+    channel->peer = address;
+
+    auto *result = channel.get();
+    addChannel(std::move(channel));
+    return result;
+}
+
+void ShmTransport::acceptChannel()
+{
+    int controlFd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (controlFd < 0)
+        return;
+
+    // The UE sends the descriptors right after connecting, do not let a misbehaving peer block the task
+    timeval timeout{};
+    timeout.tv_sec = HANDOVER_TIMEOUT / 1000;
+    timeout.tv_usec = (HANDOVER_TIMEOUT % 1000) * 1000;
+    ::setsockopt(controlFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int fds[3];
+    if (!ReceiveFds(controlFd, fds, 3))
+    {
+        CloseFd(controlFd);
+        return;
+    }
+
+    size_t memorySize = 2 * ShmRing::RequiredSize(RING_CAPACITY);
+
+    struct stat st
+    {
+    };
+    void *memory = MAP_FAILED;
+    if (::fstat(fds[0], &st) == 0 && static_cast<size_t>(st.st_size) == memorySize)
+        memory = ::mmap(nullptr, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    CloseFd(fds[0]);
+
+    if (memory == MAP_FAILED)
+    {
+        CloseFd(fds[1]);
+        CloseFd(fds[2]);
+        CloseFd(controlFd);
+        return;
+    }
+
+    auto channel = std::make_unique<Channel>();
+    channel->controlFd = controlFd;
+    channel->txEvent = fds[2];
+    channel->rxEvent = fds[1];
+    channel->memory = memory;
+    channel->memorySize = memorySize;
+    channel->tx = ShmRing{reinterpret_cast<uint8_t *>(memory) + ShmRing::RequiredSize(RING_CAPACITY), RING_CAPACITY};
+    channel->rx = ShmRing{memory, RING_CAPACITY};
+    channel->peer = MakePeerAddress(++m_channelIdCounter);
+
+    addChannel(std::move(channel));
+}
+
+void ShmTransport::addChannel(std::unique_ptr<Channel> &&channel)
+{
+    m_channelByPeer[AddressKey(channel->peer)] = channel.get();
+    m_channels.push_back(std::move(channel));
+}
+
+void ShmTransport::closeChannel(Channel *channel)
+{
+    m_channelByPeer.erase(AddressKey(channel->peer));
+
+    ::munmap(channel->memory, channel->memorySize);
+    CloseFd(channel->txEvent);
+    CloseFd(channel->rxEvent);
+    CloseFd(channel->controlFd);
+
+    for (auto it = m_channels.begin(); it != m_channels.end(); ++it)
+    {
+        if (it->get() == channel)
+        {
+            m_channels.erase(it);
+            break;
+        }
+    }
+    m_nextChannel = 0;
+}
+
+} // namespace rls
@@ -0,0 +1,113 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "rls_transport.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/network.hpp>
+
+namespace rls
+{
+
+/* Single producer single consumer ring of length prefixed records, living in memory shared by two processes */
+class ShmRing
+{
+  private:
+    struct Header
+    {
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+        alignas(64) std::atomic<uint32_t> waiting;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+    static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+  private:
+    Header *m_header;
+    uint8_t *m_data;
+    size_t m_capacity;
+
+  public:
+    ShmRing();
+    ShmRing(void *memory, size_t capacity);
+
+  public:
+    [[nodiscard]] bool isEmpty() const;
+    [[nodiscard]] bool isWaiting() const;
+
+    // Returns false if there is not enough room, the record is dropped in that case like a datagram would be
+    bool push(const uint8_t *header, size_t headerSize, const uint8_t *payload, size_t payloadSize);
+
+    // Returns 0 if the ring is empty, records not fitting into the buffer are skipped
+    int pop(uint8_t *buffer, size_t bufferSize);
+
+    // The consumer announces that it is about to sleep on the doorbell, so that the producer rings it only then
+    void setWaiting(bool waiting);
+
+    static size_t RequiredSize(size_t capacity);
+};
+
+/* RLS transport over shared memory for gNB and UE processes on the same host. Each UE creates a memfd holding one ring
+ * per direction and two eventfd doorbells, and hands them over to the gNB through an abstract unix socket named after
+ * the gNB's link address. Peers which are not reachable that way are served over UDP as usual. */
+class ShmTransport : public RlsTransport
+{
+  private:
+    struct Channel
+    {
+        int controlFd{-1};
+        int txEvent{-1};
+        int rxEvent{-1};
+        void *memory{};
+        size_t memorySize{};
+        ShmRing tx{};
+        ShmRing rx{};
+        InetAddress peer{};
+    };
+
+  private:
+    std::mutex m_mutex; // Guards the channels, but is not held while polling
+    Socket m_udp;
+    int m_listenFd;
+    int m_channelIdCounter;
+    size_t m_nextChannel;
+    std::vector<std::unique_ptr<Channel>> m_channels;
+    std::unordered_map<std::string, Channel *> m_channelByPeer;
+    std::unordered_map<std::string, int64_t> m_lastConnectAttempt;
+
+  public:
+    ShmTransport();
+    ShmTransport(const std::string &address, uint16_t port);
+    ~ShmTransport() override;
+
+  public:
+    int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) override;
+    void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) override;
+    void send(const InetAddress &address, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+              size_t payloadSize) override;
+
+  private:
+    int popAny(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress);
+    Channel *findChannel(const InetAddress &address);
+    Channel *connectChannel(const InetAddress &address);
+    void acceptChannel();
+    void addChannel(std::unique_ptr<Channel> &&channel);
+    void closeChannel(Channel *channel);
+};
+
+} // namespace rls
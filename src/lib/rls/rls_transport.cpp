@@ -0,0 +1,99 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "rls_transport.hpp"
+#include "rls_shm.hpp"
+
+namespace rls
+{
+
+UdpTransport::UdpTransport() : m_server{}
+{
+}
+
+UdpTransport::UdpTransport(const std::string &address, uint16_t port) : m_server{address, port}
+{
+}
+
+int UdpTransport::receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress)
+{
+    return m_server.Receive(buffer, bufferSize, timeoutMs, outPeerAddress);
+}
+
+void UdpTransport::send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    m_server.Send(address, buffer, bufferSize);
+}
+
+void UdpTransport::send(const InetAddress &address, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+                        size_t payloadSize)
+{
+    m_server.Send(address, header, headerSize, payload, payloadSize);
+}
+
+CaptureTransport::CaptureTransport(std::unique_ptr<RlsTransport> transport, uint32_t captureInterface,
+                                   const InetAddress &localAddress)
+    : m_transport{std::move(transport)}, m_point{captureInterface, CaptureProtocol::RLS, CaptureAddress{localAddress}}
+{
+}
+
+int CaptureTransport::receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress)
+{
+    int size = m_transport->receive(buffer, bufferSize, timeoutMs, outPeerAddress);
+    if (size > 0)
+        PacketCapture::Record(m_point, CaptureDirection::INBOUND, outPeerAddress, buffer, static_cast<size_t>(size));
+    return size;
+}
+
+void CaptureTransport::send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    PacketCapture::Record(m_point, CaptureDirection::OUTBOUND, address, buffer, bufferSize);
+    m_transport->send(address, buffer, bufferSize);
+}
+
+void CaptureTransport::send(const InetAddress &address, const uint8_t *header, size_t headerSize,
+                            const uint8_t *payload, size_t payloadSize)
+{
+    PacketCapture::Record(m_point, CaptureDirection::OUTBOUND, address, header, headerSize, payload, payloadSize);
+    m_transport->send(address, header, headerSize, payload, payloadSize);
+}
+
+std::unique_ptr<RlsTransport> CreateServerTransport(ETransportType type, const std::string &address, uint16_t port)
+{
+    if (type == ETransportType::SHM)
+        return std::make_unique<ShmTransport>(address, port);
+    return std::make_unique<UdpTransport>(address, port);
+}
+
+std::unique_ptr<RlsTransport> CreateClientTransport(ETransportType type)
+{
+    if (type == ETransportType::SHM)
+        return std::make_unique<ShmTransport>();
+    return std::make_unique<UdpTransport>();
+}
+
+std::unique_ptr<RlsTransport> WithCapture(std::unique_ptr<RlsTransport> transport, uint32_t captureInterface,
+                                          const InetAddress &localAddress)
+{
+    if (!PacketCapture::IsEnabled())
+        return transport;
+    return std::make_unique<CaptureTransport>(std::move(transport), captureInterface, localAddress);
+}
+
+bool ParseTransportType(const std::string &value, ETransportType &outType)
+{
+    if (value == "udp")
+        outType = ETransportType::UDP;
+    else if (value == "shm")
+        outType = ETransportType::SHM;
+    else
+        return false;
+    return true;
+}
+
+} // namespace rls
@@ -0,0 +1,90 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <lib/udp/server.hpp>
+#include <utils/network.hpp>
+#include <utils/packet_capture.hpp>
+
+namespace rls
+{
+
+enum class ETransportType
+{
+    UDP,
+    SHM,
+};
+
+/* Carries encoded RLS messages between the gNB and the UE. Peers are always identified by an InetAddress.
+ * send() may be called from any thread, also while another thread is blocked in receive(). */
+class RlsTransport
+{
+  public:
+    virtual ~RlsTransport() = default;
+
+  public:
+    virtual int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) = 0;
+    virtual void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) = 0;
+    virtual void send(const InetAddress &address, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+                      size_t payloadSize) = 0;
+};
+
+class UdpTransport : public RlsTransport
+{
+  private:
+    udp::UdpServer m_server;
+
+  public:
+    UdpTransport();
+    UdpTransport(const std::string &address, uint16_t port);
+    ~UdpTransport() override = default;
+
+  public:
+    int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) override;
+    void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) override;
+    void send(const InetAddress &address, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+              size_t payloadSize) override;
+};
+
+/* Records the datagrams of another transport in the packet capture, as seen from the given local address */
+class CaptureTransport : public RlsTransport
+{
+  private:
+    std::unique_ptr<RlsTransport> m_transport;
+    CapturePoint m_point;
+
+  public:
+    CaptureTransport(std::unique_ptr<RlsTransport> transport, uint32_t captureInterface,
+                     const InetAddress &localAddress);
+    ~CaptureTransport() override = default;
+
+  public:
+    int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) override;
+    void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) override;
+    void send(const InetAddress &address, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+              size_t payloadSize) override;
+};
+
+// Creates the transport of the gNB side, bound to the given address
+std::unique_ptr<RlsTransport> CreateServerTransport(ETransportType type, const std::string &address, uint16_t port);
+
+// Creates the transport of the UE side
+std::unique_ptr<RlsTransport> CreateClientTransport(ETransportType type);
+
+// Wraps the transport in a CaptureTransport if the packet capture is on. The local address of the UE side is not known.
+std::unique_ptr<RlsTransport> WithCapture(std::unique_ptr<RlsTransport> transport, uint32_t captureInterface,
+                                          const InetAddress &localAddress = {});
+
+bool ParseTransportType(const std::string &value, ETransportType &outType);
+
+} // namespace rls
@@ -0,0 +1,256 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "rls_window.hpp"
+
+#include <utils/common.hpp>
+
+static constexpr const uint32_t WINDOW_SIZE = 256;
+static constexpr const uint32_t INITIAL_RING_SIZE = 4; // Ring sizes are powers of two up to WINDOW_SIZE
+
+static inline bool IsInRange(uint32_t id, uint32_t begin, uint32_t end)
+{
+    // Sequence number comparison that is safe against wrap-around
+    return id - begin < end - begin;
+}
+
+static inline uint32_t NextId(uint32_t id)
+{
+    // 0 is reserved for unacknowledged mode, it is skipped at the wrap-around
+    id++;
+    return id == 0 ? 1 : id;
+}
+
+namespace rls
+{
+
+TxWindow::TxWindow() : TxWindow(1)
+{
+}
+
+TxWindow::TxWindow(uint32_t firstId) : m_ring{}, m_base{firstId}, m_next{firstId}
+{
+}
+
+bool TxWindow::isFull() const
+{
+    return m_next - m_base >= WINDOW_SIZE;
+}
+
+bool TxWindow::isEmpty() const
+{
+    return m_next == m_base;
+}
+
+PduInfo &TxWindow::push(int endPointId, rrc::RrcChannel channel, OctetString &&pdu)
+{
+    if (m_next - m_base >= m_ring.size())
+        grow();
+
+    uint32_t id = m_next;
+    m_next = NextId(m_next);
+
+    auto &slot = m_ring[id % m_ring.size()];
+    slot.id = id;
+    slot.pdu = std::move(pdu);
+    slot.rrcChannel = channel;
+    slot.sentTime = utils::CurrentTimeMillis();
+    slot.endPointId = endPointId;
+    slot.retransmissions = 0;
+    return slot;
+}
+
+PduInfo *TxWindow::find(uint32_t id)
+{
+    if (id == 0 || !IsInRange(id, m_base, m_next))
+        return nullptr;
+
+    auto &slot = m_ring[id % m_ring.size()];
+    return slot.id == id ? &slot : nullptr;
+}
+
+void TxWindow::acknowledge(uint32_t cumulativeId, const std::vector<uint32_t> &selectiveIds)
+{
+    if (cumulativeId != 0 && IsInRange(cumulativeId, m_base, m_next))
+    {
+        for (uint32_t id = m_base; id != cumulativeId + 1; id++)
+            erase(id);
+    }
+
+    for (auto id : selectiveIds)
+        erase(id);
+
+    slide();
+}
+
+std::optional<PduInfo> TxWindow::release(uint32_t id)
+{
+    auto *info = find(id);
+    if (info == nullptr)
+        return std::nullopt;
+
+    PduInfo res = std::move(*info);
+    erase(id);
+    slide();
+    return res;
+}
+
+void TxWindow::reset()
+{
+    m_ring = std::vector<PduInfo>{};
+    m_base = m_next;
+}
+
+void TxWindow::erase(uint32_t id)
+{
+    auto *info = find(id);
+    if (info == nullptr)
+        return;
+
+    info->id = 0;
+    info->pdu = OctetString{};
+}
+
+void TxWindow::slide()
+{
+    while (m_base != m_next && m_ring[m_base % m_ring.size()].id != m_base)
+        m_base = NextId(m_base);
+}
+
+void TxWindow::grow()
+{
+    size_t newSize = m_ring.empty() ? INITIAL_RING_SIZE : m_ring.size() * 2;
+
+    // Sizes are powers of two, so the slot of an ID stays consistent across the wrap-around of the IDs
+    std::vector<PduInfo> ring(newSize);
+    for (auto &slot : m_ring)
+    {
+        if (slot.id != 0)
+            ring[slot.id % newSize] = std::move(slot);
+    }
+    m_ring = std::move(ring);
+}
+
+RxWindow::RxWindow() : m_received(WINDOW_SIZE), m_cumulative{}
+{
+}
+
+bool RxWindow::receive(uint32_t id)
+{
+    if (id == 0)
+        return true;
+
+    auto offset = static_cast<int32_t>(id - m_cumulative);
+
+    if (offset > static_cast<int32_t>(WINDOW_SIZE) || offset <= -static_cast<int32_t>(WINDOW_SIZE))
+    {
+        // Out of the reach of the sender's window, either side has restarted. Re-synchronise the window.
+        m_received.assign(WINDOW_SIZE, false);
+        m_cumulative = id - 1;
+    }
+    else if (offset <= 0)
+    {
+        // Already covered by the cumulative ID
+        return false;
+    }
+
+    if (m_received[id % WINDOW_SIZE])
+        return false;
+
+    m_received[id % WINDOW_SIZE] = true;
+
+    for (uint32_t next = NextId(m_cumulative); m_received[next % WINDOW_SIZE]; next = NextId(next))
+    {
+        m_received[next % WINDOW_SIZE] = false;
+        m_cumulative = next;
+    }
+
+    return true;
+}
+
+uint32_t RxWindow::cumulativeId() const
+{
+    return m_cumulative;
+}
+
+std::vector<uint32_t> RxWindow::selectiveIds() const
+{
+    std::vector<uint32_t> res;
+    for (uint32_t i = 2; i <= WINDOW_SIZE; i++)
+    {
+        uint32_t id = m_cumulative + i;
+        if (id != 0 && m_received[id % WINDOW_SIZE])
+            res.push_back(id);
+    }
+    return res;
+}
+
+RetransmissionWheel::RetransmissionWheel(size_t slotCount, int64_t tickPeriod)
+    : m_slots(slotCount), m_tickPeriod{tickPeriod}, m_lastTick{}, m_count{}
+{
+}
+
+bool RetransmissionWheel::isEmpty() const
+{
+    return m_count == 0;
+}
+
+void RetransmissionWheel::schedule(int64_t currentTime, int64_t delay, const Entry &entry)
+{
+    int64_t currentTick = currentTime / m_tickPeriod;
+    if (m_count == 0)
+        m_lastTick = currentTick;
+
+    int64_t ticks = (delay + m_tickPeriod - 1) / m_tickPeriod;
+    ticks = std::max<int64_t>(1, std::min<int64_t>(ticks, static_cast<int64_t>(m_slots.size()) - 1));
+
+    Entry e = entry;
+    e.tick = currentTick + ticks;
+
+    m_slots[static_cast<size_t>(e.tick) % m_slots.size()].push_back(e);
+    m_count++;
+}
+
+std::vector<RetransmissionWheel::Entry> RetransmissionWheel::advance(int64_t currentTime)
+{
+    std::vector<Entry> res;
+
+    int64_t currentTick = currentTime / m_tickPeriod;
+    int64_t steps = std::min<int64_t>(currentTick - m_lastTick, static_cast<int64_t>(m_slots.size()));
+
+    for (int64_t i = 1; i <= steps; i++)
+    {
+        auto &slot = m_slots[static_cast<size_t>(m_lastTick + i) % m_slots.size()];
+
+        // Entries of a later round stay in the slot
+        for (auto &entry : slot)
+        {
+            if (entry.tick <= currentTick)
+                res.push_back(entry);
+        }
+        utils::EraseWhere(slot, [currentTick](auto &entry) { return entry.tick <= currentTick; });
+    }
+
+    if (currentTick > m_lastTick)
+        m_lastTick = currentTick;
+
+    m_count -= res.size();
+    return res;
+}
+
+void RetransmissionWheel::cancel(int endPointId)
+{
+    for (auto &slot : m_slots)
+    {
+        size_t size = slot.size();
+        utils::EraseWhere(slot, [endPointId](auto &entry) { return entry.endPointId == endPointId; });
+        m_count -= size - slot.size();
+    }
+}
+
+} // namespace rls
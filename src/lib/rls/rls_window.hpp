@@ -0,0 +1,111 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "rls_base.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace rls
+{
+
+/* Transmit side of the per end point sequence window. Unacknowledged PDUs are kept in a ring buffer, which grows with
+ * the number of outstanding PDUs so that idle end points stay small */
+class TxWindow
+{
+  private:
+    std::vector<PduInfo> m_ring;
+    uint32_t m_base;
+    uint32_t m_next;
+
+  public:
+    TxWindow();
+    explicit TxWindow(uint32_t firstId);
+
+  public:
+    [[nodiscard]] bool isFull() const;
+    [[nodiscard]] bool isEmpty() const;
+
+    // Assigns the next sequence number to the PDU and stores it until it is acknowledged
+    PduInfo &push(int endPointId, rrc::RrcChannel channel, OctetString &&pdu);
+
+    // Returns nullptr if the PDU is already acknowledged or released
+    PduInfo *find(uint32_t id);
+
+    // Acknowledges all PDUs up to (including) 'cumulativeId' and the selectively acknowledged ones
+    void acknowledge(uint32_t cumulativeId, const std::vector<uint32_t> &selectiveIds);
+
+    // Removes the PDU from the window without acknowledgement, e.g. after transmission failure
+    std::optional<PduInfo> release(uint32_t id);
+
+    // Drops all the outstanding PDUs. The sequence numbers continue, so that the peer does not take the next PDUs
+    // for duplicates of the dropped ones
+    void reset();
+
+  private:
+    void erase(uint32_t id);
+    void slide();
+    void grow();
+};
+
+/* Receive side of the per end point sequence window, used for duplicate detection and cumulative/selective ACKs. The
+ * window re-synchronises to the peer if it jumps further than a window ahead or behind, which no retransmission can
+ * do, e.g. when the peer has restarted its sequence numbers */
+class RxWindow
+{
+  private:
+    std::vector<bool> m_received;
+    uint32_t m_cumulative;
+
+  public:
+    RxWindow();
+
+  public:
+    // Returns false if the PDU is a duplicate
+    bool receive(uint32_t id);
+
+    [[nodiscard]] uint32_t cumulativeId() const;
+    [[nodiscard]] std::vector<uint32_t> selectiveIds() const;
+};
+
+/* Hashed timer wheel for the retransmission timers, expired slots are processed without scanning the windows */
+class RetransmissionWheel
+{
+  public:
+    struct Entry
+    {
+        int endPointId{};
+        uint32_t id{};
+        int64_t tick{};
+    };
+
+  private:
+    std::vector<std::vector<Entry>> m_slots;
+    int64_t m_tickPeriod;
+    int64_t m_lastTick;
+    size_t m_count;
+
+  public:
+    RetransmissionWheel(size_t slotCount, int64_t tickPeriod);
+
+  public:
+    [[nodiscard]] bool isEmpty() const;
+
+    void schedule(int64_t currentTime, int64_t delay, const Entry &entry);
+
+    // Returns all the entries that expired until 'currentTime'
+    std::vector<Entry> advance(int64_t currentTime);
+
+    // Removes all the entries of the end point, e.g. when its window is reset
+    void cancel(int endPointId);
+};
+
+} // namespace rls
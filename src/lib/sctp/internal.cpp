@@ -109,14 +109,15 @@ void CloseSocket(int sd)
     close(sd);
 }
 
-void Accept(int sd)
+int Accept(int sd)
 {
-    sockaddr saddr{};
-    socklen_t saddr_size{};
+    sockaddr_storage saddr{};
+    auto saddr_size = (socklen_t)sizeof(saddr);
 
-    int clientSd = accept(sd, &saddr, &saddr_size);
+    int clientSd = accept(sd, (sockaddr *)&saddr, &saddr_size);
     if (clientSd < 0)
         ThrowError("SCTP accept failure: ", errno);
+    return clientSd;
 }
 
 void Connect(int sd, const std::string &address, uint16_t port)
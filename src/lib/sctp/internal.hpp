@@ -21,7 +21,7 @@ void SetInitOptions(int sd, int maxRxStreams, int maxTxStreams, int maxAttempts,
 void SetEventOptions(int sd);
 void StartListening(int sd);
 void CloseSocket(int sd);
-void Accept(int sd);
+int Accept(int sd);
 void Connect(int sd, const std::string &address, uint16_t port);
 void SendMessage(int sd, const uint8_t *buffer, size_t length, int ppid, uint16_t stream);
 void ReceiveMessage(int sd, uint32_t ppid, ISctpHandler *handler);
@@ -9,7 +9,7 @@
 #include "server.hpp"
 #include "internal.hpp"
 
-sctp::SctpServer::SctpServer(const std::string &address, uint16_t port) : sd(0)
+sctp::SctpServer::SctpServer(const std::string &address, uint16_t port, PayloadProtocolId ppid) : sd(0), ppid(ppid)
 {
     try
     {
@@ -31,7 +31,22 @@ sctp::SctpServer::~SctpServer()
     CloseSocket(sd);
 }
 
-void sctp::SctpServer::start()
+int sctp::SctpServer::accept()
 {
-    Accept(sd);
+    return Accept(sd);
+}
+
+void sctp::SctpServer::send(int clientSd, uint16_t stream, const uint8_t *buffer, size_t length)
+{
+    SendMessage(clientSd, buffer, length, (int)ppid, stream);
+}
+
+void sctp::SctpServer::receive(int clientSd, ISctpHandler *handler)
+{
+    ReceiveMessage(clientSd, static_cast<uint32_t>(ppid), handler);
+}
+
+void sctp::SctpServer::close(int clientSd)
+{
+    CloseSocket(clientSd);
 }
@@ -8,23 +8,31 @@
 
 #pragma once
 
+#include "types.hpp"
+
 #include <string>
 
 namespace sctp
 {
 
+/* One-to-one style listening socket. Each accepted association gets its own socket descriptor, which is used with
+ * send() and receive() and closed by the owner. */
 class SctpServer
 {
   private:
     int sd;
+    const PayloadProtocolId ppid;
 
   public:
-    SctpServer(const std::string &address, uint16_t port);
+    SctpServer(const std::string &address, uint16_t port, PayloadProtocolId ppid);
     ~SctpServer();
 
-    void start();
+    /* Blocks until a client associates, returns the socket descriptor of the association */
+    int accept();
 
-    // TODO: Other functionalities
+    void send(int clientSd, uint16_t stream, const uint8_t *buffer, size_t length);
+    void receive(int clientSd, ISctpHandler *handler);
+    void close(int clientSd);
 };
 
-} // namespace sctp
\ No newline at end of file
+} // namespace sctp
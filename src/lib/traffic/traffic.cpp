@@ -0,0 +1,392 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "traffic.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+static constexpr const uint32_t PROBE_MAGIC = 0x4E525447; // "NRTG"
+static constexpr const size_t IPV4_HEADER_SIZE = 20;
+static constexpr const size_t UDP_HEADER_SIZE = 8;
+static constexpr const uint8_t IP_PROTOCOL_UDP = 17;
+
+static constexpr const int64_t MAX_BACKLOG_US = 1000 * 1000;
+static constexpr const int MIN_POLL_PERIOD = 1;
+static constexpr const int MAX_POLL_PERIOD = 100;
+
+static constexpr const int64_t LATENCY_HIGHEST_VALUE = 60LL * 1000 * 1000; // 1 minute in microseconds
+static constexpr const int LATENCY_SIGNIFICANT_DIGITS = 3;
+
+static void Put16(uint8_t *p, uint32_t value)
+{
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+static void Put32(uint8_t *p, uint32_t value)
+{
+    Put16(p, value >> 16);
+    Put16(p + 2, value);
+}
+
+static void Put64(uint8_t *p, uint64_t value)
+{
+    Put32(p, static_cast<uint32_t>(value >> 32));
+    Put32(p + 4, static_cast<uint32_t>(value));
+}
+
+static uint32_t Get32(const uint8_t *p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+static uint64_t Get64(const uint8_t *p)
+{
+    return (static_cast<uint64_t>(Get32(p)) << 32) | Get32(p + 4);
+}
+
+static uint16_t Ipv4Checksum(const uint8_t *header)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < IPV4_HEADER_SIZE; i += 2)
+        sum += static_cast<uint32_t>((header[i] << 8) | header[i + 1]);
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<uint16_t>(~sum);
+}
+
+static double PerSecond(int64_t count, int64_t periodMs)
+{
+    return periodMs > 0 ? static_cast<double>(count) * 1000.0 / static_cast<double>(periodMs) : 0.0;
+}
+
+namespace traffic
+{
+
+bool ParseTrafficModel(const std::string &value, ETrafficModel &outModel)
+{
+    if (value == "cbr")
+        outModel = ETrafficModel::CBR;
+    else if (value == "poisson")
+        outModel = ETrafficModel::POISSON;
+    else if (value == "burst")
+        outModel = ETrafficModel::BURST;
+    else
+        return false;
+    return true;
+}
+
+int64_t ProbeTime()
+{
+    auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count();
+}
+
+OctetString BuildProbePacket(uint32_t source, uint32_t destination, uint16_t port, size_t payloadSize,
+                             const ProbeHeader &header, uint16_t ipId)
+{
+    payloadSize = std::max(payloadSize, PROBE_HEADER_SIZE);
+    size_t length = IPV4_HEADER_SIZE + UDP_HEADER_SIZE + payloadSize;
+
+    auto packet = OctetString::FromSpare(static_cast<int>(length));
+    uint8_t *ip = packet.data();
+    ip[0] = 0x45;
+    Put16(ip + 2, static_cast<uint32_t>(length));
+    Put16(ip + 4, ipId);
+    Put16(ip + 6, 0x4000); // Don't fragment
+    ip[8] = 64;
+    ip[9] = IP_PROTOCOL_UDP;
+    std::memcpy(ip + 12, &source, 4);
+    std::memcpy(ip + 16, &destination, 4);
+    Put16(ip + 10, Ipv4Checksum(ip));
+
+    uint8_t *udp = ip + IPV4_HEADER_SIZE;
+    Put16(udp, port);
+    Put16(udp + 2, port);
+    Put16(udp + 4, static_cast<uint32_t>(UDP_HEADER_SIZE + payloadSize));
+
+    uint8_t *probe = udp + UDP_HEADER_SIZE;
+    Put32(probe, PROBE_MAGIC);
+    Put32(probe + 4, header.flowId);
+    Put64(probe + 8, header.sequence);
+    Put64(probe + 16, static_cast<uint64_t>(header.timestamp));
+    return packet;
+}
+
+bool ParseProbePacket(const uint8_t *data, size_t length, ProbeHeader &outHeader)
+{
+    if (length < IPV4_HEADER_SIZE || (data[0] >> 4) != 4 || data[9] != IP_PROTOCOL_UDP)
+        return false;
+
+    size_t ipHeaderLength = (data[0] & 0xF) * 4u;
+    if (ipHeaderLength < IPV4_HEADER_SIZE || ipHeaderLength + UDP_HEADER_SIZE + PROBE_HEADER_SIZE > length)
+        return false;
+
+    const uint8_t *probe = data + ipHeaderLength + UDP_HEADER_SIZE;
+    if (Get32(probe) != PROBE_MAGIC)
+        return false;
+
+    outHeader.flowId = Get32(probe + 4);
+    outHeader.sequence = Get64(probe + 8);
+    outHeader.timestamp = static_cast<int64_t>(Get64(probe + 16));
+    return true;
+}
+
+TrafficStats &TrafficStats::operator+=(const TrafficStats &other)
+{
+    txPackets += other.txPackets;
+    txBytes += other.txBytes;
+    rxPackets += other.rxPackets;
+    rxBytes += other.rxBytes;
+    lost += other.lost;
+    reordered += other.reordered;
+    return *this;
+}
+
+TrafficStats TrafficStats::operator-(const TrafficStats &other) const
+{
+    TrafficStats res = *this;
+    res.txPackets -= other.txPackets;
+    res.txBytes -= other.txBytes;
+    res.rxPackets -= other.rxPackets;
+    res.rxBytes -= other.rxBytes;
+    res.lost -= other.lost;
+    res.reordered -= other.reordered;
+    return res;
+}
+
+TrafficSource::TrafficSource(const TrafficProfile &profile, uint32_t sourceAddress, uint32_t flowId, uint64_t seed,
+                             int64_t now)
+    : m_profile{profile}, m_sourceAddress{sourceAddress}, m_flowId{flowId}, m_random{seed}, m_startTime{now},
+      m_nextTime{static_cast<double>(now)}, m_burstIndex{}, m_sequence{}, m_ipId{}
+{
+    m_ipId = static_cast<uint16_t>(m_random());
+}
+
+void TrafficSource::generate(int64_t now, std::vector<OctetString> &packets, TrafficStats &stats)
+{
+    int64_t end = m_profile.duration > 0 ? m_startTime + m_profile.duration * 1000LL : INT64_MAX;
+    int64_t until = std::min(now, end);
+
+    if (static_cast<double>(until) - m_nextTime > static_cast<double>(MAX_BACKLOG_US))
+        m_nextTime = static_cast<double>(until);
+
+    while (m_nextTime <= static_cast<double>(until))
+    {
+        ProbeHeader header{};
+        header.flowId = m_flowId;
+        header.sequence = m_sequence++;
+        header.timestamp = now;
+
+        auto packet = BuildProbePacket(m_sourceAddress, m_profile.destination, m_profile.port,
+                                       static_cast<size_t>(m_profile.packetSize), header, m_ipId++);
+        stats.txPackets++;
+        stats.txBytes += packet.length();
+        packets.push_back(std::move(packet));
+
+        advance();
+    }
+}
+
+void TrafficSource::advance()
+{
+    switch (m_profile.model)
+    {
+    case ETrafficModel::CBR:
+        m_nextTime += 1e6 / m_profile.rate;
+        break;
+    case ETrafficModel::POISSON:
+        m_nextTime += std::exponential_distribution<double>{m_profile.rate}(m_random) * 1e6;
+        break;
+    case ETrafficModel::BURST:
+        if (++m_burstIndex >= m_profile.burstSize)
+        {
+            m_burstIndex = 0;
+            m_nextTime += 1e6 * m_profile.burstSize / m_profile.rate;
+        }
+        break;
+    }
+}
+
+int TrafficSource::pollPeriod() const
+{
+    double interval = 1000.0 / m_profile.rate;
+    if (m_profile.model == ETrafficModel::BURST)
+        interval *= m_profile.burstSize;
+    return std::clamp(static_cast<int>(interval), MIN_POLL_PERIOD, MAX_POLL_PERIOD);
+}
+
+TrafficSink::TrafficSink()
+    : m_started{}, m_highestSequence{}, m_firstTime{}, m_lastTime{}, m_latencyMin{}, m_latencyMax{}, m_latencySum{},
+      m_jitter{}, m_lastTransit{}, m_pendingLatencies{}
+{
+}
+
+void TrafficSink::receive(const ProbeHeader &header, size_t packetSize, int64_t now, TrafficStats &stats)
+{
+    int64_t latency = now - header.timestamp;
+
+    if (!m_started)
+    {
+        m_started = true;
+        m_firstTime = now;
+        m_highestSequence = header.sequence;
+        m_latencyMin = latency;
+        m_latencyMax = latency;
+        m_lastTransit = latency;
+        stats.lost += static_cast<int64_t>(header.sequence); // Sequence numbers start from zero
+    }
+    else if (header.sequence > m_highestSequence)
+    {
+        stats.lost += static_cast<int64_t>(header.sequence - m_highestSequence - 1);
+        m_highestSequence = header.sequence;
+    }
+    else
+    {
+        // Late or duplicate, a late one fills a gap counted as lost
+        stats.reordered++;
+        if (stats.lost > 0)
+            stats.lost--;
+    }
+
+    stats.rxPackets++;
+    stats.rxBytes += static_cast<int64_t>(packetSize);
+    m_lastTime = now;
+
+    m_latencyMin = std::min(m_latencyMin, latency);
+    m_latencyMax = std::max(m_latencyMax, latency);
+    m_latencySum += static_cast<double>(latency);
+    m_jitter += (std::abs(static_cast<double>(latency - m_lastTransit)) - m_jitter) / 16.0;
+    m_lastTransit = latency;
+
+    // Negative if the clocks of the hosts are not synchronized
+    m_pendingLatencies.push_back(std::max(latency, int64_t{0}));
+}
+
+std::vector<int64_t> &TrafficSink::pendingLatencies()
+{
+    return m_pendingLatencies;
+}
+
+Json TrafficSink::toJson(const TrafficStats &stats) const
+{
+    Json json = ToJson(stats);
+    if (!m_started)
+        return json;
+
+    int64_t duration = m_lastTime - m_firstTime;
+    json.put("rx-mbps", static_cast<int64_t>(duration > 0 ? stats.rxBytes * 8 / duration : 0));
+    json.put("latency-min-us", m_latencyMin);
+    json.put("latency-mean-us", static_cast<int64_t>(std::llround(m_latencySum / static_cast<double>(stats.rxPackets))));
+    json.put("latency-max-us", m_latencyMax);
+    json.put("jitter-us", static_cast<int64_t>(std::llround(m_jitter)));
+    return json;
+}
+
+TrafficMetrics::TrafficMetrics()
+    : m_mutex{}, m_stats{}, m_flowCount{},
+      m_latency{std::make_unique<HdrHistogram>(LATENCY_HIGHEST_VALUE, LATENCY_SIGNIFICANT_DIGITS)},
+      m_periodLatency{std::make_unique<HdrHistogram>(LATENCY_HIGHEST_VALUE, LATENCY_SIGNIFICANT_DIGITS)}
+{
+}
+
+void TrafficMetrics::addFlow(int delta)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_flowCount += delta;
+}
+
+void TrafficMetrics::report(const TrafficStats &delta, std::vector<int64_t> &latencies)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats += delta;
+    for (int64_t latency : latencies)
+    {
+        m_latency->record(latency);
+        m_periodLatency->record(latency);
+    }
+    latencies.clear();
+}
+
+TrafficStats TrafficMetrics::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+Json TrafficMetrics::toJson() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Json json = ToJson(m_stats);
+    json.put("flows", m_flowCount);
+    if (m_latency->totalCount() > 0)
+    {
+        json.put("latency-p50-us", m_latency->valueAtPercentile(50.0));
+        json.put("latency-p90-us", m_latency->valueAtPercentile(90.0));
+        json.put("latency-p99-us", m_latency->valueAtPercentile(99.0));
+        json.put("latency-max-us", m_latency->maxValue());
+    }
+    return json;
+}
+
+std::string TrafficMetrics::summary(const TrafficStats &previous, int64_t periodMs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    TrafficStats delta = m_stats - previous;
+
+    std::stringstream ss{};
+    ss.precision(1);
+    ss << std::fixed;
+    ss << m_flowCount << " flows, tx " << PerSecond(delta.txPackets, periodMs) << " pkt/s "
+       << PerSecond(delta.txBytes * 8, periodMs) / 1e6 << " Mbit/s, rx " << PerSecond(delta.rxPackets, periodMs)
+       << " pkt/s " << PerSecond(delta.rxBytes * 8, periodMs) / 1e6 << " Mbit/s, lost " << delta.lost
+       << ", reordered " << delta.reordered;
+    if (m_periodLatency->totalCount() > 0)
+    {
+        ss << ", latency p50 " << m_periodLatency->valueAtPercentile(50.0) << " us p99 "
+           << m_periodLatency->valueAtPercentile(99.0) << " us";
+    }
+    m_periodLatency->reset();
+    return ss.str();
+}
+
+Json ToJson(const ETrafficModel &model)
+{
+    switch (model)
+    {
+    case ETrafficModel::CBR:
+        return "cbr";
+    case ETrafficModel::POISSON:
+        return "poisson";
+    case ETrafficModel::BURST:
+        return "burst";
+    default:
+        return "?";
+    }
+}
+
+Json ToJson(const TrafficStats &stats)
+{
+    return Json::Obj({
+        {"tx-packets", stats.txPackets},
+        {"tx-bytes", stats.txBytes},
+        {"rx-packets", stats.rxPackets},
+        {"rx-bytes", stats.rxBytes},
+        {"lost", stats.lost},
+        {"reordered", stats.reordered},
+    });
+}
+
+} // namespace traffic
@@ -0,0 +1,162 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <utils/hdr_histogram.hpp>
+#include <utils/json.hpp>
+#include <utils/octet_string.hpp>
+
+namespace traffic
+{
+
+enum class ETrafficModel
+{
+    CBR,     // Evenly spaced packets
+    POISSON, // Exponentially distributed gaps
+    BURST,   // Packets back to back in bursts, evenly spaced bursts
+};
+
+bool ParseTrafficModel(const std::string &value, ETrafficModel &outModel);
+
+struct TrafficProfile
+{
+    ETrafficModel model{};
+    double rate = 100.0;    // Packets per second, the average one for POISSON and BURST
+    int packetSize = 1000;  // UDP payload in bytes, at least PROBE_HEADER_SIZE
+    int burstSize = 10;     // Packets per burst for BURST
+    uint32_t destination{}; // IPv4 address in network byte order
+    uint16_t port = 5001;   // Both the source and the destination port
+    int duration{};         // ms, zero for no end
+};
+
+/* Start of the UDP payload of each generated packet, after a magic number. The rest of the payload is zero. */
+struct ProbeHeader
+{
+    uint32_t flowId{};
+    uint64_t sequence{}; // Starts from zero for each flow
+    int64_t timestamp{}; // ProbeTime() at the sender
+};
+
+static constexpr const size_t PROBE_HEADER_SIZE = 24;
+
+/* Microseconds on the realtime clock, so that the latency can be measured between processes and between hosts whose
+ * clocks are synchronized */
+int64_t ProbeTime();
+
+/* An IPv4/UDP packet with the probe header, the UDP checksum is not used */
+OctetString BuildProbePacket(uint32_t source, uint32_t destination, uint16_t port, size_t payloadSize,
+                             const ProbeHeader &header, uint16_t ipId);
+
+/* Returns false if the packet is not an IPv4/UDP packet with a probe header */
+bool ParseProbePacket(const uint8_t *data, size_t length, ProbeHeader &outHeader);
+
+struct TrafficStats
+{
+    int64_t txPackets{};
+    int64_t txBytes{};
+    int64_t rxPackets{};
+    int64_t rxBytes{};
+    int64_t lost{};      // Gaps in the received sequence numbers, less the packets arrived late to fill them
+    int64_t reordered{}; // Arrived after a packet with a higher sequence number
+
+    TrafficStats &operator+=(const TrafficStats &other);
+    TrafficStats operator-(const TrafficStats &other) const;
+};
+
+/* Schedules and builds the packets of a flow according to a traffic profile */
+class TrafficSource
+{
+  private:
+    TrafficProfile m_profile;
+    uint32_t m_sourceAddress;
+    uint32_t m_flowId;
+    std::mt19937_64 m_random;
+    int64_t m_startTime;
+    double m_nextTime; // Fractional microseconds, so that the CBR rate does not drift
+    int m_burstIndex;
+    uint64_t m_sequence;
+    uint16_t m_ipId;
+
+  public:
+    TrafficSource(const TrafficProfile &profile, uint32_t sourceAddress, uint32_t flowId, uint64_t seed, int64_t now);
+
+  public:
+    /* Appends the packets due until the given time. The backlog of a source which is polled too late is dropped
+     * instead of being sent at once. */
+    void generate(int64_t now, std::vector<OctetString> &packets, TrafficStats &stats);
+
+    /* Period in ms to poll the source at, coarser for lower rates */
+    [[nodiscard]] int pollPeriod() const;
+
+  private:
+    void advance();
+};
+
+/* Measures the received packets of a flow */
+class TrafficSink
+{
+  private:
+    bool m_started;
+    uint64_t m_highestSequence;
+    int64_t m_firstTime;
+    int64_t m_lastTime;
+    int64_t m_latencyMin;
+    int64_t m_latencyMax;
+    double m_latencySum;
+    double m_jitter; // Interarrival jitter of RFC 3550
+    int64_t m_lastTransit;
+    std::vector<int64_t> m_pendingLatencies; // Not yet taken to the metrics of the process
+
+  public:
+    TrafficSink();
+
+  public:
+    void receive(const ProbeHeader &header, size_t packetSize, int64_t now, TrafficStats &stats);
+    std::vector<int64_t> &pendingLatencies();
+
+    /* Latency, jitter and throughput since the first packet */
+    [[nodiscard]] Json toJson(const TrafficStats &stats) const;
+};
+
+/* Totals of the traffic of all flows of the process with the latency percentiles, thread safe. The flows report to
+ * it periodically rather than per packet. */
+class TrafficMetrics
+{
+  private:
+    mutable std::mutex m_mutex;
+    TrafficStats m_stats;
+    int m_flowCount;
+    std::unique_ptr<HdrHistogram> m_latency;
+    std::unique_ptr<HdrHistogram> m_periodLatency; // Since the last summary
+
+  public:
+    TrafficMetrics();
+
+  public:
+    void addFlow(int delta);
+    void report(const TrafficStats &delta, std::vector<int64_t> &latencies);
+
+    [[nodiscard]] TrafficStats stats() const;
+    [[nodiscard]] Json toJson() const;
+    /* Rates and latencies over the period since the previous summary, for a periodic log line */
+    std::string summary(const TrafficStats &previous, int64_t periodMs);
+};
+
+Json ToJson(const ETrafficModel &model);
+Json ToJson(const TrafficStats &stats);
+
+} // namespace traffic
@@ -0,0 +1,267 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <lib/app/base_app.hpp>
+#include <lib/sctp/types.hpp>
+#include <replay/capture_file.hpp>
+#include <replay/replayer.hpp>
+#include <utils/common.hpp>
+#include <utils/constants.hpp>
+#include <utils/libc_error.hpp>
+#include <utils/options.hpp>
+
+static constexpr const int DEFAULT_LINGER = 1000; // Milliseconds to wait for the answers after the last packet
+
+static struct Options
+{
+    std::string captureFile{};
+    std::string interface{};
+    std::string outputFile{};
+    int linger{};
+    bool list{};
+    nr::replay::ReplayConfig config{};
+} g_options{};
+
+static double ParseSpeed(const std::string &value)
+{
+    if (value == "max")
+        return 0.0;
+
+    std::string number = value;
+    if (!number.empty() && number.back() == 'x')
+        number.pop_back();
+
+    double speed = 0.0;
+    try
+    {
+        speed = std::stod(number);
+    }
+    catch (const std::exception &)
+    {
+        throw std::runtime_error("Invalid speed: " + value);
+    }
+    if (!(speed > 0.0))
+        throw std::runtime_error("Invalid speed: " + value);
+    return speed;
+}
+
+static void ReadOptions(int argc, char **argv)
+{
+    opt::OptionsDescription desc{cons::Project,
+                                 cons::Tag,
+                                 "Replays the packets a gNB or a UE received in a capture, in place of its peers",
+                                 cons::Owner,
+                                 "nr-replay",
+                                 {"-r <capture-file> [option...]"},
+                                 {"nr-replay -r gnb.pcapng -s 10x", "nr-replay -r ue.pcapng -i imsi-286010000000001 -s max"},
+                                 true,
+                                 false};
+
+    opt::OptionItem itemRead = {'r', "read", "Replay the specified pcapng file written by --capture of the nodes",
+                                "capture-file"};
+    opt::OptionItem itemInterface = {'i', "interface",
+                                     "Replay the packets received by the specified node of the capture, required if "
+                                     "there are more than one",
+                                     "name"};
+    opt::OptionItem itemSpeed = {'s', "speed", "Replay at the captured pace multiplied by the specified factor, or as "
+                                               "fast as possible with 'max'. The default is 1",
+                                 "factor"};
+    opt::OptionItem itemTarget = {'t', "target",
+                                  "Send to the node at the specified address instead of the captured one", "address"};
+    opt::OptionItem itemProtocols = {'p', "protocols",
+                                     "Replay only the specified comma separated protocols: ngap, rls and gtp",
+                                     "protocols"};
+    opt::OptionItem itemLinger = {std::nullopt, "linger",
+                                  "Wait the specified milliseconds for the answers of the node after the last packet "
+                                  "instead of " +
+                                      std::to_string(DEFAULT_LINGER),
+                                  "ms"};
+    opt::OptionItem itemOutput = {'o', "output", "Also write the results in JSON to the specified file", "file"};
+    opt::OptionItem itemList = {'l', "list", "List the nodes of the capture and their packets without replaying",
+                                std::nullopt};
+
+    desc.items.push_back(itemRead);
+    desc.items.push_back(itemInterface);
+    desc.items.push_back(itemSpeed);
+    desc.items.push_back(itemTarget);
+    desc.items.push_back(itemProtocols);
+    desc.items.push_back(itemLinger);
+    desc.items.push_back(itemOutput);
+    desc.items.push_back(itemList);
+
+    opt::OptionsResult opt{argc, argv, desc, false, nullptr};
+
+    g_options.captureFile = opt.getOption(itemRead);
+    if (opt.hasFlag(itemInterface))
+        g_options.interface = opt.getOption(itemInterface);
+    if (opt.hasFlag(itemSpeed))
+        g_options.config.speed = ParseSpeed(opt.getOption(itemSpeed));
+    if (opt.hasFlag(itemTarget))
+        g_options.config.target = opt.getOption(itemTarget);
+
+    if (opt.hasFlag(itemProtocols))
+    {
+        for (auto &selected : g_options.config.protocols)
+            selected = false;
+
+        std::stringstream stream{opt.getOption(itemProtocols)};
+        std::string protocol;
+        while (std::getline(stream, protocol, ','))
+        {
+            if (protocol == "ngap")
+                g_options.config.protocols[static_cast<int>(CaptureProtocol::NGAP)] = true;
+            else if (protocol == "rls")
+                g_options.config.protocols[static_cast<int>(CaptureProtocol::RLS)] = true;
+            else if (protocol == "gtp")
+                g_options.config.protocols[static_cast<int>(CaptureProtocol::GTP)] = true;
+            else
+                throw std::runtime_error("Invalid protocol: " + protocol);
+        }
+    }
+
+    g_options.linger = DEFAULT_LINGER;
+    if (opt.hasFlag(itemLinger))
+    {
+        g_options.linger = utils::ParseInt(opt.getOption(itemLinger));
+        if (g_options.linger < 0)
+            throw std::runtime_error("Invalid linger time");
+    }
+
+    if (opt.hasFlag(itemOutput))
+        g_options.outputFile = opt.getOption(itemOutput);
+
+    g_options.list = opt.hasFlag(itemList);
+}
+
+static void ListInterfaces(const nr::replay::CaptureFile &capture)
+{
+    // Packet counts of each interface by protocol and direction
+    std::map<std::pair<uint32_t, std::string>, int64_t> counts{};
+    for (auto &packet : capture.packets())
+    {
+        std::string key = nr::replay::ToString(packet.protocol) +
+                          (packet.direction == CaptureDirection::INBOUND ? " in" : " out");
+        counts[{packet.interface, key}]++;
+    }
+
+    auto &interfaces = capture.interfaces();
+    for (uint32_t i = 0; i < interfaces.size(); i++)
+    {
+        std::cout << interfaces[i].name << std::endl;
+        for (auto &item : counts)
+            if (item.first.first == i)
+                std::printf("  %-10s %lld\n", item.first.second.c_str(), static_cast<long long>(item.second));
+    }
+}
+
+static uint32_t SelectInterface(const nr::replay::CaptureFile &capture)
+{
+    auto &interfaces = capture.interfaces();
+    if (interfaces.empty())
+        throw std::runtime_error("The capture has no nodes");
+
+    if (g_options.interface.empty())
+    {
+        if (interfaces.size() > 1)
+            throw std::runtime_error("The capture has more than one node, select one with --interface");
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < interfaces.size(); i++)
+        if (interfaces[i].name == g_options.interface)
+            return i;
+    throw std::runtime_error("Node not found in the capture: " + g_options.interface);
+}
+
+static void PrintResults(const Json &results)
+{
+    std::printf("%-10s %8s %12s %14s %12s %14s %8s\n", "protocol", "peers", "sent", "sent-bytes", "received",
+                "received-bytes", "errors");
+    for (auto &item : results)
+    {
+        if (item.first != "protocols")
+            continue;
+        for (auto &protocol : item.second)
+        {
+            auto &fields = protocol.second;
+            std::map<std::string, std::string> values{};
+            for (auto &field : fields)
+                values[field.first] = field.second.str();
+            std::printf("%-10s %8s %12s %14s %12s %14s %8s\n", values["protocol"].c_str(), values["peers"].c_str(),
+                        values["sent"].c_str(), values["sent-bytes"].c_str(), values["received"].c_str(),
+                        values["received-bytes"].c_str(), values["send-errors"].c_str());
+        }
+    }
+
+    for (auto &item : results)
+    {
+        if (item.first == "protocols")
+            continue;
+        if (item.second.isObject())
+        {
+            for (auto &field : item.second)
+                std::printf("%s %s: %s\n", item.first.c_str(), field.first.c_str(), field.second.str().c_str());
+        }
+        else
+        {
+            std::printf("%s: %s\n", item.first.c_str(), item.second.str().c_str());
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    app::Initialize();
+
+    try
+    {
+        ReadOptions(argc, argv);
+
+        nr::replay::CaptureFile capture{g_options.captureFile};
+        if (g_options.list)
+        {
+            ListInterfaces(capture);
+            return 0;
+        }
+
+        std::cerr << cons::Name << std::endl;
+
+        g_options.config.interface = SelectInterface(capture);
+        nr::replay::Replayer replayer{capture, g_options.config};
+        if (replayer.packetCount() == 0)
+            throw std::runtime_error("No packets to replay");
+
+        replayer.prepare();
+        std::cerr << "Replaying " << replayer.packetCount() << " packets" << std::endl;
+        replayer.run(g_options.linger);
+
+        auto results = replayer.toJson();
+        PrintResults(results);
+
+        if (!g_options.outputFile.empty())
+        {
+            std::ofstream file(g_options.outputFile);
+            file << results.dumpJson() << std::endl;
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
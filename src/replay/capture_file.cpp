@@ -0,0 +1,347 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "capture_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+
+#include <utils/constants.hpp>
+
+static constexpr const uint16_t LINKTYPE_IPV4 = 228;
+static constexpr const uint16_t LINKTYPE_IPV6 = 229;
+static constexpr const uint32_t NGAP_PPID = 60;
+
+template <typename T>
+static T ReadHost(const uint8_t *p)
+{
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+static uint16_t Read2(const uint8_t *p)
+{
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+static uint32_t Read4(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 |
+           static_cast<uint32_t>(p[3]);
+}
+
+static size_t Pad4(size_t size)
+{
+    return (size + 3) & ~static_cast<size_t>(3);
+}
+
+static CaptureAddress MakeAddress(uint8_t family, const uint8_t *address, uint16_t port)
+{
+    CaptureAddress res{};
+    res.family = family;
+    std::memcpy(res.address, address, family == 6 ? 16 : 4);
+    res.port = port;
+    return res;
+}
+
+/* Calls the function with the code, the value and the value length of each option of a block */
+template <typename F>
+static void ForEachOption(const uint8_t *options, size_t size, F &&fun)
+{
+    size_t offset = 0;
+    while (offset + 4 <= size)
+    {
+        uint16_t code = ReadHost<uint16_t>(options + offset);
+        uint16_t length = ReadHost<uint16_t>(options + offset + 2);
+        if (code == pcapng::OPT_END || offset + 4 + length > size)
+            return;
+        fun(code, options + offset + 4, length);
+        offset += 4 + Pad4(length);
+    }
+}
+
+namespace nr::replay
+{
+
+CaptureFile::CaptureFile(const std::string &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        throw std::runtime_error("Capture file could not be opened: " + path);
+    std::vector<uint8_t> file{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+
+    // Interface ids are per section, they are numbered through the whole file here
+    std::vector<int> resolutions{};
+    std::vector<uint16_t> linkTypes{};
+    uint32_t interfaceBase = 0;
+    bool hasSection = false;
+
+    size_t offset = 0;
+    while (offset + 12 <= file.size())
+    {
+        const uint8_t *block = file.data() + offset;
+        uint32_t type = ReadHost<uint32_t>(block);
+
+        if (type == pcapng::SECTION_HEADER_BLOCK)
+        {
+            uint32_t magic = ReadHost<uint32_t>(block + 8);
+            if (magic != pcapng::BYTE_ORDER_MAGIC)
+                throw std::runtime_error("Capture files of the other byte order are not supported");
+            interfaceBase = static_cast<uint32_t>(m_interfaces.size());
+            resolutions.clear();
+            linkTypes.clear();
+            hasSection = true;
+        }
+        else if (!hasSection)
+        {
+            throw std::runtime_error("Not a pcapng file: " + path);
+        }
+
+        uint32_t length = ReadHost<uint32_t>(block + 4);
+        if (length < 12 || length % 4 != 0 || offset + length > file.size())
+            throw std::runtime_error("Truncated capture file: " + path);
+
+        const uint8_t *body = block + 8;
+        size_t bodySize = length - 12;
+
+        if (type == pcapng::INTERFACE_DESCRIPTION_BLOCK)
+            readInterfaceDescription(body, bodySize, resolutions, linkTypes);
+        else if (type == pcapng::ENHANCED_PACKET_BLOCK)
+            readEnhancedPacket(body, bodySize, interfaceBase, resolutions, linkTypes);
+
+        offset += length;
+    }
+
+    if (!hasSection)
+        throw std::runtime_error("Not a pcapng file: " + path);
+}
+
+void CaptureFile::readInterfaceDescription(const uint8_t *body, size_t size, std::vector<int> &resolutions,
+                                           std::vector<uint16_t> &linkTypes)
+{
+    if (size < 8)
+        throw std::runtime_error("Invalid interface description block");
+
+    CapturedInterface interface{};
+    interface.name = "interface-" + std::to_string(m_interfaces.size());
+    int resolution = 6; // Microseconds unless stated
+
+    ForEachOption(body + 8, size - 8, [&](uint16_t code, const uint8_t *value, uint16_t length) {
+        if (code == pcapng::OPT_IF_NAME)
+            interface.name = std::string{reinterpret_cast<const char *>(value), length};
+        else if (code == pcapng::OPT_IF_TSRESOL && length >= 1)
+            resolution = value[0];
+    });
+
+    // Only the resolutions in negative powers of ten are supported, which are the usual ones
+    if (resolution & 0x80 || resolution > 9)
+        throw std::runtime_error("Unsupported time resolution of interface " + interface.name);
+
+    linkTypes.push_back(ReadHost<uint16_t>(body));
+    resolutions.push_back(resolution);
+    m_interfaces.push_back(std::move(interface));
+}
+
+void CaptureFile::readEnhancedPacket(const uint8_t *body, size_t size, uint32_t interfaceBase,
+                                     const std::vector<int> &resolutions, const std::vector<uint16_t> &linkTypes)
+{
+    if (size < 20)
+        throw std::runtime_error("Invalid enhanced packet block");
+
+    uint32_t interface = ReadHost<uint32_t>(body);
+    if (interface >= resolutions.size())
+        throw std::runtime_error("Packet of an undescribed interface");
+
+    uint64_t timestamp = static_cast<uint64_t>(ReadHost<uint32_t>(body + 4)) << 32 | ReadHost<uint32_t>(body + 8);
+    uint32_t capturedLength = ReadHost<uint32_t>(body + 12);
+    uint32_t originalLength = ReadHost<uint32_t>(body + 16);
+    if (20 + Pad4(capturedLength) > size)
+        throw std::runtime_error("Invalid enhanced packet block");
+
+    uint16_t linkType = linkTypes[interface];
+    if (capturedLength != originalLength ||
+        (linkType != pcapng::LINKTYPE_RAW && linkType != LINKTYPE_IPV4 && linkType != LINKTYPE_IPV6))
+    {
+        m_skipped++;
+        return;
+    }
+
+    uint32_t flags = 0;
+    ForEachOption(body + 20 + Pad4(capturedLength), size - 20 - Pad4(capturedLength),
+                  [&](uint16_t code, const uint8_t *value, uint16_t length) {
+                      if (code == pcapng::OPT_EPB_FLAGS && length == 4)
+                          flags = ReadHost<uint32_t>(value);
+                  });
+
+    int64_t scale = 1;
+    for (int i = resolutions[interface]; i < 9; i++)
+        scale *= 10;
+
+    CapturedPacket packet{};
+    packet.interface = interfaceBase + interface;
+    packet.time = static_cast<int64_t>(timestamp) * scale;
+
+    uint32_t direction = flags & 0x03;
+    if (direction == static_cast<uint32_t>(CaptureDirection::INBOUND))
+        packet.direction = CaptureDirection::INBOUND;
+    else if (direction == static_cast<uint32_t>(CaptureDirection::OUTBOUND))
+        packet.direction = CaptureDirection::OUTBOUND;
+    else
+    {
+        m_skipped++;
+        return;
+    }
+
+    readIpPacket(std::move(packet), body + 20, capturedLength);
+}
+
+void CaptureFile::readIpPacket(CapturedPacket &&packet, const uint8_t *data, size_t size)
+{
+    if (size < 1)
+    {
+        m_skipped++;
+        return;
+    }
+
+    uint8_t family;
+    uint8_t protocol;
+    const uint8_t *src;
+    const uint8_t *dst;
+    size_t headerSize;
+
+    if (data[0] >> 4 == 4 && size >= 20)
+    {
+        family = 4;
+        headerSize = static_cast<size_t>(data[0] & 0x0F) * 4;
+        protocol = data[9];
+        src = data + 12;
+        dst = data + 16;
+        size = std::min(size, static_cast<size_t>(Read2(data + 2)));
+    }
+    else if (data[0] >> 4 == 6 && size >= 40)
+    {
+        family = 6;
+        headerSize = 40;
+        protocol = data[6];
+        src = data + 8;
+        dst = data + 24;
+        size = std::min(size, 40 + static_cast<size_t>(Read2(data + 4)));
+    }
+    else
+    {
+        m_skipped++;
+        return;
+    }
+
+    if (size < headerSize + 8)
+    {
+        m_skipped++;
+        return;
+    }
+
+    const uint8_t *transport = data + headerSize;
+    size_t transportSize = size - headerSize;
+    uint16_t srcPort = Read2(transport);
+    uint16_t dstPort = Read2(transport + 2);
+
+    bool inbound = packet.direction == CaptureDirection::INBOUND;
+    packet.local = MakeAddress(family, inbound ? dst : src, inbound ? dstPort : srcPort);
+    packet.remote = MakeAddress(family, inbound ? src : dst, inbound ? srcPort : dstPort);
+
+    if (protocol == pcapng::IP_PROTOCOL_UDP)
+    {
+        if (srcPort == cons::PortalPort || dstPort == cons::PortalPort)
+            packet.protocol = CaptureProtocol::RLS;
+        else if (srcPort == cons::GtpPort || dstPort == cons::GtpPort)
+            packet.protocol = CaptureProtocol::GTP;
+        else
+        {
+            m_skipped++;
+            return;
+        }
+
+        size_t udpSize = std::min(transportSize, static_cast<size_t>(Read2(transport + 4)));
+        if (udpSize < 8)
+        {
+            m_skipped++;
+            return;
+        }
+        packet.data.assign(transport + 8, transport + udpSize);
+        m_packets.push_back(std::move(packet));
+        return;
+    }
+
+    if (protocol != pcapng::IP_PROTOCOL_SCTP || transportSize < 12)
+    {
+        m_skipped++;
+        return;
+    }
+
+    // Each complete DATA chunk with the NGAP payload protocol identifier is a PDU
+    size_t offset = 12;
+    while (offset + 4 <= transportSize)
+    {
+        const uint8_t *chunk = transport + offset;
+        uint8_t chunkType = chunk[0];
+        uint8_t chunkFlags = chunk[1];
+        size_t chunkLength = Read2(chunk + 2);
+        if (chunkLength < 4 || offset + chunkLength > transportSize)
+            break;
+
+        if (chunkType == 0 && chunkLength >= 16 && (chunkFlags & 0x03) == 0x03 && Read4(chunk + 12) == NGAP_PPID)
+        {
+            CapturedPacket pdu = packet;
+            pdu.protocol = CaptureProtocol::NGAP;
+            pdu.stream = Read2(chunk + 8);
+            pdu.data.assign(chunk + 16, chunk + chunkLength);
+            m_packets.push_back(std::move(pdu));
+        }
+        else
+        {
+            m_skipped++;
+        }
+
+        offset += Pad4(chunkLength);
+    }
+}
+
+std::string ToString(CaptureProtocol protocol)
+{
+    switch (protocol)
+    {
+    case CaptureProtocol::NGAP:
+        return "ngap";
+    case CaptureProtocol::RLS:
+        return "rls";
+    case CaptureProtocol::GTP:
+        return "gtp";
+    default:
+        return "?";
+    }
+}
+
+std::string ToString(const CaptureAddress &address)
+{
+    char buffer[INET6_ADDRSTRLEN] = {0};
+    if (inet_ntop(address.family == 6 ? AF_INET6 : AF_INET, address.address, buffer, sizeof(buffer)) == nullptr)
+        return "?";
+    return buffer;
+}
+
+InetAddress ToInetAddress(const CaptureAddress &address)
+{
+    return InetAddress{ToString(address), address.port};
+}
+
+} // namespace nr::replay
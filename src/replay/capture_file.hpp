@@ -0,0 +1,82 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <utils/network.hpp>
+#include <utils/packet_capture.hpp>
+
+namespace nr::replay
+{
+
+/* A captured NGAP PDU, RLS datagram or GTP-U packet without its IP and transport headers */
+struct CapturedPacket
+{
+    uint32_t interface{};
+    int64_t time{}; // Nanoseconds since the epoch
+    CaptureProtocol protocol{};
+    CaptureDirection direction{};
+    CaptureAddress local{};
+    CaptureAddress remote{};
+    uint16_t stream{};
+    std::vector<uint8_t> data{};
+};
+
+struct CapturedInterface
+{
+    std::string name{};
+};
+
+/* Reads the pcapng files written by PacketCapture. Packets of other protocols, packets without a direction and
+ * fragmented SCTP messages are skipped. */
+class CaptureFile
+{
+  private:
+    std::vector<CapturedInterface> m_interfaces{};
+    std::vector<CapturedPacket> m_packets{};
+    int64_t m_skipped{};
+
+  public:
+    /* Throws std::runtime_error if the file cannot be read or is not a pcapng file */
+    explicit CaptureFile(const std::string &path);
+
+  public:
+    [[nodiscard]] const std::vector<CapturedInterface> &interfaces() const
+    {
+        return m_interfaces;
+    }
+
+    [[nodiscard]] const std::vector<CapturedPacket> &packets() const
+    {
+        return m_packets;
+    }
+
+    [[nodiscard]] int64_t skipped() const
+    {
+        return m_skipped;
+    }
+
+  private:
+    void readInterfaceDescription(const uint8_t *body, size_t size, std::vector<int> &resolutions,
+                                  std::vector<uint16_t> &linkTypes);
+    void readEnhancedPacket(const uint8_t *body, size_t size, uint32_t interfaceBase,
+                            const std::vector<int> &resolutions, const std::vector<uint16_t> &linkTypes);
+    void readIpPacket(CapturedPacket &&packet, const uint8_t *data, size_t size);
+};
+
+std::string ToString(CaptureProtocol protocol);
+std::string ToString(const CaptureAddress &address);
+
+/* Returns the socket address, the address must be of a known family */
+InetAddress ToInetAddress(const CaptureAddress &address);
+
+} // namespace nr::replay
@@ -0,0 +1,348 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "replayer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include <sys/socket.h>
+
+#include <utils/common.hpp>
+#include <utils/libc_error.hpp>
+
+static constexpr const int RECEIVE_TIMEOUT = 200;
+static constexpr const int RECEIVE_BUFFER_SIZE = 65536;
+static constexpr const int SOCKET_BUFFER_SIZE = 4 * 1024 * 1024;
+static constexpr const int64_t MAX_LAG_US = 60ll * 1000 * 1000;
+
+static std::string PeerKey(CaptureProtocol protocol, const CaptureAddress &address)
+{
+    std::string key{static_cast<char>(protocol)};
+    key += static_cast<char>(address.family);
+    key.append(reinterpret_cast<const char *>(address.address), sizeof(address.address));
+    key += std::to_string(address.port);
+    return key;
+}
+
+static void EnlargeBuffers(const Socket &socket)
+{
+    // Best effort, the limits of the system apply
+    int size = SOCKET_BUFFER_SIZE;
+    setsockopt(socket.getFd(), SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    setsockopt(socket.getFd(), SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+}
+
+namespace nr::replay
+{
+
+class CountingHandler : public sctp::ISctpHandler
+{
+  private:
+    std::atomic<int64_t> &m_received;
+    std::atomic<int64_t> &m_receivedBytes;
+    bool m_shutdown;
+
+  public:
+    CountingHandler(std::atomic<int64_t> &received, std::atomic<int64_t> &receivedBytes)
+        : m_received{received}, m_receivedBytes{receivedBytes}, m_shutdown{}
+    {
+    }
+
+    [[nodiscard]] bool isShutdown() const
+    {
+        return m_shutdown;
+    }
+
+  private:
+    void onAssociationSetup(int associationId, int inStreams, int outStreams) override
+    {
+    }
+
+    void onAssociationShutdown() override
+    {
+        m_shutdown = true;
+    }
+
+    void onMessage(const uint8_t *buffer, size_t length, uint16_t stream) override
+    {
+        m_received++;
+        m_receivedBytes += static_cast<int64_t>(length);
+    }
+
+    void onUnhandledNotification() override
+    {
+    }
+};
+
+Replayer::Replayer(const CaptureFile &capture, const ReplayConfig &config)
+    : m_config{config}, m_packets{}, m_packetPeers{}, m_peers{}, m_stopping{}, m_stats{}, m_lag{MAX_LAG_US, 3},
+      m_duration{}
+{
+    // What the node received is what its peers are to send
+    for (auto &packet : capture.packets())
+    {
+        if (packet.interface == config.interface && packet.direction == CaptureDirection::INBOUND &&
+            config.protocols[static_cast<int>(packet.protocol)])
+            m_packets.push_back(&packet);
+    }
+
+    // The ring of the capture is filled in the order of reservation, which may slightly differ from the time order
+    std::stable_sort(m_packets.begin(), m_packets.end(),
+                     [](const CapturedPacket *a, const CapturedPacket *b) { return a->time < b->time; });
+}
+
+Replayer::~Replayer()
+{
+    m_stopping = true;
+    for (auto &item : m_peers)
+    {
+        auto &peer = item.second;
+        if (peer->sctpClient >= 0)
+            ::shutdown(peer->sctpClient, SHUT_RDWR);
+        if (peer->receiver)
+            peer->receiver->join();
+        if (peer->sctpClient >= 0)
+            peer->sctpServer->close(peer->sctpClient);
+        if (peer->socket.hasFd())
+            peer->socket.close();
+    }
+}
+
+Replayer::Peer *Replayer::findOrCreatePeer(const CapturedPacket &packet)
+{
+    auto &peer = m_peers[PeerKey(packet.protocol, packet.remote)];
+    if (peer)
+        return peer.get();
+
+    peer = std::make_unique<Peer>();
+    peer->protocol = packet.protocol;
+    peer->address = packet.remote;
+
+    if (packet.protocol == CaptureProtocol::NGAP)
+    {
+        // The gNB is always the client of the AMF
+        peer->listens = true;
+        peer->sctpServer =
+            std::make_unique<sctp::SctpServer>(ToString(packet.remote), packet.remote.port, sctp::PayloadProtocolId::NGAP);
+        return peer.get();
+    }
+
+    // The local port of a client is not known to the capture, as it is an ephemeral one
+    peer->listens = packet.local.port == 0;
+    if (peer->listens)
+    {
+        peer->socket = Socket::CreateAndBindUdp(ToInetAddress(packet.remote));
+    }
+    else
+    {
+        CaptureAddress destination = packet.local;
+        if (!m_config.target.empty())
+            destination = CaptureAddress{InetAddress{m_config.target, packet.local.port}};
+        peer->destination = ToInetAddress(destination);
+        peer->socket = destination.family == 6 ? Socket::CreateUdp6() : Socket::CreateUdp4();
+        peer->connected = true;
+    }
+    EnlargeBuffers(peer->socket);
+    return peer.get();
+}
+
+void Replayer::startReceiver(Peer *peer)
+{
+    if (peer->protocol == CaptureProtocol::NGAP)
+    {
+        peer->receiver = std::make_unique<std::thread>([this, peer]() {
+            CountingHandler handler{peer->received, peer->receivedBytes};
+            while (!m_stopping && !handler.isShutdown())
+            {
+                try
+                {
+                    peer->sctpServer->receive(peer->sctpClient, &handler);
+                }
+                catch (const sctp::SctpError &)
+                {
+                    break;
+                }
+            }
+        });
+        return;
+    }
+
+    peer->receiver = std::make_unique<std::thread>([this, peer]() {
+        std::vector<uint8_t> buffer(RECEIVE_BUFFER_SIZE);
+        while (!m_stopping)
+        {
+            InetAddress from{};
+            int size;
+            try
+            {
+                size = peer->socket.receive(buffer.data(), buffer.size(), RECEIVE_TIMEOUT, from);
+            }
+            catch (const LibError &)
+            {
+                break;
+            }
+            if (size <= 0)
+                continue;
+
+            // A listening peer answers whoever called it first
+            if (peer->listens && !peer->connected)
+            {
+                peer->destination = from;
+                peer->connected.store(true, std::memory_order_release);
+            }
+            peer->received++;
+            peer->receivedBytes += size;
+        }
+    });
+}
+
+void Replayer::prepare()
+{
+    m_packetPeers.reserve(m_packets.size());
+    for (auto *packet : m_packets)
+        m_packetPeers.push_back(findOrCreatePeer(*packet));
+
+    for (auto &item : m_peers)
+    {
+        auto *peer = item.second.get();
+        if (peer->protocol == CaptureProtocol::NGAP)
+        {
+            std::cerr << "Waiting for the node to connect to " << ToString(peer->protocol) << " peer "
+                      << ToString(peer->address) << ":" << peer->address.port << std::endl;
+            peer->sctpClient = peer->sctpServer->accept();
+            peer->connected = true;
+        }
+        startReceiver(peer);
+    }
+
+    for (auto &item : m_peers)
+    {
+        auto *peer = item.second.get();
+        if (peer->connected.load(std::memory_order_acquire))
+            continue;
+
+        std::cerr << "Waiting for the node to call " << ToString(peer->protocol) << " peer "
+                  << ToString(peer->address) << ":" << peer->address.port << std::endl;
+        while (!peer->connected.load(std::memory_order_acquire))
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+void Replayer::send(Peer *peer, const CapturedPacket &packet)
+{
+    auto &stats = m_stats[static_cast<int>(packet.protocol)];
+    try
+    {
+        if (peer->protocol == CaptureProtocol::NGAP)
+        {
+            peer->sctpServer->send(peer->sctpClient, packet.stream, packet.data.data(), packet.data.size());
+        }
+        else
+        {
+            // Blocking, so that the kernel paces the replay at full speed instead of dropping
+            ssize_t rc = ::sendto(peer->socket.getFd(), packet.data.data(), packet.data.size(), 0,
+                                  peer->destination.getSockAddr(), peer->destination.getSockLen());
+            if (rc < 0)
+                throw LibError("sendto failed: ", errno);
+        }
+        stats.sent++;
+        stats.sentBytes += static_cast<int64_t>(packet.data.size());
+    }
+    catch (const std::runtime_error &)
+    {
+        stats.errors++;
+    }
+}
+
+void Replayer::run(int lingerMs)
+{
+    if (m_packets.empty())
+        return;
+
+    int64_t firstPacket = m_packets[0]->time;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < m_packets.size(); i++)
+    {
+        auto &packet = *m_packets[i];
+
+        if (m_config.speed > 0.0)
+        {
+            auto offset = static_cast<int64_t>(static_cast<double>(packet.time - firstPacket) / m_config.speed);
+            auto due = start + std::chrono::nanoseconds(offset);
+            std::this_thread::sleep_until(due);
+
+            auto lag = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - due);
+            m_lag.record(std::max<int64_t>(1, lag.count()));
+        }
+
+        send(m_packetPeers[i], packet);
+    }
+
+    m_duration =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(lingerMs));
+}
+
+Json Replayer::toJson() const
+{
+    double seconds = static_cast<double>(m_duration) / 1e6;
+
+    int64_t sent = 0;
+    std::vector<Json> protocols{};
+    for (auto protocol : {CaptureProtocol::NGAP, CaptureProtocol::RLS, CaptureProtocol::GTP})
+    {
+        auto &stats = m_stats[static_cast<int>(protocol)];
+        int64_t received = 0, receivedBytes = 0, peers = 0;
+        for (auto &item : m_peers)
+        {
+            if (item.second->protocol != protocol)
+                continue;
+            peers++;
+            received += item.second->received;
+            receivedBytes += item.second->receivedBytes;
+        }
+        if (peers == 0)
+            continue;
+
+        sent += stats.sent;
+        protocols.push_back(Json::Obj({
+            {"protocol", ToString(protocol)},
+            {"peers", peers},
+            {"sent", stats.sent},
+            {"sent-bytes", stats.sentBytes},
+            {"send-errors", stats.errors},
+            {"received", received},
+            {"received-bytes", receivedBytes},
+        }));
+    }
+
+    Json res = Json::Obj({
+        {"speed", m_config.speed > 0.0 ? Json{m_config.speed} : Json{"max"}},
+        {"packets", static_cast<int64_t>(m_packets.size())},
+        {"duration-ms", m_duration / 1000},
+        {"packets-per-sec", seconds > 0.0 ? static_cast<double>(sent) / seconds : 0.0},
+        {"protocols", Json::Arr(std::move(protocols))},
+    });
+
+    if (m_lag.totalCount() > 0)
+    {
+        res.put("lag-us", Json::Obj({
+                              {"p50", m_lag.valueAtPercentile(50.0)},
+                              {"p99", m_lag.valueAtPercentile(99.0)},
+                              {"max", m_lag.maxValue()},
+                          }));
+    }
+    return res;
+}
+
+} // namespace nr::replay
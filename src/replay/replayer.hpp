@@ -0,0 +1,108 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "capture_file.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/sctp/server.hpp>
+#include <utils/hdr_histogram.hpp>
+#include <utils/json.hpp>
+#include <utils/network.hpp>
+
+namespace nr::replay
+{
+
+struct ReplayConfig
+{
+    uint32_t interface{};
+    double speed = 1.0; // Zero for as fast as possible
+    std::string target{}; // Address of the node, the captured one if empty
+    bool protocols[4] = {false, true, true, true}; // Indexed by CaptureProtocol
+};
+
+/* Feeds the packets which a node received in a capture back into a node, taking the place of all its peers: the AMF
+ * for NGAP, the UEs or the gNBs for RLS and the UPF for GTP-U. The packets are sent as captured at the original pace,
+ * scaled by the speed, and whatever the node sends back is counted and discarded. The replay is open loop, it does
+ * not wait for the answers of the node.
+ *
+ * A peer of a node which was captured listening on a port, like the gNB for RLS and GTP-U, sends from an ephemeral
+ * port to the captured or the target address. A peer of a node which was captured as a client, like the gNB for NGAP
+ * or the UE for RLS, listens on its own captured address instead and the replay waits until the node calls it. */
+class Replayer
+{
+  private:
+    struct Peer
+    {
+        CaptureProtocol protocol{};
+        CaptureAddress address{}; // As captured
+        bool listens{};
+
+        Socket socket{};
+        std::unique_ptr<sctp::SctpServer> sctpServer{};
+        int sctpClient = -1;
+        InetAddress destination{};
+        std::atomic<bool> connected{};
+
+        std::atomic<int64_t> received{};
+        std::atomic<int64_t> receivedBytes{};
+        std::unique_ptr<std::thread> receiver{};
+    };
+
+    struct ProtocolStats
+    {
+        int64_t sent{};
+        int64_t sentBytes{};
+        int64_t errors{};
+    };
+
+  private:
+    ReplayConfig m_config;
+    std::vector<const CapturedPacket *> m_packets;
+    std::vector<Peer *> m_packetPeers; // Peer of each packet
+    std::unordered_map<std::string, std::unique_ptr<Peer>> m_peers;
+    std::atomic<bool> m_stopping;
+
+    ProtocolStats m_stats[4];
+    HdrHistogram m_lag; // Microseconds behind the schedule of each packet
+    int64_t m_duration;
+
+  public:
+    Replayer(const CaptureFile &capture, const ReplayConfig &config);
+    ~Replayer();
+
+  public:
+    [[nodiscard]] size_t packetCount() const
+    {
+        return m_packets.size();
+    }
+
+    /* Creates the peers and waits until the node has called each listening peer, throws on socket errors */
+    void prepare();
+
+    /* Sends the packets, then waits the given milliseconds for the answers of the node */
+    void run(int lingerMs);
+
+    [[nodiscard]] Json toJson() const;
+
+  private:
+    Peer *findOrCreatePeer(const CapturedPacket &packet);
+    void startReceiver(Peer *peer);
+    void send(Peer *peer, const CapturedPacket &packet);
+};
+
+} // namespace nr::replay
@@ -0,0 +1,145 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <lib/crypt/aes.hpp>
+#include <lib/crypt/crypt.hpp>
+
+static int g_failures = 0;
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s (%s)\n", __FILE__, __LINE__, #condition,                     \
+                         crypto::AesBackend());                                                                        \
+            g_failures++;                                                                                              \
+        }                                                                                                              \
+    } while (false)
+
+static bool Equals(const uint8_t *data, const OctetString &expected)
+{
+    return std::memcmp(data, expected.data(), static_cast<size_t>(expected.length())) == 0;
+}
+
+/* RFC 4493, section 4 */
+static void TestCmac()
+{
+    auto key = OctetString::FromHex("2b7e151628aed2a6abf7158809cf4f3c");
+    auto message = OctetString::FromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                                        "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+    const struct
+    {
+        size_t length;
+        const char *mac;
+    } vectors[] = {
+        {0, "bb1d6929e95937287fa37d129b756746"},
+        {16, "070a16b46b4d4144f79bdd9dd04a287c"},
+        {40, "dfa66747de9ae63030ca32611497c827"},
+        {64, "51f0bebf7e3b9d92fc49741779363cfe"},
+    };
+
+    crypto::AesKey aes{key.data()};
+    for (auto &vector : vectors)
+    {
+        uint8_t mac[16];
+        aes.cmac(message.data(), vector.length, mac);
+        CHECK(Equals(mac, OctetString::FromHex(vector.mac)));
+    }
+}
+
+/* TS 33.401, annex C.1, 128-EEA2 test set 1. The message is 253 bits, the unused bits of the last octet are not
+ * compared. */
+static void TestEea2()
+{
+    auto key = OctetString::FromHex("d3c5d592327fb11c4035c6680af8c6d1");
+    auto plain = OctetString::FromHex("981ba6824c1bfb1ab485472029b71d808ce33e2cc3c0b5fc1f3de8a6dc66b1f0");
+    auto cipher = OctetString::FromHex("e9fed8a63d155304d71df20bf3e82214b20ed7dad2f233dc3c22d7bdeeed8e78");
+
+    auto message = plain.copy();
+    crypto::EncryptEea2(0x398a59b4, 0x15, 1, message, key);
+    CHECK(message.length() == 32);
+    CHECK(std::memcmp(message.data(), cipher.data(), 31) == 0);
+    CHECK((message.data()[31] & 0xf8) == (cipher.data()[31] & 0xf8));
+
+    crypto::DecryptEea2(0x398a59b4, 0x15, 1, message, key);
+    CHECK(Equals(message.data(), plain));
+}
+
+/* Counter mode against a block by block reference. The lower 64 bits of the counter block are incremented and wrap
+ * around without touching the upper 64 bits. The lengths cover the multi-block path, a single block and a partial
+ * last block. */
+static void TestCtrCarry()
+{
+    auto key = OctetString::FromHex("2b7e151628aed2a6abf7158809cf4f3c");
+    crypto::AesKey aes{key.data()};
+
+    const char *ivs[] = {
+        "f0f1f2f3f4f5f6f700000000fffffffa", // carry out of the low 32 bits
+        "f0f1f2f3f4f5f6f7fffffffffffffffa", // wrap-around of the 64 bit counter
+    };
+    const size_t lengths[] = {1, 15, 16, 17, 127, 128, 200, 253};
+
+    for (auto *ivHex : ivs)
+    {
+        auto iv = OctetString::FromHex(ivHex);
+        for (size_t length : lengths)
+        {
+            std::vector<uint8_t> data(length);
+            for (size_t i = 0; i < length; i++)
+                data[i] = static_cast<uint8_t>(i * 31 + 7);
+
+            std::vector<uint8_t> expected = data;
+            uint8_t block[16];
+            std::memcpy(block, iv.data(), 16);
+            for (size_t offset = 0; offset < length; offset += 16)
+            {
+                uint8_t keystream[16];
+                aes.encryptBlock(block, keystream);
+                for (size_t i = 0; i < 16 && offset + i < length; i++)
+                    expected[offset + i] ^= keystream[i];
+
+                for (int i = 15; i >= 8; i--)
+                    if (++block[i] != 0)
+                        break;
+            }
+
+            aes.ctr(iv.data(), data.data(), length);
+            CHECK(data == expected);
+        }
+    }
+}
+
+static void RunAll()
+{
+    TestCmac();
+    TestEea2();
+    TestCtrCarry();
+}
+
+int main()
+{
+    // The CPU may not have AES-NI, in which case both runs are on the portable implementation
+    std::printf("backend: %s\n", crypto::AesBackend());
+    RunAll();
+
+    crypto::ForcePortableAes();
+    std::printf("backend: %s\n", crypto::AesBackend());
+    RunAll();
+
+    if (g_failures != 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include <cstdio>
+#include <vector>
+
+#include <lib/rls/rls_window.hpp>
+
+static int g_failures = 0;
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);                         \
+            g_failures++;                                                                                              \
+        }                                                                                                              \
+    } while (false)
+
+static uint32_t Push(rls::TxWindow &window)
+{
+    return window.push(1, rrc::RrcChannel::UL_DCCH, OctetString::FromSpare(8)).id;
+}
+
+static void TestWrapAround()
+{
+    rls::TxWindow tx{0xFFFFFF00};
+    rls::RxWindow rx{};
+
+    // In order up to the wrap-around, the receiver re-synchronises to the first PDU
+    for (uint32_t i = 0; i < 0xFE; i++)
+    {
+        uint32_t id = Push(tx);
+        CHECK(rx.receive(id));
+        tx.acknowledge(rx.cumulativeId(), rx.selectiveIds());
+    }
+    CHECK(tx.isEmpty());
+    CHECK(rx.cumulativeId() == 0xFFFFFFFD);
+
+    std::vector<uint32_t> ids{};
+    for (int i = 0; i < 4; i++)
+        ids.push_back(Push(tx));
+
+    // 0 is never used as it means unacknowledged mode
+    CHECK((ids == std::vector<uint32_t>{0xFFFFFFFE, 0xFFFFFFFF, 1, 2}));
+
+    // Out of order across the wrap-around
+    CHECK(rx.receive(0xFFFFFFFE));
+    CHECK(rx.receive(1));
+    CHECK(rx.cumulativeId() == 0xFFFFFFFE);
+    CHECK((rx.selectiveIds() == std::vector<uint32_t>{1}));
+    CHECK(!rx.receive(1));
+    CHECK(rx.receive(0xFFFFFFFF));
+    CHECK(rx.cumulativeId() == 1);
+    CHECK(rx.selectiveIds().empty());
+    CHECK(rx.receive(2));
+    CHECK(rx.cumulativeId() == 2);
+    CHECK(!rx.receive(0xFFFFFFFF));
+
+    tx.acknowledge(rx.cumulativeId(), rx.selectiveIds());
+    CHECK(tx.isEmpty());
+    CHECK(tx.find(1) == nullptr);
+    CHECK(Push(tx) == 3);
+}
+
+static void TestSelectiveAcknowledgement()
+{
+    rls::TxWindow tx{};
+    for (int i = 0; i < 5; i++)
+        Push(tx);
+
+    tx.acknowledge(1, {3, 5});
+    CHECK(tx.find(1) == nullptr);
+    CHECK(tx.find(2) != nullptr);
+    CHECK(tx.find(3) == nullptr);
+    CHECK(tx.find(4) != nullptr);
+
+    auto released = tx.release(2);
+    CHECK(released.has_value() && released->id == 2);
+    tx.acknowledge(4, {});
+    CHECK(tx.isEmpty());
+}
+
+static void TestReset()
+{
+    rls::TxWindow tx{};
+    rls::RxWindow rx{};
+
+    // The peer has received the first half of the window, then the link stalls until the window is full
+    uint32_t last = 0;
+    while (!tx.isFull())
+    {
+        last = Push(tx);
+        if (last <= 128)
+            rx.receive(last);
+    }
+    CHECK(last == 256);
+    CHECK(rx.cumulativeId() == 128);
+
+    tx.reset();
+    CHECK(tx.isEmpty());
+    CHECK(!tx.isFull());
+    CHECK(tx.find(200) == nullptr);
+
+    // The sequence numbers continue after the reset, so the peer takes the next PDUs for new ones
+    uint32_t id = Push(tx);
+    CHECK(id == 257);
+    CHECK(rx.receive(id));
+    CHECK(!rx.receive(id));
+
+    tx.acknowledge(rx.cumulativeId(), rx.selectiveIds());
+    CHECK(tx.isEmpty());
+}
+
+static void TestPeerRestart()
+{
+    rls::RxWindow rx{};
+    for (uint32_t id = 1; id <= 1000; id++)
+        rx.receive(id);
+    CHECK(rx.cumulativeId() == 1000);
+
+    // Retransmissions within the reach of the sender's window are duplicates
+    CHECK(!rx.receive(1000));
+    CHECK(!rx.receive(1000 - 255));
+
+    // A new sender starts over from 1, which no retransmission can be
+    CHECK(rx.receive(1));
+    CHECK(rx.cumulativeId() == 1);
+    CHECK(rx.receive(2));
+    CHECK(!rx.receive(1));
+}
+
+static void TestWheelCancel()
+{
+    rls::RetransmissionWheel wheel{64, 100};
+    wheel.schedule(0, 500, {1, 10, 0});
+    wheel.schedule(0, 500, {2, 10, 0});
+    wheel.schedule(0, 900, {1, 11, 0});
+
+    wheel.cancel(1);
+    CHECK(!wheel.isEmpty());
+
+    auto expired = wheel.advance(1000);
+    CHECK(expired.size() == 1 && expired[0].endPointId == 2 && expired[0].id == 10);
+    CHECK(wheel.isEmpty());
+}
+
+int main()
+{
+    TestWrapAround();
+    TestSelectiveAcknowledgement();
+    TestReset();
+    TestPeerRestart();
+    TestWheelCancel();
+
+    if (g_failures != 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
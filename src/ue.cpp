@@ -6,9 +6,13 @@
 // and subject to the terms and conditions defined in LICENSE file.
 //
 
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <thread>
 
+#include <arpa/inet.h>
 #include <unistd.h>
 
 #include <lib/app/base_app.hpp>
@@ -16,18 +20,41 @@
 #include <lib/app/cli_cmd.hpp>
 #include <lib/app/proc_table.hpp>
 #include <lib/app/ue_ctl.hpp>
+#include <lib/traffic/traffic.hpp>
+#include <ue/load/driver.hpp>
+#include <ue/metrics.hpp>
+#include <ue/rls/endpoint.hpp>
+#include <ue/subscribers/db.hpp>
+#include <ue/tun/shared.hpp>
 #include <ue/ue.hpp>
 #include <utils/common.hpp>
 #include <utils/concurrent_map.hpp>
 #include <utils/constants.hpp>
+#include <utils/libc_error.hpp>
+#include <utils/nts_trace.hpp>
 #include <utils/options.hpp>
+#include <utils/packet_capture.hpp>
 #include <utils/yaml_utils.hpp>
 #include <yaml-cpp/yaml.h>
 
 static app::CliServer *g_cliServer = nullptr;
-static nr::ue::UeConfig *g_refConfig = nullptr;
+static std::shared_ptr<nr::ue::UeProfile> g_profile{};
 static ConcurrentMap<std::string, nr::ue::UserEquipment *> g_ueMap{};
 static app::CliResponseTask *g_cliRespTask = nullptr;
+static nr::ue::UeHostContext *g_hostContext = nullptr;
+static std::unique_ptr<nr::ue::LoadProfile> g_loadProfile{};
+static nr::ue::UeLoadDriver *g_loadDriver = nullptr;
+static nr::ue::ProcedureMetrics *g_procMetrics = nullptr;
+static traffic::TrafficMetrics *g_trafficMetrics = nullptr;
+static std::unique_ptr<nr::ue::SubscriberDb> g_subscriberDb{};
+
+static constexpr const int MAX_UE_COUNT_WITHOUT_HOST = 512;
+static constexpr const int TIMER_ID_MEMORY_REPORT = 1;
+static constexpr const int TIMER_PERIOD_MEMORY_REPORT = 10000;
+static constexpr const int TIMER_ID_TRAFFIC_REPORT = 2;
+static constexpr const int TIMER_PERIOD_TRAFFIC_REPORT = 5000;
+static constexpr const size_t NTS_TRACE_RECORDS_PER_THREAD = 8192;
+static constexpr const size_t CAPTURE_RING_SIZE = 32 * 1024 * 1024;
 
 static struct Options
 {
@@ -36,6 +63,13 @@ static struct Options
     bool disableCmd{};
     std::string imsi{};
     int count{};
+    int threads{};
+    std::string latencyDumpFile{};
+    std::string subscriberFile{};
+    std::string subscriberCompileFile{};
+    std::string ntsTraceFile{};
+    std::string captureFile{};
+    bool sharedTun{};
 } g_options{};
 
 struct NwUeControllerCmd : NtsMessage
@@ -53,11 +87,65 @@ struct NwUeControllerCmd : NtsMessage
     }
 };
 
+static void DumpLatencies()
+{
+    if (g_options.latencyDumpFile.empty() || g_procMetrics == nullptr)
+        return;
+
+    std::ofstream file(g_options.latencyDumpFile);
+    file << g_procMetrics->toJson(true).dumpJson() << std::endl;
+}
+
+static void ExportNtsTrace()
+{
+    if (!g_options.ntsTraceFile.empty())
+        NtsTrace::ExportChromeJson(g_options.ntsTraceFile);
+}
+
+static void StopCapture()
+{
+    int64_t dropped = PacketCapture::Stop();
+    if (dropped > 0)
+        std::cerr << "WARNING: " << dropped << " packets were dropped from the capture" << std::endl;
+}
+
+static int64_t ResidentMemoryKb()
+{
+    // The second field is the resident set size in pages
+    std::ifstream statm("/proc/self/statm");
+    int64_t size = 0, resident = 0;
+    if (!(statm >> size >> resident))
+        return 0;
+    return resident * ::sysconf(_SC_PAGESIZE) / 1024;
+}
+
 class UeControllerTask : public NtsTask
 {
+  private:
+    std::unique_ptr<Logger> m_logger;
+    int64_t m_baselineRss{};
+    std::unique_ptr<Logger> m_trafficLogger;
+    traffic::TrafficStats m_lastTrafficStats{};
+
+  public:
+    void enableMemoryReport(LogBase *logBase, int64_t baselineRss)
+    {
+        m_logger = logBase->makeUniqueLogger("host");
+        m_baselineRss = baselineRss;
+    }
+
+    void enableTrafficReport(LogBase *logBase)
+    {
+        m_trafficLogger = logBase->makeUniqueLogger("traffic");
+    }
+
   protected:
     void onStart() override
     {
+        if (m_logger)
+            setTimer(TIMER_ID_MEMORY_REPORT, TIMER_PERIOD_MEMORY_REPORT);
+        if (m_trafficLogger)
+            setTimer(TIMER_ID_TRAFFIC_REPORT, TIMER_PERIOD_TRAFFIC_REPORT);
     }
 
     void onLoop() override
@@ -65,7 +153,21 @@ class UeControllerTask : public NtsTask
         auto *msg = take();
         if (msg == nullptr)
             return;
-        if (msg->msgType == NtsMessageType::UE_CTL_COMMAND)
+        if (msg->msgType == NtsMessageType::TIMER_EXPIRED)
+        {
+            auto *w = dynamic_cast<NmTimerExpired *>(msg);
+            if (w->timerId == TIMER_ID_MEMORY_REPORT)
+            {
+                reportMemory();
+                setTimer(TIMER_ID_MEMORY_REPORT, TIMER_PERIOD_MEMORY_REPORT);
+            }
+            else if (w->timerId == TIMER_ID_TRAFFIC_REPORT)
+            {
+                reportTraffic();
+                setTimer(TIMER_ID_TRAFFIC_REPORT, TIMER_PERIOD_TRAFFIC_REPORT);
+            }
+        }
+        else if (msg->msgType == NtsMessageType::UE_CTL_COMMAND)
         {
             auto *w = dynamic_cast<NwUeControllerCmd *>(msg);
             switch (w->present)
@@ -80,8 +182,16 @@ class UeControllerTask : public NtsTask
                 if (key.empty())
                     return;
 
+                if (g_loadDriver)
+                    g_loadDriver->removeUe(w->ue);
+
                 if (g_ueMap.removeAndGetSize(key) == 0)
+                {
+                    DumpLatencies();
+                    ExportNtsTrace();
+                    StopCapture();
                     exit(0);
+                }
 
                 delete w->ue;
                 break;
@@ -93,13 +203,126 @@ class UeControllerTask : public NtsTask
     void onQuit() override
     {
     }
+
+  private:
+    void reportMemory()
+    {
+        size_t count = g_ueMap.size();
+        int64_t rss = ResidentMemoryKb();
+        int64_t perUe = count > 0 ? (rss - m_baselineRss) / static_cast<int64_t>(count) : 0;
+        m_logger->info(FMT_STRING("{} UEs, RSS {} KB, {} KB per UE"), static_cast<int>(count),
+                       static_cast<long long>(rss), static_cast<long long>(perUe));
+    }
+
+    void reportTraffic()
+    {
+        m_trafficLogger->info(FMT_STRING("{}"),
+                              g_trafficMetrics->summary(m_lastTrafficStats, TIMER_PERIOD_TRAFFIC_REPORT));
+        m_lastTrafficStats = g_trafficMetrics->stats();
+    }
 };
 
 static UeControllerTask *g_controllerTask;
 
-static nr::ue::UeConfig *ReadConfigYaml()
+static Vector3 ReadVector3(const YAML::Node &node)
+{
+    return Vector3{yaml::GetInt32(node, "x"), yaml::GetInt32(node, "y"), yaml::GetInt32(node, "z")};
+}
+
+static void ReadMobility(const YAML::Node &node, radio::MobilityConfig &mobility)
+{
+    std::string model = yaml::GetString(node, "model");
+    if (!radio::ParseMobilityModel(model, mobility.model))
+        throw std::runtime_error("Invalid mobility model: " + model);
+
+    if (yaml::HasField(node, "position"))
+        mobility.position = ReadVector3(node["position"]);
+    if (yaml::HasField(node, "loop"))
+        mobility.loop = yaml::GetBool(node, "loop");
+
+    if (mobility.model == radio::EMobilityModel::RANDOM_WAYPOINT)
+    {
+        yaml::AssertHasFields(node, {"areaMin", "areaMax"});
+        mobility.areaMin = ReadVector3(node["areaMin"]);
+        mobility.areaMax = ReadVector3(node["areaMax"]);
+        if (yaml::HasField(node, "minSpeed"))
+            mobility.minSpeed = static_cast<float>(yaml::GetDouble(node, "minSpeed", 0.1, 1000));
+        if (yaml::HasField(node, "maxSpeed"))
+            mobility.maxSpeed = static_cast<float>(yaml::GetDouble(node, "maxSpeed", 0.1, 1000));
+        if (yaml::HasField(node, "pauseTime"))
+            mobility.pauseTime = yaml::GetInt32(node, "pauseTime", 0, std::nullopt);
+        if (yaml::HasField(node, "seed"))
+            mobility.seed = static_cast<uint64_t>(yaml::GetInt64(node, "seed", 0, std::nullopt));
+    }
+    else if (mobility.model == radio::EMobilityModel::ROUTE)
+    {
+        for (auto &waypoint : yaml::GetSequence(node, "waypoints"))
+            mobility.waypoints.push_back(ReadVector3(waypoint));
+        if (mobility.waypoints.empty())
+            throw std::runtime_error("Mobility route must have at least one waypoint");
+        if (yaml::HasField(node, "speed"))
+            mobility.speed = static_cast<float>(yaml::GetDouble(node, "speed", 0.1, 1000));
+    }
+    else if (mobility.model == radio::EMobilityModel::TRACE)
+    {
+        mobility.trace = radio::LoadMobilityTrace(yaml::GetString(node, "traceFile"));
+    }
+}
+
+static traffic::TrafficProfile ReadTrafficProfile(const YAML::Node &node)
+{
+    traffic::TrafficProfile profile{};
+
+    std::string model = yaml::GetString(node, "model");
+    if (!traffic::ParseTrafficModel(model, profile.model))
+        throw std::runtime_error("Invalid traffic model: " + model);
+
+    std::string destination = yaml::GetIp4(node, "destination");
+    profile.destination = inet_addr(destination.c_str());
+
+    if (yaml::HasField(node, "rate"))
+        profile.rate = yaml::GetDouble(node, "rate", 0.001, 1000000);
+    if (yaml::HasField(node, "size"))
+        profile.packetSize = yaml::GetInt32(node, "size", static_cast<int>(traffic::PROBE_HEADER_SIZE), 65000);
+    if (yaml::HasField(node, "burstSize"))
+        profile.burstSize = yaml::GetInt32(node, "burstSize", 1, 10000);
+    if (yaml::HasField(node, "port"))
+        profile.port = static_cast<uint16_t>(yaml::GetInt32(node, "port", 1, 65535));
+    if (yaml::HasField(node, "duration"))
+        profile.duration = yaml::GetInt32(node, "duration", 0, std::nullopt);
+    return profile;
+}
+
+static void ReadLoadProfile(const YAML::Node &node, nr::ue::LoadProfile &profile)
 {
-    auto *result = new nr::ue::UeConfig();
+    std::string arrival = yaml::GetString(node, "arrival");
+    if (!nr::ue::ParseArrivalProcess(arrival, profile.arrival))
+        throw std::runtime_error("Invalid UE arrival process: " + arrival);
+
+    profile.rate = yaml::GetDouble(node, "rate", 0.001, std::nullopt);
+
+    if (profile.arrival == nr::ue::EArrivalProcess::RAMP)
+    {
+        profile.rampDuration = yaml::GetInt32(node, "rampDuration", 0, std::nullopt);
+        if (yaml::HasField(node, "startRate"))
+            profile.startRate = yaml::GetDouble(node, "startRate", 0.001, std::nullopt);
+    }
+
+    if (yaml::HasField(node, "deregistration"))
+        profile.deregistrationPeriod = yaml::GetInt32(node, "deregistration", 0, std::nullopt);
+    if (yaml::HasField(node, "serviceRequest"))
+        profile.serviceRequestPeriod = yaml::GetInt32(node, "serviceRequest", 0, std::nullopt);
+    if (yaml::HasField(node, "sessionChurn"))
+        profile.sessionChurnPeriod = yaml::GetInt32(node, "sessionChurn", 0, std::nullopt);
+    if (yaml::HasField(node, "reportPeriod"))
+        profile.reportPeriod = yaml::GetInt32(node, "reportPeriod", 100, std::nullopt);
+    if (yaml::HasField(node, "seed"))
+        profile.seed = static_cast<uint64_t>(yaml::GetInt64(node, "seed", 0, std::nullopt));
+}
+
+static std::shared_ptr<nr::ue::UeProfile> ReadConfigYaml()
+{
+    auto result = std::make_shared<nr::ue::UeProfile>();
     auto config = YAML::LoadFile(g_options.configFile);
 
     result->hplmn.mcc = yaml::GetInt32(config, "mcc", 1, 999);
@@ -110,6 +333,30 @@ static nr::ue::UeConfig *ReadConfigYaml()
     for (auto &gnbSearchItem : yaml::GetSequence(config, "gnbSearchList"))
         result->gnbSearchList.push_back(gnbSearchItem.as<std::string>());
 
+    if (yaml::HasField(config, "rlsTransport"))
+    {
+        std::string transport = yaml::GetString(config, "rlsTransport");
+        if (!rls::ParseTransportType(transport, result->rlsTransport))
+            throw std::runtime_error("Invalid RLS transport: " + transport);
+    }
+
+    if (yaml::HasField(config, "tunMtu"))
+        result->tunMtu = yaml::GetInt32(config, "tunMtu", 576, 9000);
+    if (yaml::HasField(config, "tunOffload"))
+        result->tunOffload = yaml::GetBool(config, "tunOffload");
+
+    if (yaml::HasField(config, "mobility"))
+        ReadMobility(config["mobility"], result->mobility);
+
+    if (yaml::HasField(config, "traffic"))
+        result->traffic = ReadTrafficProfile(config["traffic"]);
+
+    if (yaml::HasField(config, "loadProfile"))
+    {
+        g_loadProfile = std::make_unique<nr::ue::LoadProfile>();
+        ReadLoadProfile(config["loadProfile"], *g_loadProfile);
+    }
+
     if (yaml::HasField(config, "default-nssai"))
     {
         for (auto &sNssai : yaml::GetSequence(config, "default-nssai"))
@@ -250,12 +497,47 @@ static void ReadOptions(int argc, char **argv)
                                       std::nullopt};
     opt::OptionItem itemDisableRouting = {'r', "no-routing-config",
                                           "Do not auto configure routing for UE TUN interface", std::nullopt};
+    opt::OptionItem itemThreads = {'t', "threads",
+                                   "Run the UEs on the specified number of shared threads with a shared RLS socket",
+                                   "num"};
+    opt::OptionItem itemLatencyDump = {'d', "latency-dump",
+                                       "Dump the procedure latency histograms of the UEs to the specified file at exit",
+                                       "file"};
+    opt::OptionItem itemSubscribers = {'s', "subscribers",
+                                       "Take the keys and slices of each UE from the specified bulk subscriber file",
+                                       "file"};
+    opt::OptionItem itemSubscribersCompile = {'b', "subscribers-compile",
+                                              "Write the subscriber file in the binary format to the specified file "
+                                              "and exit",
+                                              "file"};
+    opt::OptionItem itemLogLevel = {std::nullopt, "log-level",
+                                    "Log the messages of the specified level and above: debug, info, warn or error",
+                                    "level"};
+    opt::OptionItem itemNtsTrace = {std::nullopt, "nts-trace",
+                                    "Trace the messages between the tasks and write the trace in Chrome trace format "
+                                    "to the specified file at exit",
+                                    "file"};
+    opt::OptionItem itemCapture = {std::nullopt, "capture", "Capture the RLS packets into the specified pcapng file",
+                                   "file"};
+
+    opt::OptionItem itemSharedTun = {std::nullopt, "shared-tun",
+                                     "Share one multi-queue TUN interface between the PDU sessions of all the UEs, "
+                                     "implies the shared threads",
+                                     std::nullopt};
 
     desc.items.push_back(itemConfigFile);
     desc.items.push_back(itemImsi);
     desc.items.push_back(itemCount);
     desc.items.push_back(itemDisableCmd);
     desc.items.push_back(itemDisableRouting);
+    desc.items.push_back(itemThreads);
+    desc.items.push_back(itemLatencyDump);
+    desc.items.push_back(itemSubscribers);
+    desc.items.push_back(itemSubscribersCompile);
+    desc.items.push_back(itemLogLevel);
+    desc.items.push_back(itemNtsTrace);
+    desc.items.push_back(itemCapture);
+    desc.items.push_back(itemSharedTun);
 
     opt::OptionsResult opt{argc, argv, desc, false, nullptr};
 
@@ -266,14 +548,26 @@ static void ReadOptions(int argc, char **argv)
         g_options.count = utils::ParseInt(opt.getOption(itemCount));
         if (g_options.count <= 0)
             throw std::runtime_error("Invalid number of UEs");
-        if (g_options.count > 512)
-            throw std::runtime_error("Number of UEs is too big");
     }
     else
     {
         g_options.count = 1;
     }
 
+    g_options.sharedTun = opt.hasFlag(itemSharedTun);
+
+    if (opt.hasFlag(itemThreads))
+    {
+        g_options.threads = utils::ParseInt(opt.getOption(itemThreads));
+        if (g_options.threads <= 0)
+            throw std::runtime_error("Invalid number of threads");
+    }
+    else if (g_options.count > MAX_UE_COUNT_WITHOUT_HOST || g_options.sharedTun)
+    {
+        // Thread per task does not scale any further, share the threads then
+        g_options.threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
     g_options.imsi = {};
     if (opt.hasFlag(itemImsi))
     {
@@ -282,73 +576,50 @@ static void ReadOptions(int argc, char **argv)
     }
 
     g_options.disableCmd = opt.hasFlag(itemDisableCmd);
-}
-
-static std::string LargeSum(std::string a, std::string b)
-{
-    if (a.length() > b.length())
-        std::swap(a, b);
 
-    std::string str;
-    size_t n1 = a.length(), n2 = b.length();
+    if (opt.hasFlag(itemLatencyDump))
+        g_options.latencyDumpFile = opt.getOption(itemLatencyDump);
 
-    reverse(a.begin(), a.end());
-    reverse(b.begin(), b.end());
-
-    int carry = 0;
-    for (size_t i = 0; i < n1; i++)
+    if (opt.hasFlag(itemLogLevel))
     {
-        int sum = ((a[i] - '0') + (b[i] - '0') + carry);
-        str.push_back(static_cast<char>((sum % 10) + '0'));
-        carry = sum / 10;
+        Severity severity{};
+        if (!ParseSeverity(opt.getOption(itemLogLevel), severity))
+            throw std::runtime_error("Invalid log level: " + opt.getOption(itemLogLevel));
+        Logger::SetMinSeverity(severity);
     }
-    for (size_t i = n1; i < n2; i++)
+
+    if (opt.hasFlag(itemNtsTrace))
+        g_options.ntsTraceFile = opt.getOption(itemNtsTrace);
+    if (opt.hasFlag(itemCapture))
+        g_options.captureFile = opt.getOption(itemCapture);
+
+    if (opt.hasFlag(itemSubscribers))
+        g_options.subscriberFile = opt.getOption(itemSubscribers);
+    if (opt.hasFlag(itemSubscribersCompile))
     {
-        int sum = ((b[i] - '0') + carry);
-        str.push_back(static_cast<char>((sum % 10) + '0'));
-        carry = sum / 10;
+        g_options.subscriberCompileFile = opt.getOption(itemSubscribersCompile);
+        if (g_options.subscriberFile.empty())
+            throw std::runtime_error("Subscriber file to compile is not specified");
     }
-    if (carry)
-        throw std::runtime_error("UE serial number overflow");
-    reverse(str.begin(), str.end());
-    return str;
-}
-
-static void IncrementNumber(std::string &s, int delta)
-{
-    s = LargeSum(s, std::to_string(delta));
 }
 
 static nr::ue::UeConfig *GetConfigByUe(int ueIndex)
 {
-    auto *c = new nr::ue::UeConfig();
-    c->key = g_refConfig->key.copy();
-    c->opC = g_refConfig->opC.copy();
-    c->opType = g_refConfig->opType;
-    c->amf = g_refConfig->amf.copy();
-    c->imei = g_refConfig->imei;
-    c->imeiSv = g_refConfig->imeiSv;
-    c->supi = g_refConfig->supi;
-    c->hplmn = g_refConfig->hplmn;
-    c->configuredNssai = g_refConfig->configuredNssai;
-    c->defaultConfiguredNssai = g_refConfig->defaultConfiguredNssai;
-    c->supportedAlgs = g_refConfig->supportedAlgs;
-    c->gnbSearchList = g_refConfig->gnbSearchList;
-    c->defaultSessions = g_refConfig->defaultSessions;
-    c->configureRouting = g_refConfig->configureRouting;
-    c->prefixLogger = g_refConfig->prefixLogger;
-    c->integrityMaxRate = g_refConfig->integrityMaxRate;
-    c->uacAic = g_refConfig->uacAic;
-    c->uacAcc = g_refConfig->uacAcc;
-
-    if (c->supi.has_value())
-        IncrementNumber(c->supi->value, ueIndex);
-    if (c->imei.has_value())
-        IncrementNumber(*c->imei, ueIndex);
-    if (c->imeiSv.has_value())
-        IncrementNumber(*c->imeiSv, ueIndex);
-
-    return c;
+    auto *config = new nr::ue::UeConfig(g_profile, ueIndex);
+
+    if (g_subscriberDb)
+    {
+        auto supi = config->getSupi();
+        if (!supi.has_value() || supi->type != "imsi")
+            throw std::runtime_error("UE without IMSI cannot be looked up in the subscriber file");
+
+        auto *record = g_subscriberDb->find(supi->value);
+        if (record == nullptr)
+            throw std::runtime_error("IMSI not found in the subscriber file: " + supi->value);
+        config->subscription = nr::ue::ToSubscription(*record);
+    }
+
+    return config;
 }
 
 static void ReceiveCommand(app::CliMessage &msg)
@@ -453,9 +724,22 @@ int main(int argc, char **argv)
     try
     {
         ReadOptions(argc, argv);
-        g_refConfig = ReadConfigYaml();
+
+        if (!g_options.subscriberFile.empty())
+        {
+            g_subscriberDb = nr::ue::SubscriberDb::Load(g_options.subscriberFile);
+            if (!g_options.subscriberCompileFile.empty())
+            {
+                g_subscriberDb->writeBinary(g_options.subscriberCompileFile);
+                std::cout << g_subscriberDb->size() << " subscribers written to " << g_options.subscriberCompileFile
+                          << std::endl;
+                return 0;
+            }
+        }
+
+        g_profile = ReadConfigYaml();
         if (g_options.imsi.length() > 0)
-            g_refConfig->supi = Supi::Parse("imsi-" + g_options.imsi);
+            g_profile->supi = Supi::Parse("imsi-" + g_options.imsi);
     }
     catch (const std::runtime_error &e)
     {
@@ -466,6 +750,76 @@ int main(int argc, char **argv)
     std::cout << cons::Name << std::endl;
 
     g_controllerTask = new UeControllerTask();
+
+    g_procMetrics = new nr::ue::ProcedureMetrics();
+    app::RunAtExit(DumpLatencies);
+
+    if (g_profile->traffic)
+        g_trafficMetrics = new traffic::TrafficMetrics();
+
+    if (!g_options.ntsTraceFile.empty())
+    {
+        NtsTrace::Enable(NTS_TRACE_RECORDS_PER_THREAD);
+        app::RunAtExit(ExportNtsTrace);
+    }
+
+    if (!g_options.captureFile.empty())
+    {
+        try
+        {
+            PacketCapture::Start(g_options.captureFile, CAPTURE_RING_SIZE);
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+        app::RunAtExit(StopCapture);
+    }
+
+    if (g_options.threads > 0)
+    {
+        // The shared threads also carry the user plane of the UEs, rather lose log messages than stall them
+        LogBase::SetOverflowPolicy(LogOverflowPolicy::DROP);
+
+        g_hostContext = new nr::ue::UeHostContext();
+        g_hostContext->logBase = new LogBase("logs/ue-host.log");
+        g_hostContext->executor = new NtsExecutor(g_options.threads);
+        g_hostContext->rlsEndpoint = new nr::ue::RlsEndpointTask(g_hostContext->logBase, g_profile->rlsTransport,
+                                                                 g_profile->gnbSearchList);
+        g_hostContext->rlsEndpoint->start();
+
+        // A queue per shared thread, each thread writes the downlink of the sessions it runs to its own queue
+        if (g_options.sharedTun)
+        {
+            if (!utils::IsRoot())
+            {
+                std::cerr << "ERROR: Shared TUN interface could not be setup. Permission denied. Please run the UE "
+                             "with 'sudo'"
+                          << std::endl;
+                return 1;
+            }
+
+            try
+            {
+                g_hostContext->sharedTun =
+                    new nr::ue::SharedTun(g_hostContext->logBase, g_options.threads, g_profile->tunMtu,
+                                          g_profile->tunOffload, g_profile->configureRouting);
+            }
+            catch (const LibError &e)
+            {
+                std::cerr << "ERROR: Shared TUN interface could not be setup: " << e.what() << std::endl;
+                return 1;
+            }
+        }
+
+        g_controllerTask->enableMemoryReport(g_hostContext->logBase, ResidentMemoryKb());
+    }
+
+    if (g_trafficMetrics)
+        g_controllerTask->enableTrafficReport(g_hostContext ? g_hostContext->logBase
+                                                            : new LogBase("logs/ue-traffic.log"));
+
     g_controllerTask->start();
 
     if (!g_options.disableCmd)
@@ -474,11 +828,30 @@ int main(int argc, char **argv)
         g_cliRespTask = new app::CliResponseTask(g_cliServer);
     }
 
+    if (g_loadProfile)
+    {
+        auto *logBase = g_hostContext ? g_hostContext->logBase : new LogBase("logs/ue-load.log");
+        g_loadDriver = new nr::ue::UeLoadDriver(*g_loadProfile, logBase);
+    }
+
     for (int i = 0; i < g_options.count; i++)
     {
-        auto *config = GetConfigByUe(i);
-        auto *ue = new nr::ue::UserEquipment(config, &g_ueController, nullptr, g_cliRespTask);
+        nr::ue::UeConfig *config;
+        try
+        {
+            config = GetConfigByUe(i);
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+
+        auto *ue = new nr::ue::UserEquipment(config, &g_ueController, g_loadDriver, g_cliRespTask, g_hostContext,
+                                             g_procMetrics, g_trafficMetrics);
         g_ueMap.put(config->getNodeName(), ue);
+        if (g_loadDriver)
+            g_loadDriver->addUe(config->getNodeName(), ue);
     }
 
     if (!g_options.disableCmd)
@@ -487,7 +860,11 @@ int main(int argc, char **argv)
         g_cliRespTask->start();
     }
 
-    g_ueMap.invokeForeach([](const auto &ue) { ue.second->start(); });
+    // The load driver starts the UEs at the arrival rate of the profile
+    if (g_loadDriver)
+        g_loadDriver->start();
+    else
+        g_ueMap.invokeForeach([](const auto &ue) { ue.second->start(); });
 
     while (true)
         Loop();
@@ -9,6 +9,7 @@
 #include "cmd_handler.hpp"
 
 #include <ue/app/task.hpp>
+#include <ue/metrics.hpp>
 #include <ue/nas/task.hpp>
 #include <ue/rls/task.hpp>
 #include <ue/rrc/task.hpp>
@@ -31,6 +32,13 @@ static std::string SignalDescription(int dbm)
     return "Poor";
 }
 
+static constexpr const int MEMORY_SUBSYSTEM_COUNT = static_cast<int>(nr::ue::EMemorySubsystem::TUN) + 1;
+
+static Json MemoryUsage(int64_t bytes, int64_t blocks)
+{
+    return Json::Obj({{"bytes", bytes}, {"blocks", blocks}});
+}
+
 namespace nr::ue
 {
 
@@ -137,22 +145,22 @@ void UeCmdHandler::handleCmdImpl(NmUeCliCommand &msg)
     }
     case app::UeCliCommand::INFO: {
         auto json = Json::Obj({
-            {"supi", ToJson(m_base->config->supi)},
-            {"hplmn", ToJson(m_base->config->hplmn)},
-            {"imei", ::ToJson(m_base->config->imei)},
-            {"imeisv", ::ToJson(m_base->config->imeiSv)},
+            {"supi", ToJson(m_base->config->getSupi())},
+            {"hplmn", ToJson(m_base->config->profile->hplmn)},
+            {"imei", ::ToJson(m_base->config->getImei())},
+            {"imeisv", ::ToJson(m_base->config->getImeiSv())},
             {"ecall-only", ::ToJson(m_base->nasTask->usim->m_isECallOnly)},
             {"uac-aic", Json::Obj({
-                            {"mps", m_base->config->uacAic.mps},
-                            {"mcs", m_base->config->uacAic.mcs},
+                            {"mps", m_base->config->profile->uacAic.mps},
+                            {"mcs", m_base->config->profile->uacAic.mcs},
                         })},
             {"uac-acc", Json::Obj({
-                            {"normal-class", m_base->config->uacAcc.normalCls},
-                            {"class-11", m_base->config->uacAcc.cls11},
-                            {"class-12", m_base->config->uacAcc.cls12},
-                            {"class-13", m_base->config->uacAcc.cls13},
-                            {"class-14", m_base->config->uacAcc.cls14},
-                            {"class-15", m_base->config->uacAcc.cls15},
+                            {"normal-class", m_base->config->profile->uacAcc.normalCls},
+                            {"class-11", m_base->config->profile->uacAcc.cls11},
+                            {"class-12", m_base->config->profile->uacAcc.cls12},
+                            {"class-13", m_base->config->profile->uacAcc.cls13},
+                            {"class-14", m_base->config->profile->uacAcc.cls14},
+                            {"class-15", m_base->config->profile->uacAcc.cls15},
                         })},
             {"is-high-priority", m_base->nasTask->mm->isHighPriority()},
         });
@@ -220,7 +228,7 @@ void UeCmdHandler::handleCmdImpl(NmUeCliCommand &msg)
     case app::UeCliCommand::RLS_STATE: {
         Json json = Json::Obj({
             {"sti", OctetString::FromOctet8(m_base->rlsTask->m_shCtx->sti).toHexString()},
-            {"gnb-search-space", ::ToJson(m_base->config->gnbSearchList)},
+            {"gnb-search-space", ::ToJson(m_base->config->profile->gnbSearchList)},
         });
         sendResult(msg.address, json.dumpYaml());
         break;
@@ -267,6 +275,89 @@ void UeCmdHandler::handleCmdImpl(NmUeCliCommand &msg)
         sendResult(msg.address, json.dumpYaml());
         break;
     }
+    case app::UeCliCommand::LATENCY: {
+        auto *metrics = m_base->procClock->metrics();
+        Json json = Json::Obj({
+            {"ue", m_base->procClock->toJson()},
+            {"process", metrics ? metrics->toJson(false) : Json{}},
+        });
+        sendResult(msg.address, json.dumpYaml());
+        break;
+    }
+    case app::UeCliCommand::MEMORY: {
+        if (!MemoryAccount::IsCompiledIn())
+        {
+            sendError(msg.address, "Memory accounting is not compiled in, build with -DMEMORY_ACCOUNTING=ON");
+            break;
+        }
+
+        // Read before building the result, which allocates too
+        auto *account = m_base->memAccount;
+        int64_t ueBytes[MemoryAccount::MAX_SUBSYSTEMS];
+        int64_t ueBlocks[MemoryAccount::MAX_SUBSYSTEMS];
+        for (int i = 0; i < MemoryAccount::MAX_SUBSYSTEMS; i++)
+        {
+            ueBytes[i] = account->bytes(i);
+            ueBlocks[i] = account->blocks(i);
+        }
+        int64_t totalBytes[MemoryAccount::MAX_SUBSYSTEMS];
+        int64_t totalBlocks[MemoryAccount::MAX_SUBSYSTEMS];
+        int accountCount;
+        MemoryAccount::Totals(totalBytes, totalBlocks, accountCount);
+
+        // Each UE created in the process has an account, including the ones switched off
+        Json ue = Json::Obj({});
+        Json process = Json::Obj({{"ue-count", accountCount}});
+        int64_t ueSum[2] = {}, processSum[2] = {};
+        for (int i = 0; i < MEMORY_SUBSYSTEM_COUNT; i++)
+        {
+            auto name = ToJson(static_cast<EMemorySubsystem>(i)).str();
+            ue.put(name, MemoryUsage(ueBytes[i], ueBlocks[i]));
+            process.put(name, MemoryUsage(totalBytes[i], totalBlocks[i]));
+            ueSum[0] += ueBytes[i];
+            ueSum[1] += ueBlocks[i];
+            processSum[0] += totalBytes[i];
+            processSum[1] += totalBlocks[i];
+        }
+        ue.put("total", MemoryUsage(ueSum[0], ueSum[1]));
+        process.put("total", MemoryUsage(processSum[0], processSum[1]));
+        process.put("average-bytes-per-ue", accountCount > 0 ? processSum[0] / accountCount : int64_t{0});
+
+        // Allocated by the threads shared by the UEs, e.g. the RLS endpoint of the host mode
+        auto &untagged = MemoryAccount::Untagged();
+        process.put("untagged", MemoryUsage(untagged.bytes(0), untagged.blocks(0)));
+
+        Json json = Json::Obj({{"ue", ue},
+                               {"process", process},
+                               {"untracked", "malloc and calloc, including the ASN.1 structures of asn1c"}});
+        sendResult(msg.address, json.dumpYaml());
+        break;
+    }
+    case app::UeCliCommand::TRAFFIC: {
+        auto &profile = m_base->config->profile->traffic;
+        if (!profile)
+        {
+            sendError(msg.address, "No traffic profile is configured for the UE");
+            break;
+        }
+
+        Json sessions = Json::Obj({});
+        auto &trafficSessions = m_base->appTask->m_trafficSessions;
+        for (int psi = 0; psi < static_cast<int>(trafficSessions.size()); psi++)
+        {
+            if (trafficSessions[psi])
+                sessions.put("session-" + std::to_string(psi),
+                             trafficSessions[psi]->sink.toJson(trafficSessions[psi]->stats));
+        }
+
+        Json json = Json::Obj({
+            {"model", traffic::ToJson(profile->model)},
+            {"sessions", sessions},
+            {"process", m_base->trafficMetrics ? m_base->trafficMetrics->toJson() : Json{}},
+        });
+        sendResult(msg.address, json.dumpYaml());
+        break;
+    }
     }
 }
 
@@ -8,22 +8,28 @@
 
 #include "task.hpp"
 #include "cmd_handler.hpp"
+#include <arpa/inet.h>
 #include <lib/nas/utils.hpp>
+#include <ue/metrics.hpp>
 #include <ue/nas/task.hpp>
 #include <ue/rls/task.hpp>
+#include <ue/tun/shared.hpp>
 #include <ue/tun/tun.hpp>
 #include <utils/common.hpp>
 #include <utils/constants.hpp>
+#include <utils/libc_error.hpp>
+#include <utils/nts_trace.hpp>
 
 static constexpr const int SWITCH_OFF_TIMER_ID = 1;
 static constexpr const int SWITCH_OFF_DELAY = 500;
+static constexpr const int TRAFFIC_TIMER_ID = 2;
 
 namespace nr::ue
 {
 
 UeAppTask::UeAppTask(TaskBase *base) : m_base{base}
 {
-    m_logger = m_base->logBase->makeUniqueLogger(m_base->config->getLoggerPrefix() + "app");
+    m_logger = m_base->logBase->makePrefixedLogger(m_base->config->getLoggerPrefix(), "app");
 }
 
 void UeAppTask::onStart()
@@ -32,15 +38,8 @@ void UeAppTask::onStart()
 
 void UeAppTask::onQuit()
 {
-    for (auto &tunTask : m_tunTasks)
-    {
-        if (tunTask != nullptr)
-        {
-            tunTask->quit();
-            delete tunTask;
-            tunTask = nullptr;
-        }
-    }
+    for (int psi = 0; psi < static_cast<int>(m_tunTasks.size()); psi++)
+        releaseTunInterface(psi);
 }
 
 void UeAppTask::onLoop()
@@ -59,11 +58,12 @@ void UeAppTask::onLoop()
             auto *m = new NmUeAppToNas(NmUeAppToNas::UPLINK_DATA_DELIVERY);
             m->psi = w->psi;
             m->data = std::move(w->data);
+            m->offload = w->offload;
             m_base->nasTask->push(m);
             break;
         }
         case NmUeTunToApp::TUN_ERROR: {
-            m_logger->err("TUN failure [%s]", w->error.c_str());
+            m_logger->err(FMT_STRING("TUN failure [{}]"), w->error.c_str());
             break;
         }
         }
@@ -86,6 +86,19 @@ void UeAppTask::onLoop()
                 m->data = std::move(w->data);
                 tunTask->push(m);
             }
+            else if (!m_sharedTunAddresses[w->psi].empty())
+            {
+                // Written by this thread directly, to the queue of the thread
+                m_base->host->sharedTun->write(w->data.data(), static_cast<size_t>(w->data.length()));
+            }
+            else if (m_trafficSessions[w->psi])
+            {
+                auto &session = *m_trafficSessions[w->psi];
+                traffic::ProbeHeader header{};
+                if (traffic::ParseProbePacket(w->data.data(), static_cast<size_t>(w->data.length()), header))
+                    session.sink.receive(header, static_cast<size_t>(w->data.length()), traffic::ProbeTime(),
+                                         session.stats);
+            }
             break;
         }
         }
@@ -108,6 +121,10 @@ void UeAppTask::onLoop()
             m_logger->info("UE device is switching off");
             m_base->ueController->performSwitchOff(m_base->ue);
         }
+        else if (w->timerId == TRAFFIC_TIMER_ID)
+        {
+            generateTraffic();
+        }
         break;
     }
     default:
@@ -129,13 +146,7 @@ void UeAppTask::receiveStatusUpdate(NmUeStatusUpdate &msg)
 
     if (msg.what == NmUeStatusUpdate::SESSION_RELEASE)
     {
-        if (m_tunTasks[msg.psi] != nullptr)
-        {
-            m_tunTasks[msg.psi]->quit();
-            delete m_tunTasks[msg.psi];
-            m_tunTasks[msg.psi] = nullptr;
-        }
-
+        releaseTunInterface(msg.psi);
         return;
     }
 
@@ -148,12 +159,6 @@ void UeAppTask::receiveStatusUpdate(NmUeStatusUpdate &msg)
 
 void UeAppTask::setupTunInterface(const PduSession *pduSession)
 {
-    if (!utils::IsRoot())
-    {
-        m_logger->err("TUN interface could not be setup. Permission denied. Please run the UE with 'sudo'");
-        return;
-    }
-
     if (!pduSession->pduAddress.has_value())
     {
         m_logger->err("Connection could not setup. PDU address is missing.");
@@ -174,35 +179,191 @@ void UeAppTask::setupTunInterface(const PduSession *pduSession)
         return;
     }
 
-    if (m_tunTasks[psi] != nullptr)
+    if (m_tunTasks[psi] != nullptr || !m_sharedTunAddresses[psi].empty() || m_trafficSessions[psi] != nullptr)
     {
         m_logger->err("Connection could not setup. TUN task for specified PSI is non-null.");
         return;
     }
 
+    // Neither needs root, the shared TUN interface is already up and the synthetic traffic needs none
+    if (m_base->config->profile->traffic)
+    {
+        setupTrafficSession(pduSession, utils::OctetStringToIp(pduSession->pduAddress->pduAddressInformation));
+        return;
+    }
+
+    if (m_base->host && m_base->host->sharedTun)
+    {
+        setupSharedTun(pduSession, utils::OctetStringToIp(pduSession->pduAddress->pduAddressInformation));
+        return;
+    }
+
+    if (!utils::IsRoot())
+    {
+        m_logger->err("TUN interface could not be setup. Permission denied. Please run the UE with 'sudo'");
+        return;
+    }
+
     std::string error{}, allocatedName{};
-    int fd = tun::TunAllocate(cons::TunNamePrefix, allocatedName, error);
+    auto &profile = *m_base->config->profile;
+    int fd = tun::TunAllocate(cons::TunNamePrefix, profile.tunOffload, allocatedName, error);
     if (fd == 0 || error.length() > 0)
     {
-        m_logger->err("TUN allocation failure [%s]", error.c_str());
+        m_logger->err(FMT_STRING("TUN allocation failure [{}]"), error.c_str());
+        m_base->procClock->record(EProcedureMetric::PDU_SESSION_TO_TUN, EProcedureOutcome::FAILURE,
+                                  pduSession->establishmentStartTime);
         return;
     }
 
     std::string ipAddress = utils::OctetStringToIp(pduSession->pduAddress->pduAddressInformation);
 
-    bool r = tun::TunConfigure(allocatedName, ipAddress, cons::TunMtu, m_base->config->configureRouting, error);
+    bool r = tun::TunConfigure(allocatedName, ipAddress, profile.tunMtu, profile.configureRouting, error);
     if (!r || error.length() > 0)
     {
-        m_logger->err("TUN configuration failure [%s]", error.c_str());
+        m_logger->err(FMT_STRING("TUN configuration failure [{}]"), error.c_str());
+        m_base->procClock->record(EProcedureMetric::PDU_SESSION_TO_TUN, EProcedureOutcome::FAILURE,
+                                  pduSession->establishmentStartTime);
         return;
     }
 
-    auto *task = new TunTask(m_base, psi, fd);
+    TunTask *task;
+    {
+        MemoryTagScope tagScope{MemoryTagOf(m_base, EMemorySubsystem::TUN)};
+        task = new TunTask(m_base, psi, fd, profile.tunOffload);
+    }
+    task->setMemoryTag(MemoryTagOf(m_base, EMemorySubsystem::TUN));
+    if (NtsTrace::IsEnabled())
+        task->setTraceName(m_base->config->getNodeName() + "/tun" + std::to_string(psi));
     m_tunTasks[psi] = task;
     task->start();
 
-    m_logger->info("Connection setup for PDU session[%d] is successful, TUN interface[%s, %s] is up.", pduSession->psi,
-                   allocatedName.c_str(), ipAddress.c_str());
+    m_base->procClock->record(EProcedureMetric::PDU_SESSION_TO_TUN, EProcedureOutcome::SUCCESS,
+                              pduSession->establishmentStartTime);
+
+    m_logger->info(FMT_STRING("Connection setup for PDU session[{}] is successful, TUN interface[{}, {}] is up."),
+                   pduSession->psi, allocatedName.c_str(), ipAddress.c_str());
+}
+
+void UeAppTask::setupSharedTun(const PduSession *pduSession, const std::string &ipAddress)
+{
+    auto *sharedTun = m_base->host->sharedTun;
+    try
+    {
+        sharedTun->addSession(ipAddress, this, pduSession->psi, MemoryTagOf(m_base, EMemorySubsystem::TUN));
+    }
+    catch (const LibError &e)
+    {
+        m_logger->err(FMT_STRING("TUN configuration failure [{}]"), e.what());
+        m_base->procClock->record(EProcedureMetric::PDU_SESSION_TO_TUN, EProcedureOutcome::FAILURE,
+                                  pduSession->establishmentStartTime);
+        return;
+    }
+
+    m_sharedTunAddresses[pduSession->psi] = ipAddress;
+
+    m_base->procClock->record(EProcedureMetric::PDU_SESSION_TO_TUN, EProcedureOutcome::SUCCESS,
+                              pduSession->establishmentStartTime);
+
+    m_logger->info(
+        FMT_STRING("Connection setup for PDU session[{}] is successful, shared TUN interface[{}, {}] is up."),
+        pduSession->psi, sharedTun->name(), ipAddress);
+}
+
+void UeAppTask::setupTrafficSession(const PduSession *pduSession, const std::string &ipAddress)
+{
+    int psi = pduSession->psi;
+
+    // Distinct but reproducible flows for the UEs and their sessions
+    size_t seed = std::hash<std::string>{}(m_base->config->getNodeName());
+    utils::HashCombine(seed, psi);
+
+    traffic::TrafficSource source{*m_base->config->profile->traffic, inet_addr(ipAddress.c_str()),
+                                  static_cast<uint32_t>(seed), static_cast<uint64_t>(seed), traffic::ProbeTime()};
+    int pollPeriod = source.pollPeriod();
+    m_trafficSessions[psi] = std::make_unique<TrafficSession>(std::move(source));
+
+    if (m_base->trafficMetrics)
+        m_base->trafficMetrics->addFlow(1);
+
+    if (!m_trafficTimerRunning)
+    {
+        m_trafficTimerRunning = true;
+        setTimer(TRAFFIC_TIMER_ID, pollPeriod);
+    }
+
+    m_base->procClock->record(EProcedureMetric::PDU_SESSION_TO_TUN, EProcedureOutcome::SUCCESS,
+                              pduSession->establishmentStartTime);
+
+    m_logger->info(FMT_STRING("Connection setup for PDU session[{}] is successful, synthetic traffic[{}] is started."),
+                   psi, ipAddress);
+}
+
+void UeAppTask::generateTraffic()
+{
+    int64_t now = traffic::ProbeTime();
+    int pollPeriod = 0;
+    std::vector<OctetString> packets{};
+
+    for (int psi = 0; psi < static_cast<int>(m_trafficSessions.size()); psi++)
+    {
+        auto &session = m_trafficSessions[psi];
+        if (!session)
+            continue;
+
+        session->source.generate(now, packets, session->stats);
+        for (auto &packet : packets)
+        {
+            auto *m = new NmUeAppToNas(NmUeAppToNas::UPLINK_DATA_DELIVERY);
+            m->psi = psi;
+            m->data = std::move(packet);
+            m_base->nasTask->push(m);
+        }
+        packets.clear();
+
+        reportTraffic(*session);
+        pollPeriod = session->source.pollPeriod();
+    }
+
+    // Stops with the last session
+    m_trafficTimerRunning = pollPeriod > 0;
+    if (m_trafficTimerRunning)
+        setTimer(TRAFFIC_TIMER_ID, pollPeriod);
+}
+
+void UeAppTask::reportTraffic(TrafficSession &session)
+{
+    // Once per poll rather than per packet, so that thousands of UEs do not contend on the metrics
+    auto &latencies = session.sink.pendingLatencies();
+    if (m_base->trafficMetrics)
+    {
+        m_base->trafficMetrics->report(session.stats - session.reportedStats, latencies);
+        session.reportedStats = session.stats;
+    }
+    latencies.clear();
+}
+
+void UeAppTask::releaseTunInterface(int psi)
+{
+    if (m_tunTasks[psi] != nullptr)
+    {
+        m_tunTasks[psi]->quit();
+        delete m_tunTasks[psi];
+        m_tunTasks[psi] = nullptr;
+    }
+
+    if (!m_sharedTunAddresses[psi].empty())
+    {
+        m_base->host->sharedTun->removeSession(m_sharedTunAddresses[psi]);
+        m_sharedTunAddresses[psi].clear();
+    }
+
+    if (m_trafficSessions[psi] != nullptr)
+    {
+        reportTraffic(*m_trafficSessions[psi]);
+        if (m_base->trafficMetrics)
+            m_base->trafficMetrics->addFlow(-1);
+        m_trafficSessions[psi].reset();
+    }
 }
 
 } // namespace nr::ue
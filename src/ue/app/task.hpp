@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <lib/traffic/traffic.hpp>
 #include <memory>
 #include <thread>
 #include <ue/nts.hpp>
@@ -21,6 +22,19 @@
 namespace nr::ue
 {
 
+/* A PDU session which carries the synthetic traffic of the profile instead of the packets of a TUN interface */
+struct TrafficSession
+{
+    traffic::TrafficSource source;
+    traffic::TrafficSink sink{};
+    traffic::TrafficStats stats{};
+    traffic::TrafficStats reportedStats{}; // Already added to the metrics of the process
+
+    explicit TrafficSession(traffic::TrafficSource &&source) : source{std::move(source)}
+    {
+    }
+};
+
 class UeAppTask : public NtsTask
 {
   private:
@@ -28,6 +42,9 @@ class UeAppTask : public NtsTask
     std::unique_ptr<Logger> m_logger;
 
     std::array<TunTask *, 16> m_tunTasks{};
+    std::array<std::string, 16> m_sharedTunAddresses{}; // Addresses of the sessions on the shared TUN device
+    std::array<std::unique_ptr<TrafficSession>, 16> m_trafficSessions{};
+    bool m_trafficTimerRunning{};
     ECmState m_cmState{};
 
     friend class UeCmdHandler;
@@ -44,6 +61,11 @@ class UeAppTask : public NtsTask
   private:
     void receiveStatusUpdate(NmUeStatusUpdate &msg);
     void setupTunInterface(const PduSession *pduSession);
+    void setupSharedTun(const PduSession *pduSession, const std::string &ipAddress);
+    void setupTrafficSession(const PduSession *pduSession, const std::string &ipAddress);
+    void generateTraffic();
+    void reportTraffic(TrafficSession &session);
+    void releaseTunInterface(int psi);
 };
 
 } // namespace nr::ue
@@ -0,0 +1,359 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "driver.hpp"
+
+#include <algorithm>
+
+#include <utils/common.hpp>
+
+static constexpr const int TIMER_ID_TICK = 1;
+static constexpr const int TIMER_ID_REPORT = 2;
+static constexpr const int TIMER_PERIOD_TICK = 10;
+
+static const char *const PROCEDURE_NAMES[] = {"registration", "deregistration", "service-request",
+                                              "session-establishment", "session-release"};
+
+static constexpr const int64_t LATENCY_HIGHEST_VALUE = 600 * 1000; // 10 minutes in milliseconds
+static constexpr const int LATENCY_SIGNIFICANT_DIGITS = 3;
+
+namespace nr::ue
+{
+
+bool ParseArrivalProcess(const std::string &value, EArrivalProcess &outProcess)
+{
+    if (value == "constant")
+        outProcess = EArrivalProcess::CONSTANT;
+    else if (value == "poisson")
+        outProcess = EArrivalProcess::POISSON;
+    else if (value == "ramp")
+        outProcess = EArrivalProcess::RAMP;
+    else
+        return false;
+    return true;
+}
+
+UeLoadDriver::UeLoadDriver(const LoadProfile &profile, LogBase *logBase)
+    : m_profile{profile}, m_logger{logBase->makeUniqueLogger("load")}, m_random{profile.seed}
+{
+    for (auto &stats : m_stats)
+        stats.latencies = std::make_unique<HdrHistogram>(LATENCY_HIGHEST_VALUE, LATENCY_SIGNIFICANT_DIGITS);
+}
+
+void UeLoadDriver::addUe(const std::string &nodeName, UserEquipment *ue)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_indexByName[nodeName] = static_cast<int>(m_ues.size());
+    m_ues.push_back(UeEntry{});
+    m_ues.back().ue = ue;
+}
+
+void UeLoadDriver::removeUe(UserEquipment *ue)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto &entry : m_ues)
+        if (entry.ue == ue)
+            entry.ue = nullptr;
+}
+
+void UeLoadDriver::onStart()
+{
+    m_startTime = utils::CurrentTimeMillis();
+    m_nextArrival = 0.0;
+
+    setTimer(TIMER_ID_TICK, TIMER_PERIOD_TICK);
+    setTimer(TIMER_ID_REPORT, m_profile.reportPeriod);
+}
+
+void UeLoadDriver::onLoop()
+{
+    NtsMessage *msg = take();
+    if (!msg)
+        return;
+
+    if (msg->msgType == NtsMessageType::TIMER_EXPIRED)
+    {
+        auto *w = dynamic_cast<NmTimerExpired *>(msg);
+        if (w->timerId == TIMER_ID_TICK)
+        {
+            int64_t now = utils::CurrentTimeMillis();
+            std::vector<UserEquipment *> arrivals{};
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                performArrivals(now, arrivals);
+                performActions(now);
+            }
+            // Started outside the lock, the UE tasks notify their initial states synchronously
+            for (auto *ue : arrivals)
+                ue->start();
+            setTimer(TIMER_ID_TICK, TIMER_PERIOD_TICK);
+        }
+        else if (w->timerId == TIMER_ID_REPORT)
+        {
+            report();
+            setTimer(TIMER_ID_REPORT, m_profile.reportPeriod);
+        }
+    }
+
+    delete msg;
+}
+
+void UeLoadDriver::onQuit()
+{
+}
+
+void UeLoadDriver::performArrivals(int64_t now, std::vector<UserEquipment *> &arrivals)
+{
+    auto elapsed = static_cast<double>(now - m_startTime);
+
+    while (m_arrivedCount < static_cast<int>(m_ues.size()) && m_nextArrival <= elapsed)
+    {
+        int index = m_arrivedCount++;
+        if (m_ues[index].ue)
+        {
+            arrivals.push_back(m_ues[index].ue);
+            scheduleActions(index, now);
+        }
+        m_nextArrival += arrivalGap(m_nextArrival);
+    }
+}
+
+double UeLoadDriver::arrivalGap(double elapsed)
+{
+    switch (m_profile.arrival)
+    {
+    case EArrivalProcess::CONSTANT:
+        return 1000.0 / m_profile.rate;
+    case EArrivalProcess::POISSON:
+        return std::exponential_distribution<double>{m_profile.rate / 1000.0}(m_random);
+    case EArrivalProcess::RAMP: {
+        double progress = m_profile.rampDuration > 0 ? std::min(1.0, elapsed / m_profile.rampDuration) : 1.0;
+        return 1000.0 / (m_profile.startRate + (m_profile.rate - m_profile.startRate) * progress);
+    }
+    default:
+        return 0.0;
+    }
+}
+
+int UeLoadDriver::actionPeriod(EAction action) const
+{
+    switch (action)
+    {
+    case EAction::DEREGISTRATION:
+        return m_profile.deregistrationPeriod;
+    case EAction::SERVICE_REQUEST:
+        return m_profile.serviceRequestPeriod;
+    case EAction::SESSION_CHURN:
+        return m_profile.sessionChurnPeriod;
+    default:
+        return 0;
+    }
+}
+
+void UeLoadDriver::scheduleActions(int ueIndex, int64_t now)
+{
+    for (auto action : {EAction::DEREGISTRATION, EAction::SERVICE_REQUEST, EAction::SESSION_CHURN})
+    {
+        int period = actionPeriod(action);
+        if (period <= 0)
+            continue;
+
+        // The first occurrence is offset randomly so that the UEs do not act in lockstep
+        int64_t offset = std::uniform_int_distribution<int64_t>{0, period - 1}(m_random);
+        m_actions.push(ScheduledAction{now + period + offset, ueIndex, action});
+    }
+}
+
+void UeLoadDriver::performActions(int64_t now)
+{
+    while (!m_actions.empty() && m_actions.top().time <= now)
+    {
+        ScheduledAction item = m_actions.top();
+        m_actions.pop();
+
+        auto &entry = m_ues[item.ueIndex];
+        if (entry.ue == nullptr)
+            continue;
+
+        performAction(entry, item.action, now);
+
+        item.time += actionPeriod(item.action);
+        m_actions.push(item);
+    }
+}
+
+void UeLoadDriver::performAction(UeEntry &entry, EAction action, int64_t now)
+{
+    // Procedures are only triggered in the states they are meant for, the occurrence is skipped otherwise
+    if (!entry.isRegistered)
+        return;
+
+    switch (action)
+    {
+    case EAction::DEREGISTRATION:
+        entry.ue->triggerProcedure(ETriggeredProcedure::DEREGISTRATION);
+        break;
+    case EAction::SERVICE_REQUEST:
+        if (!entry.isConnected)
+            entry.ue->triggerProcedure(ETriggeredProcedure::SERVICE_REQUEST);
+        break;
+    case EAction::SESSION_CHURN:
+        if (entry.activeSessions > 0)
+        {
+            beginProcedure(entry, EProcedure::SESSION_RELEASE, now);
+            entry.ue->triggerProcedure(ETriggeredProcedure::SESSION_RELEASE);
+        }
+        else
+        {
+            entry.ue->triggerProcedure(ETriggeredProcedure::SESSION_ESTABLISHMENT);
+        }
+        break;
+    }
+}
+
+void UeLoadDriver::beginProcedure(UeEntry &entry, EProcedure procedure, int64_t now)
+{
+    auto &startTime = entry.startTime[static_cast<int>(procedure)];
+    auto &stats = m_stats[static_cast<int>(procedure)];
+
+    // A procedure started over before completing counts as a failure
+    if (startTime != 0)
+        stats.failures++;
+
+    stats.attempts++;
+    startTime = now;
+}
+
+void UeLoadDriver::endProcedure(UeEntry &entry, EProcedure procedure, bool isSuccess, int64_t now)
+{
+    auto &startTime = entry.startTime[static_cast<int>(procedure)];
+    auto &stats = m_stats[static_cast<int>(procedure)];
+
+    if (startTime == 0)
+        return;
+
+    if (isSuccess)
+    {
+        stats.successes++;
+        stats.latencies->record(now - startTime);
+    }
+    else
+    {
+        stats.failures++;
+    }
+
+    startTime = 0;
+}
+
+void UeLoadDriver::onConnected(app::NodeType subjectType, const std::string &subjectId, app::NodeType objectType,
+                               const std::string &objectId)
+{
+}
+
+void UeLoadDriver::onReceive(app::NodeType subjectType, const std::string &subjectId, app::NodeType objectType,
+                             const std::string &objectId, app::ConnectionType connectionType, std::string message)
+{
+}
+
+void UeLoadDriver::onSend(app::NodeType subjectType, const std::string &subjectId, app::NodeType objectType,
+                          const std::string &objectId, app::ConnectionType connectionType, std::string message)
+{
+}
+
+void UeLoadDriver::onSwitch(app::NodeType subjectType, const std::string &subjectId, app::StateType stateType,
+                            const std::string &fromState, const std::string &toState)
+{
+    if (subjectType != app::NodeType::UE || fromState == toState)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_indexByName.find(subjectId);
+    if (it == m_indexByName.end())
+        return;
+
+    auto &entry = m_ues[it->second];
+    int64_t now = utils::CurrentTimeMillis();
+
+    if (stateType == app::StateType::MM)
+    {
+        if (toState == "MM-REGISTER-INITIATED")
+            beginProcedure(entry, EProcedure::REGISTRATION, now);
+        else if (fromState == "MM-REGISTER-INITIATED")
+            endProcedure(entry, EProcedure::REGISTRATION, toState == "MM-REGISTERED", now);
+
+        if (toState == "MM-SERVICE-REQUEST-INITIATED")
+            beginProcedure(entry, EProcedure::SERVICE_REQUEST, now);
+        else if (fromState == "MM-SERVICE-REQUEST-INITIATED")
+            endProcedure(entry, EProcedure::SERVICE_REQUEST, toState == "MM-REGISTERED" && entry.isConnected, now);
+
+        if (toState == "MM-DEREGISTER-INITIATED")
+            beginProcedure(entry, EProcedure::DEREGISTRATION, now);
+        else if (fromState == "MM-DEREGISTER-INITIATED")
+            endProcedure(entry, EProcedure::DEREGISTRATION, toState == "MM-DEREGISTERED", now);
+
+        entry.isRegistered = toState == "MM-REGISTERED";
+    }
+    else if (stateType == app::StateType::CM)
+    {
+        entry.isConnected = toState == "CM-CONNECTED";
+    }
+    else if (stateType == app::StateType::PS)
+    {
+        if (toState == "PS-ACTIVE-PENDING")
+            beginProcedure(entry, EProcedure::SESSION_ESTABLISHMENT, now);
+        else if (fromState == "PS-ACTIVE-PENDING")
+            endProcedure(entry, EProcedure::SESSION_ESTABLISHMENT, toState == "PS-ACTIVE", now);
+
+        if (toState == "PS-ACTIVE")
+        {
+            entry.activeSessions++;
+        }
+        else if (fromState == "PS-ACTIVE")
+        {
+            entry.activeSessions--;
+            if (entry.activeSessions == 0)
+                endProcedure(entry, EProcedure::SESSION_RELEASE, true, now);
+        }
+    }
+}
+
+void UeLoadDriver::report()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_logger->info(FMT_STRING("{} of {} UEs arrived"), m_arrivedCount, static_cast<int>(m_ues.size()));
+
+    for (int i = 0; i < PROCEDURE_COUNT; i++)
+    {
+        auto &item = m_stats[i];
+        if (item.attempts == 0)
+            continue;
+
+        if (item.latencies->totalCount() == 0)
+        {
+            m_logger->info(FMT_STRING("{}: {} attempts, {} successes, {} failures"), PROCEDURE_NAMES[i],
+                           static_cast<long long>(item.attempts), static_cast<long long>(item.successes),
+                           static_cast<long long>(item.failures));
+            continue;
+        }
+
+        m_logger->info(FMT_STRING("{}: {} attempts, {} successes, {} failures, latency p50 {} ms, p90 {} ms, "
+                       "p99 {} ms"),
+                       PROCEDURE_NAMES[i], static_cast<long long>(item.attempts),
+                       static_cast<long long>(item.successes), static_cast<long long>(item.failures),
+                       static_cast<long long>(item.latencies->valueAtPercentile(50.0)),
+                       static_cast<long long>(item.latencies->valueAtPercentile(90.0)),
+                       static_cast<long long>(item.latencies->valueAtPercentile(99.0)));
+        item.latencies->reset();
+    }
+}
+
+} // namespace nr::ue
@@ -0,0 +1,161 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/app/monitor.hpp>
+#include <ue/ue.hpp>
+#include <utils/hdr_histogram.hpp>
+#include <utils/logger.hpp>
+#include <utils/nts.hpp>
+
+namespace nr::ue
+{
+
+enum class EArrivalProcess
+{
+    CONSTANT,
+    POISSON,
+    RAMP,
+};
+
+struct LoadProfile
+{
+    EArrivalProcess arrival{};
+    double rate{};          // UEs per second, the final rate of a ramp
+    double startRate = 1.0; // UEs per second at the beginning of a ramp
+    int rampDuration{};     // ms
+
+    /* Per-UE procedure periods in milliseconds, zero disables the procedure */
+    int deregistrationPeriod{};
+    int serviceRequestPeriod{};
+    int sessionChurnPeriod{};
+
+    int reportPeriod = 5000; // ms
+    uint64_t seed{};
+};
+
+bool ParseArrivalProcess(const std::string &value, EArrivalProcess &outProcess);
+
+/* Starts the UEs of the process at the arrival rate of a load profile instead of all at once, keeps triggering the
+ * periodic procedures of the profile on them, and reports the outcome of the procedures. The outcome is observed
+ * through the node listener interface, so the driver must be given to the UEs as their node listener. */
+class UeLoadDriver : public NtsTask, public app::INodeListener
+{
+  private:
+    enum class EProcedure
+    {
+        REGISTRATION,
+        DEREGISTRATION,
+        SERVICE_REQUEST,
+        SESSION_ESTABLISHMENT,
+        SESSION_RELEASE,
+    };
+
+    enum class EAction
+    {
+        DEREGISTRATION,
+        SERVICE_REQUEST,
+        SESSION_CHURN,
+    };
+
+    static constexpr const int PROCEDURE_COUNT = 5;
+
+    struct ProcedureStats
+    {
+        int64_t attempts{};
+        int64_t successes{};
+        int64_t failures{};
+        std::unique_ptr<HdrHistogram> latencies{}; // ms, since the last report
+    };
+
+    struct UeEntry
+    {
+        UserEquipment *ue{};
+        bool isRegistered{};
+        bool isConnected{};
+        int activeSessions{};
+        std::array<int64_t, PROCEDURE_COUNT> startTime{}; // Zero if the procedure is not ongoing
+    };
+
+    struct ScheduledAction
+    {
+        int64_t time{};
+        int ueIndex{};
+        EAction action{};
+
+        bool operator>(const ScheduledAction &other) const
+        {
+            return time > other.time;
+        }
+    };
+
+  private:
+    LoadProfile m_profile;
+    std::unique_ptr<Logger> m_logger;
+    std::mt19937_64 m_random;
+
+    std::mutex m_mutex;
+    std::vector<UeEntry> m_ues{};
+    std::unordered_map<std::string, int> m_indexByName{};
+    std::priority_queue<ScheduledAction, std::vector<ScheduledAction>, std::greater<>> m_actions{};
+    std::array<ProcedureStats, PROCEDURE_COUNT> m_stats{};
+
+    int64_t m_startTime{};
+    double m_nextArrival{}; // ms since the start
+    int m_arrivedCount{};
+
+  public:
+    UeLoadDriver(const LoadProfile &profile, LogBase *logBase);
+    ~UeLoadDriver() override = default;
+
+  public:
+    /* Must be called before the task is started */
+    void addUe(const std::string &nodeName, UserEquipment *ue);
+    /* Must be called before the UE is deleted */
+    void removeUe(UserEquipment *ue);
+
+  public:
+    void onConnected(app::NodeType subjectType, const std::string &subjectId, app::NodeType objectType,
+                     const std::string &objectId) override;
+    void onReceive(app::NodeType subjectType, const std::string &subjectId, app::NodeType objectType,
+                   const std::string &objectId, app::ConnectionType connectionType, std::string message) override;
+    void onSend(app::NodeType subjectType, const std::string &subjectId, app::NodeType objectType,
+                const std::string &objectId, app::ConnectionType connectionType, std::string message) override;
+    void onSwitch(app::NodeType subjectType, const std::string &subjectId, app::StateType stateType,
+                  const std::string &fromState, const std::string &toState) override;
+
+  protected:
+    void onStart() override;
+    void onLoop() override;
+    void onQuit() override;
+
+  private:
+    void performArrivals(int64_t now, std::vector<UserEquipment *> &arrivals);
+    void performActions(int64_t now);
+    void performAction(UeEntry &entry, EAction action, int64_t now);
+    void scheduleActions(int ueIndex, int64_t now);
+    int actionPeriod(EAction action) const;
+    double arrivalGap(double elapsed);
+
+    void beginProcedure(UeEntry &entry, EProcedure procedure, int64_t now);
+    void endProcedure(UeEntry &entry, EProcedure procedure, bool isSuccess, int64_t now);
+    void report();
+};
+
+} // namespace nr::ue
@@ -0,0 +1,167 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "metrics.hpp"
+
+#include <chrono>
+#include <cmath>
+
+static constexpr const int64_t HISTOGRAM_HIGHEST_VALUE = 600LL * 1000 * 1000; // 10 minutes in microseconds
+static constexpr const int HISTOGRAM_SIGNIFICANT_DIGITS = 3;
+
+namespace nr::ue
+{
+
+void ProcedureMetrics::record(EProcedureMetric metric, EProcedureOutcome outcome, int64_t latencyUs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto &histogram = m_histograms[static_cast<int>(metric)][static_cast<int>(outcome)];
+    if (histogram == nullptr)
+        histogram = std::make_unique<HdrHistogram>(HISTOGRAM_HIGHEST_VALUE, HISTOGRAM_SIGNIFICANT_DIGITS);
+    histogram->record(latencyUs);
+}
+
+Json ProcedureMetrics::toJson(bool withDistribution) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Json json = Json::Obj({});
+    for (int i = 0; i < METRIC_COUNT; i++)
+    {
+        Json outcomes = Json::Obj({});
+        for (int j = 0; j < OUTCOME_COUNT; j++)
+        {
+            auto &histogram = m_histograms[i][j];
+            if (histogram == nullptr)
+                continue;
+
+            Json item = Json::Obj({
+                {"count", histogram->totalCount()},
+                {"min-us", histogram->minValue()},
+                {"mean-us", static_cast<int64_t>(std::llround(histogram->mean()))},
+                {"p50-us", histogram->valueAtPercentile(50.0)},
+                {"p90-us", histogram->valueAtPercentile(90.0)},
+                {"p99-us", histogram->valueAtPercentile(99.0)},
+                {"p99.9-us", histogram->valueAtPercentile(99.9)},
+                {"max-us", histogram->maxValue()},
+            });
+
+            if (withDistribution)
+            {
+                std::vector<Json> buckets{};
+                for (auto &bucket : histogram->distribution())
+                    buckets.push_back(Json::Arr({bucket.first, bucket.second}));
+                item.put("distribution", Json::Arr(std::move(buckets)));
+            }
+
+            outcomes.put(ToJson(static_cast<EProcedureOutcome>(j)).str(), std::move(item));
+        }
+
+        if (outcomes.itemCount() > 0)
+            json.put(ToJson(static_cast<EProcedureMetric>(i)).str(), std::move(outcomes));
+    }
+    return json;
+}
+
+ProcedureClock::ProcedureClock(ProcedureMetrics *metrics) : m_metrics{metrics}
+{
+    for (auto &latency : m_lastLatency)
+        latency = -1;
+}
+
+int64_t ProcedureClock::Now()
+{
+    auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count();
+}
+
+void ProcedureClock::start(EProcedureMetric metric)
+{
+    m_startTime[static_cast<int>(metric)] = Now();
+}
+
+void ProcedureClock::stop(EProcedureMetric metric, EProcedureOutcome outcome)
+{
+    auto &startTime = m_startTime[static_cast<int>(metric)];
+    if (startTime == 0)
+        return;
+
+    record(metric, outcome, startTime);
+    startTime = 0;
+}
+
+void ProcedureClock::record(EProcedureMetric metric, EProcedureOutcome outcome, int64_t startTime)
+{
+    int64_t latency = Now() - startTime;
+
+    m_lastLatency[static_cast<int>(metric)] = latency;
+    if (m_metrics)
+        m_metrics->record(metric, outcome, latency);
+}
+
+ProcedureMetrics *ProcedureClock::metrics() const
+{
+    return m_metrics;
+}
+
+Json ProcedureClock::toJson() const
+{
+    Json json = Json::Obj({});
+    for (int i = 0; i < ProcedureMetrics::METRIC_COUNT; i++)
+    {
+        int64_t latency = m_lastLatency[i];
+        if (latency >= 0)
+            json.put(ToJson(static_cast<EProcedureMetric>(i)).str() + "-us", latency);
+    }
+    return json;
+}
+
+Json ToJson(const EProcedureMetric &metric)
+{
+    switch (metric)
+    {
+    case EProcedureMetric::START_TO_REGISTERED:
+        return "start-to-registered";
+    case EProcedureMetric::REGISTRATION:
+        return "registration";
+    case EProcedureMetric::AUTHENTICATION:
+        return "authentication";
+    case EProcedureMetric::SECURITY_MODE:
+        return "security-mode";
+    case EProcedureMetric::SERVICE_REQUEST:
+        return "service-request";
+    case EProcedureMetric::DEREGISTRATION:
+        return "deregistration";
+    case EProcedureMetric::PDU_SESSION_ESTABLISHMENT:
+        return "pdu-session-establishment";
+    case EProcedureMetric::PDU_SESSION_TO_TUN:
+        return "pdu-session-to-tun";
+    default:
+        return "?";
+    }
+}
+
+Json ToJson(const EProcedureOutcome &outcome)
+{
+    switch (outcome)
+    {
+    case EProcedureOutcome::SUCCESS:
+        return "success";
+    case EProcedureOutcome::REJECT:
+        return "reject";
+    case EProcedureOutcome::FAILURE:
+        return "failure";
+    case EProcedureOutcome::TIMEOUT:
+        return "timeout";
+    default:
+        return "?";
+    }
+}
+
+} // namespace nr::ue
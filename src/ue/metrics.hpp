@@ -0,0 +1,89 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <utils/hdr_histogram.hpp>
+#include <utils/json.hpp>
+
+namespace nr::ue
+{
+
+enum class EProcedureMetric
+{
+    START_TO_REGISTERED,       // UE start until RM-REGISTERED for the first time
+    REGISTRATION,              // Registration Request sent until Registration Accept/Reject received
+    AUTHENTICATION,            // Authentication Request received until Authentication Response/Failure sent
+    SECURITY_MODE,             // Security Mode Command received until Security Mode Complete/Reject sent
+    SERVICE_REQUEST,           // Service Request sent until Service Accept/Reject received
+    DEREGISTRATION,            // De-registration Request sent until De-registration Accept received
+    PDU_SESSION_ESTABLISHMENT, // PDU Session Establishment Request sent until Accept/Reject received
+    PDU_SESSION_TO_TUN,        // PDU Session Establishment Request sent until the TUN interface is up
+};
+
+enum class EProcedureOutcome
+{
+    SUCCESS,
+    REJECT,
+    FAILURE,
+    TIMEOUT,
+};
+
+/* Latency histograms of the UE procedures, shared by all UEs of the process */
+class ProcedureMetrics
+{
+  public:
+    static constexpr const int METRIC_COUNT = 8;
+    static constexpr const int OUTCOME_COUNT = 4;
+
+  private:
+    mutable std::mutex m_mutex;
+    std::array<std::array<std::unique_ptr<HdrHistogram>, OUTCOME_COUNT>, METRIC_COUNT> m_histograms{};
+
+  public:
+    void record(EProcedureMetric metric, EProcedureOutcome outcome, int64_t latencyUs);
+
+    /* Summary of the percentiles, with the non-empty buckets too if 'withDistribution' */
+    [[nodiscard]] Json toJson(bool withDistribution) const;
+};
+
+/* Start times and the last measured latencies of the procedures of a UE. Procedures are timed in microseconds on
+ * the monotonic clock, an ongoing procedure started again is timed from the new start. */
+class ProcedureClock
+{
+  private:
+    ProcedureMetrics *m_metrics;
+    std::array<int64_t, ProcedureMetrics::METRIC_COUNT> m_startTime{};
+    std::array<std::atomic<int64_t>, ProcedureMetrics::METRIC_COUNT> m_lastLatency{};
+
+  public:
+    explicit ProcedureClock(ProcedureMetrics *metrics);
+
+  public:
+    static int64_t Now();
+
+    void start(EProcedureMetric metric);
+    /* Does nothing if the procedure is not ongoing */
+    void stop(EProcedureMetric metric, EProcedureOutcome outcome);
+    /* For the procedures whose start time is kept elsewhere, e.g. per PDU session */
+    void record(EProcedureMetric metric, EProcedureOutcome outcome, int64_t startTime);
+
+    [[nodiscard]] ProcedureMetrics *metrics() const;
+    [[nodiscard]] Json toJson() const;
+};
+
+Json ToJson(const EProcedureMetric &metric);
+Json ToJson(const EProcedureOutcome &outcome);
+
+} // namespace nr::ue
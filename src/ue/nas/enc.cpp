@@ -37,7 +37,7 @@ static nas::ESecurityHeaderType MakeSecurityHeaderType(const NasSecurityContext
 }
 
 static OctetString EncryptData(nas::ETypeOfCipheringAlgorithm alg, const NasCount &count, bool is3gppAccess,
-                               const OctetString &data, const OctetString &key)
+                               const OctetString &data, const OctetString &key, crypto::AesKeyCache &schedule)
 {
     int bearer = is3gppAccess ? 1 : 2;
     int direction = 0;
@@ -52,7 +52,7 @@ static OctetString EncryptData(nas::ETypeOfCipheringAlgorithm alg, const NasCoun
         crypto::EncryptEea1((uint32_t)count.toOctet4(), bearer, direction, msg, key);
         break;
     case nas::ETypeOfCipheringAlgorithm::EA2_128:
-        crypto::EncryptEea2((uint32_t)count.toOctet4(), bearer, direction, msg, key);
+        crypto::EncryptEea2((uint32_t)count.toOctet4(), bearer, direction, msg, schedule.get(key));
         break;
     case nas::ETypeOfCipheringAlgorithm::EA3_128:
         crypto::EncryptEea3((uint32_t)count.toOctet4(), bearer, direction, msg, key);
@@ -69,14 +69,13 @@ static std::unique_ptr<nas::SecuredMmMessage> Encrypt(NasSecurityContext &ctx, O
 {
     auto count = ctx.uplinkCount;
     auto is3gppAccess = ctx.is3gppAccess;
-    auto &intKey = ctx.keys.kNasInt;
     auto &encKey = ctx.keys.kNasEnc;
-    auto intAlg = ctx.integrity;
     auto encAlg = ctx.ciphering;
 
-    auto encryptedData =
-        bypassCiphering ? plainNasMessage.copy() : EncryptData(encAlg, count, is3gppAccess, plainNasMessage, encKey);
-    auto mac = ComputeMac(intAlg, count, is3gppAccess, true, intKey, encryptedData);
+    auto encryptedData = bypassCiphering
+                             ? plainNasMessage.copy()
+                             : EncryptData(encAlg, count, is3gppAccess, plainNasMessage, encKey, ctx.encSchedule);
+    auto mac = ComputeMac(ctx, count, true, encryptedData);
 
     auto secured = std::make_unique<nas::SecuredMmMessage>();
     secured->epd = nas::EExtendedProtocolDiscriminator::MOBILITY_MANAGEMENT_MESSAGES;
@@ -91,7 +90,8 @@ static std::unique_ptr<nas::SecuredMmMessage> Encrypt(NasSecurityContext &ctx, O
 }
 
 static OctetString DecryptData(nas::ETypeOfCipheringAlgorithm alg, const NasCount &count, bool is3gppAccess,
-                               const OctetString &key, nas::ESecurityHeaderType sht, const OctetString &data)
+                               const OctetString &key, crypto::AesKeyCache &schedule, nas::ESecurityHeaderType sht,
+                               const OctetString &data)
 {
     OctetString msg = data.copy();
 
@@ -110,7 +110,7 @@ static OctetString DecryptData(nas::ETypeOfCipheringAlgorithm alg, const NasCoun
         crypto::DecryptEea1((uint32_t)count.toOctet4(), bearer, direction, msg, key);
         break;
     case nas::ETypeOfCipheringAlgorithm::EA2_128:
-        crypto::DecryptEea2((uint32_t)count.toOctet4(), bearer, direction, msg, key);
+        crypto::DecryptEea2((uint32_t)count.toOctet4(), bearer, direction, msg, schedule.get(key));
         break;
     case nas::ETypeOfCipheringAlgorithm::EA3_128:
         crypto::DecryptEea3((uint32_t)count.toOctet4(), bearer, direction, msg, key);
@@ -138,12 +138,10 @@ std::unique_ptr<nas::NasMessage> Decrypt(NasSecurityContext &ctx, const nas::Sec
     auto estimatedCount = ctx.estimatedDownlinkCount(msg.sequenceNumber);
 
     auto is3gppAccess = ctx.is3gppAccess;
-    auto &intKey = ctx.keys.kNasInt;
     auto &encKey = ctx.keys.kNasEnc;
-    auto intAlg = ctx.integrity;
     auto encAlg = ctx.ciphering;
 
-    auto mac = ComputeMac(intAlg, estimatedCount, is3gppAccess, false, intKey, msg.plainNasMessage);
+    auto mac = ComputeMac(ctx, estimatedCount, false, msg.plainNasMessage);
 
     if (mac != (uint32_t)msg.messageAuthenticationCode)
     {
@@ -152,20 +150,23 @@ std::unique_ptr<nas::NasMessage> Decrypt(NasSecurityContext &ctx, const nas::Sec
     }
 
     ctx.updateDownlinkCount(estimatedCount);
-    OctetString decryptedData = DecryptData(encAlg, estimatedCount, is3gppAccess, encKey, msg.sht, msg.plainNasMessage);
+    OctetString decryptedData =
+        DecryptData(encAlg, estimatedCount, is3gppAccess, encKey, ctx.encSchedule, msg.sht, msg.plainNasMessage);
     OctetView buff{decryptedData};
     return nas::DecodeNasMessage(buff);
 }
 
-uint32_t ComputeMac(nas::ETypeOfIntegrityProtectionAlgorithm alg, NasCount count, bool is3gppAccess, bool isUplink,
-                    const OctetString &key, const OctetString &plainMessage)
+uint32_t ComputeMac(NasSecurityContext &ctx, NasCount count, bool isUplink, const OctetString &plainMessage)
 {
+    auto alg = ctx.integrity;
+    auto &key = ctx.keys.kNasInt;
+
     if (alg == nas::ETypeOfIntegrityProtectionAlgorithm::IA0)
         return 0;
 
     auto data = OctetString::Concat(OctetString::FromOctet(count.sqn), plainMessage);
 
-    int bearer = is3gppAccess ? 1 : 2;
+    int bearer = ctx.is3gppAccess ? 1 : 2;
     int direction = isUplink ? 0 : 1;
 
     switch (alg)
@@ -173,7 +174,7 @@ uint32_t ComputeMac(nas::ETypeOfIntegrityProtectionAlgorithm alg, NasCount count
     case nas::ETypeOfIntegrityProtectionAlgorithm::IA1_128:
         return crypto::ComputeMacEia1((int)count.toOctet4(), bearer, direction, data, key);
     case nas::ETypeOfIntegrityProtectionAlgorithm::IA2_128:
-        return crypto::ComputeMacEia2((int)count.toOctet4(), bearer, direction, data, key);
+        return crypto::ComputeMacEia2((int)count.toOctet4(), bearer, direction, data, ctx.intSchedule.get(key));
     case nas::ETypeOfIntegrityProtectionAlgorithm::IA3_128:
         return crypto::ComputeMacEia3((int)count.toOctet4(), bearer, direction, data, key);
     default:
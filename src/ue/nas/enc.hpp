@@ -18,7 +18,7 @@ std::unique_ptr<nas::SecuredMmMessage> Encrypt(NasSecurityContext &ctx, const na
                                                bool bypassCiphering);
 std::unique_ptr<nas::NasMessage> Decrypt(NasSecurityContext &ctx, const nas::SecuredMmMessage &msg);
 
-uint32_t ComputeMac(nas::ETypeOfIntegrityProtectionAlgorithm alg, NasCount count, bool is3gppAccess, bool isUplink,
-                    const OctetString &key, const OctetString &plainMessage);
+/* Computes the MAC with the integrity algorithm and the key of the context */
+uint32_t ComputeMac(NasSecurityContext &ctx, NasCount count, bool isUplink, const OctetString &plainMessage);
 
 } // namespace nr::ue::nas_enc
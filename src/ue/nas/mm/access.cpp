@@ -95,7 +95,7 @@ bool NasMm::hasEmergency()
 
 bool NasMm::isHighPriority()
 {
-    auto &acc = m_base->config->uacAcc;
+    auto &acc = m_base->config->profile->uacAcc;
     return acc.cls11 || acc.cls12 || acc.cls13 || acc.cls14 || acc.cls15;
 }
 
@@ -130,17 +130,17 @@ EUacResult NasMm::performUac()
 
         auto currentPlmn = m_base->shCtx.getCurrentPlmn();
 
-        if (m_base->config->uacAic.mps && m_rmState == ERmState::RM_REGISTERED && currentPlmn.hasValue())
+        if (m_base->config->profile->uacAic.mps && m_rmState == ERmState::RM_REGISTERED && currentPlmn.hasValue())
         {
-            if (currentPlmn == m_base->config->hplmn || m_storage->equivalentPlmnList->contains(currentPlmn) ||
-                currentPlmn.mcc == m_base->config->hplmn.mcc)
+            if (currentPlmn == m_base->config->profile->hplmn || m_storage->equivalentPlmnList->contains(currentPlmn) ||
+                currentPlmn.mcc == m_base->config->profile->hplmn.mcc)
                 ais[1] = true;
         }
 
-        if (m_base->config->uacAic.mcs && m_rmState == ERmState::RM_REGISTERED && currentPlmn.hasValue())
+        if (m_base->config->profile->uacAic.mcs && m_rmState == ERmState::RM_REGISTERED && currentPlmn.hasValue())
         {
-            if (currentPlmn == m_base->config->hplmn || m_storage->equivalentPlmnList->contains(currentPlmn) ||
-                currentPlmn.mcc == m_base->config->hplmn.mcc)
+            if (currentPlmn == m_base->config->profile->hplmn || m_storage->equivalentPlmnList->contains(currentPlmn) ||
+                currentPlmn.mcc == m_base->config->profile->hplmn.mcc)
                 ais[2] = true;
         }
 
@@ -153,22 +153,22 @@ EUacResult NasMm::performUac()
         }
 
         if (currentPlmn.hasValue() &&
-            (currentPlmn == m_base->config->hplmn || m_storage->equivalentPlmnList->contains(currentPlmn)))
+            (currentPlmn == m_base->config->profile->hplmn || m_storage->equivalentPlmnList->contains(currentPlmn)))
         {
-            if (m_base->config->uacAcc.cls11)
+            if (m_base->config->profile->uacAcc.cls11)
                 ais[11] = true;
-            if (m_base->config->uacAcc.cls15)
+            if (m_base->config->profile->uacAcc.cls15)
                 ais[15] = true;
         }
 
         if (currentPlmn.hasValue() &&
-            (currentPlmn == m_base->config->hplmn || currentPlmn.mcc == m_base->config->hplmn.mcc))
+            (currentPlmn == m_base->config->profile->hplmn || currentPlmn.mcc == m_base->config->profile->hplmn.mcc))
         {
-            if (m_base->config->uacAcc.cls12)
+            if (m_base->config->profile->uacAcc.cls12)
                 ais[12] = true;
-            if (m_base->config->uacAcc.cls13)
+            if (m_base->config->profile->uacAcc.cls13)
                 ais[13] = true;
-            if (m_base->config->uacAcc.cls14)
+            if (m_base->config->profile->uacAcc.cls14)
                 ais[14] = true;
         }
 
@@ -260,36 +260,21 @@ EUacResult NasMm::performUac()
         return ASN_RRC_EstablishmentCause_mt_Access;
     }();
 
-    auto uacInput = std::make_unique<UacInput>();
-    uacInput->identities = accessIdentities;
-    uacInput->category = accessCategory;
-    uacInput->establishmentCause = static_cast<int>(establishmentCause);
-
-    auto uacCtl = LightSync<UacInput, UacOutput>::MakeShared(100, 0, std::move(uacInput));
-
-    auto *w = new NmUeNasToRrc(NmUeNasToRrc::PERFORM_UAC);
-    w->uacCtl = uacCtl;
+    auto *w = new NmUeNasToRrc(NmUeNasToRrc::UAC_PERFORMED);
+    w->establishmentCause = static_cast<int>(establishmentCause);
     m_base->rrcTask->push(w);
 
-    auto uacOutput = uacCtl->waitForProcess();
-
-    if (uacOutput == nullptr)
-    {
-        m_logger->err("No response from RRC from UAC checks, considering access attempt is barred");
-        return EUacResult::BARRED;
-    }
-
-    auto res = uacOutput->res;
+    auto res = m_base->shCtx.uacCellState.get().isBarred(accessIdentities) ? EUacResult::BARRED : EUacResult::ALLOWED;
 
     switch (res)
     {
     case EUacResult::ALLOWED:
-        m_logger->debug("UAC access attempt is allowed for identity[%s], category[%s]",
+        m_logger->debug(FMT_STRING("UAC access attempt is allowed for identity[{}], category[{}]"),
                         AccessIdentitiesToString(accessIdentities).c_str(),
                         AccessCategoryToString(accessCategory).c_str());
         return EUacResult::ALLOWED;
     case EUacResult::BARRED:
-        m_logger->err("UAC access attempt is barred for identity[%s], category[%s]",
+        m_logger->err(FMT_STRING("UAC access attempt is barred for identity[{}], category[{}]"),
                       AccessIdentitiesToString(accessIdentities).c_str(),
                       AccessCategoryToString(accessCategory).c_str());
         return EUacResult::BARRED;
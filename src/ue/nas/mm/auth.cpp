@@ -53,7 +53,7 @@ void NasMm::receiveAuthenticationRequestEap(const nas::AuthenticationRequest &ms
     };
 
     auto sendAuthFailure = [this](nas::EMmCause cause) {
-        m_logger->err("Sending Authentication Failure with cause [%s]", nas::utils::EnumToString(cause));
+        m_logger->err(FMT_STRING("Sending Authentication Failure with cause [{}]"), nas::utils::EnumToString(cause));
 
         // Clear RAND and RES* stored in volatile memory
         m_usim->m_rand = {};
@@ -167,15 +167,15 @@ void NasMm::receiveAuthenticationRequestEap(const nas::AuthenticationRequest &ms
         auto &ckPrime = ckPrimeIkPrime.first;
         auto &ikPrime = ckPrimeIkPrime.second;
 
-        auto mk = keys::CalculateMk(ckPrime, ikPrime, m_base->config->supi.value());
+        auto mk = keys::CalculateMk(ckPrime, ikPrime, m_base->config->getSupi().value());
         auto kaut = mk.subCopy(16, 32);
 
         // Check the received AT_MAC
         auto expectedMac = keys::CalculateMacForEapAkaPrime(kaut, receivedEap);
         if (expectedMac != receivedMac)
         {
-            m_logger->err("AT_MAC failure in EAP AKA'. expected: %s received: %s", expectedMac.toHexString().c_str(),
-                          receivedMac.toHexString().c_str());
+            m_logger->err(FMT_STRING("AT_MAC failure in EAP AKA'. expected: {} received: {}"),
+                          expectedMac.toHexString().c_str(), receivedMac.toHexString().c_str());
 
             if (networkFailingTheAuthCheck(true))
                 return;
@@ -267,7 +267,8 @@ void NasMm::receiveAuthenticationRequest5gAka(const nas::AuthenticationRequest &
 
     auto sendFailure = [this](nas::EMmCause cause, std::optional<OctetString> &&auts = std::nullopt) {
         if (cause != nas::EMmCause::SYNCH_FAILURE)
-            m_logger->err("Sending Authentication Failure with cause [%s]", nas::utils::EnumToString(cause));
+            m_logger->err(FMT_STRING("Sending Authentication Failure with cause [{}]"),
+                          nas::utils::EnumToString(cause));
         else
             m_logger->debug("Sending Authentication Failure due to SQN out of range");
 
@@ -498,8 +499,8 @@ EAutnValidationRes NasMm::validateAutn(const OctetString &rand, const OctetStrin
     // Check MAC
     if (receivedMAC != milenage.mac_a)
     {
-        m_logger->err("AUTN validation MAC mismatch. expected [%s] received [%s]", milenage.mac_a.toHexString().c_str(),
-                      receivedMAC.toHexString().c_str());
+        m_logger->err(FMT_STRING("AUTN validation MAC mismatch. expected [{}] received [{}]"),
+                      milenage.mac_a.toHexString().c_str(), receivedMAC.toHexString().c_str());
         return EAutnValidationRes::MAC_FAILURE;
     }
 
@@ -508,13 +509,13 @@ EAutnValidationRes NasMm::validateAutn(const OctetString &rand, const OctetStrin
 
 crypto::milenage::Milenage NasMm::calculateMilenage(const OctetString &sqn, const OctetString &rand, bool dummyAmf)
 {
-    OctetString amf = dummyAmf ? OctetString::FromSpare(2) : m_base->config->amf.copy();
+    OctetString amf = dummyAmf ? OctetString::FromSpare(2) : m_base->config->getAmf().copy();
 
-    if (m_base->config->opType == OpType::OPC)
-        return crypto::milenage::Calculate(m_base->config->opC, m_base->config->key, rand, sqn, amf);
+    if (m_base->config->getOpType() == OpType::OPC)
+        return crypto::milenage::Calculate(m_base->config->getOpC(), m_base->config->getKey(), rand, sqn, amf);
 
-    OctetString opc = crypto::milenage::CalculateOpC(m_base->config->opC, m_base->config->key);
-    return crypto::milenage::Calculate(opc, m_base->config->key, rand, sqn, amf);
+    OctetString opc = crypto::milenage::CalculateOpC(m_base->config->getOpC(), m_base->config->getKey());
+    return crypto::milenage::Calculate(opc, m_base->config->getKey(), rand, sqn, amf);
 }
 
 bool NasMm::networkFailingTheAuthCheck(bool hasChance)
@@ -56,7 +56,7 @@ static EMmState GetMmStateFromSubState(EMmSubState subState)
 
 NasMm::NasMm(TaskBase *base, NasTimers *timers) : m_base{base}, m_timers{timers}, m_sm{}, m_usim{}, m_procCtl{}
 {
-    m_logger = base->logBase->makeUniqueLogger(base->config->getLoggerPrefix() + "nas");
+    m_logger = base->logBase->makePrefixedLogger(base->config->getLoggerPrefix(), "nas");
 
     m_rmState = ERmState::RM_DEREGISTERED;
     m_cmState = ECmState::CM_IDLE;
@@ -71,6 +71,8 @@ void NasMm::onStart(NasSm *sm, Usim *usim)
     m_sm = sm;
     m_usim = usim;
 
+    m_base->procClock->start(EProcedureMetric::START_TO_REGISTERED);
+
     triggerMmCycle();
 }
 
@@ -246,13 +248,13 @@ void NasMm::switchMmState(EMmSubState subState)
     if (m_base->nodeListener)
     {
         m_base->nodeListener->onSwitch(app::NodeType::UE, m_base->config->getNodeName(), app::StateType::MM,
-                                       ToJson(oldSubState).str(), ToJson(subState).str());
-        m_base->nodeListener->onSwitch(app::NodeType::UE, m_base->config->getNodeName(), app::StateType::MM_SUB,
                                        ToJson(oldState).str(), ToJson(state).str());
+        m_base->nodeListener->onSwitch(app::NodeType::UE, m_base->config->getNodeName(), app::StateType::MM_SUB,
+                                       ToJson(oldSubState).str(), ToJson(subState).str());
     }
 
     if (state != oldState || subState != oldSubState)
-        m_logger->info("UE switches to state [%s]", ToJson(subState).str().c_str());
+        m_logger->info(FMT_STRING("UE switches to state [{}]"), ToJson(subState).str().c_str());
 
     triggerMmCycle();
 }
@@ -263,7 +265,7 @@ void NasMm::switchCmState(ECmState state)
     m_cmState = state;
 
     if (state != oldState)
-        m_logger->info("UE switches to state [%s]", ToJson(state).str().c_str());
+        m_logger->info(FMT_STRING("UE switches to state [{}]"), ToJson(state).str().c_str());
 
     onSwitchCmState(oldState, m_cmState);
 
@@ -294,7 +296,7 @@ void NasMm::switchUState(E5UState state)
     }
 
     if (state != oldState)
-        m_logger->info("UE switches to state [%s]", ToJson(state).str().c_str());
+        m_logger->info(FMT_STRING("UE switches to state [{}]"), ToJson(state).str().c_str());
 
     triggerMmCycle();
 }
@@ -340,6 +342,9 @@ void NasMm::onSwitchMmState(EMmState oldState, EMmState newState, EMmSubState ol
 
 void NasMm::onSwitchRmState(ERmState oldState, ERmState newState)
 {
+    if (newState == ERmState::RM_REGISTERED)
+        m_base->procClock->stop(EProcedureMetric::START_TO_REGISTERED, EProcedureOutcome::SUCCESS);
+
     if (oldState == ERmState::RM_REGISTERED && newState == ERmState::RM_REGISTERED)
     {
         // "The UE shall delete (List of equivalent PLMNs) ...  when the UE registered for emergency services
@@ -62,7 +62,7 @@ EProcRc NasMm::sendDeregistration(EDeregCause deregCause)
         return EProcRc::CANCEL;
     }
 
-    m_logger->debug("Starting de-registration procedure due to [%s]", ToJson(deregCause).str().c_str());
+    m_logger->debug(FMT_STRING("Starting de-registration procedure due to [{}]"), ToJson(deregCause).str().c_str());
 
     updateProvidedGuti();
 
@@ -89,6 +89,7 @@ EProcRc NasMm::sendDeregistration(EDeregCause deregCause)
     m_lastDeregistrationRequest = std::move(request);
     m_lastDeregCause = deregCause;
     m_timers->t3521.resetExpiryCount();
+    m_base->procClock->start(EProcedureMetric::DEREGISTRATION);
 
     if (m_lastDeregistrationRequest->deRegistrationType.switchOff == nas::ESwitchOff::NORMAL_DE_REGISTRATION)
     {
@@ -24,12 +24,12 @@ void NasMm::receiveIdentityRequest(const nas::IdentityRequest &msg)
     else if (msg.identityType.value == nas::EIdentityType::IMEI)
     {
         resp.mobileIdentity.type = nas::EIdentityType::IMEI;
-        resp.mobileIdentity.value = *m_base->config->imei;
+        resp.mobileIdentity.value = *m_base->config->getImei();
     }
     else if (msg.identityType.value == nas::EIdentityType::IMEISV)
     {
         resp.mobileIdentity.type = nas::EIdentityType::IMEISV;
-        resp.mobileIdentity.value = *m_base->config->imeiSv;
+        resp.mobileIdentity.value = *m_base->config->getImeiSv();
     }
     else if (msg.identityType.value == nas::EIdentityType::GUTI)
     {
@@ -49,7 +49,7 @@ void NasMm::receiveIdentityRequest(const nas::IdentityRequest &msg)
     else
     {
         resp.mobileIdentity.type = nas::EIdentityType::NO_IDENTITY;
-        m_logger->err("Requested identity is not available: %d", (int)msg.identityType.value);
+        m_logger->err(FMT_STRING("Requested identity is not available: {}"), (int)msg.identityType.value);
     }
 
     sendNasMessage(resp);
@@ -71,15 +71,15 @@ nas::IE5gsMobileIdentity NasMm::getOrGenerateSuci()
 
 nas::IE5gsMobileIdentity NasMm::generateSuci()
 {
-    auto &supi = m_base->config->supi;
-    auto &plmn = m_base->config->hplmn;
+    auto supi = m_base->config->getSupi();
+    auto &plmn = m_base->config->profile->hplmn;
 
     if (!supi.has_value())
         return {};
 
     if (supi->type != "imsi")
     {
-        m_logger->err("SUCI generating failed, invalid SUPI type: %s", supi->value.c_str());
+        m_logger->err(FMT_STRING("SUCI generating failed, invalid SUPI type: {}"), supi->value.c_str());
         return {};
     }
 
@@ -108,18 +108,18 @@ nas::IE5gsMobileIdentity NasMm::getOrGeneratePreferredId()
     {
         return suci;
     }
-    else if (m_base->config->imei.has_value())
+    else if (m_base->config->getImei().has_value())
     {
         nas::IE5gsMobileIdentity res{};
         res.type = nas::EIdentityType::IMEI;
-        res.value = *m_base->config->imei;
+        res.value = *m_base->config->getImei();
         return res;
     }
-    else if (m_base->config->imeiSv.has_value())
+    else if (m_base->config->getImeiSv().has_value())
     {
         nas::IE5gsMobileIdentity res{};
         res.type = nas::EIdentityType::IMEISV;
-        res.value = *m_base->config->imeiSv;
+        res.value = *m_base->config->getImeiSv();
         return res;
     }
     else
@@ -24,6 +24,49 @@ static bool IsInitialNasMessage(const nas::PlainMmMessage &msg)
            msgType == nas::EMessageType::SERVICE_REQUEST;
 }
 
+// Stops the procedures ended by the message, and starts the ones the network starts
+static void TimeProcedures(ProcedureClock &clock, const nas::PlainMmMessage &msg)
+{
+    switch (msg.messageType)
+    {
+    case nas::EMessageType::REGISTRATION_ACCEPT:
+        clock.stop(EProcedureMetric::REGISTRATION, EProcedureOutcome::SUCCESS);
+        break;
+    case nas::EMessageType::REGISTRATION_REJECT:
+        clock.stop(EProcedureMetric::REGISTRATION, EProcedureOutcome::REJECT);
+        break;
+    case nas::EMessageType::SERVICE_ACCEPT:
+        clock.stop(EProcedureMetric::SERVICE_REQUEST, EProcedureOutcome::SUCCESS);
+        break;
+    case nas::EMessageType::SERVICE_REJECT:
+        clock.stop(EProcedureMetric::SERVICE_REQUEST, EProcedureOutcome::REJECT);
+        break;
+    case nas::EMessageType::DEREGISTRATION_ACCEPT_UE_ORIGINATING:
+        clock.stop(EProcedureMetric::DEREGISTRATION, EProcedureOutcome::SUCCESS);
+        break;
+    case nas::EMessageType::AUTHENTICATION_REQUEST:
+        clock.start(EProcedureMetric::AUTHENTICATION);
+        break;
+    case nas::EMessageType::AUTHENTICATION_RESPONSE:
+        clock.stop(EProcedureMetric::AUTHENTICATION, EProcedureOutcome::SUCCESS);
+        break;
+    case nas::EMessageType::AUTHENTICATION_FAILURE:
+        clock.stop(EProcedureMetric::AUTHENTICATION, EProcedureOutcome::FAILURE);
+        break;
+    case nas::EMessageType::SECURITY_MODE_COMMAND:
+        clock.start(EProcedureMetric::SECURITY_MODE);
+        break;
+    case nas::EMessageType::SECURITY_MODE_COMPLETE:
+        clock.stop(EProcedureMetric::SECURITY_MODE, EProcedureOutcome::SUCCESS);
+        break;
+    case nas::EMessageType::SECURITY_MODE_REJECT:
+        clock.stop(EProcedureMetric::SECURITY_MODE, EProcedureOutcome::REJECT);
+        break;
+    default:
+        break;
+    }
+}
+
 static bool IsAcceptedWithoutIntegrity(const nas::PlainMmMessage &msg)
 {
     auto msgType = msg.messageType;
@@ -187,6 +230,8 @@ EProcRc NasMm::sendNasMessage(const nas::PlainMmMessage &msg)
     m->nasPdu = std::move(pdu);
     m_base->rrcTask->push(m);
 
+    TimeProcedures(*m_base->procClock, msg);
+
     return EProcRc::OK;
 }
 
@@ -295,6 +340,8 @@ void NasMm::receiveNasMessage(const nas::NasMessage &msg)
 
 void NasMm::receiveMmMessage(const nas::PlainMmMessage &msg)
 {
+    TimeProcedures(*m_base->procClock, msg);
+
     switch (msg.messageType)
     {
     case nas::EMessageType::REGISTRATION_ACCEPT:
@@ -340,14 +387,14 @@ void NasMm::receiveMmMessage(const nas::PlainMmMessage &msg)
         receiveDlNasTransport((const nas::DlNasTransport &)msg);
         break;
     default:
-        m_logger->err("Unhandled NAS MM message received [%d]", (int)msg.messageType);
+        m_logger->err(FMT_STRING("Unhandled NAS MM message received [{}]"), (int)msg.messageType);
         break;
     }
 }
 
 void NasMm::sendMmStatus(nas::EMmCause cause)
 {
-    m_logger->warn("Sending MM Status with cause [%s]", nas::utils::EnumToString(cause));
+    m_logger->warn(FMT_STRING("Sending MM Status with cause [{}]"), nas::utils::EnumToString(cause));
 
     nas::FiveGMmStatus m;
     m.mmCause.value = cause;
@@ -356,7 +403,7 @@ void NasMm::sendMmStatus(nas::EMmCause cause)
 
 void NasMm::receiveMmStatus(const nas::FiveGMmStatus &msg)
 {
-    m_logger->err("MM status received with cause [%s]", nas::utils::EnumToString(msg.mmCause.value));
+    m_logger->err(FMT_STRING("MM status received with cause [{}]"), nas::utils::EnumToString(msg.mmCause.value));
 }
 
 bool NasMm::checkForReplay(const nas::SecuredMmMessage &msg)
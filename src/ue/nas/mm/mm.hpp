@@ -10,6 +10,7 @@
 
 #include <lib/crypt/milenage.hpp>
 #include <lib/nas/nas.hpp>
+#include <ue/metrics.hpp>
 #include <ue/nas/storage.hpp>
 #include <ue/nas/usim/usim.hpp>
 #include <ue/nts.hpp>
@@ -53,7 +53,7 @@ void NasMm::initialRegistrationRequired(EInitialRegCause cause)
     if (m_procCtl.initialRegistration == cause)
         return;
 
-    m_logger->debug("Initial registration required due to [%s]", ToJson(cause).str().c_str());
+    m_logger->debug(FMT_STRING("Initial registration required due to [{}]"), ToJson(cause).str().c_str());
 
     AssignCause(m_procCtl.initialRegistration, cause);
     triggerMmCycle();
@@ -67,7 +67,7 @@ void NasMm::mobilityUpdatingRequired(ERegUpdateCause cause)
     if (m_procCtl.mobilityRegistration == cause)
         return;
 
-    m_logger->debug("Mobility registration updating required due to [%s]", ToJson(cause).str().c_str());
+    m_logger->debug(FMT_STRING("Mobility registration updating required due to [{}]"), ToJson(cause).str().c_str());
 
     AssignCause(m_procCtl.mobilityRegistration, cause);
     triggerMmCycle();
@@ -81,7 +81,7 @@ void NasMm::serviceRequestRequired(EServiceReqCause cause)
     if (m_procCtl.serviceRequest == cause)
         return;
 
-    m_logger->debug("Service request required due to [%s]", ToJson(cause).str().c_str());
+    m_logger->debug(FMT_STRING("Service request required due to [{}]"), ToJson(cause).str().c_str());
 
     AssignCause(m_procCtl.serviceRequest, cause);
     triggerMmCycle();
@@ -95,7 +95,7 @@ void NasMm::deregistrationRequired(EDeregCause cause)
     if (m_procCtl.deregistration == cause)
         return;
 
-    m_logger->debug("De-registration required due to [%s]", ToJson(cause).str().c_str());
+    m_logger->debug(FMT_STRING("De-registration required due to [{}]"), ToJson(cause).str().c_str());
 
     AssignCause(m_procCtl.deregistration, cause);
     triggerMmCycle();
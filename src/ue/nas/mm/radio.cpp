@@ -77,13 +77,13 @@ void NasMm::performPlmnSelection()
 
     // Highest priority is for HPLMN, so just look for HPLMN first.
     for (auto &plmn : plmns)
-        if (plmn == m_base->config->hplmn)
+        if (plmn == m_base->config->profile->hplmn)
             candidates.push_back(plmn);
 
     // Then again look for the all PLMNS
     for (auto &plmn : plmns)
     {
-        if (plmn == m_base->config->hplmn)
+        if (plmn == m_base->config->profile->hplmn)
             continue; // If it's the HPLMN, it's already added above
         if (m_storage->forbiddenPlmnList->contains(plmn))
             continue;
@@ -99,13 +99,13 @@ void NasMm::performPlmnSelection()
     {
         if (logFailures)
         {
-            m_logger->err("No PLMN could be selected among [%d] PLMNs", static_cast<int>(plmns.size()));
+            m_logger->err(FMT_STRING("No PLMN could be selected among [{}] PLMNs"), static_cast<int>(plmns.size()));
             m_lastTimePlmnSearchFailureLogged = currentTime;
         }
     }
     else if (lastSelectedPlmn != selected)
     {
-        m_logger->info("Selected plmn[%s]", ToJson(selected).str().c_str());
+        m_logger->info(FMT_STRING("Selected plmn[{}]"), ToJson(selected).str().c_str());
         m_base->rrcTask->push(new NmUeNasToRrc(NmUeNasToRrc::RRC_NOTIFY));
 
         resetRegAttemptCounter();
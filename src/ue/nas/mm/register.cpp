@@ -54,7 +54,7 @@ EProcRc NasMm::sendInitialRegistration(EInitialRegCause regCause)
         return EProcRc::STAY;
     }
 
-    m_logger->debug("Sending %s",
+    m_logger->debug(FMT_STRING("Sending {}"),
                     nas::utils::EnumToString(isEmergencyReg ? nas::ERegistrationType::EMERGENCY_REGISTRATION
                                                             : nas::ERegistrationType::INITIAL_REGISTRATION));
 
@@ -122,6 +122,8 @@ EProcRc NasMm::sendInitialRegistration(EInitialRegCause regCause)
     m_timers->t3502.stop();
     m_timers->t3511.stop();
 
+    m_base->procClock->start(EProcedureMetric::REGISTRATION);
+
     return EProcRc::OK;
 }
 
@@ -170,7 +172,7 @@ EProcRc NasMm::sendMobilityRegistration(ERegUpdateCause updateCause)
         return EProcRc::STAY;
     }
 
-    m_logger->debug("Sending %s with update cause [%s]",
+    m_logger->debug(FMT_STRING("Sending {} with update cause [{}]"),
                     nas::utils::EnumToString(updateCause == ERegUpdateCause::T3512_EXPIRY
                                                  ? nas::ERegistrationType::PERIODIC_REGISTRATION_UPDATING
                                                  : nas::ERegistrationType::MOBILITY_REGISTRATION_UPDATING),
@@ -254,6 +256,8 @@ EProcRc NasMm::sendMobilityRegistration(ERegUpdateCause updateCause)
     m_timers->t3502.stop();
     m_timers->t3511.stop();
 
+    m_base->procClock->start(EProcedureMetric::REGISTRATION);
+
     return EProcRc::OK;
 }
 
@@ -428,7 +432,7 @@ void NasMm::receiveInitialRegistrationAccept(const nas::RegistrationAccept &msg)
     else if (regType == nas::ERegistrationType::EMERGENCY_REGISTRATION)
         m_registeredForEmergency = true;
 
-    m_logger->info("%s is successful", nas::utils::EnumToString(regType));
+    m_logger->info(FMT_STRING("{} is successful"), nas::utils::EnumToString(regType));
 }
 
 void NasMm::receiveMobilityRegistrationAccept(const nas::RegistrationAccept &msg)
@@ -571,7 +575,7 @@ void NasMm::receiveMobilityRegistrationAccept(const nas::RegistrationAccept &msg
         sendNasMessage(nas::RegistrationComplete{});
 
     auto regType = m_lastRegistrationRequest->registrationType.registrationType;
-    m_logger->info("%s is successful", nas::utils::EnumToString(regType));
+    m_logger->info(FMT_STRING("{} is successful"), nas::utils::EnumToString(regType));
 }
 
 void NasMm::receiveRegistrationReject(const nas::RegistrationReject &msg)
@@ -586,7 +590,7 @@ void NasMm::receiveRegistrationReject(const nas::RegistrationReject &msg)
     auto cause = msg.mmCause.value;
     auto regType = m_lastRegistrationRequest->registrationType.registrationType;
 
-    m_logger->err("%s failed [%s]", nas::utils::EnumToString(regType), nas::utils::EnumToString(cause));
+    m_logger->err(FMT_STRING("{} failed [{}]"), nas::utils::EnumToString(regType), nas::utils::EnumToString(cause));
 
     if (regType == nas::ERegistrationType::INITIAL_REGISTRATION ||
         regType == nas::ERegistrationType::EMERGENCY_REGISTRATION)
@@ -610,7 +614,7 @@ void NasMm::receiveInitialRegistrationReject(const nas::RegistrationReject &msg)
         if (msg.eapMessage->eap->code == eap::ECode::FAILURE)
             receiveEapFailureMessage(*msg.eapMessage->eap);
         else
-            m_logger->warn("Network sent EAP with type of %s in RegistrationReject, ignoring EAP IE.",
+            m_logger->warn(FMT_STRING("Network sent EAP with type of {} in RegistrationReject, ignoring EAP IE."),
                            nas::utils::EnumToString(msg.eapMessage->eap->code));
     }
 
@@ -768,7 +772,7 @@ void NasMm::receiveMobilityRegistrationReject(const nas::RegistrationReject &msg
         if (msg.eapMessage->eap->code == eap::ECode::FAILURE)
             receiveEapFailureMessage(*msg.eapMessage->eap);
         else
-            m_logger->warn("Network sent EAP with type of %s in RegistrationReject, ignoring EAP IE.",
+            m_logger->warn(FMT_STRING("Network sent EAP with type of {} in RegistrationReject, ignoring EAP IE."),
                            nas::utils::EnumToString(msg.eapMessage->eap->code));
     }
 
@@ -926,6 +930,8 @@ void NasMm::receiveMobilityRegistrationReject(const nas::RegistrationReject &msg
 
 void NasMm::handleAbnormalInitialRegFailure(nas::ERegistrationType regType)
 {
+    m_base->procClock->stop(EProcedureMetric::REGISTRATION, EProcedureOutcome::FAILURE);
+
     // Timer T3510 shall be stopped if still running
     m_timers->t3510.stop();
 
@@ -970,6 +976,8 @@ void NasMm::handleAbnormalInitialRegFailure(nas::ERegistrationType regType)
 
 void NasMm::handleAbnormalMobilityRegFailure(nas::ERegistrationType regType)
 {
+    m_base->procClock->stop(EProcedureMetric::REGISTRATION, EProcedureOutcome::FAILURE);
+
     // "Timer T3510 shall be stopped if still running"
     m_timers->t3510.stop();
 
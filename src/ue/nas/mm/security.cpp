@@ -56,7 +56,7 @@ void NasMm::receiveSecurityModeCommand(const nas::SecurityModeCommand &msg)
         nas::SecurityModeReject resp;
         resp.mmCause.value = cause;
         sendNasMessage(resp);
-        m_logger->err("Rejecting Security Mode Command with cause [%s]", nas::utils::EnumToString(cause));
+        m_logger->err(FMT_STRING("Rejecting Security Mode Command with cause [{}]"), nas::utils::EnumToString(cause));
     };
 
     // The RAND and RES* values stored in the ME shall be deleted and timer T3516, if running, shall be stopped
@@ -70,7 +70,7 @@ void NasMm::receiveSecurityModeCommand(const nas::SecurityModeCommand &msg)
 
     if (!IsValidKsi(msg.ngKsi))
     {
-        m_logger->err("Invalid ngKSI received, tsc[%d], ksi[%d]", (int)msg.ngKsi.tsc, msg.ngKsi.ksi);
+        m_logger->err(FMT_STRING("Invalid ngKSI received, tsc[{}], ksi[{}]"), (int)msg.ngKsi.tsc, msg.ngKsi.ksi);
         reject(nas::EMmCause::SEC_MODE_REJECTED_UNSPECIFIED);
         return;
     }
@@ -96,7 +96,7 @@ void NasMm::receiveSecurityModeCommand(const nas::SecurityModeCommand &msg)
     int whichCtx = FindSecurityContext(msg.ngKsi.ksi, m_usim->m_currentNsCtx, m_usim->m_nonCurrentNsCtx);
     if (whichCtx == -1)
     {
-        m_logger->err("Security context with ngKSI[%d] not found", msg.ngKsi.ksi);
+        m_logger->err(FMT_STRING("Security context with ngKSI[{}] not found"), msg.ngKsi.ksi);
         reject(nas::EMmCause::SEC_MODE_REJECTED_UNSPECIFIED);
         return;
     }
@@ -155,8 +155,7 @@ void NasMm::receiveSecurityModeCommand(const nas::SecurityModeCommand &msg)
 
         keys::DeriveNasKeys(tmpCtx);
 
-        uint32_t calculatedMac = nas_enc::ComputeMac(tmpCtx.integrity, tmpCtx.downlinkCount, tmpCtx.is3gppAccess, false,
-                                                     tmpCtx.keys.kNasInt, msg._originalPlainNasPdu);
+        uint32_t calculatedMac = nas_enc::ComputeMac(tmpCtx, tmpCtx.downlinkCount, false, msg._originalPlainNasPdu);
 
         // First check with the last estimated NAS COUNT
         if (calculatedMac != static_cast<uint32_t>(msg._macForNewSC))
@@ -166,8 +165,7 @@ void NasMm::receiveSecurityModeCommand(const nas::SecurityModeCommand &msg)
 
             tmpCtx.downlinkCount = {}; // assign NAS COUNT=0
 
-            calculatedMac = nas_enc::ComputeMac(tmpCtx.integrity, tmpCtx.downlinkCount, tmpCtx.is3gppAccess, false,
-                                                tmpCtx.keys.kNasInt, msg._originalPlainNasPdu);
+            calculatedMac = nas_enc::ComputeMac(tmpCtx, tmpCtx.downlinkCount, false, msg._originalPlainNasPdu);
 
             if (calculatedMac != static_cast<uint32_t>(msg._macForNewSC))
             {
@@ -210,7 +208,7 @@ void NasMm::receiveSecurityModeCommand(const nas::SecurityModeCommand &msg)
     nsCtx->ciphering = msg.selectedNasSecurityAlgorithms.ciphering;
     keys::DeriveNasKeys(*nsCtx);
 
-    m_logger->debug("Selected integrity[%d] ciphering[%d]", (int)nsCtx->integrity, (int)nsCtx->ciphering);
+    m_logger->debug(FMT_STRING("Selected integrity[{}] ciphering[{}]"), (int)nsCtx->integrity, (int)nsCtx->ciphering);
 
     // The UE shall in addition reset the uplink NAS COUNT counter if a) the SECURITY MODE COMMAND message is received
     // in order to take a 5G NAS security context into use created after a successful execution of the 5G AKA based
@@ -243,11 +241,11 @@ void NasMm::receiveSecurityModeCommand(const nas::SecurityModeCommand &msg)
     // Append IMEISV if requested
     if (msg.imeiSvRequest.has_value() && msg.imeiSvRequest->imeiSvRequest == nas::EImeiSvRequest::REQUESTED)
     {
-        if (m_base->config->imeiSv.has_value())
+        if (m_base->config->getImeiSv().has_value())
         {
             resp.imeiSv = nas::IE5gsMobileIdentity{};
             resp.imeiSv->type = nas::EIdentityType::IMEISV;
-            resp.imeiSv->value = *m_base->config->imeiSv;
+            resp.imeiSv->value = *m_base->config->getImeiSv();
         }
     }
 
@@ -273,7 +271,7 @@ void NasMm::receiveSecurityModeCommand(const nas::SecurityModeCommand &msg)
 
 nas::IEUeSecurityCapability NasMm::createSecurityCapabilityIe()
 {
-    auto &algs = m_base->config->supportedAlgs;
+    auto &algs = m_base->config->profile->supportedAlgs;
     auto supported = ~0;
 
     nas::IEUeSecurityCapability res{};
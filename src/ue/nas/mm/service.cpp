@@ -97,7 +97,7 @@ EProcRc NasMm::sendServiceRequest(EServiceReqCause reqCause)
         return EProcRc::STAY;
     }
 
-    m_logger->debug("Sending Service Request due to [%s]", ToJson(reqCause).str().c_str());
+    m_logger->debug(FMT_STRING("Sending Service Request due to [{}]"), ToJson(reqCause).str().c_str());
 
     updateProvidedGuti();
 
@@ -203,6 +203,7 @@ EProcRc NasMm::sendServiceRequest(EServiceReqCause reqCause)
     m_lastServiceRequest = std::move(request);
     m_lastServiceReqCause = reqCause;
     m_timers->t3517.start();
+    m_base->procClock->start(EProcedureMetric::SERVICE_REQUEST);
 
     switchMmState(EMmSubState::MM_SERVICE_REQUEST_INITIATED_PS);
 
@@ -250,7 +251,7 @@ void NasMm::receiveServiceAccept(const nas::ServiceAccept &msg)
     if (msg.pduSessionReactivationResultErrorCause.has_value())
     {
         for (auto &item : msg.pduSessionReactivationResultErrorCause->values)
-            m_logger->err("PDU session reactivation result error PSI[%d] cause[%s]", item.pduSessionId,
+            m_logger->err(FMT_STRING("PDU session reactivation result error PSI[{}] cause[{}]"), item.pduSessionId,
                           nas::utils::EnumToString(item.causeValue));
     }
 
@@ -287,7 +288,7 @@ void NasMm::receiveServiceReject(const nas::ServiceReject &msg)
     m_timers->t3516.stop();
 
     auto cause = msg.mmCause.value;
-    m_logger->err("Service Reject received with cause [%s]", nas::utils::EnumToString(cause));
+    m_logger->err(FMT_STRING("Service Reject received with cause [{}]"), nas::utils::EnumToString(cause));
 
     auto handleAbnormalCase = [this]() {
         m_logger->debug("Handling Service Reject abnormal case");
@@ -19,7 +19,7 @@ namespace nr::ue
 void NasMm::onTimerExpire(UeTimer &timer)
 {
     auto logExpired = [this, &timer]() {
-        m_logger->debug("NAS timer[%d] expired [%d]", timer.getCode(), timer.getExpiryCount());
+        m_logger->debug(FMT_STRING("NAS timer[{}] expired [{}]"), timer.getCode(), timer.getExpiryCount());
     };
 
     switch (timer.getCode())
@@ -60,6 +60,7 @@ void NasMm::onTimerExpire(UeTimer &timer)
         if (m_mmState == EMmState::MM_REGISTERED_INITIATED)
         {
             logExpired();
+            m_base->procClock->stop(EProcedureMetric::REGISTRATION, EProcedureOutcome::TIMEOUT);
 
             auto regType = m_lastRegistrationRequest->registrationType.registrationType;
             if (regType == nas::ERegistrationType::INITIAL_REGISTRATION ||
@@ -122,6 +123,7 @@ void NasMm::onTimerExpire(UeTimer &timer)
         if (m_mmState == EMmState::MM_SERVICE_REQUEST_INITIATED)
         {
             logExpired();
+            m_base->procClock->stop(EProcedureMetric::SERVICE_REQUEST, EProcedureOutcome::TIMEOUT);
 
             switchMmState(EMmSubState::MM_REGISTERED_PS);
 
@@ -155,6 +157,7 @@ void NasMm::onTimerExpire(UeTimer &timer)
             {
                 logExpired();
                 m_logger->debug("De-registration aborted");
+                m_base->procClock->stop(EProcedureMetric::DEREGISTRATION, EProcedureOutcome::TIMEOUT);
 
                 if (m_lastDeregCause == EDeregCause::DISABLE_5G)
                     switchMmState(EMmSubState::MM_NULL_PS);
@@ -41,7 +41,7 @@ void NasMm::receiveDlNasTransport(const nas::DlNasTransport &msg)
 
     if (msg.payloadContainerType.payloadContainerType != nas::EPayloadContainerType::N1_SM_INFORMATION)
     {
-        m_logger->err("Unhandled DL NAS Transport payload container type [%d]",
+        m_logger->err(FMT_STRING("Unhandled DL NAS Transport payload container type [{}]"),
                       (int)msg.payloadContainerType.payloadContainerType);
         return;
     }
@@ -95,7 +95,8 @@ void NasMm::receiveDlNasTransport(const nas::DlNasTransport &msg)
             break;
         }
         default: {
-            m_logger->warn("Unhandled MM Cause [%d] in DL NAS Transport", static_cast<int>(msg.mmCause->value));
+            m_logger->warn(FMT_STRING("Unhandled MM Cause [{}] in DL NAS Transport"),
+                           static_cast<int>(msg.mmCause->value));
             m_sm->receiveForwardingFailure(smMessage, msg.mmCause->value, std::nullopt);
             break;
         }
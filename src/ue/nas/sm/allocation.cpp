@@ -16,7 +16,7 @@ int NasSm::allocatePduSessionId(const SessionConfig &config)
 {
     if (config.type != nas::EPduSessionType::IPV4)
     {
-        m_logger->debug("PDU session type [%s] is not supported", nas::utils::EnumToString(config.type));
+        m_logger->debug(FMT_STRING("PDU session type [{}] is not supported"), nas::utils::EnumToString(config.type));
         return 0;
     }
 
@@ -73,7 +73,7 @@ void NasSm::freeProcedureTransactionId(int pti)
 
 void NasSm::freePduSessionId(int psi)
 {
-    m_pduSessions[psi]->psState = EPsState::INACTIVE;
+    switchPsState(psi, EPsState::INACTIVE);
 }
 
 } // namespace nr::ue
\ No newline at end of file
@@ -13,7 +13,7 @@ namespace nr::ue
 
 NasSm::NasSm(TaskBase *base, NasTimers *timers) : m_base(base), m_timers(timers), m_mm(nullptr)
 {
-    m_logger = base->logBase->makeUniqueLogger(base->config->getLoggerPrefix() + "nas");
+    m_logger = base->logBase->makePrefixedLogger(base->config->getLoggerPrefix(), "nas");
 
     for (int i = 0; i < 16; i++)
         m_pduSessions[i] = new PduSession(i);
@@ -29,4 +29,16 @@ void NasSm::onQuit()
     // TODO
 }
 
+void NasSm::switchPsState(int psi, EPsState state)
+{
+    EPsState oldState = m_pduSessions[psi]->psState;
+    m_pduSessions[psi]->psState = state;
+
+    if (m_base->nodeListener && state != oldState)
+    {
+        m_base->nodeListener->onSwitch(app::NodeType::UE, m_base->config->getNodeName(), app::StateType::PS,
+                                       ToJson(oldState).str(), ToJson(state).str());
+    }
+}
+
 } // namespace nr::ue
\ No newline at end of file
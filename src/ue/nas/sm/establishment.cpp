@@ -56,7 +56,7 @@ void NasSm::sendEstablishmentRequest(const SessionConfig &config)
     /* Control the received config */
     if (config.type != nas::EPduSessionType::IPV4)
     {
-        m_logger->err("PDU session type [%s] is not supported", nas::utils::EnumToString(config.type));
+        m_logger->err(FMT_STRING("PDU session type [{}] is not supported"), nas::utils::EnumToString(config.type));
         return;
     }
     if (m_mm->m_rmState == ERmState::RM_REGISTERED && m_mm->m_registeredForEmergency && !config.isEmergency)
@@ -86,7 +86,7 @@ void NasSm::sendEstablishmentRequest(const SessionConfig &config)
 
     /* Set relevant fields of the PS description */
     auto &ps = m_pduSessions[psi];
-    ps->psState = EPsState::ACTIVE_PENDING;
+    switchPsState(psi, EPsState::ACTIVE_PENDING);
     ps->sessionType = config.type;
     ps->apn = config.apn;
     ps->sNssai = config.sNssai;
@@ -113,7 +113,7 @@ void NasSm::sendEstablishmentRequest(const SessionConfig &config)
     auto req = std::make_unique<nas::PduSessionEstablishmentRequest>();
     req->pti = pti;
     req->pduSessionId = psi;
-    req->integrityProtectionMaximumDataRate = MakeIntegrityMaxRate(m_base->config->integrityMaxRate);
+    req->integrityProtectionMaximumDataRate = MakeIntegrityMaxRate(m_base->config->profile->integrityMaxRate);
     req->pduSessionType = nas::IEPduSessionType{};
     req->pduSessionType->pduSessionType = nas::EPduSessionType::IPV4;
     req->sscMode = nas::IESscMode{};
@@ -130,6 +130,7 @@ void NasSm::sendEstablishmentRequest(const SessionConfig &config)
 
     /* Send SM message */
     sendSmMessage(psi, *pt.message);
+    ps->establishmentStartTime = ProcedureClock::Now();
 }
 
 void NasSm::receiveEstablishmentAccept(const nas::PduSessionEstablishmentAccept &msg)
@@ -151,11 +152,13 @@ void NasSm::receiveEstablishmentAccept(const nas::PduSessionEstablishmentAccept
 
     if (msg.smCause.has_value())
     {
-        m_logger->warn("SM cause received in PduSessionEstablishmentAccept [%s]",
+        m_logger->warn(FMT_STRING("SM cause received in PduSessionEstablishmentAccept [{}]"),
                        nas::utils::EnumToString(msg.smCause->value));
     }
 
-    pduSession->psState = EPsState::ACTIVE;
+    switchPsState(pduSession->psi, EPsState::ACTIVE);
+    m_base->procClock->record(EProcedureMetric::PDU_SESSION_ESTABLISHMENT, EProcedureOutcome::SUCCESS,
+                              pduSession->establishmentStartTime);
     pduSession->authorizedQoSRules = nas::utils::DeepCopyIe(msg.authorizedQoSRules);
     pduSession->sessionAmbr = nas::utils::DeepCopyIe(msg.sessionAmbr);
     pduSession->sessionType = msg.selectedPduSessionType.pduSessionType;
@@ -174,12 +177,13 @@ void NasSm::receiveEstablishmentAccept(const nas::PduSessionEstablishmentAccept
     statusUpdate->pduSession = pduSession;
     m_base->appTask->push(statusUpdate);
 
-    m_logger->info("PDU Session establishment is successful PSI[%d]", pduSession->psi);
+    m_logger->info(FMT_STRING("PDU Session establishment is successful PSI[{}]"), pduSession->psi);
 }
 
 void NasSm::receiveEstablishmentReject(const nas::PduSessionEstablishmentReject &msg)
 {
-    m_logger->err("PDU Session Establishment Reject received [%s]", nas::utils::EnumToString(msg.smCause.value));
+    m_logger->err(FMT_STRING("PDU Session Establishment Reject received [{}]"),
+                  nas::utils::EnumToString(msg.smCause.value));
 
     if (!checkPtiAndPsi(msg))
         return;
@@ -195,7 +199,9 @@ void NasSm::receiveEstablishmentReject(const nas::PduSessionEstablishmentReject
         return;
     }
 
-    pduSession->psState = EPsState::INACTIVE;
+    switchPsState(pduSession->psi, EPsState::INACTIVE);
+    m_base->procClock->record(EProcedureMetric::PDU_SESSION_ESTABLISHMENT, EProcedureOutcome::REJECT,
+                              pduSession->establishmentStartTime);
 
     if (pduSession->isEmergency)
     {
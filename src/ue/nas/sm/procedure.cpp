@@ -19,14 +19,14 @@ bool NasSm::checkPtiAndPsi(const nas::SmMessage &msg)
 {
     if (msg.pti < ProcedureTransaction::MIN_ID || msg.pti > ProcedureTransaction::MAX_ID)
     {
-        m_logger->err("Received PTI [%d] value is invalid", msg.pti);
+        m_logger->err(FMT_STRING("Received PTI [{}] value is invalid"), msg.pti);
         sendSmCause(nas::ESmCause::INVALID_PTI_VALUE, msg.pti, msg.pduSessionId);
         return false;
     }
 
     if (m_procedureTransactions[msg.pti].psi != msg.pduSessionId)
     {
-        m_logger->err("Received PSI value [%d] is invalid, expected was [%d]", msg.pduSessionId,
+        m_logger->err(FMT_STRING("Received PSI value [{}] is invalid, expected was [{}]"), msg.pduSessionId,
                       m_procedureTransactions[msg.pti].psi);
         sendSmCause(nas::ESmCause::INVALID_PTI_VALUE, msg.pti, msg.pduSessionId);
         return false;
@@ -51,7 +51,7 @@ void NasSm::abortProcedureByPti(int pti)
 
     int psi = m_procedureTransactions[pti].psi;
 
-    m_logger->debug("Aborting SM procedure for PTI[%d], PSI[%d]", pti, psi);
+    m_logger->debug(FMT_STRING("Aborting SM procedure for PTI[{}], PSI[{}]"), pti, psi);
 
     if (msgType == nas::EMessageType::PDU_SESSION_ESTABLISHMENT_REQUEST)
     {
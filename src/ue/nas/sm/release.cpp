@@ -29,11 +29,11 @@ void NasSm::sendReleaseRequest(int psi)
     auto &ps = m_pduSessions[psi];
     if (ps->psState != EPsState::ACTIVE)
     {
-        m_logger->warn("PDU session release procedure could not start: PS[%d] is not active already", psi);
+        m_logger->warn(FMT_STRING("PDU session release procedure could not start: PS[{}] is not active already"), psi);
         return;
     }
 
-    m_logger->debug("Sending PDU Session Release Request for PSI[%d]", psi);
+    m_logger->debug(FMT_STRING("Sending PDU Session Release Request for PSI[{}]"), psi);
 
     /* Allocate PTI */
     int pti = allocateProcedureTransactionId();
@@ -69,7 +69,7 @@ void NasSm::receiveReleaseReject(const nas::PduSessionReleaseReject &msg)
 {
     auto cause = msg.smCause.value;
 
-    m_logger->err("PDU Session Release Reject received [%s]", nas::utils::EnumToString(cause));
+    m_logger->err(FMT_STRING("PDU Session Release Reject received [{}]"), nas::utils::EnumToString(cause));
 
     if (!checkPtiAndPsi(msg))
         return;
@@ -87,7 +87,7 @@ void NasSm::receiveReleaseReject(const nas::PduSessionReleaseReject &msg)
             return;
         }
 
-        pduSession->psState = EPsState::ACTIVE;
+        switchPsState(msg.pduSessionId, EPsState::ACTIVE);
     }
     else
     {
@@ -105,7 +105,7 @@ void NasSm::receiveReleaseCommand(const nas::PduSessionReleaseCommand &msg)
     /* Abnormal case handling 6.3.3.6/a */
     if (m_pduSessions[msg.pduSessionId]->psState == EPsState::INACTIVE)
     {
-        m_logger->err("PS[%d] is already in inactive state, ignoring release command", msg.pduSessionId);
+        m_logger->err(FMT_STRING("PS[{}] is already in inactive state, ignoring release command"), msg.pduSessionId);
         sendSmCause(nas::ESmCause::INVALID_PDU_SESSION_IDENTITY, msg.pti, msg.pduSessionId);
         return;
     }
@@ -113,7 +113,8 @@ void NasSm::receiveReleaseCommand(const nas::PduSessionReleaseCommand &msg)
     /* Abnormal case handling 6.4.1.6/c */
     if (m_pduSessions[psi]->psState == EPsState::ACTIVE_PENDING)
     {
-        m_logger->warn("PDU Session Release Command ignored for PSI[%d] due to collision with establishment procedure.",
+        m_logger->warn(FMT_STRING("PDU Session Release Command ignored for PSI[{}] due to collision with "
+                                  "establishment procedure."),
                        psi);
         return;
     }
@@ -136,7 +137,8 @@ void NasSm::receiveReleaseCommand(const nas::PduSessionReleaseCommand &msg)
 
         if (pt.message == nullptr || pt.message->messageType != nas::EMessageType::PDU_SESSION_RELEASE_REQUEST)
         {
-            m_logger->err("PTI mismatch occurred, received PTI[%d] has no PDU session release request", pti);
+            m_logger->err(FMT_STRING("PTI mismatch occurred, received PTI[{}] has no PDU session release request"),
+                          pti);
             sendSmCause(nas::ESmCause::PTI_MISMATCH, msg.pti, msg.pduSessionId);
             return;
         }
@@ -31,7 +31,7 @@ static bool IsEstablished(EPsState state)
 
 void NasSm::localReleaseSession(int psi)
 {
-    m_logger->debug("Performing local release of PDU session[%d]", psi);
+    m_logger->debug(FMT_STRING("Performing local release of PDU session[{}]"), psi);
 
     bool isEstablished = IsEstablished(m_pduSessions[psi]->psState);
 
@@ -61,7 +61,7 @@ bool NasSm::anyEmergencySession()
 
 void NasSm::handleUplinkStatusChange(int psi, bool isPending)
 {
-    m_logger->debug("Uplink data status changed PSI[%d] pending[%s]", psi, isPending ? "true" : "false");
+    m_logger->debug(FMT_STRING("Uplink data status changed PSI[{}] pending[{}]"), psi, isPending ? "true" : "false");
     m_pduSessions[psi]->uplinkPending = isPending;
 
     if (isPending)
@@ -125,7 +125,7 @@ void NasSm::establishRequiredSessions()
         return;
     }
 
-    for (auto &config : m_base->config->defaultSessions)
+    for (auto &config : m_base->config->profile->defaultSessions)
     {
         if (!anySessionMatches(config))
             sendEstablishmentRequest(config);
@@ -47,7 +47,7 @@ void NasSm::onTimerTick()
     }
 }
 
-void NasSm::handleUplinkDataRequest(int psi, OctetString &&data)
+void NasSm::handleUplinkDataRequest(int psi, OctetString &&data, const tun::PacketOffload &offload)
 {
     auto state = m_mm->m_mmSubState;
     if (state != EMmSubState::MM_REGISTERED_INITIATED_PS && state != EMmSubState::MM_REGISTERED_NORMAL_SERVICE &&
@@ -73,6 +73,7 @@ void NasSm::handleUplinkDataRequest(int psi, OctetString &&data)
         auto *m = new NmUeNasToRls(NmUeNasToRls::DATA_PDU_DELIVERY);
         m->psi = psi;
         m->pdu = std::move(data);
+        m->offload = offload;
         m_base->rlsTask->push(m);
     }
     else
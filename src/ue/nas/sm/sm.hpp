@@ -11,6 +11,7 @@
 #include <array>
 #include <bitset>
 #include <lib/nas/nas.hpp>
+#include <ue/metrics.hpp>
 #include <ue/nts.hpp>
 #include <ue/types.hpp>
 #include <utils/nts.hpp>
@@ -42,6 +43,9 @@ class NasSm
     void onStart(NasMm *mm);
     void onQuit();
 
+  private: /* Base */
+    void switchPsState(int psi, EPsState state);
+
   private: /* Resource */
     void localReleaseSession(int psi);
     void localReleaseAllSessions();
@@ -92,7 +96,7 @@ class NasSm
   private: /* Service Access Point */
     void handleNasEvent(const NmUeNasToNas &msg);
     void onTimerTick();
-    void handleUplinkDataRequest(int psi, OctetString &&data);
+    void handleUplinkDataRequest(int psi, OctetString &&data, const tun::PacketOffload &offload);
     void handleDownlinkDataRequest(int psi, OctetString &&data);
 };
 
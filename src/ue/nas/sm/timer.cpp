@@ -63,6 +63,8 @@ void NasSm::onTransactionTimerExpire(int pti)
         else
         {
             m_logger->err("PDU Session Establishment procedure failure, no response from the network after 5 attempts");
+            m_base->procClock->record(EProcedureMetric::PDU_SESSION_ESTABLISHMENT, EProcedureOutcome::TIMEOUT,
+                                      m_pduSessions[pt.psi]->establishmentStartTime);
             abortProcedureByPti(pti);
         }
         break;
@@ -102,14 +102,14 @@ void NasSm::receiveSmMessage(const nas::SmMessage &msg)
         receiveSmStatus((const nas::FiveGSmStatus &)msg);
         break;
     default:
-        m_logger->err("Unhandled NAS SM message received: %d", (int)msg.messageType);
+        m_logger->err(FMT_STRING("Unhandled NAS SM message received: {}"), (int)msg.messageType);
         break;
     }
 }
 
 void NasSm::receiveSmStatus(const nas::FiveGSmStatus &msg)
 {
-    m_logger->err("SM Status received with cause [%s]", nas::utils::EnumToString(msg.smCause.value));
+    m_logger->err(FMT_STRING("SM Status received with cause [{}]"), nas::utils::EnumToString(msg.smCause.value));
 
     if (msg.smCause.value == nas::ESmCause::INVALID_PTI_VALUE)
     {
@@ -126,7 +126,7 @@ void NasSm::receiveSmStatus(const nas::FiveGSmStatus &msg)
 
 void NasSm::sendSmCause(const nas::ESmCause &cause, int pti, int psi)
 {
-    m_logger->warn("Sending SM Cause[%s] for PSI[%d]", nas::utils::EnumToString(cause), psi);
+    m_logger->warn(FMT_STRING("Sending SM Cause[{}] for PSI[{}]"), nas::utils::EnumToString(cause), psi);
 
     nas::FiveGSmStatus smStatus;
     smStatus.smCause.value = cause;
@@ -147,8 +147,8 @@ void NasSm::receiveForwardingFailure(const nas::SmMessage &msg, nas::EMmCause ca
 {
     // TODO: other actions such as congestion control etc
 
-    m_logger->err("SM forwarding failure for message type[%d] with cause[%s]", static_cast<int>(msg.messageType),
-                  nas::utils::EnumToString(cause));
+    m_logger->err(FMT_STRING("SM forwarding failure for message type[{}] with cause[{}]"),
+                  static_cast<int>(msg.messageType), nas::utils::EnumToString(cause));
 
     if (!checkPtiAndPsi(msg))
         return;
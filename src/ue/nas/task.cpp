@@ -19,7 +19,7 @@ namespace nr::ue
 
 NasTask::NasTask(TaskBase *base) : base{base}, timers{}
 {
-    logger = base->logBase->makeUniqueLogger(base->config->getLoggerPrefix() + "nas");
+    logger = base->logBase->makePrefixedLogger(base->config->getLoggerPrefix(), "nas");
 
     mm = new NasMm(base, &timers);
     sm = new NasSm(base, &timers);
@@ -28,7 +28,7 @@ NasTask::NasTask(TaskBase *base) : base{base}, timers{}
 
 void NasTask::onStart()
 {
-    usim->initialize(base->config->supi.has_value());
+    usim->initialize(base->config->getSupi().has_value());
 
     sm->onStart(mm);
     mm->onStart(sm, usim);
@@ -85,7 +85,25 @@ void NasTask::onLoop()
         switch (w->present)
         {
         case NmUeAppToNas::UPLINK_DATA_DELIVERY: {
-            sm->handleUplinkDataRequest(w->psi, std::move(w->data));
+            sm->handleUplinkDataRequest(w->psi, std::move(w->data), w->offload);
+            break;
+        }
+        case NmUeAppToNas::TRIGGER_PROCEDURE: {
+            switch (w->procedure)
+            {
+            case ETriggeredProcedure::DEREGISTRATION:
+                mm->deregistrationRequired(EDeregCause::NORMAL);
+                break;
+            case ETriggeredProcedure::SERVICE_REQUEST:
+                mm->serviceRequestRequiredForSignalling();
+                break;
+            case ETriggeredProcedure::SESSION_ESTABLISHMENT:
+                sm->establishRequiredSessions();
+                break;
+            case ETriggeredProcedure::SESSION_RELEASE:
+                sm->sendReleaseRequestForAll();
+                break;
+            }
             break;
         }
         default:
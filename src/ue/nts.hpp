@@ -16,7 +16,7 @@
 #include <lib/app/cli_base.hpp>
 #include <lib/rls/rls_base.hpp>
 #include <lib/rrc/rrc.hpp>
-#include <utils/light_sync.hpp>
+#include <ue/tun/offload.hpp>
 #include <utils/network.hpp>
 #include <utils/nts.hpp>
 #include <utils/octet_string.hpp>
@@ -51,6 +51,7 @@ struct NmUeTunToApp : NtsMessage
     // DATA_PDU_DELIVERY
     int psi{};
     OctetString data{};
+    tun::PacketOffload offload{};
 
     // TUN_ERROR
     std::string error{};
@@ -96,7 +97,7 @@ struct NmUeNasToRrc : NtsMessage
         LOCAL_RELEASE_CONNECTION,
         UPLINK_NAS_DELIVERY,
         RRC_NOTIFY,
-        PERFORM_UAC,
+        UAC_PERFORMED,
     } present;
 
     // UPLINK_NAS_DELIVERY
@@ -106,8 +107,8 @@ struct NmUeNasToRrc : NtsMessage
     // LOCAL_RELEASE_CONNECTION
     bool treatBarred{};
 
-    // PERFORM_UAC
-    std::shared_ptr<LightSync<UacInput, UacOutput>> uacCtl{};
+    // UAC_PERFORMED
+    int establishmentCause{};
 
     explicit NmUeNasToRrc(PR present) : NtsMessage(NtsMessageType::UE_NAS_TO_RRC), present(present)
     {
@@ -128,7 +129,6 @@ struct NmUeRrcToRls : NtsMessage
 
     // RRC_PDU_DELIVERY
     rrc::RrcChannel channel{};
-    uint32_t pduId{};
     OctetString pdu{};
 
     explicit NmUeRrcToRls(PR present) : NtsMessage(NtsMessageType::UE_RRC_TO_RLS), present(present)
@@ -166,8 +166,13 @@ struct NmUeRlsToRrc : NtsMessage
     OctetString pdu;
 
     // SIGNAL_CHANGED
+    // RECEIVE_HEARTBEAT_ACK
     int dbm{};
 
+    // RECEIVE_HEARTBEAT_ACK
+    uint64_t sti{};
+    uint8_t features{};
+
     // RADIO_LINK_FAILURE
     rls::ERlfCause rlfCause{};
 
@@ -214,11 +219,16 @@ struct NmUeAppToNas : NtsMessage
     enum PR
     {
         UPLINK_DATA_DELIVERY,
+        TRIGGER_PROCEDURE,
     } present;
 
     // UPLINK_DATA_DELIVERY
     int psi{};
     OctetString data;
+    tun::PacketOffload offload{};
+
+    // TRIGGER_PROCEDURE
+    ETriggeredProcedure procedure{};
 
     explicit NmUeAppToNas(PR present) : NtsMessage(NtsMessageType::UE_APP_TO_NAS), present(present)
     {
@@ -235,6 +245,7 @@ struct NmUeNasToRls : NtsMessage
     // DATA_PDU_DELIVERY
     int psi{};
     OctetString pdu;
+    tun::PacketOffload offload{}; // Segmented by the control task at the last moment
 
     explicit NmUeNasToRls(PR present) : NtsMessage(NtsMessageType::UE_NAS_TO_RLS), present(present)
     {
@@ -270,6 +281,9 @@ struct NmUeRlsToRls : NtsMessage
         RADIO_LINK_FAILURE,
         TRANSMISSION_FAILURE,
         ASSIGN_CURRENT_CELL,
+        RESET_STI,
+        RECEIVE_DATAGRAM,
+        RECEIVE_HEARTBEAT_ACK,
     } present;
 
     // RECEIVE_RLS_MESSAGE
@@ -283,8 +297,13 @@ struct NmUeRlsToRls : NtsMessage
     std::unique_ptr<rls::RlsMessage> msg{};
 
     // SIGNAL_CHANGED
+    // RECEIVE_HEARTBEAT_ACK
     int dbm{};
 
+    // RECEIVE_HEARTBEAT_ACK
+    uint64_t sti{};
+    uint8_t features{};
+
     // UPLINK_DATA
     // DOWNLINK_DATA
     int psi{};
@@ -293,14 +312,19 @@ struct NmUeRlsToRls : NtsMessage
     // DOWNLINK_DATA
     // UPLINK_RRC
     // DOWNLINK_RRC
+    // RECEIVE_DATAGRAM
     OctetString data;
 
+    // UPLINK_DATA
+    tun::PacketOffload offload{};
+
     // UPLINK_RRC
     // DOWNLINK_RRC
     rrc::RrcChannel rrcChannel{};
 
-    // UPLINK_RRC
-    uint32_t pduId{};
+    // RECEIVE_DATAGRAM
+    // RECEIVE_HEARTBEAT_ACK
+    InetAddress address{};
 
     // RADIO_LINK_FAILURE
     rls::ERlfCause rlfCause{};
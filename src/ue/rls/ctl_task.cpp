@@ -10,22 +10,27 @@
 
 #include <utils/common.hpp>
 
-static constexpr const size_t MAX_PDU_COUNT = 128;
-static constexpr const int MAX_PDU_TTL = 3000;
+static constexpr const int RETRANSMISSION_TIMEOUT = 500;
+static constexpr const int MAX_RETRANSMISSION = 4;
+static constexpr const size_t RETRANSMISSION_WHEEL_SIZE = 64;
 
-static constexpr const int TIMER_ID_ACK_CONTROL = 1;
+static constexpr const int TIMER_ID_RETRANSMISSION = 1;
 static constexpr const int TIMER_ID_ACK_SEND = 2;
+static constexpr const int TIMER_ID_BATCH_FLUSH = 3;
 
-static constexpr const int TIMER_PERIOD_ACK_CONTROL = 1500;
-static constexpr const int TIMER_PERIOD_ACK_SEND = 2250;
+static constexpr const int TIMER_PERIOD_RETRANSMISSION = 100;
+static constexpr const int TIMER_PERIOD_ACK_SEND = 20;
+static constexpr const int TIMER_PERIOD_BATCH_FLUSH = 1;
 
 namespace nr::ue
 {
 
 RlsControlTask::RlsControlTask(TaskBase *base, RlsSharedContext *shCtx)
-    : m_shCtx{shCtx}, m_servingCell{}, m_mainTask{}, m_udpTask{}, m_pduMap{}, m_pendingAck{}
+    : m_shCtx{shCtx}, m_servingCell{}, m_mainTask{}, m_udpTask{}, m_txWindows{}, m_rxWindows{}, m_pendingAck{},
+      m_retransmissions{RETRANSMISSION_WHEEL_SIZE, TIMER_PERIOD_RETRANSMISSION}, m_batcher{}, m_ackTimerSet{},
+      m_retransmissionTimerSet{}, m_batchTimerSet{}
 {
-    m_logger = base->logBase->makeUniqueLogger(base->config->getLoggerPrefix() + "rls-ctl");
+    m_logger = base->logBase->makePrefixedLogger(base->config->getLoggerPrefix(), "rls-ctl");
 }
 
 void RlsControlTask::initialize(NtsTask *mainTask, RlsUdpTask *udpTask)
@@ -36,8 +41,6 @@ void RlsControlTask::initialize(NtsTask *mainTask, RlsUdpTask *udpTask)
 
 void RlsControlTask::onStart()
 {
-    setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
-    setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
 }
 
 void RlsControlTask::onLoop()
@@ -59,14 +62,17 @@ void RlsControlTask::onLoop()
             handleRlsMessage(w->cellId, *w->msg);
             break;
         case NmUeRlsToRls::UPLINK_DATA:
-            handleUplinkDataDelivery(w->psi, std::move(w->data));
+            handleUplinkDataDelivery(w->psi, std::move(w->data), w->offload);
             break;
         case NmUeRlsToRls::UPLINK_RRC:
-            handleUplinkRrcDelivery(w->cellId, w->pduId, w->rrcChannel, std::move(w->data));
+            handleUplinkRrcDelivery(w->cellId, w->rrcChannel, std::move(w->data));
             break;
         case NmUeRlsToRls::ASSIGN_CURRENT_CELL:
             m_servingCell = w->cellId;
             break;
+        case NmUeRlsToRls::RESET_STI:
+            handleResetSti();
+            break;
         default:
             m_logger->unhandledNts(msg);
             break;
@@ -75,16 +81,21 @@ void RlsControlTask::onLoop()
     }
     case NtsMessageType::TIMER_EXPIRED: {
         auto *w = dynamic_cast<NmTimerExpired *>(msg);
-        if (w->timerId == TIMER_ID_ACK_CONTROL)
+        if (w->timerId == TIMER_ID_RETRANSMISSION)
         {
-            setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
-            onAckControlTimerExpired();
+            m_retransmissionTimerSet = false;
+            onRetransmissionTimerExpired();
         }
         else if (w->timerId == TIMER_ID_ACK_SEND)
         {
-            setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
+            m_ackTimerSet = false;
             onAckSendTimerExpired();
         }
+        else if (w->timerId == TIMER_ID_BATCH_FLUSH)
+        {
+            m_batchTimerSet = false;
+            onBatchTimerExpired();
+        }
         break;
     }
     default:
@@ -104,126 +115,190 @@ void RlsControlTask::handleRlsMessage(int cellId, rls::RlsMessage &msg)
     if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION_ACK)
     {
         auto &m = (rls::RlsPduTransmissionAck &)msg;
-        for (auto pduId : m.pduIds)
-            m_pduMap.erase(pduId);
+        auto it = m_txWindows.find(cellId);
+        if (it != m_txWindows.end())
+            it->second.acknowledge(m.cumulativeId, m.pduIds);
     }
     else if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION)
     {
         auto &m = (rls::RlsPduTransmission &)msg;
-        if (m.pduId != 0)
-            m_pendingAck[cellId].push_back(m.pduId);
+        handlePduTransmission(cellId, m.pduType, m.pduId, m.payload, std::move(m.pdu));
+    }
+    else if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION_BATCH)
+    {
+        auto &m = (rls::RlsPduTransmissionBatch &)msg;
+        for (auto &item : m.items)
+            handlePduTransmission(cellId, item.pduType, item.pduId, item.payload, std::move(item.pdu));
+    }
+    else
+    {
+        m_logger->err("Unhandled RLS message type");
+    }
+}
 
-        if (m.pduType == rls::EPduType::DATA)
-        {
-            if (cellId != m_servingCell)
-            {
-                // NOTE: Data packet may be received from a cell other than serving cell
-                //  Ignore the packet if this is the case. Other cell can only send RRC, but not DATA
-                return;
-            }
-
-            auto *w = new NmUeRlsToRls(NmUeRlsToRls::DOWNLINK_DATA);
-            w->psi = static_cast<int>(m.payload);
-            w->data = std::move(m.pdu);
-            m_mainTask->push(w);
-        }
-        else if (m.pduType == rls::EPduType::RRC)
+void RlsControlTask::handlePduTransmission(int cellId, rls::EPduType pduType, uint32_t pduId, uint32_t payload,
+                                           OctetString &&pdu)
+{
+    if (pduId != 0)
+    {
+        bool isNew = m_rxWindows[cellId].receive(pduId);
+
+        // Duplicates are acknowledged again, since the previous ACK may be lost
+        m_pendingAck.insert(cellId);
+        if (!m_ackTimerSet)
         {
-            auto *w = new NmUeRlsToRls(NmUeRlsToRls::DOWNLINK_RRC);
-            w->cellId = cellId;
-            w->rrcChannel = static_cast<rrc::RrcChannel>(m.payload);
-            w->data = std::move(m.pdu);
-            m_mainTask->push(w);
+            m_ackTimerSet = true;
+            setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
         }
-        else
+
+        if (!isNew)
+            return;
+    }
+
+    if (pduType == rls::EPduType::DATA)
+    {
+        if (cellId != m_servingCell)
         {
-            m_logger->err("Unhandled RLS PDU type");
+            // NOTE: Data packet may be received from a cell other than serving cell
+            //  Ignore the packet if this is the case. Other cell can only send RRC, but not DATA
+            return;
         }
+
+        auto *w = new NmUeRlsToRls(NmUeRlsToRls::DOWNLINK_DATA);
+        w->psi = static_cast<int>(payload);
+        w->data = std::move(pdu);
+        m_mainTask->push(w);
+    }
+    else if (pduType == rls::EPduType::RRC)
+    {
+        auto *w = new NmUeRlsToRls(NmUeRlsToRls::DOWNLINK_RRC);
+        w->cellId = cellId;
+        w->rrcChannel = static_cast<rrc::RrcChannel>(payload);
+        w->data = std::move(pdu);
+        m_mainTask->push(w);
     }
     else
     {
-        m_logger->err("Unhandled RLS message type");
+        m_logger->err("Unhandled RLS PDU type");
     }
 }
 
 void RlsControlTask::handleSignalChange(int cellId, int dbm)
 {
+    if (dbm == INT32_MIN)
+    {
+        // Signal is lost, the cell will have a new ID if it is detected again
+        m_txWindows.erase(cellId);
+        m_retransmissions.cancel(cellId);
+        m_rxWindows.erase(cellId);
+        m_pendingAck.erase(cellId);
+    }
+
     auto *w = new NmUeRlsToRls(NmUeRlsToRls::SIGNAL_CHANGED);
     w->cellId = cellId;
     w->dbm = dbm;
     m_mainTask->push(w);
 }
 
-void RlsControlTask::handleUplinkRrcDelivery(int cellId, uint32_t pduId, rrc::RrcChannel channel, OctetString &&data)
+void RlsControlTask::handleUplinkRrcDelivery(int cellId, rrc::RrcChannel channel, OctetString &&data)
 {
-    if (pduId != 0)
+    auto &window = m_txWindows[cellId];
+    if (window.isFull())
     {
-        if (m_pduMap.count(pduId))
-        {
-            m_pduMap.clear();
+        window.reset();
+        m_retransmissions.cancel(cellId);
 
-            auto *w = new NmUeRlsToRls(NmUeRlsToRls::RADIO_LINK_FAILURE);
-            w->rlfCause = rls::ERlfCause::PDU_ID_EXISTS;
-            m_mainTask->push(w);
-            return;
-        }
-
-        if (m_pduMap.size() > MAX_PDU_COUNT)
-        {
-            m_pduMap.clear();
+        auto *w = new NmUeRlsToRls(NmUeRlsToRls::RADIO_LINK_FAILURE);
+        w->rlfCause = rls::ERlfCause::PDU_ID_FULL;
+        m_mainTask->push(w);
+        return;
+    }
 
-            auto *w = new NmUeRlsToRls(NmUeRlsToRls::RADIO_LINK_FAILURE);
-            w->rlfCause = rls::ERlfCause::PDU_ID_FULL;
-            m_mainTask->push(w);
-            return;
-        }
+    auto &pdu = window.push(cellId, channel, std::move(data));
+    transmitRrc(pdu);
 
-        m_pduMap[pduId].endPointId = cellId;
-        m_pduMap[pduId].id = pduId;
-        m_pduMap[pduId].pdu = data.copy();
-        m_pduMap[pduId].rrcChannel = channel;
-        m_pduMap[pduId].sentTime = utils::CurrentTimeMillis();
+    m_retransmissions.schedule(pdu.sentTime, RETRANSMISSION_TIMEOUT, {cellId, pdu.id});
+    if (!m_retransmissionTimerSet)
+    {
+        m_retransmissionTimerSet = true;
+        setTimer(TIMER_ID_RETRANSMISSION, TIMER_PERIOD_RETRANSMISSION);
     }
+}
 
+void RlsControlTask::transmitRrc(rls::PduInfo &pdu)
+{
     rls::RlsPduTransmission msg{m_shCtx->sti};
     msg.pduType = rls::EPduType::RRC;
-    msg.pdu = std::move(data);
-    msg.payload = static_cast<uint32_t>(channel);
-    msg.pduId = pduId;
+    msg.pdu = std::move(pdu.pdu);
+    msg.payload = static_cast<uint32_t>(pdu.rrcChannel);
+    msg.pduId = pdu.id;
+
+    m_udpTask->send(pdu.endPointId, msg);
 
-    m_udpTask->send(cellId, msg);
+    // Keep the PDU for retransmission without copying it
+    pdu.pdu = std::move(msg.pdu);
 }
 
-void RlsControlTask::handleUplinkDataDelivery(int psi, OctetString &&data)
+void RlsControlTask::handleResetSti()
 {
-    rls::RlsPduTransmission msg{m_shCtx->sti};
-    msg.pduType = rls::EPduType::DATA;
-    msg.pdu = std::move(data);
-    msg.payload = static_cast<uint32_t>(psi);
-    msg.pduId = 0;
+    m_shCtx->sti = utils::Random64();
 
-    m_udpTask->send(m_servingCell, msg);
+    // Cells will see us as a new UE, so the sequence windows must start over
+    for (auto &item : m_txWindows)
+        m_retransmissions.cancel(item.first);
+    m_txWindows.clear();
+    m_rxWindows.clear();
+    m_pendingAck.clear();
 }
 
-void RlsControlTask::onAckControlTimerExpired()
+void RlsControlTask::handleUplinkDataDelivery(int psi, OctetString &&data, const tun::PacketOffload &offload)
+{
+    if (offload.isEmpty())
+    {
+        sendBatched(m_servingCell, static_cast<uint32_t>(psi), std::move(data));
+        return;
+    }
+
+    // The packet went through the UE as a whole, it is cut into segments of the MTU only here
+    std::vector<OctetString> segments{};
+    if (!tun::SegmentPacket(std::move(data), offload, segments))
+    {
+        m_logger->warn("Uplink packet with invalid offloads is dropped");
+        return;
+    }
+
+    for (auto &segment : segments)
+        sendBatched(m_servingCell, static_cast<uint32_t>(psi), std::move(segment));
+}
+
+void RlsControlTask::onRetransmissionTimerExpired()
 {
     int64_t current = utils::CurrentTimeMillis();
 
-    std::vector<uint32_t> transmissionFailureIds;
     std::vector<rls::PduInfo> transmissionFailures;
 
-    for (auto &pdu : m_pduMap)
+    for (auto &entry : m_retransmissions.advance(current))
     {
-        auto delta = current - pdu.second.sentTime;
-        if (delta > MAX_PDU_TTL)
+        auto it = m_txWindows.find(entry.endPointId);
+        if (it == m_txWindows.end())
+            continue;
+
+        auto *pdu = it->second.find(entry.id);
+        if (pdu == nullptr)
+            continue; // Already acknowledged
+
+        if (pdu->retransmissions >= MAX_RETRANSMISSION)
         {
-            transmissionFailureIds.push_back(pdu.first);
-            transmissionFailures.push_back(std::move(pdu.second));
+            auto released = it->second.release(entry.id);
+            if (released.has_value())
+                transmissionFailures.push_back(std::move(*released));
+            continue;
         }
-    }
 
-    for (auto id : transmissionFailureIds)
-        m_pduMap.erase(id);
+        pdu->retransmissions++;
+        transmitRrc(*pdu);
+        m_retransmissions.schedule(current, RETRANSMISSION_TIMEOUT, entry);
+    }
 
     if (!transmissionFailures.empty())
     {
@@ -231,23 +306,75 @@ void RlsControlTask::onAckControlTimerExpired()
         w->pduList = std::move(transmissionFailures);
         m_mainTask->push(w);
     }
+
+    if (!m_retransmissions.isEmpty())
+    {
+        m_retransmissionTimerSet = true;
+        setTimer(TIMER_ID_RETRANSMISSION, TIMER_PERIOD_RETRANSMISSION);
+    }
 }
 
 void RlsControlTask::onAckSendTimerExpired()
 {
-    auto copy = m_pendingAck;
+    for (int cellId : m_pendingAck)
+    {
+        auto &window = m_rxWindows[cellId];
+
+        rls::RlsPduTransmissionAck msg{m_shCtx->sti};
+        msg.cumulativeId = window.cumulativeId();
+        msg.pduIds = window.selectiveIds();
+
+        m_udpTask->send(cellId, msg);
+    }
+
     m_pendingAck.clear();
+}
 
-    for (auto &item : copy)
+void RlsControlTask::sendBatched(int endPointId, uint32_t payload, OctetString &&data)
+{
+    if (!m_batcher.fits(endPointId, data))
     {
-        if (!item.second.empty())
-            continue;
+        flushBatch(endPointId);
 
-        rls::RlsPduTransmissionAck msg{m_shCtx->sti};
-        msg.pduIds = std::move(item.second);
+        if (!m_batcher.fits(endPointId, data))
+        {
+            // Too large to be batched, send it directly
+            rls::RlsPduTransmission msg{m_shCtx->sti};
+            msg.pduType = rls::EPduType::DATA;
+            msg.pdu = std::move(data);
+            msg.payload = payload;
+            msg.pduId = 0;
+
+            m_udpTask->send(endPointId, msg);
+            return;
+        }
+    }
 
-        m_udpTask->send(item.first, msg);
+    rls::RlsPduItem item{};
+    item.pduType = rls::EPduType::DATA;
+    item.pduId = 0;
+    item.payload = payload;
+    item.pdu = std::move(data);
+    m_batcher.add(endPointId, std::move(item));
+
+    if (!m_batchTimerSet)
+    {
+        m_batchTimerSet = true;
+        setTimer(TIMER_ID_BATCH_FLUSH, TIMER_PERIOD_BATCH_FLUSH);
     }
 }
 
+void RlsControlTask::flushBatch(int endPointId)
+{
+    auto msg = m_batcher.take(endPointId, m_shCtx->sti);
+    if (msg != nullptr)
+        m_udpTask->send(endPointId, *msg);
+}
+
+void RlsControlTask::onBatchTimerExpired()
+{
+    for (int endPointId : m_batcher.endPoints())
+        flushBatch(endPointId);
+}
+
 } // namespace nr::ue
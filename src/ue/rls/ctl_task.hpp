@@ -11,8 +11,11 @@
 #include "udp_task.hpp"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <lib/rls/rls_batch.hpp>
+#include <lib/rls/rls_window.hpp>
 #include <lib/rrc/rrc.hpp>
 #include <ue/nts.hpp>
 #include <ue/types.hpp>
@@ -29,8 +32,14 @@ class RlsControlTask : public NtsTask
     int m_servingCell;
     NtsTask *m_mainTask;
     RlsUdpTask *m_udpTask;
-    std::unordered_map<uint32_t, rls::PduInfo> m_pduMap;
-    std::unordered_map<int, std::vector<uint32_t>> m_pendingAck;
+    std::unordered_map<int, rls::TxWindow> m_txWindows;
+    std::unordered_map<int, rls::RxWindow> m_rxWindows;
+    std::unordered_set<int> m_pendingAck;
+    rls::RetransmissionWheel m_retransmissions;
+    rls::PduBatcher m_batcher;
+    bool m_ackTimerSet;
+    bool m_retransmissionTimerSet;
+    bool m_batchTimerSet;
 
   public:
     explicit RlsControlTask(TaskBase *base, RlsSharedContext *shCtx);
@@ -46,11 +55,17 @@ class RlsControlTask : public NtsTask
 
   private:
     void handleRlsMessage(int cellId, rls::RlsMessage &msg);
+    void handlePduTransmission(int cellId, rls::EPduType pduType, uint32_t pduId, uint32_t payload, OctetString &&pdu);
     void handleSignalChange(int cellId, int dbm);
-    void handleUplinkRrcDelivery(int cellId, uint32_t pduId, rrc::RrcChannel channel, OctetString &&data);
-    void handleUplinkDataDelivery(int psi, OctetString &&data);
-    void onAckControlTimerExpired();
+    void handleUplinkRrcDelivery(int cellId, rrc::RrcChannel channel, OctetString &&data);
+    void handleResetSti();
+    void handleUplinkDataDelivery(int psi, OctetString &&data, const tun::PacketOffload &offload);
+    void onRetransmissionTimerExpired();
     void onAckSendTimerExpired();
+    void transmitRrc(rls::PduInfo &pdu);
+    void onBatchTimerExpired();
+    void sendBatched(int endPointId, uint32_t payload, OctetString &&data);
+    void flushBatch(int endPointId);
 };
 
 } // namespace nr::ue
\ No newline at end of file
@@ -0,0 +1,234 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "endpoint.hpp"
+
+#include <cstring>
+
+#include <netinet/in.h>
+
+#include <ue/nts.hpp>
+#include <utils/common.hpp>
+#include <utils/constants.hpp>
+
+static constexpr const int BUFFER_SIZE = 16384;
+static constexpr const int LOOP_PERIOD = 1000;
+static constexpr const int RECEIVE_TIMEOUT = 200;
+
+// Keeps the HEARTBEAT_BATCH messages well below the receive buffer size of the gNB
+static constexpr const size_t MAX_HEARTBEAT_BATCH = 512;
+
+static bool IsSameAddress(const InetAddress &a, const InetAddress &b)
+{
+    auto *x = a.getSockAddr();
+    auto *y = b.getSockAddr();
+    if (x->sa_family != y->sa_family)
+        return false;
+
+    if (x->sa_family == AF_INET)
+    {
+        auto *x4 = reinterpret_cast<const sockaddr_in *>(x);
+        auto *y4 = reinterpret_cast<const sockaddr_in *>(y);
+        return x4->sin_port == y4->sin_port && x4->sin_addr.s_addr == y4->sin_addr.s_addr;
+    }
+    if (x->sa_family == AF_INET6)
+    {
+        auto *x6 = reinterpret_cast<const sockaddr_in6 *>(x);
+        auto *y6 = reinterpret_cast<const sockaddr_in6 *>(y);
+        return x6->sin6_port == y6->sin6_port && std::memcmp(&x6->sin6_addr, &y6->sin6_addr, sizeof(in6_addr)) == 0;
+    }
+    return a.getSockLen() == b.getSockLen() && std::memcmp(x, y, a.getSockLen()) == 0;
+}
+
+namespace nr::ue
+{
+
+RlsEndpointTask::RlsEndpointTask(LogBase *logBase, rls::ETransportType transportType,
+                                 const std::vector<std::string> &searchSpace)
+    : m_receivers{}, m_searchSpace{}, m_lastHeartbeat{}
+{
+    m_logger = logBase->makeUniqueLogger("rls-endpoint");
+    // The UEs of the host are captured together, as the datagrams they share
+    m_transport = rls::WithCapture(rls::CreateClientTransport(transportType), PacketCapture::AddInterface("ue-host"));
+
+    for (auto &ip : searchSpace)
+        m_searchSpace.push_back({InetAddress{ip, cons::PortalPort}, false});
+}
+
+void RlsEndpointTask::onStart()
+{
+}
+
+void RlsEndpointTask::onLoop()
+{
+    auto current = utils::CurrentTimeMillis();
+    if (current - m_lastHeartbeat > LOOP_PERIOD)
+    {
+        m_lastHeartbeat = current;
+        heartbeatCycle();
+    }
+
+    uint8_t buffer[BUFFER_SIZE];
+    InetAddress peerAddress;
+
+    int size = m_transport->receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
+    if (size > 0)
+        receiveDatagram(peerAddress, buffer, static_cast<size_t>(size));
+}
+
+void RlsEndpointTask::onQuit()
+{
+    m_transport.reset();
+}
+
+void RlsEndpointTask::receiveDatagram(const InetAddress &address, const uint8_t *data, size_t size)
+{
+    uint64_t destination = 0;
+    bool enveloped = rls::DecodeEnvelope(data, size, destination);
+
+    if (!enveloped && size > 4 && data[4] == static_cast<uint8_t>(rls::EMessageType::HEARTBEAT_ACK_BATCH))
+    {
+        rls::RlsMessageView view{};
+        if (!rls::DecodeRlsMessageView(data, size, view))
+            m_logger->err("Unable to decode RLS message");
+        else
+            receiveHeartbeatAckBatch(address, view);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (enveloped && size > 4 && data[4] == static_cast<uint8_t>(rls::EMessageType::HEARTBEAT_ACK))
+    {
+        // Heartbeats to this gNB are aggregated from now on if it supports it
+        rls::RlsMessageView view{};
+        if (rls::DecodeRlsMessageView(data, size, view) && (view.features & rls::FEATURE_HEARTBEAT_BATCH))
+        {
+            for (auto &target : m_searchSpace)
+                if (IsSameAddress(target.address, address))
+                    target.supportsBatch = true;
+        }
+    }
+
+    NtsTask *receiver = nullptr;
+    if (enveloped)
+    {
+        auto it = m_receivers.find(destination);
+        if (it != m_receivers.end())
+            receiver = it->second.task;
+    }
+    else if (m_receivers.size() == 1)
+    {
+        // The gNB does not support envelopes, which is only unambiguous with a single UE
+        receiver = m_receivers.begin()->second.task;
+    }
+
+    if (receiver == nullptr)
+        return;
+
+    // Pushed while holding the lock, so that the receiver cannot be deleted in between
+    auto *w = new NmUeRlsToRls(NmUeRlsToRls::RECEIVE_DATAGRAM);
+    w->address = address;
+    w->data = OctetString::FromArray(data, size);
+    receiver->push(w);
+}
+
+void RlsEndpointTask::receiveHeartbeatAckBatch(const InetAddress &address, const rls::RlsMessageView &view)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (size_t i = 0; i < view.itemCount; i++)
+    {
+        auto item = rls::GetHeartBeatAckItem(view, i);
+
+        auto it = m_receivers.find(item.sti);
+        if (it == m_receivers.end())
+            continue;
+
+        auto *w = new NmUeRlsToRls(NmUeRlsToRls::RECEIVE_HEARTBEAT_ACK);
+        w->address = address;
+        w->sti = view.sti;
+        w->dbm = item.dbm;
+        w->features = view.features;
+        it->second.task->push(w);
+    }
+}
+
+void RlsEndpointTask::heartbeatCycle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (auto &target : m_searchSpace)
+        sendHeartbeats(target);
+}
+
+void RlsEndpointTask::sendHeartbeats(const SearchTarget &target)
+{
+    if (!target.supportsBatch)
+    {
+        // Until the gNB is known to support aggregated heartbeats, every UE sends its own
+        for (auto &receiver : m_receivers)
+        {
+            rls::RlsHeartBeat msg{receiver.first};
+            msg.simPos = receiver.second.simPos;
+            msg.features = rls::SUPPORTED_FEATURES;
+            sendMessage(target.address, msg);
+        }
+        return;
+    }
+
+    rls::RlsHeartBeatBatch msg{0};
+    msg.features = rls::SUPPORTED_FEATURES;
+    msg.items.reserve(std::min(m_receivers.size(), MAX_HEARTBEAT_BATCH));
+
+    for (auto &receiver : m_receivers)
+    {
+        msg.items.push_back({receiver.first, receiver.second.simPos});
+        if (msg.items.size() == MAX_HEARTBEAT_BATCH)
+        {
+            sendMessage(target.address, msg);
+            msg.items.clear();
+        }
+    }
+
+    if (!msg.items.empty())
+        sendMessage(target.address, msg);
+}
+
+void RlsEndpointTask::sendMessage(const InetAddress &address, const rls::RlsMessage &msg)
+{
+    OctetString stream;
+    rls::EncodeRlsMessage(msg, stream);
+
+    m_transport->send(address, stream.data(), static_cast<size_t>(stream.length()));
+}
+
+void RlsEndpointTask::registerReceiver(uint64_t sti, NtsTask *receiver, const Vector3 &simPos)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_receivers[sti] = {receiver, simPos};
+}
+
+void RlsEndpointTask::unregisterReceiver(uint64_t sti)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_receivers.erase(sti);
+}
+
+void RlsEndpointTask::send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    m_transport->send(address, buffer, bufferSize);
+}
+
+void RlsEndpointTask::send(const InetAddress &address, const uint8_t *header, size_t headerSize,
+                           const uint8_t *payload, size_t payloadSize)
+{
+    m_transport->send(address, header, headerSize, payload, payloadSize);
+}
+
+} // namespace nr::ue
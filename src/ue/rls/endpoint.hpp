@@ -0,0 +1,78 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/rls/rls_pdu.hpp>
+#include <lib/rls/rls_transport.hpp>
+#include <utils/logger.hpp>
+#include <utils/nts.hpp>
+
+namespace nr::ue
+{
+
+/* RLS socket shared by all UEs of the process in the multi-UE host mode. Received messages are dispatched to the UE
+ * named in the envelope, and UEs send their messages directly from their own threads. Heartbeats of all the UEs are
+ * sent from here, aggregated into HEARTBEAT_BATCH messages for the gNBs supporting them. */
+class RlsEndpointTask : public NtsTask
+{
+  private:
+    struct Receiver
+    {
+        NtsTask *task{};
+        Vector3 simPos{};
+    };
+
+    struct SearchTarget
+    {
+        InetAddress address{};
+        bool supportsBatch{};
+    };
+
+  private:
+    std::unique_ptr<Logger> m_logger;
+    std::unique_ptr<rls::RlsTransport> m_transport;
+    std::mutex m_mutex;
+    std::unordered_map<uint64_t, Receiver> m_receivers;
+    std::vector<SearchTarget> m_searchSpace;
+    int64_t m_lastHeartbeat;
+
+  public:
+    RlsEndpointTask(LogBase *logBase, rls::ETransportType transportType, const std::vector<std::string> &searchSpace);
+    ~RlsEndpointTask() override = default;
+
+  protected:
+    void onStart() override;
+    void onLoop() override;
+    void onQuit() override;
+
+  private:
+    void receiveDatagram(const InetAddress &address, const uint8_t *data, size_t size);
+    void receiveHeartbeatAckBatch(const InetAddress &address, const rls::RlsMessageView &view);
+    void heartbeatCycle();
+    void sendHeartbeats(const SearchTarget &target);
+    void sendMessage(const InetAddress &address, const rls::RlsMessage &msg);
+
+  public:
+    // Registers the UE or updates its position, which is reported in the heartbeats
+    void registerReceiver(uint64_t sti, NtsTask *receiver, const Vector3 &simPos);
+    void unregisterReceiver(uint64_t sti);
+
+    void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize);
+    void send(const InetAddress &address, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+              size_t payloadSize);
+};
+
+} // namespace nr::ue
@@ -13,22 +13,38 @@
 #include <ue/rrc/task.hpp>
 #include <utils/common.hpp>
 #include <utils/constants.hpp>
+#include <utils/nts_trace.hpp>
 
 namespace nr::ue
 {
 
 UeRlsTask::UeRlsTask(TaskBase *base) : m_base{base}
 {
-    m_logger = m_base->logBase->makeUniqueLogger(m_base->config->getLoggerPrefix() + "rls");
+    m_logger = m_base->logBase->makePrefixedLogger(m_base->config->getLoggerPrefix(), "rls");
 
     m_shCtx = new RlsSharedContext();
     m_shCtx->sti = utils::Random64();
 
-    m_udpTask = new RlsUdpTask(base, m_shCtx, base->config->gnbSearchList);
+    m_udpTask = new RlsUdpTask(base, m_shCtx, base->config->profile->gnbSearchList);
     m_ctlTask = new RlsControlTask(base, m_shCtx);
 
+    if (NtsTrace::IsEnabled())
+    {
+        m_udpTask->setTraceName(base->config->getNodeName() + "/rls-udp");
+        m_ctlTask->setTraceName(base->config->getNodeName() + "/rls-ctl");
+    }
+
+    m_udpTask->setMemoryTag(MemoryTagOf(base, EMemorySubsystem::RLS));
+    m_ctlTask->setMemoryTag(MemoryTagOf(base, EMemorySubsystem::RLS));
+
     m_udpTask->initialize(m_ctlTask);
     m_ctlTask->initialize(this, m_udpTask);
+
+    if (base->host)
+    {
+        m_udpTask->setExecutor(base->host->executor);
+        m_ctlTask->setExecutor(base->host->executor);
+    }
 }
 
 void UeRlsTask::onStart()
@@ -78,7 +94,7 @@ void UeRlsTask::onLoop()
             break;
         }
         case NmUeRlsToRls::TRANSMISSION_FAILURE: {
-            m_logger->debug("transmission failure [%d]", w->pduList.size());
+            m_logger->debug(FMT_STRING("transmission failure [{}]"), w->pduList.size());
             break;
         }
         default: {
@@ -102,13 +118,12 @@ void UeRlsTask::onLoop()
             auto *m = new NmUeRlsToRls(NmUeRlsToRls::UPLINK_RRC);
             m->cellId = w->cellId;
             m->rrcChannel = w->channel;
-            m->pduId = w->pduId;
             m->data = std::move(w->pdu);
             m_ctlTask->push(m);
             break;
         }
         case NmUeRrcToRls::RESET_STI: {
-            m_shCtx->sti = utils::Random64();
+            m_ctlTask->push(new NmUeRlsToRls(NmUeRlsToRls::RESET_STI));
             break;
         }
         }
@@ -122,6 +137,7 @@ void UeRlsTask::onLoop()
             auto *m = new NmUeRlsToRls(NmUeRlsToRls::UPLINK_DATA);
             m->psi = w->psi;
             m->data = std::move(w->pdu);
+            m->offload = w->offload;
             m_ctlTask->push(m);
             break;
         }
@@ -21,105 +21,226 @@ static constexpr const int LOOP_PERIOD = 1000;
 static constexpr const int RECEIVE_TIMEOUT = 200;
 static constexpr const int HEARTBEAT_THRESHOLD = 2000; // (LOOP_PERIOD + RECEIVE_TIMEOUT)'dan büyük olmalı
 
+static constexpr const int TIMER_ID_HEARTBEAT = 1;
+
 namespace nr::ue
 {
 
 RlsUdpTask::RlsUdpTask(TaskBase *base, RlsSharedContext *shCtx, const std::vector<std::string> &searchSpace)
-    : m_server{}, m_ctlTask{}, m_shCtx{shCtx}, m_searchSpace{}, m_cells{}, m_cellIdToSti{}, m_lastLoop{},
-      m_cellIdCounter{}
+    : m_transport{}, m_endpoint{}, m_ctlTask{}, m_shCtx{shCtx}, m_searchSpace{}, m_cells{}, m_cellIdToSti{},
+      m_lastLoop{}, m_cellIdCounter{}, m_startTime{utils::CurrentTimeMillis()}, m_registeredSti{}
 {
-    m_logger = base->logBase->makeUniqueLogger(base->config->getLoggerPrefix() + "rls-udp");
+    m_logger = base->logBase->makePrefixedLogger(base->config->getLoggerPrefix(), "rls-udp");
 
-    m_server = new udp::UdpServer();
+    // UEs of a host share the endpoint's socket instead of having one each
+    if (base->host)
+        m_endpoint = base->host->rlsEndpoint;
+    else
+        m_transport = rls::WithCapture(rls::CreateClientTransport(base->config->profile->rlsTransport),
+                                       PacketCapture::AddInterface(base->config->getNodeName()));
 
     for (auto &ip : searchSpace)
         m_searchSpace.emplace_back(ip, cons::PortalPort);
 
-    m_simPos = Vector3{};
+    m_mobility = radio::CreateMobilityModel(base->config->getMobility());
+    m_simPos = m_mobility->positionAt(0);
 }
 
 void RlsUdpTask::onStart()
 {
+    if (m_endpoint)
+    {
+        heartbeatCycle(utils::CurrentTimeMillis(), m_simPos);
+        setTimer(TIMER_ID_HEARTBEAT, LOOP_PERIOD);
+    }
 }
 
 void RlsUdpTask::onLoop()
 {
+    if (m_endpoint)
+    {
+        // Driven by the messages of the endpoint and the heartbeat timer instead of polling a socket
+        NtsMessage *msg = take();
+        if (!msg)
+            return;
+
+        auto *w = msg->msgType == NtsMessageType::UE_RLS_TO_RLS ? dynamic_cast<NmUeRlsToRls *>(msg) : nullptr;
+        if (w && w->present == NmUeRlsToRls::RECEIVE_DATAGRAM)
+        {
+            receiveDatagram(w->address, w->data.data(), static_cast<size_t>(w->data.length()));
+        }
+        else if (w && w->present == NmUeRlsToRls::RECEIVE_HEARTBEAT_ACK)
+        {
+            // An item of an aggregated heartbeat ACK, handled just like a HEARTBEAT_ACK message
+            rls::RlsMessageView view{};
+            view.msgType = rls::EMessageType::HEARTBEAT_ACK;
+            view.sti = w->sti;
+            view.dbm = w->dbm;
+            view.features = w->features;
+            receiveRlsPdu(w->address, view, nullptr, 0);
+        }
+        else if (msg->msgType == NtsMessageType::TIMER_EXPIRED)
+        {
+            auto current = utils::CurrentTimeMillis();
+            m_simPos = m_mobility->positionAt(current - m_startTime);
+            heartbeatCycle(current, m_simPos);
+            setTimer(TIMER_ID_HEARTBEAT, LOOP_PERIOD);
+        }
+        else
+        {
+            m_logger->unhandledNts(msg);
+        }
+
+        delete msg;
+        return;
+    }
+
     auto current = utils::CurrentTimeMillis();
     if (current - m_lastLoop > LOOP_PERIOD)
     {
         m_lastLoop = current;
+        m_simPos = m_mobility->positionAt(current - m_startTime);
         heartbeatCycle(current, m_simPos);
     }
 
     uint8_t buffer[BUFFER_SIZE];
     InetAddress peerAddress;
 
-    int size = m_server->Receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
+    int size = m_transport->receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
     if (size > 0)
-    {
-        auto rlsMsg = rls::DecodeRlsMessage(OctetView{buffer, static_cast<size_t>(size)});
-        if (rlsMsg == nullptr)
-            m_logger->err("Unable to decode RLS message");
-        else
-            receiveRlsPdu(peerAddress, std::move(rlsMsg));
-    }
+        receiveDatagram(peerAddress, buffer, static_cast<size_t>(size));
 }
 
 void RlsUdpTask::onQuit()
 {
-    delete m_server;
+    if (m_endpoint && m_registeredSti != 0)
+        m_endpoint->unregisterReceiver(m_registeredSti);
+    m_transport.reset();
+}
+
+void RlsUdpTask::receiveDatagram(const InetAddress &addr, const uint8_t *data, size_t size)
+{
+    rls::RlsMessageView view{};
+    if (!rls::DecodeRlsMessageView(data, size, view))
+        m_logger->err("Unable to decode RLS message");
+    else
+        receiveRlsPdu(addr, view, data, size);
+}
+
+void RlsUdpTask::sendDatagram(const InetAddress &addr, const uint8_t *header, size_t headerSize,
+                              const uint8_t *payload, size_t payloadSize)
+{
+    if (m_endpoint && payloadSize == 0)
+        m_endpoint->send(addr, header, headerSize);
+    else if (m_endpoint)
+        m_endpoint->send(addr, header, headerSize, payload, payloadSize);
+    else if (payloadSize == 0)
+        m_transport->send(addr, header, headerSize);
+    else
+        m_transport->send(addr, header, headerSize, payload, payloadSize);
 }
 
 void RlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg)
 {
+    if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION)
+    {
+        auto &m = (const rls::RlsPduTransmission &)msg;
+
+        // Only the header is encoded, the PDU is sent from where it is
+        uint8_t header[rls::PDU_TRANSMISSION_HEADER_SIZE];
+        rls::EncodePduTransmissionHeader(m.sti, m.pduType, m.pduId, m.payload, static_cast<size_t>(m.pdu.length()),
+                                         header);
+
+        sendDatagram(addr, header, sizeof(header), m.pdu.data(), static_cast<size_t>(m.pdu.length()));
+        return;
+    }
+
     OctetString stream;
     rls::EncodeRlsMessage(msg, stream);
 
-    m_server->Send(addr, stream.data(), static_cast<size_t>(stream.length()));
+    sendDatagram(addr, stream.data(), static_cast<size_t>(stream.length()), nullptr, 0);
 }
 
 void RlsUdpTask::send(int cellId, const rls::RlsMessage &msg)
 {
     if (m_cellIdToSti.count(cellId))
     {
-        auto sti = m_cellIdToSti[cellId];
-        sendRlsPdu(m_cells[sti].address, msg);
+        auto &cell = m_cells[m_cellIdToSti[cellId]];
+
+        if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION_BATCH && !(cell.features & rls::FEATURE_PDU_BATCH))
+        {
+            // The cell does not support batching, send the PDUs one by one
+            for (auto &item : ((const rls::RlsPduTransmissionBatch &)msg).items)
+            {
+                rls::RlsPduTransmission m{msg.sti};
+                m.pduType = item.pduType;
+                m.pduId = item.pduId;
+                m.payload = item.payload;
+                m.pdu = item.pdu.copy();
+                sendRlsPdu(cell.address, m);
+            }
+            return;
+        }
+
+        sendRlsPdu(cell.address, msg);
     }
 }
 
-void RlsUdpTask::receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg)
+void RlsUdpTask::receiveRlsPdu(const InetAddress &addr, const rls::RlsMessageView &view, const uint8_t *data,
+                               size_t size)
 {
-    if (msg->msgType == rls::EMessageType::HEARTBEAT_ACK)
+    if (view.msgType == rls::EMessageType::HEARTBEAT_ACK)
     {
-        if (!m_cells.count(msg->sti))
+        if (!m_cells.count(view.sti))
         {
-            m_cells[msg->sti].cellId = ++m_cellIdCounter;
-            m_cellIdToSti[m_cells[msg->sti].cellId] = msg->sti;
+            m_cells[view.sti].cellId = ++m_cellIdCounter;
+            m_cellIdToSti[m_cells[view.sti].cellId] = view.sti;
         }
 
         int oldDbm = INT32_MIN;
-        if (m_cells.count(msg->sti))
-            oldDbm = m_cells[msg->sti].dbm;
+        if (m_cells.count(view.sti))
+            oldDbm = m_cells[view.sti].dbm;
 
-        m_cells[msg->sti].address = addr;
-        m_cells[msg->sti].lastSeen = utils::CurrentTimeMillis();
+        m_cells[view.sti].address = addr;
+        m_cells[view.sti].lastSeen = utils::CurrentTimeMillis();
 
-        int newDbm = ((const rls::RlsHeartBeatAck &)*msg).dbm;
-        m_cells[msg->sti].dbm = newDbm;
+        int newDbm = view.dbm;
+        m_cells[view.sti].dbm = newDbm;
+        m_cells[view.sti].features = view.features;
 
         if (oldDbm != newDbm)
-            onSignalChangeOrLost(m_cells[msg->sti].cellId);
+            onSignalChangeOrLost(m_cells[view.sti].cellId);
         return;
     }
 
-    if (!m_cells.count(msg->sti))
+    if (!m_cells.count(view.sti))
     {
         // if no HB-ACK received yet, and the message is not HB-ACK, then ignore the message
         return;
     }
 
+    std::unique_ptr<rls::RlsMessage> msg;
+    if (view.msgType == rls::EMessageType::PDU_TRANSMISSION)
+    {
+        auto m = std::make_unique<rls::RlsPduTransmission>(view.sti);
+        m->pduType = view.pduType;
+        m->pduId = view.pduId;
+        m->payload = view.payload;
+        m->pdu = OctetString::FromArray(view.pdu, view.pduLength);
+        msg = std::move(m);
+    }
+    else
+    {
+        msg = rls::DecodeRlsMessage(OctetView{data, size});
+        if (msg == nullptr)
+        {
+            m_logger->err("Unable to decode RLS message");
+            return;
+        }
+    }
+
     auto *w = new NmUeRlsToRls(NmUeRlsToRls::RECEIVE_RLS_MESSAGE);
-    w->cellId = m_cells[msg->sti].cellId;
+    w->cellId = m_cells[view.sti].cellId;
     w->msg = std::move(msg);
     m_ctlTask->push(w);
 }
@@ -159,10 +280,25 @@ void RlsUdpTask::heartbeatCycle(uint64_t time, const Vector3 &simPos)
     for (auto cell : toRemove)
         onSignalChangeOrLost(cell.second);
 
+    uint64_t sti = m_shCtx->sti;
+
+    if (m_endpoint)
+    {
+        // The endpoint sends the heartbeats of all the UEs. The STI changes with RESET_STI, the endpoint must know it
+        // before the gNB does.
+        if (m_registeredSti != 0 && m_registeredSti != sti)
+            m_endpoint->unregisterReceiver(m_registeredSti);
+        m_endpoint->registerReceiver(sti, this, simPos);
+        m_registeredSti = sti;
+        return;
+    }
+
     for (auto &addr : m_searchSpace)
     {
-        rls::RlsHeartBeat msg{m_shCtx->sti};
+        rls::RlsHeartBeat msg{sti};
         msg.simPos = simPos;
+        // Envelopes and aggregated heartbeats are only needed when the socket is shared
+        msg.features = rls::SUPPORTED_FEATURES & ~(rls::FEATURE_ENVELOPE | rls::FEATURE_HEARTBEAT_BATCH);
         sendRlsPdu(addr, msg);
     }
 }
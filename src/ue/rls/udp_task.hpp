@@ -9,11 +9,14 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include <lib/radio/mobility.hpp>
 #include <lib/rls/rls_pdu.hpp>
-#include <lib/udp/server.hpp>
+#include <lib/rls/rls_transport.hpp>
+#include <ue/rls/endpoint.hpp>
 #include <ue/types.hpp>
 #include <utils/nts.hpp>
 
@@ -29,11 +32,13 @@ class RlsUdpTask : public NtsTask
         int64_t lastSeen{};
         int dbm{};
         int cellId{};
+        uint8_t features{};
     };
 
   private:
     std::unique_ptr<Logger> m_logger;
-    udp::UdpServer *m_server;
+    std::unique_ptr<rls::RlsTransport> m_transport;
+    RlsEndpointTask *m_endpoint;
     NtsTask *m_ctlTask;
     RlsSharedContext* m_shCtx;
     std::vector<InetAddress> m_searchSpace;
@@ -42,6 +47,9 @@ class RlsUdpTask : public NtsTask
     int64_t m_lastLoop;
     Vector3 m_simPos;
     int m_cellIdCounter;
+    std::unique_ptr<radio::MobilityModel> m_mobility;
+    int64_t m_startTime;
+    uint64_t m_registeredSti;
 
     friend class UeCmdHandler;
 
@@ -56,7 +64,10 @@ class RlsUdpTask : public NtsTask
 
   private:
     void sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg);
-    void receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg);
+    void sendDatagram(const InetAddress &addr, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+                      size_t payloadSize);
+    void receiveDatagram(const InetAddress &addr, const uint8_t *data, size_t size);
+    void receiveRlsPdu(const InetAddress &addr, const rls::RlsMessageView &view, const uint8_t *data, size_t size);
     void onSignalChangeOrLost(int cellId);
     void heartbeatCycle(uint64_t time, const Vector3 &simPos);
 
@@ -37,7 +37,7 @@ void UeRrcTask::notifyCellDetected(int cellId, int dbm)
     m_cellDesc[cellId] = {};
     m_cellDesc[cellId].dbm = dbm;
 
-    m_logger->debug("New signal detected for cell[%d], total [%d] cells in coverage", cellId,
+    m_logger->debug(FMT_STRING("New signal detected for cell[{}], total [{}] cells in coverage"), cellId,
                     static_cast<int>(m_cellDesc.size()));
 
     updateAvailablePlmns();
@@ -60,8 +60,10 @@ void UeRrcTask::notifyCellLost(int cellId)
     });
 
     m_cellDesc.erase(cellId);
+    if (isActiveCell)
+        updateUacCellState();
 
-    m_logger->debug("Signal lost for cell[%d], total [%d] cells in coverage", cellId,
+    m_logger->debug(FMT_STRING("Signal lost for cell[{}], total [{}] cells in coverage"), cellId,
                     static_cast<int>(m_cellDesc.size()));
 
     if (isActiveCell)
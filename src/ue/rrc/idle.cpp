@@ -46,11 +46,10 @@ void UeRrcTask::performCellSelection()
             {
                 if (!m_cellDesc.empty())
                 {
-                    m_logger->warn(
-                        "Suitable cell selection failed in [%d] cells. [%d] out of PLMN, [%d] no SI, [%d] reserved, "
-                        "[%d] barred, ftai [%d]",
-                        static_cast<int>(m_cellDesc.size()), report.outOfPlmnCells, report.siMissingCells,
-                        report.reservedCells, report.barredCells, report.forbiddenTaiCells);
+                    m_logger->warn(FMT_STRING("Suitable cell selection failed in [{}] cells. [{}] out of PLMN, "
+                                              "[{}] no SI, [{}] reserved, [{}] barred, ftai [{}]"),
+                                   static_cast<int>(m_cellDesc.size()), report.outOfPlmnCells, report.siMissingCells,
+                                   report.reservedCells, report.barredCells, report.forbiddenTaiCells);
                 }
                 else
                 {
@@ -74,8 +73,8 @@ void UeRrcTask::performCellSelection()
             {
                 if (!m_cellDesc.empty())
                 {
-                    m_logger->warn("Acceptable cell selection failed in [%d] cells. [%d] no SI, [%d] reserved, [%d] "
-                                   "barred, ftai [%d]",
+                    m_logger->warn(FMT_STRING("Acceptable cell selection failed in [{}] cells. [{}] no SI, "
+                                              "[{}] reserved, [{}] barred, ftai [{}]"),
                                    static_cast<int>(m_cellDesc.size()), report.siMissingCells, report.reservedCells,
                                    report.barredCells, report.forbiddenTaiCells);
                 }
@@ -93,10 +92,11 @@ void UeRrcTask::performCellSelection()
 
     int selectedCell = cellInfo.cellId;
     m_base->shCtx.currentCell.set(cellInfo);
+    updateUacCellState();
 
     if (selectedCell != 0 && selectedCell != lastCell.cellId)
-        m_logger->info("Selected cell plmn[%s] tac[%d] category[%s]", ToJson(cellInfo.plmn).str().c_str(), cellInfo.tac,
-                       ToJson(cellInfo.category).str().c_str());
+        m_logger->info(FMT_STRING("Selected cell plmn[{}] tac[{}] category[{}]"), ToJson(cellInfo.plmn).str().c_str(),
+                       cellInfo.tac, ToJson(cellInfo.category).str().c_str());
 
     if (selectedCell != lastCell.cellId)
     {
@@ -56,9 +56,8 @@ void UeRrcTask::handleNasSapMessage(NmUeNasToRrc &msg)
         triggerCycle();
         break;
     }
-    case NmUeNasToRrc::PERFORM_UAC: {
-        if (!msg.uacCtl->isExpiredForProducer())
-            performUac(msg.uacCtl);
+    case NmUeNasToRrc::UAC_PERFORMED: {
+        m_establishmentCause = msg.establishmentCause;
         break;
     }
     }
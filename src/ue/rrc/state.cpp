@@ -41,7 +41,7 @@ void UeRrcTask::switchState(ERrcState state)
     ERrcState oldState = m_state;
     m_state = state;
 
-    m_logger->info("UE switches to state [%s]", ToJson(state).str().c_str());
+    m_logger->info(FMT_STRING("UE switches to state [{}]"), ToJson(state).str().c_str());
 
     if (m_base->nodeListener)
     {
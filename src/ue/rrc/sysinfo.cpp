@@ -32,6 +32,7 @@ void UeRrcTask::receiveMib(int cellId, const ASN_RRC_MIB &msg)
     desc.mib.hasMib = true;
 
     updateAvailablePlmns();
+    updateUacCellState();
 }
 
 void UeRrcTask::receiveSib1(int cellId, const ASN_RRC_SIB1 &msg)
@@ -65,6 +66,7 @@ void UeRrcTask::receiveSib1(int cellId, const ASN_RRC_SIB1 &msg)
     desc.sib1.hasSib1 = true;
 
     updateAvailablePlmns();
+    updateUacCellState();
 }
 
 } // namespace nr::ue
\ No newline at end of file
@@ -25,7 +25,7 @@ namespace nr::ue
 
 UeRrcTask::UeRrcTask(TaskBase *base) : m_base{base}, m_timers{}
 {
-    m_logger = base->logBase->makeUniqueLogger(base->config->getLoggerPrefix() + "rrc");
+    m_logger = base->logBase->makePrefixedLogger(base->config->getLoggerPrefix(), "rrc");
 
     m_startedTime = utils::CurrentTimeMillis();
     m_state = ERrcState::RRC_IDLE;
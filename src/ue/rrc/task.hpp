@@ -136,7 +136,7 @@ class UeRrcTask : public NtsTask
     void handleRadioLinkFailure(rls::ERlfCause cause);
 
     /* Access Control */
-    void performUac(std::shared_ptr<LightSync<UacInput, UacOutput>> &uacCtl);
+    void updateUacCellState();
 };
 
 } // namespace nr::ue
@@ -0,0 +1,369 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "db.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utils/io.hpp>
+#include <utils/libc_error.hpp>
+
+static constexpr const char BINARY_MAGIC[8] = {'U', 'E', 'S', 'U', 'B', 'D', 'B', '1'};
+
+namespace nr::ue
+{
+
+struct BinaryHeader
+{
+    char magic[8];
+    uint32_t recordSize;
+    uint32_t count;
+};
+
+static_assert(sizeof(BinaryHeader) == 16, "unexpected subscriber file header layout");
+
+static uint64_t HashImsi(uint64_t imsi, uint8_t length)
+{
+    // splitmix64 finalizer
+    uint64_t x = imsi ^ (static_cast<uint64_t>(length) << 56);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static bool ParseImsi(const char *begin, const char *end, uint64_t &imsi, uint8_t &length)
+{
+    if (end - begin > 5 && std::memcmp(begin, "imsi-", 5) == 0)
+        begin += 5;
+    if (begin == end || end - begin > 15)
+        return false;
+
+    imsi = 0;
+    for (auto *p = begin; p != end; p++)
+    {
+        if (*p < '0' || *p > '9')
+            return false;
+        imsi = imsi * 10 + static_cast<uint64_t>(*p - '0');
+    }
+    length = static_cast<uint8_t>(end - begin);
+    return true;
+}
+
+static int HexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool ParseHex(const char *begin, const char *end, uint8_t *out, size_t size)
+{
+    if (static_cast<size_t>(end - begin) != size * 2)
+        return false;
+    for (size_t i = 0; i < size; i++)
+    {
+        int high = HexDigit(begin[2 * i]);
+        int low = HexDigit(begin[2 * i + 1]);
+        if (high < 0 || low < 0)
+            return false;
+        out[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+
+static bool ParseNssai(const char *begin, const char *end, SubscriberRecord &record)
+{
+    while (begin < end)
+    {
+        auto *itemEnd = static_cast<const char *>(std::memchr(begin, ';', static_cast<size_t>(end - begin)));
+        if (itemEnd == nullptr)
+            itemEnd = end;
+
+        if (record.sliceCount == SubscriberRecord::MAX_SLICES)
+            return false;
+        int slice = record.sliceCount++;
+
+        auto *colon = static_cast<const char *>(std::memchr(begin, ':', static_cast<size_t>(itemEnd - begin)));
+        auto *sstEnd = colon ? colon : itemEnd;
+        if (sstEnd == begin || sstEnd - begin > 3)
+            return false;
+
+        int sst = 0;
+        for (auto *p = begin; p != sstEnd; p++)
+        {
+            if (*p < '0' || *p > '9')
+                return false;
+            sst = sst * 10 + (*p - '0');
+        }
+        if (sst > 0xFF)
+            return false;
+        record.sst[slice] = static_cast<uint8_t>(sst);
+
+        if (colon)
+        {
+            if (!ParseHex(colon + 1, itemEnd, record.sd[slice], 3))
+                return false;
+            record.sdMask |= static_cast<uint8_t>(1 << slice);
+        }
+
+        begin = itemEnd + 1;
+    }
+    return true;
+}
+
+static void ParseCsvLine(const char *begin, const char *end, SubscriberRecord &record)
+{
+    const char *fields[5][2]{};
+    int fieldCount = 0;
+
+    for (auto *p = begin;;)
+    {
+        auto *comma = static_cast<const char *>(std::memchr(p, ',', static_cast<size_t>(end - p)));
+        auto *fieldEnd = comma ? comma : end;
+        if (fieldCount == 5)
+            throw std::runtime_error("too many fields");
+        fields[fieldCount][0] = p;
+        fields[fieldCount][1] = fieldEnd;
+        fieldCount++;
+        if (comma == nullptr)
+            break;
+        p = comma + 1;
+    }
+
+    if (fieldCount < 3)
+        throw std::runtime_error("IMSI, K and OPc are required");
+
+    std::memset(&record, 0, sizeof(record));
+
+    if (!ParseImsi(fields[0][0], fields[0][1], record.imsi, record.imsiLength))
+        throw std::runtime_error("invalid IMSI");
+    if (!ParseHex(fields[1][0], fields[1][1], record.key, sizeof(record.key)))
+        throw std::runtime_error("invalid K");
+    if (!ParseHex(fields[2][0], fields[2][1], record.opc, sizeof(record.opc)))
+        throw std::runtime_error("invalid OPc");
+
+    if (fieldCount > 3 && fields[3][0] != fields[3][1])
+    {
+        if (!ParseHex(fields[3][0], fields[3][1], record.amf, sizeof(record.amf)))
+            throw std::runtime_error("invalid AMF");
+        record.flags |= SubscriberRecord::FLAG_HAS_AMF;
+    }
+
+    if (fieldCount > 4 && fields[4][0] != fields[4][1])
+    {
+        if (!ParseNssai(fields[4][0], fields[4][1], record))
+            throw std::runtime_error("invalid NSSAI");
+        record.flags |= SubscriberRecord::FLAG_HAS_NSSAI;
+    }
+}
+
+SubscriberDb::SubscriberDb() : m_records{}, m_count{}, m_mapping{}, m_mappingSize{}
+{
+}
+
+SubscriberDb::~SubscriberDb()
+{
+    if (m_mapping)
+        ::munmap(m_mapping, m_mappingSize);
+}
+
+std::unique_ptr<SubscriberDb> SubscriberDb::Load(const std::string &path)
+{
+    char magic[sizeof(BINARY_MAGIC)]{};
+    {
+        std::ifstream stream{path, std::ios::binary};
+        if (!stream)
+            throw std::runtime_error("Subscriber file could not be opened: " + path);
+        stream.read(magic, sizeof(magic));
+    }
+
+    auto db = std::make_unique<SubscriberDb>();
+    if (std::memcmp(magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0)
+        db->loadBinary(path);
+    else
+        db->loadCsv(io::ReadAllText(path));
+    db->buildIndex();
+    return db;
+}
+
+void SubscriberDb::loadCsv(const std::string &content)
+{
+    const char *p = content.data();
+    const char *end = p + content.size();
+    int lineNumber = 0;
+
+    while (p < end)
+    {
+        auto *lineEnd = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (lineEnd == nullptr)
+            lineEnd = end;
+        auto *next = lineEnd + 1;
+        lineNumber++;
+
+        while (lineEnd > p && (lineEnd[-1] == '\r' || lineEnd[-1] == ' ' || lineEnd[-1] == '\t'))
+            lineEnd--;
+
+        bool isHeader = lineNumber == 1 && lineEnd - p >= 4 && std::memcmp(p, "imsi", 4) == 0 &&
+                        (lineEnd - p == 4 || p[4] == ',');
+        if (p != lineEnd && *p != '#' && !isHeader)
+        {
+            m_ownedRecords.emplace_back();
+            try
+            {
+                ParseCsvLine(p, lineEnd, m_ownedRecords.back());
+            }
+            catch (const std::runtime_error &e)
+            {
+                throw std::runtime_error("Subscriber file line " + std::to_string(lineNumber) + ": " + e.what());
+            }
+        }
+
+        p = next;
+    }
+
+    m_records = m_ownedRecords.data();
+    m_count = m_ownedRecords.size();
+}
+
+void SubscriberDb::loadBinary(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw LibError("Subscriber file could not be opened: " + path);
+
+    struct stat st = {};
+    if (::fstat(fd, &st) < 0)
+    {
+        int err = errno;
+        ::close(fd);
+        throw LibError("Subscriber file could not be read: " + path, err);
+    }
+
+    m_mappingSize = static_cast<size_t>(st.st_size);
+    void *memory = m_mappingSize >= sizeof(BinaryHeader)
+                       ? ::mmap(nullptr, m_mappingSize, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0)
+                       : MAP_FAILED;
+    int err = errno;
+    ::close(fd);
+
+    if (memory == MAP_FAILED)
+        throw LibError("Subscriber file could not be mapped: " + path, err);
+    m_mapping = memory;
+
+    auto *header = static_cast<const BinaryHeader *>(memory);
+    if (header->recordSize != sizeof(SubscriberRecord) ||
+        m_mappingSize != sizeof(BinaryHeader) + static_cast<size_t>(header->count) * sizeof(SubscriberRecord))
+        throw std::runtime_error("Subscriber file is truncated or of another version: " + path);
+
+    m_records = reinterpret_cast<const SubscriberRecord *>(static_cast<const uint8_t *>(memory) + sizeof(BinaryHeader));
+    m_count = header->count;
+}
+
+void SubscriberDb::buildIndex()
+{
+    if (m_count >= UINT32_MAX / 2)
+        throw std::runtime_error("Too many subscribers");
+
+    // At most half full, the probe sequences stay short
+    size_t capacity = 16;
+    while (capacity < m_count * 2)
+        capacity *= 2;
+    m_index.assign(capacity, 0);
+
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < m_count; i++)
+    {
+        auto &record = m_records[i];
+        size_t slot = HashImsi(record.imsi, record.imsiLength) & mask;
+        while (m_index[slot] != 0)
+        {
+            auto &other = m_records[m_index[slot] - 1];
+            if (other.imsi == record.imsi && other.imsiLength == record.imsiLength)
+                throw std::runtime_error("Duplicate IMSI in subscriber file at record " + std::to_string(i + 1));
+            slot = (slot + 1) & mask;
+        }
+        m_index[slot] = static_cast<uint32_t>(i + 1);
+    }
+}
+
+size_t SubscriberDb::size() const
+{
+    return m_count;
+}
+
+const SubscriberRecord *SubscriberDb::find(const std::string &imsi) const
+{
+    uint64_t value;
+    uint8_t length;
+    if (!ParseImsi(imsi.data(), imsi.data() + imsi.size(), value, length))
+        return nullptr;
+
+    size_t mask = m_index.size() - 1;
+    size_t slot = HashImsi(value, length) & mask;
+    while (m_index[slot] != 0)
+    {
+        auto &record = m_records[m_index[slot] - 1];
+        if (record.imsi == value && record.imsiLength == length)
+            return &record;
+        slot = (slot + 1) & mask;
+    }
+    return nullptr;
+}
+
+void SubscriberDb::writeBinary(const std::string &path) const
+{
+    BinaryHeader header{};
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.recordSize = sizeof(SubscriberRecord);
+    header.count = static_cast<uint32_t>(m_count);
+
+    std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char *>(m_records), static_cast<std::streamsize>(m_count * sizeof(SubscriberRecord)));
+    if (!stream)
+        throw std::runtime_error("Subscriber file could not be written: " + path);
+}
+
+std::unique_ptr<UeSubscription> ToSubscription(const SubscriberRecord &record)
+{
+    auto subscription = std::make_unique<UeSubscription>();
+    subscription->key = OctetString::FromArray(record.key, sizeof(record.key));
+    subscription->opC = OctetString::FromArray(record.opc, sizeof(record.opc));
+
+    if (record.flags & SubscriberRecord::FLAG_HAS_AMF)
+        subscription->amf = OctetString::FromArray(record.amf, sizeof(record.amf));
+
+    if (record.flags & SubscriberRecord::FLAG_HAS_NSSAI)
+    {
+        NetworkSlice nssai{};
+        for (int i = 0; i < record.sliceCount; i++)
+        {
+            SingleSlice slice{};
+            slice.sst = record.sst[i];
+            if (record.sdMask & (1 << i))
+                slice.sd = octet3{record.sd[i][0], record.sd[i][1], record.sd[i][2]};
+            nssai.slices.push_back(slice);
+        }
+        subscription->configuredNssai = std::move(nssai);
+    }
+
+    return subscription;
+}
+
+} // namespace nr::ue
@@ -0,0 +1,85 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ue/types.hpp>
+
+namespace nr::ue
+{
+
+/* A subscriber of the bulk subscriber file, in the layout of the records of the binary format */
+struct SubscriberRecord
+{
+    static constexpr const int MAX_SLICES = 4;
+    static constexpr const uint8_t FLAG_HAS_AMF = 1;
+    static constexpr const uint8_t FLAG_HAS_NSSAI = 2;
+
+    uint64_t imsi;       // IMSI digits as a number
+    uint8_t imsiLength;  // Number of IMSI digits, keeps the leading zeros
+    uint8_t flags;       // AMF and NSSAI of the profile are used unless given
+    uint8_t sliceCount;  // [0..MAX_SLICES]
+    uint8_t sdMask;      // Bit i is set if slice i has an SD
+    uint8_t amf[2];
+    uint8_t sst[MAX_SLICES];
+    uint8_t sd[MAX_SLICES][3];
+    uint8_t key[16];
+    uint8_t opc[16];
+    uint8_t reserved[2]; // Zero
+};
+
+static_assert(sizeof(SubscriberRecord) == 64, "unexpected subscriber record layout");
+
+/* Per-IMSI credentials and slices, loaded from either
+ *   - a CSV file with lines of 'imsi,k,opc[,amf[,nssai]]', where the NSSAI is a ';' separated list of 'sst[:sd]' with
+ *     the SD in 6 hexadecimal digits. Empty lines, lines starting with '#' and a header line starting with 'imsi' are
+ *     ignored.
+ *   - the binary format written by writeBinary(), which is a header followed by the records in host byte order. The
+ *     file is memory-mapped rather than read.
+ * The records are indexed by an open addressing hash table built at load time, for constant time lookups. */
+class SubscriberDb
+{
+  private:
+    std::vector<SubscriberRecord> m_ownedRecords;
+    const SubscriberRecord *m_records;
+    size_t m_count;
+    void *m_mapping;
+    size_t m_mappingSize;
+    std::vector<uint32_t> m_index; // Record index plus one, zero for empty slots
+
+  public:
+    SubscriberDb();
+    ~SubscriberDb();
+
+    SubscriberDb(const SubscriberDb &) = delete;
+    SubscriberDb &operator=(const SubscriberDb &) = delete;
+
+  public:
+    /* Detects the format by the header, throws on malformed files and duplicate IMSIs */
+    static std::unique_ptr<SubscriberDb> Load(const std::string &path);
+
+    [[nodiscard]] size_t size() const;
+    /* IMSI digits without the 'imsi-' prefix, nullptr if not found */
+    [[nodiscard]] const SubscriberRecord *find(const std::string &imsi) const;
+    void writeBinary(const std::string &path) const;
+
+  private:
+    void loadCsv(const std::string &content);
+    void loadBinary(const std::string &path);
+    void buildIndex();
+};
+
+std::unique_ptr<UeSubscription> ToSubscription(const SubscriberRecord &record);
+
+} // namespace nr::ue
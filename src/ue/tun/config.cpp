@@ -7,6 +7,7 @@
 //
 
 #include "config.hpp"
+#include "netlink.hpp"
 
 #include <arpa/inet.h>
 #include <array>
@@ -19,7 +20,9 @@
 #include <fstream>
 #include <ifaddrs.h>
 #include <iostream>
+#include <linux/fib_rules.h>
 #include <linux/if_tun.h>
+#include <linux/rtnetlink.h>
 #include <memory>
 #include <mutex>
 #include <net/if.h>
@@ -32,8 +35,8 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
 #include <utils/libc_error.hpp>
@@ -43,43 +46,10 @@
 
 static std::mutex configMutex;
 
-static int ExecOutput(const char *cmd, std::string &output)
-{
-    char buffer[128];
-    std::string result;
-    FILE *pipe = popen(cmd, "r");
-    if (!pipe)
-    {
-        output = "popen() failed!";
-        return -1;
-    }
-    try
-    {
-        while (fgets(buffer, sizeof buffer, pipe) != nullptr)
-            result += buffer;
-    }
-    catch (...)
-    {
-        pclose(pipe);
-        output = "";
-        return -1;
-    }
-    output = result;
-
-    int status = pclose(pipe);
-    return WEXITSTATUS(status);
-}
-
-static std::string ExecStrict(const std::string &cmd)
-{
-    std::string output;
-    if (ExecOutput(cmd.c_str(), output))
-    {
-        throw LibError("Command execution failed. The command was: " + cmd + ". The output is: '" + output +
-                       "Command execution failure");
-    }
-    return output;
-}
+/* Guarded by configMutex */
+static std::unique_ptr<nr::ue::tun::RtNetlink> g_netlink{};
+static std::unordered_map<std::string, uint32_t> g_tableIds{};
+static std::set<uint32_t> g_usedTableIds{};
 
 static const char *NextInterfaceName(const std::string &prefix)
 {
@@ -109,46 +79,20 @@ static const char *NextInterfaceName(const std::string &prefix)
     return nullptr;
 }
 
-static void TunSetIpAndUp(const char *ifName, const char *ipAddr, int mtu)
+/* Prefix length of the classful network of the address, as set by SIOCSIFADDR */
+static uint8_t ClassfulPrefixLength(in_addr_t address)
 {
-    ifreq ifr{};
-    memset(&ifr, 0, sizeof(struct ifreq));
-
-    sockaddr_in sai{};
-    memset(&sai, 0, sizeof(struct sockaddr));
-
-    int sockFd;
-    char *p;
-
-    sockFd = socket(AF_INET, SOCK_DGRAM, 0);
-
-    strcpy(ifr.ifr_name, ifName);
-
-    sai.sin_family = AF_INET;
-    sai.sin_port = 0;
-
-    sai.sin_addr.s_addr = inet_addr(ipAddr);
-
-    p = (char *)&sai;
-    memcpy((((char *)&ifr + offsetof(struct ifreq, ifr_addr))), p, sizeof(struct sockaddr));
-
-    if (ioctl(sockFd, SIOCSIFADDR, &ifr) < 0)
-        throw LibError("ioctl(SIOCSIFADDR)", errno);
-    if (ioctl(sockFd, SIOCGIFFLAGS, &ifr) < 0)
-        throw LibError("ioctl(SIOCGIFFLAGS)", errno);
-
-    ifr.ifr_mtu = mtu;
-    if (ioctl(sockFd, SIOCSIFMTU, &ifr) < 0)
-        throw LibError("ioctl(SIOCSIFMTU)", errno);
-
-    ifr.ifr_flags |= IFF_UP | IFF_RUNNING;
-    if (ioctl(sockFd, SIOCSIFFLAGS, &ifr) < 0)
-        throw LibError("ioctl(SIOCSIFFLAGS)", errno);
-
-    close(sockFd);
+    uint32_t host = ntohl(address);
+    if (IN_CLASSA(host))
+        return 8;
+    if (IN_CLASSB(host))
+        return 16;
+    if (IN_CLASSC(host))
+        return 24;
+    return 32;
 }
 
-static void ConfigureRtTables(const std::string &table_name)
+static void LoadRtTables()
 {
     std::ifstream ifs;
     ifs.open("/etc/iproute2/rt_tables");
@@ -156,10 +100,6 @@ static void ConfigureRtTables(const std::string &table_name)
         throw LibError("Could not open '/etc/iproute2/rt_tables'");
 
     std::string line;
-
-    bool found = false;
-    std::set<int> nums;
-
     while (std::getline(ifs, line))
     {
         auto pos = line.find('#');
@@ -171,148 +111,223 @@ static void ConfigureRtTables(const std::string &table_name)
         std::stringstream ss;
         ss << line;
 
-        int num;
-        ss >> num >> line;
-
-        nums.insert(num);
+        uint32_t num;
+        std::string name;
+        if (!(ss >> num >> name))
+            continue;
 
-        if (line == table_name)
-            found = true;
+        g_usedTableIds.insert(num);
+        g_tableIds[name] = num;
     }
+}
 
-    ifs.close();
+/* Routing table of the given name, registered in '/etc/iproute2/rt_tables' so that ip(8) shows it by name. The file
+ * is only read again for the names which are not known yet, since other processes may register tables too. */
+static uint32_t RoutingTableId(const std::string &tableName)
+{
+    auto it = g_tableIds.find(tableName);
+    if (it != g_tableIds.end())
+        return it->second;
 
-    if (!found)
-    {
-        int availableId = 1000;
-        while (nums.count(availableId))
-            availableId++;
+    LoadRtTables();
 
-        std::ofstream ofs;
+    it = g_tableIds.find(tableName);
+    if (it != g_tableIds.end())
+        return it->second;
 
-        ofs.open("/etc/iproute2/rt_tables", std::ios_base::app);
-        if (!ofs.is_open() || !ofs.good())
-            throw LibError("Could not open '/etc/iproute2/rt_tables'");
+    uint32_t availableId = 1000;
+    while (g_usedTableIds.count(availableId))
+        availableId++;
 
-        ofs << "\n" << availableId << "\t" << table_name << std::endl;
-        ofs.close();
-    }
+    std::ofstream ofs;
+    ofs.open("/etc/iproute2/rt_tables", std::ios_base::app);
+    if (!ofs.is_open() || !ofs.good())
+        throw LibError("Could not open '/etc/iproute2/rt_tables'");
+
+    ofs << "\n" << availableId << "\t" << tableName << std::endl;
+    ofs.close();
+
+    g_usedTableIds.insert(availableId);
+    g_tableIds[tableName] = availableId;
+    return availableId;
 }
 
-static void RemoveExistingIpRules(const std::string &ip_addr)
+/* Priorities of the rules of the form 'from <address> lookup <any table>' */
+static std::vector<uint32_t> FindRulesFrom(nr::ue::tun::RtNetlink &netlink, in_addr_t address)
 {
-    std::string list_command = "ip rule list from " + ip_addr;
-    std::string output = ExecStrict(list_command);
+    std::vector<uint32_t> priorities;
 
-    std::stringstream ss;
-    ss << output;
+    fib_rule_hdr request{};
+    request.family = AF_INET;
 
-    std::vector<std::string> lines;
-    std::vector<std::string> will_remove;
+    netlink.dump(RTM_GETRULE, &request, sizeof(request), [&priorities, address](const nlmsghdr *msg) {
+        if (msg->nlmsg_type != RTM_NEWRULE)
+            return;
 
-    std::string s;
-    while (std::getline(ss, s))
-        lines.push_back(s);
-
-    for (auto &line : lines)
-    {
-        int num = 0;
-        char from_ip[512] = {0};
-        char table_name[512] = {0};
+        auto *rule = reinterpret_cast<const fib_rule_hdr *>(NLMSG_DATA(msg));
+        if (rule->family != AF_INET || rule->src_len != 32)
+            return;
 
-        if (sscanf(line.c_str(), "%d: from %s lookup %s", &num, from_ip, table_name) != 3)
-            throw LibError("ip rule list lookup command could not parsed");
+        bool sourceMatches = false;
+        uint32_t priority = 0;
 
-        if (!strcmp(from_ip, ip_addr.c_str()))
+        int length = static_cast<int>(RTM_PAYLOAD(msg));
+        for (auto *attr = reinterpret_cast<const rtattr *>(reinterpret_cast<const uint8_t *>(rule) +
+                                                          NLMSG_ALIGN(sizeof(fib_rule_hdr)));
+             RTA_OK(attr, length); attr = RTA_NEXT(attr, length))
         {
-            std::stringstream rule;
-            rule << "from " << from_ip << " lookup " << table_name;
-            will_remove.push_back(rule.str());
+            if (attr->rta_type == FRA_SRC && RTA_PAYLOAD(attr) == sizeof(in_addr_t))
+                sourceMatches = std::memcmp(RTA_DATA(attr), &address, sizeof(in_addr_t)) == 0;
+            else if (attr->rta_type == FRA_PRIORITY)
+                std::memcpy(&priority, RTA_DATA(attr), sizeof(priority));
         }
-    }
 
-    for (auto &line : will_remove)
-        ExecStrict("ip rule del " + line);
+        if (sourceMatches)
+            priorities.push_back(priority);
+    });
+
+    return priorities;
 }
 
-static void AddNewIpRules(const std::string &ip_addr, const std::string &table_name)
+static nr::ue::tun::RtNetlink &Netlink()
 {
-    std::stringstream cmd;
-    cmd << "ip rule add from " << ip_addr << " table " << table_name;
-    ExecStrict(cmd.str());
+    if (g_netlink == nullptr)
+        g_netlink = std::make_unique<nr::ue::tun::RtNetlink>();
+    return *g_netlink;
 }
 
-static bool IsFibTableExists(const std::string &table_name)
+static uint32_t InterfaceIndex(const char *ifName)
 {
-    std::string output = ExecStrict("ip route show table all");
-
-    std::stringstream ss;
-    ss << output;
-
-    std::string token;
-    while (ss >> token)
-    {
-        if (token == "table")
-        {
-            ss >> token;
-            if (token == table_name)
-                return true;
-        }
-    }
+    uint32_t ifIndex = if_nametoindex(ifName);
+    if (ifIndex == 0)
+        throw LibError("if_nametoindex(" + std::string{ifName} + ")", errno);
+    return ifIndex;
+}
 
-    return false;
+static in_addr_t ParseAddress(const char *ipAddr)
+{
+    in_addr_t address = inet_addr(ipAddr);
+    if (address == INADDR_NONE)
+        throw LibError("Invalid IPv4 address: " + std::string{ipAddr});
+    return address;
 }
 
-static void RemoveExistingIpRoutes(const std::string &interface_name, const std::string &table_name)
+/* Tables beyond the 8-bit header field are only given by the attribute */
+static uint8_t HeaderTable(uint32_t tableId)
 {
-    if (!IsFibTableExists(table_name))
-        return;
+    return tableId < 256 ? static_cast<uint8_t>(tableId) : static_cast<uint8_t>(RT_TABLE_UNSPEC);
+}
 
-    std::string list_command = "ip route list table " + table_name;
+/* With offloads, each packet is preceded by a virtio_net_hdr, and the kernel may hand TCP segments up to 64 KB with
+ * their checksums left to be completed */
+static int OpenTunQueue(const char *ifName, short flags, bool offload)
+{
+    if (offload)
+        flags |= IFF_VNET_HDR;
 
-    std::string output = ExecStrict(list_command);
+    int fd;
+    if ((fd = open("/dev/net/tun", O_RDWR)) < 0)
+        throw LibError("Open failure /dev/net/tun");
 
-    std::stringstream ss;
-    ss << output;
+    ifreq ifr{};
+    ifr.ifr_flags = flags;
+    strncpy(ifr.ifr_name, ifName, IFNAMSIZ - 1);
 
-    std::vector<std::string> lines;
-    std::vector<std::string> will_remove;
+    if (ioctl(fd, TUNSETIFF, (void *)&ifr) < 0)
+    {
+        int err = errno;
+        close(fd);
+        throw LibError("ioctl(TUNSETIFF)", err);
+    }
 
-    std::string s;
-    while (std::getline(ss, s))
-        lines.push_back(s);
+    if (strcmp(ifr.ifr_name, ifName) != 0)
+    {
+        close(fd);
+        throw LibError("TUN interface name could not be allocated.");
+    }
 
-    for (auto &line : lines)
+    if (offload && ioctl(fd, TUNSETOFFLOAD, TUN_F_CSUM | TUN_F_TSO4) < 0)
     {
-        char if_name[IF_NAMESIZE + 8] = {0};
+        int err = errno;
+        close(fd);
+        throw LibError("ioctl(TUNSETOFFLOAD)", err);
+    }
 
-        if (sscanf(line.c_str(), "default dev %s scope link", if_name) != 1)
-            throw LibError("ip route list command could not parsed");
+    return fd;
+}
 
-        if (!strcmp(if_name, interface_name.c_str()))
-        {
-            std::stringstream rule;
-            rule << "ip route del default dev " << interface_name << " table " << table_name;
-            will_remove.push_back(rule.str());
-        }
-    }
+static void QueueAddress(nr::ue::tun::RtNetlink &netlink, uint16_t type, uint32_t ifIndex, in_addr_t address,
+                         uint8_t prefixLength)
+{
+    ifaddrmsg addrMsg{};
+    addrMsg.ifa_family = AF_INET;
+    addrMsg.ifa_prefixlen = prefixLength;
+    addrMsg.ifa_scope = RT_SCOPE_UNIVERSE;
+    addrMsg.ifa_index = ifIndex;
+    if (type == RTM_NEWADDR)
+        netlink.begin(RTM_NEWADDR, NLM_F_CREATE | NLM_F_REPLACE, &addrMsg, sizeof(addrMsg), "set address");
+    else
+        netlink.begin(RTM_DELADDR, 0, &addrMsg, sizeof(addrMsg), "delete address", EADDRNOTAVAIL);
+    netlink.attribute(IFA_LOCAL, &address, sizeof(address));
+    netlink.attribute(IFA_ADDRESS, &address, sizeof(address));
+}
 
-    for (auto &line : will_remove)
-        ExecStrict(line);
+static void QueueLinkUp(nr::ue::tun::RtNetlink &netlink, uint32_t ifIndex, int mtu)
+{
+    ifinfomsg linkMsg{};
+    linkMsg.ifi_family = AF_UNSPEC;
+    linkMsg.ifi_index = static_cast<int>(ifIndex);
+    linkMsg.ifi_flags = IFF_UP;
+    linkMsg.ifi_change = IFF_UP;
+    netlink.begin(RTM_NEWLINK, 0, &linkMsg, sizeof(linkMsg), "set MTU and up");
+    netlink.attributeU32(IFLA_MTU, static_cast<uint32_t>(mtu));
+}
+
+static void QueueDeleteRules(nr::ue::tun::RtNetlink &netlink, in_addr_t address,
+                             const std::vector<uint32_t> &priorities)
+{
+    // The kernel matches a rule to delete by the fields given only
+    for (uint32_t priority : priorities)
+    {
+        fib_rule_hdr deleteMsg{};
+        deleteMsg.family = AF_INET;
+        deleteMsg.src_len = 32;
+        netlink.begin(RTM_DELRULE, 0, &deleteMsg, sizeof(deleteMsg), "delete rule", ENOENT);
+        netlink.attribute(FRA_SRC, &address, sizeof(address));
+        netlink.attributeU32(FRA_PRIORITY, priority);
+    }
 }
 
-static void AddIpRoutes(const std::string &if_name, const std::string &table_name)
+static void QueueRule(nr::ue::tun::RtNetlink &netlink, in_addr_t address, uint32_t tableId)
 {
-    std::stringstream cmd;
-    cmd << "ip route add default dev " << if_name << " table " << table_name;
+    fib_rule_hdr ruleMsg{};
+    ruleMsg.family = AF_INET;
+    ruleMsg.src_len = 32;
+    ruleMsg.table = HeaderTable(tableId);
+    ruleMsg.action = FR_ACT_TO_TBL;
+    netlink.begin(RTM_NEWRULE, NLM_F_CREATE | NLM_F_EXCL, &ruleMsg, sizeof(ruleMsg), "add rule");
+    netlink.attribute(FRA_SRC, &address, sizeof(address));
+    netlink.attributeU32(FRA_TABLE, tableId);
+}
 
-    std::string output = ExecStrict(cmd.str());
+static void QueueDefaultRoute(nr::ue::tun::RtNetlink &netlink, uint32_t ifIndex, uint32_t tableId)
+{
+    // Replaces the default route of a previous session on the same interface
+    rtmsg routeMsg{};
+    routeMsg.rtm_family = AF_INET;
+    routeMsg.rtm_table = HeaderTable(tableId);
+    routeMsg.rtm_protocol = RTPROT_BOOT;
+    routeMsg.rtm_scope = RT_SCOPE_LINK;
+    routeMsg.rtm_type = RTN_UNICAST;
+    netlink.begin(RTM_NEWROUTE, NLM_F_CREATE | NLM_F_REPLACE, &routeMsg, sizeof(routeMsg), "add default route");
+    netlink.attributeU32(RTA_OIF, ifIndex);
+    netlink.attributeU32(RTA_TABLE, tableId);
 }
 
 namespace nr::ue::tun
 {
 
-int AllocateTun(const char *ifPrefix, char **allocatedName)
+int AllocateTun(const char *ifPrefix, bool offload, char **allocatedName)
 {
     // acquire the configuration lock
     const std::lock_guard<std::mutex> lock(configMutex);
@@ -321,51 +336,133 @@ int AllocateTun(const char *ifPrefix, char **allocatedName)
     if (!ifName)
         throw LibError("TUN interface name could not be allocated.", errno);
 
-    char tunName[IFNAMSIZ];
-    strcpy(tunName, ifName);
+    int fd = OpenTunQueue(ifName, IFF_TUN | IFF_NO_PI, offload);
 
-    ifreq ifr{};
-    int fd;
+    *allocatedName = strdup(ifName);
+    return fd;
+}
 
-    if ((fd = open("/dev/net/tun", O_RDWR)) < 0)
-        throw LibError("Open failure /dev/net/tun");
+std::vector<int> AllocateMultiQueueTun(const char *ifPrefix, int queueCount, bool offload, std::string &allocatedName)
+{
+    // acquire the configuration lock
+    const std::lock_guard<std::mutex> lock(configMutex);
 
-    memset(&ifr, 0, sizeof(ifr));
+    const char *ifName = NextInterfaceName(ifPrefix);
+    if (!ifName)
+        throw LibError("TUN interface name could not be allocated.", errno);
 
-    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+    // Each TUNSETIFF with the same name attaches another queue to the device
+    std::vector<int> fds{};
+    try
+    {
+        for (int i = 0; i < queueCount; i++)
+            fds.push_back(OpenTunQueue(ifName, IFF_TUN | IFF_NO_PI | IFF_MULTI_QUEUE, offload));
+    }
+    catch (const LibError &)
+    {
+        for (int fd : fds)
+            close(fd);
+        throw;
+    }
 
-    strncpy(ifr.ifr_name, tunName, IFNAMSIZ);
+    allocatedName = ifName;
+    return fds;
+}
 
-    if (ioctl(fd, TUNSETIFF, (void *)&ifr) < 0)
+void ConfigureTun(const char *tunName, const char *ipAddr, int mtu, bool configureRoute)
+{
+    // acquire the configuration lock
+    const std::lock_guard<std::mutex> lock(configMutex);
+
+    auto &netlink = Netlink();
+    uint32_t ifIndex = InterfaceIndex(tunName);
+    in_addr_t address = ParseAddress(ipAddr);
+
+    // Looked up before the batch, since the stale rules are deleted in the same batch
+    std::vector<uint32_t> staleRules{};
+    uint32_t tableId = 0;
+    if (configureRoute)
     {
-        close(fd);
-        throw LibError("ioctl(TUNSETIFF)", errno);
+        tableId = RoutingTableId(ROUTING_TABLE_PREFIX + std::string(tunName));
+        staleRules = FindRulesFrom(netlink, address);
     }
 
-    strcpy(tunName, ifr.ifr_name);
-    if (strcmp(tunName, ifName) != 0)
-        throw LibError("TUN interface name could not be allocated.");
+    // All requests go in a single batch, which the kernel applies in order. The interface must be up before the
+    // route which uses it is added.
+    QueueAddress(netlink, RTM_NEWADDR, ifIndex, address, ClassfulPrefixLength(address));
+    QueueLinkUp(netlink, ifIndex, mtu);
 
-    *allocatedName = strdup(tunName);
-    return fd;
+    if (configureRoute)
+    {
+        QueueDeleteRules(netlink, address, staleRules);
+        QueueRule(netlink, address, tableId);
+        QueueDefaultRoute(netlink, ifIndex, tableId);
+    }
+
+    netlink.commit();
 }
 
-void ConfigureTun(const char *tunName, const char *ipAddr, int mtu, bool configureRoute)
+void ConfigureSharedTun(const char *tunName, int mtu, bool configureRoute)
 {
     // acquire the configuration lock
     const std::lock_guard<std::mutex> lock(configMutex);
 
-    TunSetIpAndUp(tunName, ipAddr, mtu);
+    auto &netlink = Netlink();
+    uint32_t ifIndex = InterfaceIndex(tunName);
+
+    QueueLinkUp(netlink, ifIndex, mtu);
+    if (configureRoute)
+        QueueDefaultRoute(netlink, ifIndex, RoutingTableId(ROUTING_TABLE_PREFIX + std::string(tunName)));
+
+    netlink.commit();
+}
+
+void AddTunAddress(const char *tunName, const char *ipAddr, bool configureRoute)
+{
+    // acquire the configuration lock
+    const std::lock_guard<std::mutex> lock(configMutex);
+
+    auto &netlink = Netlink();
+    uint32_t ifIndex = InterfaceIndex(tunName);
+    in_addr_t address = ParseAddress(ipAddr);
+
+    std::vector<uint32_t> staleRules{};
+    uint32_t tableId = 0;
     if (configureRoute)
     {
-        std::string table_name = ROUTING_TABLE_PREFIX + std::string(tunName);
+        tableId = RoutingTableId(ROUTING_TABLE_PREFIX + std::string(tunName));
+        staleRules = FindRulesFrom(netlink, address);
+    }
 
-        ConfigureRtTables(table_name);
-        RemoveExistingIpRules(ipAddr);
-        AddNewIpRules(ipAddr, table_name);
-        RemoveExistingIpRoutes(tunName, table_name);
-        AddIpRoutes(tunName, table_name);
+    // Host addresses, since the addresses of all the sessions share the interface
+    QueueAddress(netlink, RTM_NEWADDR, ifIndex, address, 32);
+
+    if (configureRoute)
+    {
+        QueueDeleteRules(netlink, address, staleRules);
+        QueueRule(netlink, address, tableId);
     }
+
+    netlink.commit();
+}
+
+void RemoveTunAddress(const char *tunName, const char *ipAddr, bool configureRoute)
+{
+    // acquire the configuration lock
+    const std::lock_guard<std::mutex> lock(configMutex);
+
+    auto &netlink = Netlink();
+    uint32_t ifIndex = InterfaceIndex(tunName);
+    in_addr_t address = ParseAddress(ipAddr);
+
+    std::vector<uint32_t> staleRules{};
+    if (configureRoute)
+        staleRules = FindRulesFrom(netlink, address);
+
+    QueueAddress(netlink, RTM_DELADDR, ifIndex, address, 32);
+    QueueDeleteRules(netlink, address, staleRules);
+
+    netlink.commit();
 }
 
 } // namespace nr::ue::tun
@@ -11,11 +11,20 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace nr::ue::tun
 {
 
-int AllocateTun(const char *ifPrefix, char **allocatedName);
+/* With offloads, packets are read and written with a virtio_net_hdr, see offload.hpp */
+int AllocateTun(const char *ifPrefix, bool offload, char **allocatedName);
 void ConfigureTun(const char *tunName, const char *ipAddr, int mtu, bool configureRoute);
 
+/* A TUN device with the given number of queues, returns the file descriptors of the queues */
+std::vector<int> AllocateMultiQueueTun(const char *ifPrefix, int queueCount, bool offload, std::string &allocatedName);
+/* Brings up a TUN device whose addresses are added per session, with a default route in its routing table */
+void ConfigureSharedTun(const char *tunName, int mtu, bool configureRoute);
+void AddTunAddress(const char *tunName, const char *ipAddr, bool configureRoute);
+void RemoveTunAddress(const char *tunName, const char *ipAddr, bool configureRoute);
+
 } // namespace nr::ue::tun
@@ -0,0 +1,218 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "netlink.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <utils/libc_error.hpp>
+
+static constexpr const size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+static constexpr const int RECEIVE_TIMEOUT_SECONDS = 5;
+
+namespace nr::ue::tun
+{
+
+RtNetlink::RtNetlink() : m_fd{-1}, m_sequence{}, m_batch{}, m_current{}, m_pending{}, m_receiveBuffer{}
+{
+    m_fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (m_fd < 0)
+        throw LibError("socket(NETLINK_ROUTE)", errno);
+
+    sockaddr_nl local{};
+    local.nl_family = AF_NETLINK;
+    if (::bind(m_fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0)
+    {
+        int err = errno;
+        ::close(m_fd);
+        throw LibError("bind(NETLINK_ROUTE)", err);
+    }
+
+    // An acknowledgement is never expected to be lost, but a stuck configuration must not block the UE forever
+    timeval timeout{};
+    timeout.tv_sec = RECEIVE_TIMEOUT_SECONDS;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    m_receiveBuffer.resize(RECEIVE_BUFFER_SIZE);
+}
+
+RtNetlink::~RtNetlink()
+{
+    ::close(m_fd);
+}
+
+void RtNetlink::begin(uint16_t type, uint16_t flags, const void *header, size_t headerLength, std::string description,
+                      int ignoredError)
+{
+    m_current = m_batch.size();
+    m_batch.resize(m_current + NLMSG_SPACE(headerLength));
+
+    auto *msg = reinterpret_cast<nlmsghdr *>(&m_batch[m_current]);
+    msg->nlmsg_len = NLMSG_LENGTH(headerLength);
+    msg->nlmsg_type = type;
+    msg->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+    msg->nlmsg_seq = ++m_sequence;
+    msg->nlmsg_pid = 0;
+    std::memcpy(NLMSG_DATA(msg), header, headerLength);
+
+    m_pending.push_back(Pending{msg->nlmsg_seq, ignoredError, std::move(description)});
+}
+
+void RtNetlink::attribute(uint16_t type, const void *data, size_t length)
+{
+    size_t offset = m_current + NLMSG_ALIGN(reinterpret_cast<nlmsghdr *>(&m_batch[m_current])->nlmsg_len);
+    m_batch.resize(offset + RTA_SPACE(length));
+
+    auto *attr = reinterpret_cast<rtattr *>(&m_batch[offset]);
+    attr->rta_type = type;
+    attr->rta_len = static_cast<unsigned short>(RTA_LENGTH(length));
+    std::memcpy(RTA_DATA(attr), data, length);
+
+    reinterpret_cast<nlmsghdr *>(&m_batch[m_current])->nlmsg_len = static_cast<uint32_t>(m_batch.size() - m_current);
+}
+
+void RtNetlink::attributeU32(uint16_t type, uint32_t value)
+{
+    attribute(type, &value, sizeof(value));
+}
+
+void RtNetlink::commit()
+{
+    if (m_pending.empty())
+        return;
+
+    auto pending = std::move(m_pending);
+    m_pending.clear();
+
+    try
+    {
+        send();
+    }
+    catch (...)
+    {
+        m_batch.clear();
+        throw;
+    }
+    m_batch.clear();
+
+    // The kernel keeps handling the batch after a failed request, so all acknowledgements are drained before
+    // reporting the first failure
+    size_t acknowledged = 0;
+    const Pending *failed = nullptr;
+    int failedError = 0;
+
+    while (acknowledged < pending.size())
+    {
+        int length = static_cast<int>(receive());
+        for (auto *msg = reinterpret_cast<nlmsghdr *>(m_receiveBuffer.data()); NLMSG_OK(msg, length);
+             msg = NLMSG_NEXT(msg, length))
+        {
+            if (msg->nlmsg_type != NLMSG_ERROR)
+                continue;
+
+            uint32_t index = msg->nlmsg_seq - pending[0].sequence;
+            if (index >= pending.size())
+                continue;
+
+            acknowledged++;
+
+            int error = -reinterpret_cast<nlmsgerr *>(NLMSG_DATA(msg))->error;
+            if (error != 0 && error != pending[index].ignoredError && failed == nullptr)
+            {
+                failed = &pending[index];
+                failedError = error;
+            }
+        }
+    }
+
+    if (failed != nullptr)
+        throw LibError("Netlink request failed: " + failed->description, failedError);
+}
+
+void RtNetlink::dump(uint16_t type, const void *header, size_t headerLength,
+                     const std::function<void(const nlmsghdr *)> &visitor)
+{
+    if (!m_pending.empty())
+        throw LibError("Netlink dump requested while a batch is pending");
+
+    m_batch.resize(NLMSG_SPACE(headerLength));
+
+    auto *request = reinterpret_cast<nlmsghdr *>(m_batch.data());
+    request->nlmsg_len = NLMSG_LENGTH(headerLength);
+    request->nlmsg_type = type;
+    request->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request->nlmsg_seq = ++m_sequence;
+    request->nlmsg_pid = 0;
+    std::memcpy(NLMSG_DATA(request), header, headerLength);
+
+    uint32_t sequence = request->nlmsg_seq;
+
+    try
+    {
+        send();
+    }
+    catch (...)
+    {
+        m_batch.clear();
+        throw;
+    }
+    m_batch.clear();
+
+    while (true)
+    {
+        int length = static_cast<int>(receive());
+        for (auto *msg = reinterpret_cast<nlmsghdr *>(m_receiveBuffer.data()); NLMSG_OK(msg, length);
+             msg = NLMSG_NEXT(msg, length))
+        {
+            if (msg->nlmsg_seq != sequence)
+                continue;
+            if (msg->nlmsg_type == NLMSG_DONE)
+                return;
+            if (msg->nlmsg_type == NLMSG_ERROR)
+                throw LibError("Netlink dump failed", -reinterpret_cast<nlmsgerr *>(NLMSG_DATA(msg))->error);
+
+            visitor(msg);
+        }
+    }
+}
+
+void RtNetlink::send()
+{
+    sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+
+    ssize_t res;
+    do
+    {
+        res = ::sendto(m_fd, m_batch.data(), m_batch.size(), 0, reinterpret_cast<sockaddr *>(&kernel), sizeof(kernel));
+    } while (res < 0 && errno == EINTR);
+
+    if (res < 0)
+        throw LibError("sendto(NETLINK_ROUTE)", errno);
+}
+
+size_t RtNetlink::receive()
+{
+    ssize_t res;
+    do
+    {
+        res = ::recv(m_fd, m_receiveBuffer.data(), m_receiveBuffer.size(), 0);
+    } while (res < 0 && errno == EINTR);
+
+    if (res < 0)
+        throw LibError("recv(NETLINK_ROUTE)", errno);
+    return static_cast<size_t>(res);
+}
+
+} // namespace nr::ue::tun
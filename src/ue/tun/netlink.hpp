@@ -0,0 +1,68 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct nlmsghdr;
+
+namespace nr::ue::tun
+{
+
+/* A NETLINK_ROUTE socket. Requests are batched and sent with a single sendmsg, the kernel handles them in order and
+ * acknowledges each one. Throws LibError on failures. Not thread safe. */
+class RtNetlink
+{
+  private:
+    struct Pending
+    {
+        uint32_t sequence;
+        int ignoredError; // errno which does not fail the request, e.g. ENOENT for deletions
+        std::string description;
+    };
+
+    int m_fd;
+    uint32_t m_sequence;
+    std::vector<uint8_t> m_batch;
+    size_t m_current; // Offset of the request being built
+    std::vector<Pending> m_pending;
+    std::vector<uint8_t> m_receiveBuffer;
+
+  public:
+    RtNetlink();
+    ~RtNetlink();
+
+    RtNetlink(const RtNetlink &) = delete;
+    RtNetlink &operator=(const RtNetlink &) = delete;
+
+  public:
+    /* Starts a new request in the batch with the given family header, e.g. ifaddrmsg for RTM_NEWADDR */
+    void begin(uint16_t type, uint16_t flags, const void *header, size_t headerLength, std::string description,
+               int ignoredError = 0);
+    /* Appends an attribute to the request being built */
+    void attribute(uint16_t type, const void *data, size_t length);
+    void attributeU32(uint16_t type, uint32_t value);
+
+    /* Sends the batched requests and waits for all acknowledgements, throws for the first request failed */
+    void commit();
+
+    /* Sends a dump request and calls the visitor for each message of the reply */
+    void dump(uint16_t type, const void *header, size_t headerLength,
+              const std::function<void(const nlmsghdr *)> &visitor);
+
+  private:
+    void send();
+    size_t receive();
+};
+
+} // namespace nr::ue::tun
@@ -0,0 +1,348 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "offload.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+
+/* virtio_net_hdr of <linux/virtio_net.h>, which does not compile as C++. In the byte order of the host for TUN. */
+struct VnetHeader
+{
+    uint8_t flags;
+    uint8_t gsoType;
+    uint16_t hdrLen;
+    uint16_t gsoSize;
+    uint16_t csumStart;
+    uint16_t csumOffset;
+};
+
+static_assert(sizeof(VnetHeader) == nr::ue::tun::VNET_HEADER_SIZE);
+
+static constexpr const uint8_t VNET_F_NEEDS_CSUM = 1;
+static constexpr const uint8_t VNET_F_DATA_VALID = 2;
+static constexpr const uint8_t VNET_GSO_NONE = 0;
+static constexpr const uint8_t VNET_GSO_TCPV4 = 1;
+static constexpr const uint8_t VNET_GSO_ECN = 0x80;
+
+static constexpr const size_t IPV4_HEADER_SIZE = 20;
+static constexpr const size_t TCP_HEADER_MIN_SIZE = 20;
+static constexpr const uint8_t IP_PROTOCOL_TCP = 6;
+
+static constexpr const uint8_t TCP_FIN = 0x01;
+static constexpr const uint8_t TCP_PSH = 0x08;
+static constexpr const uint8_t TCP_ACK = 0x10;
+static constexpr const uint8_t TCP_CWR = 0x80;
+
+static constexpr const size_t TCP_SEQ_OFFSET = 4;
+static constexpr const size_t TCP_FLAGS_OFFSET = 13;
+static constexpr const size_t TCP_CHECKSUM_OFFSET = 16;
+
+static constexpr const size_t MAX_COALESCED_SEGMENTS = 64;
+
+static uint16_t Get16(const uint8_t *p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static uint32_t Get32(const uint8_t *p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+static void Put16(uint8_t *p, uint32_t value)
+{
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+static void Put32(uint8_t *p, uint32_t value)
+{
+    Put16(p, value >> 16);
+    Put16(p + 2, value);
+}
+
+/* Ones' complement sum of RFC 1071. The words are summed as they are in memory, which gives the checksum as it is in
+ * memory regardless of the byte order of the host, so the values summed with it must be in network byte order too. */
+static uint64_t Sum(const uint8_t *data, size_t length, uint64_t sum = 0)
+{
+    for (; length >= 2; data += 2, length -= 2)
+    {
+        uint16_t word;
+        std::memcpy(&word, data, sizeof(word));
+        sum += word;
+    }
+    if (length > 0)
+    {
+        uint8_t last[2] = {data[0], 0};
+        uint16_t word;
+        std::memcpy(&word, last, sizeof(word));
+        sum += word;
+    }
+    return sum;
+}
+
+static uint16_t Fold(uint64_t sum)
+{
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<uint16_t>(sum);
+}
+
+static void StoreChecksum(uint8_t *p, uint16_t checksum)
+{
+    std::memcpy(p, &checksum, sizeof(checksum));
+}
+
+static uint64_t PseudoHeaderSum(const uint8_t *ipHeader, size_t l4Length)
+{
+    return Sum(ipHeader + 12, 8, htons(static_cast<uint16_t>(l4Length)) + htons(IP_PROTOCOL_TCP));
+}
+
+static void SetIpv4Checksum(uint8_t *ipHeader, size_t headerLength)
+{
+    StoreChecksum(ipHeader + 10, 0);
+    StoreChecksum(ipHeader + 10, static_cast<uint16_t>(~Fold(Sum(ipHeader, headerLength))));
+}
+
+static void SetTcpChecksum(uint8_t *ipHeader, size_t ipHeaderLength, size_t l4Length)
+{
+    uint8_t *tcp = ipHeader + ipHeaderLength;
+    StoreChecksum(tcp + TCP_CHECKSUM_OFFSET, 0);
+    StoreChecksum(tcp + TCP_CHECKSUM_OFFSET,
+                  static_cast<uint16_t>(~Fold(Sum(tcp, l4Length, PseudoHeaderSum(ipHeader, l4Length)))));
+}
+
+static bool IsTcpChecksumValid(const uint8_t *ipHeader, size_t ipHeaderLength, size_t l4Length)
+{
+    return Fold(Sum(ipHeader + ipHeaderLength, l4Length, PseudoHeaderSum(ipHeader, l4Length))) == 0xFFFF;
+}
+
+/* Headers of an IPv4 TCP packet, zero if malformed */
+static size_t TcpHeadersLength(const uint8_t *data, size_t length)
+{
+    if (length < IPV4_HEADER_SIZE + TCP_HEADER_MIN_SIZE || (data[0] >> 4) != 4 || data[9] != IP_PROTOCOL_TCP)
+        return 0;
+
+    size_t ipHeaderLength = (data[0] & 0xF) * 4u;
+    if (ipHeaderLength < IPV4_HEADER_SIZE || ipHeaderLength + TCP_HEADER_MIN_SIZE > length)
+        return 0;
+
+    size_t tcpHeaderLength = (data[ipHeaderLength + 12] >> 4) * 4u;
+    if (tcpHeaderLength < TCP_HEADER_MIN_SIZE || ipHeaderLength + tcpHeaderLength > length)
+        return 0;
+
+    return ipHeaderLength + tcpHeaderLength;
+}
+
+/* A segment of a bulk transfer, which GRO would merge: no IP options or fragments, only ACK and PSH flags, and some
+ * payload */
+static bool IsMergeable(const uint8_t *data, size_t length)
+{
+    size_t headersLength = TcpHeadersLength(data, length);
+    if (headersLength == 0 || headersLength == length || data[0] != 0x45 || Get16(data + 2) != length)
+        return false;
+    if ((Get16(data + 6) & 0x3FFF) != 0)
+        return false;
+    return (data[IPV4_HEADER_SIZE + TCP_FLAGS_OFFSET] & ~TCP_PSH) == TCP_ACK;
+}
+
+namespace nr::ue::tun
+{
+
+PacketOffload ParseVnetHeader(const uint8_t *header)
+{
+    VnetHeader hdr{};
+    std::memcpy(&hdr, header, sizeof(hdr));
+
+    PacketOffload offload{};
+    offload.gsoType = static_cast<uint8_t>(hdr.gsoType & ~VNET_GSO_ECN);
+    offload.gsoSize = hdr.gsoSize;
+    offload.needsChecksum = (hdr.flags & VNET_F_NEEDS_CSUM) != 0;
+    offload.checksumStart = hdr.csumStart;
+    offload.checksumOffset = hdr.csumOffset;
+    return offload;
+}
+
+bool SegmentPacket(OctetString &&packet, const PacketOffload &offload, std::vector<OctetString> &segments)
+{
+    size_t length = static_cast<size_t>(packet.length());
+    uint8_t *data = packet.data();
+
+    if (offload.gsoType == VNET_GSO_NONE)
+    {
+        if (offload.needsChecksum)
+        {
+            size_t start = offload.checksumStart;
+            size_t field = start + offload.checksumOffset;
+            if (field + 2 > length)
+                return false;
+
+            // The field holds the sum of the pseudo header already
+            auto checksum = static_cast<uint16_t>(~Fold(Sum(data + start, length - start)));
+            StoreChecksum(data + field, checksum == 0 ? 0xFFFF : checksum);
+        }
+        segments.push_back(std::move(packet));
+        return true;
+    }
+
+    // Only TCPv4 segmentation is enabled on the device
+    size_t headersLength = TcpHeadersLength(data, length);
+    if (offload.gsoType != VNET_GSO_TCPV4 || headersLength == 0 || offload.gsoSize == 0)
+        return false;
+
+    size_t ipHeaderLength = (data[0] & 0xF) * 4u;
+    size_t payloadLength = length - headersLength;
+    uint16_t id = Get16(data + 4);
+    uint32_t sequence = Get32(data + ipHeaderLength + TCP_SEQ_OFFSET);
+    uint8_t flags = data[ipHeaderLength + TCP_FLAGS_OFFSET];
+
+    for (size_t offset = 0; offset < payloadLength || offset == 0; offset += offload.gsoSize)
+    {
+        size_t segmentPayload = std::min<size_t>(offload.gsoSize, payloadLength - offset);
+        bool isLast = offset + segmentPayload >= payloadLength;
+
+        auto segment = OctetString::FromSpare(static_cast<int>(headersLength + segmentPayload));
+        uint8_t *s = segment.data();
+        std::memcpy(s, data, headersLength);
+        std::memcpy(s + headersLength, data + headersLength + offset, segmentPayload);
+
+        Put16(s + 2, static_cast<uint32_t>(headersLength + segmentPayload));
+        Put16(s + 4, id++);
+        SetIpv4Checksum(s, ipHeaderLength);
+
+        uint8_t *tcp = s + ipHeaderLength;
+        Put32(tcp + TCP_SEQ_OFFSET, sequence + static_cast<uint32_t>(offset));
+        uint8_t segmentFlags = flags;
+        if (!isLast)
+            segmentFlags &= ~(TCP_FIN | TCP_PSH);
+        if (offset > 0)
+            segmentFlags &= ~TCP_CWR;
+        tcp[TCP_FLAGS_OFFSET] = segmentFlags;
+        SetTcpChecksum(s, ipHeaderLength, headersLength - ipHeaderLength + segmentPayload);
+
+        segments.push_back(std::move(segment));
+
+        if (isLast)
+            break;
+    }
+
+    return true;
+}
+
+SegmentCoalescer::SegmentCoalescer()
+    : m_packet{}, m_output{}, m_segmentCount{}, m_segmentSize{}, m_verified{}, m_closed{}
+{
+}
+
+bool SegmentCoalescer::add(const uint8_t *data, size_t length)
+{
+    if (m_packet.empty())
+    {
+        m_packet.assign(data, data + length);
+        m_segmentCount = 1;
+        m_verified = IsMergeable(data, length) && IsTcpChecksumValid(data, IPV4_HEADER_SIZE, length - IPV4_HEADER_SIZE);
+        m_segmentSize = m_verified ? length - TcpHeadersLength(data, length) : 0;
+        m_closed = !m_verified || (data[IPV4_HEADER_SIZE + TCP_FLAGS_OFFSET] & TCP_PSH) != 0;
+        return true;
+    }
+
+    if (!continues(data, length))
+        return false;
+
+    size_t headersLength = TcpHeadersLength(data, length);
+    size_t payloadLength = length - headersLength;
+    m_packet.insert(m_packet.end(), data + headersLength, data + length);
+    m_segmentCount++;
+
+    uint8_t flags = data[IPV4_HEADER_SIZE + TCP_FLAGS_OFFSET];
+    if (payloadLength < m_segmentSize || (flags & TCP_PSH) != 0)
+    {
+        m_packet[IPV4_HEADER_SIZE + TCP_FLAGS_OFFSET] |= flags & TCP_PSH;
+        m_closed = true;
+    }
+    return true;
+}
+
+bool SegmentCoalescer::continues(const uint8_t *data, size_t length) const
+{
+    if (m_closed || m_segmentCount >= MAX_COALESCED_SEGMENTS || !IsMergeable(data, length))
+        return false;
+
+    size_t headersLength = TcpHeadersLength(data, length);
+    const uint8_t *first = m_packet.data();
+
+    if (headersLength != TcpHeadersLength(first, m_packet.size()) || length - headersLength > m_segmentSize ||
+        m_packet.size() + length - headersLength > MAX_OFFLOAD_PACKET_SIZE)
+        return false;
+
+    // The IP headers may differ only in length, ID and checksum
+    if (data[1] != first[1] || std::memcmp(data + 6, first + 6, 4) != 0 || std::memcmp(data + 12, first + 12, 8) != 0)
+        return false;
+
+    // The TCP headers only in sequence number, PSH flag and checksum, and the payload must follow in order
+    const uint8_t *tcp = data + IPV4_HEADER_SIZE;
+    const uint8_t *firstTcp = first + IPV4_HEADER_SIZE;
+    if (std::memcmp(tcp, firstTcp, 4) != 0 || std::memcmp(tcp + 8, firstTcp + 8, 5) != 0 ||
+        std::memcmp(tcp + 14, firstTcp + 14, 2) != 0 ||
+        std::memcmp(tcp + 18, firstTcp + 18, headersLength - IPV4_HEADER_SIZE - 18) != 0)
+        return false;
+    if (Get32(tcp + TCP_SEQ_OFFSET) !=
+        Get32(firstTcp + TCP_SEQ_OFFSET) + static_cast<uint32_t>(m_packet.size() - headersLength))
+        return false;
+
+    // The checksum is not kept for the merged packet, it is verified here instead of the kernel
+    return IsTcpChecksumValid(data, IPV4_HEADER_SIZE, length - IPV4_HEADER_SIZE);
+}
+
+bool SegmentCoalescer::isEmpty() const
+{
+    return m_packet.empty();
+}
+
+SegmentCoalescer::Output SegmentCoalescer::flush()
+{
+    m_output.swap(m_packet);
+    m_packet.clear();
+
+    VnetHeader hdr{};
+    uint8_t *data = m_output.data();
+
+    if (m_segmentCount > 1)
+    {
+        size_t headersLength = TcpHeadersLength(data, m_output.size());
+        size_t l4Length = m_output.size() - IPV4_HEADER_SIZE;
+
+        Put16(data + 2, static_cast<uint32_t>(m_output.size()));
+        SetIpv4Checksum(data, IPV4_HEADER_SIZE);
+
+        // The kernel completes the checksum of each segment from the sum of the pseudo header of the whole packet
+        StoreChecksum(data + IPV4_HEADER_SIZE + TCP_CHECKSUM_OFFSET, Fold(PseudoHeaderSum(data, l4Length)));
+
+        hdr.flags = VNET_F_NEEDS_CSUM;
+        hdr.gsoType = VNET_GSO_TCPV4;
+        hdr.hdrLen = static_cast<uint16_t>(headersLength);
+        hdr.gsoSize = static_cast<uint16_t>(m_segmentSize);
+        hdr.csumStart = static_cast<uint16_t>(IPV4_HEADER_SIZE);
+        hdr.csumOffset = static_cast<uint16_t>(TCP_CHECKSUM_OFFSET);
+    }
+    else if (m_verified)
+    {
+        hdr.flags = VNET_F_DATA_VALID;
+    }
+
+    Output output{};
+    std::memcpy(output.vnetHeader, &hdr, sizeof(hdr));
+    output.data = data;
+    output.length = m_output.size();
+    return output;
+}
+
+} // namespace nr::ue::tun
@@ -0,0 +1,84 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <utils/octet_string.hpp>
+
+namespace nr::ue::tun
+{
+
+/* Size of the virtio_net_hdr preceding each packet on a TUN device opened with IFF_VNET_HDR */
+static constexpr const size_t VNET_HEADER_SIZE = 10;
+
+/* The largest packet crossing the TUN boundary, i.e. a GSO packet of the kernel */
+static constexpr const size_t MAX_OFFLOAD_PACKET_SIZE = 65535;
+
+/* Offloads of a packet read from a TUN device, as given by its virtio_net_hdr. The kernel leaves the checksum of the
+ * transport header incomplete, and hands a TCP (or UDP with UDP_SEGMENT) burst of the host as one packet up to 64 KB
+ * instead of segments of MTU size. Both are completed by SegmentPacket before the packet leaves the UE. */
+struct PacketOffload
+{
+    uint8_t gsoType{}; // VIRTIO_NET_HDR_GSO_*
+    uint16_t gsoSize{};
+    bool needsChecksum{};
+    uint16_t checksumStart{};
+    uint16_t checksumOffset{};
+
+    [[nodiscard]] bool isEmpty() const
+    {
+        return gsoType == 0 && !needsChecksum;
+    }
+};
+
+PacketOffload ParseVnetHeader(const uint8_t *header);
+
+/* Completes the checksum and cuts the packet into segments of the MTU as given by its offloads. Returns false and
+ * appends nothing for a packet whose headers do not match its offloads. */
+bool SegmentPacket(OctetString &&packet, const PacketOffload &offload, std::vector<OctetString> &segments);
+
+/* Merges consecutive in-order IPv4 TCP segments of the same flow into one GSO packet, so that a burst of the downlink
+ * crosses the TUN boundary in a single write, like GRO of a network card. */
+class SegmentCoalescer
+{
+  public:
+    struct Output
+    {
+        uint8_t vnetHeader[VNET_HEADER_SIZE];
+        const uint8_t *data;
+        size_t length;
+    };
+
+  private:
+    std::vector<uint8_t> m_packet; // The packet being merged, headers of the first segment
+    std::vector<uint8_t> m_output; // The last flushed packet
+    size_t m_segmentCount;
+    size_t m_segmentSize;
+    bool m_verified; // Checksums of all the segments are verified
+    bool m_closed;   // A segment shorter than the first or with PSH, nothing can follow
+
+  public:
+    SegmentCoalescer();
+
+  public:
+    /* Returns false if the packet does not continue the pending one, which must be flushed before adding it again.
+     * Packets which cannot be merged are flushed as they are. */
+    bool add(const uint8_t *data, size_t length);
+    [[nodiscard]] bool isEmpty() const;
+    /* The merged packet, valid until the next call to add */
+    Output flush();
+
+  private:
+    bool continues(const uint8_t *data, size_t length) const;
+};
+
+} // namespace nr::ue::tun
@@ -0,0 +1,159 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "shared.hpp"
+#include "config.hpp"
+#include "offload.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <ue/nts.hpp>
+#include <utils/constants.hpp>
+#include <utils/libc_error.hpp>
+
+static constexpr const size_t RECEIVER_BUFFER_SIZE =
+    nr::ue::tun::VNET_HEADER_SIZE + nr::ue::tun::MAX_OFFLOAD_PACKET_SIZE;
+static constexpr const size_t IPV4_HEADER_MIN_SIZE = 20;
+static constexpr const size_t IPV4_SOURCE_OFFSET = 12;
+
+namespace nr::ue
+{
+
+SharedTun::SharedTun(LogBase *logBase, int queueCount, int mtu, bool offload, bool configureRouting)
+    : m_logger{logBase->makeUniqueLogger("tun")}, m_name{}, m_offload{offload}, m_configureRouting{configureRouting},
+      m_queues{}, m_readers{}, m_nextWriteQueue{}, m_mutex{}, m_sessions{}
+{
+    m_queues = tun::AllocateMultiQueueTun(cons::TunNamePrefix, queueCount, offload, m_name);
+    tun::ConfigureSharedTun(m_name.c_str(), mtu, configureRouting);
+
+    for (int fd : m_queues)
+    {
+        auto *args = new ReaderArgs{this, fd};
+        m_readers.push_back(std::make_unique<ScopedThread>(&SharedTun::ReaderThread, args));
+    }
+
+    m_logger->info(FMT_STRING("Shared TUN interface[{}] is up with {} queues"), m_name, queueCount);
+}
+
+const std::string &SharedTun::name() const
+{
+    return m_name;
+}
+
+void SharedTun::addSession(const std::string &ipAddress, NtsTask *appTask, int psi, MemoryTag memoryTag)
+{
+    tun::AddTunAddress(m_name.c_str(), ipAddress.c_str(), m_configureRouting);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sessions[inet_addr(ipAddress.c_str())] = Session{appTask, psi, memoryTag};
+}
+
+void SharedTun::removeSession(const std::string &ipAddress)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sessions.erase(inet_addr(ipAddress.c_str()));
+    }
+
+    try
+    {
+        tun::RemoveTunAddress(m_name.c_str(), ipAddress.c_str(), m_configureRouting);
+    }
+    catch (const LibError &e)
+    {
+        m_logger->err(FMT_STRING("TUN address[{}] could not be removed [{}]"), ipAddress, e.what());
+    }
+}
+
+void SharedTun::write(const uint8_t *data, size_t size)
+{
+    // Each thread sticks to a queue, the shared threads of the host get distinct queues as long as there are enough
+    static thread_local int t_queue = -1;
+    if (t_queue < 0)
+        t_queue = static_cast<int>(m_nextWriteQueue++ % m_queues.size());
+
+    ssize_t res;
+    size_t expected = size;
+    if (m_offload)
+    {
+        // Written as they are, with their checksums complete
+        static const uint8_t s_noOffloads[tun::VNET_HEADER_SIZE] = {};
+        iovec iov[2] = {{const_cast<uint8_t *>(s_noOffloads), tun::VNET_HEADER_SIZE},
+                        {const_cast<uint8_t *>(data), size}};
+        res = ::writev(m_queues[t_queue], iov, 2);
+        expected += tun::VNET_HEADER_SIZE;
+    }
+    else
+    {
+        res = ::write(m_queues[t_queue], data, size);
+    }
+
+    if (res < 0)
+        m_logger->err(FMT_STRING("TUN device could not write ({})"), strerror(errno));
+    else if (static_cast<size_t>(res) != expected)
+        m_logger->err("TUN device partially written");
+}
+
+void SharedTun::ReaderThread(void *args)
+{
+    auto *readerArgs = reinterpret_cast<ReaderArgs *>(args);
+    SharedTun *tun = readerArgs->tun;
+    int fd = readerArgs->fd;
+    delete readerArgs;
+
+    tun->readerLoop(fd);
+}
+
+void SharedTun::readerLoop(int fd)
+{
+    size_t headerSize = m_offload ? tun::VNET_HEADER_SIZE : 0;
+    std::vector<uint8_t> buffer(RECEIVER_BUFFER_SIZE);
+
+    while (true)
+    {
+        ssize_t n = ::read(fd, buffer.data(), buffer.size());
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            m_logger->err(FMT_STRING("TUN device could not read ({}), queue is abandoned"), strerror(errno));
+            return;
+        }
+
+        // Only IPv4 sessions are supported, like the devices per session
+        const uint8_t *packet = buffer.data() + headerSize;
+        if (static_cast<size_t>(n) < headerSize + IPV4_HEADER_MIN_SIZE || (packet[0] >> 4) != 4)
+            continue;
+        size_t length = static_cast<size_t>(n) - headerSize;
+
+        uint32_t source;
+        std::memcpy(&source, packet + IPV4_SOURCE_OFFSET, sizeof(source));
+
+        // Pushed under the lock, so that the app task is not deleted in between
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_sessions.find(source);
+        if (it == m_sessions.end())
+            continue;
+
+        MemoryTagScope tagScope{it->second.memoryTag};
+
+        auto *m = new NmUeTunToApp(NmUeTunToApp::DATA_PDU_DELIVERY);
+        m->psi = it->second.psi;
+        m->data = OctetString::FromArray(packet, length);
+        if (m_offload)
+            m->offload = tun::ParseVnetHeader(buffer.data());
+        it->second.appTask->push(m);
+    }
+}
+
+} // namespace nr::ue
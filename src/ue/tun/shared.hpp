@@ -0,0 +1,81 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/logger.hpp>
+#include <utils/memory.hpp>
+#include <utils/nts.hpp>
+#include <utils/scoped_thread.hpp>
+
+namespace nr::ue
+{
+
+/* A multi-queue TUN device shared by the PDU sessions of all UEs of the process, in place of a device per session.
+ * Each session adds its address to the device. Uplink packets are read by a thread per queue and dispatched to the app
+ * task of the session by their source address. Downlink packets are written to a queue of the calling thread, so that
+ * the shared threads of the host do not contend on the queues. Never destroyed. */
+class SharedTun
+{
+  private:
+    struct Session
+    {
+        NtsTask *appTask{};
+        int psi{};
+        MemoryTag memoryTag{};
+    };
+
+    struct ReaderArgs
+    {
+        SharedTun *tun{};
+        int fd{};
+    };
+
+  private:
+    std::unique_ptr<Logger> m_logger;
+    std::string m_name;
+    bool m_offload;
+    bool m_configureRouting;
+    std::vector<int> m_queues;
+    std::vector<std::unique_ptr<ScopedThread>> m_readers;
+    std::atomic<size_t> m_nextWriteQueue;
+    std::mutex m_mutex;
+    std::unordered_map<uint32_t, Session> m_sessions; // By the IPv4 address in network byte order
+
+  public:
+    /* Allocates and brings up the device, throws LibError */
+    SharedTun(LogBase *logBase, int queueCount, int mtu, bool offload, bool configureRouting);
+
+    SharedTun(const SharedTun &) = delete;
+    SharedTun &operator=(const SharedTun &) = delete;
+
+  public:
+    [[nodiscard]] const std::string &name() const;
+
+    /* Adds the address of the session to the device, throws LibError */
+    void addSession(const std::string &ipAddress, NtsTask *appTask, int psi, MemoryTag memoryTag);
+    /* No packets are dispatched to the session once this returns */
+    void removeSession(const std::string &ipAddress);
+
+    void write(const uint8_t *data, size_t size);
+
+  private:
+    static void ReaderThread(void *args);
+    void readerLoop(int fd);
+};
+
+} // namespace nr::ue
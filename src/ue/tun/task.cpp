@@ -8,20 +8,27 @@
 
 #include "task.hpp"
 #include <cstring>
+#include <sys/uio.h>
 #include <ue/app/task.hpp>
 #include <ue/nts.hpp>
 #include <unistd.h>
 #include <utils/libc_error.hpp>
 #include <utils/scoped_thread.hpp>
 
-// TODO: May be reduced to MTU 1500
-#define RECEIVER_BUFFER_SIZE 8000
+// Large enough for a GSO packet of the kernel when offloads are enabled
+static constexpr const size_t RECEIVER_BUFFER_SIZE =
+    nr::ue::tun::VNET_HEADER_SIZE + nr::ue::tun::MAX_OFFLOAD_PACKET_SIZE;
+
+// Downlink packets queued at once are written in a single pass, merged where possible
+static constexpr const int MAX_WRITE_BATCH = 64;
 
 struct ReceiverArgs
 {
     int fd{};
     int psi{};
+    bool offload{};
     NtsTask *targetTask{};
+    MemoryTag memoryTag{};
 };
 
 static std::string GetErrorMessage(const std::string &cause)
@@ -46,26 +53,32 @@ static void ReceiverThread(ReceiverArgs *args)
 {
     int fd = args->fd;
     int psi = args->psi;
+    size_t headerSize = args->offload ? nr::ue::tun::VNET_HEADER_SIZE : 0;
     NtsTask *targetTask = args->targetTask;
 
+    // The received PDUs are charged to the task like its own allocations
+    SetThreadMemoryTag(args->memoryTag);
+
     delete args;
 
-    uint8_t buffer[RECEIVER_BUFFER_SIZE];
+    std::vector<uint8_t> buffer(RECEIVER_BUFFER_SIZE);
 
     while (true)
     {
-        ssize_t n = ::read(fd, buffer, RECEIVER_BUFFER_SIZE);
+        ssize_t n = ::read(fd, buffer.data(), buffer.size());
         if (n < 0)
         {
             targetTask->push(NmError(GetErrorMessage("TUN device could not read")));
             return; // Abort receiver thread
         }
 
-        if (n > 0)
+        if (static_cast<size_t>(n) > headerSize)
         {
             auto *m = new nr::ue::NmUeTunToApp(nr::ue::NmUeTunToApp::DATA_PDU_DELIVERY);
             m->psi = psi;
-            m->data = OctetString::FromArray(buffer, static_cast<size_t>(n));
+            m->data = OctetString::FromArray(buffer.data() + headerSize, static_cast<size_t>(n) - headerSize);
+            if (headerSize > 0)
+                m->offload = nr::ue::tun::ParseVnetHeader(buffer.data());
             targetTask->push(m);
         }
     }
@@ -74,7 +87,8 @@ static void ReceiverThread(ReceiverArgs *args)
 namespace nr::ue
 {
 
-ue::TunTask::TunTask(TaskBase *base, int psi, int fd) : m_base{base}, m_psi{psi}, m_fd{fd}, m_receiver{}
+ue::TunTask::TunTask(TaskBase *base, int psi, int fd, bool offload)
+    : m_base{base}, m_psi{psi}, m_fd{fd}, m_offload{offload}, m_receiver{}, m_coalescer{}
 {
 }
 
@@ -84,6 +98,8 @@ void TunTask::onStart()
     receiverArgs->fd = m_fd;
     receiverArgs->targetTask = this;
     receiverArgs->psi = m_psi;
+    receiverArgs->offload = m_offload;
+    receiverArgs->memoryTag = GetThreadMemoryTag();
     m_receiver =
         new ScopedThread([](void *args) { ReceiverThread(reinterpret_cast<ReceiverArgs *>(args)); }, receiverArgs);
 }
@@ -103,13 +119,7 @@ void TunTask::onLoop()
     switch (msg->msgType)
     {
     case NtsMessageType::UE_APP_TO_TUN: {
-        auto *w = dynamic_cast<NmAppToTun *>(msg);
-        ssize_t res = ::write(m_fd, w->data.data(), w->data.length());
-        if (res < 0)
-            push(NmError(GetErrorMessage("TUN device could not write")));
-        else if (res != w->data.length())
-            push(NmError(GetErrorMessage("TUN device partially written")));
-        delete w;
+        writeBatch(dynamic_cast<NmAppToTun *>(msg));
         break;
     }
     case NtsMessageType::UE_TUN_TO_APP: {
@@ -122,4 +132,63 @@ void TunTask::onLoop()
     }
 }
 
+void TunTask::writeBatch(NmAppToTun *first)
+{
+    NmAppToTun *w = first;
+    for (int i = 0; i < MAX_WRITE_BATCH && w != nullptr; i++)
+    {
+        if (!m_offload)
+            writePacket(nullptr, w->data.data(), static_cast<size_t>(w->data.length()));
+        else if (!m_coalescer.add(w->data.data(), static_cast<size_t>(w->data.length())))
+        {
+            auto merged = m_coalescer.flush();
+            writePacket(merged.vnetHeader, merged.data, merged.length);
+            m_coalescer.add(w->data.data(), static_cast<size_t>(w->data.length()));
+        }
+        delete w;
+        w = nullptr;
+
+        NtsMessage *next = poll();
+        if (next == nullptr)
+            break;
+        if (next->msgType != NtsMessageType::UE_APP_TO_TUN)
+        {
+            pushFront(next);
+            break;
+        }
+        w = dynamic_cast<NmAppToTun *>(next);
+    }
+
+    if (w != nullptr)
+        pushFront(w); // Batch is full
+
+    if (!m_coalescer.isEmpty())
+    {
+        auto merged = m_coalescer.flush();
+        writePacket(merged.vnetHeader, merged.data, merged.length);
+    }
+}
+
+void TunTask::writePacket(const uint8_t *vnetHeader, const uint8_t *data, size_t length)
+{
+    ssize_t res;
+    size_t expected = length;
+    if (vnetHeader != nullptr)
+    {
+        iovec iov[2] = {{const_cast<uint8_t *>(vnetHeader), tun::VNET_HEADER_SIZE},
+                        {const_cast<uint8_t *>(data), length}};
+        res = ::writev(m_fd, iov, 2);
+        expected += tun::VNET_HEADER_SIZE;
+    }
+    else
+    {
+        res = ::write(m_fd, data, length);
+    }
+
+    if (res < 0)
+        push(NmError(GetErrorMessage("TUN device could not write")));
+    else if (static_cast<size_t>(res) != expected)
+        push(NmError(GetErrorMessage("TUN device partially written")));
+}
+
 } // namespace nr::ue
\ No newline at end of file
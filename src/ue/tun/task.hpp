@@ -11,6 +11,7 @@
 #include <memory>
 #include <thread>
 #include <ue/nts.hpp>
+#include <ue/tun/offload.hpp>
 #include <ue/types.hpp>
 #include <unordered_map>
 #include <utils/logger.hpp>
@@ -26,18 +27,24 @@ class TunTask : public NtsTask
     TaskBase *m_base;
     int m_psi;
     int m_fd;
+    bool m_offload;
     ScopedThread *m_receiver;
+    tun::SegmentCoalescer m_coalescer;
 
     friend class UeCmdHandler;
 
   public:
-    explicit TunTask(TaskBase *taskBase, int psi, int fd);
+    explicit TunTask(TaskBase *taskBase, int psi, int fd, bool offload);
     ~TunTask() override = default;
 
   protected:
     void onStart() override;
     void onLoop() override;
     void onQuit() override;
+
+  private:
+    void writeBatch(NmAppToTun *first);
+    void writePacket(const uint8_t *vnetHeader, const uint8_t *data, size_t length);
 };
 
 } // namespace nr::ue
@@ -13,13 +13,13 @@
 namespace nr::ue::tun
 {
 
-int TunAllocate(const char *namePrefix, std::string &allocatedName, std::string &error)
+int TunAllocate(const char *namePrefix, bool offload, std::string &allocatedName, std::string &error)
 {
     int fd;
     char *name = nullptr;
     try
     {
-        fd = tun::AllocateTun(namePrefix, &name);
+        fd = tun::AllocateTun(namePrefix, offload, &name);
         allocatedName = std::string{name};
     }
     catch (const LibError &e)
@@ -7,6 +7,9 @@
 //
 
 #include "types.hpp"
+
+#include <stdexcept>
+
 #include <utils/printer.hpp>
 
 namespace nr::ue
@@ -21,6 +24,100 @@ NasTimers::NasTimers()
 {
 }
 
+/* Adds 'delta' to the decimal number in 'digits' keeping its length, e.g. leading zeros of an MSIN */
+static std::string AddToSerialNumber(std::string digits, int delta)
+{
+    int carry = delta;
+    for (auto it = digits.rbegin(); it != digits.rend() && carry != 0; ++it)
+    {
+        int sum = (*it - '0') + carry;
+        *it = static_cast<char>('0' + sum % 10);
+        carry = sum / 10;
+    }
+    if (carry != 0)
+        throw std::runtime_error("UE serial number overflow");
+    return digits;
+}
+
+std::optional<Supi> UeConfig::getSupi() const
+{
+    if (!profile->supi.has_value())
+        return std::nullopt;
+    return Supi{profile->supi->type, AddToSerialNumber(profile->supi->value, index)};
+}
+
+std::optional<std::string> UeConfig::getImei() const
+{
+    if (!profile->imei.has_value())
+        return std::nullopt;
+    return AddToSerialNumber(*profile->imei, index);
+}
+
+std::optional<std::string> UeConfig::getImeiSv() const
+{
+    if (!profile->imeiSv.has_value())
+        return std::nullopt;
+    return AddToSerialNumber(*profile->imeiSv, index);
+}
+
+const OctetString &UeConfig::getKey() const
+{
+    return subscription ? subscription->key : profile->key;
+}
+
+const OctetString &UeConfig::getOpC() const
+{
+    return subscription ? subscription->opC : profile->opC;
+}
+
+OpType UeConfig::getOpType() const
+{
+    return subscription ? OpType::OPC : profile->opType;
+}
+
+const OctetString &UeConfig::getAmf() const
+{
+    return subscription && subscription->amf.has_value() ? *subscription->amf : profile->amf;
+}
+
+const NetworkSlice &UeConfig::getConfiguredNssai() const
+{
+    if (subscription && subscription->configuredNssai.has_value())
+        return *subscription->configuredNssai;
+    return profile->configuredNssai;
+}
+
+radio::MobilityConfig UeConfig::getMobility() const
+{
+    auto mobility = profile->mobility;
+    mobility.seed += static_cast<uint64_t>(index); // Each UE takes its own random path
+    return mobility;
+}
+
+std::string UeConfig::getNodeName() const
+{
+    if (auto supi = getSupi())
+        return ToJson(supi).str();
+    if (auto imei = getImei())
+        return "imei-" + *imei;
+    if (auto imeiSv = getImeiSv())
+        return "imeisv-" + *imeiSv;
+    return "unknown-ue";
+}
+
+std::string UeConfig::getLoggerPrefix() const
+{
+    if (!profile->prefixLogger)
+        return "";
+    if (auto supi = getSupi())
+        return supi->value + "|";
+    if (auto imei = getImei())
+        return *imei + "|";
+    if (auto imeiSv = getImeiSv())
+        return *imeiSv + "|";
+    return "unknown-ue|";
+}
+
 Json ToJson(const ECmState &state)
 {
     switch (state)
@@ -83,6 +180,27 @@ Json ToJson(const ERrcState &state)
     }
 }
 
+Json ToJson(const EMemorySubsystem &v)
+{
+    switch (v)
+    {
+    case EMemorySubsystem::OTHER:
+        return "other";
+    case EMemorySubsystem::NAS:
+        return "nas";
+    case EMemorySubsystem::RRC:
+        return "rrc";
+    case EMemorySubsystem::RLS:
+        return "rls";
+    case EMemorySubsystem::APP:
+        return "app";
+    case EMemorySubsystem::TUN:
+        return "tun";
+    default:
+        return "?";
+    }
+}
+
 Json ToJson(const EMmSubState &state)
 {
     switch (state)
@@ -12,6 +12,7 @@
 
 #include <array>
 #include <atomic>
+#include <bitset>
 #include <deque>
 #include <memory>
 #include <queue>
@@ -20,8 +21,13 @@
 
 #include <lib/app/monitor.hpp>
 #include <lib/app/ue_ctl.hpp>
+#include <lib/crypt/aes.hpp>
 #include <lib/nas/nas.hpp>
+#include <lib/radio/mobility.hpp>
+#include <lib/rls/rls_transport.hpp>
+#include <lib/traffic/traffic.hpp>
 #include <utils/common_types.hpp>
+#include <utils/constants.hpp>
 #include <utils/json.hpp>
 #include <utils/locked.hpp>
 #include <utils/logger.hpp>
@@ -35,7 +41,11 @@ class UeAppTask;
 class NasTask;
 class UeRrcTask;
 class UeRlsTask;
+class RlsEndpointTask;
+class SharedTun;
 class UserEquipment;
+class ProcedureMetrics;
+class ProcedureClock;
 
 struct UeCellDesc
 {
@@ -89,19 +99,26 @@ struct IntegrityMaxDataRateConfig
     bool downlinkFull{};
 };
 
-struct UeConfig
+/* Configuration read from the config file. It is shared by all the UEs of the process and never modified once the
+ * UEs are created, the values that differ between the UEs are derived from it by UeConfig. */
+struct UeProfile
 {
     /* Read from config file */
-    std::optional<Supi> supi{};
+    std::optional<Supi> supi{};             // Of the first UE, the others follow in order
     Plmn hplmn{};
     OctetString key{};
     OctetString opC{};
     OpType opType{};
     OctetString amf{};
-    std::optional<std::string> imei{};
-    std::optional<std::string> imeiSv{};
+    std::optional<std::string> imei{};      // Of the first UE, the others follow in order
+    std::optional<std::string> imeiSv{};    // Of the first UE, the others follow in order
     SupportedAlgs supportedAlgs{};
     std::vector<std::string> gnbSearchList{};
+    rls::ETransportType rlsTransport{};
+    int tunMtu{cons::TunMtu};
+    bool tunOffload{true};
+    std::optional<traffic::TrafficProfile> traffic{}; // Sessions carry synthetic traffic instead of a TUN interface
+    radio::MobilityConfig mobility{};
     std::vector<SessionConfig> defaultSessions{};
     IntegrityMaxDataRateConfig integrityMaxRate{};
     NetworkSlice defaultConfiguredNssai{};
@@ -126,30 +143,42 @@ struct UeConfig
     /* Assigned by program */
     bool configureRouting{};
     bool prefixLogger{};
+};
 
-    [[nodiscard]] std::string getNodeName() const
-    {
-        if (supi.has_value())
-            return ToJson(supi).str();
-        if (imei.has_value())
-            return "imei-" + *imei;
-        if (imeiSv.has_value())
-            return "imeisv-" + *imeiSv;
-        return "unknown-ue";
-    }
+/* Subscription data of a UE overriding the one of the profile, e.g. from a bulk subscriber file. The OP is always
+ * given as OPc here. */
+struct UeSubscription
+{
+    OctetString key{};
+    OctetString opC{};
+    std::optional<OctetString> amf{};
+    std::optional<NetworkSlice> configuredNssai{};
+};
 
-    [[nodiscard]] std::string getLoggerPrefix() const
+/* Configuration of a single UE, i.e. the shared profile and what makes this UE differ from it. The identities are
+ * those of the profile offset by the UE index. */
+struct UeConfig
+{
+    std::shared_ptr<const UeProfile> profile;
+    int index;
+    std::unique_ptr<UeSubscription> subscription{};
+
+    UeConfig(std::shared_ptr<const UeProfile> profile, int index) : profile{std::move(profile)}, index{index}
     {
-        if (!prefixLogger)
-            return "";
-        if (supi.has_value())
-            return supi->value + "|";
-        if (imei.has_value())
-            return *imei + "|";
-        if (imeiSv.has_value())
-            return *imeiSv + "|";
-        return "unknown-ue|";
     }
+
+    [[nodiscard]] std::optional<Supi> getSupi() const;
+    [[nodiscard]] std::optional<std::string> getImei() const;
+    [[nodiscard]] std::optional<std::string> getImeiSv() const;
+    [[nodiscard]] const OctetString &getKey() const;
+    [[nodiscard]] const OctetString &getOpC() const;
+    [[nodiscard]] OpType getOpType() const;
+    [[nodiscard]] const OctetString &getAmf() const;
+    [[nodiscard]] const NetworkSlice &getConfiguredNssai() const;
+    [[nodiscard]] radio::MobilityConfig getMobility() const;
+
+    [[nodiscard]] std::string getNodeName() const;
+    [[nodiscard]] std::string getLoggerPrefix() const;
 };
 
 struct CellSelectionReport
@@ -171,11 +200,22 @@ struct ActiveCellInfo
     [[nodiscard]] bool hasValue() const;
 };
 
+/* UAC related state of the current cell. It is published by RRC so that NAS performs the UAC checks without waiting
+ * for the RRC task, which may be run by the same executor thread. */
+struct UacCellState
+{
+    bool isAccessible{}; // MIB and SIB1 are received, and the cell is neither barred nor reserved
+    UacAiBarringSet aiBarringSet{};
+
+    [[nodiscard]] bool isBarred(const std::bitset<16> &identities) const;
+};
+
 struct UeSharedContext
 {
     Locked<std::unordered_set<Plmn>> availablePlmns;
     Locked<Plmn> selectedPlmn;
     Locked<ActiveCellInfo> currentCell;
+    Locked<UacCellState> uacCellState;
     Locked<std::vector<Tai>> forbiddenTaiRoaming;
     Locked<std::vector<Tai>> forbiddenTaiRps;
     Locked<GutiMobileIdentity> providedGuti;
@@ -191,14 +231,38 @@ struct RlsSharedContext
     std::atomic<uint64_t> sti{};
 };
 
+/* Subsystems of the memory accounting of a UE, the indices of MemoryAccount */
+enum class EMemorySubsystem
+{
+    OTHER,
+    NAS,
+    RRC,
+    RLS,
+    APP,
+    TUN,
+};
+
+/* Resources shared by all UEs of the process in the multi-UE host mode */
+struct UeHostContext
+{
+    LogBase *logBase{};
+    NtsExecutor *executor{};
+    RlsEndpointTask *rlsEndpoint{};
+    SharedTun *sharedTun{}; // Only if the sessions share a TUN device
+};
+
 struct TaskBase
 {
     UserEquipment *ue{};
+    UeHostContext *host{};
     UeConfig *config{};
     LogBase *logBase{};
     app::IUeController *ueController{};
     app::INodeListener *nodeListener{};
     NtsTask *cliCallbackTask{};
+    ProcedureClock *procClock{};
+    traffic::TrafficMetrics *trafficMetrics{}; // Only if the profile has traffic
+    MemoryAccount *memAccount{}; // Only if the memory accounting is compiled in
 
     UeSharedContext shCtx{};
 
@@ -208,6 +272,11 @@ struct TaskBase
     UeRlsTask *rlsTask{};
 };
 
+inline MemoryTag MemoryTagOf(const TaskBase *base, EMemorySubsystem subsystem)
+{
+    return MemoryTag{base->memAccount, static_cast<int>(subsystem)};
+}
+
 struct RrcTimers
 {
     UeTimer t300;
@@ -350,6 +419,8 @@ struct PduSession
     std::optional<nas::IEQoSFlowDescriptions> authorizedQoSFlowDescriptions{};
     std::optional<nas::IEPduAddress> pduAddress{};
 
+    int64_t establishmentStartTime{}; // Monotonic microseconds, see ProcedureClock
+
     explicit PduSession(int psi) : psi(psi)
     {
     }
@@ -423,6 +494,11 @@ struct NasSecurityContext
     nas::ETypeOfIntegrityProtectionAlgorithm integrity{};
     nas::ETypeOfCipheringAlgorithm ciphering{};
 
+    /* Expanded AES schedules of K_NASint and K_NASenc for NIA2 and NEA2, rebuilt when the keys change. They are only
+     * allocated once the context protects a message, deep copies start without them. */
+    crypto::AesKeyCache intSchedule{};
+    crypto::AesKeyCache encSchedule{};
+
     void updateDownlinkCount(const NasCount &validatedCount)
     {
         downlinkCount.overflow = validatedCount.overflow;
@@ -592,11 +668,13 @@ struct ProcControl
     std::optional<EDeregCause> deregistration{};
 };
 
-struct UacInput
+// Procedures that can be triggered on a UE from outside of its stack, e.g. by the load driver
+enum class ETriggeredProcedure
 {
-    std::bitset<16> identities;
-    int category{};
-    int establishmentCause{};
+    DEREGISTRATION,
+    SERVICE_REQUEST,
+    SESSION_ESTABLISHMENT,
+    SESSION_RELEASE,
 };
 
 enum class EUacResult
@@ -606,11 +684,6 @@ enum class EUacResult
     BARRING_APPLICABLE_EXCEPT_0_2,
 };
 
-struct UacOutput
-{
-    EUacResult res{};
-};
-
 enum class ENasTransportHint
 {
     PDU_SESSION_ESTABLISHMENT_REQUEST,
@@ -645,5 +718,6 @@ Json ToJson(const ERegUpdateCause &v);
 Json ToJson(const EPsState &v);
 Json ToJson(const EServiceReqCause &v);
 Json ToJson(const ERrcState &v);
+Json ToJson(const EMemorySubsystem &v);
 
 } // namespace nr::ue
@@ -9,28 +9,69 @@
 #include "ue.hpp"
 
 #include "app/task.hpp"
+#include "metrics.hpp"
 #include "nas/task.hpp"
 #include "rls/task.hpp"
 #include "rrc/task.hpp"
 
+#include <utils/nts_trace.hpp>
+
 namespace nr::ue
 {
 
+/* Each task is charged with what it allocates, starting with its construction */
+template <typename T>
+static T *NewTask(TaskBase *base, EMemorySubsystem subsystem)
+{
+    MemoryTagScope tagScope{MemoryTagOf(base, subsystem)};
+    auto *task = new T(base);
+    task->setMemoryTag(MemoryTagOf(base, subsystem));
+    return task;
+}
+
 UserEquipment::UserEquipment(UeConfig *config, app::IUeController *ueController, app::INodeListener *nodeListener,
-                             NtsTask *cliCallbackTask)
+                             NtsTask *cliCallbackTask, UeHostContext *host, ProcedureMetrics *metrics,
+                             traffic::TrafficMetrics *trafficMetrics)
 {
+    // The remaining allocations of the UE, e.g. the task base and the log files, are charged to OTHER
+    auto *memAccount = MemoryAccount::Create();
+    MemoryTagScope tagScope{MemoryTag{memAccount, static_cast<int>(EMemorySubsystem::OTHER)}};
+
     auto *base = new TaskBase();
     base->ue = this;
+    base->host = host;
     base->config = config;
-    base->logBase = new LogBase("logs/ue-" + config->getNodeName() + ".log");
+    base->logBase = host ? host->logBase : new LogBase("logs/ue-" + config->getNodeName() + ".log");
     base->ueController = ueController;
     base->nodeListener = nodeListener;
     base->cliCallbackTask = cliCallbackTask;
+    base->procClock = new ProcedureClock(metrics);
+    base->trafficMetrics = trafficMetrics;
+    base->memAccount = memAccount;
+
+    base->nasTask = NewTask<NasTask>(base, EMemorySubsystem::NAS);
+    base->rrcTask = NewTask<UeRrcTask>(base, EMemorySubsystem::RRC);
+    base->appTask = NewTask<UeAppTask>(base, EMemorySubsystem::APP);
+    base->rlsTask = NewTask<UeRlsTask>(base, EMemorySubsystem::RLS);
 
-    base->nasTask = new NasTask(base);
-    base->rrcTask = new UeRrcTask(base);
-    base->appTask = new UeAppTask(base);
-    base->rlsTask = new UeRlsTask(base);
+    // The tasks of a UE are grouped in the trace by the node name
+    if (NtsTrace::IsEnabled())
+    {
+        auto nodeName = config->getNodeName();
+        base->nasTask->setTraceName(nodeName + "/nas");
+        base->rrcTask->setTraceName(nodeName + "/rrc");
+        base->appTask->setTraceName(nodeName + "/app");
+        base->rlsTask->setTraceName(nodeName + "/rls");
+    }
+
+    // Tasks of a host run on the shared threads, TUN tasks still have their own since they block on the device
+    if (host)
+    {
+        base->nasTask->setExecutor(host->executor);
+        base->rrcTask->setExecutor(host->executor);
+        base->appTask->setExecutor(host->executor);
+        base->rlsTask->setExecutor(host->executor);
+    }
 
     taskBase = base;
 }
@@ -47,7 +88,10 @@ UserEquipment::~UserEquipment()
     delete taskBase->rlsTask;
     delete taskBase->appTask;
 
-    delete taskBase->logBase;
+    if (taskBase->host == nullptr)
+        delete taskBase->logBase;
+
+    delete taskBase->procClock;
 
     delete taskBase;
 }
@@ -65,4 +109,11 @@ void UserEquipment::pushCommand(std::unique_ptr<app::UeCliCommand> cmd, const In
     taskBase->appTask->push(new NmUeCliCommand(std::move(cmd), address));
 }
 
+void UserEquipment::triggerProcedure(ETriggeredProcedure procedure)
+{
+    auto *msg = new NmUeAppToNas(NmUeAppToNas::TRIGGER_PROCEDURE);
+    msg->procedure = procedure;
+    taskBase->nasTask->push(msg);
+}
+
 } // namespace nr::ue
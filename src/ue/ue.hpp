@@ -24,12 +24,14 @@ class UserEquipment
 
   public:
     UserEquipment(UeConfig *config, app::IUeController *ueController, app::INodeListener *nodeListener,
-                  NtsTask *cliCallbackTask);
+                  NtsTask *cliCallbackTask, UeHostContext *host = nullptr, ProcedureMetrics *metrics = nullptr,
+                  traffic::TrafficMetrics *trafficMetrics = nullptr);
     virtual ~UserEquipment();
 
   public:
     void start();
     void pushCommand(std::unique_ptr<app::UeCliCommand> cmd, const InetAddress &address);
+    void triggerProcedure(ETriggeredProcedure procedure);
 };
 
 } // namespace nr::ue
\ No newline at end of file
@@ -0,0 +1,188 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <arpa/inet.h>
+
+#include <lib/app/base_app.hpp>
+#include <upf/stub.hpp>
+#include <utils/constants.hpp>
+#include <utils/libc_error.hpp>
+#include <utils/options.hpp>
+#include <utils/yaml_utils.hpp>
+#include <yaml-cpp/yaml.h>
+
+static nr::upf::UpfStub *g_upfStub = nullptr;
+
+static struct Options
+{
+    std::string configFile{};
+    std::string dumpFile{};
+} g_options{};
+
+static int g_reportPeriod = 5000;
+
+static void DumpCounters()
+{
+    if (g_options.dumpFile.empty() || g_upfStub == nullptr)
+        return;
+
+    std::ofstream file(g_options.dumpFile);
+    file << g_upfStub->toJson().dumpJson() << std::endl;
+}
+
+static uint32_t ReadIp4(const YAML::Node &node, const std::string &name)
+{
+    return inet_addr(yaml::GetIp4(node, name).c_str());
+}
+
+static traffic::TrafficProfile ReadTrafficProfile(const YAML::Node &node)
+{
+    traffic::TrafficProfile profile{};
+
+    std::string model = yaml::GetString(node, "model");
+    if (!traffic::ParseTrafficModel(model, profile.model))
+        throw std::runtime_error("Invalid traffic model: " + model);
+
+    if (yaml::HasField(node, "rate"))
+        profile.rate = yaml::GetDouble(node, "rate", 0.001, 10000000);
+    if (yaml::HasField(node, "size"))
+        profile.packetSize = yaml::GetInt32(node, "size", static_cast<int>(traffic::PROBE_HEADER_SIZE), 9000);
+    if (yaml::HasField(node, "burstSize"))
+        profile.burstSize = yaml::GetInt32(node, "burstSize", 1, 10000);
+    if (yaml::HasField(node, "port"))
+        profile.port = static_cast<uint16_t>(yaml::GetInt32(node, "port", 1, 65535));
+    if (yaml::HasField(node, "duration"))
+        profile.duration = yaml::GetInt32(node, "duration", 0, std::nullopt);
+    return profile;
+}
+
+static nr::upf::UpfStubConfig ReadConfigYaml()
+{
+    nr::upf::UpfStubConfig result{};
+    auto config = YAML::LoadFile(g_options.configFile);
+
+    result.address = yaml::GetIp4(config, "address");
+    result.port = cons::GtpPort;
+
+    std::string uplink = yaml::GetString(config, "uplink");
+    if (!nr::upf::ParseUplinkMode(uplink, result.uplinkMode))
+        throw std::runtime_error("Invalid uplink mode: " + uplink);
+
+    if (yaml::HasField(config, "qfi"))
+        result.qfi = yaml::GetInt32(config, "qfi", 0, 63);
+    if (yaml::HasField(config, "dataNetworkAddress"))
+        result.dataNetworkAddress = ReadIp4(config, "dataNetworkAddress");
+    if (yaml::HasField(config, "reportPeriod"))
+        g_reportPeriod = yaml::GetInt32(config, "reportPeriod", 100, std::nullopt);
+
+    if (yaml::HasField(config, "tunnels"))
+    {
+        for (auto &item : yaml::GetSequence(config, "tunnels"))
+        {
+            nr::upf::TunnelMapping mapping{};
+            mapping.uplinkTeid = static_cast<uint32_t>(yaml::GetInt64(item, "uplink", 0, 0xFFFFFFFFll));
+            mapping.downlinkTeid = static_cast<uint32_t>(yaml::GetInt64(item, "downlink", 0, 0xFFFFFFFFll));
+            if (yaml::HasField(item, "count"))
+                mapping.count = yaml::GetInt32(item, "count", 1, std::nullopt);
+            result.tunnels.push_back(mapping);
+        }
+    }
+
+    if (yaml::HasField(config, "downlink"))
+    {
+        for (auto &item : yaml::GetSequence(config, "downlink"))
+        {
+            nr::upf::DownlinkFlow flow{};
+            flow.gnbAddress = yaml::GetIp4(item, "gnb");
+            flow.teid = static_cast<uint32_t>(yaml::GetInt64(item, "teid", 0, 0xFFFFFFFFll));
+            flow.ueAddress = ReadIp4(item, "ueAddress");
+            if (yaml::HasField(item, "count"))
+                flow.count = yaml::GetInt32(item, "count", 1, std::nullopt);
+            if (yaml::HasField(item, "qfi"))
+                flow.qfi = yaml::GetInt32(item, "qfi", 0, 63);
+            flow.profile = ReadTrafficProfile(item);
+            result.downlink.push_back(flow);
+        }
+    }
+
+    return result;
+}
+
+static void ReadOptions(int argc, char **argv)
+{
+    opt::OptionsDescription desc{cons::Project,
+                                 cons::Tag,
+                                 "GTP-U stand-in for the N3 interface of a UPF",
+                                 cons::Owner,
+                                 "nr-upf-stub",
+                                 {"-c <config-file> [option...]"},
+                                 {},
+                                 true,
+                                 false};
+
+    opt::OptionItem itemConfigFile = {'c', "config", "Use specified configuration file for the UPF stub",
+                                      "config-file"};
+    opt::OptionItem itemDump = {'d', "dump", "Dump the counters and latencies of each TEID to the specified file at exit",
+                                "file"};
+
+    desc.items.push_back(itemConfigFile);
+    desc.items.push_back(itemDump);
+
+    opt::OptionsResult opt{argc, argv, desc, false, nullptr};
+
+    g_options.configFile = opt.getOption(itemConfigFile);
+    if (opt.hasFlag(itemDump))
+        g_options.dumpFile = opt.getOption(itemDump);
+}
+
+int main(int argc, char **argv)
+{
+    app::Initialize();
+
+    nr::upf::UpfStubConfig config{};
+    try
+    {
+        ReadOptions(argc, argv);
+        config = ReadConfigYaml();
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << cons::Name << std::endl;
+
+    auto *logBase = new LogBase("logs/upf-stub.log");
+    try
+    {
+        g_upfStub = new nr::upf::UpfStub(config, logBase);
+    }
+    catch (const LibError &e)
+    {
+        std::cerr << "ERROR: GTP-U socket could not be created: " << e.what() << std::endl;
+        return 1;
+    }
+    app::RunAtExit(DumpCounters);
+    g_upfStub->start();
+
+    auto logger = logBase->makeUniqueLogger("upf");
+    traffic::TrafficStats previous{};
+    while (true)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(g_reportPeriod));
+        logger->info(FMT_STRING("{}"), g_upfStub->summary(previous, g_reportPeriod));
+        previous = g_upfStub->stats();
+    }
+}
@@ -0,0 +1,110 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "gtpu.hpp"
+
+static constexpr const uint8_t FLAGS_VERSION_MASK = 0xF0; // Version and protocol type
+static constexpr const uint8_t FLAGS_GTPU_V1 = 0x30;
+static constexpr const uint8_t FLAG_EXTENSION = 0x04;
+static constexpr const uint8_t FLAG_OPTIONAL_FIELDS = 0x07; // Any of extension, sequence and N-PDU number
+
+static constexpr const uint8_t EXT_PDU_SESSION_CONTAINER = 0x85;
+static constexpr const uint8_t IE_RECOVERY = 14;
+
+static uint16_t Get16(const uint8_t *p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static void Put16(uint8_t *p, size_t value)
+{
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+static void Put32(uint8_t *p, uint32_t value)
+{
+    Put16(p, value >> 16);
+    Put16(p + 2, value & 0xFFFF);
+}
+
+namespace nr::upf
+{
+
+bool ParseGtpu(const uint8_t *data, size_t length, GtpuPacket &outPacket)
+{
+    if (length < GTPU_HEADER_SIZE || (data[0] & FLAGS_VERSION_MASK) != FLAGS_GTPU_V1)
+        return false;
+
+    size_t end = GTPU_HEADER_SIZE + Get16(data + 2);
+    if (end > length)
+        return false;
+
+    outPacket.msgType = data[1];
+    outPacket.teid = (static_cast<uint32_t>(Get16(data + 4)) << 16) | Get16(data + 6);
+    outPacket.sequence = 0;
+    outPacket.qfi = -1;
+
+    size_t offset = GTPU_HEADER_SIZE;
+    if (data[0] & FLAG_OPTIONAL_FIELDS)
+    {
+        if (offset + 4 > end)
+            return false;
+        outPacket.sequence = Get16(data + offset);
+        uint8_t nextType = (data[0] & FLAG_EXTENSION) ? data[offset + 3] : 0;
+        offset += 4;
+
+        // Each extension header is a multiple of 4 octets, the last octet is the type of the next one
+        while (nextType != 0)
+        {
+            if (offset >= end)
+                return false;
+            size_t extLength = data[offset] * 4u;
+            if (extLength == 0 || offset + extLength > end)
+                return false;
+            if (nextType == EXT_PDU_SESSION_CONTAINER && extLength >= 4)
+                outPacket.qfi = data[offset + 2] & 0x3F;
+            nextType = data[offset + extLength - 1];
+            offset += extLength;
+        }
+    }
+
+    outPacket.payload = data + offset;
+    outPacket.payloadLength = end - offset;
+    return true;
+}
+
+void WriteDownlinkHeader(uint8_t *out, uint32_t teid, int qfi, size_t payloadLength)
+{
+    out[0] = FLAGS_GTPU_V1 | FLAG_EXTENSION;
+    out[1] = GTPU_G_PDU;
+    Put16(out + 2, GTPU_DL_HEADER_SIZE - GTPU_HEADER_SIZE + payloadLength);
+    Put32(out + 4, teid);
+    Put16(out + 8, 0);  // Sequence number, not used
+    out[10] = 0;        // N-PDU number, not used
+    out[11] = EXT_PDU_SESSION_CONTAINER;
+    out[12] = 1;        // Length in 4 octets
+    out[13] = 0;        // PDU type DL, no optional fields
+    out[14] = static_cast<uint8_t>(qfi & 0x3F);
+    out[15] = 0;        // No more extension headers
+}
+
+void WriteEchoResponse(uint8_t *out, uint16_t sequence)
+{
+    out[0] = FLAGS_GTPU_V1 | 0x02; // The sequence number is mandatory in echo messages
+    out[1] = GTPU_ECHO_RESPONSE;
+    Put16(out + 2, GTPU_ECHO_RESPONSE_SIZE - GTPU_HEADER_SIZE);
+    Put32(out + 4, 0);
+    Put16(out + 8, sequence);
+    out[10] = 0;
+    out[11] = 0;
+    out[12] = IE_RECOVERY;
+    out[13] = 0; // Restart counter, always zero for the UPF
+}
+
+} // namespace nr::upf
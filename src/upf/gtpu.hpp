@@ -0,0 +1,48 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nr::upf
+{
+
+/* GTP-U headers of the fast path of the stub, read and written in place without a message object per packet. See
+ * 3GPP 29.281 and 38.415. */
+
+static constexpr const uint8_t GTPU_ECHO_REQUEST = 1;
+static constexpr const uint8_t GTPU_ECHO_RESPONSE = 2;
+static constexpr const uint8_t GTPU_G_PDU = 255;
+
+/* Mandatory part, then the optional fields and a PDU session container of a downlink packet */
+static constexpr const size_t GTPU_HEADER_SIZE = 8;
+static constexpr const size_t GTPU_DL_HEADER_SIZE = 16;
+static constexpr const size_t GTPU_ECHO_RESPONSE_SIZE = 14;
+
+struct GtpuPacket
+{
+    uint8_t msgType{};
+    uint32_t teid{};
+    uint16_t sequence{};
+    int qfi = -1; // Of the PDU session container if any
+    const uint8_t *payload{};
+    size_t payloadLength{};
+};
+
+/* Returns false for anything other than a well formed GTPv1-U packet */
+bool ParseGtpu(const uint8_t *data, size_t length, GtpuPacket &outPacket);
+
+/* Writes a G-PDU header of GTPU_DL_HEADER_SIZE with a downlink PDU session container of the given QFI */
+void WriteDownlinkHeader(uint8_t *out, uint32_t teid, int qfi, size_t payloadLength);
+
+/* Writes an echo response with the Recovery IE, of GTPU_ECHO_RESPONSE_SIZE */
+void WriteEchoResponse(uint8_t *out, uint16_t sequence);
+
+} // namespace nr::upf
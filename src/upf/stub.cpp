@@ -0,0 +1,397 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "stub.hpp"
+#include "gtpu.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <utils/constants.hpp>
+
+static constexpr const int BATCH_SIZE = 64;
+static constexpr const size_t RECEIVE_BUFFER_SIZE = 9216; // Jumbo frames
+static constexpr const int SOCKET_BUFFER_SIZE = 8 * 1024 * 1024;
+
+static constexpr const size_t IPV4_HEADER_MIN_SIZE = 20;
+static constexpr const uint8_t IP_PROTOCOL_TCP = 6;
+static constexpr const uint8_t IP_PROTOCOL_UDP = 17;
+
+/* Swaps the addresses and the ports of an IPv4 packet, which leaves all its checksums valid */
+static void SwapEndpoints(uint8_t *ip, size_t length)
+{
+    if (length < IPV4_HEADER_MIN_SIZE || (ip[0] >> 4) != 4)
+        return;
+
+    uint8_t temp[4];
+    std::memcpy(temp, ip + 12, 4);
+    std::memcpy(ip + 12, ip + 16, 4);
+    std::memcpy(ip + 16, temp, 4);
+
+    size_t headerLength = (ip[0] & 0xF) * 4u;
+    if ((ip[9] == IP_PROTOCOL_UDP || ip[9] == IP_PROTOCOL_TCP) && headerLength + 4 <= length)
+    {
+        uint8_t *ports = ip + headerLength;
+        std::swap(ports[0], ports[2]);
+        std::swap(ports[1], ports[3]);
+    }
+}
+
+static void SendAll(int fd, mmsghdr *messages, int count, Logger &logger)
+{
+    int sent = 0;
+    while (sent < count)
+    {
+        int res = ::sendmmsg(fd, messages + sent, static_cast<unsigned>(count - sent), 0);
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            logger.err(FMT_STRING("GTP-U packets could not be sent ({})"), strerror(errno));
+            return;
+        }
+        sent += res;
+    }
+}
+
+namespace nr::upf
+{
+
+bool ParseUplinkMode(const std::string &value, EUplinkMode &outMode)
+{
+    if (value == "reflect")
+        outMode = EUplinkMode::REFLECT;
+    else if (value == "sink")
+        outMode = EUplinkMode::SINK;
+    else
+        return false;
+    return true;
+}
+
+UpfStub::UpfStub(const UpfStubConfig &config, LogBase *logBase)
+    : m_logger{logBase->makeUniqueLogger("upf")}, m_config{config}, m_socket{}, m_mutex{}, m_teids{}, m_tunnels{},
+      m_metrics{}, m_invalidPackets{}, m_flows{}, m_receiver{}, m_generator{}
+{
+    m_socket = Socket::CreateAndBindUdp(InetAddress{config.address, config.port});
+
+    // Bursts of the benchmark should not be dropped by the kernel before the receiver thread catches up
+    int bufferSize = SOCKET_BUFFER_SIZE;
+    ::setsockopt(m_socket.getFd(), SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    ::setsockopt(m_socket.getFd(), SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+    for (auto &mapping : config.tunnels)
+    {
+        for (int i = 0; i < mapping.count; i++)
+            m_tunnels[mapping.uplinkTeid + i].downlinkTeid = mapping.downlinkTeid + i;
+    }
+
+    int64_t now = traffic::ProbeTime();
+    for (auto &flow : config.downlink)
+    {
+        InetAddress gnbAddress{flow.gnbAddress, cons::GtpPort};
+        for (int i = 0; i < flow.count; i++)
+        {
+            uint32_t teid = flow.teid + static_cast<uint32_t>(i);
+            traffic::TrafficProfile profile = flow.profile;
+            profile.destination = htonl(ntohl(flow.ueAddress) + static_cast<uint32_t>(i));
+            m_flows.push_back(GeneratedFlow{gnbAddress, teid, flow.qfi,
+                                            traffic::TrafficSource{profile, config.dataNetworkAddress, teid, teid,
+                                                                   now}});
+        }
+    }
+}
+
+void UpfStub::start()
+{
+    m_receiver = std::make_unique<ScopedThread>(&UpfStub::ReceiverThread, this);
+    if (!m_flows.empty())
+        m_generator = std::make_unique<ScopedThread>(&UpfStub::GeneratorThread, this);
+
+    m_logger->info(FMT_STRING("GTP-U is up on {}:{}, uplink is {}, {} downlink flows"), m_config.address, m_config.port,
+                   ToJson(m_config.uplinkMode).str(), static_cast<int>(m_flows.size()));
+}
+
+void UpfStub::addTunnel(uint32_t uplinkTeid, uint32_t downlinkTeid, const InetAddress &gnbAddress)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &tunnel = m_tunnels[uplinkTeid];
+    tunnel.downlinkTeid = downlinkTeid;
+    tunnel.gnbAddress = std::make_unique<InetAddress>(gnbAddress);
+}
+
+void UpfStub::ReceiverThread(void *args)
+{
+    reinterpret_cast<UpfStub *>(args)->receiverLoop();
+}
+
+void UpfStub::GeneratorThread(void *args)
+{
+    reinterpret_cast<UpfStub *>(args)->generatorLoop();
+}
+
+void UpfStub::receiverLoop()
+{
+    int fd = m_socket.getFd();
+
+    std::vector<uint8_t> buffers(BATCH_SIZE * RECEIVE_BUFFER_SIZE);
+    mmsghdr messages[BATCH_SIZE];
+    iovec iovs[BATCH_SIZE];
+    sockaddr_storage senders[BATCH_SIZE];
+
+    mmsghdr replies[BATCH_SIZE];
+    iovec replyIovs[BATCH_SIZE][2];
+    uint8_t replyHeaders[BATCH_SIZE][GTPU_DL_HEADER_SIZE];
+
+    std::vector<int64_t> latencies{};
+
+    while (true)
+    {
+        for (int i = 0; i < BATCH_SIZE; i++)
+        {
+            iovs[i] = {buffers.data() + i * RECEIVE_BUFFER_SIZE, RECEIVE_BUFFER_SIZE};
+            messages[i].msg_hdr = {};
+            messages[i].msg_hdr.msg_name = &senders[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(senders[i]);
+            messages[i].msg_hdr.msg_iov = &iovs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int count = ::recvmmsg(fd, messages, BATCH_SIZE, MSG_WAITFORONE, nullptr);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            m_logger->err(FMT_STRING("GTP-U socket could not receive ({}), receiver is stopped"), strerror(errno));
+            return;
+        }
+
+        int64_t now = traffic::ProbeTime();
+        int replyCount = 0;
+        traffic::TrafficStats delta{};
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            for (int i = 0; i < count; i++)
+            {
+                auto *data = reinterpret_cast<uint8_t *>(iovs[i].iov_base);
+                GtpuPacket packet{};
+                if ((messages[i].msg_hdr.msg_flags & MSG_TRUNC) || !ParseGtpu(data, messages[i].msg_len, packet))
+                {
+                    m_invalidPackets++;
+                    continue;
+                }
+
+                if (packet.msgType == GTPU_ECHO_REQUEST)
+                {
+                    uint8_t response[GTPU_ECHO_RESPONSE_SIZE];
+                    WriteEchoResponse(response, packet.sequence);
+                    ::sendto(fd, response, sizeof(response), 0, reinterpret_cast<sockaddr *>(&senders[i]),
+                             messages[i].msg_hdr.msg_namelen);
+                    continue;
+                }
+                if (packet.msgType != GTPU_G_PDU)
+                    continue;
+
+                auto it = m_teids.find(packet.teid);
+                if (it == m_teids.end())
+                {
+                    it = m_teids.emplace(packet.teid, TeidState{}).first;
+                    m_metrics.addFlow(1);
+                }
+                auto &state = it->second;
+                auto before = state.stats;
+
+                traffic::ProbeHeader header{};
+                if (traffic::ParseProbePacket(packet.payload, packet.payloadLength, header))
+                {
+                    state.sink.receive(header, packet.payloadLength, now, state.stats);
+                    auto &pending = state.sink.pendingLatencies();
+                    latencies.insert(latencies.end(), pending.begin(), pending.end());
+                    pending.clear();
+                }
+                else
+                {
+                    state.stats.rxPackets++;
+                    state.stats.rxBytes += static_cast<int64_t>(packet.payloadLength);
+                }
+
+                if (m_config.uplinkMode == EUplinkMode::REFLECT)
+                {
+                    // In place, the payload stays in the receive buffer until the replies are sent
+                    auto *payload = const_cast<uint8_t *>(packet.payload);
+                    SwapEndpoints(payload, packet.payloadLength);
+
+                    uint32_t downlinkTeid = packet.teid;
+                    auto &reply = replies[replyCount].msg_hdr;
+                    reply = {};
+                    reply.msg_name = messages[i].msg_hdr.msg_name;
+                    reply.msg_namelen = messages[i].msg_hdr.msg_namelen;
+
+                    auto tunnel = m_tunnels.find(packet.teid);
+                    if (tunnel != m_tunnels.end())
+                    {
+                        downlinkTeid = tunnel->second.downlinkTeid;
+                        if (tunnel->second.gnbAddress)
+                        {
+                            reply.msg_name = const_cast<sockaddr *>(tunnel->second.gnbAddress->getSockAddr());
+                            reply.msg_namelen = tunnel->second.gnbAddress->getSockLen();
+                        }
+                    }
+
+                    WriteDownlinkHeader(replyHeaders[replyCount], downlinkTeid,
+                                        packet.qfi >= 0 ? packet.qfi : m_config.qfi, packet.payloadLength);
+                    replyIovs[replyCount][0] = {replyHeaders[replyCount], GTPU_DL_HEADER_SIZE};
+                    replyIovs[replyCount][1] = {payload, packet.payloadLength};
+                    reply.msg_iov = replyIovs[replyCount];
+                    reply.msg_iovlen = 2;
+                    replyCount++;
+
+                    state.reflected++;
+                    state.stats.txPackets++;
+                    state.stats.txBytes += static_cast<int64_t>(packet.payloadLength);
+                }
+
+                delta += state.stats - before;
+            }
+
+            m_metrics.report(delta, latencies);
+        }
+
+        if (replyCount > 0)
+            SendAll(fd, replies, replyCount, *m_logger);
+    }
+}
+
+void UpfStub::generatorLoop()
+{
+    int fd = m_socket.getFd();
+
+    mmsghdr messages[BATCH_SIZE];
+    iovec iovs[BATCH_SIZE][2];
+    uint8_t headers[BATCH_SIZE][GTPU_DL_HEADER_SIZE];
+    std::vector<OctetString> batch{};   // Payloads of the messages being batched
+    std::vector<OctetString> packets{}; // Due packets of a flow
+    std::vector<traffic::TrafficStats> flowStats(m_flows.size());
+    std::vector<int64_t> noLatencies{};
+
+    int pollPeriod = INT32_MAX;
+    for (auto &flow : m_flows)
+        pollPeriod = std::min(pollPeriod, flow.source.pollPeriod());
+
+    auto flush = [&]() {
+        SendAll(fd, messages, static_cast<int>(batch.size()), *m_logger);
+        batch.clear();
+    };
+
+    while (true)
+    {
+        int64_t now = traffic::ProbeTime();
+
+        for (size_t f = 0; f < m_flows.size(); f++)
+        {
+            auto &flow = m_flows[f];
+            flow.source.generate(now, packets, flowStats[f]);
+
+            for (auto &packet : packets)
+            {
+                if (batch.size() == BATCH_SIZE)
+                    flush();
+
+                size_t k = batch.size();
+                WriteDownlinkHeader(headers[k], flow.teid, flow.qfi, static_cast<size_t>(packet.length()));
+                iovs[k][0] = {headers[k], GTPU_DL_HEADER_SIZE};
+                iovs[k][1] = {packet.data(), static_cast<size_t>(packet.length())};
+                messages[k].msg_hdr = {};
+                messages[k].msg_hdr.msg_name = const_cast<sockaddr *>(flow.gnbAddress.getSockAddr());
+                messages[k].msg_hdr.msg_namelen = flow.gnbAddress.getSockLen();
+                messages[k].msg_hdr.msg_iov = iovs[k];
+                messages[k].msg_hdr.msg_iovlen = 2;
+                batch.push_back(std::move(packet));
+            }
+            packets.clear();
+        }
+        if (!batch.empty())
+            flush();
+
+        // Counted once per round rather than per packet
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            traffic::TrafficStats delta{};
+            for (size_t f = 0; f < m_flows.size(); f++)
+            {
+                if (flowStats[f].txPackets == 0)
+                    continue;
+                auto it = m_teids.find(m_flows[f].teid);
+                if (it == m_teids.end())
+                {
+                    it = m_teids.emplace(m_flows[f].teid, TeidState{}).first;
+                    m_metrics.addFlow(1);
+                }
+                it->second.stats += flowStats[f];
+                delta += flowStats[f];
+                flowStats[f] = {};
+            }
+            m_metrics.report(delta, noLatencies);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(pollPeriod));
+    }
+}
+
+Json UpfStub::toJson() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Json teids = Json::Obj({});
+    for (auto &item : m_teids)
+    {
+        Json json = item.second.sink.toJson(item.second.stats);
+        json.put("reflected", item.second.reflected);
+        teids.put(std::to_string(item.first), json);
+    }
+
+    return Json::Obj({
+        {"uplink-mode", ToJson(m_config.uplinkMode)},
+        {"invalid-packets", m_invalidPackets.load()},
+        {"total", m_metrics.toJson()},
+        {"teids", teids},
+    });
+}
+
+std::string UpfStub::summary(const traffic::TrafficStats &previous, int64_t periodMs)
+{
+    return m_metrics.summary(previous, periodMs);
+}
+
+traffic::TrafficStats UpfStub::stats() const
+{
+    return m_metrics.stats();
+}
+
+Json ToJson(const EUplinkMode &mode)
+{
+    switch (mode)
+    {
+    case EUplinkMode::REFLECT:
+        return "reflect";
+    case EUplinkMode::SINK:
+        return "sink";
+    default:
+        return "?";
+    }
+}
+
+} // namespace nr::upf
@@ -0,0 +1,132 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/traffic/traffic.hpp>
+#include <utils/json.hpp>
+#include <utils/logger.hpp>
+#include <utils/network.hpp>
+#include <utils/scoped_thread.hpp>
+
+namespace nr::upf
+{
+
+enum class EUplinkMode
+{
+    REFLECT, // Sent back as downlink with the addresses of the inner packet swapped
+    SINK,    // Only counted
+};
+
+bool ParseUplinkMode(const std::string &value, EUplinkMode &outMode);
+
+/* Downlink TEIDs of a range of uplink TEIDs for reflection, the TEIDs are taken as they are otherwise */
+struct TunnelMapping
+{
+    uint32_t uplinkTeid{};
+    uint32_t downlinkTeid{};
+    int count = 1;
+};
+
+/* Generated downlink of a range of TEIDs, a flow per TEID with consecutive UE addresses */
+struct DownlinkFlow
+{
+    std::string gnbAddress{};
+    uint32_t teid{};
+    int count = 1;
+    uint32_t ueAddress{}; // Of the first TEID in network byte order
+    int qfi = 1;
+    traffic::TrafficProfile profile{};
+};
+
+struct UpfStubConfig
+{
+    std::string address{};
+    uint16_t port{};
+    EUplinkMode uplinkMode{};
+    int qfi = 1; // For the reflected packets without a PDU session container
+    uint32_t dataNetworkAddress{}; // Source of the generated downlink in network byte order
+    std::vector<TunnelMapping> tunnels{};
+    std::vector<DownlinkFlow> downlink{};
+};
+
+/* A stand-in for the N3 side of a UPF to benchmark the user plane of the gNB without a core network. Terminates GTP-U,
+ * reflects or sinks the uplink and generates downlink at the given rates, counting both per TEID. The packets move in
+ * batches with recvmmsg and sendmmsg on a receiver and a generator thread. */
+class UpfStub
+{
+  private:
+    struct TeidState
+    {
+        traffic::TrafficStats stats{}; // Uplink as received, downlink as transmitted
+        traffic::TrafficSink sink{};   // Uplink probes of the traffic generator of the UE
+        int64_t reflected{};
+    };
+
+    struct Tunnel
+    {
+        uint32_t downlinkTeid{};
+        std::unique_ptr<InetAddress> gnbAddress{}; // The sender of the uplink if not known
+    };
+
+    struct GeneratedFlow
+    {
+        InetAddress gnbAddress;
+        uint32_t teid;
+        int qfi;
+        traffic::TrafficSource source;
+    };
+
+  private:
+    std::unique_ptr<Logger> m_logger;
+    UpfStubConfig m_config;
+    Socket m_socket;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint32_t, TeidState> m_teids;
+    std::unordered_map<uint32_t, Tunnel> m_tunnels;
+    traffic::TrafficMetrics m_metrics;
+    std::atomic<int64_t> m_invalidPackets;
+
+    std::vector<GeneratedFlow> m_flows;
+    std::unique_ptr<ScopedThread> m_receiver;
+    std::unique_ptr<ScopedThread> m_generator;
+
+  public:
+    UpfStub(const UpfStubConfig &config, LogBase *logBase);
+
+  public:
+    void start();
+
+    /* For the core network stub of the same process, which knows the downlink TEID of each session */
+    void addTunnel(uint32_t uplinkTeid, uint32_t downlinkTeid, const InetAddress &gnbAddress);
+
+    /* Per TEID counters and latencies, and the totals */
+    [[nodiscard]] Json toJson() const;
+    /* Rates over the period since the previous stats, for a periodic log line */
+    std::string summary(const traffic::TrafficStats &previous, int64_t periodMs);
+    [[nodiscard]] traffic::TrafficStats stats() const;
+
+  private:
+    static void ReceiverThread(void *args);
+    static void GeneratorThread(void *args);
+    void receiverLoop();
+    void generatorLoop();
+};
+
+Json ToJson(const EUplinkMode &mode);
+
+} // namespace nr::upf
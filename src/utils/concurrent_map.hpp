@@ -56,4 +56,10 @@ class ConcurrentMap
         m_map.erase(key);
         return m_map.size();
     }
+
+    size_t size() const
+    {
+        std::lock_guard lk(m_mutex);
+        return m_map.size();
+    }
 };
\ No newline at end of file
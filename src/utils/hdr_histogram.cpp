@@ -0,0 +1,159 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "hdr_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+HdrHistogram::HdrHistogram(int64_t highestTrackableValue, int significantDigits)
+    : m_highestTrackableValue{highestTrackableValue}, m_totalCount{}, m_minValue{}, m_maxValue{}, m_sum{}
+{
+    if (highestTrackableValue < 2)
+        throw std::runtime_error("HDR histogram highest trackable value must be at least 2");
+    if (significantDigits < 1 || significantDigits > 5)
+        throw std::runtime_error("HDR histogram significant digits must be in range [1, 5]");
+
+    // Sub-buckets are enough to tell apart values differing in the given number of significant digits
+    int64_t largestValueWithSingleUnitResolution = 2 * static_cast<int64_t>(std::pow(10, significantDigits));
+    int subBucketCountMagnitude = static_cast<int>(std::ceil(std::log2(largestValueWithSingleUnitResolution)));
+
+    m_subBucketHalfCountMagnitude = subBucketCountMagnitude - 1;
+    m_subBucketHalfCount = int64_t{1} << m_subBucketHalfCountMagnitude;
+    m_subBucketMask = (int64_t{1} << subBucketCountMagnitude) - 1;
+
+    int64_t smallestUntrackableValue = int64_t{1} << subBucketCountMagnitude;
+    int bucketCount = 1;
+    while (smallestUntrackableValue <= highestTrackableValue)
+    {
+        bucketCount++;
+        if (smallestUntrackableValue > std::numeric_limits<int64_t>::max() / 2)
+            break;
+        smallestUntrackableValue <<= 1;
+    }
+
+    m_counts.resize(static_cast<size_t>((bucketCount + 1) * m_subBucketHalfCount));
+}
+
+size_t HdrHistogram::countsIndexFor(int64_t value) const
+{
+    int pow2Ceiling = 64 - __builtin_clzll(static_cast<uint64_t>(value | m_subBucketMask));
+    int bucketIndex = pow2Ceiling - (m_subBucketHalfCountMagnitude + 1);
+    int64_t subBucketIndex = value >> bucketIndex;
+    return static_cast<size_t>((static_cast<int64_t>(bucketIndex + 1) << m_subBucketHalfCountMagnitude) +
+                               (subBucketIndex - m_subBucketHalfCount));
+}
+
+int64_t HdrHistogram::valueFromIndex(size_t index) const
+{
+    auto i = static_cast<int64_t>(index);
+    int64_t bucketIndex = (i >> m_subBucketHalfCountMagnitude) - 1;
+    int64_t subBucketIndex = (i & (m_subBucketHalfCount - 1)) + m_subBucketHalfCount;
+    if (bucketIndex < 0)
+    {
+        subBucketIndex -= m_subBucketHalfCount;
+        bucketIndex = 0;
+    }
+    return subBucketIndex << bucketIndex;
+}
+
+int64_t HdrHistogram::highestEquivalentValue(size_t index) const
+{
+    int64_t bucketIndex = std::max<int64_t>(0, (static_cast<int64_t>(index) >> m_subBucketHalfCountMagnitude) - 1);
+    return valueFromIndex(index) + (int64_t{1} << bucketIndex) - 1;
+}
+
+void HdrHistogram::record(int64_t value)
+{
+    value = std::clamp<int64_t>(value, 0, m_highestTrackableValue);
+
+    m_counts[countsIndexFor(value)]++;
+
+    if (m_totalCount == 0 || value < m_minValue)
+        m_minValue = value;
+    if (m_totalCount == 0 || value > m_maxValue)
+        m_maxValue = value;
+
+    m_totalCount++;
+    m_sum += static_cast<double>(value);
+}
+
+void HdrHistogram::add(const HdrHistogram &other)
+{
+    if (other.m_counts.size() != m_counts.size() || other.m_subBucketMask != m_subBucketMask)
+        throw std::runtime_error("HDR histograms of different layouts cannot be added");
+    if (other.m_totalCount == 0)
+        return;
+
+    for (size_t i = 0; i < m_counts.size(); i++)
+        m_counts[i] += other.m_counts[i];
+
+    m_minValue = m_totalCount == 0 ? other.m_minValue : std::min(m_minValue, other.m_minValue);
+    m_maxValue = m_totalCount == 0 ? other.m_maxValue : std::max(m_maxValue, other.m_maxValue);
+    m_totalCount += other.m_totalCount;
+    m_sum += other.m_sum;
+}
+
+void HdrHistogram::reset()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_totalCount = 0;
+    m_minValue = 0;
+    m_maxValue = 0;
+    m_sum = 0;
+}
+
+int64_t HdrHistogram::totalCount() const
+{
+    return m_totalCount;
+}
+
+int64_t HdrHistogram::minValue() const
+{
+    return m_minValue;
+}
+
+int64_t HdrHistogram::maxValue() const
+{
+    return m_maxValue;
+}
+
+double HdrHistogram::mean() const
+{
+    return m_totalCount == 0 ? 0.0 : m_sum / static_cast<double>(m_totalCount);
+}
+
+int64_t HdrHistogram::valueAtPercentile(double percentile) const
+{
+    if (m_totalCount == 0)
+        return 0;
+
+    auto target = static_cast<int64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 *
+                                                 static_cast<double>(m_totalCount)));
+    target = std::max<int64_t>(target, 1);
+
+    int64_t cumulative = 0;
+    for (size_t i = 0; i < m_counts.size(); i++)
+    {
+        cumulative += m_counts[i];
+        if (cumulative >= target)
+            return std::min(highestEquivalentValue(i), m_maxValue);
+    }
+    return m_maxValue;
+}
+
+std::vector<std::pair<int64_t, int64_t>> HdrHistogram::distribution() const
+{
+    std::vector<std::pair<int64_t, int64_t>> res{};
+    for (size_t i = 0; i < m_counts.size(); i++)
+        if (m_counts[i] != 0)
+            res.emplace_back(std::min(highestEquivalentValue(i), m_maxValue), m_counts[i]);
+    return res;
+}
@@ -0,0 +1,55 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/* High dynamic range histogram, in the layout of HdrHistogram. Values from 1 up to the highest trackable value are
+ * counted with the given number of significant decimal digits, i.e. with a constant relative error, in buckets of
+ * doubling size each divided into the same number of linear sub-buckets. Values out of the range are clamped. Not
+ * thread safe. */
+class HdrHistogram
+{
+  private:
+    int64_t m_highestTrackableValue;
+    int m_subBucketHalfCountMagnitude;
+    int64_t m_subBucketHalfCount;
+    int64_t m_subBucketMask;
+    std::vector<int64_t> m_counts;
+
+    int64_t m_totalCount;
+    int64_t m_minValue;
+    int64_t m_maxValue;
+    double m_sum;
+
+  public:
+    HdrHistogram(int64_t highestTrackableValue, int significantDigits);
+
+  public:
+    void record(int64_t value);
+    void add(const HdrHistogram &other);
+    void reset();
+
+    [[nodiscard]] int64_t totalCount() const;
+    [[nodiscard]] int64_t minValue() const;
+    [[nodiscard]] int64_t maxValue() const;
+    [[nodiscard]] double mean() const;
+    [[nodiscard]] int64_t valueAtPercentile(double percentile) const;
+
+    /* Non-empty buckets as (highest equivalent value, count) pairs in increasing order */
+    [[nodiscard]] std::vector<std::pair<int64_t, int64_t>> distribution() const;
+
+  private:
+    [[nodiscard]] size_t countsIndexFor(int64_t value) const;
+    [[nodiscard]] int64_t valueFromIndex(size_t index) const;
+    [[nodiscard]] int64_t highestEquivalentValue(size_t index) const;
+};
@@ -8,6 +8,8 @@
 
 #include "json.hpp"
 
+#include <cmath>
+#include <iomanip>
 #include <sstream>
 #include <utility>
 
@@ -73,7 +75,7 @@ static void AppendJson(const Json &json, std::stringstream &stream, int indentat
         int index = 0;
         for (auto &item : json)
         {
-            stream << indent << " " << item.first << ": ";
+            stream << indent << " \"" << EscapeJson(item.first) << "\": ";
             AppendJson(item.second, stream, indentation + 1);
             if (index == json.itemCount() - 1)
                 stream << "\n";
@@ -201,6 +203,21 @@ Json::Json(int64_t v) : m_type{Type::NUMBER}, m_strVal(std::to_string(v)), m_int
 {
 }
 
+Json::Json(double v) : m_type{Type::NUMBER}, m_intVal{static_cast<int64_t>(v)}
+{
+    // JSON has no representation of infinity and NaN
+    if (!std::isfinite(v))
+    {
+        m_type = Type::NULL_TYPE;
+        m_intVal = 0;
+        return;
+    }
+
+    std::stringstream ss{};
+    ss << std::fixed << std::setprecision(3) << v;
+    m_strVal = ss.str();
+}
+
 Json::Type Json::type() const
 {
     return m_type;
@@ -411,3 +428,8 @@ Json ToJson(int64_t v)
 {
     return v;
 }
+
+Json ToJson(double v)
+{
+    return v;
+}
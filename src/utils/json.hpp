@@ -58,6 +58,7 @@ class Json
     /* no-explicit */ Json(int32_t v);
     /* no-explicit */ Json(int64_t v);
     /* no-explicit */ Json(uint64_t v) = delete;
+    /* no-explicit */ Json(double v); // With three decimal places, for rates and ratios
 
     template <std::size_t N>
     inline /* no-explicit */ Json(const char (&v)[N]) : Json(std::string(v))
@@ -115,6 +116,7 @@ Json ToJson(int16_t v);
 Json ToJson(uint32_t v);
 Json ToJson(int32_t v);
 Json ToJson(int64_t v);
+Json ToJson(double v);
 
 template <typename T>
 inline Json ToJson(const std::optional<T> &v)
@@ -1,72 +1,316 @@
-//
-// This file is a part of UERANSIM open source project.
-// Copyright (c) 2021 ALİ GÜNGÖR.
-//
-// The software and all associated files are licensed under GPL-3.0
-// and subject to the terms and conditions defined in LICENSE file.
-//
-
 #include "logger.hpp"
+#include "memory.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <thread>
 #include <vector>
 
+#include <spdlog/pattern_formatter.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
-Logger::Logger(const std::string &name, const std::vector<std::shared_ptr<spdlog::sinks::sink>> &sinks)
-{
-    logger = new spdlog::logger(name, std::begin(sinks), std::end(sinks));
+static constexpr const size_t QUEUE_CAPACITY = 16384; // Power of two
+static constexpr const int BACKEND_IDLE_WAIT_MS = 10;
 
-    logger->set_level(spdlog::level::debug);
-    logger->flush_on(spdlog::level::warn);
-}
+// Prefix of the logger which is currently logging in this thread, formatted by the '%*' flag
+static thread_local const std::string *g_currentPrefix = nullptr;
 
-Logger::~Logger()
+class PrefixFlagFormatter : public spdlog::custom_flag_formatter
 {
-    delete logger;
-}
+  public:
+    void format(const spdlog::details::log_msg &, const std::tm &, spdlog::memory_buf_t &dest) override
+    {
+        if (g_currentPrefix)
+            dest.append(g_currentPrefix->data(), g_currentPrefix->data() + g_currentPrefix->size());
+    }
+
+    [[nodiscard]] std::unique_ptr<custom_flag_formatter> clone() const override
+    {
+        return std::make_unique<PrefixFlagFormatter>();
+    }
+};
 
-void Logger::logImpl(Severity severity, const std::string &msg)
+static spdlog::level::level_enum ToSpdLevel(Severity severity)
 {
     switch (severity)
     {
     case Severity::DEBUG:
-        logger->debug(msg);
-        break;
+        return spdlog::level::debug;
     case Severity::INFO:
-        logger->info(msg);
-        break;
+        return spdlog::level::info;
     case Severity::WARN:
-        logger->warn(msg);
-        break;
+        return spdlog::level::warn;
     case Severity::ERR:
-        logger->error(msg);
-        break;
+        return spdlog::level::err;
     case Severity::FATAL:
-        logger->critical(msg);
-        logger->flush();
-        std::terminate();
-        break;
+    default:
+        return spdlog::level::critical;
     }
 }
 
+/* Process-wide logging backend. Logging threads put the messages into a bounded lock-free queue (multi-producer
+ * single-consumer, in the layout of Vyukov's bounded queue) and a single thread writes them to the sinks in the
+ * order they were queued. Messages are formatted by the logging threads, the queue takes the ownership of the text
+ * so that nothing is copied. */
+class LogBackend
+{
+  private:
+    struct Entry
+    {
+        spdlog::log_clock::time_point time{};
+        Severity severity{};
+        std::shared_ptr<spdlog::logger> logger{};
+        std::shared_ptr<const std::string> prefix{};
+        std::string message{};
+    };
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence{};
+        Entry entry{};
+    };
+
+  private:
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) std::atomic<size_t> m_dequeuePos;
+    alignas(64) std::atomic<int64_t> m_dropped;
+    std::atomic<LogOverflowPolicy> m_policy;
+
+    std::atomic<bool> m_sleeping;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCv;
+
+    std::shared_ptr<spdlog::sinks::sink> m_consoleSink;
+    std::mutex m_sharedMutex;
+    std::unordered_map<std::string, std::shared_ptr<spdlog::logger>> m_sharedLoggers;
+    std::shared_ptr<spdlog::logger> m_selfLogger;
+
+  public:
+    static LogBackend &Instance()
+    {
+        // Never destroyed, threads of the nodes may still be logging while the process exits. Shared by the nodes, so
+        // not charged to the node which happens to log first.
+        static auto *instance = []() {
+            MemoryTagScope tagScope{MemoryTag{}};
+            return new LogBackend();
+        }();
+        return *instance;
+    }
+
+  private:
+    LogBackend()
+        : m_cells{new Cell[QUEUE_CAPACITY]}, m_enqueuePos{}, m_dequeuePos{}, m_dropped{},
+          m_policy{LogOverflowPolicy::BLOCK}, m_sleeping{}
+    {
+        for (size_t i = 0; i < QUEUE_CAPACITY; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+
+        m_consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+        m_consoleSink->set_level(spdlog::level::trace);
+
+        // Same as spdlog's default pattern, except that the prefix of prefixed loggers precedes the name
+        auto formatter = std::make_unique<spdlog::pattern_formatter>();
+        formatter->add_flag<PrefixFlagFormatter>('*').set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%*%n] [%^%l%$] %v");
+        m_consoleSink->set_formatter(std::move(formatter));
+
+        m_selfLogger = std::make_shared<spdlog::logger>("log", m_consoleSink);
+
+        std::thread{[this]() { run(); }}.detach();
+        std::atexit([]() { Instance().flush(); });
+    }
+
+  public:
+    [[nodiscard]] const std::shared_ptr<spdlog::sinks::sink> &consoleSink() const
+    {
+        return m_consoleSink;
+    }
+
+    std::shared_ptr<spdlog::logger> sharedLogger(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        MemoryTagScope tagScope{MemoryTag{}};
+
+        auto &logger = m_sharedLoggers[name];
+        if (logger == nullptr)
+        {
+            logger = std::make_shared<spdlog::logger>(name, m_consoleSink);
+            logger->set_level(spdlog::level::debug);
+            logger->flush_on(spdlog::level::warn);
+        }
+        return logger;
+    }
+
+    void setPolicy(LogOverflowPolicy policy)
+    {
+        m_policy = policy;
+    }
+
+    void push(Severity severity, const std::shared_ptr<spdlog::logger> &logger,
+              const std::shared_ptr<const std::string> &prefix, std::string &&message)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &m_cells[pos & (QUEUE_CAPACITY - 1)];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // The queue is full
+                if (m_policy.load(std::memory_order_relaxed) == LogOverflowPolicy::DROP)
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->entry.time = spdlog::log_clock::now();
+        cell->entry.severity = severity;
+        cell->entry.logger = logger;
+        cell->entry.prefix = prefix;
+        cell->entry.message = std::move(message);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        if (m_sleeping.load())
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_wakeCv.notify_one();
+        }
+    }
+
+    /* Waits until the messages queued before the call are written */
+    void flush()
+    {
+        size_t target = m_enqueuePos.load();
+        while (m_dequeuePos.load() < target)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_wakeMutex);
+                m_wakeCv.notify_one();
+            }
+            std::this_thread::yield();
+        }
+        m_consoleSink->flush();
+    }
+
+  private:
+    bool pop(Entry &entry)
+    {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell &cell = m_cells[pos & (QUEUE_CAPACITY - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+            return false;
+
+        entry = std::move(cell.entry);
+        cell.entry.logger = nullptr;
+        cell.entry.prefix = nullptr;
+        cell.sequence.store(pos + QUEUE_CAPACITY, std::memory_order_release);
+        m_dequeuePos.store(pos + 1);
+        return true;
+    }
+
+    void write(const Entry &entry)
+    {
+        g_currentPrefix = entry.prefix.get();
+        entry.logger->log(entry.time, spdlog::source_loc{}, ToSpdLevel(entry.severity), entry.message);
+        g_currentPrefix = nullptr;
+    }
+
+    void run()
+    {
+        Entry entry{};
+        while (true)
+        {
+            if (pop(entry))
+            {
+                write(entry);
+                entry.logger = nullptr;
+                entry.prefix = nullptr;
+                continue;
+            }
+
+            int64_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0)
+                m_selfLogger->warn(FMT_STRING("{} log messages dropped, the log queue was full"), dropped);
+
+            // Producers only wake the thread up if it declared to sleep, the timeout covers the race in between
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_sleeping = true;
+            if (m_dequeuePos.load() == m_enqueuePos.load())
+                m_wakeCv.wait_for(lock, std::chrono::milliseconds(BACKEND_IDLE_WAIT_MS));
+            m_sleeping = false;
+        }
+    }
+};
+
+Logger::Logger(const std::string &name, const std::vector<std::shared_ptr<spdlog::sinks::sink>> &sinks) : prefix{}
+{
+    logger = std::make_shared<spdlog::logger>(name, std::begin(sinks), std::end(sinks));
+
+    logger->set_level(spdlog::level::debug);
+    logger->flush_on(spdlog::level::warn);
+}
+
+Logger::Logger(std::shared_ptr<spdlog::logger> logger, std::string prefix)
+    : logger{std::move(logger)},
+      prefix{prefix.empty() ? nullptr : std::make_shared<const std::string>(std::move(prefix))}
+{
+}
+
+Logger::~Logger() = default;
+
+std::atomic<int> Logger::s_minSeverity{static_cast<int>(Severity::DEBUG)};
+
+void Logger::SetMinSeverity(Severity severity)
+{
+    s_minSeverity = static_cast<int>(severity);
+}
+
+void Logger::logImpl(Severity severity, std::string &&msg)
+{
+    if (severity != Severity::FATAL)
+    {
+        LogBackend::Instance().push(severity, logger, prefix, std::move(msg));
+        return;
+    }
+
+    // Written synchronously after everything queued before, the process is terminated right after
+    LogBackend::Instance().flush();
+    g_currentPrefix = prefix.get();
+    logger->critical(msg);
+    logger->flush();
+    std::terminate();
+}
+
 void Logger::flush()
 {
+    LogBackend::Instance().flush();
     logger->flush();
 }
 
 void Logger::unhandledNts(NtsMessage* msg)
 {
-    err("Unhandled NTS message received with type %d", (int)msg->msgType);
+    err(FMT_STRING("Unhandled NTS message received with type {}"), (int)msg->msgType);
 }
 
-LogBase::LogBase(const std::string &filename)
+LogBase::LogBase(const std::string &filename) : consoleSink{LogBackend::Instance().consoleSink()}
 {
-    // fileSink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(filename);
-    // fileSink->set_level(spdlog::level::trace);
-
-    consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-    consoleSink->set_level(spdlog::level::trace); // todo: set to 'trace'.
 }
 
 LogBase::~LogBase() = default;
@@ -100,3 +344,33 @@ std::shared_ptr<Logger> LogBase::makeSharedLogger(const std::string &loggerName,
 
     return std::make_shared<Logger>(loggerName, v);
 }
+
+std::unique_ptr<Logger> LogBase::makePrefixedLogger(const std::string &prefix, const std::string &loggerName)
+{
+    return std::make_unique<Logger>(LogBackend::Instance().sharedLogger(loggerName), prefix);
+}
+
+void LogBase::SetOverflowPolicy(LogOverflowPolicy policy)
+{
+    LogBackend::Instance().setPolicy(policy);
+}
+
+void LogBase::FlushAll()
+{
+    LogBackend::Instance().flush();
+}
+
+bool ParseSeverity(const std::string &value, Severity &outSeverity)
+{
+    if (value == "debug")
+        outSeverity = Severity::DEBUG;
+    else if (value == "info")
+        outSeverity = Severity::INFO;
+    else if (value == "warn")
+        outSeverity = Severity::WARN;
+    else if (value == "error")
+        outSeverity = Severity::ERR;
+    else
+        return false;
+    return true;
+}
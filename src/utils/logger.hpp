@@ -10,11 +10,23 @@
 
 #include "nts.hpp"
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#include <spdlog/fmt/fmt.h>
 #include <spdlog/fwd.h>
 
+/* Log levels below this one are compiled out, 0 to 3 for debug, info, warn and error. Set by the LOG_LEVEL option of
+ * CMake. */
+#ifndef UERANSIM_MIN_LOG_LEVEL
+#define UERANSIM_MIN_LOG_LEVEL 0
+#endif
+
 enum class Severity
 {
     DEBUG,
@@ -24,82 +36,127 @@ enum class Severity
     FATAL
 };
 
+/* What a logging thread does when the asynchronous log queue is full */
+enum class LogOverflowPolicy
+{
+    BLOCK, // Wait until the backend thread makes room, no message is lost
+    DROP,  // Drop the message and count it, the count is reported once the queue has room again
+};
+
 class Logger
 {
   private:
-    spdlog::logger *logger;
+    std::shared_ptr<spdlog::logger> logger;
+    std::shared_ptr<const std::string> prefix;
+
+    static std::atomic<int> s_minSeverity;
 
   public:
     Logger(const std::string &name, const std::vector<std::shared_ptr<spdlog::sinks::sink>> &sinks);
+    Logger(std::shared_ptr<spdlog::logger> logger, std::string prefix);
     virtual ~Logger();
 
   private:
-    void logImpl(Severity severity, const std::string &msg);
+    /* Enables the formatting overloads for the formats made with FMT_STRING only */
+    template <typename S>
+    using IsFormat = std::enable_if_t<fmt::is_compile_string<S>::value, int>;
+
+    void logImpl(Severity severity, std::string &&msg);
 
   public:
-    template <typename... Args>
-    inline void debug(const std::string &fmt, Args &&...args)
+    /* Levels below the compile-time minimum are compiled out, see UERANSIM_MIN_LOG_LEVEL */
+    static constexpr bool IsCompiledIn(Severity severity)
     {
-        log(Severity::DEBUG, fmt, args...);
+        return static_cast<int>(severity) >= UERANSIM_MIN_LOG_LEVEL;
     }
 
-    inline void debug(const std::string &fmt)
+    static bool IsEnabled(Severity severity)
+    {
+        return IsCompiledIn(severity) && static_cast<int>(severity) >= s_minSeverity.load(std::memory_order_relaxed);
+    }
+
+    /* Applies to all the loggers of the process */
+    static void SetMinSeverity(Severity severity);
+
+    /* The message is formatted in fmt style, i.e. with '{}' placeholders, and only if the level is enabled. The format
+     * is to be given with FMT_STRING, so that it is checked against the arguments at compile time. Messages without
+     * arguments are taken verbatim. */
+    template <typename S, typename... Args, IsFormat<S> = 0>
+    inline void debug(const S &fmt, const Args &...args)
     {
-        log(Severity::DEBUG, fmt);
+        if constexpr (IsCompiledIn(Severity::DEBUG))
+            log(Severity::DEBUG, fmt, args...);
     }
 
-    template <typename... Args>
-    inline void info(const std::string &fmt, Args &&...args)
+    inline void debug(const std::string &msg)
     {
-        log(Severity::INFO, fmt, args...);
+        if constexpr (IsCompiledIn(Severity::DEBUG))
+            log(Severity::DEBUG, msg);
     }
 
-    inline void info(const std::string &fmt)
+    template <typename S, typename... Args, IsFormat<S> = 0>
+    inline void info(const S &fmt, const Args &...args)
     {
-        log(Severity::INFO, fmt);
+        if constexpr (IsCompiledIn(Severity::INFO))
+            log(Severity::INFO, fmt, args...);
     }
 
-    template <typename... Args>
-    inline void warn(const std::string &fmt, Args &&...args)
+    inline void info(const std::string &msg)
     {
-        log(Severity::WARN, fmt, args...);
+        if constexpr (IsCompiledIn(Severity::INFO))
+            log(Severity::INFO, msg);
     }
 
-    inline void warn(const std::string &fmt)
+    template <typename S, typename... Args, IsFormat<S> = 0>
+    inline void warn(const S &fmt, const Args &...args)
     {
-        log(Severity::WARN, fmt);
+        if constexpr (IsCompiledIn(Severity::WARN))
+            log(Severity::WARN, fmt, args...);
     }
 
-    template <typename... Args>
-    inline void err(const std::string &fmt, Args &&...args)
+    inline void warn(const std::string &msg)
     {
-        log(Severity::ERR, fmt, args...);
+        if constexpr (IsCompiledIn(Severity::WARN))
+            log(Severity::WARN, msg);
     }
 
-    inline void err(const std::string &fmt)
+    template <typename S, typename... Args, IsFormat<S> = 0>
+    inline void err(const S &fmt, const Args &...args)
     {
-        log(Severity::ERR, fmt);
+        if constexpr (IsCompiledIn(Severity::ERR))
+            log(Severity::ERR, fmt, args...);
     }
 
-    template <typename... Args>
-    inline void fatal(const std::string &fmt, Args &&...args)
+    inline void err(const std::string &msg)
+    {
+        if constexpr (IsCompiledIn(Severity::ERR))
+            log(Severity::ERR, msg);
+    }
+
+    template <typename S, typename... Args, IsFormat<S> = 0>
+    inline void fatal(const S &fmt, const Args &...args)
     {
         log(Severity::FATAL, fmt, args...);
     }
 
-    inline void fatal(const std::string &fmt)
+    inline void fatal(const std::string &msg)
     {
-        log(Severity::FATAL, fmt);
+        log(Severity::FATAL, msg);
     }
 
-    template <typename... Args>
-    inline void log(Severity severity, const std::string &fmt, Args &&...args)
+    template <typename S, typename... Args, IsFormat<S> = 0>
+    inline void log(Severity severity, const S &fmt, const Args &...args)
     {
-        int size = snprintf(nullptr, 0, fmt.c_str(), args...);
-        std::string res;
-        res.resize(size);
-        snprintf(&res[0], size + 1, fmt.c_str(), args...);
-        logImpl(severity, res);
+        if (!IsEnabled(severity))
+            return;
+        logImpl(severity, fmt::format(fmt, args...));
+    }
+
+    inline void log(Severity severity, const std::string &msg)
+    {
+        if (!IsEnabled(severity))
+            return;
+        logImpl(severity, std::string{msg});
     }
 
     void flush();
@@ -108,10 +165,12 @@ class Logger
     void unhandledNts(NtsMessage *msg);
 };
 
+/* Messages of all the loggers of the process are queued to a single backend thread which writes them to the sinks,
+ * so the logging threads do not wait for the console. The sinks and the loggers shared by name are process-wide too,
+ * hence creating a LogBase and the loggers of a node is cheap. */
 class LogBase
 {
   private:
-    // std::shared_ptr<spdlog::sinks::sink> fileSink;
     std::shared_ptr<spdlog::sinks::sink> consoleSink;
 
   public:
@@ -121,4 +180,15 @@ class LogBase
     Logger *makeLogger(const std::string &loggerName, bool useConsole = true);
     std::unique_ptr<Logger> makeUniqueLogger(const std::string &loggerName, bool useConsole = true);
     std::shared_ptr<Logger> makeSharedLogger(const std::string &loggerName, bool useConsole = true);
+
+    /* Returns a light-weight logger which shares the underlying logger with all other loggers of the same name, and
+     * shows the prefix in front of the name. Suitable for having thousands of nodes in the same process. */
+    std::unique_ptr<Logger> makePrefixedLogger(const std::string &prefix, const std::string &loggerName);
+
+    /* Applies to all the loggers of the process, BLOCK by default */
+    static void SetOverflowPolicy(LogOverflowPolicy policy);
+    /* Waits until the messages logged so far are written */
+    static void FlushAll();
 };
+
+bool ParseSeverity(const std::string &value, Severity &outSeverity);
@@ -0,0 +1,195 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "memory.hpp"
+
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+static MemoryAccount g_untagged{};
+
+#ifdef UERANSIM_MEMORY_ACCOUNTING
+
+static thread_local MemoryTag t_tag{};
+
+static std::mutex &RegistryMutex()
+{
+    static std::mutex mutex{};
+    return mutex;
+}
+
+static std::vector<MemoryAccount *> &Registry()
+{
+    static auto *registry = new std::vector<MemoryAccount *>();
+    return *registry;
+}
+
+#endif
+
+MemoryAccount *MemoryAccount::Create()
+{
+#ifdef UERANSIM_MEMORY_ACCOUNTING
+    // Charged to the tag of the creator, like any other block
+    auto *account = new MemoryAccount();
+
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    Registry().push_back(account);
+    return account;
+#else
+    return nullptr;
+#endif
+}
+
+MemoryAccount &MemoryAccount::Untagged()
+{
+    return g_untagged;
+}
+
+void MemoryAccount::Totals(int64_t (&bytes)[MAX_SUBSYSTEMS], int64_t (&blocks)[MAX_SUBSYSTEMS], int &accountCount)
+{
+    for (int i = 0; i < MAX_SUBSYSTEMS; i++)
+    {
+        bytes[i] = 0;
+        blocks[i] = 0;
+    }
+    accountCount = 0;
+
+#ifdef UERANSIM_MEMORY_ACCOUNTING
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    for (auto *account : Registry())
+    {
+        for (int i = 0; i < MAX_SUBSYSTEMS; i++)
+        {
+            bytes[i] += account->bytes(i);
+            blocks[i] += account->blocks(i);
+        }
+    }
+    accountCount = static_cast<int>(Registry().size());
+#endif
+}
+
+MemoryTag GetThreadMemoryTag()
+{
+#ifdef UERANSIM_MEMORY_ACCOUNTING
+    return t_tag;
+#else
+    return {};
+#endif
+}
+
+void SetThreadMemoryTag(MemoryTag tag)
+{
+#ifdef UERANSIM_MEMORY_ACCOUNTING
+    t_tag = tag;
+#endif
+}
+
+#ifdef UERANSIM_MEMORY_ACCOUNTING
+
+/* Precedes each block, keeps the alignment of malloc */
+struct alignas(16) BlockHeader
+{
+    MemoryAccount *account;
+    uint64_t sizeAndSubsystem; // Subsystem in the top byte
+};
+
+static constexpr const int SUBSYSTEM_SHIFT = 56;
+static constexpr const uint64_t SIZE_MASK = (1ULL << SUBSYSTEM_SHIFT) - 1;
+
+static void *AccountedAlloc(size_t size) noexcept
+{
+    void *raw;
+    while ((raw = std::malloc(sizeof(BlockHeader) + size)) == nullptr)
+    {
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+            return nullptr;
+        handler();
+    }
+
+    MemoryTag tag = t_tag;
+    MemoryAccount *account = tag.account ? tag.account : &g_untagged;
+    int subsystem = tag.account ? tag.subsystem : 0;
+    account->charge(subsystem, size);
+
+    auto *header = static_cast<BlockHeader *>(raw);
+    header->account = account;
+    header->sizeAndSubsystem = static_cast<uint64_t>(size) | (static_cast<uint64_t>(subsystem) << SUBSYSTEM_SHIFT);
+    return header + 1;
+}
+
+static void AccountedFree(void *ptr) noexcept
+{
+    if (ptr == nullptr)
+        return;
+
+    auto *header = static_cast<BlockHeader *>(ptr) - 1;
+    header->account->credit(static_cast<int>(header->sizeAndSubsystem >> SUBSYSTEM_SHIFT),
+                            static_cast<size_t>(header->sizeAndSubsystem & SIZE_MASK));
+    std::free(header);
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = AccountedAlloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    void *ptr = AccountedAlloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return AccountedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return AccountedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    AccountedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    AccountedFree(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    AccountedFree(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    AccountedFree(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    AccountedFree(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    AccountedFree(ptr);
+}
+
+#endif
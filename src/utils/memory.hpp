@@ -0,0 +1,102 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/* Live heap usage charged to a node, split by subsystem. Only counted if built with MEMORY_ACCOUNTING, which
+ * replaces the global operator new and delete: each block gets a small header naming the account and the subsystem
+ * that were tagged on the allocating thread, so that a block is credited back to the same account wherever it is
+ * freed. Accounts are never destroyed since blocks may outlive their node.
+ * C allocations are not counted: the ASN.1 structures and OCTET STRING buffers of asn1c, which are made with malloc
+ * and calloc, are missing from every account. */
+class MemoryAccount
+{
+  public:
+    static constexpr const int MAX_SUBSYSTEMS = 8;
+
+  private:
+    std::atomic<int64_t> m_bytes[MAX_SUBSYSTEMS]{};
+    std::atomic<int64_t> m_blocks[MAX_SUBSYSTEMS]{};
+
+  public:
+    static constexpr bool IsCompiledIn()
+    {
+#ifdef UERANSIM_MEMORY_ACCOUNTING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /* A new account, or nullptr if the accounting is not compiled in */
+    static MemoryAccount *Create();
+
+    /* Charged for the allocations of the threads with no tag */
+    static MemoryAccount &Untagged();
+
+    /* Sums of all accounts created, excluding the untagged one */
+    static void Totals(int64_t (&bytes)[MAX_SUBSYSTEMS], int64_t (&blocks)[MAX_SUBSYSTEMS], int &accountCount);
+
+  public:
+    void charge(int subsystem, size_t size)
+    {
+        m_bytes[subsystem].fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+        m_blocks[subsystem].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void credit(int subsystem, size_t size)
+    {
+        m_bytes[subsystem].fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+        m_blocks[subsystem].fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] int64_t bytes(int subsystem) const
+    {
+        return m_bytes[subsystem].load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] int64_t blocks(int subsystem) const
+    {
+        return m_blocks[subsystem].load(std::memory_order_relaxed);
+    }
+};
+
+/* Account and subsystem charged for the allocations of a thread */
+struct MemoryTag
+{
+    MemoryAccount *account{};
+    int subsystem{};
+};
+
+MemoryTag GetThreadMemoryTag();
+void SetThreadMemoryTag(MemoryTag tag);
+
+/* Tags the allocations of the current thread until the end of the scope, then restores the previous tag */
+class MemoryTagScope
+{
+  private:
+    MemoryTag m_previous;
+
+  public:
+    explicit MemoryTagScope(MemoryTag tag) : m_previous{GetThreadMemoryTag()}
+    {
+        SetThreadMemoryTag(tag);
+    }
+
+    ~MemoryTagScope()
+    {
+        SetThreadMemoryTag(m_previous);
+    }
+
+    MemoryTagScope(const MemoryTagScope &) = delete;
+    MemoryTagScope &operator=(const MemoryTagScope &) = delete;
+};
@@ -16,6 +16,7 @@
 #include <stdexcept>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 static std::string OctetStringToIpString(const OctetString &address)
@@ -196,11 +197,41 @@ void Socket::send(const InetAddress &address, const uint8_t *buffer, size_t size
     }
 }
 
+void Socket::send(const InetAddress &address, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+                  size_t payloadSize) const
+{
+    // Gather the header and the payload in the kernel, so that the payload is not copied into a new buffer
+    iovec iov[2];
+    iov[0].iov_base = const_cast<uint8_t *>(header);
+    iov[0].iov_len = headerSize;
+    iov[1].iov_base = const_cast<uint8_t *>(payload);
+    iov[1].iov_len = payloadSize;
+
+    msghdr msg{};
+    msg.msg_name = const_cast<sockaddr *>(address.getSockAddr());
+    msg.msg_namelen = address.getSockLen();
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    ssize_t rc = sendmsg(fd, &msg, MSG_DONTWAIT);
+    if (rc == -1)
+    {
+        int err = errno;
+        if (err != EAGAIN)
+            throw LibError("sendmsg failed: ", errno);
+    }
+}
+
 bool Socket::hasFd() const
 {
     return fd >= 0;
 }
 
+int Socket::getFd() const
+{
+    return fd;
+}
+
 Socket Socket::CreateAndBindUdp(const InetAddress &address)
 {
     Socket s(address.getSockAddr()->sa_family, SOCK_DGRAM, IPPROTO_UDP);
@@ -54,8 +54,11 @@ class Socket
     void bind(const InetAddress &address) const;
     int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outAddress) const;
     void send(const InetAddress &address, const uint8_t *buffer, size_t size) const;
+    void send(const InetAddress &address, const uint8_t *header, size_t headerSize, const uint8_t *payload,
+              size_t payloadSize) const;
     void close();
     [[nodiscard]] bool hasFd() const;
+    [[nodiscard]] int getFd() const;
     [[nodiscard]] InetAddress getAddress() const;
 
     /* Socket options */
@@ -8,11 +8,27 @@
 
 #include "nts.hpp"
 #include "common.hpp"
+#include "nts_trace.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 #define WAIT_TIME_IF_NO_TIMER 500
 #define PAUSE_POLLING_PERIOD 20
+#define EXECUTOR_SLICE_LOOPS 16
+
+NtsMessage::~NtsMessage()
+{
+    if (traceId != 0 && NtsTrace::IsEnabled())
+        NtsTrace::OnDone(this);
+}
+
+static NtsMessage *Dequeued(NtsTask *task, NtsMessage *msg)
+{
+    if (msg && NtsTrace::IsEnabled())
+        NtsTrace::OnDequeue(task, msg);
+    return msg;
+}
 
 static NtsMessage *TimerExpiredMessage(TimerInfo *timerInfo)
 {
@@ -53,6 +69,11 @@ TimerInfo *TimerBase::getAndRemoveExpiredTimer()
     return nullptr;
 }
 
+bool TimerBase::hasExpiredTimer() const
+{
+    return !timerQueue.empty() && timerQueue.top()->end < utils::CurrentTimeMillis();
+}
+
 TimerBase::~TimerBase()
 {
     while (!timerQueue.empty())
@@ -70,12 +91,17 @@ bool NtsTask::push(NtsMessage *msg)
         return false;
     }
 
+    if (NtsTrace::IsEnabled())
+        NtsTrace::OnEnqueue(this, msg);
+
     {
         std::unique_lock<std::mutex> lock(mutex);
         msgQueue.push_back(msg);
     }
 
     cv.notify_one();
+    if (executor)
+        executor->schedule(this);
     return true;
 }
 
@@ -87,12 +113,17 @@ bool NtsTask::pushFront(NtsMessage *msg)
         return false;
     }
 
+    if (NtsTrace::IsEnabled())
+        NtsTrace::OnEnqueue(this, msg);
+
     {
         std::unique_lock<std::mutex> lock(mutex);
         msgQueue.push_front(msg);
     }
 
     cv.notify_one();
+    if (executor)
+        executor->schedule(this);
     return true;
 }
 
@@ -112,6 +143,9 @@ bool NtsTask::setTimerAbsolute(int timerId, int64_t timeMs)
     }
 
     cv.notify_one();
+    // Timers expire strictly after their end time
+    if (executor)
+        executor->scheduleAt(this, timeMs + 1);
     return true;
 }
 
@@ -123,7 +157,7 @@ NtsMessage *NtsTask::poll()
         {
             NtsMessage *ret = msgQueue.front();
             msgQueue.pop_front();
-            return ret;
+            return Dequeued(this, ret);
         }
     }
 
@@ -140,13 +174,17 @@ NtsMessage *NtsTask::poll()
     {
         NtsMessage *msg = TimerExpiredMessage(expiredTimer);
         delete expiredTimer;
-        return msg;
+        return Dequeued(this, msg);
     }
     return nullptr;
 }
 
 NtsMessage *NtsTask::poll(int64_t timeout)
 {
+    // Tasks on an executor never block, they are called again when there is something to do
+    if (executor)
+        return poll();
+
     timeout = std::min(timeout, (int64_t)WAIT_TIME_IF_NO_TIMER);
 
     if (isQuiting)
@@ -158,7 +196,7 @@ NtsMessage *NtsTask::poll(int64_t timeout)
         {
             NtsMessage *ret = msgQueue.front();
             msgQueue.pop_front();
-            return ret;
+            return Dequeued(this, ret);
         }
         cv.wait_for(lock, std::chrono::milliseconds(std::min(timerBase.getNextWaitTime(), timeout)));
     }
@@ -172,7 +210,7 @@ NtsMessage *NtsTask::poll(int64_t timeout)
         {
             NtsMessage *ret = msgQueue.front();
             msgQueue.pop_front();
-            return ret;
+            return Dequeued(this, ret);
         }
     }
 
@@ -186,7 +224,7 @@ NtsMessage *NtsTask::poll(int64_t timeout)
     {
         NtsMessage *msg = TimerExpiredMessage(expiredTimer);
         delete expiredTimer;
-        return msg;
+        return Dequeued(this, msg);
     }
     return nullptr;
 }
@@ -196,13 +234,38 @@ NtsMessage *NtsTask::take()
     return poll(WAIT_TIME_IF_NO_TIMER);
 }
 
+void NtsTask::setExecutor(NtsExecutor *executor)
+{
+    this->executor = executor;
+    executor->registerTask(this);
+}
+
+void NtsTask::setTraceName(std::string name)
+{
+    traceName = std::move(name);
+}
+
+void NtsTask::setMemoryTag(MemoryTag tag)
+{
+    memoryTag = tag;
+}
+
 void NtsTask::start()
 {
-    onStart();
+    {
+        MemoryTagScope tagScope{memoryTag};
+        onStart();
+    }
 
-    if (!isQuiting)
+    if (!isQuiting && executor)
+    {
+        executor->attach(this);
+    }
+    else if (!isQuiting)
     {
         thread = std::thread{[this]() {
+            NtsTrace::SetCurrentTask(this);
+            SetThreadMemoryTag(memoryTag);
             while (true)
             {
                 if (this->isQuiting)
@@ -231,6 +294,8 @@ void NtsTask::quit()
 
     cv.notify_one();
 
+    if (executor)
+        executor->detach(this);
     if (thread.joinable())
         thread.join();
 
@@ -255,16 +320,198 @@ void NtsTask::requestPause()
         throw std::runtime_error("NTS pause overflow");
 
     if (!isQuiting)
+    {
         cv.notify_one();
+        if (executor)
+            executor->schedule(this);
+    }
 }
 
 void NtsTask::requestUnpause()
 {
     if (--pauseReqCount < 0)
         throw std::runtime_error("NTS un-pause underflow");
+
+    if (executor && !isQuiting)
+        executor->schedule(this);
 }
 
 bool NtsTask::isPauseConfirmed()
 {
     return pauseConfirmed;
 }
+
+bool NtsTask::hasWork()
+{
+    if (pauseReqCount > 0)
+        return !pauseConfirmed;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    return !msgQueue.empty() || timerBase.hasExpiredTimer();
+}
+
+void NtsTask::runSlice()
+{
+    NtsTrace::SetCurrentTask(this);
+    MemoryTagScope tagScope{memoryTag};
+
+    // A limited number of loops, so that a busy task does not hold the worker thread forever
+    for (int i = 0; i < EXECUTOR_SLICE_LOOPS; i++)
+    {
+        if (isQuiting)
+            break;
+
+        if (pauseReqCount > 0)
+        {
+            pauseConfirmed = true;
+            break;
+        }
+
+        pauseConfirmed = false;
+        if (!hasWork())
+            break;
+
+        onLoop();
+    }
+
+    NtsTrace::SetCurrentTask(nullptr);
+}
+
+NtsExecutor::NtsExecutor(int threadCount)
+{
+    for (int i = 0; i < threadCount; i++)
+        threads.emplace_back([this]() { workerLoop(); });
+}
+
+NtsExecutor::~NtsExecutor()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        isQuiting = true;
+    }
+    cv.notify_all();
+
+    for (auto &thread : threads)
+        thread.join();
+}
+
+size_t NtsExecutor::threadCount() const
+{
+    return threads.size();
+}
+
+void NtsExecutor::registerTask(NtsTask *task)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    task->executorSerial = ++serialCounter;
+    liveTasks[task] = task->executorSerial;
+}
+
+void NtsExecutor::attach(NtsTask *task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        task->isStarted = true;
+        // Run once in any case, messages may have been pushed before the start
+        enqueueLocked(task);
+    }
+    cv.notify_one();
+}
+
+void NtsExecutor::detach(NtsTask *task)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    liveTasks.erase(task);
+    readyQueue.erase(std::remove(readyQueue.begin(), readyQueue.end(), task), readyQueue.end());
+
+    idleCv.wait(lock, [task]() { return !task->isRunning; });
+    task->isStarted = false;
+    task->isScheduled = false;
+}
+
+void NtsExecutor::schedule(NtsTask *task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (task->isScheduled)
+            return;
+        enqueueLocked(task);
+    }
+    cv.notify_one();
+}
+
+void NtsExecutor::scheduleAt(NtsTask *task, int64_t timeMs)
+{
+    bool isEarliest;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (isQuiting || task->isQuiting)
+            return;
+        wakeups.push({timeMs, task, task->executorSerial});
+        isEarliest = wakeups.top().task == task && wakeups.top().time == timeMs;
+    }
+
+    // Sleeping workers only need to know if they should wake up earlier
+    if (isEarliest)
+        cv.notify_one();
+}
+
+void NtsExecutor::enqueueLocked(NtsTask *task)
+{
+    if (isQuiting || task->isQuiting || !task->isStarted || task->isScheduled)
+        return;
+    task->isScheduled = true;
+    readyQueue.push_back(task);
+}
+
+void NtsExecutor::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!isQuiting)
+    {
+        int64_t now = utils::CurrentTimeMillis();
+        while (!wakeups.empty() && wakeups.top().time <= now)
+        {
+            Wakeup wakeup = wakeups.top();
+            wakeups.pop();
+
+            auto it = liveTasks.find(wakeup.task);
+            if (it == liveTasks.end() || it->second != wakeup.serial)
+                continue;
+
+            // A timer set in onStart() may expire before the task is attached
+            if (!wakeup.task->isStarted)
+                wakeups.push({now + 1, wakeup.task, wakeup.serial});
+            else
+                enqueueLocked(wakeup.task);
+        }
+
+        if (readyQueue.empty())
+        {
+            if (wakeups.empty())
+                cv.wait(lock);
+            else
+                cv.wait_for(lock, std::chrono::milliseconds(wakeups.top().time - now));
+            continue;
+        }
+
+        NtsTask *task = readyQueue.front();
+        readyQueue.pop_front();
+        task->isRunning = true;
+
+        lock.unlock();
+        task->runSlice();
+        lock.lock();
+
+        task->isRunning = false;
+        task->isScheduled = false;
+        if (task->hasWork())
+        {
+            enqueueLocked(task);
+            cv.notify_one();
+        }
+        idleCv.notify_all();
+    }
+}
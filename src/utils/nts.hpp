@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include "memory.hpp"
 #include "scoped_thread.hpp"
 
 #include <atomic>
@@ -16,7 +17,9 @@
 #include <deque>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 enum class NtsMessageType
@@ -58,17 +61,20 @@ enum class NtsMessageType
     UE_RLS_TO_RLS,
 	UE_NAS_TO_APP,
 	UE_NAS_TO_RLS,
+
+    AMF_NGAP,
 };
 
 struct NtsMessage
 {
     const NtsMessageType msgType;
+    uint64_t traceId{}; // Only assigned if NtsTrace is enabled
 
     explicit NtsMessage(NtsMessageType msgType) : msgType(msgType)
     {
     }
 
-    virtual ~NtsMessage() = default;
+    virtual ~NtsMessage();
 };
 
 struct NmTimerExpired : NtsMessage
@@ -107,6 +113,56 @@ class TimerBase
     TimerInfo *getAndRemoveExpiredTimer();
 
     int64_t getNextWaitTime();
+
+    [[nodiscard]] bool hasExpiredTimer() const;
+};
+
+class NtsTask;
+
+/* Runs many NTS tasks on a fixed set of threads, instead of one thread per task. */
+class NtsExecutor
+{
+    struct Wakeup
+    {
+        int64_t time{};
+        NtsTask *task{};
+        uint64_t serial{};
+    };
+
+    struct WakeupComparator
+    {
+        bool operator()(const Wakeup &a, const Wakeup &b)
+        {
+            return a.time > b.time;
+        }
+    };
+
+    std::mutex mutex{};
+    std::condition_variable cv{};
+    std::condition_variable idleCv{};
+    std::deque<NtsTask *> readyQueue{};
+    std::priority_queue<Wakeup, std::vector<Wakeup>, WakeupComparator> wakeups{};
+    std::unordered_map<NtsTask *, uint64_t> liveTasks{}; // Stale wakeups of deleted tasks are recognized by the serial
+    uint64_t serialCounter{};
+    std::vector<std::thread> threads{};
+    bool isQuiting{};
+
+  public:
+    explicit NtsExecutor(int threadCount);
+    ~NtsExecutor();
+
+    [[nodiscard]] size_t threadCount() const;
+
+  private:
+    void registerTask(NtsTask *task);
+    void attach(NtsTask *task);
+    void detach(NtsTask *task);
+    void schedule(NtsTask *task);
+    void scheduleAt(NtsTask *task, int64_t timeMs);
+    void enqueueLocked(NtsTask *task);
+    void workerLoop();
+
+    friend class NtsTask;
 };
 
 // TODO: Limit queue size?
@@ -123,11 +179,39 @@ class NtsTask
     std::atomic_bool pauseConfirmed{};
     std::thread thread;
 
+    /* Only used if the task runs on an executor */
+    NtsExecutor *executor{};
+    uint64_t executorSerial{};
+    bool isStarted{};   // Guarded by the executor's mutex
+    bool isScheduled{}; // Guarded by the executor's mutex
+    bool isRunning{};   // Guarded by the executor's mutex
+
+    /* Only used if NtsTrace is enabled */
+    std::string traceName{};
+    std::atomic<uint32_t> traceTaskId{};
+
+    /* Only used if the memory accounting is compiled in */
+    MemoryTag memoryTag{};
+
+    friend class NtsExecutor;
+    friend class NtsTrace;
+
   public:
     NtsTask() = default;
 
     virtual ~NtsTask() = default;
 
+    // - Makes the task run on the given executor instead of its own thread. Must be called before start().
+    // - onLoop() of such a task must never block. take() and poll() return immediately, and onLoop() is called again
+    // when a message or a timer arrives.
+    void setExecutor(NtsExecutor *executor);
+
+    // Name of the task in NtsTrace, as 'node/task' to group the tasks of a node. The type name is used otherwise.
+    void setTraceName(std::string name);
+
+    // Account and subsystem charged for the allocations of the task's callbacks. Must be called before start().
+    void setMemoryTag(MemoryTag tag);
+
     // NtsTask takes the ownership of NtsMessage* after somebody pushes the message.
     bool push(NtsMessage *msg);
 
@@ -183,4 +267,8 @@ class NtsTask
 
     // - Returns true iff pause was requested and now is confirmed.
     bool isPauseConfirmed();
+
+  private:
+    bool hasWork();
+    void runSlice();
 };
\ No newline at end of file
@@ -0,0 +1,355 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "nts_trace.hpp"
+#include "nts.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include <cxxabi.h>
+
+static constexpr const int EXPORT_SETTLE_MS = 20;
+
+enum class TraceEvent : uint8_t
+{
+    ENQUEUE,
+    DEQUEUE,
+    DONE,
+};
+
+struct TraceRecord
+{
+    int64_t time;       // Nanoseconds on the monotonic clock
+    uint64_t msgId;
+    uint32_t task;      // Consumer for ENQUEUE and DEQUEUE, the deleting or forwarding task for DONE
+    uint32_t otherTask; // Producer for ENQUEUE
+    uint16_t msgType;
+    TraceEvent event;
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(TraceRecord) == 32, "unexpected trace record layout");
+
+struct TraceRing
+{
+    std::vector<TraceRecord> records;
+    std::atomic<uint64_t> written{};
+
+    explicit TraceRing(size_t capacity) : records(capacity)
+    {
+    }
+};
+
+std::atomic<bool> NtsTrace::s_enabled{};
+
+static size_t g_recordsPerThread = 0;
+static std::atomic<uint64_t> g_msgIdCounter{};
+
+static std::mutex g_registryMutex{};
+static std::vector<std::unique_ptr<TraceRing>> g_rings{}; // Kept after their threads exit
+static std::vector<std::string> g_taskNames{};           // Indexed by task id minus one
+
+static thread_local TraceRing *g_threadRing = nullptr;
+static thread_local NtsTask *g_currentTask = nullptr;
+
+static int64_t NowNanos()
+{
+    auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count();
+}
+
+static std::string DemangledTypeName(const NtsTask &task)
+{
+    const char *mangled = typeid(task).name();
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    std::string res = status == 0 && demangled ? demangled : mangled;
+    std::free(demangled);
+    return res;
+}
+
+static const char *MessageTypeName(uint16_t type)
+{
+    switch (static_cast<NtsMessageType>(type))
+    {
+    case NtsMessageType::TIMER_EXPIRED:
+        return "TIMER_EXPIRED";
+    case NtsMessageType::GNB_STATUS_UPDATE:
+        return "GNB_STATUS_UPDATE";
+    case NtsMessageType::GNB_CLI_COMMAND:
+        return "GNB_CLI_COMMAND";
+    case NtsMessageType::UE_STATUS_UPDATE:
+        return "UE_STATUS_UPDATE";
+    case NtsMessageType::UE_CLI_COMMAND:
+        return "UE_CLI_COMMAND";
+    case NtsMessageType::UE_CTL_COMMAND:
+        return "UE_CTL_COMMAND";
+    case NtsMessageType::UDP_SERVER_RECEIVE:
+        return "UDP_SERVER_RECEIVE";
+    case NtsMessageType::CLI_SEND_RESPONSE:
+        return "CLI_SEND_RESPONSE";
+    case NtsMessageType::GNB_RLS_TO_RRC:
+        return "GNB_RLS_TO_RRC";
+    case NtsMessageType::GNB_RLS_TO_GTP:
+        return "GNB_RLS_TO_GTP";
+    case NtsMessageType::GNB_GTP_TO_RLS:
+        return "GNB_GTP_TO_RLS";
+    case NtsMessageType::GNB_RRC_TO_RLS:
+        return "GNB_RRC_TO_RLS";
+    case NtsMessageType::GNB_RLS_TO_RLS:
+        return "GNB_RLS_TO_RLS";
+    case NtsMessageType::GNB_NGAP_TO_RRC:
+        return "GNB_NGAP_TO_RRC";
+    case NtsMessageType::GNB_RRC_TO_NGAP:
+        return "GNB_RRC_TO_NGAP";
+    case NtsMessageType::GNB_NGAP_TO_GTP:
+        return "GNB_NGAP_TO_GTP";
+    case NtsMessageType::GNB_SCTP:
+        return "GNB_SCTP";
+    case NtsMessageType::UE_APP_TO_TUN:
+        return "UE_APP_TO_TUN";
+    case NtsMessageType::UE_APP_TO_NAS:
+        return "UE_APP_TO_NAS";
+    case NtsMessageType::UE_TUN_TO_APP:
+        return "UE_TUN_TO_APP";
+    case NtsMessageType::UE_RRC_TO_NAS:
+        return "UE_RRC_TO_NAS";
+    case NtsMessageType::UE_NAS_TO_RRC:
+        return "UE_NAS_TO_RRC";
+    case NtsMessageType::UE_RRC_TO_RLS:
+        return "UE_RRC_TO_RLS";
+    case NtsMessageType::UE_RRC_TO_RRC:
+        return "UE_RRC_TO_RRC";
+    case NtsMessageType::UE_NAS_TO_NAS:
+        return "UE_NAS_TO_NAS";
+    case NtsMessageType::UE_RLS_TO_RRC:
+        return "UE_RLS_TO_RRC";
+    case NtsMessageType::UE_RLS_TO_NAS:
+        return "UE_RLS_TO_NAS";
+    case NtsMessageType::UE_RLS_TO_RLS:
+        return "UE_RLS_TO_RLS";
+    case NtsMessageType::UE_NAS_TO_APP:
+        return "UE_NAS_TO_APP";
+    case NtsMessageType::UE_NAS_TO_RLS:
+        return "UE_NAS_TO_RLS";
+    case NtsMessageType::AMF_NGAP:
+        return "AMF_NGAP";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+/* Id of the task in the trace, zero for no task. Assigned on the first record of the task, together with its name. */
+uint32_t NtsTrace::TaskId(NtsTask *task)
+{
+    if (task == nullptr)
+        return 0;
+
+    uint32_t id = task->traceTaskId.load(std::memory_order_acquire);
+    if (id != 0)
+        return id;
+
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    id = task->traceTaskId.load(std::memory_order_relaxed);
+    if (id == 0)
+    {
+        g_taskNames.push_back(task->traceName.empty() ? DemangledTypeName(*task) : task->traceName);
+        id = static_cast<uint32_t>(g_taskNames.size());
+        task->traceTaskId.store(id, std::memory_order_release);
+    }
+    return id;
+}
+
+static void Record(TraceEvent event, uint64_t msgId, NtsMessageType msgType, uint32_t task, uint32_t otherTask)
+{
+    if (g_threadRing == nullptr)
+    {
+        auto ring = std::make_unique<TraceRing>(g_recordsPerThread);
+        g_threadRing = ring.get();
+
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        g_rings.push_back(std::move(ring));
+    }
+
+    uint64_t index = g_threadRing->written.load(std::memory_order_relaxed);
+    auto &record = g_threadRing->records[index % g_threadRing->records.size()];
+    record.time = NowNanos();
+    record.msgId = msgId;
+    record.task = task;
+    record.otherTask = otherTask;
+    record.msgType = static_cast<uint16_t>(msgType);
+    record.event = event;
+    g_threadRing->written.store(index + 1, std::memory_order_release);
+}
+
+void NtsTrace::Enable(size_t recordsPerThread)
+{
+    if (recordsPerThread == 0)
+        throw std::runtime_error("NTS trace ring cannot be empty");
+
+    g_recordsPerThread = recordsPerThread;
+    s_enabled = true;
+}
+
+void NtsTrace::SetCurrentTask(NtsTask *task)
+{
+    g_currentTask = task;
+}
+
+void NtsTrace::OnEnqueue(NtsTask *consumer, NtsMessage *msg)
+{
+    // A message forwarded by its consumer is done for that consumer
+    if (msg->traceId != 0)
+        OnDone(msg);
+
+    msg->traceId = ++g_msgIdCounter;
+    Record(TraceEvent::ENQUEUE, msg->traceId, msg->msgType, TaskId(consumer), TaskId(g_currentTask));
+}
+
+void NtsTrace::OnDequeue(NtsTask *consumer, NtsMessage *msg)
+{
+    // Timer messages are created by the consumer when dequeued
+    if (msg->traceId == 0)
+        msg->traceId = ++g_msgIdCounter;
+    Record(TraceEvent::DEQUEUE, msg->traceId, msg->msgType, TaskId(consumer), 0);
+}
+
+void NtsTrace::OnDone(const NtsMessage *msg)
+{
+    if (msg->traceId == 0)
+        return;
+    Record(TraceEvent::DONE, msg->traceId, msg->msgType, TaskId(g_currentTask), 0);
+}
+
+void NtsTrace::ExportChromeJson(const std::string &path)
+{
+    if (!s_enabled.exchange(false))
+        return;
+
+    // Threads that just passed the check finish their records meanwhile
+    std::this_thread::sleep_for(std::chrono::milliseconds(EXPORT_SETTLE_MS));
+
+    struct MessageTimes
+    {
+        int64_t enqueue{}, dequeue{}, done{};
+        uint32_t producer{}, consumer{}, doneTask{};
+        uint16_t type{};
+    };
+
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+
+    std::unordered_map<uint64_t, MessageTimes> messages{};
+    int64_t origin = INT64_MAX;
+
+    for (auto &ring : g_rings)
+    {
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        uint64_t capacity = ring->records.size();
+        for (uint64_t i = written > capacity ? written - capacity : 0; i < written; i++)
+        {
+            auto &record = ring->records[i % capacity];
+            auto &item = messages[record.msgId];
+            item.type = record.msgType;
+            switch (record.event)
+            {
+            case TraceEvent::ENQUEUE:
+                item.enqueue = record.time;
+                item.consumer = record.task;
+                item.producer = record.otherTask;
+                break;
+            case TraceEvent::DEQUEUE:
+                item.dequeue = record.time;
+                item.consumer = record.task;
+                break;
+            case TraceEvent::DONE:
+                item.done = record.time;
+                item.doneTask = record.task;
+                break;
+            }
+            origin = std::min(origin, record.time);
+        }
+    }
+
+    std::ofstream out{path, std::ios::trunc};
+    if (!out)
+        throw std::runtime_error("NTS trace file could not be opened: " + path);
+
+    auto micros = [origin](int64_t time) { return std::to_string((time - origin) / 1000.0); };
+
+    // Tasks named 'node/task' are grouped into a process per node, the others are in process zero
+    std::unordered_map<std::string, int> processIds{};
+    std::vector<int> taskProcess(g_taskNames.size() + 1, 0);
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out << R"({"name":"process_name","ph":"M","pid":0,"args":{"name":"process"}})";
+
+    for (size_t i = 0; i < g_taskNames.size(); i++)
+    {
+        auto &name = g_taskNames[i];
+        auto slash = name.rfind('/');
+        int pid = 0;
+        if (slash != std::string::npos)
+        {
+            auto node = name.substr(0, slash);
+            auto it = processIds.find(node);
+            if (it == processIds.end())
+            {
+                pid = static_cast<int>(processIds.size()) + 1;
+                processIds[node] = pid;
+                out << ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":\"" << node
+                    << "\"}}";
+            }
+            else
+            {
+                pid = it->second;
+            }
+        }
+        taskProcess[i + 1] = pid;
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << (i + 1)
+            << ",\"args\":{\"name\":\"" << (slash == std::string::npos ? name : name.substr(slash + 1)) << "\"}}";
+    }
+
+    for (auto &[id, item] : messages)
+    {
+        if (item.dequeue == 0 || item.consumer == 0)
+            continue;
+
+        int64_t end = item.done != 0 && item.done >= item.dequeue ? item.done : item.dequeue;
+        const char *name = MessageTypeName(item.type);
+        int pid = taskProcess[item.consumer];
+
+        out << ",\n{\"name\":\"" << name << "\",\"cat\":\"nts\",\"ph\":\"X\",\"pid\":" << pid
+            << ",\"tid\":" << item.consumer << ",\"ts\":" << micros(item.dequeue)
+            << ",\"dur\":" << std::to_string((end - item.dequeue) / 1000.0) << ",\"args\":{\"id\":" << id;
+        if (item.enqueue != 0)
+            out << ",\"queued-us\":" << std::to_string((item.dequeue - item.enqueue) / 1000.0);
+        if (item.producer != 0)
+            out << ",\"from\":\"" << g_taskNames[item.producer - 1] << "\"";
+        out << "}}";
+
+        if (item.enqueue != 0 && item.producer != 0)
+        {
+            out << ",\n{\"name\":\"" << name << "\",\"cat\":\"nts\",\"ph\":\"s\",\"id\":" << id
+                << ",\"pid\":" << taskProcess[item.producer] << ",\"tid\":" << item.producer
+                << ",\"ts\":" << micros(item.enqueue) << "}";
+            out << ",\n{\"name\":\"" << name << "\",\"cat\":\"nts\",\"ph\":\"f\",\"bp\":\"e\",\"id\":" << id
+                << ",\"pid\":" << pid << ",\"tid\":" << item.consumer << ",\"ts\":" << micros(item.dequeue) << "}";
+        }
+    }
+
+    out << "\n]}\n";
+}
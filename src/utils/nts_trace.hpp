@@ -0,0 +1,49 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct NtsMessage;
+class NtsTask;
+
+/* Optional trace of the NTS messages. For each message the producer and consumer tasks, the type and the enqueue,
+ * dequeue and done times are recorded, where done is when the consumer deletes or forwards the message. Records go to
+ * a ring of fixed-size binary records per thread, the oldest records are overwritten once a ring is full. When the
+ * trace is off, the hooks cost a single relaxed load. */
+class NtsTrace
+{
+  private:
+    static std::atomic<bool> s_enabled;
+
+  public:
+    static bool IsEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /* Starts the trace with a ring of the given number of records for each thread which records */
+    static void Enable(size_t recordsPerThread);
+
+    /* Stops the trace and writes it in the Chrome trace event format, which Perfetto and chrome://tracing open. Each
+     * message is a slice on the track of its consumer task, connected to its producer by a flow arrow. */
+    static void ExportChromeJson(const std::string &path);
+
+    /* Hooks of NtsTask and NtsMessage */
+    static void SetCurrentTask(NtsTask *task);
+    static void OnEnqueue(NtsTask *consumer, NtsMessage *msg);
+    static void OnDequeue(NtsTask *consumer, NtsMessage *msg);
+    static void OnDone(const NtsMessage *msg);
+
+  private:
+    static uint32_t TaskId(NtsTask *task);
+};
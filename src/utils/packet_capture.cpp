@@ -0,0 +1,542 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#include "packet_capture.hpp"
+#include "constants.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+static constexpr const size_t CELL_SIZE = 256;
+static constexpr const int WRITER_IDLE_WAIT_MS = 10;
+static constexpr const size_t FILE_BUFFER_SIZE = 1024 * 1024;
+static constexpr const size_t MAX_IP_PACKET = 65535;
+
+enum class RecordKind : uint8_t
+{
+    PACKET,
+    INTERFACE,
+};
+
+struct RecordHeader
+{
+    int64_t time; // Nanoseconds since the epoch
+    uint32_t cellCount;
+    uint32_t size; // Octets following the header, the packet or the name of the interface
+    uint32_t interface;
+    uint16_t stream;
+    RecordKind kind;
+    CaptureProtocol protocol;
+    CaptureDirection direction;
+    CaptureAddress local;
+    CaptureAddress remote;
+};
+
+struct alignas(64) CaptureCell
+{
+    std::atomic<size_t> sequence;
+    uint8_t data[CELL_SIZE - sizeof(std::atomic<size_t>)];
+};
+
+static constexpr const size_t CELL_DATA_SIZE = sizeof(CaptureCell::data);
+
+static_assert(sizeof(CaptureCell) == CELL_SIZE, "unexpected capture cell layout");
+static_assert(sizeof(RecordHeader) <= CELL_DATA_SIZE, "capture record header must fit in a cell");
+
+static int64_t NowNanosSinceEpoch()
+{
+    auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count();
+}
+
+static uint16_t Ip4Checksum(const uint8_t *header, size_t size)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < size; i += 2)
+        sum += static_cast<uint32_t>(header[i] << 8 | header[i + 1]);
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<uint16_t>(~sum);
+}
+
+CaptureAddress::CaptureAddress(const InetAddress &address)
+{
+    auto *sa = address.getSockAddr();
+    if (address.getSockLen() == 0)
+        return;
+
+    if (sa->sa_family == AF_INET)
+    {
+        auto *sin = reinterpret_cast<const sockaddr_in *>(sa);
+        family = 4;
+        std::memcpy(this->address, &sin->sin_addr, 4);
+        port = ntohs(sin->sin_port);
+    }
+    else if (sa->sa_family == AF_INET6)
+    {
+        auto *sin6 = reinterpret_cast<const sockaddr_in6 *>(sa);
+        family = 6;
+        std::memcpy(this->address, &sin6->sin6_addr, 16);
+        port = ntohs(sin6->sin6_port);
+    }
+    else
+    {
+        // FNV-1a of the whole address, the same peer always gets the same loopback address
+        uint32_t hash = 2166136261u;
+        auto *bytes = reinterpret_cast<const uint8_t *>(sa);
+        for (socklen_t i = 0; i < address.getSockLen(); i++)
+            hash = (hash ^ bytes[i]) * 16777619u;
+
+        family = 4;
+        this->address[0] = 127;
+        this->address[1] = static_cast<uint8_t>(hash >> 16);
+        this->address[2] = static_cast<uint8_t>(hash >> 8);
+        this->address[3] = static_cast<uint8_t>(hash);
+    }
+}
+
+/* Multi-producer single-consumer ring of fixed-size cells in the layout of Vyukov's bounded queue, where a record
+ * takes as many consecutive cells as it needs. The consumer frees the cells in order, so a producer only has to see
+ * the last cell of a range free to claim the whole range. Only the first cell of a record is published, the consumer
+ * reads the others after it. */
+class CaptureBackend
+{
+  private:
+    std::unique_ptr<CaptureCell[]> m_cells;
+    size_t m_capacity;
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) std::atomic<int64_t> m_dropped;
+    alignas(64) size_t m_dequeuePos;
+
+    std::mutex m_interfaceMutex;
+    uint32_t m_interfaceCount;
+
+    std::FILE *m_file;
+    std::unique_ptr<char[]> m_fileBuffer;
+    std::vector<uint8_t> m_payload;
+    std::vector<uint8_t> m_block;
+    uint32_t m_tsn;
+    uint16_t m_ipId;
+
+    std::atomic<bool> m_stopping;
+    std::thread m_writer;
+
+  public:
+    CaptureBackend(const std::string &path, size_t ringSize)
+        : m_cells{}, m_capacity{}, m_enqueuePos{}, m_dropped{}, m_dequeuePos{}, m_interfaceCount{}, m_file{},
+          m_payload{}, m_block{}, m_tsn{}, m_ipId{}, m_stopping{}
+    {
+        // Capacity in cells is the largest power of two that fits in the given size
+        m_capacity = 1;
+        while (m_capacity * 2 * CELL_SIZE <= ringSize)
+            m_capacity *= 2;
+
+        m_file = std::fopen(path.c_str(), "wb");
+        if (m_file == nullptr)
+            throw std::runtime_error("Capture file could not be created: " + path);
+        m_fileBuffer = std::make_unique<char[]>(FILE_BUFFER_SIZE);
+        std::setvbuf(m_file, m_fileBuffer.get(), _IOFBF, FILE_BUFFER_SIZE);
+
+        m_cells = std::make_unique<CaptureCell[]>(m_capacity);
+        for (size_t i = 0; i < m_capacity; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+
+        writeSectionHeader();
+        m_writer = std::thread{[this]() { run(); }};
+    }
+
+  public:
+    bool push(RecordHeader &header, const uint8_t *first, size_t firstSize, const uint8_t *second, size_t secondSize)
+    {
+        size_t total = sizeof(RecordHeader) + firstSize + secondSize;
+        size_t count = (total + CELL_DATA_SIZE - 1) / CELL_DATA_SIZE;
+        if (count > m_capacity)
+            return false;
+
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            size_t last = pos + count - 1;
+            size_t sequence = m_cells[last & (m_capacity - 1)].sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(last);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // Either the ring is full or another producer has moved on in the meantime
+                size_t current = m_enqueuePos.load(std::memory_order_relaxed);
+                if (current == pos)
+                    return false;
+                pos = current;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        header.cellCount = static_cast<uint32_t>(count);
+        size_t offset = 0;
+        copyIn(pos, offset, reinterpret_cast<const uint8_t *>(&header), sizeof(RecordHeader));
+        copyIn(pos, offset, first, firstSize);
+        copyIn(pos, offset, second, secondSize);
+
+        m_cells[pos & (m_capacity - 1)].sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    void countDrop()
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t addInterface(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(m_interfaceMutex);
+
+        RecordHeader header{};
+        header.kind = RecordKind::INTERFACE;
+        header.interface = m_interfaceCount;
+        header.size = static_cast<uint32_t>(name.size());
+
+        // Packets of the interface must not precede its description, so this one waits for room
+        while (!push(header, reinterpret_cast<const uint8_t *>(name.data()), name.size(), nullptr, 0))
+            std::this_thread::yield();
+        return m_interfaceCount++;
+    }
+
+    int64_t stop()
+    {
+        m_stopping = true;
+        m_writer.join();
+        std::fclose(m_file);
+        m_file = nullptr;
+        return m_dropped.load();
+    }
+
+  private:
+    void copyIn(size_t pos, size_t &offset, const uint8_t *data, size_t size)
+    {
+        while (size > 0)
+        {
+            CaptureCell &cell = m_cells[(pos + offset / CELL_DATA_SIZE) & (m_capacity - 1)];
+            size_t cellOffset = offset % CELL_DATA_SIZE;
+            size_t chunk = std::min(size, CELL_DATA_SIZE - cellOffset);
+            std::memcpy(cell.data + cellOffset, data, chunk);
+            data += chunk;
+            size -= chunk;
+            offset += chunk;
+        }
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            if (drain())
+                continue;
+            if (m_stopping.load())
+            {
+                // Producers which passed the enabled check just before the stop may still be writing
+                std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_IDLE_WAIT_MS));
+                drain();
+                break;
+            }
+            std::fflush(m_file);
+            std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_IDLE_WAIT_MS));
+        }
+        std::fflush(m_file);
+    }
+
+    bool drain()
+    {
+        bool any = false;
+        while (true)
+        {
+            size_t pos = m_dequeuePos;
+            CaptureCell &first = m_cells[pos & (m_capacity - 1)];
+            if (first.sequence.load(std::memory_order_acquire) != pos + 1)
+                return any;
+            any = true;
+
+            RecordHeader header{};
+            std::memcpy(&header, first.data, sizeof(RecordHeader));
+
+            m_payload.resize(header.size);
+            size_t offset = sizeof(RecordHeader);
+            size_t remaining = header.size;
+            uint8_t *out = m_payload.data();
+            while (remaining > 0)
+            {
+                CaptureCell &cell = m_cells[(pos + offset / CELL_DATA_SIZE) & (m_capacity - 1)];
+                size_t cellOffset = offset % CELL_DATA_SIZE;
+                size_t chunk = std::min(remaining, CELL_DATA_SIZE - cellOffset);
+                std::memcpy(out, cell.data + cellOffset, chunk);
+                out += chunk;
+                remaining -= chunk;
+                offset += chunk;
+            }
+
+            for (size_t i = 0; i < header.cellCount; i++)
+                m_cells[(pos + i) & (m_capacity - 1)].sequence.store(pos + i + m_capacity, std::memory_order_release);
+            m_dequeuePos = pos + header.cellCount;
+
+            if (header.kind == RecordKind::INTERFACE)
+                writeInterfaceDescription(std::string{m_payload.begin(), m_payload.end()});
+            else
+                writePacket(header);
+        }
+    }
+
+    /* Block writing, in the byte order of the host as pcapng allows */
+
+    template <typename T>
+    void append(T value)
+    {
+        auto *p = reinterpret_cast<const uint8_t *>(&value);
+        m_block.insert(m_block.end(), p, p + sizeof(T));
+    }
+
+    void appendPadding()
+    {
+        while (m_block.size() % 4 != 0)
+            m_block.push_back(0);
+    }
+
+    void appendOption(uint16_t code, const void *value, size_t size)
+    {
+        append<uint16_t>(code);
+        append<uint16_t>(static_cast<uint16_t>(size));
+        auto *p = reinterpret_cast<const uint8_t *>(value);
+        m_block.insert(m_block.end(), p, p + size);
+        appendPadding();
+    }
+
+    void beginBlock(uint32_t type)
+    {
+        m_block.clear();
+        append<uint32_t>(type);
+        append<uint32_t>(0); // Total length, set by endBlock
+    }
+
+    void endBlock()
+    {
+        auto length = static_cast<uint32_t>(m_block.size() + 4);
+        std::memcpy(m_block.data() + 4, &length, 4);
+        append<uint32_t>(length);
+        std::fwrite(m_block.data(), 1, m_block.size(), m_file);
+    }
+
+    void writeSectionHeader()
+    {
+        beginBlock(pcapng::SECTION_HEADER_BLOCK);
+        append<uint32_t>(pcapng::BYTE_ORDER_MAGIC);
+        append<uint16_t>(1); // Major version
+        append<uint16_t>(0); // Minor version
+        append<int64_t>(-1); // Section length is not specified
+        std::string application = cons::Name;
+        appendOption(pcapng::OPT_SHB_USER_APPL, application.data(), application.size());
+        appendOption(pcapng::OPT_END, nullptr, 0);
+        endBlock();
+    }
+
+    void writeInterfaceDescription(const std::string &name)
+    {
+        beginBlock(pcapng::INTERFACE_DESCRIPTION_BLOCK);
+        append<uint16_t>(pcapng::LINKTYPE_RAW);
+        append<uint16_t>(0); // Reserved
+        append<uint32_t>(0); // No snapshot length limit
+        appendOption(pcapng::OPT_IF_NAME, name.data(), name.size());
+        uint8_t resolution = 9; // Nanoseconds
+        appendOption(pcapng::OPT_IF_TSRESOL, &resolution, 1);
+        appendOption(pcapng::OPT_END, nullptr, 0);
+        endBlock();
+    }
+
+    void writePacket(const RecordHeader &header)
+    {
+        const CaptureAddress &src = header.direction == CaptureDirection::INBOUND ? header.remote : header.local;
+        const CaptureAddress &dst = header.direction == CaptureDirection::INBOUND ? header.local : header.remote;
+
+        uint8_t family = header.remote.family != 0 ? header.remote.family : header.local.family;
+        if (family == 0)
+            family = 4;
+
+        size_t transportSize;
+        if (header.protocol == CaptureProtocol::NGAP)
+            transportSize = 12 + 16 + ((header.size + 3) & ~static_cast<size_t>(3));
+        else
+            transportSize = 8 + header.size;
+        size_t ipSize = (family == 6 ? 40 : 20) + transportSize;
+
+        beginBlock(pcapng::ENHANCED_PACKET_BLOCK);
+        append<uint32_t>(header.interface);
+        append<uint32_t>(static_cast<uint32_t>(static_cast<uint64_t>(header.time) >> 32));
+        append<uint32_t>(static_cast<uint32_t>(header.time));
+        append<uint32_t>(static_cast<uint32_t>(ipSize));
+        append<uint32_t>(static_cast<uint32_t>(ipSize));
+
+        uint8_t ipProtocol =
+            header.protocol == CaptureProtocol::NGAP ? pcapng::IP_PROTOCOL_SCTP : pcapng::IP_PROTOCOL_UDP;
+        size_t ipStart = m_block.size();
+        if (family == 6)
+        {
+            appendBigEndian<uint32_t>(0x60000000);
+            appendBigEndian<uint16_t>(static_cast<uint16_t>(std::min(transportSize, MAX_IP_PACKET)));
+            m_block.push_back(ipProtocol);
+            m_block.push_back(64); // Hop limit
+            appendAddress(src, 16);
+            appendAddress(dst, 16);
+        }
+        else
+        {
+            m_block.push_back(0x45);
+            m_block.push_back(0);
+            appendBigEndian<uint16_t>(static_cast<uint16_t>(std::min(ipSize, MAX_IP_PACKET)));
+            appendBigEndian<uint16_t>(m_ipId++);
+            appendBigEndian<uint16_t>(0x4000); // Don't fragment
+            m_block.push_back(64);             // Time to live
+            m_block.push_back(ipProtocol);
+            appendBigEndian<uint16_t>(0); // Checksum, computed below
+            appendAddress(src, 4);
+            appendAddress(dst, 4);
+
+            uint16_t checksum = Ip4Checksum(m_block.data() + ipStart, 20);
+            m_block[ipStart + 10] = static_cast<uint8_t>(checksum >> 8);
+            m_block[ipStart + 11] = static_cast<uint8_t>(checksum);
+        }
+
+        appendBigEndian<uint16_t>(src.port);
+        appendBigEndian<uint16_t>(dst.port);
+        if (header.protocol == CaptureProtocol::NGAP)
+        {
+            // SCTP common header and a single unfragmented DATA chunk, the checksum is left zero
+            appendBigEndian<uint32_t>(0); // Verification tag
+            appendBigEndian<uint32_t>(0); // Checksum
+            m_block.push_back(0);         // DATA
+            m_block.push_back(0x03);      // Beginning and ending fragment
+            appendBigEndian<uint16_t>(static_cast<uint16_t>(std::min<size_t>(16 + header.size, 0xFFFF)));
+            appendBigEndian<uint32_t>(m_tsn++);
+            appendBigEndian<uint16_t>(header.stream);
+            appendBigEndian<uint16_t>(0); // Stream sequence number
+            appendBigEndian<uint32_t>(60); // NGAP payload protocol identifier
+        }
+        else
+        {
+            appendBigEndian<uint16_t>(static_cast<uint16_t>(std::min(transportSize, MAX_IP_PACKET)));
+            appendBigEndian<uint16_t>(0); // Checksum is optional
+        }
+
+        m_block.insert(m_block.end(), m_payload.begin(), m_payload.end());
+        appendPadding();
+
+        uint32_t flags = static_cast<uint32_t>(header.direction);
+        appendOption(pcapng::OPT_EPB_FLAGS, &flags, 4);
+        appendOption(pcapng::OPT_END, nullptr, 0);
+        endBlock();
+    }
+
+    template <typename T>
+    void appendBigEndian(T value)
+    {
+        for (int i = static_cast<int>(sizeof(T)) - 1; i >= 0; i--)
+            m_block.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+
+    void appendAddress(const CaptureAddress &address, size_t size)
+    {
+        uint8_t bytes[16] = {0};
+        if (size == 16 && address.family == 4)
+        {
+            // IPv4-mapped IPv6 address
+            bytes[10] = 0xFF;
+            bytes[11] = 0xFF;
+            std::memcpy(bytes + 12, address.address, 4);
+        }
+        else if (size == 4 && address.family == 6)
+        {
+            // Left unspecified, there is no IPv4 form
+        }
+        else
+        {
+            std::memcpy(bytes, address.address, size);
+        }
+        m_block.insert(m_block.end(), bytes, bytes + size);
+    }
+};
+
+std::atomic<bool> PacketCapture::s_enabled{};
+
+// Never destroyed, producers which passed the enabled check may still be using it after the stop
+static CaptureBackend *g_backend = nullptr;
+
+void PacketCapture::Start(const std::string &path, size_t ringSize)
+{
+    if (g_backend != nullptr)
+        throw std::runtime_error("Packet capture is already started");
+
+    MemoryTagScope tagScope{MemoryTag{}};
+    g_backend = new CaptureBackend(path, ringSize);
+    s_enabled = true;
+}
+
+int64_t PacketCapture::Stop()
+{
+    if (!s_enabled.exchange(false))
+        return 0;
+    return g_backend->stop();
+}
+
+uint32_t PacketCapture::AddInterface(const std::string &name)
+{
+    if (!IsEnabled())
+        return 0;
+    return g_backend->addInterface(name);
+}
+
+void PacketCapture::Record(const CapturePoint &point, CaptureDirection direction, const InetAddress &remote,
+                           const uint8_t *data, size_t size, uint16_t stream)
+{
+    Record(point, direction, remote, data, size, nullptr, 0, stream);
+}
+
+void PacketCapture::Record(const CapturePoint &point, CaptureDirection direction, const InetAddress &remote,
+                           const uint8_t *header, size_t headerSize, const uint8_t *payload, size_t payloadSize,
+                           uint16_t stream)
+{
+    if (!IsEnabled())
+        return;
+
+    RecordHeader record{};
+    record.time = NowNanosSinceEpoch();
+    record.size = static_cast<uint32_t>(headerSize + payloadSize);
+    record.interface = point.interface;
+    record.stream = stream;
+    record.kind = RecordKind::PACKET;
+    record.protocol = point.protocol;
+    record.direction = direction;
+    record.local = point.local;
+    record.remote = CaptureAddress{remote};
+
+    if (!g_backend->push(record, header, headerSize, payload, payloadSize))
+        g_backend->countDrop();
+}
@@ -0,0 +1,105 @@
+//
+// This file is a part of UERANSIM open source project.
+// Copyright (c) 2021 ALİ GÜNGÖR.
+//
+// The software and all associated files are licensed under GPL-3.0
+// and subject to the terms and conditions defined in LICENSE file.
+//
+
+#pragma once
+
+#include "network.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class CaptureProtocol : uint8_t
+{
+    NGAP = 1,
+    RLS = 2,
+    GTP = 3,
+};
+
+// Values of the direction bits of the pcapng packet flags
+enum class CaptureDirection : uint8_t
+{
+    INBOUND = 1,
+    OUTBOUND = 2,
+};
+
+/* Address of a captured packet, in the form it is written. Addresses which are not IPv4 or IPv6, such as the ones of
+ * the shared memory RLS peers, are mapped to a loopback IPv4 address. */
+struct CaptureAddress
+{
+    uint8_t family{}; // 4 or 6, or 0 if not known
+    uint8_t address[16]{};
+    uint16_t port{};
+
+    CaptureAddress() = default;
+    explicit CaptureAddress(const InetAddress &address);
+};
+
+/* Where packets of one protocol are captured, the local address is the one of the capturing node */
+struct CapturePoint
+{
+    uint32_t interface{};
+    CaptureProtocol protocol{};
+    CaptureAddress local{};
+};
+
+/* Optional capture of the NGAP PDUs, RLS datagrams and GTP-U packets of the nodes into a pcapng file. Each node is an
+ * interface of the file, and each packet is written as a raw IP packet with the UDP or SCTP header it would have on
+ * the wire, so that Wireshark dissects NGAP, GTP-U and (with tools/rls-wireshark-dissector.lua) RLS by their usual
+ * ports and payload protocol identifiers. Packets are copied into a lock-free ring and written by a background
+ * thread. Recording never blocks, packets are dropped and counted while the ring is full. When the capture is off,
+ * the hooks cost a single relaxed load. */
+class PacketCapture
+{
+  private:
+    static std::atomic<bool> s_enabled;
+
+  public:
+    static bool IsEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /* Starts the capture into the given file with a ring of the given size in bytes, throws on failure */
+    static void Start(const std::string &path, size_t ringSize);
+
+    /* Stops the capture after writing the recorded packets, returns the number of dropped packets */
+    static int64_t Stop();
+
+    /* Adds an interface for a node, returns its id */
+    static uint32_t AddInterface(const std::string &name);
+
+    static void Record(const CapturePoint &point, CaptureDirection direction, const InetAddress &remote,
+                       const uint8_t *data, size_t size, uint16_t stream = 0);
+    static void Record(const CapturePoint &point, CaptureDirection direction, const InetAddress &remote,
+                       const uint8_t *header, size_t headerSize, const uint8_t *payload, size_t payloadSize,
+                       uint16_t stream = 0);
+};
+
+namespace pcapng
+{
+
+static constexpr const uint32_t SECTION_HEADER_BLOCK = 0x0A0D0D0A;
+static constexpr const uint32_t INTERFACE_DESCRIPTION_BLOCK = 1;
+static constexpr const uint32_t ENHANCED_PACKET_BLOCK = 6;
+static constexpr const uint32_t BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+
+static constexpr const uint16_t OPT_END = 0;
+static constexpr const uint16_t OPT_SHB_USER_APPL = 4;
+static constexpr const uint16_t OPT_IF_NAME = 2;
+static constexpr const uint16_t OPT_IF_TSRESOL = 9;
+static constexpr const uint16_t OPT_EPB_FLAGS = 2;
+
+// Raw IPv4 or IPv6 packets
+static constexpr const uint16_t LINKTYPE_RAW = 101;
+
+static constexpr const uint8_t IP_PROTOCOL_UDP = 17;
+static constexpr const uint8_t IP_PROTOCOL_SCTP = 132;
+
+} // namespace pcapng
@@ -141,6 +141,36 @@ int64_t GetInt64(const YAML::Node &node, const std::string &name, std::optional<
     return value;
 }
 
+void AssertHasDouble(const YAML::Node &node, const std::string &name)
+{
+    AssertHasField(node, name);
+    try
+    {
+        node[name].as<double>();
+    }
+    catch (const std::runtime_error &e)
+    {
+        FieldError(name, "has invalid type");
+    }
+}
+
+double GetDouble(const YAML::Node &node, const std::string &name)
+{
+    AssertHasDouble(node, name);
+    return node[name].as<double>();
+}
+
+double GetDouble(const YAML::Node &node, const std::string &name, std::optional<double> minValue,
+                 std::optional<double> maxValue)
+{
+    double value = GetDouble(node, name);
+    if (minValue.has_value() && value < minValue)
+        FieldError(name, "is too small");
+    if (maxValue.has_value() && value > maxValue)
+        FieldError(name, "is too big");
+    return value;
+}
+
 std::string GetIp4(const YAML::Node &node, const std::string &name)
 {
     std::string ip = GetString(node, name);
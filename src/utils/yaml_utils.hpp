@@ -28,6 +28,7 @@ void AssertHasInt32(const YAML::Node &node, const std::string &name);
 void AssertHasInt64(const YAML::Node &node, const std::string &name);
 void AssertHasString(const YAML::Node &node, const std::string &name);
 void AssertHasBool(const YAML::Node &node, const std::string &name);
+void AssertHasDouble(const YAML::Node &node, const std::string &name);
 void AssertHasSequence(const YAML::Node &node, const std::string &name);
 
 int GetInt32(const YAML::Node &node, const std::string &name);
@@ -41,6 +42,10 @@ std::string GetString(const YAML::Node &node, const std::string &name);
 std::string GetString(const YAML::Node &node, const std::string &name, std::optional<int> minLength,
                       std::optional<int> maxLength);
 
+double GetDouble(const YAML::Node &node, const std::string &name);
+double GetDouble(const YAML::Node &node, const std::string &name, std::optional<double> minValue,
+                 std::optional<double> maxValue);
+
 std::string GetIp4(const YAML::Node &node, const std::string &name);
 
 bool GetBool(const YAML::Node &node, const std::string &name);
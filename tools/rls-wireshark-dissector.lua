@@ -19,6 +19,9 @@ local msgTypeNames = {
     [5] = "Heartbeat ACK",
     [6] = "PDU Transmission",
     [7] = "PDU Transmission ACK",
+    [8] = "PDU Transmission Batch",
+    [9] = "Heartbeat Batch",
+    [10] = "Heartbeat ACK Batch",
 }
 
 local pduTypeNames = {
@@ -58,13 +61,75 @@ fields.RrcMsgType = ProtoField.uint32("rls.rrc_message_type", "RRC Message Type"
 fields.PduLength = ProtoField.uint32("rls.pdu_length", "PDU Length", base.DEC)
 fields.PduSessionId = ProtoField.uint32("rls.pdu_session_id", "PDU Session ID", base.DEC)
 fields.AcknowledgeItem = ProtoField.uint32("rls.ack_item", "PDU ID")
+fields.CumulativeAck = ProtoField.uint32("rls.cumulative_ack", "Cumulative PDU ID", base.DEC)
 fields.Dbm = ProtoField.int32("rls.dbm", "RLS Signal Strength (dBm)", base.DEC)
 fields.PosX = ProtoField.uint32("rls.pos_x", "RLS Position X", base.DEC)
 fields.PosY = ProtoField.uint32("rls.pos_y", "RLS Position Y", base.DEC)
 fields.PosZ = ProtoField.uint32("rls.pos_z", "RLS Position Z", base.DEC)
+fields.Features = ProtoField.uint8("rls.features", "Supported Features", base.HEX)
+fields.FeaturePduBatch = ProtoField.bool("rls.features.pdu_batch", "PDU Batching", 8, nil, 0x01)
+fields.FeatureEnvelope = ProtoField.bool("rls.features.envelope", "Envelope", 8, nil, 0x02)
+fields.FeatureHeartbeatBatch = ProtoField.bool("rls.features.heartbeat_batch", "Heartbeat Batching", 8, nil, 0x04)
+fields.BatchCount = ProtoField.uint16("rls.batch_count", "Number of PDUs", base.DEC)
+fields.Destination = ProtoField.uint64("rls.destination", "Destination Node Temporary ID", base.DEC)
+fields.ItemCount = ProtoField.uint16("rls.item_count", "Number of Items", base.DEC)
+fields.ItemSti = ProtoField.uint64("rls.item_sti", "UE Node Temporary ID", base.DEC)
+
+local function dissectPdu(buffer, pinfo, tree, subtree, pduType, payloadOffset, lengthOffset, lengthSize)
+    local pduLength = buffer(lengthOffset, lengthSize):uint()
+    local pduOffset = lengthOffset + lengthSize
+    if pduType == 1 then -- RRC PDU
+        local rrcMsgType = buffer(payloadOffset, 4):uint()
+        subtree:add(fields.RrcMsgType, buffer(payloadOffset, 4))
+        subtree:add(fields.PduLength, buffer(lengthOffset, lengthSize))
+        Dissector.get(nrRrcDissectors[rrcMsgType]):call(buffer(pduOffset, pduLength):tvb(), pinfo, tree)
+    elseif (pduType == 2) then -- Data PDU
+        subtree:add(fields.PduSessionId, buffer(payloadOffset, 4))
+        subtree:add(fields.PduLength, buffer(lengthOffset, lengthSize))
+        Dissector.get("ip"):call(buffer(pduOffset, pduLength):tvb(), pinfo, tree)
+    end
+    return pduOffset + pduLength
+end
+
+local function dissectFeatures(buffer, tree, offset)
+    if buffer:len() <= offset then return end -- Absent in older versions
+    local featureTree = tree:add(fields.Features, buffer(offset, 1))
+    featureTree:add(fields.FeaturePduBatch, buffer(offset, 1))
+    featureTree:add(fields.FeatureEnvelope, buffer(offset, 1))
+    featureTree:add(fields.FeatureHeartbeatBatch, buffer(offset, 1))
+end
+
+local function dissectHeartbeatItems(buffer, subtree, isAck)
+    dissectFeatures(buffer, subtree, 13)
+    local count = buffer(14, 2):uint()
+    subtree:add(fields.ItemCount, buffer(14, 2))
+    local itemSize = isAck and 12 or 20
+    local offset = 16
+    for i = 1,count,1 do
+        local item = subtree:add(rlsProtocol, buffer(offset, itemSize), "UE (" .. i .. "/" .. count .. ")")
+        item:add(fields.ItemSti, buffer(offset, 8))
+        if isAck then
+            item:add(fields.Dbm, buffer(offset + 8, 4))
+        else
+            item:add(fields.PosX, buffer(offset + 8, 4))
+            item:add(fields.PosY, buffer(offset + 12, 4))
+            item:add(fields.PosZ, buffer(offset + 16, 4))
+        end
+        offset = offset + itemSize
+    end
+end
 
 function rlsProtocol.dissector(buffer, pinfo, tree)
     if buffer:len() == 0 then return end
+
+    -- Messages to one of the UEs sharing a socket are enveloped with the STI of the UE
+    if buffer(0, 1):uint() == 0x04 and buffer:len() > 9 then
+        local envelope = tree:add(rlsProtocol, buffer(0, 9), "RLS Envelope")
+        envelope:add(fields.Destination, buffer(1, 8))
+        rlsProtocol.dissector(buffer(9):tvb(), pinfo, tree)
+        return
+    end
+
     if buffer(0, 1):uint() ~= 0x03 then return end
 
     pinfo.cols.protocol = rlsProtocol.name
@@ -83,30 +148,40 @@ function rlsProtocol.dissector(buffer, pinfo, tree)
         subtree:add(fields.PosX, buffer(13,4))
         subtree:add(fields.PosY, buffer(17,4))
         subtree:add(fields.PosZ, buffer(21,4))
+        dissectFeatures(buffer, subtree, 25)
     elseif msgType == 5 then -- Heartbeat ACK
         subtree:add(fields.Dbm, buffer(13,4))
+        dissectFeatures(buffer, subtree, 17)
     elseif msgType == 6 then -- PDU Transmission
         local pduType = buffer(13, 1):uint()
         subtree:add(fields.PduType, buffer(13, 1))
         subtree:add(fields.PduId, buffer(14, 4))
-        if pduType == 1 then -- RRC PDU
-            local rrcMsgType = buffer(18, 4):uint()
-            local pduLength = buffer(22, 4):uint()
-            subtree:add(fields.RrcMsgType, buffer(18, 4))
-            subtree:add(fields.PduLength, buffer(22, 4))
-            Dissector.get(nrRrcDissectors[rrcMsgType]):call(buffer(26, pduLength):tvb(), pinfo, tree)
-        elseif (pduType == 2) then -- Data PDU
-            subtree:add(fields.PduSessionId, buffer(18, 4))
-            local pduLength = buffer(22, 4):uint()
-            subtree:add(fields.PduLength, buffer(22, 4))
-            Dissector.get("ip"):call(buffer(26, pduLength):tvb(), pinfo, tree)
-        end
+        dissectPdu(buffer, pinfo, tree, subtree, pduType, 18, 22, 4)
     elseif msgType == 7 then -- PDU Transmission ACK
         local ackCount = buffer(13, 4):uint()
         local ackArray = subtree:add(rlsProtocol, buffer(13, 4), "Acknowledge List (" .. ackCount .. ")")
         for i = 1,ackCount,1 do
             ackArray:add(fields.AcknowledgeItem, buffer(17 + (i - 1) * 4, 4))
         end
+        local cumulativeOffset = 17 + ackCount * 4
+        if buffer:len() > cumulativeOffset then -- Absent in older versions
+            subtree:add(fields.CumulativeAck, buffer(cumulativeOffset, 4))
+        end
+    elseif msgType == 8 then -- PDU Transmission Batch
+        local count = buffer(13, 2):uint()
+        subtree:add(fields.BatchCount, buffer(13, 2))
+        local offset = 15
+        for i = 1,count,1 do
+            local pduType = buffer(offset, 1):uint()
+            local item = subtree:add(rlsProtocol, buffer(offset), "PDU (" .. i .. "/" .. count .. ")")
+            item:add(fields.PduType, buffer(offset, 1))
+            item:add(fields.PduId, buffer(offset + 1, 4))
+            offset = dissectPdu(buffer, pinfo, tree, item, pduType, offset + 5, offset + 9, 2)
+        end
+    elseif msgType == 9 then -- Heartbeat Batch
+        dissectHeartbeatItems(buffer, subtree, false)
+    elseif msgType == 10 then -- Heartbeat ACK Batch
+        dissectHeartbeatItems(buffer, subtree, true)
     end
 end
 